@@ -1,5 +1,7 @@
 
 import sys
+import os
+import time
 import logging
 from PyQt5.QtWidgets import (
     QApplication, QMainWindow, QWidget, QSplitter, QMessageBox,
@@ -14,8 +16,12 @@ import config
 
 from controller_core import ControllerCore
 import serial_manager
+import packet
 import numpy as np
 from debug_viewer import Viewer, _parse
+import led_preview
+import show
+import dashboard
 
 
 class QtConsoleHandler(logging.Handler):
@@ -90,12 +96,39 @@ class AppWindow(QMainWindow):
         self.btn_gyro.setFixedSize(60, 20)
         hbox.addWidget(self.btn_gyro)
 
-        # QTimer to fire at config.GYRO_SEND_RATE Hz
+        # QTimer to fire at config.ORIENT_RATE Hz
         self.gyro_timer = QTimer(self)
-        self.gyro_timer.setInterval(int(1000 / config.GYRO_SEND_RATE))
+        self.gyro_timer.setTimerType(Qt.PreciseTimer)
+        self.gyro_timer.setInterval(max(1, round(1000 / config.ORIENT_RATE)))
         self.gyro_timer.timeout.connect(self._send_gyro)
         self.btn_gyro.toggled.connect(self.on_gyro_toggled)
 
+        # ─── Live preview toggle ("mirror" on the device) ───
+        self.btn_live = QPushButton("Live Off")
+        self.btn_live.setCheckable(True)
+        self.btn_live.setFixedSize(60, 20)
+        self.btn_live.setEnabled(led_preview.available())
+        self.btn_live.toggled.connect(self.on_live_toggled)
+        hbox.addWidget(self.btn_live)
+
+        # ─── Record the mirrored frames to a show file ───
+        self.btn_rec = QPushButton("Rec")
+        self.btn_rec.setCheckable(True)
+        self.btn_rec.setFixedSize(40, 20)
+        self.btn_rec.setEnabled(led_preview.available())
+        self.btn_rec.toggled.connect(self.on_rec_toggled)
+        hbox.addWidget(self.btn_rec)
+
+        # ─── Telemetry dashboard pane (dashboard.py) ───
+        self.btn_dash = QPushButton("Dash")
+        self.btn_dash.setCheckable(True)
+        self.btn_dash.setFixedSize(40, 20)
+        self.btn_dash.toggled.connect(self.on_dash_toggled)
+        hbox.addWidget(self.btn_dash)
+        self.recorder = None
+        self.geometry = 0
+        self.geo_shown = None           # crc of the binary dump on screen
+
 
 
 
@@ -145,41 +178,50 @@ class AppWindow(QMainWindow):
         left_splitter.addWidget(recv_widget)
 
 
-        # Plot area
+        # Plot area: the OpenGL live preview, matplotlib without pyqtgraph
         canvas_widget = QWidget()
         canvas_widget.setPalette(pal)
         canvas_layout = QVBoxLayout(canvas_widget)
-        self.figure = Figure(facecolor='#353535')
-        self.canvas = FigureCanvas(self.figure)
-        self.canvas.toolbar_visible = False
-        canvas_layout.addWidget(self.canvas)
+        self.preview = None
+        if led_preview.available():
+            self.preview = led_preview.Preview()
+            canvas_layout.addWidget(self.preview)
+            serial_manager.on_pixels = self.preview.pixels
+        else:
+            self.figure = Figure(facecolor='#353535')
+            self.canvas = FigureCanvas(self.figure)
+            self.canvas.toolbar_visible = False
+            canvas_layout.addWidget(self.canvas)
 
         main_splitter.addWidget(left_splitter)
         main_splitter.addWidget(canvas_widget)
-        self.setCentralWidget(main_splitter)
 
+        # dashboard, hidden until "Dash"; the history fills either way
+        self.history = dashboard.History()
+        self.dash = dashboard.Pane(self.history)
+        self.dash.setPalette(pal)
+        self.dash.hide()
+        main_splitter.addWidget(self.dash)
+        self.setCentralWidget(main_splitter)
 
 
 
-        # ─── Metrics display (rolling averages) ─────────────────────────────────
-        # how many samples to average over
-        self.metrics_history = config.METRICS_HISTORY
-        self.frame_times = []
-        self.anim_times = []
 
-        # build a little bar above the autoscroll controls
+        # ─── Metrics display (TELEMETRY packets, averaged on the device) ────────
         metrics_widget = QWidget()
         metrics_layout = QHBoxLayout(metrics_widget)
         metrics_layout.setContentsMargins(10, 5, 5, 0)
         metrics_layout.setSpacing(15)
 
-        self.lbl_frame_time = QLabel("Avg frame: – ms")
-        self.lbl_frame_time.setStyleSheet("color: #ddd;")
-        metrics_layout.addWidget(self.lbl_frame_time)
-
-        self.lbl_anim_time = QLabel("Avg anim: – ms")
-        self.lbl_anim_time.setStyleSheet("color: #ddd;")
-        metrics_layout.addWidget(self.lbl_anim_time)
+        self.lbl_frame_time = QLabel("Frame: – ms")
+        self.lbl_anim_time  = QLabel("Anim: – ms")
+        self.lbl_fps        = QLabel("– fps")
+        self.lbl_health     = QLabel("")
+        self.lbl_latency    = QLabel("in→light: –")     # histogram as its tooltip
+        for lbl in (self.lbl_frame_time, self.lbl_anim_time, self.lbl_fps, self.lbl_health,
+                    self.lbl_latency):
+            lbl.setStyleSheet("color: #ddd;")
+            metrics_layout.addWidget(lbl)
 
         metrics_layout.addStretch(1)
         metrics_widget.setFixedHeight(25)
@@ -192,36 +234,11 @@ class AppWindow(QMainWindow):
         handler = QtConsoleHandler(self.sent_console)
         logging.getLogger().addHandler(handler)
 
-        # override serial_manager._log_recv to filter out metrics & #face# tags
+        serial_manager.on_telemetry = self._on_telemetry
+
+        # override serial_manager._log_recv to filter out #face# tags
         orig_log_recv = serial_manager._log_recv
         def _filtered_log_recv(msg):
-            # ─── intercept frametime updates ───────────────────────────
-            if msg.startswith("#frametime"):
-                import re
-                m = re.match(r"#frametime\s+(\d+)#", msg)
-                if m:
-                    us  = int(m.group(1))       # raw microseconds
-                    val = us / 1000.0           # convert to milliseconds
-                    self.frame_times.append(val)
-                    if len(self.frame_times) > self.metrics_history:
-                        self.frame_times.pop(0)
-                    avg = sum(self.frame_times) / len(self.frame_times)
-                    self.lbl_frame_time.setText(f"Avg frame: {avg:.2f} ms")
-                return
-
-            if msg.startswith("#animtime"):
-                import re
-                m = re.match(r"#animtime\s+(\d+)#", msg)
-                if m:
-                    us  = int(m.group(1))
-                    val = us / 1000.0          # convert to milliseconds
-                    self.anim_times.append(val)
-                    if len(self.anim_times) > self.metrics_history:
-                        self.anim_times.pop(0)
-                    avg = sum(self.anim_times) / len(self.anim_times)
-                    self.lbl_anim_time.setText(f"Avg anim: {avg:.2f} ms")
-                return
-
             # ─── drop face tags as before ───────────────────────────────
             if msg.startswith("#face#"):
                 return
@@ -251,10 +268,54 @@ class AppWindow(QMainWindow):
         self.viewer_timer.timeout.connect(self._update_viewer)
         self.viewer_timer.start(200)
 
+        self.dash_timer = QTimer(self)
+        self.dash_timer.timeout.connect(self.dash.redraw)
+        self.dash_timer.start(1000)
+
         # Viewer placeholder
         self.viewer = None
 
 
+    def _on_telemetry(self, t):
+        """Labels from one TELEMETRY packet (telemetry.py), the dashboard's history."""
+        reader = serial_manager.reader
+        self.history.add(t, reader.rx_bytes if reader else None)
+        sub, anim = t.zones.get("SUBMIT"), t.zones.get("ANIM")
+        if sub and sub.calls:
+            self.lbl_frame_time.setText(f"Frame: {sub.avg_us / 1000:.2f} ms (p99 {sub.p99_us / 1000:.2f})")
+        if anim and anim.calls:
+            self.lbl_anim_time.setText(f"Anim: {anim.avg_us / 1000:.2f} ms (p99 {anim.p99_us / 1000:.2f})")
+        sleep, idle = t.zones.get("SLEEP"), t.tasks.get("idle")
+        if idle:                                   # RTOS build: the idle task's share
+            load = 1.0 - idle.cpu_permille / 1000.0
+        elif sleep and sleep.calls and t.window_ms:
+            load = 1.0 - sleep.calls * sleep.avg_us / (t.window_ms * 1000.0)
+        else:
+            load = None
+        if load is None:
+            self.lbl_fps.setText(f"{t.fps:.1f} fps")
+        else:
+            self.lbl_fps.setText(f"{t.fps:.1f} fps  load {max(load, 0.0) * 100:.0f}%")
+        self.lbl_health.setText(
+            f"late {t.frames_late}  drop {t.tx_dropped_text}/{t.tx_dropped_packet}"
+            f"  dma err {t.dma_errors} / {sum(b.timeouts for b in t.buses)} hung"
+            f"  heap {t.heap_peak // 1024} kB ({t.heap_left // 1024} kB free)"
+            f"  stack {t.stack_peak} + irq {t.irq_stack_peak} B"
+            + (f"  supply {t.supply.mv / 1000:.2f} V {t.supply.ma / 1000:.1f} A"
+               f" (x{t.supply.gain_q8 / 256:.2f}, cap {t.supply.budget_ma / 1000:.1f} A)" if t.supply else "")
+            + "".join(f"  {name} {k.cpu_permille / 10:.0f}% ({k.stack_free} B free)"
+                      for name, k in t.tasks.items() if name != "idle"))
+        self.lbl_health.setToolTip("\n".join(
+            f"strip {i}: {b.transfers} transfers, {b.errors} errors, {b.timeouts} timeouts, max {b.max_us} us"
+            for i, b in enumerate(t.buses))
+            + (f"\nsupply min {t.supply.min_mv} mV, {t.supply.sags} sag ticks, model {t.supply.model_ma} mA"
+               if t.supply else ""))
+        hung = any(b.timeouts for b in t.buses)
+        self.lbl_health.setStyleSheet(
+            "color: #f88;" if t.dma_errors or hung or t.tx_dropped_packet or t.rx_overrun else "color: #ddd;")
+        self.lbl_latency.setText(self.core.latency.summary())
+        self.lbl_latency.setToolTip(f"<pre>{self.core.latency.histogram()}</pre>")
+
     def on_gyro_toggled(self, checked: bool):
         """Start or stop sending gyro data to the MCU."""
         self.btn_gyro.setText("Gyro On" if checked else "Gyro Off")
@@ -264,10 +325,41 @@ class AppWindow(QMainWindow):
             self.gyro_timer.stop()
 
 
+    def on_dash_toggled(self, checked: bool):
+        """Show or hide the telemetry dashboard."""
+        self.dash.setVisible(checked)
+        self.dash.redraw()
+
+    def on_live_toggled(self, checked: bool):
+        """Have the device mirror its frames to the preview, or stop it."""
+        self.btn_live.setText("Live On" if checked else "Live Off")
+        serial_manager.send(f"mirror {config.MIRROR_FPS if checked else 0}")
+
+    def on_rec_toggled(self, checked: bool):
+        """Start / finish a show file of what the preview receives."""
+        if self.recorder:
+            self.preview.on_frame = None
+            self.recorder.close()
+            logging.info(f"show: {self.recorder.n} frames to {self.recorder.f.name}")
+            self.recorder = None
+        if checked:
+            if not self.preview.leds:
+                logging.error("show: no geometry yet (#dumpgeo#)")
+                self.btn_rec.setChecked(False)
+                return
+            os.makedirs(config.SHOW_DIR, exist_ok=True)
+            path = os.path.join(config.SHOW_DIR, time.strftime("%Y%m%d-%H%M%S.ipshow"))
+            self.recorder = show.Recorder(path, self.preview.leds, config.MIRROR_FPS, self.geometry)
+            self.preview.on_frame = self.recorder.add
+            if not self.btn_live.isChecked():
+                self.btn_live.setChecked(True)
+
     def _send_gyro(self):
         """
         Called on each timer tick.  Grabs the latest gyro tuple
-        from ControllerCore.get_gyro(), if available, and sends it.
+        from ControllerCore.get_gyro(), if available, and sends it as an
+        ORIENT packet stamped now: a quaternion (w, x, y, z) as is, Euler
+        angles (x roll, y pitch, z yaw) converted.
         """
         try:
             gyro_data = self.core.get_gyro()
@@ -285,10 +377,13 @@ class AppWindow(QMainWindow):
             self.on_gyro_toggled(False)
             return
 
-        x, y, z = gyro_data
-        cmd = f"#gyro x={x:+.3f},y={y:+.3f},z={z:+.3f}#"
+        if len(gyro_data) == 4:
+            q = gyro_data
+        else:
+            x, y, z = gyro_data
+            q = packet.euler_quat(x, y, z)
         try:
-            serial_manager.send(cmd)
+            serial_manager.send_packet(packet.ORIENT, packet.orient(q))
         except Exception as e:
             # turn off on error
             self.on_gyro_toggled(False)
@@ -309,6 +404,17 @@ class AppWindow(QMainWindow):
         if getattr(serial_manager, 'got_geometry', False): # is true if false
             lines = serial_manager.buffer_lines
             serial_manager.buffer_lines = []
+            crc = getattr(lines, "crc", None)   # a geometry.Geometry (dump or cache)
+            if crc is not None and crc == self.geo_shown and (self.preview or self.viewer):
+                serial_manager.got_geometry = False
+                return                          # the same model again (reconnect)
+            self.geo_shown = crc
+            if self.preview:
+                if not self.preview.set_geometry(lines):
+                    logging.error("preview: geometry dump without LED lines")
+                self.geometry = show.geometry_hash(lines)
+                serial_manager.got_geometry = False
+                return
             try:
                 V, H, E, F = _parse(lines)
             except Exception as exc:
@@ -330,11 +436,12 @@ class AppWindow(QMainWindow):
 
             serial_manager.got_geometry = False
 
-        if serial_manager.pending_face is not None and self.viewer:
+        view = self.preview or self.viewer
+        if serial_manager.pending_face is not None and view:
             new_idx = serial_manager.pending_face
             serial_manager.pending_face = None
-            if new_idx != self.viewer.current_face:
-                self.viewer.show_face(new_idx)
+            if new_idx != view.current_face:
+                view.show_face(new_idx)
 
     def _on_timer(self):
         self.core.step()
@@ -344,6 +451,9 @@ class AppWindow(QMainWindow):
     def closeEvent(self, event):
         self.step_timer.stop()
         self.viewer_timer.stop()
+        self.dash_timer.stop()
+        if self.recorder:
+            self.btn_rec.setChecked(False)
         self.core.shutdown()
         super().closeEvent(event)
 
@@ -0,0 +1,230 @@
+"""audio_sync.py - music sync from the show PC's sound (led/audio.h)
+-------------------------------------------------------------------------------
+Analyses what the PC plays (or a microphone, or a WAV file) and sends every
+device an AUDIO packet (packet.py) per frame: 8 band levels, the overall
+level, the spectral flux, a beat count, the phase through the beat and the
+tempo. Firmware built with LED_AUDIO_HOST hands them to the animations as if
+it had analysed them itself (audio_frame()), without sampling or an FFT of
+its own.
+
+The analysis is the firmware's (led/audio.c), with a longer window: Hann
+window, log spaced bands from 40 Hz, each band in dB against its own
+decaying peak over a 30 dB range, a -70 dBFS floor, onsets where the flux
+stands out of its running mean. On top of that, the tempo: the flux
+envelope of the last HISTORY_S seconds is autocorrelated over 60 … 200 BPM
+(mid tempos preferred), and a beat clock at that tempo is pulled towards
+the onsets. The beats it counts are what the devices flash on, the phase
+lets them move smoothly in between. --lead-ms sends the phase that far
+ahead, for the capture and USB latency.
+
+    python audio_sync.py --port COM5                    # what the PC plays
+    python audio_sync.py --all --mic                    # the default microphone
+    python audio_sync.py --port COM5 --device "USB Audio" --lead-ms 40
+    python audio_sync.py --port COM5 --wav set.wav      # a file, in real time
+    python audio_sync.py --list                         # the capture devices
+
+Capture needs the soundcard package (loopback of the playing device on
+Windows, macOS with a loopback driver, and PulseAudio / PipeWire).
+"""
+import argparse, collections, math, sys, time, wave
+
+import numpy as np
+
+import packet
+
+BANDS = 8                                       # PKT_AUDIO's
+F_LO = 40.0
+RANGE_DB, PEAK_FALL_DB, FLOOR_DB = 30.0, 6.0, -70.0     # as led/audio.h
+ONSET_K, ONSET_GAP_S = 1.8, 0.12
+BPM_MIN, BPM_MAX = 60, 200
+HISTORY_S = 6.0                                 # flux the tempo is taken from
+TEMPO_EVERY_S = 0.5
+PULL = 0.3                                      # of the phase error per onset
+
+
+class Analyzer:
+    """One step per frame of `hop` samples, mono float -1 … 1."""
+
+    def __init__(self, fs, fps=60.0, n=2048):
+        self.fs, self.fps, self.hop = fs, fps, round(fs / fps)
+        self.n = max(n, 1 << (2 * self.hop - 1).bit_length())    # a window covers two hops
+        self.win = np.hanning(self.n).astype(np.float32)
+        self.buf = np.zeros(self.n, np.float32)
+        freq = np.fft.rfftfreq(self.n, 1 / fs)
+        edges = F_LO * (fs / 2 / F_LO) ** (np.arange(BANDS + 1) / BANDS)
+        band = np.searchsorted(edges, freq, side="right") - 1
+        self.sel = (band >= 0) & (band < BANDS)
+        self.band = band[self.sel]
+        self.db_fs = -20 * math.log10(self.win.sum() / 2)      # full scale sine: 0 dB
+        self.peak = np.full(BANDS, FLOOR_DB + RANGE_DB)
+        self.last = np.full(BANDS, FLOOR_DB)
+        self.flux_avg, self.last_onset, self.t = 0.0, -1.0, 0.0
+        self.env = collections.deque(maxlen=round(HISTORY_S * fps))
+        self.next_tempo = TEMPO_EVERY_S
+        self.bpm, self.phase, self.beats = 0.0, 0.0, 0
+
+    def step(self, x):
+        """The frame's samples in; (bands, level, flux dB, onset) out."""
+        dt = len(x) / self.fs
+        self.t += dt
+        self.buf = np.concatenate((self.buf[len(x):], x))[-self.n:]
+        spec = np.fft.rfft((self.buf - self.buf.mean()) * self.win)
+        power = np.bincount(self.band, weights=(spec.real ** 2 + spec.imag ** 2)[self.sel],
+                            minlength=BANDS)
+        db = 10 * np.log10(power + 1e-20) + self.db_fs
+
+        dbf = np.maximum(db, FLOOR_DB)              # rises out of the floor only
+        flux = float(np.clip(dbf - self.last, 0, None).sum())
+        self.last = dbf
+        self.peak = np.maximum(np.maximum(self.peak - PEAK_FALL_DB * dt, db), FLOOR_DB + RANGE_DB)
+        bands = np.where(db < FLOOR_DB, 0.0, np.clip((db - (self.peak - RANGE_DB)) / RANGE_DB, 0, 1))
+
+        onset = flux > self.flux_avg * ONSET_K + 1.0 and self.t - self.last_onset >= ONSET_GAP_S
+        if onset:
+            self.last_onset = self.t
+        self.flux_avg += (flux - self.flux_avg) * 0.1
+        self.env.append(flux)
+        if self.t >= self.next_tempo:
+            self.next_tempo = self.t + TEMPO_EVERY_S
+            self.bpm = self.tempo()
+        self.beat(dt, onset)
+        return bands, float(bands.mean()), flux, onset
+
+    def tempo(self) -> float:
+        """The flux envelope's strongest period in BPM_MIN … BPM_MAX, 0 if
+        there is none to speak of (silence, no pulse)."""
+        e = np.asarray(self.env, np.float64)
+        if len(e) < self.env.maxlen // 2 or not e.any():
+            return 0.0
+        e = e - e.mean()
+        ac = np.correlate(e, e, "full")[len(e) - 1:]
+        if ac[0] <= 0:
+            return 0.0
+        lo, hi = math.ceil(60 * self.fps / BPM_MAX), math.floor(60 * self.fps / BPM_MIN)
+        lags = np.arange(lo, min(hi, len(ac) - 2) + 1)
+        bpm = 60 * self.fps / lags
+        score = ac[lags] / ac[0] * np.exp(-0.5 * np.log2(bpm / 120) ** 2)     # an octave either side of 120
+        i = int(np.argmax(score))
+        if score[i] < 0.1:
+            return 0.0
+        k = lags[i]
+        a, b, c = ac[k - 1], ac[k], ac[k + 1]      # the peak between the lags
+        d = 0.5 * (a - c) / (a - 2 * b + c) if a - 2 * b + c else 0.0
+        return 60 * self.fps / (k + max(-0.5, min(0.5, d)))
+
+    def beat(self, dt, onset):
+        """The beat clock: free running at the tempo, pulled to the onsets;
+        without a tempo every onset is a beat."""
+        if not self.bpm:
+            self.phase = 0.0
+            self.beats += onset
+            return
+        self.phase += dt * self.bpm / 60
+        if onset:
+            err = self.phase - round(self.phase)    # ahead (+) or behind (-) the nearest beat
+            self.phase = max(0.0, self.phase - PULL * err)
+        while self.phase >= 1:
+            self.phase -= 1
+            self.beats += 1
+
+
+def sources(a):
+    """Blocks of hop samples, mono float32, paced by the capture (or the
+    clock, for a file)."""
+    if a.wav:
+        with wave.open(a.wav) as w:
+            if w.getsampwidth() != 2:
+                sys.exit(f"{a.wav}: 16 bit PCM only")
+            fs, ch = w.getframerate(), w.getnchannels()
+            yield fs
+            hop, start, n = round(fs / a.fps), time.perf_counter(), 0
+            while True:
+                raw = w.readframes(hop)
+                if len(raw) < hop * ch * 2:
+                    return
+                x = np.frombuffer(raw, "<i2").reshape(-1, ch).mean(axis=1) / 32768
+                n += 1
+                time.sleep(max(0.0, start + n * hop / fs - time.perf_counter()))
+                yield x.astype(np.float32)
+    try:
+        import soundcard as sc
+    except ImportError:
+        sys.exit("capture needs the soundcard package (pip install soundcard), or --wav")
+    if a.device:
+        mics = [m for m in sc.all_microphones(include_loopback=True) if a.device.lower() in m.name.lower()]
+        if not mics:
+            sys.exit(f"no capture device like \"{a.device}\" (--list)")
+        mic = mics[0]
+    elif a.mic:
+        mic = sc.default_microphone()
+    else:
+        mic = sc.get_microphone(id=str(sc.default_speaker().name), include_loopback=True)
+    fs = 48000
+    yield fs
+    hop = round(fs / a.fps)
+    print(f"audio: {mic.name}, {fs} Hz")
+    with mic.recorder(samplerate=fs, blocksize=hop) as rec:
+        while True:
+            yield rec.record(numframes=hop).mean(axis=1).astype(np.float32)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", action="append", help="once per device")
+    ap.add_argument("--all", action="store_true", help="every sculpture found (devices.py)")
+    ap.add_argument("--fps", type=float, default=60, help="packets per second")
+    ap.add_argument("--lead-ms", type=float, default=30, help="phase sent this far ahead")
+    ap.add_argument("--mic", action="store_true", help="the default microphone, not the playback")
+    ap.add_argument("--device", help="capture device, part of its name")
+    ap.add_argument("--wav", help="a 16 bit WAV file instead, played out in real time")
+    ap.add_argument("--list", action="store_true", help="list the capture devices and end")
+    a = ap.parse_args()
+    if a.list:
+        import soundcard as sc
+        for m in sc.all_microphones(include_loopback=True):
+            print(("loopback  " if m.isloopback else "input     ") + m.name)
+        return
+    if not a.port and not a.all:
+        ap.error("--port or --all")
+
+    if a.all:
+        import devices
+        fleet = devices.Manager(use_bulk=False)
+        fleet.scan()
+        writers, ports = fleet.writers(), []
+    else:
+        import serial
+        fleet, ports = None, [serial.Serial(p, 115200, timeout=0) for p in a.port]
+        writers = [s.write for s in ports]
+
+    src = sources(a)
+    an = Analyzer(next(src), a.fps)
+    print(f"audio sync: {len(writers)} devices, {a.fps:g} packets/s, ctrl-c ends")
+    shown, sent = time.monotonic(), 0
+    try:
+        for x in src:
+            bands, level, flux, _onset = an.step(x)
+            ahead = an.phase + a.lead_ms / 1000 * an.bpm / 60
+            sent = max(sent, an.beats + int(ahead))    # a pull back must not count down
+            pkt = packet.build(packet.AUDIO, packet.audio(bands, level, flux, sent, ahead % 1, an.bpm))
+            for w in writers:
+                w(pkt)
+            if fleet:
+                fleet.drain()                   # log text, not needed here
+            for s in ports:
+                s.reset_input_buffer()
+            if time.monotonic() - shown >= 1:
+                shown = time.monotonic()
+                print(f"\r{an.bpm:6.1f} bpm  {an.beats:5d} beats  level {level:4.2f}  "
+                      + "".join(" .:-=+*#%@"[min(9, int(b * 10))] for b in bands), end="", flush=True)
+    except KeyboardInterrupt:
+        pass
+    print()
+    if fleet:
+        fleet.close()
+    for s in ports:
+        s.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+"""bench.py - the firmware's benchmark reports (led/bench.h), kept per revision
+-------------------------------------------------------------------------------
+"bench [frames]" on the console runs every animation from the same start
+(seed, time, quality) and sends one BENCH packet per animation after a
+header; Collector puts them together, save() writes the report as JSON to
+config.BENCH_DIR, named by time and firmware revision. The app's console
+does that for every run, so does `run` here. `compare` lines two reports up
+and fails on what got slower:
+
+    python bench.py run --port COM5 --frames 240
+    python bench.py list
+    python bench.py compare bench/old.json bench/new.json --threshold 0.1
+
+Times are DWT cycles in the files (cpu_hz next to them), µs when printed.
+"""
+import argparse, datetime, json, os, struct, subprocess, sys, time
+
+import config
+import packet
+
+VERSION = 2
+METRICS = ["anim", "encode", "dma"]
+STATS   = ["min", "median", "p99", "max"]
+_HEAD   = struct.Struct("<BBBHIII")
+_ANIM   = struct.Struct("<BBB12sH" + "I" * (len(METRICS) * len(STATS)) + "IIII")
+
+
+def decode(payload: bytes):
+    """BENCH payload → ("header", dict) or ("anim", dict), None for another version."""
+    if len(payload) < 3 or payload[0] != VERSION:
+        return None
+    if payload[1] == 0xFF:
+        if len(payload) < _HEAD.size:
+            return None
+        _v, _i, count, frames, seed, period, hz = _HEAD.unpack_from(payload)
+        return "header", dict(count=count, frames=frames, seed=seed, period_us=period,
+                              cpu_hz=hz, build=payload[_HEAD.size:].decode(errors="replace"))
+    if len(payload) < _ANIM.size:
+        return None
+    v = _ANIM.unpack_from(payload)
+    cyc = v[5:5 + len(METRICS) * len(STATS)]
+    stack, scratch, heap, irq = v[-4:]
+    return "anim", dict(index=v[1], count=v[2], name=v[3].rstrip(b"\0").decode(),
+                        frames=v[4], stack=stack, irq=irq, scratch=scratch, heap=heap,
+                        **{m: dict(zip(STATS, cyc[k * len(STATS):(k + 1) * len(STATS)]))
+                           for k, m in enumerate(METRICS)})
+
+
+class Collector:
+    """BENCH packets → a whole report, once the last animation is in."""
+
+    def __init__(self):
+        self.report = None
+
+    def add(self, payload: bytes):
+        got = decode(payload)
+        if got is None:
+            return None
+        kind, d = got
+        if kind == "header":
+            self.report = dict(d, anims=[])
+            return None
+        if self.report is None:
+            return None                         # joined a run half way
+        self.report["anims"].append(d)
+        if len(self.report["anims"]) < self.report["count"]:
+            return None
+        done, self.report = self.report, None
+        return done
+
+
+def git_rev() -> str:
+    """Short hash of the checkout the firmware was built from, "-dirty" if changed."""
+    try:
+        rev = subprocess.run(["git", "describe", "--always", "--dirty"], capture_output=True,
+                             text=True, timeout=5, cwd=os.path.dirname(os.path.abspath(__file__)))
+        return rev.stdout.strip() or "unknown"
+    except (OSError, subprocess.SubprocessError):
+        return "unknown"
+
+
+def save(report, rev=None) -> str:
+    """Report → BENCH_DIR/<time>_<rev>.json, the path."""
+    rev = rev or git_rev()
+    stamp = datetime.datetime.now()
+    report = dict(report, rev=rev, time=stamp.isoformat(timespec="seconds"))
+    os.makedirs(config.BENCH_DIR, exist_ok=True)
+    path = os.path.join(config.BENCH_DIR, f"{stamp:%Y%m%d-%H%M%S}_{rev}.json")
+    with open(path, "w") as f:
+        json.dump(report, f, indent=1)
+    return path
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def _us(report, cyc) -> float:
+    return cyc * 1e6 / report["cpu_hz"]
+
+
+def compare(a, b, threshold=0.1):
+    """[(anim, metric, stat, a µs, b µs)] where b is more than threshold slower."""
+    worse = []
+    old = {x["name"]: x for x in a["anims"]}
+    for x in b["anims"]:
+        y = old.get(x["name"])
+        if y is None:
+            continue
+        for m in METRICS:
+            for s in ("median", "p99"):
+                ua, ub = _us(a, y[m][s]), _us(b, x[m][s])
+                if ub > ua * (1 + threshold) and ub - ua >= 1:     # µs of jitter is no regression
+                    worse.append((x["name"], m, s, ua, ub))
+    return worse
+
+
+def print_report(r):
+    print(f"{r.get('rev', '?')}  {r['build']}, {r['frames']} frames at {r['period_us']} us, "
+          f"seed {r['seed']:#x}")
+    print(f"  {'':12}" + "".join(f"{m + ' med/p99/max us':>24}" for m in METRICS)
+          + f"{'stack':>8}{'irq':>6}{'scratch':>9}{'heap':>8}")
+    for x in r["anims"]:
+        cols = "".join(f"{'/'.join(f'{_us(r, x[m][s]):.0f}' for s in STATS[1:]):>24}" for m in METRICS)
+        print(f"  {x['name']:12}{cols}{x['stack']:>8}{x.get('irq', 0):>6}{x['scratch']:>9}{x['heap']:>8}")
+
+
+def _run(port, frames, rev):
+    import serial
+    col, buf = Collector(), b""
+    with serial.Serial(port, 115200, timeout=0.1) as s:
+        s.reset_input_buffer()
+        s.write(f"bench {frames}\n".encode())
+        wait = 5.0 + (frames or 240) / 20.0     # an animation's frames, at 20 fps or better
+        end = time.time() + wait
+        while time.time() < end:
+            buf += s.read(s.in_waiting or 1)
+            *frames_in, buf = buf.split(b"\0")
+            for fr in frames_in:
+                got = packet.parse(fr) if fr else None
+                if not got or got[0] != packet.BENCH:
+                    continue
+                end = time.time() + wait        # still going: one animation at a time
+                report = col.add(got[1])
+                if report:
+                    path = save(report, rev)
+                    print_report(load(path))
+                    print(f"saved {path}")
+                    return
+    sys.exit("no (complete) benchmark report; built with LED_PROFILE?")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("run")
+    p.add_argument("--port", required=True)
+    p.add_argument("--frames", type=int, default=0, help="per animation, 0 = BENCH_FRAMES")
+    p.add_argument("--rev", help="firmware revision (git describe of this checkout)")
+    sub.add_parser("list")
+    p = sub.add_parser("compare")
+    p.add_argument("a")
+    p.add_argument("b")
+    p.add_argument("--threshold", type=float, default=0.1, help="slower by this fraction fails")
+    a = ap.parse_args()
+    if a.cmd == "run":
+        _run(a.port, a.frames, a.rev)
+    elif a.cmd == "list":
+        names = sorted(os.listdir(config.BENCH_DIR)) if os.path.isdir(config.BENCH_DIR) else []
+        for n in names:
+            if n.endswith(".json"):
+                r = load(os.path.join(config.BENCH_DIR, n))
+                print(f"{n}  {r['build']}, {len(r['anims'])} animations, {r['frames']} frames")
+    else:
+        ra, rb = load(a.a), load(a.b)
+        print_report(ra)
+        print_report(rb)
+        worse = compare(ra, rb, a.threshold)
+        for name, m, s, ua, ub in worse:
+            print(f"{name}: {m} {s} {ua:.0f} -> {ub:.0f} us ({(ub / ua - 1) * 100 if ua else 100:+.0f}%)")
+        print(f"{len(worse)} regressions over {a.threshold:.0%}")
+        raise SystemExit(1 if worse else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,96 @@
+"""blackbox.py - the firmware's frames around a stutter (led/blackbox.h)
+-------------------------------------------------------------------------------
+The MCU keeps the last 64 frames' zone times; a frame late for its slot (or
+over "bb <us>") holds them with the 16 frames after it, "#bbspike#" says so
+on the console. "bb dump" streams the capture:
+
+    #bb# n=<frames> spike=<frame> thr=<us> period=<us> zones=<ANIM,...>#
+    #bbf <frame> <ms> <work_us> <late> <µs per zone>...#
+    #endbb#
+
+and the trace ring of the same moment after it (#trace#, trace_export.py).
+serial_manager.py saves the capture as logs/blackbox_<time>.csv; here it is
+printed, the spike marked and each zone against its median:
+
+    python blackbox.py logs/blackbox_20261015_120000.csv
+"""
+import argparse, csv, re, statistics, time
+from pathlib import Path
+
+HEADER_RE = re.compile(r"#bb#\s+n=(\d+)\s+spike=(\d+)\s+thr=(\d+)\s+period=(\d+)\s+zones=([\w,]*)#")
+COLUMNS = ["frame", "ms", "work_us", "late"]
+
+
+def parse(lines):
+    """lines: the dump from #bb# to #endbb# → (meta dict, [row dicts])."""
+    m = HEADER_RE.match(lines[0])
+    if not m:
+        raise ValueError(f"not a #bb# header: {lines[0]!r}")
+    zones = [z for z in m.group(5).split(",") if z]
+    meta = {"spike": int(m.group(2)), "thr": int(m.group(3)),
+            "period": int(m.group(4)), "zones": zones}
+    rows = []
+    for l in lines[1:]:
+        if not l.startswith("#bbf "):
+            continue
+        v = [int(x) for x in l[5:].rstrip("#").split()]
+        rows.append(dict(zip(COLUMNS + zones, v)))
+    return meta, rows
+
+
+def save(lines, out_dir="logs"):
+    """Parse and write logs/blackbox_<time>.csv, returns (path, one line summary)."""
+    meta, rows = parse(lines)
+    path = Path(out_dir) / time.strftime("blackbox_%Y%m%d_%H%M%S.csv")
+    path.parent.mkdir(exist_ok=True)
+    with open(path, "w", newline="") as f:
+        f.write(f"# spike={meta['spike']} thr={meta['thr']} period={meta['period']}\n")
+        w = csv.DictWriter(f, COLUMNS + meta["zones"])
+        w.writeheader()
+        w.writerows(rows)
+    return path, summary(meta, rows)
+
+
+def load(path):
+    with open(path, newline="") as f:
+        first = f.readline()
+        meta = dict(kv.split("=") for kv in first.lstrip("# ").split())
+        rows = [{k: int(v) for k, v in r.items()} for r in csv.DictReader(f)]
+    zones = [c for c in (rows[0] if rows else {}) if c not in COLUMNS]
+    return {"spike": int(meta["spike"]), "thr": int(meta["thr"]),
+            "period": int(meta["period"]), "zones": zones}, rows
+
+
+def summary(meta, rows):
+    """The spike frame and the zone that grew the most in it."""
+    spike = next((r for r in rows if r["frame"] == meta["spike"]), None)
+    if spike is None:
+        return f"{len(rows)} frames, no spike (taken on request)"
+    worst, grew = None, 0
+    for z in meta["zones"]:
+        d = spike[z] - statistics.median(r[z] for r in rows)
+        if d > grew:
+            worst, grew = z, d
+    s = f"{len(rows)} frames, spike frame {spike['frame']}: {spike['work_us']} us"
+    return s + (f", {worst} +{grew:.0f} us over its median" if worst else "")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("capture", help="logs/blackbox_<time>.csv")
+    args = ap.parse_args()
+
+    meta, rows = load(args.capture)
+    zones = meta["zones"]
+    print(summary(meta, rows))
+    print(f"{'frame':>8} {'ms':>9} {'work':>6}  " + " ".join(f"{z[:8]:>8}" for z in zones))
+    for r in rows:
+        mark = "<<" if r["frame"] == meta["spike"] else ("late" if r["late"] else "")
+        print(f"{r['frame']:>8} {r['ms']:>9} {r['work_us']:>6}  "
+              + " ".join(f"{r[z]:>8}" for z in zones) + f"  {mark}")
+    print(f"{'median':>8} {'':>9} {statistics.median(r['work_us'] for r in rows):>6.0f}  "
+          + " ".join(f"{statistics.median(r[z] for r in rows):>8.0f}" for z in zones))
+
+
+if __name__ == "__main__":
+    main()
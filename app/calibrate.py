@@ -0,0 +1,341 @@
+"""calibrate.py - the edge mapping from a webcam (led/calib.h, LED_CALIB)
+-------------------------------------------------------------------------------
+"calib" on the console flashes every physical block (the LED run on one
+bar, in wiring order) in a Gray code, one pattern per CALIB_HOLD_MS:
+
+    #calib# k=<i> n=<n> bits=<b> E=<E> hold=<ms>#     pattern i is lit
+    #endcalib#
+
+off, all on, a pattern per bit of the block number, and the first half of
+every block (the end the wiring starts at). A picture per pattern gives
+each lit pixel its block; a block's pixels make a segment, its half lit
+in the last picture says which end is LED 0. Segment ends close together
+are one corner. Turned between views (Enter), the sculpture shows every
+bar and corner at least once; the blocks and corners then form a graph,
+which is matched onto the polyhedron's edges and vertices from the
+geometry dump. Of the matches (the symmetries of the solid), the ones
+turning the way the camera sees the corners count, of those the one
+closest to the map the device has now.
+
+The result is printed as USER_MAP / USER_FLIP (config.h) and, with
+--apply, sent as "calib set" lines and saved on the device ("calib apply",
+flash with LED_MAP_STORE).
+
+    python calibrate.py --port COM5 --camera 0 --views 4 --apply
+
+Needs opencv-python for the camera.
+"""
+import argparse, math, re, time
+
+import numpy as np
+try:
+    import cv2
+except ImportError:                             # optional
+    cv2 = None
+
+import dlog
+import dmx_bridge
+import led_preview
+import packet
+
+CALIB_RE = re.compile(r"#calib#\s+k=(\d+)\s+n=(\d+)\s+bits=(\d+)\s+E=(\d+)\s+hold=(\d+)#")
+MIN_CONTRAST = 40               # grey levels between off and on for a pixel to count
+MIN_PIXELS   = 12               # a block with fewer lit pixels is not seen in this view
+CORNER_TOL   = 0.3              # segment ends this close (x median segment length) meet
+SHORT        = 0.4              # segments under this (x median) are left out of a view
+
+
+# ── device ────────────────────────────────────────────────────────────────
+
+def _read_lines(s, until, timeout):
+    """Text lines off an open port (LOG packets formatted), each as it comes,
+    until a line starting with `until`."""
+    buf, end = b"", time.time() + timeout
+    while time.time() < end:
+        buf += s.read(s.in_waiting or 1)
+        while True:                             # LOG packets → their text, others dropped
+            a = buf.find(b"\0")
+            b = buf.find(b"\0", a + 1) if a != -1 else -1
+            if b == -1:
+                break
+            got = packet.parse(buf[a + 1:b])
+            txt = dlog.format_packet(got[1]).encode() if got and got[0] == packet.LOG else b""
+            buf = buf[:a] + txt + buf[b + 1:]
+        while b"\n" in buf and (buf.find(b"\0") == -1 or buf.find(b"\n") < buf.find(b"\0")):
+            line, buf = buf.split(b"\n", 1)
+            text = line.decode(errors="replace").strip()
+            yield text
+            if text.startswith(until):
+                return
+    raise SystemExit(f"{s.port}: no {until}")
+
+
+def capture(s, cam, hold_ms):
+    """One view: "calib", a grey picture per pattern → (pictures, bits)."""
+    s.reset_input_buffer()
+    s.write(f"calib {hold_ms}\n".encode())
+    shots, bits = [], 0
+    for line in _read_lines(s, "#endcalib#", timeout=30):
+        m = CALIB_RE.search(line)
+        if not m:
+            continue
+        k, bits, hold = int(m.group(1)), int(m.group(3)), int(m.group(5))
+        time.sleep(hold / 2000)                 # half way into the pattern
+        for _ in range(2):                      # the driver's queued frame first
+            ok, img = cam.read()
+        if not ok:
+            raise SystemExit("camera: no picture")
+        if k != len(shots):
+            raise SystemExit(f"pattern {len(shots)} missed, hold longer (--hold)")
+        shots.append(cv2.cvtColor(img, cv2.COLOR_BGR2GRAY).astype(np.int16))
+    return shots, bits
+
+
+# ── pictures → segments ───────────────────────────────────────────────────
+
+def decode(shots, bits, blocks):
+    """Pictures of one view → {block: ((x, y) at LED 0, (x, y) at the last)}."""
+    off, on = shots[0], shots[1]
+    span = on - off
+    seen = span > MIN_CONTRAST
+    half = lambda img: (img - off) * 2 > span
+    code = np.zeros(off.shape, dtype=np.int32)
+    for k in range(bits):
+        code |= half(shots[2 + k]).astype(np.int32) << k
+    for sh in (1, 2, 4, 8):                     # Gray → binary
+        code ^= code >> sh
+    first = half(shots[2 + bits])
+
+    out = {}
+    for b in range(blocks):
+        ys, xs = np.nonzero(seen & (code == b))
+        if len(xs) < MIN_PIXELS:
+            continue
+        pts = np.stack([xs, ys], axis=1).astype(np.float64)
+        c = pts.mean(axis=0)
+        axis = np.linalg.svd(pts - c, full_matrices=False)[2][0]
+        t = (pts - c) @ axis
+        lo, hi = np.percentile(t, 2), np.percentile(t, 98)
+        a, z = tuple(c + lo * axis), tuple(c + hi * axis)
+        lit = first[ys, xs]
+        if lit.any() and t[lit].mean() > 0:     # LED 0 is where the first half is
+            a, z = z, a
+        out[b] = (a, z)
+    return out
+
+
+# ── segments → graph → map ────────────────────────────────────────────────
+
+class _Sets:
+    def __init__(self):
+        self.up = {}
+
+    def find(self, x):
+        self.up.setdefault(x, x)
+        while self.up[x] != x:
+            self.up[x] = self.up[self.up[x]]
+            x = self.up[x]
+        return x
+
+    def join(self, a, b):
+        self.up[self.find(a)] = self.find(b)
+
+
+def corners(views, blocks):
+    """Segment ends meeting in a view are one corner, over all views.
+    → ({block: (corner at LED 0, corner at the last)}, the views without
+    the segments too short to count)."""
+    sets, used = _Sets(), []
+    for segs in views:
+        lens = sorted(math.dist(a, z) for a, z in segs.values())
+        med = lens[len(lens) // 2] if lens else 0
+        # bars seen end on are too short to tell their ends apart
+        segs = {b: ab for b, ab in segs.items() if math.dist(*ab) >= SHORT * med}
+        used.append(segs)
+        ends = [((b, i), p) for b, ab in segs.items() for i, p in enumerate(ab)]
+        for n, (ka, pa) in enumerate(ends):
+            sets.find(ka)
+            for kb, pb in ends[n + 1:]:
+                if ka[0] != kb[0] and math.dist(pa, pb) < CORNER_TOL * med:
+                    sets.join(ka, kb)
+    missing = [b for b in range(blocks) if not any(b in v for v in used)]
+    if missing:
+        raise ValueError(f"blocks never seen: {missing}, add a view")
+    ids, out = {}, {}
+    for b in range(blocks):
+        a, z = (ids.setdefault(sets.find((b, i)), len(ids)) for i in (0, 1))
+        if a == z:
+            raise ValueError(f"block {b} starts and ends in the same corner")
+        out[b] = (a, z)
+    return out, used
+
+
+def _ccw(spokes):
+    """Keys of spokes {key: (dx, dy)} in counter-clockwise order."""
+    return [k for k, _ in sorted(spokes.items(), key=lambda kv: math.atan2(kv[1][1], kv[1][0]))]
+
+
+def _same_cycle(a, b):
+    if len(a) != len(b):
+        return False
+    return any(a == b[i:] + b[:i] for i in range(len(b)))
+
+
+def _logical_orders(V, E):
+    """Per vertex its edges counter-clockwise as seen from outside."""
+    mid = [sum(c) / len(V) for c in zip(*V)]
+    out = {}
+    for v, p in enumerate(V):
+        n = [p[i] - mid[i] for i in range(3)]
+        ref = (1.0, 0.0, 0.0) if abs(n[0]) < 0.9 * math.hypot(*n) else (0.0, 1.0, 0.0)
+        cross = lambda a, b: (a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                              a[0] * b[1] - a[1] * b[0])
+        u = cross(ref, n)
+        w = cross(n, u)
+        spokes = {}
+        for e, (a, b) in enumerate(E):
+            if v in (a, b):
+                q = V[b if a == v else a]
+                d = [q[i] - p[i] for i in range(3)]
+                spokes[e] = (sum(d[i] * u[i] for i in range(3)), sum(d[i] * w[i] for i in range(3)))
+        out[v] = _ccw(spokes)
+    return out
+
+
+def _matches(phys, V, E, limit=2000):
+    """Vertex maps corner → logical vertex that carry every block onto an edge."""
+    nv = 1 + max(max(ab) for ab in phys.values())
+    if nv != len(V):
+        raise ValueError(f"{nv} corners found for {len(V)} vertices, add a view")
+    adj_p = [set() for _ in range(nv)]
+    for a, z in phys.values():
+        adj_p[a].add(z)
+        adj_p[z].add(a)
+    adj_l = [set() for _ in V]
+    for a, b in E:
+        adj_l[a].add(b)
+        adj_l[b].add(a)
+    order, seen = [], set()
+    for start in range(nv):                     # breadth first: neighbours mapped early
+        queue = [start] if start not in seen else []
+        seen.update(queue)
+        while queue:
+            c = queue.pop(0)
+            order.append(c)
+            for n in sorted(adj_p[c] - seen):
+                seen.add(n)
+                queue.append(n)
+
+    found, sigma, used = [], {}, set()
+
+    def extend(i):
+        if len(found) >= limit:
+            return
+        if i == len(order):
+            found.append(dict(sigma))
+            return
+        c = order[i]
+        for v in range(len(V)):
+            if v in used or len(adj_l[v]) != len(adj_p[c]):
+                continue
+            if all(sigma[n] in adj_l[v] for n in adj_p[c] if n in sigma):
+                sigma[c] = v
+                used.add(v)
+                extend(i + 1)
+                used.discard(v)
+                del sigma[c]
+
+    extend(0)
+    return found
+
+
+def solve(views, V, E, current=None):
+    """Segments of every view, the polyhedron (V [(x, y, z)], E [(a, b)]) →
+    (USER_MAP, USER_FLIP): logical edge → physical block, wired B → A."""
+    phys, views = corners(views, len(E))
+    pairs = {frozenset(ab): e for e, ab in enumerate(E)}
+    orders = _logical_orders(V, E)
+
+    # what the camera saw turning around each corner, block → logical edge later
+    seen_orders = []
+    for segs in views:
+        at = {}
+        for b, (pa, pz) in segs.items():
+            for i, (p, q) in enumerate(((pa, pz), (pz, pa))):
+                c = phys[b][i]
+                at.setdefault(c, {})[b] = (q[0] - p[0], p[1] - q[1])   # y up
+        seen_orders += [(c, _ccw(spokes)) for c, spokes in at.items() if len(spokes) >= 3]
+
+    best, best_key = None, None
+    for sigma in _matches(phys, V, E):
+        edge = {b: pairs[frozenset((sigma[a], sigma[z]))] for b, (a, z) in phys.items()}
+        turn = 0
+        for c, blocks in seen_orders:
+            want = [e for e in orders[sigma[c]] if e in {edge[b] for b in blocks}]
+            turn += 1 if _same_cycle([edge[b] for b in blocks], want) else -1
+        umap = [0] * len(E)
+        flip = [False] * len(E)
+        for b, e in edge.items():
+            umap[e] = b
+            flip[e] = sigma[phys[b][0]] != E[e][0]
+        kept = sum(1 for e in range(len(E)) if current and current[e] == umap[e])
+        key = (turn, kept)
+        if best_key is None or key > best_key:
+            best, best_key = (umap, flip), key
+    if best is None:
+        raise ValueError("the corners do not match the polyhedron, add a view")
+    return best
+
+
+def current_map(L):
+    """The device's map from the dump's L: lines (wiring order framebuffer):
+    the block an edge's LEDs sit in, by their lowest index."""
+    if not L or None in L:
+        return None
+    lows = [min(s, s + (c - 1) * st) for s, c, st in L]
+    rank = {lo: i for i, lo in enumerate(sorted(lows))}
+    return [rank[lo] for lo in lows]
+
+
+def c_initializers(umap, flip):
+    rows = lambda xs, n: ",\n".join("    " + ", ".join(xs[i:i + n]) for i in range(0, len(xs), n))
+    return ("static const uint16_t USER_MAP[EDGE_CNT] = {\n" + rows([f"{m:3}" for m in umap], 8) +
+            "\n};\n\nstatic const bool USER_FLIP[EDGE_CNT] = {\n" +
+            rows(["true" if f else "false" for f in flip], 4) + "\n};")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", required=True)
+    ap.add_argument("--camera", type=int, default=0)
+    ap.add_argument("--views", type=int, default=4, help="picture sets, the sculpture turned between")
+    ap.add_argument("--hold", type=int, default=400, help="ms per pattern")
+    ap.add_argument("--apply", action="store_true", help="send and save the map on the device")
+    args = ap.parse_args()
+    if cv2 is None:
+        raise SystemExit("calibrate.py needs opencv-python")
+
+    import serial
+    cam = cv2.VideoCapture(args.camera)
+    with serial.Serial(args.port, 115200, timeout=0.1) as s:
+        V, E, _F, L = led_preview.parse(dmx_bridge.fetch_dump(s))
+        V = [tuple(map(float, v)) for v in V]
+        views = []
+        for n in range(args.views):
+            if n:
+                input(f"turn the sculpture for view {n + 1} of {args.views}, Enter ")
+            shots, bits = capture(s, cam, args.hold)
+            views.append(decode(shots, bits, len(E)))
+            print(f"view {n + 1}: {len(views[-1])} of {len(E)} blocks")
+        umap, flip = solve(views, V, E, current_map(L))
+        print(c_initializers(umap, flip))
+        if args.apply:
+            for e in range(len(E)):
+                s.write(f"calib set {e} {umap[e]} {int(flip[e])}\n".encode())
+                time.sleep(0.01)
+            s.write(b"calib apply\n")
+            print("sent, saved on the device")
+
+
+if __name__ == "__main__":
+    main()
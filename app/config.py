@@ -1,9 +1,10 @@
 import pygame
+import packet
 
 
 #===============[ PS4 CONTROLLER MAPPING ]===============
 
-UPDATES_PER_SEC = 5 # 5 Hz Serial spam rate
+UPDATES_PER_SEC = 30 # stick / trigger packets per second at most (one CONTROL packet each, only when a step adds up)
 
 #-----------------------------------------------
 
@@ -50,7 +51,8 @@ TRIGGER_DEADZONE    = 0.05
 #===========================================================
 
 
-GYRO_SEND_RATE = 5
+# orientation packets per second (ORIENT, extrapolated on the device)
+ORIENT_RATE = 200
 
 #===============[ SERIAL SETTINGS ]===============
 
@@ -58,7 +60,32 @@ BAUD = 115200
 FAST_RETRY = 2.0
 SLOW_RETRY = 10.0
 
-METRICS_HISTORY = 10
+# frames a second the device mirrors to the live preview (led_preview.py)
+MIRROR_FPS = 60
+
+# where "Rec" puts the mirrored frames as show files (show.py)
+SHOW_DIR = "shows"
+
+# where the console's "bench" runs are kept, one JSON report each (bench.py)
+BENCH_DIR = "bench"
+
+# geometry dumps kept by their #geohash#, a reconnect with a known one skips
+# the dump (geometry.py)
+GEO_CACHE_DIR = "cache"
+
+# telemetry packets the app's dashboard keeps (dashboard.py), 12 minutes at
+# the firmware's default 200 ms; its baselines go in DASH_DIR, a median or p99 worse
+# than DASH_THRESHOLD against one is listed
+DASH_HISTORY = 3600
+DASH_DIR = "dash"
+DASH_THRESHOLD = 0.1
+
+# firmware build the deferred log strings come from (dlog.py, LOG_DEFERRED)
+FIRMWARE_ELF = "../firmware/stm32cube-project-files/Debug/dodecahedron.elf"
+
+# packets over the vendor bulk pipe when the firmware has one (USB_BULK,
+# usb_bulk.py, needs pyusb), the serial port otherwise
+USE_BULK = True
 
 #===========================================================
 
@@ -73,9 +100,12 @@ COMMANDS = {
     'reverse':'r',      # flip/reverse edge
     'save':   'save',   # persist mapping
     'help':   'help',   # list commands
-    'dump':   '#dumpgeo#',  # dump current model
+    'dump':   '#dumpgeob#', # dump current model (GEOMETRY packets, #dumpgeo#: as text)
+    'geohash':'#geohash#',  # ask for the model's hash (geometry cache)
     'print':  'g',      # print sample poly (printPolys)
     'hue':    'h', 
+    'trace':  'trace',  # dump event timeline (saved as Chrome trace JSON)
+    'hud':    'hud',    # performance gauges on the sculpture, on / off
 }
 
 # Joystick button → command key mapping
@@ -86,7 +116,8 @@ JOYSTICK_BUTTON_MAPPING = {
     BTN_R1:       'f++',  # face +1
     BTN_TRIANGLE: COMMANDS['print'],
     BTN_OPTIONS:  COMMANDS['dump'],
-    BTN_CIRCLE:  COMMANDS['mode']
+    BTN_CIRCLE:  COMMANDS['mode'],
+    BTN_SHARE:    COMMANDS['hud'],
 }
 
 # Keyboard key → command key mapping
@@ -108,6 +139,14 @@ AXIS_MAPPING = {
     COMMANDS['edge']:   RIGHT_STICK_X,
 }
 
+# command → CONTROL op (packet.py); sticks step, hue is sent as a value
+CONTROL_OPS = {
+    COMMANDS['face']: packet.FACE,
+    COMMANDS['bar']:  packet.BAR,
+    COMMANDS['edge']: packet.SLOT,
+    COMMANDS['hue']:  packet.HUE,
+}
+
 TRIGGER_MAPPING = {
     COMMANDS['hue']: [
         (LEFT_TRIGGER,  -1),  # LT für negativen Delta
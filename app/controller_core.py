@@ -4,45 +4,168 @@ controller_core.py – zentrale Logik für Joystick/Keyboard und Serial I/O
 """
 import time
 import logging
+import threading
+import collections
 import pygame
 import config
+import packet
 import serial_manager
+import latency
 
-class ControllerCore:
+PROBE_INTERVAL = 0.2    # s between latency probes, stick packets come far more often
+IDLE_WAIT_MS   = 200    # event wait with nothing held, how soon shutdown() is seen
+
+
+class InputThread(threading.Thread):
     """
-    Core logic for joystick and keyboard input, serial reconnect/drain,
-    sending commands based on mappings.
+    pygame on its own thread, woken by its events instead of polled: a
+    button press sends its command once (again every REPEAT_DELAY while
+    held), stick and trigger moves are kept and integrated over the time
+    they were held. At most one CONTROL packet per 1 / UPDATES_PER_SEC, and
+    only with something in it that changes on the device: whole stick steps
+    (the rest carried over), a hue that moved a level. Nothing moving, the
+    thread sleeps in pygame.event.wait().
+
+    Sends go to `outbox` as ("cmd", text, t_input) / ("control", payload,
+    t_input), log lines as ("log", level, text); the GUI thread's step()
+    handles them, the port and the log console stay on one thread.
     """
-    def __init__(self):
-        logging.info("[info] Initializing ControllerCore...")
+
+    def __init__(self, outbox):
+        super().__init__(daemon=True, name="input")
+        self.outbox = outbox
+        self.running = True
+        self.joysticks = {}     # instance id → Joystick
+        self.axes = {}          # (instance id, axis) → last value
+        self.held = {}          # button → time of its next repeat
+        self.pressed = {}       # button → time of its last press (debounce)
+        self.acc = {}           # stick op → steps not sent yet
+        self.hue = 0.0          # absolute, the device takes it as is
+        self.sent_hue = 0
+        self.last = time.time()
+        self.next_send = 0.0
+
+    def run(self):
         pygame.init()
         pygame.joystick.init()
-        self._gyro = None   # placeholder for last‐read gyro tuple
-        # Liste aller verbundenen Joysticks
-        self.joysticks = []
-        self._init_joysticks()
+        while self.running:
+            try:
+                ev = pygame.event.wait(self._wait_ms())
+                events = ([ev] if ev.type != pygame.NOEVENT else []) + pygame.event.get()
+            except Exception as e:
+                self._log(logging.ERROR, f"Pygame event wait failed: {e}")
+                time.sleep(IDLE_WAIT_MS / 1000)
+                continue
+            now = time.time()
+            t_input = latency.now_us()  # what the buttons / sticks below stand for
+            for event in events:
+                self._event(event, now, t_input)
+            for btn, at in list(self.held.items()):
+                if now >= at:
+                    self._send_cmd(btn, now, t_input)
+            self._sticks(now, t_input)
+        pygame.quit()
 
-        # Button-Debounce-/Repeat-State
-        self.btn_last = {btn: 0.0 for btn in config.JOYSTICK_BUTTON_MAPPING}
-        self.btn_repeat = {btn: False for btn in config.JOYSTICK_BUTTON_MAPPING}
+    def _moving(self):
+        return any(abs(v) > config.STICK_DEADZONE for (_j, a), v in self.axes.items()
+                   if a in config.AXIS_MAPPING.values()) or \
+               any(self.axes.get((j, a), 0.0) > config.TRIGGER_DEADZONE / 2
+                   for j in self.joysticks for axes in config.TRIGGER_MAPPING.values()
+                   for a, _sign in axes)
 
-        # Zeit für nächstes Axis-Kommando
-        self.next_axis_time = 0.0
+    def _wait_ms(self):
+        """Until the next repeat or packet when something is held, else idle."""
+        now, due = time.time(), list(self.held.values())
+        if self._moving():
+            due.append(max(self.next_send, now + 0.001))
+        if not due:
+            return IDLE_WAIT_MS
+        return max(1, min(IDLE_WAIT_MS, int((min(due) - now) * 1000) + 1))
 
-        logging.info("[info] ControllerCore initialized.")
-
-    def _init_joysticks(self):
-        """Initial scan: alle aktuell eingesteckten Joysticks verbinden"""
-        count = pygame.joystick.get_count()
-        for idx in range(count):
+    def _event(self, event, now, t_input):
+        if event.type == pygame.JOYDEVICEADDED:
             try:
-                joy = pygame.joystick.Joystick(idx)
+                joy = pygame.joystick.Joystick(event.device_index)
                 joy.init()
-                self.joysticks.append(joy)
                 jid = getattr(joy, 'get_instance_id', joy.get_id)()
-                logging.info(f"[info] Joystick '{joy.get_name()}' connected (instance {jid})")
+                self.joysticks[jid] = joy
+                self._log(logging.INFO, f"[info] Joystick '{joy.get_name()}' connected (instance {jid})")
             except Exception as e:
-                logging.error(f"[error] Failed to init joystick {idx}: {e}")
+                self._log(logging.ERROR, f"[error] Could not add joystick at index {event.device_index}: {e}")
+        elif event.type == pygame.JOYDEVICEREMOVED:
+            joy = self.joysticks.pop(event.instance_id, None)
+            if joy:
+                self._log(logging.INFO, f"[info] Joystick '{joy.get_name()}' disconnected (instance {event.instance_id})")
+            self.axes = {k: v for k, v in self.axes.items() if k[0] != event.instance_id}
+        elif event.type == pygame.JOYBUTTONDOWN:
+            btn = event.button
+            if btn in config.JOYSTICK_BUTTON_MAPPING and \
+                    now - self.pressed.get(btn, 0.0) >= config.DEBOUNCE_MS:
+                self.pressed[btn] = now
+                self._send_cmd(btn, now, t_input)
+        elif event.type == pygame.JOYBUTTONUP:
+            self.held.pop(event.button, None)
+        elif event.type == pygame.JOYAXISMOTION:
+            self.axes[(event.instance_id, event.axis)] = event.value
+
+    def _log(self, level, text):
+        self.outbox.append(("log", level, text))
+
+    def _send_cmd(self, btn, now, t_input):
+        self.outbox.append(("cmd", config.JOYSTICK_BUTTON_MAPPING[btn], t_input))
+        self.held[btn] = now + config.REPEAT_DELAY
+
+    def _sticks(self, now, t_input):
+        """Integrate the axes since the last wake-up, send what adds up."""
+        dt, self.last = now - self.last, now
+        for jid in self.joysticks:
+            for cmd, axis in config.AXIS_MAPPING.items():
+                val = self.axes.get((jid, axis), 0.0)
+                if abs(val) > config.STICK_DEADZONE:
+                    op = config.CONTROL_OPS[cmd]
+                    self.acc[op] = self.acc.get(op, 0.0) + val * config.STICK_SENSE * dt
+            for cmd, axis_list in config.TRIGGER_MAPPING.items():
+                for axis, sign in axis_list:
+                    val = self.axes.get((jid, axis), 0.0)
+                    if val > config.TRIGGER_DEADZONE / 2:
+                        self.hue = (self.hue + sign * val * config.TRIGGER_SENSE * dt) % 255
+        if now < self.next_send:
+            return
+        ops = []
+        for op, a in self.acc.items():
+            if int(a):
+                ops.append((op | packet.DELTA, float(int(a))))
+                self.acc[op] = a - int(a)
+        if int(self.hue) != self.sent_hue:
+            self.sent_hue = int(self.hue)
+            ops.append((config.CONTROL_OPS[config.COMMANDS['hue']], self.sent_hue))
+        if ops:
+            self.outbox.append(("control", packet.control(ops), t_input))
+            self.next_send = now + 1.0 / config.UPDATES_PER_SEC
+
+    def stop(self):
+        self.running = False
+        self.join(timeout=1.0)
+
+
+class ControllerCore:
+    """
+    Core logic for joystick input (InputThread) and serial I/O: reconnect,
+    drain, and the sends the input thread queued.
+    """
+    def __init__(self):
+        logging.info("[info] Initializing ControllerCore...")
+        self._gyro = None   # placeholder for last‐read gyro tuple
+        self.outbox = collections.deque()
+        self.input = InputThread(self.outbox)
+        self.input.start()
+
+        # input-to-light probes behind commands (latency.py)
+        self.latency = latency.Tracker()
+        self.next_probe = 0.0
+        serial_manager.on_probe = self.latency.reply
+
+        logging.info("[info] ControllerCore initialized.")
 
     def step(self):
         now = time.time()
@@ -51,79 +174,24 @@ class ControllerCore:
         serial_manager.try_reconnect()
         serial_manager.drain()
 
-        # Pygame Event-Handling
-        try:
-            pygame.event.pump()
-            events = pygame.event.get()
-        except Exception as e:
-            logging.error(f"Pygame event pump/get failed: {e}")
-            events = []
-
-        for event in events:
-            if event.type == pygame.JOYDEVICEADDED:
-                idx = event.device_index
-                try:
-                    joy = pygame.joystick.Joystick(idx)
-                    joy.init()
-                    self.joysticks.append(joy)
-                    jid = getattr(joy, 'get_instance_id', joy.get_id)()
-                    logging.info(f"[info] Joystick '{joy.get_name()}' connected (instance {jid})")
-                except Exception as e:
-                    logging.error(f"[error] Could not add joystick at index {idx}: {e}")
-            elif event.type == pygame.JOYDEVICEREMOVED:
-                inst = getattr(event, 'instance_id', None)
-                for joy in list(self.joysticks):
-                    jid = getattr(joy, 'get_instance_id', joy.get_id)()
-                    if jid == inst:
-                        logging.info(f"[info] Joystick '{joy.get_name()}' disconnected (instance {jid})")
-                        self.joysticks.remove(joy)
-                        break
-
-        try: 
-            for joy in self.joysticks:
-                for btn, cmd in config.JOYSTICK_BUTTON_MAPPING.items():
-                    try:
-                        pressed = joy.get_button(btn)
-                    except Exception:
-                        continue
-                    if pressed:
-                        delay = config.REPEAT_DELAY if self.btn_repeat[btn] else config.DEBOUNCE_MS
-                        if now - self.btn_last[btn] >= delay:
-                            serial_manager.send(cmd)
-                            self.btn_last[btn] = now
-                            self.btn_repeat[btn] = True
-                    else:
-                        self.btn_repeat[btn] = False
-
-            # Polling der Achsen für kontinuierliche Befehle
-            for joy in self.joysticks:
-                for cmd, axis in config.AXIS_MAPPING.items():
-                    try:
-                        val = joy.get_axis(axis)
-                    except Exception:
-                        continue
-                    if abs(val) > config.STICK_DEADZONE and now >= self.next_axis_time:
-                        delta = val * (config.STICK_SENSE / config.UPDATES_PER_SEC)
-                        serial_manager.send(f"{cmd} {delta:+.3f}")
-                        self.next_axis_time = now + 1.0 / config.UPDATES_PER_SEC
-
-            for cmd, axis_list in config.TRIGGER_MAPPING.items():
-                for axis, sign in axis_list:
-                    val = joy.get_axis(axis)
-                    if val > config.TRIGGER_DEADZONE/2 and now >= self.next_axis_time:
-                        delta = sign * val * (config.TRIGGER_SENSE / config.UPDATES_PER_SEC)
-                        serial_manager.send(f"{cmd} {delta:+.3f}")
-                        self.next_axis_time = now + 1.0 / config.UPDATES_PER_SEC 
+        # what the input thread queued, in order
+        while self.outbox:
+            kind, what, arg = self.outbox.popleft()
+            if kind == "log":
+                logging.log(what, arg)          # level, text
+                continue
+            if kind == "cmd":
+                serial_manager.send(what)
+            else:
+                serial_manager.send_packet(packet.CONTROL, what)
+            self._probe(now, arg)               # t_input
 
-        except: 
-            pass
-
-                # ─── if the UI asked for gyro, sample & send it ─────────────────
-        if self.joysticks:
-            try:
-                self._gyro = None
-            except:
-                pass
+    def _probe(self, now, t_input):
+        """PROBE right behind a command, at most every PROBE_INTERVAL."""
+        if now < self.next_probe:
+            return
+        self.next_probe = now + PROBE_INTERVAL
+        serial_manager.send_packet(packet.PROBE, self.latency.payload(t_input))
 
     def get_gyro(self):
         """
@@ -134,5 +202,5 @@ class ControllerCore:
     
     def shutdown(self):
         logging.info("[info] Shutting down ControllerCore...")
-        serial_manager.close_serial()
-        pygame.quit()
\ No newline at end of file
+        self.input.stop()
+        serial_manager.close_serial()
\ No newline at end of file
@@ -0,0 +1,216 @@
+"""daemon.py - the sculptures without the app: a headless link with a WebSocket / UDP API
+-------------------------------------------------------------------------------
+For a show PC that only streams and controls. No Qt, matplotlib or pygame:
+the daemon holds every sculpture's port and bulk pipe (devices.Manager, a
+reader thread each), keeps the SYNC frame grid going (sync.py, --sync) and
+lets any number of clients in at once, the app's tools, scripts, a show
+runner, each seeing everything that comes in.
+
+WebSocket (--ws, needs the websockets package), one JSON object per message:
+
+    in  {"cmd": "seed 7"}                           a console line
+        {"packet": 7, "data": "<hex payload>"}      a packet (packet.py types)
+        {"select": ["3473367A3138"]}                where this client's
+                                                    messages go, null: all
+        a binary message                            bytes as they are (stream
+                                                    frames after "stream")
+        any of the JSON ones may carry "to": a serial number or a list
+    out {"devices": [...]}                          on connect, and
+        {"opened": [...], "closed": [...]}          when they change
+        {"dev": sn, "line": "..."}                  console and LOG text
+        {"dev": sn, "packet": t, "data": "<hex>", "us": arrival}
+                                                    "telemetry": {...} added
+                                                    to TELEMETRY ones
+        {"dev": sn, "warn": "..."}
+
+UDP (--udp), for whatever cannot hold a connection (lighting desks,
+one-line scripts); goes to every sculpture, nothing comes back:
+
+    a datagram of text                              console line(s)
+    a datagram starting with 0x00                   bytes as they are (a
+                                                    packet.build() frame, a
+                                                    stream frame)
+
+    python daemon.py                                # ws :8765, udp :8766
+    python daemon.py --sync 60 --udp 0              # frame grid, no UDP
+    echo "telem 1000" | nc -u -q0 localhost 8766
+
+A client that does not keep up loses messages (CLIENT_QUEUE), the links
+never wait for one. The app itself wants the ports for its own, run one or
+the other on a sculpture.
+"""
+import argparse, asyncio, dataclasses, json, socket
+
+import devices
+import dlog
+import packet
+import sync
+import telemetry
+
+SCAN_S       = 2.0                      # look for sculptures plugged in / gone
+POLL_S       = 0.005                    # drain the readers
+CLIENT_QUEUE = 2000                     # messages held per client, then dropped
+
+
+def event_json(sn, ev):
+    """A Reader event → the message clients get."""
+    if ev[0] == "line":
+        return {"dev": sn, "line": ev[1]}
+    if ev[0] == "warn":
+        return {"dev": sn, "warn": ev[1]}
+    _kind, ptype, payload, us = ev
+    msg = {"dev": sn, "packet": ptype, "data": payload.hex(), "us": us}
+    if ptype == packet.TELEMETRY:
+        t = telemetry.decode(payload)
+        if t:
+            msg["telemetry"] = dataclasses.asdict(t)
+    return msg
+
+
+class Client:
+    """One WebSocket connection: its queue, writer task and selection."""
+
+    def __init__(self, ws):
+        self.ws = ws
+        self.queue = asyncio.Queue(CLIENT_QUEUE)
+        self.to = None                  # serial numbers, None: all
+        self.dropped = 0
+
+    def put(self, text):
+        try:
+            self.queue.put_nowait(text)
+        except asyncio.QueueFull:
+            self.dropped += 1
+
+    async def writer(self):
+        while True:
+            await self.ws.send(await self.queue.get())
+
+
+class Daemon:
+    def __init__(self, use_bulk=True, sync_fps=0.0):
+        self.manager = devices.Manager(use_bulk)
+        self.clients = set()
+        self.clock = sync.Clock(sync_fps) if sync_fps else None
+        self.sender = None
+
+    # ── links ──
+    def broadcast(self, msg):
+        text = json.dumps(msg)
+        for c in self.clients:
+            c.put(text)
+
+    def scan(self):
+        opened, closed = self.manager.scan()
+        if opened or closed:
+            print(f"opened {opened} closed {closed}, {len(self.manager.devices)} sculptures")
+            self.broadcast({"opened": opened, "closed": closed})
+            if self.clock:              # stamped per device, so per writer
+                self.sender = sync.Sender(self.clock, self.manager.writers())
+
+    async def links(self):
+        loop = asyncio.get_running_loop()
+        next_scan = 0.0
+        while True:
+            if loop.time() >= next_scan:
+                next_scan = loop.time() + SCAN_S
+                await loop.run_in_executor(None, self.scan)
+            if self.sender:
+                self.sender.poll()
+            events = self.manager.drain()
+            if events and self.clients:
+                for sn, ev in events:
+                    self.broadcast(event_json(sn, ev))
+            await asyncio.sleep(POLL_S)
+
+    def handle(self, msg, to=None):
+        """One client JSON message; to: the client's selection."""
+        to = msg.get("to", to)
+        if "cmd" in msg:
+            self.manager.send(str(msg["cmd"]), to)
+        elif "packet" in msg:
+            self.manager.send_packet(int(msg["packet"]), bytes.fromhex(msg.get("data", "")), to)
+
+    # ── WebSocket ──
+    async def client(self, ws, _path=None):
+        c = Client(ws)
+        self.clients.add(c)
+        await ws.send(json.dumps({"devices": sorted(self.manager.devices)}))
+        writer = asyncio.ensure_future(c.writer())
+        try:
+            async for m in ws:
+                if isinstance(m, bytes):
+                    self.manager.write(m, c.to)
+                    continue
+                try:
+                    msg = json.loads(m)
+                    if "select" in msg:
+                        c.to = msg["select"]
+                    else:
+                        self.handle(msg, c.to)
+                except (ValueError, TypeError, AttributeError) as e:
+                    c.put(json.dumps({"error": f"{e}: {m[:80]}"}))
+        finally:
+            writer.cancel()
+            self.clients.discard(c)
+            if c.dropped:
+                print(f"client {ws.remote_address}: {c.dropped} messages dropped")
+
+    # ── UDP ──
+    def datagram(self, data):
+        if data[:1] == b"\0":
+            self.manager.write(data)
+        else:
+            for line in data.decode(errors="replace").splitlines():
+                if line.strip():
+                    self.manager.send(line.strip())
+
+
+class _Udp(asyncio.DatagramProtocol):
+    def __init__(self, daemon):
+        self.daemon = daemon
+
+    def datagram_received(self, data, _addr):
+        self.daemon.datagram(data)
+
+
+async def serve(args):
+    d = Daemon(not args.no_bulk, args.sync)
+    loop = asyncio.get_running_loop()
+    if args.udp:
+        await loop.create_datagram_endpoint(lambda: _Udp(d), local_addr=(args.bind, args.udp),
+                                            family=socket.AF_INET)
+        print(f"udp {args.bind}:{args.udp}")
+    if args.ws:
+        try:
+            import websockets
+        except ImportError:
+            raise SystemExit("--ws needs the websockets package (--ws 0 for UDP only)")
+        await websockets.serve(d.client, args.bind, args.ws, max_size=1 << 20)
+        print(f"ws://{args.bind}:{args.ws}")
+    try:
+        await d.links()
+    finally:
+        d.manager.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--ws", type=int, default=8765, help="WebSocket port, 0: none")
+    ap.add_argument("--udp", type=int, default=8766, help="UDP port, 0: none")
+    ap.add_argument("--bind", default="127.0.0.1", help="0.0.0.0 for the network")
+    ap.add_argument("--sync", type=float, default=0.0, metavar="FPS",
+                    help="keep every sculpture on one frame grid (sync.py)")
+    ap.add_argument("--no-bulk", action="store_true", help="everything on the ports")
+    ap.add_argument("--elf", help="firmware ELF for LOG packets (LOG_DEFERRED builds)")
+    args = ap.parse_args()
+    if args.elf:
+        dlog.set_elf(args.elf)
+    try:
+        asyncio.run(serve(args))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,253 @@
+"""dashboard.py - long telemetry history, percentiles, export and baselines
+-------------------------------------------------------------------------------
+The labels above the console show the last TELEMETRY packet only. History
+keeps config.DASH_HISTORY of them (one per telemetry interval, "telem <ms>"
+on the console) as the series below, Pane plots them in the app ("Dash"):
+
+    fps                         frames per second of the window
+    anim / encode / dma ms      profiler zone averages, anim p99 next to it
+    load %                      awake share: 1 - SLEEP (idle task on RTOS)
+    usb kB/s                    bytes the reader got, port and bulk pipe
+    heap kB / stack / irq B     high-water marks since boot
+
+summary() gives min / p50 / p95 / p99 / max per series; to_csv() and
+to_parquet() (needs pandas with pyarrow) write the samples. A run's
+summary saved with save_baseline() (config.DASH_DIR, named by time and
+firmware revision like bench.py's reports) is what later runs compare()
+against: a median or tail (p99, the minimum for fps and usb) worse by
+more than the threshold is listed.
+"""
+import collections, csv, datetime, json, os
+
+import config
+import bench
+
+# key, label, plot, higher is worse
+SERIES = [
+    ("fps",        "fps",          0, False),
+    ("anim_ms",    "anim ms",      1, True),
+    ("anim_p99",   "anim p99 ms",  1, True),
+    ("encode_ms",  "encode ms",    1, True),
+    ("dma_ms",     "dma ms",       1, True),
+    ("load",       "load %",       2, True),
+    ("usb_kbs",    "usb kB/s",     2, False),
+    ("heap_kb",    "heap kB",      3, True),
+    ("stack",      "stack B",      3, True),
+    ("irq_stack",  "irq stack B",  3, True),
+]
+PLOTS = ["frame rate", "zone times", "load, usb", "memory high-water"]
+PCTS  = [50, 95, 99]
+
+
+def _ms(zone):
+    return zone.avg_us / 1000.0 if zone and zone.calls else None
+
+
+def sample(t, usb_kbs=None):
+    """One Telemetry → {series key: value or None}."""
+    anim, sleep, idle = t.zones.get("ANIM"), t.zones.get("SLEEP"), t.tasks.get("idle")
+    if idle:
+        load = 100.0 - idle.cpu_permille / 10.0
+    elif sleep and sleep.calls and t.window_ms:
+        load = max(0.0, 100.0 - sleep.calls * sleep.avg_us / (t.window_ms * 10.0))
+    else:
+        load = None
+    return {"fps": t.fps, "anim_ms": _ms(anim),
+            "anim_p99": anim.p99_us / 1000.0 if anim and anim.calls else None,
+            "encode_ms": _ms(t.zones.get("ENCODE")), "dma_ms": _ms(t.zones.get("DMA_WAIT")),
+            "load": load, "usb_kbs": usb_kbs, "heap_kb": t.heap_peak / 1024.0,
+            "stack": t.stack_peak, "irq_stack": t.irq_stack_peak}
+
+
+def percentile(xs, p):
+    """Nearest rank of the sorted xs."""
+    if not xs:
+        return None
+    k = max(0, min(len(xs) - 1, round(p / 100.0 * len(xs) + 0.5) - 1))
+    return xs[k]
+
+
+class History:
+    """The last `size` samples, each with the device's uptime and the host time."""
+
+    def __init__(self, size=None):
+        self.rows = collections.deque(maxlen=size or config.DASH_HISTORY)
+        self.last_rx = None             # (host s, reader bytes) of the previous packet
+
+    def add(self, t, rx_bytes=None, now=None):
+        """A Telemetry; rx_bytes the reader's total so far, for the usb rate."""
+        now = now if now is not None else datetime.datetime.now().timestamp()
+        kbs = None
+        if rx_bytes is not None:
+            if self.last_rx and now > self.last_rx[0] and rx_bytes >= self.last_rx[1]:
+                kbs = (rx_bytes - self.last_rx[1]) / (now - self.last_rx[0]) / 1024.0
+            self.last_rx = (now, rx_bytes)
+        self.rows.append(dict(sample(t, kbs), time=now, uptime_ms=t.uptime_ms))
+
+    def clear(self):
+        self.rows.clear()
+        self.last_rx = None
+
+    def series(self, key):
+        """[(host s, value)] of one series, gaps left out."""
+        return [(r["time"], r[key]) for r in self.rows if r[key] is not None]
+
+    def summary(self):
+        """{key: {"n", "min", "p50", "p95", "p99", "max"}} of the series with data."""
+        out = {}
+        for key, *_ in SERIES:
+            xs = sorted(v for _t, v in self.series(key))
+            if xs:
+                out[key] = dict(n=len(xs), min=xs[0], max=xs[-1],
+                                **{f"p{p}": percentile(xs, p) for p in PCTS})
+        return out
+
+    def to_csv(self, path):
+        cols = ["time", "uptime_ms"] + [k for k, *_ in SERIES]
+        with open(path, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=cols)
+            w.writeheader()
+            w.writerows(self.rows)
+        return path
+
+    def to_parquet(self, path):
+        import pandas                   # optional, with pyarrow or fastparquet
+        pandas.DataFrame(list(self.rows)).to_parquet(path)
+        return path
+
+    def save_baseline(self, rev=None):
+        """summary() → DASH_DIR/<time>_<rev>.json, the path."""
+        stamp = datetime.datetime.now()
+        rev = rev or bench.git_rev()
+        os.makedirs(config.DASH_DIR, exist_ok=True)
+        path = os.path.join(config.DASH_DIR, f"{stamp:%Y%m%d-%H%M%S}_{rev}.json")
+        with open(path, "w") as f:
+            json.dump(dict(rev=rev, time=stamp.isoformat(timespec="seconds"),
+                           summary=self.summary()), f, indent=1)
+        return path
+
+
+def baselines():
+    """Saved runs, newest first."""
+    if not os.path.isdir(config.DASH_DIR):
+        return []
+    return sorted((os.path.join(config.DASH_DIR, n) for n in os.listdir(config.DASH_DIR)
+                   if n.endswith(".json")), reverse=True)
+
+
+def compare(base, now, threshold=0.1):
+    """[(key, stat, baseline, now)] of what got worse than base by more than
+    threshold; both summary() dicts."""
+    worse = []
+    for key, _label, _plot, up in SERIES:
+        a, b = base.get(key), now.get(key)
+        if not a or not b:
+            continue
+        for s in ("p50", "p99") if up else ("p50", "min"):
+            x, y = a[s], b[s]
+            if (y > x * (1 + threshold)) if up else (y < x * (1 - threshold)):
+                worse.append((key, s, x, y))
+    return worse
+
+
+try:
+    from PyQt5.QtWidgets import (QWidget, QVBoxLayout, QHBoxLayout, QPushButton, QLabel,
+                                 QFileDialog)
+    from matplotlib.backends.backend_qt5agg import FigureCanvasQTAgg as FigureCanvas
+    from matplotlib.figure import Figure
+except ImportError:                     # History alone, without the app
+    QWidget = object
+
+
+class Pane(QWidget):
+    """The History's series, one plot per group, percentiles under them."""
+
+    def __init__(self, history):
+        super().__init__()
+        self.history = history
+        lay = QVBoxLayout(self)
+        lay.setContentsMargins(5, 5, 5, 5)
+        self.figure = Figure(facecolor="#353535")
+        self.canvas = FigureCanvas(self.figure)
+        lay.addWidget(self.canvas, 1)
+        self.axes = [self.figure.add_subplot(len(PLOTS), 1, i + 1) for i in range(len(PLOTS))]
+
+        bar = QHBoxLayout()
+        for text, fn in (("CSV", self._csv), ("Parquet", self._parquet),
+                         ("Baseline", self._baseline), ("Compare", self._compare),
+                         ("Clear", self._clear)):
+            b = QPushButton(text)
+            b.setFixedHeight(20)
+            b.setStyleSheet("QPushButton {background-color: #1a1a1a; color: #eee;}")
+            b.clicked.connect(fn)
+            bar.addWidget(b)
+        bar.addStretch(1)
+        lay.addLayout(bar)
+        self.lbl = QLabel("")
+        self.lbl.setStyleSheet("color: #ddd; font-family: monospace;")
+        lay.addWidget(self.lbl)
+
+    def redraw(self):
+        """Plots and the percentile table from the history, when shown."""
+        if not self.isVisible() or not self.history.rows:
+            return
+        t0 = self.history.rows[-1]["time"]
+        for i, ax in enumerate(self.axes):
+            ax.clear()
+            ax.set_facecolor("#1a1a1a")
+            ax.tick_params(colors="#ddd", labelsize=7)
+            ax.set_title(PLOTS[i], color="#ddd", fontsize=8)
+            for key, label, plot, _up in SERIES:
+                pts = self.history.series(key)
+                if plot == i and pts:
+                    ax.plot([t - t0 for t, _v in pts], [v for _t, v in pts], label=label, lw=1)
+            if ax.lines:
+                ax.legend(fontsize=7, loc="upper left")
+        self.axes[-1].set_xlabel("s", color="#ddd", fontsize=7)
+        self.figure.tight_layout()
+        self.canvas.draw_idle()
+        summ = self.history.summary()
+        self.lbl.setText("\n".join(
+            f"{label:<12}" + "".join(f"{s} {summ[key][s]:8.2f}  " for s in ("p50", "p95", "p99", "max"))
+            for key, label, *_ in SERIES if key in summ))
+
+    def _save(self, title, filt, fn):
+        path, _ = QFileDialog.getSaveFileName(self, title, "", filt)
+        if path:
+            try:
+                fn(path)
+            except ImportError:
+                self.lbl.setText("Parquet needs pandas with pyarrow")
+                return
+            self.lbl.setText(f"saved {path}")
+
+    def _csv(self):
+        self._save("Telemetry as CSV", "CSV (*.csv)", self.history.to_csv)
+
+    def _parquet(self):
+        self._save("Telemetry as Parquet", "Parquet (*.parquet)", self.history.to_parquet)
+
+    def _baseline(self):
+        self.lbl.setText(f"baseline saved to {self.history.save_baseline()}")
+
+    def _compare(self):
+        runs = baselines()
+        if not runs:
+            self.lbl.setText(f"no baseline in {config.DASH_DIR}/ yet (Baseline)")
+            return
+        path, _ = QFileDialog.getOpenFileName(self, "Compare with", runs[0], "JSON (*.json)")
+        if not path:
+            return
+        with open(path) as f:
+            base = json.load(f)
+        worse = compare(base["summary"], self.history.summary(), config.DASH_THRESHOLD)
+        self.lbl.setText(f"against {base['rev']} ({base['time']}): " + (
+            "\n".join(f"  {k} {s} {a:.2f} -> {b:.2f}" for k, s, a, b in worse)
+            if worse else f"nothing worse than {config.DASH_THRESHOLD:.0%}"))
+
+    def _clear(self):
+        self.history.clear()
+        for ax in self.axes:
+            ax.clear()
+        self.canvas.draw_idle()
+        self.lbl.setText("")
@@ -9,6 +9,8 @@ import matplotlib.pyplot as plt
 from mpl_toolkits.mplot3d.art3d import Line3DCollection, Poly3DCollection
 from matplotlib.widgets import Button
 
+import geometry
+
 
 
 from matplotlib.backends.backend_qt5agg import FigureCanvasQTAgg as FigureCanvas
@@ -38,6 +40,8 @@ def _parse(lines):
     komplett verworfen wird.
     """
     import re, logging
+    if isinstance(lines, geometry.Geometry):
+        return np.array(lines.V), np.array(lines.H), np.array(lines.E), lines.F
     V, E, F, H = [], [], [], []
 
     for line in lines:
@@ -0,0 +1,180 @@
+"""devices.py - every sculpture on the USB at once (a fleet, one per port)
+-------------------------------------------------------------------------------
+serial_manager.py drives the app's one port. Manager finds every port of
+the firmware's VID / PID (usbd_desc.c) and keeps a Device per USB serial
+number: its own port, its bulk pipe when it has one (usb_bulk.py, picked by
+the same serial number), its own reader thread (link.Reader) and
+event queue, and a lock around its writes, so one thread per stream or
+show can write to it. scan() opens what came and drops what went or
+failed, a serial number keeps its name across replugs.
+
+Commands, packets and raw bytes (stream frames, sync.py's SYNC) go to one
+device, a list, or all of them (to=None); drain() hands out what came in,
+with the device it came from:
+
+    python devices.py list
+    python devices.py send "seed 7"                 # every sculpture
+    python devices.py send "telem 0" --to 3473367A3138
+"""
+import argparse, threading, time
+
+import serial, serial.tools.list_ports
+
+import packet
+import usb_bulk
+from link import Reader
+
+VID, PID = usb_bulk.VID, usb_bulk.PID
+
+
+class Device:
+    """One sculpture: its port, pipe, reader and write lock."""
+
+    def __init__(self, sn, port, use_bulk=True):
+        self.sn, self.port = sn, port
+        self.ser = serial.Serial(port, 115200, timeout=0.1, write_timeout=0.1)
+        self.bulk = usb_bulk.open(sn) if use_bulk else None
+        self.reader = Reader(self.ser, self.bulk)
+        self.reader.name = f"reader-{sn}"
+        self.reader.start()
+        self.lock = threading.Lock()
+        self.error = None
+
+    @property
+    def alive(self):
+        return self.error is None and self.reader.error is None and self.ser.is_open
+
+    def _write(self, data, pipe=False):
+        with self.lock:
+            try:
+                if pipe and self.bulk:
+                    self.bulk.write(data)
+                else:
+                    self.ser.write(data)
+            except Exception as e:
+                self.error = e
+
+    def send(self, cmd: str):
+        """A console line."""
+        self._write((cmd + "\n").encode())
+
+    def send_packet(self, ptype: int, payload: bytes = b""):
+        self._write(packet.build(ptype, payload), pipe=True)
+
+    def write(self, data: bytes):
+        """Bytes as they are, on the port (stream frames after "stream")."""
+        self._write(data)
+
+    def close(self):
+        self.reader.stop()
+        try:
+            self.ser.close()
+        except Exception:
+            pass
+        if self.bulk:
+            self.bulk.close()
+
+
+def ports():
+    """{serial number: port} of every port with the firmware's VID / PID."""
+    found = {}
+    for p in serial.tools.list_ports.comports():
+        if p.vid == VID and p.pid == PID:
+            found[p.serial_number or p.device] = p.device
+    return found
+
+
+class Manager:
+    """The sculptures plugged in, by serial number."""
+
+    def __init__(self, use_bulk=True):
+        self.devices = {}
+        self.use_bulk = use_bulk
+
+    def scan(self):
+        """Open new ports, close the ones gone or broken. (opened, closed) names."""
+        seen, opened, closed = ports(), [], []
+        for sn, dev in list(self.devices.items()):
+            if sn not in seen or seen[sn] != dev.port or not dev.alive:
+                dev.close()
+                del self.devices[sn]
+                closed.append(sn)
+        for sn, port in seen.items():
+            if sn in self.devices:
+                continue
+            try:
+                self.devices[sn] = Device(sn, port, self.use_bulk)
+                opened.append(sn)
+            except (serial.SerialException, OSError):
+                pass                            # busy (the app has it), next scan
+        return opened, closed
+
+    def _to(self, to):
+        if to is None:
+            return list(self.devices.values())
+        names = [to] if isinstance(to, str) else to
+        return [self.devices[n] for n in names if n in self.devices]
+
+    def send(self, cmd, to=None):
+        for d in self._to(to):
+            d.send(cmd)
+
+    def send_packet(self, ptype, payload=b"", to=None):
+        """Built once per device: a stamped payload (SYNC, PROBE) should be
+        built per device instead, writers() for that."""
+        for d in self._to(to):
+            d.send_packet(ptype, payload)
+
+    def write(self, data, to=None):
+        for d in self._to(to):
+            d.write(data)
+
+    def writers(self, to=None):
+        """Each device's write(), for sync.Sender and stream loops."""
+        return [d.write for d in self._to(to)]
+
+    def drain(self, limit=2000):
+        """[(serial number, event)] of what came in, events as Reader's."""
+        out = []
+        for sn, d in self.devices.items():
+            q = d.reader.events
+            while q and len(out) < limit:
+                out.append((sn, q.popleft()))
+        return out
+
+    def close(self):
+        for d in self.devices.values():
+            d.close()
+        self.devices.clear()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("list")
+    p = sub.add_parser("send")
+    p.add_argument("line")
+    p.add_argument("--to", action="append", help="serial number, once per device (default all)")
+    p.add_argument("--wait", type=float, default=1.0, help="s of answers to print")
+    a = ap.parse_args()
+
+    if a.cmd == "list":
+        for sn, port in sorted(ports().items()):
+            print(f"{sn:<26}{port}")
+        return
+    m = Manager(use_bulk=False)
+    m.scan()
+    if not m.devices:
+        raise SystemExit("no sculpture found")
+    m.send(a.line, a.to)
+    end = time.time() + a.wait
+    while time.time() < end:
+        for sn, ev in m.drain():
+            if ev[0] == "line":
+                print(f"{sn}: {ev[1]}")
+        time.sleep(0.01)
+    m.close()
+
+
+if __name__ == "__main__":
+    main()
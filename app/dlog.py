@@ -0,0 +1,105 @@
+"""dlog.py - format the firmware's deferred log packets (led/dlog.h)
+-------------------------------------------------------------------------------
+A LOG packet is the address of a format string in the ELF's .logstr section
+(never flashed) and the raw arguments: 4 bytes per integer / float (float32),
+a length byte and the bytes per string. The format string says which is
+which, so it is read here and printed like printf would have.
+"""
+import os, re, struct
+
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t|L)?([diouxXcspeEfgG%])")
+
+_elf_path = None
+_elf_mtime = None
+_base, _strings = 0, b""
+
+
+def _load(path):
+    """.logstr of a 32 bit little endian ELF → (address, bytes)."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise ValueError("not an ELF32 little endian file")
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def header(i):
+        name, _t, _fl, addr, off, size = struct.unpack_from("<IIIIII", elf, shoff + i * shentsize)
+        return name, addr, off, size
+
+    _, _, str_off, _ = header(shstrndx)
+    for i in range(shnum):
+        name, addr, off, size = header(i)
+        end = elf.index(b"\0", str_off + name)
+        if elf[str_off + name:end] == b".logstr":
+            return addr, elf[off:off + size]
+    raise ValueError("no .logstr section (built without LOG_DEFERRED?)")
+
+
+def set_elf(path):
+    global _elf_path, _elf_mtime
+    _elf_path, _elf_mtime = path, None
+
+
+def _strings_now():
+    """Reload after a rebuild."""
+    global _elf_mtime, _base, _strings
+    if not _elf_path:
+        return False
+    try:
+        m = os.path.getmtime(_elf_path)
+        if m != _elf_mtime:
+            _base, _strings = _load(_elf_path)
+            _elf_mtime = m
+    except (OSError, ValueError):
+        return False
+    return True
+
+
+def render(fmt: str, args: bytes) -> str:
+    out, pos, i = [], 0, 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        spec = "%" + flags + width + ("." + prec if prec is not None else "")
+        try:
+            if conv == "s":
+                n = args[i]
+                out.append((spec + "s") % args[i + 1:i + 1 + n].decode(errors="replace"))
+                i += 1 + n
+                continue
+            if conv in "eEfgG":
+                v, = struct.unpack_from("<f", args, i)
+            elif conv in "di":
+                v, = struct.unpack_from("<i", args, i)
+            else:
+                v, = struct.unpack_from("<I", args, i)
+            i += 4
+        except (IndexError, struct.error):
+            out.append("<?>")                   # argument did not fit the packet
+            pos = len(fmt)
+            break
+        if conv == "c":
+            out.append((spec + "c") % chr(v & 0xFF))
+        elif conv == "p":
+            out.append("0x%08x" % v)
+        else:
+            out.append((spec + ("d" if conv == "u" else conv)) % v)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def format_packet(payload: bytes) -> str:
+    """LOG packet payload → the text the firmware would have printed."""
+    if len(payload) < 4:
+        return "[dlog] short packet\n"
+    fid, = struct.unpack_from("<I", payload)
+    if not _strings_now() or not 0 <= fid - _base < len(_strings):
+        return f"[dlog] #{fid:08x} {payload[4:].hex(' ')} (no ELF for it)\n"
+    off = fid - _base
+    fmt = _strings[off:_strings.index(b"\0", off)].decode(errors="replace")
+    return render(fmt, payload[4:])
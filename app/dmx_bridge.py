@@ -0,0 +1,264 @@
+"""dmx_bridge.py - drive the sculptures from a lighting console (Art-Net / sACN)
+-------------------------------------------------------------------------------
+Listens for Art-Net (ArtDmx, UDP 6454) and sACN (E1.31, UDP 5568, multicast
+239.255.hi.lo) and streams what comes in to one or more devices as stream.py
+frames (led/led_stream.h), delta or palette compressed.
+
+The patch comes from the devices themselves: "#dumpgeo#" lists every logical
+edge's LEDs (the "L:" lines, framebuffer index at vertex A, count, step
+towards B). Each edge is one run of RGB fixtures, edge 0 first, 170 LEDs to a
+universe; an edge that does not fit in what is left of a universe starts the
+next one, so no edge is split. Universes count on from --universe across the
+devices in --port order; the patch is printed at start.
+
+DMX comes in far more often and less regular than the devices show frames.
+It only lands in a per device buffer; one writer thread per device sends the
+newest one whenever the device took the last (it holds the endpoint until a
+frame is shown) and --fps allows. Once the console sends ArtSync / E1.31 sync
+packets, the buffers are handed over on those only, so a frame spread over
+several universes is never shown half updated.
+
+    python dmx_bridge.py --port COM5                    # Art-Net and sACN, from universe 1
+    python dmx_bridge.py --port COM5 --port COM6 --universe 0 --fps 40
+    python dmx_bridge.py --port COM5 --no-sacn --bind 2.0.0.10
+
+Deferred log builds (LOG_DEFERRED) send the dump as LOG packets, formatted
+from config.FIRMWARE_ELF (or --elf).
+"""
+import argparse, re, select, socket, struct, threading, time
+
+import packet
+import dlog
+import stream
+
+ARTNET_PORT, SACN_PORT = 6454, 5568
+ART_ID, OP_DMX, OP_SYNC = b"Art-Net\0", 0x5000, 0x5200
+ACN_ID = b"ASC-E1.17\0\0\0"
+SACN_DATA, SACN_EXTENDED, SACN_FRAMING_DATA, SACN_FRAMING_SYNC = 0x04, 0x08, 0x02, 0x01
+SACN_PREVIEW, SACN_TERMINATED = 0x80, 0x40
+LEDS_PER_UNIVERSE = 170                         # 510 of 512 channels
+SYNC_TIMEOUT = 4.0                              # no sync for this long: hand over at once (Art-Net spec)
+
+
+# ── patch ─────────────────────────────────────────────────────────────────
+
+def fetch_dump(s, timeout=3.0):
+    """#dumpgeo# on an open port → its lines."""
+    s.reset_input_buffer()
+    s.write(b"#dumpgeo#\n")
+    buf, text, end = b"", "", time.time() + timeout
+    while "#endgeo#" not in text:
+        if time.time() > end:
+            raise SystemExit(f"{s.port}: no geometry dump")
+        buf += s.read(s.in_waiting or 1)
+        while True:                             # LOG packets → their text, others dropped
+            a = buf.find(b"\0")
+            b = buf.find(b"\0", a + 1) if a != -1 else -1
+            if b == -1:
+                break
+            got = packet.parse(buf[a + 1:b])
+            txt = dlog.format_packet(got[1]).encode() if got and got[0] == packet.LOG else b""
+            buf = buf[:a] + txt + buf[b + 1:]
+        cut = buf.find(b"\0")
+        done = buf if cut == -1 else buf[:cut]
+        text += done.decode(errors="replace")
+        buf = buf[len(done):]
+    return text.splitlines()
+
+
+def fetch_edges(s, timeout=3.0):
+    """#dumpgeo# on an open port → [(start, count, step)] per logical edge."""
+    edges = {}
+    for line in fetch_dump(s, timeout):
+        if line.startswith("L:"):
+            for e, start, count, step in re.findall(r"(\d+),\((\d+),(\d+),(-?\d+)\)", line):
+                edges[int(e)] = (int(start), int(count), int(step))
+    if not edges or sorted(edges) != list(range(len(edges))):
+        raise SystemExit(f"{s.port}: dump without LED lines (firmware too old?)")
+    return [edges[e] for e in range(len(edges))]
+
+
+def patch(edges, first_universe):
+    """{universe: [(channel offset, framebuffer index), ...]}, next free universe."""
+    out, uni, used = {}, first_universe, 0
+    for start, count, step in edges:
+        if used + count > LEDS_PER_UNIVERSE and used:
+            uni, used = uni + 1, 0
+        for i in range(count):                  # > 170 LEDs on one edge: it runs on
+            if used == LEDS_PER_UNIVERSE:
+                uni, used = uni + 1, 0
+            out.setdefault(uni, []).append((3 * used, start + i * step))
+            used += 1
+    return out, uni + (used > 0)
+
+
+# ── devices ───────────────────────────────────────────────────────────────
+
+class Device:
+    """One sculpture in stream mode: DMX lands in `staging`, hand_over()
+    makes it the next frame, the writer thread sends the newest one."""
+
+    def __init__(self, port, first_universe, fps):
+        import serial
+        s = serial.Serial(port, 115200, timeout=1)
+        self.edges = fetch_edges(s)
+        s.close()
+        self.serial = stream.start(port)
+        self.universes, self.next_universe = patch(self.edges, first_universe)
+        leds = sum(c for _, c, _ in self.edges)
+        self.staging = bytearray(3 * leds)
+        self.frame, self.fresh = None, False
+        self.period = 1 / fps if fps else 0
+        self.cv = threading.Condition()
+        self.sent = self.bytes = 0
+        self.running = True
+        self.thread = threading.Thread(target=self._writer, daemon=True)
+        self.thread.start()
+
+    def dmx(self, universe, data):
+        for ch, px in self.universes[universe]:
+            rgb = data[ch:ch + 3]
+            if len(rgb) == 3:                   # a short universe leaves the rest
+                self.staging[3 * px:3 * px + 3] = rgb
+
+    def hand_over(self):
+        with self.cv:
+            self.frame, self.fresh = bytes(self.staging), True
+            self.cv.notify()
+
+    def _writer(self):
+        prev, palette, last = None, [], 0.0
+        while self.running:
+            with self.cv:
+                self.cv.wait_for(lambda: self.fresh or not self.running)
+                cur, self.fresh = self.frame, False
+            if not self.running:
+                break
+            f = stream.encode(prev, cur, palette)
+            self.serial.write(f)                # blocks until the device took the last
+            prev, self.sent, self.bytes = cur, self.sent + 1, self.bytes + len(f)
+            wait = last + self.period - time.monotonic()
+            if wait > 0:                        # frames in between coalesce
+                time.sleep(wait)
+            last = time.monotonic()
+
+    def close(self):
+        with self.cv:
+            self.running = False
+            self.cv.notify()
+        self.thread.join(1)
+        self.serial.write(b"stream off\n")
+        self.serial.close()
+
+
+# ── receivers ─────────────────────────────────────────────────────────────
+
+def artnet(data):
+    """ArtDmx → (universe, dmx), ArtSync → ("sync", None), else None."""
+    if len(data) < 12 or data[:8] != ART_ID:
+        return None
+    op, = struct.unpack_from("<H", data, 8)
+    if op == OP_SYNC:
+        return "sync", None
+    if op != OP_DMX or len(data) < 18:
+        return None
+    uni = data[14] | (data[15] & 0x7F) << 8     # port address: net | sub-net | universe
+    n, = struct.unpack_from(">H", data, 16)
+    return uni, data[18:18 + n]
+
+
+def sacn(data):
+    """E1.31 data → (universe, dmx), synchronization → ("sync", None), else None."""
+    if len(data) < 49 or data[4:16] != ACN_ID:
+        return None
+    root, = struct.unpack_from(">I", data, 18)
+    frame, = struct.unpack_from(">I", data, 40)
+    if root == SACN_EXTENDED and frame == SACN_FRAMING_SYNC:
+        return "sync", None
+    if root != SACN_DATA or frame != SACN_FRAMING_DATA or len(data) < 126:
+        return None
+    if data[112] & (SACN_PREVIEW | SACN_TERMINATED) or data[125] != 0:
+        return None                             # visualiser data, source gone, not dimmer data
+    uni, = struct.unpack_from(">H", data, 113)
+    n, = struct.unpack_from(">H", data, 123)
+    return uni, data[126:126 + n - 1]
+
+
+def open_socket(port, bind, groups=()):
+    sk = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sk.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sk.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sk.bind(("", port))
+    for g in groups:
+        mreq = socket.inet_aton(g) + socket.inet_aton(bind)
+        sk.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    return sk
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", action="append", required=True, help="once per sculpture")
+    ap.add_argument("--universe", type=int, default=1, help="first universe")
+    ap.add_argument("--fps", type=float, default=60, help="at most this many frames per device, 0 = no cap")
+    ap.add_argument("--bind", default="0.0.0.0", help="interface for the sACN multicast groups")
+    ap.add_argument("--no-artnet", action="store_true")
+    ap.add_argument("--no-sacn", action="store_true")
+    ap.add_argument("--elf", help="firmware ELF for deferred logs (default config.FIRMWARE_ELF)")
+    a = ap.parse_args()
+
+    if a.elf is None:
+        import config
+        a.elf = config.FIRMWARE_ELF
+    dlog.set_elf(a.elf)
+
+    devices, route, uni = [], {}, a.universe
+    for p in a.port:
+        d = Device(p, uni, a.fps)
+        devices.append(d)
+        for u in d.universes:
+            route.setdefault(u, []).append(d)
+        print(f"{p}: {len(d.edges)} edges, {len(d.staging) // 3} LEDs, "
+              f"universes {uni}..{d.next_universe - 1}")
+        uni = d.next_universe
+
+    socks = {}
+    if not a.no_artnet:
+        socks[open_socket(ARTNET_PORT, a.bind)] = artnet
+    if not a.no_sacn:
+        groups = [f"239.255.{u >> 8}.{u & 0xFF}" for u in route if 1 <= u <= 63999]
+        socks[open_socket(SACN_PORT, a.bind, groups)] = sacn
+    print("bridge: listening, ctrl-c ends")
+
+    last_sync, t0, packets = 0.0, time.time(), 0
+    try:
+        while True:
+            ready, _, _ = select.select(list(socks), [], [], 0.5)
+            for sk in ready:
+                data, _ = sk.recvfrom(1024)
+                got = socks[sk](data)
+                if got is None:
+                    continue
+                packets += 1
+                uni, dmx = got
+                if uni == "sync":
+                    last_sync = time.monotonic()
+                    for d in devices:
+                        d.hand_over()
+                    continue
+                held = time.monotonic() - last_sync < SYNC_TIMEOUT
+                for d in route.get(uni, ()):
+                    d.dmx(uni, dmx)
+                    if not held:
+                        d.hand_over()
+    except KeyboardInterrupt:
+        pass
+    dt = time.time() - t0
+    for d in devices:
+        d.close()
+        print(f"{d.serial.port}: {d.sent} frames, {d.sent / dt:.1f} fps, "
+              f"{d.bytes / max(d.sent, 1):.0f} bytes each")
+    print(f"{packets} DMX packets, {packets / dt:.0f}/s")
+
+
+if __name__ == "__main__":
+    main()
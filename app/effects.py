@@ -0,0 +1,423 @@
+"""effects.py - the firmware's effects rendered on the PC (NumPy)
+-------------------------------------------------------------------------------
+rainbow, plasma, minefield and the vertex palette / gradient of led/led_anim.c,
+one array expression per frame instead of a loop per LED, from the geometry
+dump (#dumpgeo#: vertices, edges and the "L:" LED lines). Same integer steps
+as the firmware: the 8-band rainbow and palette tables (lut.h, led_palette.c),
+the quarter-wave lut_sinf(), the Q14 plasma basis, the per-edge index DDA of
+led_texture.c and the named xorshift streams of led_rng.c, so with the same
+seed an effect draws the same frames. Not bit-identical where the dump is
+coarser than the device (vertices printed to 6 places) or the device saves
+time (led_governor interlacing, the minefield's shell estimate under load);
+palette blends are not replayed, an effect runs on its palette at rest.
+
+Frames are (LEDs, 3) uint8 in framebuffer order, what stream.py sends:
+
+    layout = effects.Layout.from_dump(lines)
+    fx     = effects.create("plasma", layout)
+    rgb    = fx.frame(dt_us).tobytes()
+
+    python stream.py --port COM5 --effect plasma
+"""
+import math, re
+
+import numpy as np
+
+REF_HZ = 60                                     # anim_clock.h ANIM_REF_HZ
+SEED   = 0xA5A5A5A5                             # led_rng.h RNG_SEED
+
+
+# ── geometry ──────────────────────────────────────────────────────────────
+class Layout:
+    """LED positions (framebuffer order) and edges, as led_mapping.c holds them."""
+
+    def __init__(self, V, E, L):
+        self.V = np.asarray(V, dtype=np.float32)
+        self.E = [tuple(ab) for ab in E]
+        self.L = list(L)                                    # (start, count, step) per edge
+        self.total = sum(c for _, c, _ in self.L)
+        self.base = np.cumsum([0] + [c for _, c, _ in self.L])[:-1]   # mapping_get_edge_base()
+        self.pos = np.zeros((self.total, 3), dtype=np.float32)
+        for (a, b), (start, count, step) in zip(self.E, self.L):
+            i = np.arange(count)
+            t = i.astype(np.float32) / np.float32(count - 1) if count > 1 else np.zeros(count, np.float32)
+            A, B = self.V[a], self.V[b]
+            self.pos[start + i * step] = A + (B - A) * t[:, None]
+
+    @classmethod
+    def from_dump(cls, lines):
+        """#dumpgeo# lines (LOG text already formatted)."""
+        V, E, L = [], [], {}
+        for line in lines:
+            if line.startswith("V:"):
+                V += [(float(x), float(y), float(z)) for x, y, z in
+                      re.findall(r"\d+,\(([-\d.]+),([-\d.]+),([-\d.]+),\d+\)", line)]
+            elif line.startswith("E:"):
+                E += [(int(a), int(b)) for a, b in re.findall(r"\((\d+)-(\d+)\)", line)]
+            elif line.startswith("L:"):
+                for e, s, c, st in re.findall(r"(\d+),\((\d+),(\d+),(-?\d+)\)", line):
+                    L[int(e)] = (int(s), int(c), int(st))
+        if not V or not E or sorted(L) != list(range(len(E))):
+            raise ValueError("geometry dump without vertices, edges or LED lines")
+        return cls(V, E, [L[e] for e in range(len(E))])
+
+
+# ── tables (lut.h, led_palette.c) ─────────────────────────────────────────
+def scale8_video(i, s):
+    i, s = np.asarray(i, dtype=np.uint16), np.asarray(s, dtype=np.uint16)
+    return ((i * s >> 8) + ((i != 0) & (s != 0))).astype(np.uint8)
+
+
+def _rainbow_raw(hue):
+    off8 = (hue & 0x1F) << 3
+    third, twothird = off8 * 85 >> 8, off8 * 170 >> 8
+    return [(255 - third, third, 0), (171, 85 + third, 0),
+            (171 - twothird, 170 + third, 0), (0, 255 - third, third),
+            (0, 171 - twothird, 85 + twothird), (third, 0, 255 - third),
+            (85 + third, 0, 171 - third), (170 + third, 0, 85 - third)][hue >> 5]
+
+
+RAINBOW = np.array([_rainbow_raw(h) for h in range(256)], dtype=np.uint8)   # lut_rainbow
+
+_SIN_Q15 = np.floor(np.sin(np.arange(257) * (math.pi / 2) / 256) * 32767.0 + 0.5).astype(np.int32)
+
+
+def _sin_step(k):
+    j, quad = k & 255, (k >> 8) & 3
+    v = np.where(quad & 1, _SIN_Q15[256 - j], _SIN_Q15[j])
+    return np.where(quad & 2, -v, v)
+
+
+def lut_sinf(x):
+    """lut.c lut_sinf(), float32 like the device."""
+    t = np.asarray(x, dtype=np.float32) * np.float32(256 / np.float32(1.57079633))
+    i = np.floor(t).astype(np.int64)
+    fr = t - i.astype(np.float32)
+    a, b = _sin_step(i), _sin_step(i + 1)
+    return (a.astype(np.float32) + (b - a).astype(np.float32) * fr) * np.float32(1 / 32767)
+
+
+def lut_cosf(x):
+    return lut_sinf(np.asarray(x, dtype=np.float32) + np.float32(1.57079633))
+
+
+def hsv_rainbow(sat=255, val=255):
+    """hsv_to_rgb_rainbow() of every hue, (256, 3) (led_anim.c rainbow_table)."""
+    c = RAINBOW.copy()
+    if sat != 255:
+        if sat == 0:
+            c[:] = 255
+        else:
+            desat = int(scale8_video(255 - sat, 255 - sat))
+            c = scale8_video(c, 255 - desat) + np.uint8(desat)
+    if val != 255:
+        c = np.zeros_like(c) if val == 0 else scale8_video(c, val)
+    return c
+
+
+# name: [(pos, r, g, b)], led_palette.c
+PALETTES = {
+    "rainbow":   [(0, 255, 0, 0), (32, 171, 85, 0), (64, 171, 170, 0), (96, 0, 255, 0),
+                  (128, 0, 171, 85), (160, 0, 0, 255), (192, 85, 0, 171), (224, 170, 0, 85),
+                  (255, 255, 0, 0)],
+    "minefield": [(0, 212, 0, 43), (32, 0, 129, 127), (64, 171, 122, 0), (96, 171, 124, 0),
+                  (128, 171, 127, 0), (159, 220, 0, 35), (191, 204, 0, 51), (223, 13, 0, 242),
+                  (255, 0, 0, 255)],
+    "neon":      [(0, 191, 0, 64), (128, 21, 0, 234), (255, 171, 122, 0)],
+    "hotpink":   [(0, 212, 0, 43), (85, 42, 0, 213), (170, 0, 129, 127), (255, 245, 10, 0)],
+    "magenta":   [(0, 233, 0, 22), (85, 26, 0, 229), (170, 171, 122, 0), (255, 234, 21, 0)],
+    "purple":    [(0, 127, 0, 129), (128, 0, 129, 127), (255, 171, 127, 0)],
+    "pinkblue":  [(0, 212, 0, 43), (128, 21, 0, 234), (255, 234, 21, 0)],
+    "lava":      [(0, 0, 0, 0), (96, 128, 0, 0), (160, 255, 32, 0), (224, 255, 160, 0),
+                  (255, 255, 255, 128)],
+    "ocean":     [(0, 0, 0, 64), (96, 0, 64, 192), (192, 0, 192, 192), (255, 170, 255, 255)],
+    "aurora":    [(0, 0, 16, 8), (96, 0, 192, 48), (176, 0, 160, 140), (255, 150, 0, 200)],
+}
+
+
+def palette(name):
+    """palette_expand(): (256, 3) uint8."""
+    st = PALETTES[name]
+    out, k = np.zeros((256, 3), dtype=np.uint8), 0
+    for i in range(256):
+        if len(st) < 2:
+            out[i] = st[0][1:]
+            continue
+        while k + 2 < len(st) and i > st[k + 1][0]:
+            k += 1
+        a, b = st[k], st[k + 1]
+        if i <= a[0]:
+            out[i] = a[1:]
+        elif i >= b[0]:
+            out[i] = b[1:]
+        else:
+            f = ((i - a[0]) << 8) // (b[0] - a[0])
+            out[i] = [(ca + ((cb - ca) * f >> 8)) & 0xFF for ca, cb in zip(a[1:], b[1:])]
+    return out
+
+
+def shade(lut, idx, sat=255, val=255):
+    """palette_shade() per LED: idx, sat, val scalars or arrays."""
+    c = lut[idx]
+    sat, val = np.broadcast_to(sat, c.shape[:-1]), np.broadcast_to(val, c.shape[:-1])
+    desat = scale8_video(255 - sat, 255 - sat)[..., None]
+    c = np.where((sat != 255)[..., None], scale8_video(c, 255 - desat) + desat, c)
+    return np.where((val != 255)[..., None], scale8_video(c, val[..., None]), c).astype(np.uint8)
+
+
+# ── device plumbing: random streams, clock, texture fill ──────────────────
+def _mix32(x):
+    x ^= x >> 16
+    x = x * 0x7FEB352D & 0xFFFFFFFF
+    x ^= x >> 15
+    x = x * 0x846CA68B & 0xFFFFFFFF
+    return x ^ x >> 16
+
+
+class Rng:
+    """led_rng.h stream: xorshift32 seeded from the global seed and a name."""
+
+    def __init__(self, name=None, seed=SEED):
+        s = seed
+        if name:
+            h = 2166136261
+            for ch in name.encode():
+                h = (h ^ ch) * 16777619 & 0xFFFFFFFF
+            s = _mix32(s ^ h)
+        self.s = s or 1
+
+    def u32(self):
+        x = self.s
+        x ^= x << 13 & 0xFFFFFFFF
+        x ^= x >> 17
+        x ^= x << 5 & 0xFFFFFFFF
+        self.s = x
+        return x
+
+    def below(self, n):
+        return self.u32() * n >> 32
+
+    def float(self):
+        return np.float32(self.u32() >> 8) * np.float32(1 / 16777216)
+
+
+class Rate:
+    """AnimRate: whole events owed at per_s for this frame's dt."""
+
+    def __init__(self):
+        self.acc = 0
+
+    def take(self, per_s, dt_us):
+        self.acc += per_s * dt_us
+        n, self.acc = divmod(self.acc, 1000000)
+        return n
+
+
+def tex_index(layout, qa, qb, lut, out):
+    """tex_run_index() with two stops per edge, at A and B (Q8 indices):
+    the Q16 DDA of led_texture.c, wrapped into lut, written to out."""
+    for e, (start, count, step) in enumerate(layout.L):
+        if not count:
+            continue
+        va, vb = int(qa[e]) << 8, int(qb[e]) << 8
+        k = np.arange(count, dtype=np.int64)
+        if count > 1:
+            du = 65536 // (count - 1)
+            d = vb - va
+            inc = int(d * du / 65536)                       # C division: toward zero
+            acc = va + k * inc
+            acc[-1] = vb                                    # du rounds down, ends on B
+        else:
+            acc = np.full(1, va, dtype=np.int64)
+        out[start + k * step] = lut[(acc >> 16) & 0xFF]
+
+
+def view_apply(R, v):
+    return v @ np.asarray(R, dtype=np.float32).T
+
+
+# ── effects ───────────────────────────────────────────────────────────────
+class Effect:
+    """One animation; frame(dt_us) draws the next frame into self.fb."""
+
+    palette = None
+
+    def __init__(self, layout, seed=SEED, R=None):
+        self.layout, self.seed = layout, seed
+        self.R = np.eye(3, dtype=np.float32) if R is None else np.asarray(R, dtype=np.float32)
+        self.fb = np.zeros((layout.total, 3), dtype=np.uint8)
+        self.now_us = 0
+        self.lut = palette(self.palette) if self.palette else None
+
+    def frame(self, dt_us=1000000 // REF_HZ):
+        self.now_us += int(dt_us)
+        self.draw(int(dt_us))
+        return self.fb
+
+    def draw(self, dt_us):
+        raise NotImplementedError
+
+
+class VertexPalette(Effect):
+    """"palette": hue from the view-rotated vertex azimuth, shorter way round."""
+
+    def __init__(self, layout, hue_offset=0, sat=255, val=255, **kw):
+        super().__init__(layout, **kw)
+        self.hue_offset, self.table = hue_offset, hsv_rainbow(sat, val)
+
+    def draw(self, dt_us):
+        w = view_apply(self.R, self.layout.V)
+        az = np.arctan2(w[:, 1], w[:, 0]).astype(np.float32)
+        norm = (az + np.float32(math.pi)) / np.float32(2 * math.pi)
+        hue = ((norm * np.float32(255) + np.float32(0.5)).astype(np.int32) + self.hue_offset) & 0xFF
+        a, b = np.array([e[0] for e in self.layout.E]), np.array([e[1] for e in self.layout.E])
+        dh = hue[b] - hue[a]
+        dh = np.where(dh > 128, dh - 256, np.where(dh < -128, dh + 256, dh))
+        tex_index(self.layout, hue[a] << 8, (hue[a] + dh) << 8, self.table, self.fb)
+
+
+class VertexGradient(Effect):
+    """"gradient": hue from the projection onto a vertex direction."""
+
+    def __init__(self, layout, vertex=0, hue_offset=0, sat=255, val=255, **kw):
+        super().__init__(layout, **kw)
+        self.vertex, self.hue_offset, self.table = vertex, hue_offset, hsv_rainbow(sat, val)
+
+    def draw(self, dt_us):
+        d = self.layout.V[self.vertex]
+        mag = np.sqrt(np.float32((d * d).sum()))
+        if mag == 0:
+            return
+        dp = np.clip((self.layout.V @ d) / mag, -1, 1).astype(np.float32)
+        scaled = (dp + 1) * np.float32(0.5) * np.float32(1 + self.hue_offset / 40) * np.float32(255)
+        q8 = ((scaled + np.float32(0.5)) * 256).astype(np.int64)
+        a, b = zip(*self.layout.E)
+        tex_index(self.layout, q8[list(a)], q8[list(b)], self.table, self.fb)
+
+
+class Rainbow(Effect):
+    """"rainbow": hue = logical index * 256 / total + offset, one step per 1/60 s."""
+
+    palette = "rainbow"
+
+    def __init__(self, layout, **kw):
+        super().__init__(layout, **kw)
+        self.offset, self.rate = 0, Rate()
+
+    def draw(self, dt_us):
+        L, tot = self.layout, self.layout.total
+        cnt = np.array([c for _, c, _ in L.L])
+        off = self.offset << 8
+        tex_index(L, L.base * 65536 // tot + off, (L.base + cnt - 1) * 65536 // tot + off,
+                  shade(self.lut, np.arange(256), 255, 120), self.fb)
+        self.offset = (self.offset + self.rate.take(REF_HZ, dt_us)) & 0xFF
+
+
+class Plasma(Effect):
+    """"plasma": Σ sin(k_i · Rv + phase_i) through the Q14 basis, hue on the palette."""
+
+    palette = "rainbow"
+
+    def __init__(self, layout, k=(4.3, 2.7, 3.7), speed=0.015, **kw):
+        super().__init__(layout, **kw)
+        self.k, self.speed, self.phase = k, np.float32(speed), np.float32(0)
+        self.s = self.c = None
+
+    def basis(self):
+        a = np.float32(self.k) * (self.layout.pos @ self.R.T).astype(np.float32)
+        self.s = (lut_sinf(a) * np.float32(16384)).astype(np.int32)    # (LEDs, 3), Q14
+        self.c = (lut_cosf(a) * np.float32(16384)).astype(np.int32)
+
+    def draw(self, dt_us):
+        if self.s is None:
+            self.basis()
+        ph = np.array([self.phase, self.phase * np.float32(0.8), self.phase * np.float32(1.3)],
+                      dtype=np.float32)
+        sp = (lut_sinf(ph) * np.float32(16384)).astype(np.int32)
+        cp = (lut_cosf(ph) * np.float32(16384)).astype(np.int32)
+        n = (self.s * cp + self.c * sp).sum(axis=1)
+        n14 = np.maximum((n >> 14) + 3 * 16384, 0)
+        self.fb[:] = shade(self.lut, (n14 * 85 >> 15) & 0xFF, 255, 180)
+        self.phase += self.speed * np.float32(dt_us * (REF_HZ * 1e-6))
+
+
+class Minefield(Effect):
+    """"minefield": expanding shells from random LEDs over a fading frame."""
+
+    palette = "minefield"
+    MAX = 20                                    # MAX_CONCURRENT_EXPLOSIONS
+    RADIUS = 2.0                                # POLY_RADIUS
+
+    def __init__(self, layout, expl_per_sec=0.35, shell_speed=0.25, shell_speed_rng=0.1,
+                 shell_thickness=0.3, shell_thickness_rng=0.15, fade_amount=11,
+                 falloff_exp=2.1, radial_falloff_exp=2.2, **kw):
+        super().__init__(layout, **kw)
+        self.expl_per_sec, self.fade_amount = expl_per_sec, fade_amount
+        self.speed, self.thick = (shell_speed, shell_speed_rng), (shell_thickness, shell_thickness_rng)
+        self.rng, self.fade_rate, self.last_burst = Rng("minefield", self.seed), Rate(), 0
+        self.slots = [None] * self.MAX          # [center, radius, speed, thickness, colour]
+        curve = lambda ex: np.floor(255 * np.power(np.arange(256, dtype=np.float32) / 255,
+                                                   np.float32(ex)) + 0.5).astype(np.int32)
+        self.shell_curve, self.radial_curve = curve(falloff_exp), curve(radial_falloff_exp)
+
+    def fade(self, power):
+        lut = np.arange(256, dtype=np.int32)
+        for _ in range(power):
+            lut = lut * (255 - self.fade_amount) >> 8
+        self.fb[:] = lut.astype(np.uint8)[self.fb]
+
+    def rand_range(self, base, rng):
+        return np.float32(base) + np.float32(rng) * (self.rng.float() * np.float32(2) - np.float32(1))
+
+    def spawn(self):
+        if all(s is not None for s in self.slots):
+            return
+        i = self.slots.index(None)
+        idx = self.rng.below(self.layout.total)
+        speed = self.rand_range(*self.speed)
+        thick = max(np.float32(0), self.rand_range(*self.thick))
+        st = PALETTES[self.palette]
+        colour = st[self.rng.below(len(st))][0]
+        self.slots[i] = [self.layout.pos[idx].copy(), np.float32(0), speed, thick, colour]
+
+    def draw(self, dt_us):
+        fades = self.fade_rate.take(2 * REF_HZ, dt_us)
+        if fades:
+            self.fade(min(fades, 8))
+        now = self.now_us // 1000
+        if now - self.last_burst >= int(1000 / self.expl_per_sec):
+            self.last_burst = now
+            self.spawn()
+
+        best = np.zeros(self.layout.total, dtype=np.int32)
+        for i, s in enumerate(self.slots):
+            if s is None:
+                continue
+            s[1] += s[2] * np.float32(dt_us * 1e-6)
+            if s[1] > self.RADIUS + s[3]:
+                self.slots[i] = None
+                continue
+            c, r, _, th, colour = s
+            if th <= 0:
+                continue
+            radial = 1 - min(r / (np.float32(self.RADIUS) + th), 1)
+            rad = self.radial_curve[int(radial * 255 + 0.5)] + 1
+            delta = np.abs(np.sqrt(((self.layout.pos - c) ** 2).sum(axis=1)) - r)
+            hit = delta <= th
+            x = 1 - delta[hit] * (np.float32(1) / th)
+            w = self.shell_curve[(x * 255 + 0.5).astype(np.int32)] * rad >> 8
+            best[hit] = np.maximum(best[hit], w << 8 | colour)
+
+        inten = best >> 8
+        lit = inten > 0
+        add = np.zeros_like(self.fb)
+        add[lit] = shade(self.lut, best[lit] & 0xFF, 255 - inten[lit] // 2, inten[lit])
+        self.fb[:] = np.minimum(self.fb.astype(np.uint16) + add, 255)
+
+
+EFFECTS = {"palette": VertexPalette, "gradient": VertexGradient,
+           "rainbow": Rainbow, "plasma": Plasma, "minefield": Minefield}
+
+
+def create(name, layout, **kw):
+    return EFFECTS[name](layout, **kw)
@@ -0,0 +1,147 @@
+"""geometry.py - the firmware's binary model dump (polyhedron/geo_debug.h)
+-------------------------------------------------------------------------------
+"#dumpgeob#" on the console sends the model as GEOMETRY packets, one per
+scheduler step:
+
+    section u8 | dump id u8 | first u16 | records
+
+a HEAD (V, E, F, mapped edges), then vertices (x y z float32, hue u8),
+edges (a b u16), LED runs per edge (start count u16, step i8), faces
+(n u8, n u16) and END (crc u32, bytes u32) over all records before it.
+Collector puts a dump back together; the Geometry it hands out is what the
+viewer and the LED preview take instead of the #geo# text lines.
+
+The firmware says "#geohash# <crc> V= E= F=#" when the port opens: the crc
+its END packet would carry. save() keeps every dump under that name in
+config.GEO_CACHE_DIR, load() finds it again, so a known model needs no dump.
+"""
+import json, re, struct
+from pathlib import Path
+
+import proto
+
+HEAD, VERTS, EDGES, LEDS, FACES, END = range(6)
+
+# layouts: tools/protocol.def (proto.py)
+_PKT  = proto.GeoPkt.S
+_HEAD = proto.GeoCounts.S
+_VERT = proto.GeoVert.S
+_EDGE = proto.GeoEdge.S
+_LED  = proto.GeoLed.S
+_END  = proto.GeoEnd.S
+
+
+def crc32_mpeg2(data: bytes, crc: int = 0xFFFFFFFF) -> int:
+    """CRC-32/MPEG-2 byte by byte, as geo_debug.c keeps it over the records."""
+    for b in data:
+        crc ^= b << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else crc << 1
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+class Geometry:
+    """A whole dump: V [(x, y, z)], H [hue 0..1], E [(a, b)], F [[v, ...]],
+    L [(start, count, step)] per edge (None without the LED mapping), crc
+    of the dump."""
+
+    def __init__(self, V, H, E, F, L, crc):
+        self.V, self.H, self.E, self.F, self.L, self.crc = V, H, E, F, L, crc
+
+
+def text_lines(g, verts=4, edges=10):
+    """The V:/E:/L: lines #dumpgeo# prints for the same model, so
+    show.geometry_hash() comes out the same for either dump."""
+    out = []
+    for k in range(0, len(g.V), verts):
+        out.append("V:" + "".join(f"{i},({x:.6f},{y:.6f},{z:.6f},{round(g.H[i] * 255)}); "
+                                  for i, (x, y, z) in enumerate(g.V[k:k + verts], k)))
+    for k in range(0, len(g.E), edges):
+        out.append("E:" + "".join(f"({a}-{b}), " for a, b in g.E[k:k + edges]))
+    if g.L and g.L[0] is not None:
+        for k in range(0, len(g.L), edges):
+            out.append("L:" + "".join(f"{i},({s},{c},{st}); "
+                                      for i, (s, c, st) in enumerate(g.L[k:k + edges], k)))
+    return out
+
+
+HASH_RE = re.compile(r"#geohash#\s+([0-9a-f]{8})\b")
+
+
+def parse_hash(line):
+    """A #geohash# line → its crc, None if it is not one."""
+    m = HASH_RE.match(line)
+    return int(m.group(1), 16) if m else None
+
+
+def _path(crc, cache_dir):
+    return Path(cache_dir) / f"geo_{crc:08x}.json"
+
+
+def save(g, cache_dir):
+    path = _path(g.crc, cache_dir)
+    path.parent.mkdir(exist_ok=True)
+    path.write_text(json.dumps({"V": g.V, "H": g.H, "E": g.E, "F": g.F, "L": g.L}))
+    return path
+
+
+def load(crc, cache_dir):
+    """The Geometry kept for crc, None if there is none (or it does not read)."""
+    try:
+        d = json.loads(_path(crc, cache_dir).read_text())
+    except (OSError, ValueError):
+        return None
+    tup = lambda xs: [tuple(x) if x is not None else None for x in xs]
+    return Geometry(tup(d["V"]), d["H"], tup(d["E"]), d["F"], tup(d["L"]), crc)
+
+
+class Collector:
+    """GEOMETRY packets → a Geometry once END checks out; a dump with a
+    packet lost or out of order is dropped."""
+
+    def __init__(self):
+        self.id = None
+
+    def add(self, payload: bytes):
+        if len(payload) < _PKT.size:
+            return None
+        section, did, first = _PKT.unpack_from(payload)
+        body = payload[_PKT.size:]
+        if section == HEAD:
+            nv, ne, nf, nl = _HEAD.unpack_from(body)
+            self.id, self.n = did, {VERTS: nv, EDGES: ne, LEDS: nl, FACES: nf}
+            self.V, self.H, self.E, self.F, self.L = [], [], [], [], []
+            self.crc, self.bytes = 0xFFFFFFFF, 0
+            return None
+        if did != self.id:
+            return None                         # joined half way, or an old dump
+        if section == END:
+            crc, n = _END.unpack_from(body)
+            self.id = None
+            if crc != self.crc or n != self.bytes or len(self.V) != self.n[VERTS] or \
+                    len(self.E) != self.n[EDGES] or len(self.F) != self.n[FACES]:
+                raise ValueError(f"geometry dump broken (crc {crc:08x}, got {self.crc:08x})")
+            L = self.L if len(self.L) == self.n[EDGES] else [None] * len(self.E)
+            return Geometry(self.V, [h / 255.0 for h in self.H], self.E, self.F, L, crc)
+        got = {VERTS: self.V, EDGES: self.E, LEDS: self.L, FACES: self.F}.get(section)
+        if got is None or first != len(got):
+            self.id = None                      # a packet missing
+            return None
+        self.crc = crc32_mpeg2(body, self.crc)
+        self.bytes += len(body)
+        if section == VERTS:
+            for x, y, z, h in _VERT.iter_unpack(body):
+                self.V.append((x, y, z))
+                self.H.append(h)
+        elif section == EDGES:
+            self.E += list(_EDGE.iter_unpack(body))
+        elif section == LEDS:
+            self.L += list(_LED.iter_unpack(body))
+        else:
+            k = 0
+            while k < len(body):
+                n = body[k]
+                self.F.append(list(struct.unpack_from(f"<{n}H", body, k + 1)))
+                k += 1 + 2 * n
+        return None
@@ -0,0 +1,117 @@
+"""itm_decode.py - the firmware's SWO output (led/itm.h) from a probe capture
+-------------------------------------------------------------------------------
+With LED_ITM the MCU writes to three ITM stimulus ports and the debug probe
+records the SWO pin, e.g. OpenOCD's `stm32f4x.tpiu configure -protocol uart
+-output swo.bin ...` (the formatter off, ITM packets as they came):
+
+    port 0  printf text (ITM_LOG)
+    port 1  profiler zones, one word per zone end: zone << 24 | cycles
+    port 2  trace events, two words each: DWT cycles, then
+            event | flags << 8 | arg << 16
+
+The text is printed as it came, the zones are summed up like the telemetry
+packet has them (µs), the trace events go to a Chrome trace JSON like the
+"trace" dump (trace_export.py):
+
+    python itm_decode.py swo.bin
+    python itm_decode.py swo.bin --trace logs/swo_trace.json --hz 84000000
+"""
+import argparse, json, sys
+from pathlib import Path
+
+import telemetry
+import trace_export
+
+PORT_LOG, PORT_PROF, PORT_TRACE = 0, 1, 2
+_SIZE = {1: 1, 2: 2, 3: 4}
+
+
+def packets(data: bytes, stats: dict):
+    """ITM software source packets → (port, value, size), overflows counted
+    in stats. Sync, timestamp, extension and hardware (DWT) packets are
+    skipped."""
+    i, n = 0, len(data)
+    while i < n:
+        h = data[i]
+        i += 1
+        if h == 0x00:                           # sync: zeros, then 0x80
+            while i < n and data[i] == 0x00:
+                i += 1
+            if i < n and data[i] == 0x80:
+                i += 1
+        elif h == 0x70:
+            stats["overflow"] = stats.get("overflow", 0) + 1
+        elif h & 0x03:
+            size = _SIZE[h & 0x03]
+            if i + size > n:
+                return
+            value = int.from_bytes(data[i:i + size], "little")
+            i += size
+            if not h & 0x04:                    # software source: a stimulus port
+                yield h >> 3, value, size
+        elif h & 0x80:                          # timestamp / extension, continued
+            while i < n and data[i] & 0x80:
+                i += 1
+            i += 1
+
+
+def decode(data: bytes):
+    """Capture → (text, {zone: [cycles, ...]}, [(cyc, event, flags, arg)], overflows)."""
+    text, zones, records = bytearray(), {}, []
+    pending = None                              # the cycles word of a trace event
+    stats = {}
+    for port, value, size in packets(data, stats):
+        if port == PORT_LOG:
+            text += value.to_bytes(size, "little")
+        elif port == PORT_PROF and size == 4:
+            z = value >> 24
+            name = telemetry.ZONES[z] if z < len(telemetry.ZONES) else f"zone{z}"
+            zones.setdefault(name, []).append(value & 0xFFFFFF)
+        elif port == PORT_TRACE and size == 4:
+            if pending is None:
+                pending = value
+            else:
+                records.append((pending, value & 0xFF, (value >> 8) & 0xFF, value >> 16))
+                pending = None
+    return text.decode("utf-8", "replace"), zones, records, stats.get("overflow", 0)
+
+
+def zone_table(zones, hz):
+    """Per zone calls, min / avg / p99 / max in µs."""
+    lines = [f"{'zone':<10} {'calls':>7} {'min':>8} {'avg':>8} {'p99':>8} {'max':>8}  us"]
+    for name, cyc in zones.items():
+        s = sorted(cyc)
+        us = lambda c: c * 1e6 / hz
+        p99 = s[min(len(s) - 1, len(s) * 99 // 100)]
+        lines.append(f"{name:<10} {len(s):>7} {us(s[0]):>8.1f} {us(sum(s) / len(s)):>8.1f}"
+                     f" {us(p99):>8.1f} {us(s[-1]):>8.1f}")
+    return "\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("capture", help="raw SWO capture (ITM packets)")
+    ap.add_argument("--hz", type=int, default=84_000_000, help="CPU clock (DWT cycles)")
+    ap.add_argument("--trace", help="write the trace events as Chrome trace JSON")
+    args = ap.parse_args()
+
+    text, zones, records, overflow = decode(Path(args.capture).read_bytes())
+    if text:
+        sys.stdout.write(text)
+        if not text.endswith("\n"):
+            print()
+    if zones:
+        print(zone_table(zones, args.hz))
+    if records and args.trace:
+        out = Path(args.trace)
+        out.parent.mkdir(parents=True, exist_ok=True)
+        out.write_text(json.dumps(trace_export.convert_records(records, args.hz)), encoding="utf-8")
+        print(f"{len(records)} trace events -> {out}")
+    elif records:
+        print(f"{len(records)} trace events (--trace to save them)")
+    if overflow:
+        print(f"{overflow} ITM overflows: lower the load or raise ITM_SWO_HZ", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
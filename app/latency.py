@@ -0,0 +1,93 @@
+"""latency.py - input-to-light latency from PROBE packets (led/latency.h)
+-------------------------------------------------------------------------------
+A PROBE goes out right behind a command and comes back once the device's
+DMA finished the first frame that can show it, with its own times after the
+packet arrived: handler, frame tick, DMA done (shown) and reply. The host
+knows when the input was read, when the probe was written and when the
+answer came in, so
+
+    transit   = (back - sent - reply_us) / 2        each way, assumed equal
+    to light  = (sent - input) + transit + shown_us
+
+The input was read by ControllerCore.step(); a press lies up to one step
+interval before that (app_window.py, 5 ms), not counted. The answer is
+stamped by serial_manager's reader thread as it comes in.
+"""
+import collections, itertools, time
+
+import packet
+import proto
+
+_REPLY = proto.ProbeReply.S                      # tools/protocol.def
+NONE = 0xFFFFFFFF                               # no frame went out in time
+KEEP = 500                                      # samples in the histogram
+BIN_MS = 2
+
+
+def now_us() -> int:
+    return time.perf_counter_ns() // 1000
+
+
+class Tracker:
+    """Outstanding probes and the latencies of the answered ones (ms)."""
+
+    def __init__(self):
+        self.ids = itertools.count(1)
+        self.pending = {}                       # id → (input_us, sent_us)
+        self.samples = collections.deque(maxlen=KEEP)
+        self.parts = None                       # last answer, ms: input→sent, transit, handled, tick, shown
+        self.lost = 0
+
+    def payload(self, input_us) -> bytes:
+        """PROBE payload for an input read at input_us, write it right away."""
+        pid, sent = next(self.ids), now_us()
+        if len(self.pending) > 8:               # never answered (reconnect, old firmware)
+            self.lost += len(self.pending)
+            self.pending.clear()
+        self.pending[pid] = (input_us, sent)
+        return packet.probe(pid, input_us)
+
+    def reply(self, payload: bytes, back_us=None):
+        """A PROBE | REPLY payload (arrived at back_us) → latency in ms, None
+        if unknown / no frame."""
+        if len(payload) < _REPLY.size:
+            return None
+        pid, _host, handled, tick, shown, reply = _REPLY.unpack_from(payload)
+        got = self.pending.pop(pid, None)
+        if got is None:
+            return None
+        if shown == NONE:
+            self.lost += 1
+            return None
+        input_us, sent = got
+        if back_us is None:
+            back_us = now_us()
+        transit = max(0, (back_us - sent - reply) // 2)
+        total = (sent - input_us + transit + shown) / 1000
+        self.parts = ((sent - input_us) / 1000, transit / 1000,
+                      handled / 1000, tick / 1000, shown / 1000)
+        self.samples.append(total)
+        return total
+
+    def percentile(self, p):
+        s = sorted(self.samples)
+        return s[min(len(s) - 1, int(p / 100 * len(s)))] if s else 0.0
+
+    def summary(self) -> str:
+        if not self.samples:
+            return "in→light: –"
+        return (f"in→light p50 {self.percentile(50):.1f} ms  p99 {self.percentile(99):.1f} ms"
+                f"  (n {len(self.samples)}, lost {self.lost})")
+
+    def histogram(self, width=30) -> str:
+        """BIN_MS wide text bars, one line per bin that has samples."""
+        if not self.samples:
+            return ""
+        bins = collections.Counter(int(v // BIN_MS) for v in self.samples)
+        top = max(bins.values())
+        lines = [f"{b * BIN_MS:4d}-{(b + 1) * BIN_MS:<4d} ms {'█' * max(1, round(n / top * width))} {n}"
+                 for b, n in sorted(bins.items())]
+        if self.parts:
+            lines.append("last: input→sent %.1f, transit %.1f, handled %.1f, tick %.1f, shown %.1f ms"
+                         % self.parts)
+        return "\n".join(lines)
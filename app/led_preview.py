@@ -0,0 +1,148 @@
+"""led_preview.py - live 3D view of what the sculpture shows (OpenGL)
+-------------------------------------------------------------------------------
+The LED positions are uploaded once per geometry dump: every edge's LEDs
+(the "L:" lines of #dumpgeo#: framebuffer index at vertex A, count, step)
+spaced along it as the firmware places them (led_mapping.c). After that only
+the colour buffer changes: "mirror <fps>" on the console makes the device
+send each drawn frame as PIXELS packets (led/led_mirror.h), Frames puts
+them back together and Preview.set_frame() hands the colours to the GPU
+(pyqtgraph's GL scatter item keeps positions and colours in buffers, a
+frame is one array copy, no per-LED Python).
+
+Needs pyqtgraph and PyOpenGL; available() says whether they import, the
+app keeps the matplotlib viewer without them.
+"""
+import re
+
+import numpy as np
+
+import geometry
+import proto
+
+try:
+    import pyqtgraph.opengl as gl
+except ImportError:                             # optional
+    gl = None
+
+LED_SIZE = 0.045                                # point size, world units (unit sphere)
+INSET    = 0.04                                 # LEDs kept off the vertices, fraction of the edge
+WIRE     = (0.35, 0.35, 0.35, 0.6)
+FACE_HI  = (1.0, 1.0, 1.0, 0.9)
+GAIN     = 1.5                                  # the LEDs look brighter than an sRGB screen
+
+
+def available() -> bool:
+    return gl is not None
+
+
+def parse(lines):
+    """Geometry dump → V (n, 3), E [(a, b)], F [[v, ...]], L [(start, count, step)]."""
+    if isinstance(lines, geometry.Geometry):
+        return np.array(lines.V, dtype=np.float32), lines.E, lines.F, lines.L
+    V, E, F, L = [], [], [], {}
+    for line in lines:
+        if line.startswith("V:"):
+            for x, y, z in re.findall(r"\d+,\(([-\d.]+),([-\d.]+),([-\d.]+),\d+\)", line):
+                V.append((float(x), float(y), float(z)))
+        elif line.startswith("E:"):
+            E += [(int(a), int(b)) for a, b in re.findall(r"\((\d+)-(\d+)\)", line)]
+        elif line.startswith("L:"):
+            for e, s, c, st in re.findall(r"(\d+),\((\d+),(\d+),(-?\d+)\)", line):
+                L[int(e)] = (int(s), int(c), int(st))
+        elif line.startswith("f"):
+            idx = line.split(":", 1)[1]
+            F.append([int(i) for i in idx.strip().strip(",").split(",") if i])
+    return np.array(V, dtype=np.float32), E, F, [L.get(e) for e in range(len(E))]
+
+
+class Frames:
+    """PIXELS packets → whole frames (rgb bytes, framebuffer order)."""
+
+    _HEAD = proto.PixelsHead.S
+
+    def __init__(self):
+        self.buf, self.frame, self.got = bytearray(), None, 0
+
+    def add(self, payload: bytes, leds: int):
+        """A packet; (rgb, brightness) once its frame is complete, else None.
+        A frame with a packet missing is never handed out."""
+        if len(payload) < self._HEAD.size or not leds:
+            return None
+        frame, first, bright = self._HEAD.unpack_from(payload)
+        rgb = payload[self._HEAD.size:]
+        if frame != self.frame or len(self.buf) != 3 * leds:
+            self.buf, self.frame, self.got = bytearray(3 * leds), frame, 0
+        end = min(3 * leds, 3 * first + len(rgb))
+        if end <= 3 * first:
+            return None
+        self.buf[3 * first:end] = rgb[:end - 3 * first]
+        self.got += end - 3 * first
+        if self.got < 3 * leds:
+            return None
+        self.frame = None
+        return bytes(self.buf), bright
+
+
+if gl is not None:
+    class Preview(gl.GLViewWidget):
+        """The sculpture as points, one per LED, over a dim wireframe."""
+
+        def __init__(self, parent=None):
+            super().__init__(parent)
+            self.setBackgroundColor((26, 26, 26))
+            self.setCameraPosition(distance=4.0, elevation=20, azimuth=45)
+            self.F, self.E, self.current_face = [], [], 0
+            self.leds = 0
+            self.order = np.zeros(0, dtype=np.intp)     # point → framebuffer index
+            self.points = gl.GLScatterPlotItem(pxMode=False)
+            self.wires = gl.GLLinePlotItem(mode="lines", color=WIRE, width=1, antialias=True)
+            self.face = gl.GLLinePlotItem(mode="lines", color=FACE_HI, width=3, antialias=True)
+            for item in (self.wires, self.face, self.points):
+                self.addItem(item)
+            self.frames = Frames()
+            self.on_frame = None                        # callback(rgb) per frame shown (show.Recorder.add)
+
+        def set_geometry(self, lines) -> bool:
+            """Upload LED positions and wires from a dump; False without "L:" lines."""
+            V, E, F, L = parse(lines)
+            if not len(V) or not E or None in L:
+                return False
+            pos, order = [], []
+            for (a, b), (start, count, step) in zip(E, L):
+                A, B = V[a], V[b]
+                for i in range(count):
+                    t = i / (count - 1) if count > 1 else 0.5
+                    t = INSET + (1 - 2 * INSET) * t
+                    pos.append(A + (B - A) * t)
+                    order.append(start + i * step)
+            self.E, self.F, self.V = E, F, V
+            self.order = np.array(order, dtype=np.intp)
+            self.leds = int(self.order.max()) + 1
+            self.points.setData(pos=np.array(pos, dtype=np.float32), size=LED_SIZE,
+                                color=np.full((len(pos), 4), (0.1, 0.1, 0.1, 1.0), dtype=np.float32))
+            self.wires.setData(pos=np.array([V[i] for ab in E for i in ab], dtype=np.float32))
+            self.show_face(self.current_face, first=True)
+            return True
+
+        def pixels(self, payload: bytes):
+            """A PIXELS packet (serial_manager.on_pixels)."""
+            got = self.frames.add(payload, self.leds)
+            if got:
+                self.set_frame(*got)
+                if self.on_frame:
+                    self.on_frame(got[0])
+
+        def set_frame(self, rgb: bytes, brightness: int = 255):
+            """Colours in framebuffer order: one copy to the GPU."""
+            c = np.frombuffer(rgb, dtype=np.uint8).reshape(-1, 3)[self.order]
+            col = np.ones((len(c), 4), dtype=np.float32)
+            col[:, :3] = np.minimum(c * (GAIN * brightness / (255.0 * 255.0)), 1.0)
+            self.points.setData(color=col)
+
+        def show_face(self, idx, *, first=False):
+            if not (0 <= idx < len(self.F)) or (idx == self.current_face and not first):
+                return
+            self.current_face = idx
+            f = self.F[idx]
+            seg = [self.V[v] for i in range(len(f)) for v in (f[i], f[(i + 1) % len(f)])]
+            self.face.setData(pos=np.array(seg, dtype=np.float32))
@@ -0,0 +1,128 @@
+"""link.py - one sculpture's byte stream → text lines and packets
+-------------------------------------------------------------------------------
+Framer splits what the port (or the bulk pipe) delivers, Reader is the
+thread that reads it; serial_manager.py runs one for the app's port,
+devices.py one per sculpture, daemon.py through devices.py. Nothing here
+needs the GUI, pygame or the app's config.
+"""
+import re, threading, collections, time
+
+import packet
+import dlog
+
+
+class Framer:
+    """Incremental split of one byte stream into text lines and 0x00-framed
+    packets. Every byte is looked at once: text collects in a bytearray up
+    to the next CR / LF / 0x00, a packet up to its closing 0x00. A LOG
+    packet's text goes in where the packet was, so a line split by one
+    still comes out whole."""
+
+    DELIM = re.compile(rb"[\0\n\r]")
+    LINE  = re.compile(rb"[\n\r]")
+    PKT_MAX = 2048                          # longer: not a packet, dropped
+
+    def __init__(self, on_packet):
+        self.on_packet = on_packet          # frame → text it stands for (b"" mostly)
+        self.text = bytearray()
+        self.pkt = None                     # bytearray while inside a packet
+
+    def feed(self, data: bytes, lines: list):
+        """Append every line completed by data to lines (str, no empties)."""
+        mv, i, n = memoryview(data), 0, len(data)
+        while i < n:
+            if self.pkt is not None:
+                j = data.find(b"\0", i)
+                if j == -1:
+                    self.pkt += mv[i:]
+                    if len(self.pkt) > self.PKT_MAX:
+                        self.pkt = None
+                    break
+                self.pkt += mv[i:j]
+                i = j + 1
+                if not self.pkt:            # two delimiters in a row: this one opens it
+                    continue
+                frame, self.pkt = bytes(self.pkt), None
+                txt = self.on_packet(frame)
+                if txt:
+                    self._text(txt, lines)
+                continue
+            m = self.DELIM.search(data, i)
+            if m is None:
+                self.text += mv[i:]
+                break
+            k = m.start()
+            self.text += mv[i:k]
+            i = k + 1
+            if data[k] == 0:
+                self.pkt = bytearray()
+            else:
+                self._line(lines)
+
+    def _text(self, txt: bytes, lines: list):
+        pos = 0
+        for m in self.LINE.finditer(txt):
+            self.text += txt[pos:m.start()]
+            self._line(lines)
+            pos = m.end()
+        self.text += txt[pos:]
+
+    def _line(self, lines: list):
+        if self.text:
+            lines.append(self.text.decode(errors="replace"))
+            self.text.clear()
+
+
+class Reader(threading.Thread):
+    """Reads the serial port (and the bulk pipe) off the GUI thread. Lines
+    and decoded packets go to `events`, a deque (append / popleft are
+    atomic, no lock) that drain() empties on the GUI thread:
+
+        ("line", text)  ("packet", type, payload, arrival µs)  ("warn", text)
+    """
+
+    def __init__(self, port, pipe):
+        super().__init__(daemon=True, name="serial-reader")
+        self.port, self.pipe = port, pipe
+        self.events = collections.deque()
+        self.error = None
+        self.running = True
+        self.rx_bytes = 0               # port and pipe, for the dashboard's rate
+        self.framers = [Framer(self._packet)] + ([Framer(self._packet)] if pipe else [])
+
+    def _packet(self, frame: bytes) -> bytes:
+        """LOG packets → their text, here; the rest → events, stamped."""
+        got = packet.parse(frame)
+        if got is None:
+            self.events.append(("warn", "[pkt] bad packet " + frame.hex(" ")))
+        elif got[0] == packet.LOG:
+            return dlog.format_packet(got[1]).encode()
+        else:
+            self.events.append(("packet", got[0], got[1], time.perf_counter_ns() // 1000))
+        return b""
+
+    def run(self):
+        lines = []
+        try:
+            while self.running:
+                if self.pipe:                   # the pipe blocks, the console is polled
+                    data = self.port.read(self.port.in_waiting)
+                    got = self.pipe.read(timeout_ms=20)
+                    if got:
+                        self.rx_bytes += len(got)
+                        self.framers[1].feed(got, lines)
+                else:                           # blocks up to the port's timeout
+                    data = self.port.read(self.port.in_waiting or 1)
+                if data:
+                    self.rx_bytes += len(data)
+                    self.framers[0].feed(data, lines)
+                if lines:
+                    self.events.extend(("line", l) for l in lines)
+                    lines.clear()
+        except Exception as e:
+            self.error = e
+
+    def stop(self):
+        self.running = False
+        if self is not threading.current_thread():
+            self.join(1.0)
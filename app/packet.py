@@ -0,0 +1,125 @@
+"""packet.py - binary packets for the firmware (led/usb_packet.h)
+-------------------------------------------------------------------------------
+COBS framed, a 0x00 before and after every packet. Decoded:
+
+    type u8 | len u8 | payload | crc32 (little endian)
+
+crc is what the STM32 CRC unit computes (CRC-32/MPEG-2, fed 32 bit words
+read little endian) over type, len and payload, zero padded to whole words.
+Answers come back with type | REPLY, refusals as ERROR (type, status).
+"""
+import math, struct, time
+
+import proto
+# types and payload layouts are tools/protocol.def's (proto.py, generated)
+from proto import PING, PARAM, SCRIPT, GYRO, LOG, TELEMETRY, CONTROL, ORIENT, SYNC, PROBE, \
+    PIXELS, BENCH, PCSAMPLE, GEOMETRY, AUDIO, CLIP, ERROR, REPLY
+STATUS = ["ok", "unknown type", "bad length", "crc mismatch"]
+
+# CONTROL ops (led_debug.h DebugOp), value float32; | DELTA makes it a step
+FACE, SLOT, BAR, HUE, MODE, FLIP = 1, 2, 3, 4, 5, 6
+DELTA = 0x80
+
+
+def crc32_stm32(data: bytes) -> int:
+    data = data + bytes(-len(data) % 4)
+    crc = 0xFFFFFFFF
+    for (word,) in struct.iter_unpack("<I", data):
+        crc ^= word
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else crc << 1
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out, run = bytearray(), bytearray()
+    for b in data:
+        if b:
+            run.append(b)
+        if not b or len(run) == 254:
+            out += bytes([len(run) + 1]) + run
+            run = bytearray()
+    return bytes(out + bytes([len(run) + 1]) + run)
+
+
+def cobs_decode(data: bytes) -> bytes:
+    out, i = bytearray(), 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS")
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def build(ptype: int, payload: bytes = b"") -> bytes:
+    """One packet, ready to write (delimiters included)."""
+    if len(payload) > 255:
+        raise ValueError("payload > 255 bytes")
+    raw = bytes([ptype, len(payload)]) + payload
+    return b"\0" + cobs_encode(raw + struct.pack("<I", crc32_stm32(raw))) + b"\0"
+
+
+def parse(frame: bytes):
+    """Bytes between two 0x00 → (type, payload), None if it does not check out."""
+    try:
+        raw = cobs_decode(frame)
+    except ValueError:
+        return None
+    if len(raw) < 6 or len(raw) != 6 + raw[1]:
+        return None
+    body, (crc,) = raw[:-4], struct.unpack("<I", raw[-4:])
+    if crc32_stm32(body) != crc:
+        return None
+    return body[0], body[2:]
+
+
+def control(ops) -> bytes:
+    """CONTROL payload from (op, value) pairs, applied together on the device."""
+    return b"".join(proto.ControlOp(op, value).encode() for op, value in ops)
+
+
+def euler_quat(roll, pitch, yaw):
+    """Tait-Bryan (z yaw, y pitch, x roll, as poly_rotation_matrix) → w x y z."""
+    cr, sr = math.cos(roll / 2), math.sin(roll / 2)
+    cp, sp = math.cos(pitch / 2), math.sin(pitch / 2)
+    cy, sy = math.cos(yaw / 2), math.sin(yaw / 2)
+    return (cr * cp * cy + sr * sp * sy, sr * cp * cy - cr * sp * sy,
+            cr * sp * cy + sr * cp * sy, cr * cp * sy - sr * sp * cy)
+
+
+def orient(q, t_us=None) -> bytes:
+    """ORIENT payload: quaternion w x y z stamped with when it was read (µs,
+    any monotonic clock; the firmware maps it onto its own)."""
+    if t_us is None:
+        t_us = time.perf_counter_ns() // 1000
+    return proto.Orient(t_us & 0xFFFFFFFF, tuple(q)).encode()
+
+
+def sync(frame, phase_us, period_us, t_us=None) -> bytes:
+    """SYNC payload: frame `frame` of the host's grid ticked phase_us before
+    t_us (sync.py keeps the grid)."""
+    if t_us is None:
+        t_us = time.perf_counter_ns() // 1000
+    return proto.Sync(t_us & 0xFFFFFFFF, frame & 0xFFFFFFFF, phase_us, period_us).encode()
+
+
+def probe(pid, t_us=None) -> bytes:
+    """PROBE payload: id and the host µs it stands for (latency.py)."""
+    if t_us is None:
+        t_us = time.perf_counter_ns() // 1000
+    return proto.Probe(pid & 0xFFFFFFFF, t_us & 0xFFFFFFFF).encode()
+
+
+def audio(bands, level, flux_db, beats, phase, bpm) -> bytes:
+    """AUDIO payload: 8 band levels and the level 0 … 1, the bands' rise in
+    dB, beats counted so far, phase 0 … 1 through the beat, bpm (0: none)."""
+    u8 = lambda x: max(0, min(255, int(round(float(x) * 255))))
+    return proto.AudioFeat(tuple(u8(b) for b in bands), u8(level), max(0, min(255, int(round(flux_db)))),
+                           int(beats) & 0xFFFF, int(phase * 65536) & 0xFFFF,
+                           max(0, min(0xFFFF, int(round(bpm * 10))))).encode()
+
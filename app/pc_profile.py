@@ -0,0 +1,145 @@
+"""pc_profile.py - hot functions from the firmware's PC samples (led/pc_sample.h)
+-------------------------------------------------------------------------------
+"pcs <hz>" on the console makes the MCU sample the interrupted PC from a
+timer interrupt and send the samples as PCSAMPLE packets:
+
+    hz u16 | dropped u16 | pc u32 × n
+
+The app (serial_manager.py) appends the PCs to logs/pcs_<time>.bin as they
+come, 4 bytes each. Here they are looked up in the ELF's symbol table and
+counted per function; a function's hottest instructions, with file and line
+when arm-none-eabi-addr2line is on the PATH:
+
+    python pc_profile.py logs/pcs_20261015_120000.bin
+    python pc_profile.py logs/pcs_20261015_120000.bin --top 40 --elf build.elf
+    python pc_profile.py logs/pcs_20261015_120000.bin --func hsv_to_rgb_rainbow
+"""
+import argparse, bisect, collections, logging, shutil, struct, subprocess, time
+from pathlib import Path
+
+import config
+import proto
+
+_HEAD = proto.PcSampleHead.S
+ADDR2LINE = "arm-none-eabi-addr2line"
+
+
+class Recorder:
+    """PCSAMPLE payloads → one file of PCs per app run, opened on the first."""
+
+    def __init__(self, out_dir="logs"):
+        self.out_dir = Path(out_dir)
+        self.path = None
+        self.samples = 0
+        self.dropped = 0
+        self._f = None
+
+    def add(self, payload: bytes):
+        if len(payload) < _HEAD.size or (len(payload) - _HEAD.size) % 4:
+            return
+        _hz, dropped = _HEAD.unpack_from(payload)
+        if self._f is None:
+            self.out_dir.mkdir(exist_ok=True)
+            self.path = self.out_dir / time.strftime("pcs_%Y%m%d_%H%M%S.bin")
+            self._f = open(self.path, "ab")
+            logging.info("[pcs] samples go to %s (pc_profile.py)", self.path)
+        self._f.write(payload[_HEAD.size:])
+        self._f.flush()
+        self.samples += (len(payload) - _HEAD.size) // 4
+        if dropped:
+            self.dropped += dropped
+            logging.warning("[pcs] %d samples dropped on the device, lower the rate", dropped)
+
+
+def functions(elf_path):
+    """FUNC symbols of a 32 bit little endian ELF → sorted [(start, end, name)]."""
+    elf = Path(elf_path).read_bytes()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise ValueError("not an ELF32 little endian file")
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", elf, 0x2E)
+
+    def header(i):
+        # name, type, flags, addr, offset, size, link
+        return struct.unpack_from("<IIIIIII", elf, shoff + i * shentsize)
+
+    funcs = []
+    for i in range(shnum):
+        _n, sh_type, _fl, _a, off, size, link = header(i)
+        if sh_type != 2:                                    # SHT_SYMTAB
+            continue
+        str_off = header(link)[4]
+        for k in range(0, size, 16):
+            name, value, sym_size, info = struct.unpack_from("<IIIB", elf, off + k)
+            if info & 0xF != 2 or not sym_size:             # STT_FUNC
+                continue
+            end = elf.index(b"\0", str_off + name)
+            start = value & ~1                              # the Thumb bit
+            funcs.append((start, start + sym_size, elf[str_off + name:end].decode()))
+    if not funcs:
+        raise ValueError("no symbol table (stripped?)")
+    funcs.sort()
+    return funcs
+
+
+def load(path):
+    data = Path(path).read_bytes()
+    return [pc for (pc,) in struct.iter_unpack("<I", data[:len(data) // 4 * 4])]
+
+
+def histogram(pcs, funcs):
+    """Samples per function name, '?' for PCs outside every symbol."""
+    starts = [f[0] for f in funcs]
+    counts = collections.Counter()
+    for pc in pcs:
+        i = bisect.bisect_right(starts, pc) - 1
+        counts[funcs[i][2] if i >= 0 and pc < funcs[i][1] else f"? 0x{pc:08x}"] += 1
+    return counts
+
+
+def lines_of(elf_path, addrs):
+    """Address → 'file:line' through addr2line, {} without it."""
+    if not addrs or not shutil.which(ADDR2LINE):
+        return {}
+    out = subprocess.run([ADDR2LINE, "-e", str(elf_path)] + [f"0x{a:x}" for a in addrs],
+                         capture_output=True, text=True).stdout.split("\n")
+    return {a: Path(l.split()[0]).name for a, l in zip(addrs, out) if l}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("samples", help="logs/pcs_<time>.bin")
+    ap.add_argument("--elf", default=config.FIRMWARE_ELF)
+    ap.add_argument("--top", type=int, default=25, help="functions listed")
+    ap.add_argument("--func", help="the hottest instructions of this function")
+    args = ap.parse_args()
+
+    pcs = load(args.samples)
+    if not pcs:
+        raise SystemExit("no samples")
+    funcs = functions(args.elf)
+    counts = histogram(pcs, funcs)
+    total = len(pcs)
+
+    print(f"{total} samples, {len(counts)} functions")
+    cum = 0
+    for name, n in counts.most_common(args.top):
+        cum += n
+        print(f"  {100.0 * n / total:6.2f} %  {100.0 * cum / total:6.2f} %  {n:>8}  {name}")
+
+    if args.func:
+        f = next((f for f in funcs if f[2] == args.func), None)
+        if f is None:
+            raise SystemExit(f"{args.func}: no such function in {args.elf}")
+        inside = collections.Counter(pc for pc in pcs if f[0] <= pc < f[1])
+        n_func = sum(inside.values())
+        print(f"\n{args.func}: {n_func} samples, 0x{f[0]:08x}..0x{f[1]:08x}")
+        hot = inside.most_common(args.top)
+        where = lines_of(args.elf, [a for a, _ in hot])
+        for a, n in hot:
+            print(f"  {100.0 * n / max(n_func, 1):6.2f} %  {n:>8}  0x{a:08x} +{a - f[0]:<5}"
+                  f"  {where.get(a, '')}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,504 @@
+"""proto.py - generated by tools/proto_gen.py from tools/protocol.def
+-------------------------------------------------------------------------------
+Do not edit: change firmware/stm32cube-project-files/tools/protocol.def and
+rerun the generator, led/proto.h comes out with it.
+
+Packet types, a NamedTuple per fixed payload layout (X.S its struct.Struct,
+X.decode(buf, off) / x.encode(), X.DTYPE for NumPy arrays of them) and the
+console's command list.
+"""
+import struct
+from typing import NamedTuple
+
+try:
+    import numpy as np
+except ImportError:                             # optional
+    np = None
+
+PING      = 0x01   # payload echoed
+PARAM     = 0x02   # payload: a led_params frame (0xA7 ...), its reply
+SCRIPT    = 0x03   # payload: a led_vm frame (0xA8 ...), its reply
+GYRO      = 0x04   # roll pitch yaw, float32 rad (x y z of #gyro#), no reply
+LOG       = 0x05   # device to host only: format id u32, arguments (dlog.h)
+TELEMETRY = 0x06   # device to host only: telemetry.h
+CONTROL   = 0x07   # DebugOps (led_debug.h), a batch; reply only if refused: bad op index
+ORIENT    = 0x08   # host µs u32, quaternion w x y z float32 (led_view.h), no reply
+SYNC      = 0x09   # host µs u32, frame u32, phase µs u32, period µs u32 (frame_sync.h), no reply
+PROBE     = 0x0A   # id u32, host µs u32; replied once a frame is out (latency.h)
+PIXELS    = 0x0B   # device to host only: framebuffer run (led_mirror.h)
+BENCH     = 0x0C   # device to host only: benchmark report (bench.h)
+PCSAMPLE  = 0x0D   # device to host only: sampled PCs (pc_sample.h)
+GEOMETRY  = 0x0E   # device to host only: model dump (geo_debug.h)
+AUDIO     = 0x0F   # band levels, beat count / phase / tempo from the host's analysis (audio.h), no reply
+CLIP      = 0x10   # clip upload into flash, op u8 first (clip.h); every step replied
+ERROR     = 0x7F   # reply only: request type, PktStatus
+REPLY     = 0x80   # or-ed into the type of an answer
+
+
+class Gyro(NamedTuple):
+    """PKT_GYRO"""
+    xyz: tuple            # roll pitch yaw, rad
+    S = struct.Struct("<3f")
+
+    def encode(self) -> bytes:
+        return self.S.pack(*self.xyz)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0:3])
+
+
+class ControlOp(NamedTuple):
+    """one op of a PKT_CONTROL batch (led_debug.h)"""
+    op: int               # DebugOp, | DBG_OP_DELTA for a step
+    value: float
+    S = struct.Struct("<Bf")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.op, self.value)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class Orient(NamedTuple):
+    """PKT_ORIENT"""
+    host_us: int
+    q: tuple              # w x y z
+    S = struct.Struct("<I4f")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.host_us, *self.q)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1:5])
+
+
+class Sync(NamedTuple):
+    """PKT_SYNC"""
+    host_us: int
+    frame: int
+    phase_us: int
+    period_us: int
+    S = struct.Struct("<IIII")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.host_us, self.frame, self.phase_us, self.period_us)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3])
+
+
+class Probe(NamedTuple):
+    """PKT_PROBE"""
+    id: int
+    host_us: int
+    S = struct.Struct("<II")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.id, self.host_us)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class AudioFeat(NamedTuple):
+    """PKT_AUDIO"""
+    band: tuple           # 0 … 255, low to high, spread over AUDIO_BANDS
+    level: int
+    flux: int             # dB the bands rose, saturated
+    beats: int            # since the host started: a change is an onset
+    beat_phase: int       # 0 … 65535 through the current beat
+    bpm_x10: int          # 0: no tempo
+    S = struct.Struct("<8BBBHHH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(*self.band, self.level, self.flux, self.beats, self.beat_phase, self.bpm_x10)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0:8], v[8], v[9], v[10], v[11], v[12])
+
+
+class ClipBegin(NamedTuple):
+    """PKT_CLIP, CLIP_OP_BEGIN: erases the partition"""
+    op: int
+    size: int             # image bytes, whole words
+    S = struct.Struct("<BI")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.op, self.size)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class ClipData(NamedTuple):
+    """PKT_CLIP, CLIP_OP_DATA, then the bytes (whole words)"""
+    op: int
+    offset: int           # into the image, where the last one ended
+    S = struct.Struct("<BI")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.op, self.offset)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class ClipEnd(NamedTuple):
+    """PKT_CLIP, CLIP_OP_END: checks and closes the upload"""
+    op: int
+    crc: int              # CRC unit's over the image
+    S = struct.Struct("<BI")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.op, self.crc)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class ClipReply(NamedTuple):
+    """PKT_CLIP | PKT_REPLY"""
+    op: int
+    status: int           # ClipStatus (clip.h)
+    value: int            # begin: room, data: bytes in, end: the CRC found
+    S = struct.Struct("<BBI")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.op, self.status, self.value)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2])
+
+
+class ProbeReply(NamedTuple):
+    """PKT_PROBE | PKT_REPLY, µs after the arrival but the echoed two"""
+    id: int
+    host_us: int
+    handled_us: int
+    render_us: int
+    shown_us: int         # LATENCY_NONE: no frame went out in time
+    reply_us: int
+    S = struct.Struct("<IIIIII")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.id, self.host_us, self.handled_us, self.render_us, self.shown_us, self.reply_us)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3], v[4], v[5])
+
+
+class TelemHead(NamedTuple):
+    """PKT_TELEMETRY, then zones × TelemZone, tasks u8, TelemTask, buses u8, TelemBus, supply u8, TelemSupply"""
+    version: int          # TELEM_VERSION
+    zones: int
+    window_ms: int
+    uptime_ms: int
+    fps_x100: int
+    frames_late: int
+    frames_missed: int
+    tx_dropped_text: int
+    tx_dropped_packet: int
+    rx_overrun: int
+    dma_errors: int
+    heap_peak: int
+    heap_left: int
+    stack_peak: int
+    irq_stack_peak: int
+    S = struct.Struct("<BBHIHIIIIIIIIHH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.version, self.zones, self.window_ms, self.uptime_ms, self.fps_x100, self.frames_late, self.frames_missed, self.tx_dropped_text, self.tx_dropped_packet, self.rx_overrun, self.dma_errors, self.heap_peak, self.heap_left, self.stack_peak, self.irq_stack_peak)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10], v[11], v[12], v[13], v[14])
+
+
+class TelemZone(NamedTuple):
+    """profiler window of one zone, µs saturated at 65535"""
+    calls: int
+    overruns: int
+    min_us: int
+    avg_us: int
+    p99_us: int
+    max_us: int
+    S = struct.Struct("<HHHHHH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.calls, self.overruns, self.min_us, self.avg_us, self.p99_us, self.max_us)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3], v[4], v[5])
+
+
+class TelemTask(NamedTuple):
+    """one RTOS task"""
+    cpu_permille: int
+    stack_free: int
+    S = struct.Struct("<HH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.cpu_permille, self.stack_free)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class TelemBus(NamedTuple):
+    """one output strip"""
+    transfers: int
+    errors: int
+    timeouts: int
+    max_us: int
+    S = struct.Struct("<IHHH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.transfers, self.errors, self.timeouts, self.max_us)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3])
+
+
+class TelemSupply(NamedTuple):
+    """supply monitor readings (LED_SUPPLY_MON), 0 or 1 of them"""
+    mv: int               # supply, filtered
+    ma: int               # LED current, filtered
+    model_ma: int         # the limiter's estimate
+    gain_q8: int          # measured / modelled, 256 = 1
+    budget_ma: int
+    min_mv: int           # lowest since boot
+    sags: int             # ticks under SUPPLY_V_MIN_MV, saturated
+    S = struct.Struct("<HHHHHHH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.mv, self.ma, self.model_ma, self.gain_q8, self.budget_ma, self.min_mv, self.sags)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3], v[4], v[5], v[6])
+
+
+class PixelsHead(NamedTuple):
+    """PKT_PIXELS, then 3 bytes per LED"""
+    frame: int
+    first: int
+    brightness: int
+    S = struct.Struct("<HHB")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.frame, self.first, self.brightness)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2])
+
+
+class PcSampleHead(NamedTuple):
+    """PKT_PCSAMPLE, then u32 PCs"""
+    hz: int
+    dropped: int
+    S = struct.Struct("<HH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.hz, self.dropped)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class GeoPkt(NamedTuple):
+    """PKT_GEOMETRY, then records of the section"""
+    section: int          # GEO_SEC_*
+    dump: int
+    first: int
+    S = struct.Struct("<BBH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.section, self.dump, self.first)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2])
+
+
+class GeoCounts(NamedTuple):
+    """GEO_SEC_HEAD"""
+    verts: int
+    edges: int
+    faces: int
+    leds: int             # mapped edges, 0 without the mapping
+    S = struct.Struct("<HHHH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.verts, self.edges, self.faces, self.leds)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2], v[3])
+
+
+class GeoVert(NamedTuple):
+    """GEO_SEC_VERTS"""
+    xyz: tuple
+    hue: int
+    S = struct.Struct("<3fB")
+
+    def encode(self) -> bytes:
+        return self.S.pack(*self.xyz, self.hue)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0:3], v[3])
+
+
+class GeoEdge(NamedTuple):
+    """GEO_SEC_EDGES"""
+    a: int
+    b: int
+    S = struct.Struct("<HH")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.a, self.b)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+class GeoLed(NamedTuple):
+    """GEO_SEC_LEDS"""
+    start: int
+    count: int
+    step: int
+    S = struct.Struct("<HHb")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.start, self.count, self.step)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1], v[2])
+
+
+class GeoEnd(NamedTuple):
+    """GEO_SEC_END"""
+    crc: int              # CRC-32/MPEG-2 over the records before
+    bytes: int
+    S = struct.Struct("<II")
+
+    def encode(self) -> bytes:
+        return self.S.pack(self.crc, self.bytes)
+
+    @classmethod
+    def decode(cls, buf, off=0):
+        v = cls.S.unpack_from(buf, off)
+        return cls(v[0], v[1])
+
+
+# NumPy record dtypes, for np.frombuffer over a run of records
+if np is not None:
+    Gyro.DTYPE = np.dtype([("xyz", "<f4", (3,))])
+    ControlOp.DTYPE = np.dtype([("op", "u1"), ("value", "<f4")])
+    Orient.DTYPE = np.dtype([("host_us", "<u4"), ("q", "<f4", (4,))])
+    Sync.DTYPE = np.dtype([("host_us", "<u4"), ("frame", "<u4"), ("phase_us", "<u4"), ("period_us", "<u4")])
+    Probe.DTYPE = np.dtype([("id", "<u4"), ("host_us", "<u4")])
+    AudioFeat.DTYPE = np.dtype([("band", "u1", (8,)), ("level", "u1"), ("flux", "u1"), ("beats", "<u2"), ("beat_phase", "<u2"), ("bpm_x10", "<u2")])
+    ClipBegin.DTYPE = np.dtype([("op", "u1"), ("size", "<u4")])
+    ClipData.DTYPE = np.dtype([("op", "u1"), ("offset", "<u4")])
+    ClipEnd.DTYPE = np.dtype([("op", "u1"), ("crc", "<u4")])
+    ClipReply.DTYPE = np.dtype([("op", "u1"), ("status", "u1"), ("value", "<u4")])
+    ProbeReply.DTYPE = np.dtype([("id", "<u4"), ("host_us", "<u4"), ("handled_us", "<u4"), ("render_us", "<u4"), ("shown_us", "<u4"), ("reply_us", "<u4")])
+    TelemHead.DTYPE = np.dtype([("version", "u1"), ("zones", "u1"), ("window_ms", "<u2"), ("uptime_ms", "<u4"), ("fps_x100", "<u2"), ("frames_late", "<u4"), ("frames_missed", "<u4"), ("tx_dropped_text", "<u4"), ("tx_dropped_packet", "<u4"), ("rx_overrun", "<u4"), ("dma_errors", "<u4"), ("heap_peak", "<u4"), ("heap_left", "<u4"), ("stack_peak", "<u2"), ("irq_stack_peak", "<u2")])
+    TelemZone.DTYPE = np.dtype([("calls", "<u2"), ("overruns", "<u2"), ("min_us", "<u2"), ("avg_us", "<u2"), ("p99_us", "<u2"), ("max_us", "<u2")])
+    TelemTask.DTYPE = np.dtype([("cpu_permille", "<u2"), ("stack_free", "<u2")])
+    TelemBus.DTYPE = np.dtype([("transfers", "<u4"), ("errors", "<u2"), ("timeouts", "<u2"), ("max_us", "<u2")])
+    TelemSupply.DTYPE = np.dtype([("mv", "<u2"), ("ma", "<u2"), ("model_ma", "<u2"), ("gain_q8", "<u2"), ("budget_ma", "<u2"), ("min_mv", "<u2"), ("sags", "<u2")])
+    PixelsHead.DTYPE = np.dtype([("frame", "<u2"), ("first", "<u2"), ("brightness", "u1")])
+    PcSampleHead.DTYPE = np.dtype([("hz", "<u2"), ("dropped", "<u2")])
+    GeoPkt.DTYPE = np.dtype([("section", "u1"), ("dump", "u1"), ("first", "<u2")])
+    GeoCounts.DTYPE = np.dtype([("verts", "<u2"), ("edges", "<u2"), ("faces", "<u2"), ("leds", "<u2")])
+    GeoVert.DTYPE = np.dtype([("xyz", "<f4", (3,)), ("hue", "u1")])
+    GeoEdge.DTYPE = np.dtype([("a", "<u2"), ("b", "<u2")])
+    GeoLed.DTYPE = np.dtype([("start", "<u2"), ("count", "<u2"), ("step", "i1")])
+    GeoEnd.DTYPE = np.dtype([("crc", "<u4"), ("bytes", "<u4")])
+
+HELP = [
+    "f b e m h [++|--|<float>|=<n>]",
+    "r [=0|1] (flip)",
+    "save",
+    "forget",
+    "scene <solid>",
+    "palette <name>",
+    "layer <n> <anim>|off [add|max|alpha|mul] [alpha]",
+    "highlight [v]",
+    "seed [n]",
+    "quality [auto|0-3]",
+    "clock [auto|0-2]",
+    "supply",
+    "hud [on|off]",
+    "param [<name> <value>]",
+    "preset save|load <n>",
+    "script [save|load]",
+    "stream (host frames, any text ends it)",
+    "tx [text|packet block|drop|priority]",
+    "telem [ms|0]",
+    "mirror [fps|0]",
+    "sync",
+    "link",
+    "bench [frames|stop]",
+    "bench encode [iterations]",
+    "bench wire [frames]",
+    "boot",
+    "mem",
+    "stack",
+    "sched",
+    "trace",
+    "pcs [hz|0]",
+    "irq [on|off]",
+    "bb [us|dump|arm]",
+    "rec [start|stop|play|dump]",
+    "calib [ms|stop|set <e> <block> <flip>|apply]",
+    "cal [<strip> <r|g|b|w> <gain> <gamma>]",
+    "audio",
+    "clip [play|loop|stop]",
+    "help",
+]
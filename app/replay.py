@@ -0,0 +1,78 @@
+"""replay.py - the firmware's input recordings (led/replay.h)
+-------------------------------------------------------------------------------
+"rec start" on the console restarts the animation from a known state and
+keeps every command with its frame number, "rec stop" ends it, "rec play"
+plays it on the board. "rec dump" streams it here:
+
+    #rec# n=<bytes>#
+    #rc <hex>#            (64 bytes per line)
+    #endrec#
+
+serial_manager.py saves the bytes as logs/rec_<time>.bin, the file the host
+build plays (tools/host: make CFLAGS_EXTRA=-DLED_REPLAY, led_host -p file).
+Listed here:
+
+    python replay.py logs/rec_20261015_120000.bin
+"""
+import argparse, struct, time
+from pathlib import Path
+
+import packet
+
+# ReplayHead: magic, version, quality level, brightness, pad, seed,
+# period µs, frames, entry bytes, animation name
+HEAD = struct.Struct("<4sBBBxIIII16s")
+ENTRY = struct.Struct("<IBB")
+LINE = 0x00
+
+
+def save(lines, out_dir="logs"):
+    """The dump from #rec# to #endrec# → logs/rec_<time>.bin, returns (path, summary)."""
+    data = b"".join(bytes.fromhex(l[4:-1]) for l in lines if l.startswith("#rc "))
+    head = parse_head(data)
+    path = Path(out_dir) / time.strftime("rec_%Y%m%d_%H%M%S.bin")
+    path.parent.mkdir(exist_ok=True)
+    path.write_bytes(data)
+    return path, f"{head['anim']}, {head['frames']} frames, {head['bytes']} bytes of input"
+
+
+def parse_head(data):
+    if len(data) < HEAD.size:
+        raise ValueError("short recording")
+    magic, version, level, bright, seed, period, frames, n, anim = HEAD.unpack_from(data)
+    if magic != b"IPRC" or version != 1:
+        raise ValueError("not a recording")
+    return {"level": level, "brightness": bright, "seed": seed, "period_us": period,
+            "frames": frames, "bytes": n, "anim": anim.split(b"\0")[0].decode()}
+
+
+def entries(data, head):
+    """(frame, type, bytes) in the order they came."""
+    pos, end = HEAD.size, HEAD.size + head["bytes"]
+    while pos + ENTRY.size <= end:
+        frame, typ, n = ENTRY.unpack_from(data, pos)
+        pos += ENTRY.size
+        yield frame, typ, data[pos:pos + n]
+        pos += n
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("recording", help="logs/rec_<time>.bin")
+    args = ap.parse_args()
+
+    data = Path(args.recording).read_bytes()
+    head = parse_head(data)
+    print(f"{head['anim']}: {head['frames']} frames of {head['period_us']} us, "
+          f"seed 0x{head['seed']:08x}, quality {head['level']}, brightness {head['brightness']}")
+    names = {getattr(packet, n): n for n in ("PING", "PARAM", "SCRIPT", "GYRO", "CONTROL",
+                                            "ORIENT", "SYNC", "PROBE")}
+    for frame, typ, b in entries(data, head):
+        if typ == LINE:
+            print(f"  {frame:>7}  line    {b.decode(errors='replace')}")
+        else:
+            print(f"  {frame:>7}  {names.get(typ, hex(typ)):<7} {b.hex()}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,148 @@
+"""script_asm.py - assemble per-LED effect programs for the firmware VM
+-------------------------------------------------------------------------------
+The "script" animation (led/led_vm.c) runs a small register program on every
+LED. Source is one instruction per line, '#' starts a comment:
+
+    in    r0 azim          # r0 = LED's angle around z
+    in    r1 time
+    shr   r1 r1 2
+    add   r0 r0 r1
+    ldi   r2 255
+    outp  r0 r2            # palette entry r0 at brightness r2
+
+Values are Q8 (256 = 1.0 = a full turn = the whole palette), see led_vm.h
+for what every op does. Uploaded as led_vm frames (0xA8 'C' idx insn...,
+then 0xA8 'E' n) inside binary packets (packet.py), the firmware checks
+and answers 0xA8 op status index.
+
+    python script_asm.py effect.vm                 # hex packets to stdout
+    python script_asm.py effect.vm --port COM5     # upload, [--save] to flash
+"""
+import argparse, sys, time
+
+import packet
+
+MAGIC = 0xA8
+
+# same order as VmOp / VmSrc in led/led_vm.h
+OPS = ["in", "ldi", "mov", "add", "sub", "mul", "min", "max", "addi", "muli",
+       "shr", "andi", "abs", "sin", "tri", "noise", "outp", "outrgb"]
+SRCS = ["x", "y", "z", "t", "azim", "elev", "radius", "edge", "time",
+        "u0", "u1", "u2", "u3"]
+STATUS = ["ok", "bad opcode", "bad register", "bad input", "nothing drawn",
+          "bad length", "bad frame", "flash"]
+
+CODE_MAX = 64
+CHUNK = 60                      # instructions per 'C' frame (packet payload 255)
+
+# operand kinds after the op: r = register, s = input, i = int16, b = int8,
+# u = 0..255; the op's (d, a, b) bytes are filled left to right
+FORMS = {"in": "rs", "ldi": "ri", "mov": "rr", "abs": "rr", "sin": "rr",
+         "tri": "rr", "addi": "rrb", "muli": "rru", "shr": "rru",
+         "andi": "rru", "outp": "-rr", "outrgb": "rrr"}
+
+
+def _operand(kind, tok, line):
+    try:
+        if kind == "r":
+            if not tok.startswith("r"):
+                raise ValueError
+            n = int(tok[1:])
+            if not 0 <= n < 8:
+                raise ValueError
+            return [n]
+        if kind == "s":
+            return [SRCS.index(tok)]
+        v = int(tok, 0)
+        if kind == "i" and -32768 <= v <= 65535:
+            return [v & 0xFF, (v >> 8) & 0xFF]
+        if kind == "b" and -128 <= v <= 127:
+            return [v & 0xFF]
+        if kind == "u" and 0 <= v <= 255:
+            return [v]
+    except ValueError:
+        pass
+    raise SyntaxError(f"line {line}: bad operand '{tok}'")
+
+
+def assemble(text):
+    """Source → bytes, 4 per instruction."""
+    out = bytearray()
+    for line, raw in enumerate(text.splitlines(), 1):
+        toks = raw.split("#", 1)[0].replace(",", " ").split()
+        if not toks:
+            continue
+        op = toks[0].lower()
+        if op not in OPS:
+            raise SyntaxError(f"line {line}: unknown op '{op}'")
+        form = FORMS.get(op, "rrr")
+        args = toks[1:]
+        if len(args) != len(form.replace("-", "")):
+            raise SyntaxError(f"line {line}: {op} takes {len(form.replace('-', ''))} operands")
+        insn = [OPS.index(op)]
+        if form.startswith("-"):
+            insn.append(0)
+            form = form[1:]
+        for kind, tok in zip(form, args):
+            insn += _operand(kind, tok, line)
+        insn += [0] * (4 - len(insn))
+        out += bytes(insn)
+    if not out or len(out) > 4 * CODE_MAX:
+        raise SyntaxError(f"1..{CODE_MAX} instructions")
+    return bytes(out)
+
+
+def frames(code):
+    """Upload frames for assembled code, the last one loads it."""
+    n = len(code) // 4
+    for i in range(0, n, CHUNK):
+        yield bytes([MAGIC, ord("C"), i]) + code[4 * i:4 * min(n, i + CHUNK)]
+    yield bytes([MAGIC, ord("E"), n])
+
+
+def _reply(s, timeout=1.0):
+    """Next SCRIPT answer on the port, log text in between is skipped."""
+    buf, end = b"", time.time() + timeout
+    while time.time() < end:
+        buf += s.read(s.in_waiting or 1)
+        for frame in buf.split(b"\0")[1:-1]:
+            got = packet.parse(frame) if frame else None
+            if got and got[0] == packet.SCRIPT | packet.REPLY:
+                return got[1]
+            if got and got[0] == packet.ERROR:
+                sys.exit(f"packet refused: {packet.STATUS[got[1][1]]}")
+    return b""
+
+
+def _upload(port, code, save):
+    import serial
+    with serial.Serial(port, 115200, timeout=0.1) as s:
+        for f in list(frames(code)) + ([bytes([MAGIC, ord("W")])] if save else []):
+            s.reset_input_buffer()
+            s.write(packet.build(packet.SCRIPT, f))
+            rep = _reply(s)
+            if len(rep) < 4 or rep[0] != MAGIC:
+                sys.exit(f"no reply to '{chr(f[1])}'")
+            if rep[2]:
+                sys.exit(f"'{chr(f[1])}': {STATUS[rep[2]] if rep[2] < len(STATUS) else rep[2]}"
+                         f" (instruction {rep[3]})")
+    print(f"{len(code) // 4} instructions loaded" + (", saved" if save else ""))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("source")
+    ap.add_argument("--port", help="serial port to upload to")
+    ap.add_argument("--save", action="store_true", help="keep it in flash")
+    a = ap.parse_args()
+    with open(a.source) as f:
+        code = assemble(f.read())
+    if a.port:
+        _upload(a.port, code, a.save)
+    else:
+        for fr in frames(code):
+            print(packet.build(packet.SCRIPT, fr).hex(" "))
+
+
+if __name__ == "__main__":
+    main()
@@ -3,11 +3,28 @@
 Responsibilities
 * reconnect loop with back-off
 * send() helper that logs every outbound command (tagged [sent])
-* drain() that:
+* a reader thread (link.Reader) that does all the port reads and splits the
+  bytes into lines and packets as they come (link.Framer, each byte looked
+  at once), handing them over through a deque
+* drain(), on the GUI timer, that:
     - logs every inbound line (tagged [recv])
     - optional hide/filter for #noprefix# sections or regex masks
-    - automatically issues a #dumpgeo# once after (re)connect when no geometry
+    - takes the model from the cache (geometry.py) when the #geohash# the
+      firmware announces on connect is known, asks for a #dumpgeob# when not
 * viewer bridge for live geometry (#geo# … #endgeo#) via debug_viewer.py
+* GEOMETRY packets of a #dumpgeob# put together (geometry.py) and handed to
+  the viewer like a text dump
+* event timeline dumps (#trace# … #endtrace#) saved as Chrome trace JSON
+* black box captures (#bb# … #endbb#, "bb dump") saved as CSV (blackbox.py)
+* input recordings (#rec# … #endrec#, "rec dump") saved for led_host -p (replay.py)
+* send_packet() / inbound binary packets (packet.py, 0x00 delimited) next
+  to the text lines; LOG packets are formatted (dlog.py, strings from
+  config.FIRMWARE_ELF) and go on as if the text had come in
+* the vendor bulk pipe (usb_bulk.py) when the firmware has one: packets
+  both ways go there, the text of its LOG packets joins the console's lines
+* TELEMETRY packets decoded (telemetry.py) and handed to on_telemetry
+* PROBE answers (latency.py) handed to on_probe, PIXELS (led_preview.py) to on_pixels
+* PCSAMPLE packets of a console "pcs <hz>" run kept in logs/ (pc_profile.py)
 * public helper toggle_hidden() to switch visibility of filtered traffic
 """
 import sys, time, subprocess, tempfile, os, re, logging
@@ -17,8 +34,20 @@ import serial, serial.tools.list_ports
 from colorama import init as clr_init, Fore, Style
 
 import config
+import trace_export
+import packet
+import dlog
+import usb_bulk
+import telemetry
+import bench
+import pc_profile
+import blackbox
+import replay
+import geometry
+from link import Framer, Reader
 
 clr_init(autoreset=True)
+dlog.set_elf(config.FIRMWARE_ELF)
 
 # ── logging setup (file + stdout) ─────────────────────────────────────────
 LOG_DIR = Path("logs")
@@ -37,23 +66,36 @@ logging.basicConfig(
 ser               = None          #   serial.Serial instance
 retry_interval    = config.FAST_RETRY
 last_reconnect    = 0.0
-recv_buffer       = b""           #   unparsed bytes stash
+bulk              = None          #   usb_bulk.Pipe, packets go there
+reader            = None          #   Reader thread of the open port
+DRAIN_MAX         = 2000          #   events handled per drain() call
 
+on_telemetry      = None          #   callback(telemetry.Telemetry), e.g. the app's labels
+on_probe          = None          #   callback(payload, arrival µs) for PROBE answers, latency.Tracker.reply
+on_pixels         = None          #   callback(payload) for mirrored frames, led_preview.Preview.pixels
+
+bench_reports     = bench.Collector()  #   BENCH packets of a console "bench" run
+pc_samples        = pc_profile.Recorder()  #   PCSAMPLE packets, "pcs <hz>"
+geo_packets       = geometry.Collector()  #   GEOMETRY packets of a #dumpgeob#
 viewer_proc       = None          #   debug_viewer.py process
 viewer_in         = None          #   its stdin
 
 collecting        = False         #   inside #geo# … #endgeo#
-buffer_lines      = []
+buffer_lines      = []            #   the last dump: its lines, or a geometry.Geometry
 active_name       = "viewer"
 
 got_geometry      = False         #   at least one geo dump seen?
 pending_face      = None          #   face idx requested before geometry
 
 map_dump_mode     = False         #   inside #noprefix# … #endnoprefix#
+trace_lines       = None          #   inside #trace# … #endtrace#
+bb_lines          = None          #   inside #bb# … #endbb#
+rec_lines         = None          #   inside #rec# … #endrec#
 show_hidden       = False         #   runtime toggle for filtered traffic
 
 connect_time      = 0
-sent_dump_request = False
+sent_dump_request = False         #   geometry asked for (or taken from the cache)
+GEO_ASK_AFTER     = 1.0           #   s after connect: no #geohash# yet, ask for it
 # pattern to decide whether to hide a line when show_hidden is False
 HIDE_RE = re.compile(r"^#.*#$")   #  lines enclosed in #...#  (incl. noprefix zones)
 
@@ -92,22 +134,28 @@ def list_ports():
 
 
 def close_serial():
-    global ser
+    global ser, bulk, reader
+    if reader:
+        reader.stop()                     # before the port goes away under it
+    reader = None
     if ser:
         try:
             ser.close()
         except Exception:
             pass
     ser = None
+    if bulk:
+        bulk.close()
+    bulk = None
 
 
 def try_reconnect():
     """Attempt (re)connection every `retry_interval` seconds."""
-    global ser, last_reconnect, retry_interval, got_geometry, connect_time, sent_dump_request
+    global ser, bulk, reader, last_reconnect, retry_interval, got_geometry, connect_time, sent_dump_request
     if ser and ser.is_open:
-        if not sent_dump_request and time.time() >= connect_time + 250:
-            sent_dump_request = True
-            send(config.COMMANDS['dump'])
+        if not sent_dump_request and time.time() >= connect_time + GEO_ASK_AFTER:
+            sent_dump_request = True      # the answer goes through _on_geo_hash
+            send(config.COMMANDS['geohash'])
         return True
 
     now = time.time()
@@ -122,7 +170,13 @@ def try_reconnect():
             ser = serial.Serial(port, config.BAUD, timeout=0.1, write_timeout=0.1)
             retry_interval = config.FAST_RETRY
             logging.info(Fore.GREEN + f"Connected on {port}")
+            bulk = usb_bulk.open() if config.USE_BULK else None
+            if bulk:
+                logging.info(Fore.GREEN + "Packets on the bulk pipe")
+            reader = Reader(ser, bulk)
+            reader.start()
             got_geometry = False          # fresh session - no geo yet
+            sent_dump_request = False
             # Immediately ask the MCU for geometry
             connect_time = time.time()
             
@@ -146,6 +200,73 @@ def send(cmd: str):
         close_serial()
 
 
+def send_packet(ptype: int, payload: bytes = b""):
+    """Send one binary packet (packet.py), not logged: high-rate streams."""
+    if not ser or not ser.is_open:
+        return
+    try:
+        if bulk:
+            bulk.write(packet.build(ptype, payload))
+        else:
+            ser.write(packet.build(ptype, payload))
+    except Exception as e:
+        logging.error("[send error] %s", e)
+        close_serial()
+
+
+def _on_packet(ptype: int, payload: bytes, t_us: int):
+    """A non-LOG packet, on the GUI thread."""
+    global buffer_lines, got_geometry
+    if ptype == packet.TELEMETRY:
+        t = telemetry.decode(payload)
+        if t is None:
+            logging.warning("[pkt] telemetry of another version (%d bytes)", len(payload))
+        elif on_telemetry:
+            on_telemetry(t)
+    elif ptype == packet.PROBE | packet.REPLY:
+        if on_probe:
+            on_probe(payload, t_us)
+    elif ptype == packet.PIXELS:
+        if on_pixels:
+            on_pixels(payload)
+    elif ptype == packet.BENCH:
+        report = bench_reports.add(payload)
+        if report:
+            logging.info("[bench] report saved to %s", bench.save(report))
+    elif ptype == packet.PCSAMPLE:
+        pc_samples.add(payload)
+    elif ptype == packet.GEOMETRY:
+        try:
+            geo = geo_packets.add(payload)
+        except ValueError as e:
+            logging.error("[geo] %s", e)
+            return
+        if geo:
+            buffer_lines, got_geometry = geo, True
+            geometry.save(geo, config.GEO_CACHE_DIR)
+            logging.info("[geo] V=%d E=%d F=%d (binary, cached as %08x)",
+                         len(geo.V), len(geo.E), len(geo.F), geo.crc)
+    elif ptype == packet.ERROR:
+        t, st = payload[0], payload[1]
+        logging.warning("[pkt] type 0x%02x refused: %s", t,
+                        packet.STATUS[st] if st < len(packet.STATUS) else st)
+    else:
+        logging.info("[pkt] 0x%02x %s", ptype, payload.hex(" "))
+
+
+def _on_geo_hash(crc):
+    """The firmware's #geohash#: the cached model if there is one, else a dump."""
+    global buffer_lines, got_geometry, sent_dump_request
+    sent_dump_request = True
+    geo = geometry.load(crc, config.GEO_CACHE_DIR)
+    if geo is None:
+        logging.info("[geo] %08x not cached, dumping", crc)
+        send(config.COMMANDS['dump'])
+        return
+    buffer_lines, got_geometry = geo, True
+    logging.info("[geo] %08x from the cache", crc)
+
+
 # ── geometry viewer bridge ────────────────────────────────────────────────
 
 def _viewer_send(packet):
@@ -177,24 +298,30 @@ def _viewer_send(packet):
 # ── drain() - parse inbound stream ────────────────────────────────────────
 
 def drain():
-    """Consume bytes, split into CR/LF-terminated lines, handle meta-tags."""
-    global recv_buffer, collecting, buffer_lines, got_geometry, pending_face, map_dump_mode
+    """Take what the reader thread framed (lines, packets), handle meta-tags.
+    At most DRAIN_MAX events per call, the rest stays for the next timer tick
+    so a big dump never stalls the window."""
+    global collecting, buffer_lines, got_geometry, pending_face, map_dump_mode, trace_lines, bb_lines, rec_lines
 
-    if not ser or not ser.is_open:
+    if not reader:
+        return
+    if reader.error is not None:
+        logging.error("[rx error] %s", reader.error)
+        close_serial()
         return
+    events = reader.events
     try:
-        data = ser.read(ser.in_waiting or 1)
-        if not data:
-            return
-        recv_buffer += data
-        while True:
-            sep_idx = min((i for i in (recv_buffer.find(b"\n"), recv_buffer.find(b"\r")) if i != -1), default=-1)
-            if sep_idx == -1:
+        for _ in range(DRAIN_MAX):
+            if not events:
                 break
-            line, recv_buffer = recv_buffer[:sep_idx], recv_buffer[sep_idx+1:]
-            text = line.decode(errors="replace").rstrip("\r")
-            if not text:
+            ev = events.popleft()
+            if ev[0] == "packet":
+                _on_packet(*ev[1:])
+                continue
+            if ev[0] == "warn":
+                logging.warning(ev[1])
                 continue
+            text = ev[1]
 
             # Handle noprefix sections (raw passthrough, hidden by default)
             if text == "#noprefix#":
@@ -210,6 +337,64 @@ def drain():
                 _log_recv(text)
                 continue
 
+            # Event timeline dump → logs/trace_*.json
+            if text.startswith("#trace#"):
+                trace_lines = [text]
+                _log_recv(text)
+                continue
+            if trace_lines is not None:
+                if text.startswith("#endtrace#"):
+                    path = trace_export.save(trace_lines)
+                    trace_lines = None
+                    logging.info(Fore.YELLOW + f"[trace] saved {path}")
+                else:
+                    trace_lines.append(text)
+                continue
+
+            # Black box capture → logs/blackbox_*.csv
+            if text.startswith("#bbspike#"):
+                logging.warning(Fore.YELLOW + f"[bb] spike held: {text[10:-1]}, \"bb dump\" fetches it")
+                continue
+            if text.startswith("#bb#"):
+                bb_lines = [text]
+                _log_recv(text)
+                continue
+            if bb_lines is not None:
+                if text.startswith("#endbb#"):
+                    try:
+                        path, summary = blackbox.save(bb_lines)
+                        logging.info(Fore.YELLOW + f"[bb] {summary}, saved {path}")
+                    except ValueError as e:
+                        logging.error("[bb] %s", e)
+                    bb_lines = None
+                else:
+                    bb_lines.append(text)
+                continue
+
+            # Input recording → logs/rec_*.bin
+            if text.startswith("#rec#"):
+                rec_lines = [text]
+                _log_recv(text)
+                continue
+            if rec_lines is not None:
+                if text.startswith("#endrec#"):
+                    try:
+                        path, summary = replay.save(rec_lines)
+                        logging.info(Fore.YELLOW + f"[rec] {summary}, saved {path}")
+                    except ValueError as e:
+                        logging.error("[rec] %s", e)
+                    rec_lines = None
+                else:
+                    rec_lines.append(text)
+                continue
+
+            # Geometry hash (connect, #geohash#) → cache or dump
+            crc = geometry.parse_hash(text) if text.startswith("#geohash#") else None
+            if crc is not None:
+                _on_geo_hash(crc)
+                _log_recv(text)
+                continue
+
             # Geometry stream start
             if text.startswith("#geo#"):
                 collecting = True
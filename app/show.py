@@ -0,0 +1,274 @@
+"""show.py - recorded LED shows: seekable frame files, played from a memory map
+-------------------------------------------------------------------------------
+A show is the frames exactly as stream.py sends them (led/led_stream.h), so
+playing one is handing slices of the mapped file to the port: nothing is
+decoded or encoded on the way and a long pre-rendered show costs no more CPU
+than a short one.
+
+    header  "IPSH" version(u8) 0(u8) leds(u16) geometry(u32) fps(f32)
+            frames(u32) index offset(u64)                          28 bytes
+    frames  length(u32) + frame: 'F' rgb 'E' (key) or 'D' tokens 'E' (xor
+            against the frame before), one per frame
+    index   frame number(u32) offset(u64) per key frame, ascending
+
+Every KEY_EVERY seconds (and whenever a delta would not be smaller) a frame
+goes in raw: those are the seek points, play from one and the device holds
+the right picture from the first frame on. geometry is geometry_hash() of
+the dump the show was made for (0 = unknown), a show is only meant for the
+sculpture with that wiring.
+
+Recorded device output (the live preview's mirror, led/led_mirror.h) makes
+reference data: Show.pixels(n) is frame n decoded, compare two recordings
+with diff().
+
+A show (or a stretch of it) also plays on the device alone, out of its
+flash (firmware built with LED_CLIP, led/clip.h): upload sends the header
+and the frames from a key frame on, without the index, as a clip.
+
+    python show.py info  show.ipshow
+    python show.py diff  a.ipshow b.ipshow
+    python show.py upload show.ipshow --port COM5 --start 10 --seconds 20 --loop
+    python stream.py --port COM5 --effect plasma --record plasma.ipshow
+    python stream.py --port COM5 --play plasma.ipshow
+"""
+import argparse, bisect, mmap, re, struct, sys, time, zlib
+
+import geometry
+import packet
+import proto
+import stream
+
+MAGIC    = b"IPSH"
+VERSION  = 1
+KEY_EVERY = 2.0                                 # seconds between seek points
+_HEAD    = struct.Struct("<4sBBHIfIQ")
+_LEN     = struct.Struct("<I")
+_INDEX   = struct.Struct("<IQ")
+CLIP_CHUNK = 248                                # image bytes per CLIP packet, whole words
+CLIP_BEGIN, CLIP_DATA, CLIP_END = 0, 1, 2       # led/clip.h
+CLIP_STATUS = ["ok", "does not fit / out of order", "flash error", "crc mismatch", "no upload open"]
+
+
+def geometry_hash(lines) -> int:
+    """CRC32 of a geometry dump's vertex, edge and LED lines (a binary
+    dump's as the text dump has them)."""
+    if isinstance(lines, geometry.Geometry):
+        lines = geometry.text_lines(lines)
+    keep = [l.strip() for l in lines if re.match(r"[VEL]:", l)]
+    return zlib.crc32("\n".join(keep).encode()) if keep else 0
+
+
+def apply(prev, frame) -> bytes:
+    """The picture after frame ('F' or 'D') on top of prev."""
+    if frame[:1] == b"F":
+        return bytes(frame[1:-1])
+    out, i = bytearray(prev), 0
+    body = frame[1:-1]
+    k = 0
+    while k < len(body):
+        c = body[k]
+        k += 1
+        if c < 0x80:
+            for j in range(c + 1):
+                out[i + j] ^= body[k + j]
+            i, k = i + c + 1, k + c + 1
+        else:
+            i += c - 0x7F
+    return bytes(out)
+
+
+class Recorder:
+    """Frames in, show file out: add() every picture, close() at the end."""
+
+    def __init__(self, path, leds, fps, geometry=0):
+        self.f = open(path, "wb")
+        self.leds, self.fps, self.geometry = leds, fps, geometry
+        self.n, self.prev, self.since_key, self.index = 0, None, None, []
+        self.f.write(_HEAD.pack(MAGIC, VERSION, 0, leds, geometry, fps, 0, 0))
+
+    def add(self, rgb: bytes):
+        """One picture, 3 bytes per LED in framebuffer order."""
+        if len(rgb) != 3 * self.leds:
+            raise ValueError(f"frame of {len(rgb)} bytes, show has {self.leds} LEDs")
+        frame = stream.raw(rgb)
+        if self.prev is not None and self.since_key < KEY_EVERY * self.fps:
+            d = stream.delta(self.prev, rgb)
+            if len(d) < len(frame):
+                frame = d
+        if frame[:1] == b"F":
+            self.index.append((self.n, self.f.tell()))
+            self.since_key = 0
+        self.f.write(_LEN.pack(len(frame)) + frame)
+        self.prev, self.n, self.since_key = rgb, self.n + 1, self.since_key + 1
+
+    def close(self):
+        at = self.f.tell()
+        for number, offset in self.index:
+            self.f.write(_INDEX.pack(number, offset))
+        self.f.seek(0)
+        self.f.write(_HEAD.pack(MAGIC, VERSION, 0, self.leds, self.geometry, self.fps, self.n, at))
+        self.f.close()
+
+
+class Show:
+    """A show file, mapped read-only."""
+
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        self.view = memoryview(self.map)
+        magic, ver, _, self.leds, self.geometry, self.fps, self.count, at = _HEAD.unpack_from(self.map)
+        if magic != MAGIC or ver != VERSION:
+            raise ValueError(f"{path}: not a show (or version {ver})")
+        if not at:
+            raise ValueError(f"{path}: recording was not closed")
+        keys = [_INDEX.unpack_from(self.map, o) for o in range(at, len(self.map), _INDEX.size)]
+        self.keys = [n for n, _ in keys]
+        self.key_at = [o for _, o in keys]
+        self.end = at
+
+    def seek(self, frame):
+        """(number, offset) of the last key frame at or before frame."""
+        k = max(0, bisect.bisect_right(self.keys, frame) - 1)
+        return self.keys[k], self.key_at[k]
+
+    def frames(self, start=0):
+        """(number, frame) from the key frame before start on, frame a
+        memoryview into the map: write it as it is."""
+        n, o = self.seek(start)
+        while o < self.end:
+            size, = _LEN.unpack_from(self.map, o)
+            yield n, self.view[o + _LEN.size:o + _LEN.size + size]
+            n, o = n + 1, o + _LEN.size + size
+
+    def pixels(self, frame) -> bytes:
+        """Frame number frame decoded (3 bytes per LED)."""
+        cur = bytes(3 * self.leds)
+        for n, f in self.frames(frame):
+            cur = apply(cur, f)
+            if n == frame:
+                return cur
+        raise IndexError(frame)
+
+    def close(self):
+        self.view.release()
+        self.map.close()
+        self.file.close()
+
+
+def diff(a: Show, b: Show, tolerance=0):
+    """[(frame, LEDs off by more than tolerance, largest difference)] for
+    the frames that differ, walked in step (no seeking)."""
+    out, pa, pb = [], bytes(3 * a.leds), bytes(3 * b.leds)
+    for (n, fa), (_, fb) in zip(a.frames(), b.frames()):
+        pa, pb = apply(pa, fa), apply(pb, fb)
+        if pa == pb:
+            continue
+        d = [abs(x - y) for x, y in zip(pa, pb)]
+        off = sum(1 for i in range(0, len(d), 3) if max(d[i:i + 3]) > tolerance)
+        if off:
+            out.append((n, off, max(d)))
+    return out
+
+
+def clip_image(show: Show, start=0.0, seconds=None) -> bytes:
+    """The clip for led/clip.h: show header, then the frames from the key
+    frame at or before start (seconds) on, for seconds (all if None), with
+    the frames' end where the index offset was; zero padded to words."""
+    first, _ = show.seek(int(start * show.fps))
+    last = show.count if seconds is None else min(show.count, first + max(1, round(seconds * show.fps)))
+    body = bytearray()
+    for n, f in show.frames(first):
+        if n >= last:
+            break
+        body += _LEN.pack(len(f)) + f
+    head = _HEAD.pack(MAGIC, VERSION, 0, show.leds, show.geometry, show.fps, last - first,
+                      _HEAD.size + len(body))
+    image = head + bytes(body)
+    return image + bytes(-len(image) % 4)
+
+
+def _clip_reply(s, timeout):
+    """Next CLIP answer on the port (op, status, value), log text skipped."""
+    buf, end = b"", time.time() + timeout
+    while time.time() < end:
+        buf += s.read(s.in_waiting or 1)
+        for frame in buf.split(b"\0")[1:-1]:
+            got = packet.parse(frame) if frame else None
+            if got and got[0] == packet.CLIP | packet.REPLY:
+                r = proto.ClipReply.decode(got[1])
+                return r.op, r.status, r.value
+            if got and got[0] == packet.ERROR:
+                sys.exit(f"packet refused: {packet.STATUS[got[1][1]]}")
+    sys.exit("no answer: firmware without LED_CLIP?")
+
+
+def upload(port, image: bytes, play=None):
+    """Image into the device's clip partition, one packet answered at a
+    time; play "play" / "loop" starts it."""
+    import serial
+    with serial.Serial(port, 115200, timeout=0.1) as s:
+        s.reset_input_buffer()
+        s.write(packet.build(packet.CLIP, proto.ClipBegin(CLIP_BEGIN, len(image)).encode()))
+        _, st, room = _clip_reply(s, 5.0)       # the sector erase: a second or two
+        if st:
+            sys.exit(f"clip of {len(image)} bytes: {CLIP_STATUS[st]} (room for {room})")
+        for at in range(0, len(image), CLIP_CHUNK):
+            s.write(packet.build(packet.CLIP, proto.ClipData(CLIP_DATA, at).encode() + image[at:at + CLIP_CHUNK]))
+            _, st, got = _clip_reply(s, 1.0)
+            if st:
+                sys.exit(f"at {at}: {CLIP_STATUS[st]} (device has {got})")
+            print(f"\r{at + CLIP_CHUNK if at + CLIP_CHUNK < len(image) else len(image)} of {len(image)} bytes",
+                  end="", flush=True)
+        print()
+        crc = packet.crc32_stm32(image)
+        s.write(packet.build(packet.CLIP, proto.ClipEnd(CLIP_END, crc).encode()))
+        _, st, found = _clip_reply(s, 1.0)
+        if st:
+            sys.exit(f"clip not taken: {CLIP_STATUS[st]} (crc {found:08x}, sent {crc:08x})")
+        if play:
+            s.write(f"clip {play}\n".encode())
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("info").add_argument("show")
+    p = sub.add_parser("diff")
+    p.add_argument("a")
+    p.add_argument("b")
+    p.add_argument("--tolerance", type=int, default=0, help="per channel, 0 = exact")
+    p = sub.add_parser("upload", help="into the device's flash as a clip (LED_CLIP)")
+    p.add_argument("show")
+    p.add_argument("--port", required=True)
+    p.add_argument("--start", type=float, default=0, help="seconds, from the key frame before")
+    p.add_argument("--seconds", type=float, help="how much (default: to the end)")
+    g = p.add_mutually_exclusive_group()
+    g.add_argument("--play", action="store_const", const="play", dest="then", help="play it once")
+    g.add_argument("--loop", action="store_const", const="loop", dest="then", help="play it in a loop")
+    a = ap.parse_args()
+    if a.cmd == "upload":
+        s = Show(a.show)
+        image = clip_image(s, a.start, a.seconds)
+        frames = _HEAD.unpack_from(image)[6]
+        print(f"clip: {frames} frames ({frames / s.fps:.1f} s), {len(image)} bytes")
+        upload(a.port, image, a.then)
+        return
+    if a.cmd == "info":
+        s = Show(a.show)
+        print(f"{s.count} frames, {s.leds} LEDs, {s.fps:g} fps ({s.count / s.fps:.1f} s), "
+              f"{len(s.keys)} key frames, geometry {s.geometry:08x}, "
+              f"{s.end / max(s.count, 1):.0f} bytes a frame")
+        return
+    sa, sb = Show(a.a), Show(a.b)
+    if sa.leds != sb.leds:
+        raise SystemExit(f"{sa.leds} vs {sb.leds} LEDs")
+    bad = diff(sa, sb, a.tolerance)
+    for n, off, worst in bad[:20]:
+        print(f"frame {n}: {off} LEDs differ, by up to {worst}")
+    print(f"{len(bad)} of {min(sa.count, sb.count)} frames differ")
+    raise SystemExit(1 if bad else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,246 @@
+"""stream.py - push frames rendered on the PC to the LEDs
+-------------------------------------------------------------------------------
+"stream" on the console puts the firmware into streaming mode (led/led_stream.h).
+Frames, each closed by 'E':
+
+    'F' rgb * LEDs                      raw
+    'D' tokens                          xor against the last frame, zero
+                                        spans skipped (c < 0x80: c + 1 bytes
+                                        follow, else c - 0x7F bytes skipped)
+    'P' n rgb * n index * LEDs          palette indexed (n = 0: same palette)
+
+encode() picks the smallest. With --keys the frames go out as keyframes,
+'K' stamp(u16 ms) ease(0 linear, 1 smooth) + frame, and the firmware mixes
+between them at its own frame rate. The firmware holds the USB endpoint until a
+frame is shown, so writing as fast as the port takes them runs at the
+sculpture's frame clock. Any other text ends the mode, packets may go between
+frames. With --bulk the frames take the vendor bulk pipe (usb_bulk.py, USB_BULK
+firmware), the console only starts and stops the mode.
+
+--effect runs one of the firmware's effects on the PC instead (effects.py,
+NumPy) on the geometry the first device dumps: the same frames it would draw,
+at full quality whatever its load, and effects too heavy for the MCU.
+
+--record writes what goes out to a show file, --play streams one (show.py:
+the frames are stored as sent, playing them is writing slices of the mapped
+file), from the seek point before --start.
+
+--port more than once streams to several sculptures; --sync N puts them on one
+frame clock (sync.py) and numbers every frame, 'S' frame(u32) + frame, N frames
+ahead: each device holds it until its clock reaches that number, so all of them
+show it on the same tick.
+
+    python stream.py --port COM5                   # rainbow test pattern
+    python stream.py --port COM5 --pattern chase --fps 30
+    python stream.py --port COM5 --keys 20 --smooth
+    python stream.py --port COM5 --bulk
+    python stream.py --port COM5 --effect plasma --fps 60
+    python stream.py --port COM5 --effect minefield --fps 60 --record mines.ipshow
+    python stream.py --port COM5 --play mines.ipshow --start 600
+    python stream.py --port COM5 --port COM6 --sync 3
+"""
+import argparse, colorsys, struct, time
+
+END = b"E"
+
+
+def raw(cur):
+    return b"F" + cur + END
+
+
+def delta(prev, cur):
+    d = bytes(a ^ b for a, b in zip(prev, cur))
+    out, i = bytearray(b"D"), 0
+    while i < len(d):
+        j = i + 1
+        if d[i] == 0:
+            while j < len(d) and j - i < 128 and d[j] == 0:
+                j += 1
+            out.append(0x7F + j - i)
+        else:                                   # single zeros are cheaper inline
+            while j < len(d) and j - i < 128 and (d[j] or (j + 1 < len(d) and d[j + 1])):
+                j += 1
+            out.append(j - i - 1)
+            out += d[i:j]
+        i = j
+    return bytes(out) + END
+
+
+def indexed(cur, palette=None):
+    """None if the frame has more than 255 colours. palette: the one the
+    device holds (a list, updated), sent again only when it changes."""
+    px = [cur[i:i + 3] for i in range(0, len(cur), 3)]
+    cols = sorted(set(px))
+    if len(cols) > 255:
+        return None
+    if palette is not None and set(cols) <= set(palette):
+        head = b"P\0"
+    else:
+        head = b"P" + bytes([len(cols)]) + b"".join(cols)
+        if palette is not None:
+            palette[:] = cols
+    lut = {c: i for i, c in enumerate(palette if palette is not None else cols)}
+    return head + bytes(lut[p] for p in px) + END
+
+
+def encode(prev, cur, palette=None):
+    """Smallest frame for cur (bytes, 3 per LED). prev: what the device
+    shows (None after a start or drop), palette: see indexed()."""
+    best = raw(cur)
+    cands = [delta(prev, cur)] if prev is not None else []
+    pal = list(palette) if palette is not None else None
+    p = indexed(cur, pal)
+    if p is not None:
+        cands.append(p)
+    for c in cands:
+        if len(c) < len(best) * 0.9:            # raw is received without a copy
+            best = c
+    if best[:1] == b"P" and palette is not None:
+        palette[:] = pal
+    return best
+
+
+def keyframe(frame, stamp_ms, smooth=False):
+    """Wrap an encoded frame as a keyframe (a 'D' one is against the last key)."""
+    return b"K" + struct.pack("<HB", stamp_ms & 0xFFFF, int(smooth)) + frame
+
+
+def numbered(frame, number):
+    """Wrap a frame (or keyframe) to be shown at that shared frame number."""
+    return b"S" + struct.pack("<I", number & 0xFFFFFFFF) + frame
+
+
+def rainbow(n, t):
+    for i in range(n):
+        r, g, b = colorsys.hsv_to_rgb((i / n + t * 0.2) % 1.0, 1.0, 1.0)
+        yield int(r * 255), int(g * 255), int(b * 255)
+
+
+def chase(n, t):
+    head = int(t * 60) % n
+    for i in range(n):
+        yield (255, 120, 0) if (head - i) % n < 8 else (0, 0, 0)
+
+
+def start(port):
+    import serial
+    s = serial.Serial(port, 115200, timeout=1)
+    s.reset_input_buffer()
+    s.write(b"stream\n")
+    while line := s.read_until(b"\n"):                 # log lines in between
+        if b"stream:" in line:
+            break
+    if b"stream: on" not in line:
+        raise SystemExit(f"{port} not streaming: {line.decode(errors='replace').strip()}")
+    return s
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", action="append", required=True, help="once per sculpture")
+    ap.add_argument("--leds", type=int, default=720)
+    ap.add_argument("--fps", type=float, default=0, help="0 = as fast as it takes them")
+    ap.add_argument("--pattern", choices=["rainbow", "chase"], default="rainbow")
+    ap.add_argument("--effect", choices=["palette", "gradient", "rainbow", "plasma", "minefield"],
+                    help="firmware effect rendered here (effects.py)")
+    ap.add_argument("--seed", type=lambda v: int(v, 0), default=None,
+                    help="random seed of --effect (the device's \"seed <n>\")")
+    ap.add_argument("--record", metavar="FILE", help="also write the frames to a show file")
+    ap.add_argument("--play", metavar="FILE", help="stream a show file (its fps unless --fps)")
+    ap.add_argument("--start", type=int, default=0, metavar="FRAME", help="--play from the key frame before")
+    ap.add_argument("--keys", type=float, default=0, help="keyframes per second, mixed on the device")
+    ap.add_argument("--smooth", action="store_true", help="ease between keyframes")
+    ap.add_argument("--bulk", action="store_true", help="frames over the USB bulk pipe")
+    ap.add_argument("--sync", type=int, default=0, metavar="N",
+                    help="one frame clock, frames numbered N ahead (--fps sets it, 60 if 0)")
+    a = ap.parse_args()
+    if a.bulk and len(a.port) > 1:
+        raise SystemExit("--bulk takes one sculpture")
+
+    fx = rec = play = lines = None
+    if a.effect or a.record or a.play:          # geometry first, text ends streaming
+        import serial, dmx_bridge
+        with serial.Serial(a.port[0], 115200, timeout=1) as s:
+            lines = dmx_bridge.fetch_dump(s)
+    if a.effect:
+        import effects
+        layout = effects.Layout.from_dump(lines)
+        kw = {} if a.seed is None else {"seed": a.seed}
+        fx, a.leds = effects.create(a.effect, layout, **kw), layout.total
+    if a.play or a.record:
+        import show
+    if a.play:
+        play = show.Show(a.play)
+        if play.geometry and play.geometry != show.geometry_hash(lines):
+            print(f"{a.play}: made for another geometry / wiring ({play.geometry:08x})")
+        a.fps, frames = a.fps or play.fps, play.frames(a.start)
+    if a.record:
+        rec = show.Recorder(a.record, a.leds, a.fps or 60, show.geometry_hash(lines))
+
+    ports = [start(p) for p in a.port]
+    outs = [s.write for s in ports]
+    if a.bulk:
+        import usb_bulk
+        pipe = usb_bulk.open()
+        if pipe is None:
+            raise SystemExit("no bulk pipe (firmware without USB_BULK, or no pyusb)")
+        outs = [pipe.write]
+    clock = sender = None
+    if a.sync:
+        import sync
+        clock = sync.Clock(a.fps or 60)
+        sender = sync.Sender(clock, outs)
+        sender.poll()
+    gen = rainbow if a.pattern == "rainbow" else chase
+    t0, n, sent, prev, palette = time.time(), 0, 0, None, []
+    t_last = None
+    try:
+        while True:
+            if clock:
+                sender.poll()
+                number = clock.frame() + a.sync
+                t = clock.tick_s(number)                # what shows at that tick
+            else:
+                t = time.time() - t0
+            if play:
+                got = next(frames, None)
+                if got is None:
+                    break
+                f = got[1]                              # a slice of the map, as stored
+            else:
+                if fx:
+                    dt = 1 / 60 if t_last is None else t - t_last
+                    cur, t_last = fx.frame(round(dt * 1e6)).tobytes(), t
+                else:
+                    cur = bytes(c for px in gen(a.leds, t) for c in px)
+                f = encode(prev, cur, palette)
+                if rec:
+                    rec.add(cur)
+            if a.keys:
+                f = keyframe(f, int(t * 1000), a.smooth)
+            if clock:
+                f = numbered(f, number)
+            for out in outs:
+                out(f)
+            if not play:
+                prev = cur
+            n, sent = n + 1, sent + len(f)
+            rate = a.keys or a.fps
+            if clock:
+                while clock.frame() + a.sync <= number:   # one frame per number
+                    time.sleep(0.001)
+            elif rate:
+                time.sleep(max(0.0, t0 + n / rate - time.time()))
+    except KeyboardInterrupt:
+        pass
+    if rec:
+        rec.close()
+    for s in ports:
+        s.write(b"stream off\n")
+        s.close()
+    dt = time.time() - t0
+    print(f"{n} frames, {n / dt:.1f} fps, {sent / max(n, 1):.0f} bytes each, {sent / dt / 1000:.0f} kB/s")
+
+
+if __name__ == "__main__":
+    main()
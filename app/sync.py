@@ -0,0 +1,99 @@
+"""sync.py - one frame clock for several sculptures (led/frame_sync.h)
+-------------------------------------------------------------------------------
+The host keeps a frame grid, frame n ticks at epoch + n * period, and sends
+every device a SYNC packet (packet.py) a few times a second: when it was sent,
+the frame running then and how far into it. Each device steers its frame clock
+onto the grid and numbers its frames the same, so the animations (same scene,
+same seed) and numbered stream frames (stream.py --sync) run phase-locked across
+all of them. Nothing is sent per frame.
+
+    python sync.py --port COM5 --port COM6          # 60 fps grid
+    python sync.py --port COM5 --port COM6 --fps 50
+    python sync.py --all                            # every one plugged in (devices.py)
+
+"sync" on a device's console shows whether it is locked and how far off.
+"""
+import argparse, time
+
+import packet
+
+RATE = 10                                       # SYNC packets per second and device
+
+
+class Clock:
+    """The host's frame grid, on time.perf_counter (µs)."""
+
+    def __init__(self, fps=60.0):
+        self.period_us = round(1e6 / fps)
+        self.epoch_us = time.perf_counter_ns() // 1000
+
+    def frame(self, t_us=None) -> int:
+        if t_us is None:
+            t_us = time.perf_counter_ns() // 1000
+        return (t_us - self.epoch_us) // self.period_us
+
+    def tick_s(self, frame) -> float:
+        """When frame ticks, seconds since the epoch (what to draw for it)."""
+        return frame * self.period_us / 1e6
+
+    def payload(self) -> bytes:
+        """SYNC payload stamped now; build it right before each write."""
+        t = time.perf_counter_ns() // 1000
+        f = self.frame(t)
+        return packet.sync(f, t - self.epoch_us - f * self.period_us, self.period_us, t)
+
+
+class Sender:
+    """SYNC to a set of write functions every 1 / RATE s, from a loop that
+    calls poll() often."""
+
+    def __init__(self, clock, writers):
+        self.clock, self.writers, self.last = clock, writers, 0.0
+
+    def poll(self):
+        now = time.monotonic()
+        if now - self.last < 1 / RATE:
+            return
+        self.last = now
+        for w in self.writers:                  # stamped per device, written on its own
+            w(packet.build(packet.SYNC, self.clock.payload()))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", action="append", help="once per device")
+    ap.add_argument("--all", action="store_true", help="every sculpture found (devices.py)")
+    ap.add_argument("--fps", type=float, default=60)
+    a = ap.parse_args()
+    if not a.port and not a.all:
+        ap.error("--port or --all")
+
+    if a.all:
+        import devices
+        fleet = devices.Manager(use_bulk=False)
+        fleet.scan()
+        writers, ports = fleet.writers(), []
+    else:
+        import serial
+        fleet, ports = None, [serial.Serial(p, 115200, timeout=0) for p in a.port]
+        writers = [s.write for s in ports]
+    sender = Sender(Clock(a.fps), writers)
+    print(f"sync: {len(writers)} devices, {a.fps:g} fps, ctrl-c ends")
+    try:
+        while True:
+            sender.poll()
+            if fleet:
+                fleet.drain()                   # log text, not needed here
+            for s in ports:
+                s.reset_input_buffer()
+            time.sleep(0.005)
+    except KeyboardInterrupt:
+        pass
+    if fleet:
+        fleet.close()
+    for s in ports:
+        s.close()
+
+
+if __name__ == "__main__":
+    main()
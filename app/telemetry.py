@@ -0,0 +1,121 @@
+"""telemetry.py - decode the firmware's TELEMETRY packets (led/telemetry.h)
+-------------------------------------------------------------------------------
+One packet every telemetry interval ("telem <ms>" on the console) with the
+profiler's last window per zone and the health counters. Times in µs, the
+zone numbers saturate at 65535. One entry per output strip (DMA bus) with its
+transfers, errors, watchdog timeouts and longest transfer since boot. With
+LED_SUPPLY_MON the measured supply and current and what the power limiter
+made of them.
+"""
+import proto
+from dataclasses import dataclass, field
+
+VERSION = 5
+
+# profiler.h PROF_ZONES, in order (keep in sync)
+ZONES = ["ANIM", "FADE", "ENCODE", "SUBMIT", "DMA_WAIT", "USB", "SLEEP",
+         "AUDIO"]
+# rtos_app.h RTOS_TASKS and the idle task, in order (LED_RTOS builds only)
+TASKS = ["render", "anim", "comms", "idle"]
+
+# layouts: tools/protocol.def (proto.py)
+_HEAD = proto.TelemHead.S
+_ZONE = proto.TelemZone.S
+_TASK = proto.TelemTask.S
+_BUS = proto.TelemBus.S
+_SUPPLY = proto.TelemSupply.S
+
+
+@dataclass
+class Zone:
+    calls: int
+    overruns: int
+    min_us: int
+    avg_us: int
+    p99_us: int
+    max_us: int
+
+
+@dataclass
+class Task:
+    cpu_permille: int       # share of the time since the last packet
+    stack_free: int         # bytes never used
+
+
+@dataclass
+class Bus:
+    transfers: int          # completed since boot
+    errors: int             # SPI / DMA errors, failed starts
+    timeouts: int           # hung transfers the watchdog aborted
+    max_us: int             # longest transfer
+
+
+@dataclass
+class Supply:
+    mv: int                 # supply, filtered
+    ma: int                 # LED current, filtered
+    model_ma: int           # the limiter's estimate
+    gain_q8: int            # measured / modelled, 256 = 1
+    budget_ma: int          # what the limiter holds to now
+    min_mv: int             # lowest since boot
+    sags: int               # 10 ms ticks under the minimum
+
+
+@dataclass
+class Telemetry:
+    window_ms: int
+    uptime_ms: int
+    fps: float
+    frames_late: int
+    frames_missed: int
+    tx_dropped_text: int
+    tx_dropped_packet: int
+    rx_overrun: int
+    dma_errors: int
+    heap_peak: int
+    heap_left: int
+    stack_peak: int         # main loop, bytes (led/stack_mon.h)
+    irq_stack_peak: int     # interrupts, 0 with the one shared stack
+    zones: dict = field(default_factory=dict)   # name → Zone
+    tasks: dict = field(default_factory=dict)   # name → Task, empty bare-metal
+    buses: list = field(default_factory=list)   # Bus per strip, in order
+    supply: Supply = None                       # LED_SUPPLY_MON builds only
+
+
+def decode(payload: bytes):
+    """TELEMETRY payload → Telemetry, None for another version or a short one."""
+    if len(payload) < _HEAD.size or payload[0] != VERSION:
+        return None
+    (_v, n, window, uptime, fps, late, missed, drop_text, drop_pkt,
+     overrun, dma, heap_peak, heap_left, stack, irq_stack) = _HEAD.unpack_from(payload)
+    if len(payload) < _HEAD.size + n * _ZONE.size:
+        return None
+    zones = {}
+    for i in range(n):
+        name = ZONES[i] if i < len(ZONES) else f"zone{i}"
+        zones[name] = Zone(*_ZONE.unpack_from(payload, _HEAD.size + i * _ZONE.size))
+    tasks = {}
+    off = _HEAD.size + n * _ZONE.size
+    if len(payload) > off:
+        k = payload[off]
+        if len(payload) < off + 1 + k * _TASK.size:
+            return None
+        for i in range(k):
+            name = TASKS[i] if i < len(TASKS) else f"task{i}"
+            tasks[name] = Task(*_TASK.unpack_from(payload, off + 1 + i * _TASK.size))
+        off += 1 + k * _TASK.size
+    buses = []
+    if len(payload) > off:
+        k = payload[off]
+        if len(payload) < off + 1 + k * _BUS.size:
+            return None
+        buses = [Bus(*_BUS.unpack_from(payload, off + 1 + i * _BUS.size)) for i in range(k)]
+        off += 1 + k * _BUS.size
+    supply = None
+    if len(payload) > off and payload[off]:
+        if len(payload) < off + 1 + _SUPPLY.size:
+            return None
+        supply = Supply(*_SUPPLY.unpack_from(payload, off + 1))
+    return Telemetry(window, uptime, fps / 100.0, late, missed, drop_text, drop_pkt,
+                     overrun, dma, heap_peak, heap_left, stack, irq_stack, zones, tasks, buses,
+                     supply)
@@ -0,0 +1,75 @@
+"""trace_export.py - turn a firmware #trace# dump into Chrome trace JSON
+-------------------------------------------------------------------------------
+The MCU streams its event ring (led/trace.c) as
+
+    #trace# n=<records> hz=<cpu clock>#
+    #tr <hex>#            (8 records per line, 8 bytes each, little-endian)
+    #endtrace#
+
+Record: uint32 DWT cycles, uint8 event, uint8 flags (phase | 0x80 = ISR),
+uint16 arg. The resulting file opens in chrome://tracing or ui.perfetto.dev.
+"""
+import json, re, struct, time
+from pathlib import Path
+
+# same order as TRACE_EVENTS in led/trace.h
+EVENTS = ["ANIM", "FADE", "ENCODE", "SUBMIT", "DMA_WAIT", "USB",
+          "USB_FLUSH", "SPI_DMA", "CDC_RX", "CDC_TX", "SLEEP", "AUDIO"]
+PHASES = {0: "B", 1: "E", 2: "i"}
+
+TID_MAIN, TID_ISR, TID_SPI = 1, 2, 10     # SPI strips get TID_SPI + strip
+
+HEADER_RE = re.compile(r"#trace#\s+n=(\d+)\s+hz=(\d+)#")
+
+
+def _tid(name, flags, arg):
+    if name == "SPI_DMA":
+        return TID_SPI + arg
+    return TID_ISR if flags & 0x80 else TID_MAIN
+
+
+def convert(lines):
+    """lines: the dump from #trace# to #endtrace# → Chrome trace dict."""
+    m = HEADER_RE.match(lines[0])
+    hz = int(m.group(2)) if m else 84_000_000
+
+    raw = b"".join(bytes.fromhex(l[4:-1]) for l in lines if l.startswith("#tr "))
+    return convert_records(struct.iter_unpack("<IBBH", raw), hz)
+
+
+def convert_records(records, hz=84_000_000):
+    """(cycles, event, flags, arg) tuples, oldest first → Chrome trace dict
+    (the dump above, or the live events from SWO, itm_decode.py)."""
+    events, tids = [], set()
+    last, wraps, t0 = None, 0, None
+    for cyc, ev, flags, arg in records:
+        if last is not None and cyc < last:
+            wraps += 1                    # CYCCNT wrapped (~51 s at 84 MHz)
+        last = cyc
+        abs_cyc = cyc + (wraps << 32)
+        if t0 is None:
+            t0 = abs_cyc
+        name = EVENTS[ev] if ev < len(EVENTS) else f"EV{ev}"
+        tid  = _tid(name, flags, arg)
+        tids.add(tid)
+        e = {"name": name, "ph": PHASES.get(flags & 3, "i"),
+             "ts": (abs_cyc - t0) * 1e6 / hz, "pid": 1, "tid": tid,
+             "args": {"arg": arg}}
+        if e["ph"] == "i":
+            e["s"] = "t"
+        events.append(e)
+
+    for tid in sorted(tids):
+        label = ("main" if tid == TID_MAIN else "isr" if tid == TID_ISR
+                 else f"spi strip {tid - TID_SPI}")
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid,
+                       "args": {"name": label}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def save(lines, out_dir="logs"):
+    """Convert and write logs/trace_<time>.json, returns the path."""
+    path = Path(out_dir) / time.strftime("trace_%Y%m%d_%H%M%S.json")
+    path.parent.mkdir(exist_ok=True)
+    path.write_text(json.dumps(convert(lines)), encoding="utf-8")
+    return path
@@ -0,0 +1,83 @@
+"""usb_bulk.py - the firmware's vendor bulk pipe (led/usb_bulk.h, USB_BULK)
+-------------------------------------------------------------------------------
+With USB_BULK the sculpture is a composite device: the CDC console (the serial
+port) and interface 2, one bulk endpoint each way. Packets (packet.py) and
+stream frames (stream.py) go through it, so they never wait behind log text.
+The firmware sends its packets here once the host has written to the pipe;
+open() does that with a zero length write.
+
+The pipe is built for throughput (near 1 MB/s at full speed): write whole
+frames in one call, the firmware receives them in long transfers, and read
+big, it sends up to its ring's worth at once.
+
+Needs pyusb and a libusb backend. On Windows 8.1 and later the device's MS OS
+2.0 descriptors have WinUSB bound to interface 2 already, no Zadig needed.
+open() returns None without them or without the interface, and everything
+stays on the serial port.
+"""
+try:
+    import usb.core, usb.util
+except ImportError:                             # optional
+    usb = None
+
+VID, PID = 0x0483, 0x5740                       # usbd_desc.c USBD_VID / USBD_PID_FS
+ITF      = 2
+EP_OUT   = 0x03
+EP_IN    = 0x83
+READ_MAX = 16384                                # a few of the firmware's transfers
+
+
+class Pipe:
+    def __init__(self, dev):
+        self.dev = dev
+
+    def read(self, timeout_ms=1) -> bytes:
+        try:
+            return bytes(self.dev.read(EP_IN, READ_MAX, timeout_ms))
+        except usb.core.USBTimeoutError:
+            return b""
+
+    def write(self, data: bytes, timeout_ms=1000):
+        self.dev.write(EP_OUT, data, timeout_ms)
+
+    def close(self):
+        try:
+            usb.util.release_interface(self.dev, ITF)
+            usb.util.dispose_resources(self.dev)
+        except Exception:
+            pass
+
+
+def _serial(dev):
+    try:
+        return usb.util.get_string(dev, dev.iSerialNumber)
+    except (usb.core.USBError, ValueError):
+        return None
+
+
+def open(serial_number=None):
+    """The pipe of the first sculpture, or of the one with serial_number."""
+    if usb is None:
+        return None
+    try:
+        if serial_number is None:
+            dev = usb.core.find(idVendor=VID, idProduct=PID)
+        else:
+            dev = usb.core.find(idVendor=VID, idProduct=PID,
+                                custom_match=lambda d: _serial(d) == serial_number)
+        if dev is None:
+            return None
+        cfg = dev.get_active_configuration()
+        if usb.util.find_descriptor(cfg, bInterfaceNumber=ITF) is None:
+            return None                         # built without USB_BULK
+        try:
+            if dev.is_kernel_driver_active(ITF):
+                dev.detach_kernel_driver(ITF)
+        except (NotImplementedError, usb.core.USBError):
+            pass
+        usb.util.claim_interface(dev, ITF)
+        pipe = Pipe(dev)
+        pipe.write(b"")                         # opens it on the firmware side
+        return pipe
+    except usb.core.USBError:
+        return None
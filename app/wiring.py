@@ -0,0 +1,222 @@
+"""wiring.py - plan the LED wiring before soldering (USER_MAP, LED_STRIP_LENGTHS)
+-------------------------------------------------------------------------------
+The data runs block after block (the LED run on one bar) through each
+strip, strip 0 first; a strip takes its blocks from LED_STRIP_LENGTHS
+(config.h) or an even share of the pixels. A frame is only as fast as its
+longest strip, and every hop from one block's end to the next block's
+start that is not the same corner is a jumper wire.
+
+This searches wirings of the model for the one with the shortest longest
+strip and, of those, the least jumper wire: a walk over all edges, corner
+to corner, hopping to the nearest corner with edges left when it runs
+out (odd corners first, a walk can only end there), many times at random,
+each cut into --strips runs where that balances the LEDs best and drops
+the most jumpers. Printed are the strips, the fps they allow and the
+config.h lines: LED_STRIP_LENGTHS, LED_EDGE_LEDS (uneven blocks only,
+the firmware takes them by length otherwise) and USER_MAP / USER_FLIP.
+
+The model is a cached dump (cache/geo_<crc>.json, geometry.py) or comes
+from the device; LEDs per edge from the dump, --leds or by length:
+
+    python wiring.py cache/geo_c49cf59b.json --strips 3
+    python wiring.py --port COM5 --leds 24
+"""
+import argparse, math, random
+from pathlib import Path
+
+import geometry
+from calibrate import c_initializers
+
+# one LED: 24 bits of 3 SPI bits at 2.625 MHz (led/config.h), latch after
+LED_US   = 24 * 3 / 2.625
+LATCH_US = 300
+
+
+def model_from_port(port):
+    """#dumpgeo# over the port → V, E, [LED count per edge or None]."""
+    import serial
+    import dmx_bridge
+    import led_preview
+    with serial.Serial(port, 115200, timeout=0.1) as s:
+        V, E, _F, L = led_preview.parse(dmx_bridge.fetch_dump(s))
+    return [tuple(map(float, v)) for v in V], E, [l[1] if l else None for l in L]
+
+
+def model_from_file(path):
+    path = Path(path)
+    crc = int(path.stem.split("_")[-1], 16)
+    g = geometry.load(crc, path.parent)
+    if g is None:
+        raise SystemExit(f"{path}: no geometry")
+    return g.V, g.E, [l[1] if l else None for l in g.L]
+
+
+def led_counts(V, E, dumped, leds, longest):
+    """LEDs per logical edge: --leds (one count or one per edge), else the
+    dump's, else the edge's share of `longest` by length."""
+    if leds:
+        n = [int(x) for x in leds.split(",")]
+        if len(n) == 1:
+            return n * len(E)
+        if len(n) != len(E):
+            raise SystemExit(f"--leds: {len(n)} counts for {len(E)} edges")
+        return n
+    if all(c is not None for c in dumped):
+        return list(dumped)
+    lens = [math.dist(V[a], V[b]) for a, b in E]
+    return [max(1, round(l / max(lens) * longest)) for l in lens]
+
+
+def walk(V, E, rng):
+    """All edges as one sequence [(edge, forward, jumper before it)]."""
+    adj = [[] for _ in V]
+    for e, (a, b) in enumerate(E):
+        adj[a].append(e)
+        adj[b].append(e)
+    left = [len(x) for x in adj]
+    used = [False] * len(E)
+    seq, at = [], None
+    for _ in E:
+        if at is None or not left[at]:
+            # start over where edges are left: odd ones first, nearest
+            cand = [v for v in range(len(V)) if left[v]]
+            odd = [v for v in cand if left[v] % 2]
+            cand = odd or cand
+            if at is None:
+                nxt = rng.choice(cand)
+            else:
+                near = min(math.dist(V[at], V[v]) for v in cand)
+                nxt = rng.choice([v for v in cand if math.dist(V[at], V[v]) <= near * 1.001])
+            jump = 0.0 if at is None else math.dist(V[at], V[nxt])
+            at = nxt
+        else:
+            jump = 0.0
+        # on to the corner with the most edges left, not into a dead end
+        opts = [e for e in adj[at] if not used[e]]
+        other = lambda e: E[e][1] if E[e][0] == at else E[e][0]
+        if rng.random() < 0.25:
+            e = rng.choice(opts)
+        else:
+            best = max(left[other(e)] for e in opts)
+            e = rng.choice([e for e in opts if left[other(e)] == best])
+        used[e] = True
+        left[at] -= 1
+        fwd = E[e][0] == at
+        at = other(e)
+        left[at] -= 1
+        seq.append((e, fwd, jump))
+    return seq
+
+
+def cut(seq, count, strips):
+    """Cut points of seq into `strips` non-empty runs: the least longest
+    run, of those the least jumper wire left inside the runs. Returns
+    (longest, jumpers, [first index of each run])."""
+    n = len(seq)
+    pre = [0]
+    for e, _f, _j in seq:
+        pre.append(pre[-1] + count[e])
+    inf = float("inf")
+
+    # smallest longest run: dp over (runs, end) of the longest so far
+    best = [[inf] * (n + 1) for _ in range(strips + 1)]
+    best[0][0] = 0
+    for k in range(1, strips + 1):
+        for j in range(k, n + 1):
+            best[k][j] = min(max(best[k - 1][i], pre[j] - pre[i]) for i in range(k - 1, j))
+    top = best[strips][n]
+
+    # least jumper wire with no run over that; the first hop of a run is free
+    wire = [[inf] * (n + 1) for _ in range(strips + 1)]
+    back = [[0] * (n + 1) for _ in range(strips + 1)]
+    wire[0][0] = 0.0
+    jsum = [0.0]
+    for _e, _f, j in seq:
+        jsum.append(jsum[-1] + j)
+    for k in range(1, strips + 1):
+        for j in range(k, n + 1):
+            for i in range(k - 1, j):
+                if pre[j] - pre[i] > top or wire[k - 1][i] == inf:
+                    continue
+                w = wire[k - 1][i] + jsum[j] - jsum[i + 1]
+                if w < wire[k][j]:
+                    wire[k][j], back[k][j] = w, i
+    starts, j = [], n
+    for k in range(strips, 0, -1):
+        j = back[k][j]
+        starts.append(j)
+    return top, wire[strips][n], starts[::-1]
+
+
+def search(V, E, count, strips, tries, seed):
+    """Best (longest, jumpers, seq, starts) of `tries` walks."""
+    rng = random.Random(seed)
+    best = None
+    for _ in range(tries):
+        seq = walk(V, E, rng)
+        top, wire, starts = cut(seq, count, strips)
+        if best is None or (top, wire) < best[:2]:
+            best = (top, wire, seq, starts)
+    return best
+
+
+def maps(seq, count):
+    """Wire order → USER_MAP (logical edge → block), USER_FLIP (wired
+    B→A), LEDs per block."""
+    umap, flip, blocks = [0] * len(seq), [False] * len(seq), []
+    for p, (e, fwd, _j) in enumerate(seq):
+        umap[e], flip[e] = p, not fwd
+        blocks.append(count[e])
+    return umap, flip, blocks
+
+
+def c_lines(name, xs, n=10):
+    return (f"#define {name} {{ " +
+            ", ".join(", ".join(str(x) for x in xs[i:i + n]) for i in range(0, len(xs), n)) + " }")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("model", nargs="?", help="cache/geo_<crc>.json")
+    ap.add_argument("--port", help="take the model from the device instead")
+    ap.add_argument("--leds", help="LEDs per edge: one count, or one per logical edge")
+    ap.add_argument("--longest", type=int, default=24, help="LEDS_LONGEST_EDGE, counts by length")
+    ap.add_argument("--strips", type=int, default=3)
+    ap.add_argument("--tries", type=int, default=2000)
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--led-us", type=float, default=LED_US, help="wire time per LED")
+    args = ap.parse_args()
+    if not args.model and not args.port:
+        ap.error("a cached model or --port")
+
+    V, E, dumped = model_from_port(args.port) if args.port else model_from_file(args.model)
+    count = led_counts(V, E, dumped, args.leds, args.longest)
+    if len(E) < args.strips:
+        raise SystemExit(f"{len(E)} edges for {args.strips} strips")
+    top, wire, seq, starts = search(V, E, count, args.strips, args.tries, args.seed)
+    edge = sum(math.dist(V[a], V[b]) for a, b in E) / len(E)
+
+    lengths = []
+    for s, first in enumerate(starts):
+        end = starts[s + 1] if s + 1 < len(starts) else len(seq)
+        run = seq[first:end]
+        leds = sum(count[e] for e, _f, _j in run)
+        hops = [j for _e, _f, j in run[1:] if j]
+        lengths.append(leds)
+        print(f"strip {s}: {len(run):3} blocks {leds:5} LEDs {leds * args.led_us + LATCH_US:8.0f} us, "
+              f"{len(hops)} jumpers {sum(hops) / edge:.2f} edges long")
+        print("    " + " ".join(f"{e}{'' if f else '~'}{'*' if j and k else ''}"
+                                for k, (e, f, j) in enumerate(run)))
+    print(f"longest strip {top} LEDs: {1e6 / (top * args.led_us + LATCH_US):.1f} fps at most, "
+          f"jumpers {wire / edge:.2f} edge lengths in all ('~' B->A, '*' after a jumper)\n")
+
+    umap, flip, blocks = maps(seq, count)
+    print(c_lines("LED_STRIP_LENGTHS", lengths))
+    if len(set(blocks)) > 1:
+        print(c_lines("LED_EDGE_LEDS", blocks))
+    print()
+    print(c_initializers(umap, flip))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+/*
+ * FreeRTOSConfig.h – kernel configuration of the LED_RTOS build (rtos_app.h)
+ *
+ * Static allocation only (no heap_x.c needed), run time stats on the DWT
+ * cycle counter, no software timers. SVC, PendSV and SysTick are installed
+ * by rtos_start() in a RAM vector table, so the handler names are not
+ * mapped onto the generated ones here.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#if defined(__GNUC__) || defined(__ICCARM__)
+#include <stdint.h>
+extern uint32_t SystemCoreClock;
+#endif
+
+#define configUSE_PREEMPTION                     1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  1
+#define configUSE_TICKLESS_IDLE                  0
+#define configCPU_CLOCK_HZ                       (SystemCoreClock)
+#define configTICK_RATE_HZ                       ((TickType_t)1000)   /* = HAL tick */
+#define configMAX_PRIORITIES                     5
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
+#define configMAX_TASK_NAME_LEN                  8
+#define configUSE_16_BIT_TICKS                   0
+#define configIDLE_SHOULD_YIELD                  1
+#define configUSE_TASK_NOTIFICATIONS             1
+#define configUSE_MUTEXES                        1
+#define configUSE_RECURSIVE_MUTEXES              0
+#define configUSE_COUNTING_SEMAPHORES            0
+#define configQUEUE_REGISTRY_SIZE                0
+#define configUSE_QUEUE_SETS                     0
+#define configUSE_TIME_SLICING                   1
+#define configUSE_NEWLIB_REENTRANT               0
+#define configENABLE_BACKWARD_COMPATIBILITY      0
+
+/* memory: everything static (rtos_app.c) */
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
+
+/* hooks */
+#define configUSE_IDLE_HOOK                      1    /* WFI, MAIN_LOOP_WFI */
+#define configUSE_TICK_HOOK                      0
+#define configCHECK_FOR_STACK_OVERFLOW           2
+#define configUSE_MALLOC_FAILED_HOOK             0
+
+/* run time stats for telemetry: DWT->CYCCNT, enabled by main() already.
+ * 32 bits wrap after 51 s at 84 MHz, rtos_task_stats() takes differences */
+#define configGENERATE_RUN_TIME_STATS            1
+#define configUSE_TRACE_FACILITY                 1
+#define configUSE_STATS_FORMATTING_FUNCTIONS     0
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() ((void)0)
+#define portGET_RUN_TIME_COUNTER_VALUE()         (*(volatile uint32_t *)0xE0001004u)   /* DWT->CYCCNT */
+
+#define configUSE_CO_ROUTINES                    0
+#define configUSE_TIMERS                         0
+
+/* API */
+#define INCLUDE_vTaskPrioritySet                 0
+#define INCLUDE_uxTaskPriorityGet                0
+#define INCLUDE_vTaskDelete                      0
+#define INCLUDE_vTaskSuspend                     1    /* portMAX_DELAY blocks for good */
+#define INCLUDE_vTaskDelayUntil                  1
+#define INCLUDE_vTaskDelay                       1
+#define INCLUDE_xTaskGetSchedulerState           1    /* SysTick before the start */
+#define INCLUDE_xTaskGetIdleTaskHandle           1
+#define INCLUDE_uxTaskGetStackHighWaterMark      1
+
+/* Cortex-M interrupt priorities, 4 bits on the STM32F4 (NVIC_PRIORITYGROUP_4).
+ * The kernel runs at the lowest; ISRs from priority 2 on may use the FromISR
+ * API (strip DMAs 2, frame clock 3, memory DMA 3), USB (0) never does and is
+ * never masked by the kernel. */
+#ifdef __NVIC_PRIO_BITS
+  #define configPRIO_BITS                        __NVIC_PRIO_BITS
+#else
+  #define configPRIO_BITS                        4
+#endif
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY       15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY  2
+#define configKERNEL_INTERRUPT_PRIORITY          (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY     (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define configASSERT(x)                          if ((x) == 0) { taskDISABLE_INTERRUPTS(); for (;;); }
+
+#endif /* FREERTOS_CONFIG_H */
@@ -29,13 +29,42 @@
 /* --------------------------------------------------------------------------
  * main.c – init sequence for polyhedron, mapping and LED renderer
  * -------------------------------------------------------------------------- */
+#include <string.h>       /* memcpy                                      */
 
 #include "polyhedron.h"   /* Polyhedron geometry + helpers              */
 #include "led_mapping.h"  /* init_mapping / mapping_build_pixel_map      */
 #include "led_render.h"   /* init_render / framebuffer ops               */
 #include "led_debug.h"    /* debug_edge_map_save / debug_ui_*            */
+#include "scene.h"        /* scene_init (geometry + mapping + renderer)  */
 #include "usb_comms.h"    /* flush_usb_buffer / usb_comms_process        */
 #include "spi.h"          /* SPI handle declarations (hspi2, hspi3 …)    */
+#include "frame_clock.h"  /* frame_clock_begin / frame_clock_end         */
+#include "frame_sync.h"   /* frame_sync_tick (host frame clock)          */
+#include "profiler.h"     /* PROF_BEGIN / PROF_END / prof_tick            */
+#include "trace.h"        /* trace_tick                                  */
+#include "telemetry.h"    /* telemetry_tick                              */
+#include "led_view.h"     /* view_tick (streamed orientation)            */
+#include "led_link.h"     /* link_poll (board-to-board link)             */
+#include "latency.h"      /* latency_frame / latency_tick (PKT_PROBE)    */
+#include "led_mirror.h"   /* mirror_frame (live preview in the app)      */
+#include "render_bench.h" /* render_bench_tick ("bench wire")           */
+#include "boot_prof.h"    /* boot_mark / boot_tick (boot phase times)    */
+#include "stack_mon.h"    /* stack_init (painted stacks, irq stack)      */
+#include "idle.h"         /* idle_wait (WFI between passes)              */
+#include "sched.h"        /* sched_add / sched_run (main loop tasks)     */
+#include "rtos_app.h"     /* rtos_start (LED_RTOS build)                 */
+#include "itm.h"          /* itm_init (SWO output, LED_ITM)              */
+#include "pc_sample.h"    /* pcs_tick (PC samples, LED_PC_SAMPLE)        */
+#include "irq_stats.h"    /* irq_tick (handler load, LED_IRQ_STATS)      */
+#include "blackbox.h"     /* bb_tick (spike capture, LED_BLACKBOX)       */
+#include "replay.h"       /* replay_frame / replay_tick (LED_REPLAY)     */
+#include "audio.h"        /* audio_tick / audio_latch (LED_AUDIO)        */
+#include "led_anim.h"     /* anim_warm_tick (next mode's tables)         */
+#include "clock_scale.h"  /* clk_scale_tick (LED_CLOCK_SCALE)            */
+#include "supply.h"       /* supply_tick (LED_SUPPLY_MON)                */
+#ifdef LED_OUTPUT_GPIO
+#include "led_gpio_out.h" /* LED_GPIO_STRIPS                             */
+#endif
 
 /* USER CODE END Includes */
 
@@ -49,13 +78,11 @@
 #define USB_INIT_DELAY 1000
 #define SERIAL_SEND_RATE 50
 #define SERIAL_RECIEVE_RATE 20
-#define DEBUG_UI_UPDATE_RATE 1 //1000/60
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
 
-Polyhedron poly;  /* our geometry instance */
 
 
 void enable_DWT(void){
@@ -87,7 +114,9 @@ void SystemClock_Config(void);
 extern SPI_HandleTypeDef hspi1;                       /* declared in spi.c     */
 extern SPI_HandleTypeDef hspi2;                       /* declared in spi.c     */
 extern SPI_HandleTypeDef hspi3;                       /* declared in spi.c     */
+#ifndef LED_OUTPUT_GPIO
 static SPI_HandleTypeDef *const led_spis[] = { &hspi1, &hspi2, &hspi3 };  /* 3 strips */
+#endif
 
 /* USER CODE END PFP */
 
@@ -95,10 +124,80 @@ static SPI_HandleTypeDef *const led_spis[] = { &hspi1, &hspi2, &hspi3 };  /* 3 s
 /* USER CODE BEGIN 0 */
 
 /* ---------- helpers -------------------------------------- */
-uint32_t last_debug_ui_update_time = 0;
-uint32_t last_serial_recieve_time = 0;
-uint32_t last_serial_send_time = 0;
 uint32_t cur_time = 0;
+
+#ifndef LED_RTOS
+/* one anim → encode → DMA frame per frame clock tick */
+static void frame_task(void)
+{
+	if (!frame_clock_begin()) return;
+	replay_frame();            /* a replay: the input this frame came after */
+	frame_sync_tick();         /* shared frame number, clock steered to the host */
+	latency_frame();           /* a probe waiting: this frame draws what came with it */
+	audio_latch();             /* the bands this frame draws with */
+	view_tick();
+	debug_ui_tick();
+	mirror_frame();            /* the frame just drawn, to the app's preview */
+	frame_clock_end();
+}
+#endif
+
+/* these are macros without their module (LED_PROFILE, LED_LINK_*, LED_TRACE, ...) */
+static void link_task(void)  { link_poll(); }
+static void prof_task(void)  { prof_tick(); }
+static void trace_task(void) { trace_tick(); }
+static void pcs_task(void)   { pcs_tick(); }
+static void irq_task(void)   { irq_tick(); }
+static void bb_task(void)    { bb_tick(); }
+static void rec_task(void)   { replay_tick(); }
+static void audio_task(void) { audio_tick(); }
+static void clock_task(void) { clk_scale_tick(); }
+static void supply_task(void){ supply_tick(); }
+
+static void usb_flush_task(void)
+{
+	PROF_BEGIN(USB);
+	flush_usb_buffer();
+	PROF_END(USB);
+}
+
+/* input right when it came, or on the poll for the greeting */
+static void usb_rx_task(void)
+{
+	static uint32_t last;
+	uint32_t now = HAL_GetTick();
+	if (!usb_comms_rx_pending() && now - last < SERIAL_RECIEVE_RATE) return;
+	last = now;
+	PROF_BEGIN(USB);
+	usb_comms_process();
+	PROF_END(USB);
+}
+
+/* the main loop's work, by priority: a frame tick is served before the
+ * next lower one starts, bulk dumps only while the slot has room */
+static void tasks_init(void)
+{
+#ifndef LED_RTOS
+	sched_add("frame",     SCHED_RENDER, 0,                frame_task);         /* the RTOS build has tasks for it */
+#endif
+	sched_add("link",      SCHED_COMMS,  0,                link_task);          /* a link node: decode, latch on the edge */
+	sched_add("usb rx",    SCHED_COMMS,  0,                usb_rx_task);
+	sched_add("usb flush", SCHED_COMMS,  SERIAL_SEND_RATE, usb_flush_task);
+	sched_add("prof",      SCHED_UI,     0,                prof_task);
+	sched_add("telemetry", SCHED_UI,     0,                telemetry_tick);     /* PKT_TELEMETRY for the app */
+	sched_add("latency",   SCHED_UI,     0,                latency_tick);       /* PKT_PROBE answer once its frame is out */
+	sched_add("boot",      SCHED_UI,     0,                boot_tick);          /* first frame lit, USB up: the boot report */
+	sched_add("pcs",       SCHED_UI,     0,                pcs_task);           /* PKT_PCSAMPLE while "pcs <hz>" runs */
+	sched_add("irq",       SCHED_UI,     0,                irq_task);           /* closes the handler load window */
+	sched_add("audio",     SCHED_UI,     0,                audio_task);         /* a block's FFT, in a slot with room */
+	sched_add("clock",     SCHED_UI,     0,                clock_task);         /* HCLK down while the frames are light */
+	sched_add("supply",    SCHED_UI,     0,                supply_task);        /* measured current into the limiter */
+	sched_add("trace",     SCHED_BULK,   0,                trace_task);         /* streams a requested trace dump */
+	sched_add("blackbox",  SCHED_BULK,   0,                bb_task);            /* the spike note, a requested capture */
+	sched_add("replay",    SCHED_BULK,   0,                rec_task);           /* streams a requested recording */
+	sched_add("bench",     SCHED_BULK,   0,                render_bench_tick);  /* strip times of the frames going out */
+	sched_add("warm",      SCHED_BULK,   0,                anim_warm_tick);     /* the neighbour modes' tables, ahead of a switch */
+}
 /* ---------------------------------------------------------- */
 
 /* USER CODE END 0 */
@@ -119,7 +218,7 @@ int main(void) {
 	HAL_Init();
 
 	/* USER CODE BEGIN Init */
-
+	enable_DWT();              /* boot_prof.h counts the boot phases from here */
 	/* USER CODE END Init */
 
 	/* Configure the system clock */
@@ -127,6 +226,8 @@ int main(void) {
 
 	/* USER CODE BEGIN SysInit */
 	//HAL_Delay(USB_INIT_DELAY);
+	stack_init();              /* paint at 84 MHz, before anything deep ran */
+	boot_mark(BOOT_CLOCK);
 	/* USER CODE END SysInit */
 
 	/* Initialize all configured peripherals */
@@ -135,27 +236,43 @@ int main(void) {
 	MX_SPI1_Init();
 	MX_SPI2_Init();
 	MX_SPI3_Init();
-	MX_USB_DEVICE_Init();
 	MX_CRC_Init();
 	/* USER CODE BEGIN 2 */
-
-	enable_DWT();
+	itm_init();                /* after SPI3: PB3 goes back to SWO */
+	boot_mark(BOOT_PERIPH);
 
 	g_global_brightness = 100; /* default global dimming       */
 
-	/* 1. Build the base geometry (regular dodecahedron) */
-
-	poly_init_dodecahedron(&poly);
-	/* orient it to stand on the tip */
-	poly_orient_to_vertex(&poly, 0);
-
+	/* 1.-3. geometry (regular dodecahedron), edge mapping, wireframe distances,
+	 *       LED renderer (framebuffer + DMA buffers), see scene.c */
+#ifdef LED_OUTPUT_GPIO
+	/*    (or TIM1 + GPIO DMA, strips in parallel on LED_GPIO_PORT) */
+	if (!scene_init(NULL, LED_GPIO_STRIPS, NULL)) { Error_Handler(); }
+#else
+	const uint8_t strip_cnt = sizeof led_spis / sizeof led_spis[0];
+	if (!scene_init(NULL, strip_cnt, led_spis)) { Error_Handler(); }
+#endif
 
-	/* 2. Build logical-to-physical edge mapping */
-    if (!init_mapping(&poly, USER_MAP, USER_FLIP, EDGE_CNT)) { Error_Handler(); }
+#ifdef BOOT_EARLY_FRAME
+	debug_ui_tick();           /* the first frame goes out now, lit before USB is up */
+	boot_mark(BOOT_FIRST_FRAME);
+#endif
 
-	/* 3. Initialise LED renderer (framebuffer + SPI DMA buffers) */
-	const uint8_t strip_cnt = sizeof led_spis / sizeof led_spis[0];
-	if (!init_render(mapping_get_total_pixels(), strip_cnt, led_spis)) { Error_Handler(); }
+	/* USB after the LEDs: the .ioc leaves this call to user code
+	 * (MX_USB_DEVICE_Init "do not generate function call") */
+	MX_USB_DEVICE_Init();
+	boot_mark(BOOT_USB);
+
+	/* 4. Fixed-cadence frame clock (TIM2) */
+	if (!frame_clock_init(FRAME_CLOCK_FPS)) { Error_Handler(); }
+	idle_init();
+	audio_init();              /* sampling from here, analysed by the "audio" task */
+	supply_init();             /* supply and current by DMA, the "supply" task filters */
+	tasks_init();
+	boot_mark(BOOT_LOOP);
+#ifdef LED_RTOS
+	rtos_start();              /* render, anim and comms tasks from here on, no return */
+#endif
 
 	/* USER CODE END 2 */
 
@@ -163,25 +280,15 @@ int main(void) {
 	/* USER CODE BEGIN WHILE */
 	while (1) {
 
-		if (cur_time - last_serial_send_time > SERIAL_SEND_RATE) {
-			last_serial_send_time = cur_time;
-			flush_usb_buffer();
-		}
-		if (cur_time - last_serial_recieve_time > SERIAL_RECIEVE_RATE) {
-			last_serial_recieve_time = cur_time;
-			usb_comms_process();
-		}
-		if (cur_time - last_debug_ui_update_time > DEBUG_UI_UPDATE_RATE) {
-			last_debug_ui_update_time = cur_time;
-			debug_ui_tick();
-		}
-
+		sched_run();               /* the due tasks, render first (sched.h) */
 		g_global_brightness = 100;
+		cur_time = HAL_GetTick();
+
+		idle_wait();               /* WFI until the next interrupt, none pending */
 
 		/* USER CODE END WHILE */
 
 		/* USER CODE BEGIN 3 */
-		cur_time = HAL_GetTick();
 	}
 	/* USER CODE END 3 */
 }
@@ -22,6 +22,7 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "irq_stats.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -186,11 +187,11 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  IRQ_ENTER(SYSTICK);
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  IRQ_EXIT(SYSTICK);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -207,11 +208,11 @@ void SysTick_Handler(void)
 void DMA1_Stream4_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Stream4_IRQn 0 */
-
+  IRQ_ENTER(SPI2_DMA);
   /* USER CODE END DMA1_Stream4_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi2_tx);
   /* USER CODE BEGIN DMA1_Stream4_IRQn 1 */
-
+  IRQ_EXIT(SPI2_DMA);
   /* USER CODE END DMA1_Stream4_IRQn 1 */
 }
 
@@ -221,11 +222,11 @@ void DMA1_Stream4_IRQHandler(void)
 void DMA1_Stream5_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Stream5_IRQn 0 */
-
+  IRQ_ENTER(SPI3_DMA);
   /* USER CODE END DMA1_Stream5_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi3_tx);
   /* USER CODE BEGIN DMA1_Stream5_IRQn 1 */
-
+  IRQ_EXIT(SPI3_DMA);
   /* USER CODE END DMA1_Stream5_IRQn 1 */
 }
 
@@ -235,11 +236,11 @@ void DMA1_Stream5_IRQHandler(void)
 void OTG_FS_IRQHandler(void)
 {
   /* USER CODE BEGIN OTG_FS_IRQn 0 */
-
+  IRQ_ENTER(OTG_FS);
   /* USER CODE END OTG_FS_IRQn 0 */
   HAL_PCD_IRQHandler(&hpcd_USB_OTG_FS);
   /* USER CODE BEGIN OTG_FS_IRQn 1 */
-
+  IRQ_EXIT(OTG_FS);
   /* USER CODE END OTG_FS_IRQn 1 */
 }
 
@@ -249,11 +250,11 @@ void OTG_FS_IRQHandler(void)
 void DMA2_Stream5_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA2_Stream5_IRQn 0 */
-
+  IRQ_ENTER(SPI1_DMA);
   /* USER CODE END DMA2_Stream5_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi1_tx);
   /* USER CODE BEGIN DMA2_Stream5_IRQn 1 */
-
+  IRQ_EXIT(SPI1_DMA);
   /* USER CODE END DMA2_Stream5_IRQn 1 */
 }
 
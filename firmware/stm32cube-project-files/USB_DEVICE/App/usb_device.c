@@ -27,6 +27,7 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN Includes */
+#include "usb_bulk.h"
 
 /* USER CODE END Includes */
 
@@ -87,6 +88,9 @@ void MX_USB_DEVICE_Init(void)
   }
 
   /* USER CODE BEGIN USB_DEVICE_Init_PostTreatment */
+#ifdef USB_BULK
+  usb_bulk_attach(&hUsbDeviceFS);   /* console + bulk pipe, before the host resets the bus */
+#endif
 
   /* USER CODE END USB_DEVICE_Init_PostTreatment */
 }
@@ -23,6 +23,7 @@
 
 /* USER CODE BEGIN INCLUDE */
 #include "usb_comms.h"
+#include "led_stream.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -136,6 +137,7 @@ static int8_t CDC_Receive_FS(uint8_t* pbuf, uint32_t *Len);
 static int8_t CDC_TransmitCplt_FS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
+static void cdc_arm(uint8_t *buf, uint32_t len);
 
 /* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
 
@@ -165,15 +167,11 @@ static int8_t CDC_Init_FS(void)
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
 
   USBD_CDC_ReceivePacket(&hUsbDeviceFS);
-    /* If the host had already opened the port (DTR = 1) before we reached
-       CONFIGURED, kick the tx‑ring now.  This guarantees that the entire
-       pre‑connect backlog (“Check: V=…”, “Debug interface ready…”, etc.)
-       is flushed exactly once. */
-    extern volatile bool host_open;      /* from usb_comms.c */
-    if (host_open) {
-        extern void flush_usb_buffer(void);
-        flush_usb_buffer();
-    }
+    /* A transfer cut off by a re-enumeration is gone. If the host had
+       already opened the port (DTR = 1) before we reached CONFIGURED, this
+       kicks the tx‑ring now, so the entire pre‑connect backlog (“Check: V=…”,
+       “Debug interface ready…”, etc.) is flushed exactly once. */
+    usb_tx_pipe_done(TX_PIPE_CDC);
 
   return (USBD_OK);
   /* USER CODE END 3 */
@@ -276,9 +274,11 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 	  // hand incoming bytes to our command parser
 	  usb_comms_receive(Buf, *Len);
 
-
-	  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-	  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+	  // next packet: our buffer, straight into the framebuffer while
+	  // streaming, or nowhere until the main loop has shown a frame
+	  uint32_t len  = APP_RX_DATA_SIZE;
+	  uint8_t *next = stream_rx_target(UserRxBufferFS, &len, cdc_arm);
+	  if (next) cdc_arm(next, len);
 	  return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -324,7 +324,6 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
 {
   uint8_t result = USBD_OK;
   /* USER CODE BEGIN 13 */
-  extern void usb_tx_complete_isr(void);
   usb_tx_complete_isr();     /* kick the next chunk */
   UNUSED(Buf);
   UNUSED(Len);
@@ -334,6 +333,13 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/* next OUT packet into buf (led_stream.h StreamArm), one at a time */
+static void cdc_arm(uint8_t *buf, uint32_t len)
+{
+  (void)len;
+  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, buf);
+  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+}
 
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
@@ -63,7 +63,7 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     1U
+#define USBD_MAX_NUM_INTERFACES     3U   /* 1 would do, usb_bulk.c adds interface 2 */
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
@@ -73,6 +73,8 @@
 /*---------- -----------*/
 #define USBD_LPM_ENABLED     0U
 /*---------- -----------*/
+#define USBD_CLASS_BOS_ENABLED     1U   /* usb_bulk.c hands out a BOS descriptor */
+/*---------- -----------*/
 #define USBD_SELF_POWERED     1U
 
 /****************************************/
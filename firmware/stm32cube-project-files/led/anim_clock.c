@@ -0,0 +1,73 @@
+/* --------------------------------------------------------------------------
+ * anim_clock.c – DWT based frame step for the animations
+ * -------------------------------------------------------------------------- */
+#include "anim_clock.h"
+#include "frame_sync.h"    /* shared frame number */
+#include "frame_clock.h"   /* period_us */
+#include "stm32f4xx_hal.h" /* DWT, SystemCoreClock */
+
+static uint32_t last_cyc = 0;
+static uint32_t cyc_rem  = 0;       /* cycles not yet counted as a whole µs */
+static uint32_t dt_us    = 0;
+static uint32_t now_us   = 0;
+static bool     started  = false;
+static uint32_t fixed_us = 0;       /* anim_clock_fixed, 0 = off */
+
+void anim_clock_fixed(uint32_t us)
+{
+    fixed_us = us;
+    started  = false;
+    if (us) now_us = 0;
+}
+
+void anim_clock_tick(void)
+{
+    if (fixed_us) {
+        dt_us   = fixed_us;
+        now_us += fixed_us;
+        return;
+    }
+    uint32_t cyc = DWT->CYCCNT;       /* wraps after 51 s at 84 MHz, frames are shorter */
+    if (!started) {
+        last_cyc = cyc;
+        started  = true;
+        dt_us    = 0;
+        return;
+    }
+    uint32_t cpu = SystemCoreClock / 1000000u;
+    uint32_t d   = cyc - last_cyc + cyc_rem;
+    last_cyc = cyc;
+    dt_us    = d / cpu;
+    cyc_rem  = d - dt_us * cpu;
+    if (dt_us > ANIM_DT_MAX_US) {
+        dt_us   = ANIM_DT_MAX_US;
+        cyc_rem = 0;
+    }
+    if (frame_sync_locked()) {      /* the host's frames: same time on every device */
+        uint32_t t = frame_sync_frame() * frame_clock_stats()->period_us;
+        int32_t  d = (int32_t)(t - now_us);
+        dt_us  = d < 0 ? 0 : (d > ANIM_DT_MAX_US ? ANIM_DT_MAX_US : (uint32_t)d);
+        now_us = t;
+        return;
+    }
+    now_us += dt_us;
+}
+
+uint32_t anim_clock_dt_us(void) { return dt_us; }
+float    anim_clock_dt(void)    { return dt_us * 1e-6f; }
+float    anim_clock_ref(void)   { return dt_us * (ANIM_REF_HZ * 1e-6f); }
+uint32_t anim_clock_us(void)    { return now_us; }
+
+uint32_t anim_rate_take(AnimRate *r, uint32_t per_s)
+{
+    uint64_t acc = r->acc + (uint64_t)per_s * dt_us;
+    uint32_t n   = (uint32_t)(acc / 1000000u);
+    r->acc = (uint32_t)(acc - (uint64_t)n * 1000000u);
+    return n;
+}
+
+uint32_t anim_sim_take(AnimRate *r, uint32_t hz)
+{
+    uint32_t n = anim_rate_take(r, hz);
+    return n > ANIM_SIM_MAX_STEPS ? ANIM_SIM_MAX_STEPS : n;
+}
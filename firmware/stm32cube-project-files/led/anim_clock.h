@@ -0,0 +1,112 @@
+/*
+ * anim_clock.h – one animation time base per frame
+ *
+ * anim_tick() samples the DWT cycle counter once per frame; every animation
+ * (layers and cross-fades included) then moves by the same measured dt
+ * instead of a fixed step per tick, so the frame rate only decides how
+ * smooth the show is, not how fast it runs. The per-tick constants the
+ * effects were tuned with stay as they are: anim_clock_ref() is dt counted
+ * in ticks of ANIM_REF_HZ (1.0 at that rate), AnimRate hands out whole
+ * steps at a fixed rate for the integer phases and event counts.
+ *
+ * While frame_sync.h follows a host, time is the shared frame number times
+ * the period instead, so every device synced to that host is at the same
+ * instant (the first step after locking is cut to ANIM_DT_MAX_US).
+ * anim_clock_fixed() overrides both: every frame one fixed step from 0, what
+ * the bench (bench.h) runs the animations on.
+ *
+ * Stateful effects (shells growing, particles, waves) step their state at a
+ * fixed rate instead, anim_sim_take(): whole steps of 1/hz owed, at most
+ * ANIM_SIM_MAX_STEPS a frame (a heavy frame slows the simulation down for
+ * a moment instead of doubling its cost), and anim_sim_alpha(), how far the
+ * frame is into the next step, to draw between the last state and the next.
+ * The picture then only gets smoother or coarser with the frame rate
+ * (governor, interlacing), the same things happen either way.
+ */
+
+#ifndef _ANIM_CLOCK_H_
+#define _ANIM_CLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"        /* ANIM_DT_MAX_US */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the rate the per-tick speeds were tuned at */
+#define ANIM_REF_HZ             60
+
+/* longest step taken at once (µs): a stall (heap rebuild, flash write, ...)
+ * doesn't make everything jump ahead */
+#ifndef ANIM_DT_MAX_US
+  #define ANIM_DT_MAX_US        100000
+#endif
+
+/* simulation rate for effects without a rate of their own */
+#ifndef ANIM_SIM_HZ
+  #define ANIM_SIM_HZ           120
+#endif
+
+/* simulation steps taken in one frame at most, the rest is dropped */
+#ifndef ANIM_SIM_MAX_STEPS
+  #define ANIM_SIM_MAX_STEPS    8
+#endif
+
+/* integer steps at a fixed rate, remainder carried to the next frame */
+typedef struct {
+    uint32_t acc;           /* µs * per_s left over, < 1e6 */
+} AnimRate;
+
+/**
+ * Once per frame before the animations draw (anim_tick does it)
+ */
+void anim_clock_tick(void);
+
+/**
+ * Step every frame by exactly us, time restarting at 0 (0 = measured again)
+ */
+void anim_clock_fixed(uint32_t us);
+
+/**
+ * This frame's step in µs (0 on the first frame)
+ */
+uint32_t anim_clock_dt_us(void);
+
+/**
+ * Same in seconds
+ */
+float anim_clock_dt(void);
+
+/**
+ * Same in ticks of ANIM_REF_HZ: x per tick → x * anim_clock_ref() this frame
+ */
+float anim_clock_ref(void);
+
+/**
+ * Animation time since boot, µs (wraps after ~71 min)
+ */
+uint32_t anim_clock_us(void);
+
+/**
+ * Whole steps owed this frame at per_s steps per second
+ */
+uint32_t anim_rate_take(AnimRate *r, uint32_t per_s);
+
+/* ticks of ANIM_REF_HZ owed this frame, for "n per tick" constants */
+static inline uint32_t anim_ref_ticks(AnimRate *r) { return anim_rate_take(r, ANIM_REF_HZ); }
+
+/**
+ * Simulation steps of 1/hz to run this frame, at most ANIM_SIM_MAX_STEPS
+ */
+uint32_t anim_sim_take(AnimRate *r, uint32_t hz);
+
+/* how far into the next step the frame is, 0 … 1 (after anim_sim_take) */
+static inline float anim_sim_alpha(const AnimRate *r) { return r->acc * 1e-6f; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ANIM_CLOCK_H_ */
@@ -0,0 +1,296 @@
+/* --------------------------------------------------------------------------
+ * audio.c – windowed FFT, band energies and onsets per block, or the
+ *           host's (audio.h)
+ * -------------------------------------------------------------------------- */
+#include "audio.h"
+
+#ifdef AUDIO_FRAMES
+
+#include <string.h>
+#include "fast_math.h"      /* fm_log2f, fm_powf */
+#include "frame_clock.h"    /* frame_clock_slack_us */
+#include "profiler.h"
+#include "stm32f4xx_hal.h"  /* HAL_GetTick, DWT */
+
+/* published: the frame and when its beat was (phase 0) */
+typedef struct {
+    AudioFrame f;
+    uint32_t   beat_ms;
+} Pub;
+
+static Pub                 pub[2];      /* the source writes into the other */
+static volatile uint8_t    pub_idx;
+static volatile uint32_t   pub_ms;      /* when the newest came */
+static AudioFrame          cur;         /* latched for this frame */
+static uint32_t            cur_onsets;
+static AudioStats          stats;
+
+#ifdef LED_AUDIO_HOST
+static volatile uint32_t   host_ms;     /* last PKT_AUDIO, 0 = none yet */
+static uint16_t            host_beats;
+
+static bool host_fresh(void)
+{
+    return host_ms && HAL_GetTick() - host_ms < AUDIO_STALE_MS;
+}
+#endif
+
+/* the next to fill, carried over from the newest (onsets, tempo) */
+static Pub *pub_next(void)
+{
+    Pub *p = &pub[pub_idx ^ 1];
+    *p = pub[pub_idx];
+    p->f.onset = false;
+    return p;
+}
+
+static void pub_flip(void)
+{
+    pub_ms  = HAL_GetTick();
+    pub_idx ^= 1;
+}
+
+#ifdef LED_AUDIO
+
+#define N       AUDIO_FFT_N
+#define M       (AUDIO_FFT_N / 2)       /* complex points of the half size FFT */
+
+static float    buf[N];                 /* the window, then M complex values in place */
+static float    prev[AUDIO_HOP];        /* the hop before, first half of the window */
+static float    hann[N / 2];            /* symmetric, first half */
+static float    tw_re[M], tw_im[M];     /* e^(-2πik/N) */
+static uint16_t edge[AUDIO_BANDS + 1];  /* band b: bins edge[b] … edge[b+1]-1 */
+
+static float    peak_db[AUDIO_BANDS];
+static float    last_db[AUDIO_BANDS];
+static float    flux_avg;
+static uint32_t onset_ms;
+static float    period_ms;              /* running mean of the onset intervals */
+static bool     deferring;              /* this block counted as deferred */
+
+/* dB full scale: a full scale sine through the Hann window peaks at N / 4 */
+#define DB_FS   (-6.0206f * (float)__builtin_ctz(N / 4))    /* -20 · log10(N / 4) */
+#define HOP_S   ((float)AUDIO_HOP / (float)AUDIO_FS_HZ)
+
+static inline float db10(float p)
+{
+    return 3.0103f * fm_log2f(p + 1e-20f);          /* 10 · log10 */
+}
+
+void audio_init(void)
+{
+    for (uint16_t k = 0; k < M; ++k) {
+        tw_re[k] =  fm_cosf(FM_2PI * k / N);
+        tw_im[k] = -fm_sinf(FM_2PI * k / N);
+    }
+    for (uint16_t n = 0; n < N / 2; ++n) {
+        hann[n] = 0.5f - 0.5f * fm_cosf(FM_2PI * n / N);
+    }
+    /* log spaced, every band at least one bin, no DC */
+    const float lo = (float)AUDIO_F_LO_HZ * N / AUDIO_FS_HZ;
+    for (uint8_t b = 0; b <= AUDIO_BANDS; ++b) {
+        float    f = lo * fm_powf((float)M / lo, (float)b / AUDIO_BANDS);
+        uint16_t k = (uint16_t)(f + 0.5f);
+        if (k < 1) k = 1;
+        if (b && k <= edge[b - 1]) k = edge[b - 1] + 1;
+        edge[b] = k;
+    }
+    if (edge[AUDIO_BANDS] > M) edge[AUDIO_BANDS] = M;   /* tiny N: the top bands shrink */
+    for (uint8_t b = 0; b < AUDIO_BANDS; ++b) {
+        peak_db[b] = last_db[b] = AUDIO_FLOOR_DB;
+    }
+    audio_in_start();
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * M point complex FFT in place, x = re, im interleaved: bit reversed order,
+ * then radix-2 butterflies, twiddles out of the N point table
+ */
+static void fft_cplx(float *x)
+{
+    for (uint16_t i = 1, j = 0; i < M; ++i) {
+        uint16_t bit = M >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            float r = x[2 * i], m = x[2 * i + 1];
+            x[2 * i] = x[2 * j]; x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = r;        x[2 * j + 1] = m;
+        }
+    }
+    for (uint16_t len = 2; len <= M; len <<= 1) {
+        const uint16_t half = len >> 1, step = N / len;
+        for (uint16_t i = 0; i < M; i += len) {
+            for (uint16_t j = 0; j < half; ++j) {
+                const float wr = tw_re[j * step], wi = tw_im[j * step];
+                float *a = &x[2 * (i + j)], *b = &x[2 * (i + j + half)];
+                const float tr = b[0] * wr - b[1] * wi;
+                const float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;  b[1] = a[1] - ti;
+                a[0] += tr;        a[1] += ti;
+            }
+        }
+    }
+}
+
+/* power of real bin k out of the half size transform Z of the even / odd
+ * samples: X[k] = E[k] + W^k · O[k], E and O from Z[k] and conj(Z[M-k]) */
+static inline float bin_power(const float *z, uint16_t k)
+{
+    const uint16_t q  = (uint16_t)((M - k) & (M - 1));
+    const float    zr = z[2 * k], zi = z[2 * k + 1];
+    const float    cr = z[2 * q], ci = -z[2 * q + 1];
+    const float    er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+    const float    or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+    const float    xr = er + tw_re[k] * or_ - tw_im[k] * oi;
+    const float    xi = ei + tw_re[k] * oi + tw_im[k] * or_;
+    return xr * xr + xi * xi;
+}
+
+static void analyse(const uint16_t *s)
+{
+    /* the previous hop first, then this one; the offset out over the whole
+     * window (per hop it would step in the middle) */
+    memcpy(buf, prev, sizeof prev);
+    float sum = 0.0f;
+    for (uint16_t i = 0; i < AUDIO_HOP; ++i) {
+        prev[i] = buf[AUDIO_HOP + i] = ((float)s[i] - 2048.0f) * (1.0f / 2048.0f);
+        sum    += buf[i] + buf[AUDIO_HOP + i];
+    }
+    const float mean = sum * (1.0f / N);
+    for (uint16_t n = 0; n < N / 2; ++n) {
+        buf[n]         = (buf[n] - mean) * hann[n];
+        buf[N - 1 - n] = (buf[N - 1 - n] - mean) * hann[n];
+    }
+
+    /* even samples as real, odd as imaginary parts: buf already is that */
+    fft_cplx(buf);
+
+    Pub        *p    = pub_next();
+    AudioFrame *f    = &p->f;
+    const float fall = AUDIO_PEAK_FALL_DB * HOP_S;
+    float flux = 0.0f, sum_lv = 0.0f;
+    for (uint8_t b = 0; b < AUDIO_BANDS; ++b) {
+        float pw = 0.0f;
+        for (uint16_t k = edge[b]; k < edge[b + 1]; ++k) pw += bin_power(buf, k);
+        const float db = db10(pw) + DB_FS;
+
+        const float dbf = db < AUDIO_FLOOR_DB ? AUDIO_FLOOR_DB : db;    /* rises out of the floor only */
+        if (dbf > last_db[b]) flux += dbf - last_db[b];
+        last_db[b] = dbf;
+
+        float pk = peak_db[b] - fall;
+        if (pk < db) pk = db;
+        if (pk < AUDIO_FLOOR_DB + AUDIO_RANGE_DB) pk = AUDIO_FLOOR_DB + AUDIO_RANGE_DB;
+        peak_db[b] = pk;
+
+        float lv = db < AUDIO_FLOOR_DB ? 0.0f : (db - (pk - AUDIO_RANGE_DB)) * (1.0f / AUDIO_RANGE_DB);
+        lv = lv < 0.0f ? 0.0f : lv > 1.0f ? 1.0f : lv;
+        f->band[b] = lv;
+        sum_lv += lv;
+    }
+    f->level = sum_lv * (1.0f / AUDIO_BANDS);
+    f->flux  = flux;
+
+    /* an onset stands out of the running mean, then a gap; the ones a
+     * beat apart make the tempo */
+    const uint32_t now = HAL_GetTick();
+    if (flux > flux_avg * AUDIO_ONSET_K + 1.0f && now - onset_ms >= AUDIO_ONSET_GAP_MS) {
+        const float ioi = (float)(now - onset_ms);
+        if (ioi >= 60000.0f / AUDIO_BPM_MAX && ioi <= 60000.0f / AUDIO_BPM_MIN) {
+            period_ms = period_ms > 0.0f ? period_ms + (ioi - period_ms) * 0.25f : ioi;
+            f->bpm    = 60000.0f / period_ms;
+        }
+        onset_ms   = now;
+        p->beat_ms = now;
+        f->onsets++;
+    }
+    flux_avg += (flux - flux_avg) * 0.1f;
+    pub_flip();
+}
+
+void audio_tick(void)
+{
+    if (!audio_in_ready()) return;
+
+    uint32_t lost = 0;
+#ifdef LED_AUDIO_HOST
+    if (host_fresh()) {             /* the host's numbers: the block goes unused */
+        (void)audio_in_take(&lost);
+        return;
+    }
+#endif
+    if (frame_clock_slack_us() < AUDIO_SLICE_US) {
+        if (!deferring) stats.deferred++;
+        deferring = true;
+        return;
+    }
+    deferring = false;
+
+    const uint16_t *s = audio_in_take(&lost);
+    if (!s) return;
+    stats.lost += lost;
+
+    const uint32_t t0 = DWT->CYCCNT;
+    PROF_BEGIN(AUDIO);
+    analyse(s);
+    PROF_END(AUDIO);
+    const uint32_t us = (DWT->CYCCNT - t0) / (SystemCoreClock / 1000000u);
+    if (us > stats.max_us) stats.max_us = us;
+    stats.blocks++;
+}
+
+#endif /* LED_AUDIO */
+
+#ifdef LED_AUDIO_HOST
+void audio_host_feat(const ProtoAudioFeat *a)
+{
+    const uint32_t now = HAL_GetTick();
+    Pub        *p = pub_next();
+    AudioFrame *f = &p->f;
+    for (uint8_t b = 0; b < AUDIO_BANDS; ++b) {
+        f->band[b] = a->band[b * 8u / AUDIO_BANDS] * (1.0f / 255.0f);
+    }
+    f->level = a->level * (1.0f / 255.0f);
+    f->flux  = a->flux;
+    if (host_ms) f->onsets += (uint16_t)(a->beats - host_beats);   /* the first sets the count */
+    host_beats = a->beats;
+    f->bpm     = a->bpm_x10 * 0.1f;
+    p->beat_ms = f->bpm > 0.0f ? now - (uint32_t)(a->beat_phase * (60000.0f / 65536.0f) / f->bpm) : now;
+    host_ms    = now ? now : 1;
+    stats.host++;
+    pub_flip();
+}
+#endif
+
+void audio_latch(void)
+{
+    const uint32_t now = HAL_GetTick();
+    const Pub      p   = pub[pub_idx];
+    cur = p.f;
+    if (now - pub_ms >= AUDIO_STALE_MS) {
+        memset(cur.band, 0, sizeof cur.band);
+        cur.level = cur.flux = 0.0f;
+    }
+    /* the phase runs on at the tempo, a few beats past the last one */
+    cur.beat_phase = 0.0f;
+    if (cur.bpm > 0.0f) {
+        const float beats = (float)(now - p.beat_ms) * cur.bpm * (1.0f / 60000.0f);
+        if (beats < AUDIO_BEAT_KEEP) cur.beat_phase = beats - (float)(uint32_t)beats;
+        else                         cur.bpm = 0.0f;
+    }
+    cur.onset  = cur.onsets != cur_onsets;
+    cur_onsets = cur.onsets;
+}
+
+const AudioFrame *audio_frame(void)
+{
+    return &cur;
+}
+
+const AudioStats *audio_stats(void)
+{
+    return &stats;
+}
+
+#endif /* AUDIO_FRAMES */
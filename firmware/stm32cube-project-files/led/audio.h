@@ -0,0 +1,164 @@
+/*
+ * audio.h – band energies and beats for the animations (LED_AUDIO, LED_AUDIO_HOST)
+ *
+ * Every AUDIO_HOP samples from audio_in.h, AUDIO_FFT_N of them (the new hop
+ * after the previous one) are Hann windowed and go through a real FFT, in
+ * float on the FPU: a half size complex radix-2 transform and a split pass.
+ * The bins are summed into AUDIO_BANDS log spaced bands between
+ * AUDIO_F_LO_HZ and Nyquist. Each band is kept in dB against its own
+ * decaying peak, so band[] stays 0 … 1 whatever the input level, and bands
+ * below AUDIO_FLOOR_DB (dB full scale) read 0: silence does not gain up to
+ * the noise. The rise of the bands from block to block (spectral flux) is
+ * an onset once it stands AUDIO_ONSET_K over its running mean, at most one
+ * per AUDIO_ONSET_GAP_MS.
+ *
+ * The work is one block per hop in audio_tick(), a main loop task below the
+ * frame: it starts only while the frame slot has AUDIO_SLICE_US left, so a
+ * block is put off rather than a frame late. A block not analysed before
+ * the DMA fills it again is lost and counted. The AUDIO profiler zone has
+ * its time (~0.3 ms at 512 points), "audio" prints the counts.
+ *
+ * Onsets AUDIO_BPM_MIN … AUDIO_BPM_MAX apart set the tempo (a running
+ * mean of the intervals), the beat phase runs on from the last onset at it.
+ *
+ * LED_AUDIO_HOST takes the same numbers from PKT_AUDIO instead, computed by
+ * the app (app/audio_sync.py) from the show PC's sound: no sampling, no DSP
+ * here, only the packet's copy. With both, the packets win while they come
+ * and the local analysis is skipped; either source silent for
+ * AUDIO_STALE_MS reads as silence.
+ *
+ * Animations read audio_frame(): latched once per frame by audio_latch() at
+ * the frame's start, the same numbers for the whole frame, onset true in
+ * exactly one frame per beat, the phase carried on to the frame's time.
+ */
+
+#ifndef _AUDIO_H_
+#define _AUDIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "audio_in.h"
+#include "proto.h"          /* ProtoAudioFeat */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef AUDIO_BANDS
+  #define AUDIO_BANDS           8
+#endif
+#ifndef AUDIO_F_LO_HZ
+  #define AUDIO_F_LO_HZ         40
+#endif
+/* dB a band spans below its peak, the peak's fall in dB per second */
+#ifndef AUDIO_RANGE_DB
+  #define AUDIO_RANGE_DB        30.0f
+#endif
+#ifndef AUDIO_PEAK_FALL_DB
+  #define AUDIO_PEAK_FALL_DB    6.0f
+#endif
+#ifndef AUDIO_FLOOR_DB
+  #define AUDIO_FLOOR_DB        -70.0f
+#endif
+#ifndef AUDIO_ONSET_K
+  #define AUDIO_ONSET_K         1.8f
+#endif
+#ifndef AUDIO_ONSET_GAP_MS
+  #define AUDIO_ONSET_GAP_MS    120
+#endif
+/* tempo range, beats after the last onset the phase runs on for */
+#ifndef AUDIO_BPM_MIN
+  #define AUDIO_BPM_MIN         60
+#endif
+#ifndef AUDIO_BPM_MAX
+  #define AUDIO_BPM_MAX         200
+#endif
+#ifndef AUDIO_BEAT_KEEP
+  #define AUDIO_BEAT_KEEP       4
+#endif
+/* no new numbers for this long: silence (and the local analysis back) */
+#ifndef AUDIO_STALE_MS
+  #define AUDIO_STALE_MS        500
+#endif
+/* frame slot a block needs left to start */
+#ifndef AUDIO_SLICE_US
+  #define AUDIO_SLICE_US        1000
+#endif
+
+typedef struct {
+    float    band[AUDIO_BANDS];  /* 0 … 1, low to high, against each band's peak */
+    float    level;              /* mean of the bands                         */
+    float    flux;               /* dB the bands rose in the last block       */
+    bool     onset;              /* a beat since the previous frame           */
+    uint32_t onsets;             /* since start                               */
+    float    bpm;                /* 0: no tempo (yet)                         */
+    float    beat_phase;         /* 0 … 1 through the beat, at the frame      */
+} AudioFrame;
+
+typedef struct {
+    uint32_t blocks;             /* analysed                                  */
+    uint32_t lost;               /* filled over before their turn             */
+    uint32_t deferred;           /* waited for a frame slot with room         */
+    uint32_t max_us;             /* longest analysis                          */
+    uint32_t host;               /* PKT_AUDIO taken                           */
+} AudioStats;
+
+/* either source: audio_frame() for the animations */
+#if defined(LED_AUDIO) || defined(LED_AUDIO_HOST)
+  #define AUDIO_FRAMES
+#endif
+
+#ifdef LED_AUDIO
+
+/**
+ * Tables, then start sampling. Once, before the main loop.
+ */
+void audio_init(void);
+
+/**
+ * Main loop: analyses the newest block if there is one and the slot has room
+ */
+void audio_tick(void);
+
+#else
+
+#define audio_init()    ((void)0)
+#define audio_tick()    ((void)0)
+
+#endif /* LED_AUDIO */
+
+#ifdef LED_AUDIO_HOST
+
+/**
+ * PKT_AUDIO: the host's numbers, published as they are
+ */
+void audio_host_feat(const ProtoAudioFeat *a);
+
+#endif
+
+#ifdef AUDIO_FRAMES
+
+/**
+ * Frame start: take over the newest numbers for audio_frame()
+ */
+void audio_latch(void);
+
+/**
+ * What the animations see this frame
+ */
+const AudioFrame *audio_frame(void);
+
+const AudioStats *audio_stats(void);
+
+#else
+
+#define audio_latch()   ((void)0)
+
+#endif /* AUDIO_FRAMES */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_H_ */
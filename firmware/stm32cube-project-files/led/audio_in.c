@@ -0,0 +1,121 @@
+/* --------------------------------------------------------------------------
+ * audio_in.c – ADC1 sampled by TIM3, DMA2 stream 4 circular (audio_in.h)
+ * -------------------------------------------------------------------------- */
+#include "audio_in.h"
+
+#ifdef LED_AUDIO
+
+#include "stm32f4xx_hal.h"
+#include "irq_stats.h"
+
+_Static_assert(AUDIO_ADC_CH <= 9, "AUDIO_ADC_CH: 0 … 9 (PA0 … PA7, PB0, PB1)");
+_Static_assert((AUDIO_FFT_N & (AUDIO_FFT_N - 1)) == 0 && AUDIO_FFT_N >= 64 && AUDIO_FFT_N <= 2048,
+               "AUDIO_FFT_N: a power of two, 64 … 2048");
+
+#define AUDIO_DMA        DMA2_Stream4
+/* all interrupt flags of stream 4 (FEIF, DMEIF, TEIF, HTIF, TCIF) in HISR */
+#define AUDIO_DMA_FLAGS  0x3Du
+
+static uint16_t          samples[2 * AUDIO_HOP];
+static volatile uint32_t filled;        /* halves filled since start, ISR side */
+static uint32_t          taken;         /* filled when the last one was taken */
+
+/* TIM3 runs off APB1, doubled when APB1 is divided (84 MHz here) */
+static uint32_t tim3_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE1) ? 2 * pclk : pclk;
+}
+
+static void pin_analog(void)
+{
+#if AUDIO_ADC_CH < 8
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    GPIOA->MODER |= 3u << (2 * AUDIO_ADC_CH);
+#else
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    GPIOB->MODER |= 3u << (2 * (AUDIO_ADC_CH - 8));
+#endif
+}
+
+void audio_in_start(void)
+{
+    audio_in_stop();
+    pin_analog();
+    __HAL_RCC_ADC1_CLK_ENABLE();
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    /* ADC clock PCLK2 / 4 (21 MHz), 84 cycles sampling: 5 µs a conversion,
+     * a high impedance source settles */
+    ADC->CCR    = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0;
+    ADC1->CR1   = 0;                                        /* 12 bit, no scan */
+    ADC1->SMPR2 = 4u << (3 * AUDIO_ADC_CH);                 /* channels 0 … 9 are in SMPR2 */
+    ADC1->SQR1  = 0;                                        /* one conversion */
+    ADC1->SQR3  = AUDIO_ADC_CH;
+
+    AUDIO_DMA->PAR  = (uint32_t)&ADC1->DR;
+    AUDIO_DMA->M0AR = (uint32_t)samples;
+    AUDIO_DMA->NDTR = 2 * AUDIO_HOP;
+    AUDIO_DMA->FCR  = 0;                                    /* direct mode */
+    DMA2->HIFCR     = AUDIO_DMA_FLAGS;
+    AUDIO_DMA->CR   = (0u << DMA_SxCR_CHSEL_Pos)            /* channel 0: ADC1 */
+                    | DMA_SxCR_PL_0 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0
+                    | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE
+                    | DMA_SxCR_EN;
+
+    /* below the strip DMAs (2): a half is read a whole hop later */
+    HAL_NVIC_SetPriority(DMA2_Stream4_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream4_IRQn);
+
+    /* conversions on TIM3's TRGO, rising edge */
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_DDS
+              | ADC_CR2_EXTEN_0 | (8u << ADC_CR2_EXTSEL_Pos);   /* 1000: TIM3 TRGO */
+
+    filled = taken = 0;
+    TIM3->CR1  = 0;
+    TIM3->PSC  = 0;
+    TIM3->ARR  = (tim3_clock() + AUDIO_FS_HZ / 2) / AUDIO_FS_HZ - 1;
+    TIM3->CNT  = 0;
+    TIM3->CR2  = TIM_CR2_MMS_1;                             /* update → TRGO */
+    TIM3->EGR  = TIM_EGR_UG;
+    TIM3->CR1  = TIM_CR1_CEN;
+}
+
+void audio_in_stop(void)
+{
+    TIM3->CR1 = 0;
+    ADC1->CR2 = 0;
+    AUDIO_DMA->CR &= ~DMA_SxCR_EN;
+    while (AUDIO_DMA->CR & DMA_SxCR_EN) { }
+    HAL_NVIC_DisableIRQ(DMA2_Stream4_IRQn);
+    DMA2->HIFCR = AUDIO_DMA_FLAGS;
+}
+
+bool audio_in_ready(void)
+{
+    return filled != taken;
+}
+
+const uint16_t *audio_in_take(uint32_t *lost)
+{
+    uint32_t f = filled;
+    if (f == taken) return NULL;
+    if (lost) *lost = f - taken - 1;
+    taken = f;
+    /* odd counts ended with the half-transfer: the first half is the newest */
+    return &samples[(f & 1u) ? 0 : AUDIO_HOP];
+}
+
+void DMA2_Stream4_IRQHandler(void)
+{
+    IRQ_ENTER(AUDIO_DMA);
+    uint32_t isr = DMA2->HISR & AUDIO_DMA_FLAGS;
+    DMA2->HIFCR = isr;
+    /* both at once (held off a whole hop): counted as two, the parity says
+     * which half is the newest */
+    filled += !!(isr & DMA_HISR_HTIF4) + !!(isr & DMA_HISR_TCIF4);
+    IRQ_EXIT(AUDIO_DMA);
+}
+
+#endif /* LED_AUDIO */
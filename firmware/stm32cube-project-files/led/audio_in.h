@@ -0,0 +1,69 @@
+/*
+ * audio_in.h – microphone / line input sampled by ADC1 (LED_AUDIO)
+ *
+ * TIM3's update event triggers a conversion every 1 / AUDIO_FS_HZ, DMA2
+ * stream 4 moves the 12 bit samples into a circular buffer of two halves,
+ * AUDIO_HOP samples each. A half-transfer or transfer-complete interrupt
+ * marks that half ready; audio.c takes it from the main loop and has until
+ * the DMA comes round again (one hop, 16 ms at the defaults) before it is
+ * overwritten, which counts as lost.
+ *
+ * Pin: ADC1 channel AUDIO_ADC_CH, PA0 … PA7 for 0 … 7, PB0 / PB1 for 8 / 9.
+ * The signal wants biasing to mid supply (an electret module's output, or
+ * a line input through a capacitor onto a 2 × 10k divider), the offset is
+ * taken out per block.
+ */
+
+#ifndef _AUDIO_IN_H_
+#define _AUDIO_IN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* sample rate, Hz */
+#ifndef AUDIO_FS_HZ
+  #define AUDIO_FS_HZ       16000
+#endif
+/* FFT length, a power of two; blocks overlap by half */
+#ifndef AUDIO_FFT_N
+  #define AUDIO_FFT_N       512
+#endif
+#define AUDIO_HOP           (AUDIO_FFT_N / 2)
+/* ADC1 input channel */
+#ifndef AUDIO_ADC_CH
+  #define AUDIO_ADC_CH      1
+#endif
+
+#ifdef LED_AUDIO
+
+/**
+ * Start sampling (ADC1, TIM3, DMA2 stream 4)
+ */
+void audio_in_start(void);
+
+void audio_in_stop(void);
+
+/**
+ * A half was filled that audio_in_take() has not handed out yet
+ */
+bool audio_in_ready(void);
+
+/**
+ * The newest filled half, AUDIO_HOP samples (0 … 4095), valid until the
+ * DMA comes round to it again; NULL if none is new
+ * @param lost  halves that were filled over before anyone took them
+ */
+const uint16_t *audio_in_take(uint32_t *lost);
+
+#endif /* LED_AUDIO */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_IN_H_ */
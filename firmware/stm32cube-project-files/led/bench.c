@@ -0,0 +1,242 @@
+/* --------------------------------------------------------------------------
+ * bench.c – PKT_BENCH, the registry timed frame by frame from a fixed start
+ * -------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "bench.h"
+#include "profiler.h"        /* ENCODE, SUBMIT sums */
+#include "led_anim.h"        /* registry, anim_tick */
+#include "led_render.h"      /* frame seq / shown, g_global_brightness */
+#include "led_rng.h"         /* rng_seed, RNG_SEED */
+#include "led_governor.h"    /* gov_force */
+#include "led_debug.h"       /* debug_change_mode: back to the selected mode */
+#include "anim_clock.h"      /* anim_clock_fixed */
+#include "stack_mon.h"       /* stack_repaint, the peak per animation */
+#include "frame_clock.h"     /* period_us */
+#include "usb_packet.h"      /* usb_packet_send */
+#include "usb_device.h"      /* USBD_UsrLog */
+#include "stm32f4xx_hal.h"   /* DWT, SystemCoreClock */
+
+#ifdef LED_PROFILE
+
+extern uint8_t _end;             /* linker script: heap start */
+extern void *_sbrk(ptrdiff_t incr);   /* sysmem.c */
+
+#define BENCH_NAME          12u
+#define BENCH_REC_SIZE      (3u + BENCH_NAME + 2u + 48u + 16u)
+#define BENCH_WAIT_TICKS    8u          /* a frame never shown (DMA error): dma 0 */
+
+enum { M_ANIM, M_ENCODE, M_DMA, M_COUNT };
+
+static const char *const metric_names[M_COUNT] = { "anim", "encode", "dma" };
+
+static struct {
+    bool      on;
+    bool      begun;            /* the first animation set up, from bench_tick */
+    bool      waiting;          /* the last frame's DMA still running */
+    uint8_t   anim;
+    uint8_t   wait_ticks;
+    uint16_t  frames;
+    uint16_t  frame;
+    uint32_t  wait_seq;
+    uint32_t  wait_cyc;
+    uint32_t *samples;          /* M_COUNT × frames */
+    uint32_t  seed_was;
+    int8_t    gov_was;          /* -1: automatic */
+} run;
+
+static uint8_t *put16(uint8_t *p, uint32_t v)
+{
+    uint16_t h = (uint16_t)v;
+    memcpy(p, &h, 2);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+    return p + 4;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void send_header(void)
+{
+    static const char build[] = __DATE__ " " __TIME__;
+    uint8_t  b[17 + sizeof build];
+    uint8_t *p = b;
+    *p++ = BENCH_VERSION;
+    *p++ = 0xFF;
+    *p++ = anim_count();
+    p = put16(p, run.frames);
+    p = put32(p, RNG_SEED);
+    p = put32(p, frame_clock_stats()->period_us);
+    p = put32(p, SystemCoreClock);
+    memcpy(p, build, sizeof build - 1);
+    p += sizeof build - 1;
+    usb_packet_send(PKT_BENCH, b, (uint8_t)(p - b));
+}
+
+static void report(uint8_t i)
+{
+    const Animation *a = anim_get(i);
+    uint8_t  b[BENCH_REC_SIZE];
+    uint8_t *p = b;
+    *p++ = BENCH_VERSION;
+    *p++ = i;
+    *p++ = anim_count();
+    memset(p, 0, BENCH_NAME);
+    strncpy((char *)p, a->name, BENCH_NAME);
+    p += BENCH_NAME;
+    p = put16(p, run.frames);
+
+    const uint32_t us = SystemCoreClock / 1000000u;
+    const uint16_t n  = run.frames;
+    char line[160];
+    int  k = snprintf(line, sizeof line, "bench: %-10s", a->name);
+    for (uint8_t m = 0; m < M_COUNT; ++m) {
+        uint32_t *v = &run.samples[m * n];
+        qsort(v, n, sizeof *v, cmp_u32);
+        uint32_t med = v[n / 2u];
+        uint32_t p99 = v[(n * 99u + 99u) / 100u - 1u];
+        p = put32(p, v[0]);
+        p = put32(p, med);
+        p = put32(p, p99);
+        p = put32(p, v[n - 1u]);
+        k += snprintf(line + k, sizeof line - (size_t)k, " %s %lu/%lu/%lu us", metric_names[m],
+                      (unsigned long)(med / us), (unsigned long)(p99 / us),
+                      (unsigned long)(v[n - 1u] / us));
+    }
+    uint32_t stack   = stack_main_peak();
+    uint32_t irq     = stack_irq_peak();
+    uint32_t scratch = a->scratch ? (uint32_t)a->scratch() : 0;
+    uint32_t heap    = (uint32_t)((uint8_t *)_sbrk(0) - &_end);
+    p = put32(p, stack);
+    p = put32(p, scratch);
+    p = put32(p, heap);
+    p = put32(p, irq);
+    USBD_UsrLog("%s, stack %lu + irq %lu, scratch %lu, heap %lu\n", line, (unsigned long)stack,
+                (unsigned long)irq, (unsigned long)scratch, (unsigned long)heap);
+    usb_packet_send(PKT_BENCH, b, (uint8_t)(p - b));
+}
+
+/* every animation from the same start: seed, time 0, quality 0, no layers */
+static void begin_anim(uint8_t i)
+{
+    rng_seed(RNG_SEED);
+    anim_release();
+    anim_clock_fixed(frame_clock_stats()->period_us);
+    anim_select(i);
+    gov_force(0);
+    g_global_brightness = 255;
+    run.anim  = i;
+    run.frame = 0;
+    stack_repaint();
+}
+
+static void finish(void)
+{
+    free(run.samples);
+    run.samples = NULL;
+    run.on      = false;
+    run.waiting = false;
+    rng_seed(run.seed_was);
+    anim_release();
+    anim_clock_fixed(0);
+    gov_force(run.gov_was);
+    debug_change_mode(debug_mode());
+}
+
+bool bench_start(uint16_t frames)
+{
+    if (run.on) return false;
+    if (!frames) frames = BENCH_FRAMES;
+    if (frames > BENCH_FRAMES_MAX) frames = BENCH_FRAMES_MAX;
+    run.samples = malloc(sizeof *run.samples * M_COUNT * frames);
+    if (!run.samples) return false;
+
+    run.frames   = frames;
+    run.begun    = false;
+    run.waiting  = false;
+    run.seed_was = rng_seed_get();
+    run.gov_was  = gov_forced() ? (int8_t)gov_level() : -1;
+    run.on       = true;
+    send_header();
+    return true;
+}
+
+void bench_stop(void)
+{
+    if (run.on) finish();
+}
+
+bool bench_running(void)
+{
+    return run.on;
+}
+
+bool bench_tick(void)
+{
+    if (!run.on) return false;
+    if (!run.begun) {                   /* painted from the depth the frames run at */
+        run.begun = true;
+        begin_anim(0);
+    }
+
+    if (run.waiting) {
+        uint32_t end  = 0;
+        uint32_t seen = render_frame_shown(&end);
+        bool     out  = (int32_t)(seen - run.wait_seq) >= 0;
+        if (!out && ++run.wait_ticks < BENCH_WAIT_TICKS) return true;
+        run.samples[M_DMA * run.frames + run.frame - 1u] = out ? end - run.wait_cyc : 0;
+        run.waiting = false;
+    }
+
+    if (run.frame == run.frames) {
+        report(run.anim);
+        if (run.anim + 1u >= anim_count()) {
+            finish();
+            USBD_UsrLog("bench: done\n");
+            return true;
+        }
+        begin_anim((uint8_t)(run.anim + 1u));
+    }
+
+    const ProfStats *enc = prof_stats(PROF_ENCODE);
+    const ProfStats *sub = prof_stats(PROF_SUBMIT);
+    uint64_t enc0 = enc->sum_cyc, sub0 = sub->sum_cyc;
+    uint32_t seq0 = render_frame_seq();
+
+    uint32_t c0 = DWT->CYCCNT;
+    anim_tick();
+    uint32_t c1 = DWT->CYCCNT;
+
+    uint32_t *s = run.samples + run.frame;
+    s[M_ANIM   * run.frames] = (c1 - c0) - (uint32_t)(sub->sum_cyc - sub0);
+    s[M_ENCODE * run.frames] = (uint32_t)(enc->sum_cyc - enc0);
+    s[M_DMA    * run.frames] = 0;
+    uint32_t seq1 = render_frame_seq();
+    if (seq1 != seq0) {                 /* submitted: time it out on the next tick */
+        run.waiting    = true;
+        run.wait_ticks = 0;
+        run.wait_seq   = seq1;
+        run.wait_cyc   = c1;
+    }
+    ++run.frame;
+    return true;
+}
+
+#else /* !LED_PROFILE */
+
+bool bench_start(uint16_t frames) { (void)frames; return false; }
+void bench_stop(void)             { }
+bool bench_running(void)          { return false; }
+bool bench_tick(void)             { return false; }
+
+#endif /* LED_PROFILE */
@@ -0,0 +1,81 @@
+/*
+ * bench.h – every animation under the same conditions, numbers for the app
+ *
+ * "bench [frames]" on the console (BENCH_FRAMES without a count, "bench
+ * stop" ends it early) runs the registry one animation after the other, each
+ * for that many frames from the same start: RNG_SEED, quality level 0
+ * (gov_force), full brightness, layers off, and animation time stepped by
+ * exactly one frame period a frame (anim_clock_fixed) instead of measured.
+ * Two runs of the same firmware draw the same frames, so what changes
+ * between two firmware revisions is the code, not the show.
+ *
+ * Per frame, in DWT cycles:
+ *   anim    anim_tick() without what it spends in render_submit()
+ *   encode  the ENCODE profiler zone inside anim_tick() (pixels into the SPI
+ *           buffers; what LED_RENDER_PIPELINE encodes from the DMA interrupt
+ *           lands in dma)
+ *   dma     from anim_tick()'s return to the frame's DMA completion
+ *           (render_frame_shown), 0 for a frame the renderer skipped
+ * The next frame waits for the last one to be out, one frame a frame clock
+ * tick. Needs LED_PROFILE (the zone sums).
+ *
+ * Each animation is reported as a PKT_BENCH packet (usb_packet.h), after a
+ * header packet, and as a line of text. Payloads, little endian:
+ *
+ *   header:    version u8 (BENCH_VERSION) | 0xFF | count u8 | frames u16
+ *              seed u32 | period_us u32 | cpu_hz u32 | build (text, rest)
+ *   animation: version u8 | index u8 | count u8 | name char[12] | frames u16
+ *              { anim, encode, dma } × { min, median, p99, max } u32 cycles
+ *              stack_peak u32 | scratch u32 | heap_peak u32 | irq_peak u32
+ *
+ * stack_peak is the deepest the main loop's stack went while the animation
+ * ran, bytes below _estack, irq_peak the same for the interrupt stack (both
+ * painted before each one, stack_mon.h; 0 where that can't be done, irq_peak
+ * also without STACK_IRQ_BYTES). scratch is the animation's arena block,
+ * heap_peak the newlib break above _end once it ran (it never moves back, the
+ * bench's own sample buffer, 12 bytes a frame, included). app/bench.py
+ * keeps the reports per firmware revision and compares two of them.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_VERSION           2
+
+#ifndef BENCH_FRAMES
+  #define BENCH_FRAMES          240
+#endif
+#define BENCH_FRAMES_MAX        1200
+
+/**
+ * Start a run, frames per animation (0 = BENCH_FRAMES). false if one is
+ * running or the sample buffer does not fit.
+ */
+bool bench_start(uint16_t frames);
+
+/**
+ * End a run early, nothing more is reported
+ */
+void bench_stop(void);
+
+bool bench_running(void);
+
+/**
+ * Once per frame clock tick, before anything else draws: true while a run
+ * owns the frame (debug_ui_tick then draws nothing itself).
+ */
+bool bench_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BENCH_H_ */
@@ -0,0 +1,166 @@
+/* --------------------------------------------------------------------------
+ * blackbox.c – ring of per frame zone times, held around a spike
+ * -------------------------------------------------------------------------- */
+#include "blackbox.h"
+
+#ifdef LED_BLACKBOX
+
+#include <stdio.h>
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#include "frame_clock.h"     /* period_us */
+#include "trace.h"           /* trace_freeze, trace_dump_start */
+#include "usb_comms.h"       /* USBD_UsrLog(), usb_tx_room() */
+
+#define LINE_ROOM       (32 + 6 * PROF_ZONE_COUNT + 16)
+
+static const char *const zone_name[PROF_ZONE_COUNT] = {
+#define BB_NAME(name, budget) #name,
+    PROF_ZONES(BB_NAME)
+#undef BB_NAME
+};
+
+typedef enum {
+    BB_ARMED,       /* recording, waiting for a spike  */
+    BB_AFTER,       /* recording the frames after it   */
+    BB_HELD,        /* capture kept until it is dumped */
+    BB_DUMPING,
+} BbState;
+
+static BbFrame           ring[BB_FRAMES];
+static uint32_t          head;           /* frames written, ring[head % BB_FRAMES] is next */
+static uint16_t          acc[PROF_ZONE_COUNT];
+static volatile BbState  state;
+static uint32_t          spike_at;       /* head of the spike frame, UINT32_MAX for none */
+static uint32_t          spike_us = BB_SPIKE_US;
+static uint32_t          spikes;         /* captures since boot */
+static bool              note;           /* #bbspike# still to print */
+
+/* dump progress */
+static uint32_t          dump_pos, dump_end;
+static bool              header_out;
+
+static uint16_t sat16(uint32_t v)
+{
+    return (uint16_t)(v > UINT16_MAX ? UINT16_MAX : v);
+}
+
+void bb_zone(ProfZone z, uint32_t us)
+{
+    acc[z] = sat16(acc[z] + us);
+}
+
+void bb_frame(uint32_t frame, uint32_t work_us, bool late)
+{
+    if (state >= BB_HELD) {
+        memset(acc, 0, sizeof acc);
+        return;
+    }
+    BbFrame *f = &ring[head % BB_FRAMES];
+    f->frame   = frame;
+    f->ms      = HAL_GetTick();
+    f->work_us = sat16(work_us);
+    f->late    = late;
+    memcpy(f->zone_us, acc, sizeof acc);
+    memset(acc, 0, sizeof acc);
+
+    if (state == BB_ARMED) {
+        if (spike_us ? work_us > spike_us : late) {
+            spike_at = head;
+            state    = BB_AFTER;
+        }
+    } else if (head - spike_at >= BB_POST) {
+        state = BB_HELD;
+        trace_freeze();              /* the events of the same frames */
+        spikes++;
+        note  = true;
+    }
+    head++;
+}
+
+void bb_set_spike_us(uint32_t us)
+{
+    spike_us = us;
+}
+
+uint32_t bb_spike_us(void)
+{
+    return spike_us;
+}
+
+void bb_dump_start(void)
+{
+    if (state == BB_DUMPING) return;
+    if (state == BB_ARMED) spike_at = UINT32_MAX;   /* on request, no spike in it */
+    if (state != BB_HELD)  trace_freeze();
+    state      = BB_DUMPING;
+    dump_end   = head;
+    dump_pos   = (head > BB_FRAMES) ? head - BB_FRAMES : 0;
+    header_out = false;
+}
+
+void bb_arm(void)
+{
+    if (state == BB_DUMPING) return;
+    head     = 0;
+    note     = false;
+    state    = BB_ARMED;
+    trace_thaw();
+}
+
+void bb_report(void)
+{
+    static const char *const name[] = { "armed", "after a spike", "holding a spike", "dumping" };
+    USBD_UsrLog("bb: %s, spike over %lu us%s, %lu caught\n", name[state],
+                (unsigned long)spike_us, spike_us ? "" : " (late frames)",
+                (unsigned long)spikes);
+}
+
+void bb_tick(void)
+{
+    if (note && usb_tx_room() > LINE_ROOM) {
+        const BbFrame *f = &ring[spike_at % BB_FRAMES];
+        USBD_UsrLog("#bbspike# f=%lu us=%lu#",
+                    (unsigned long)f->frame, (unsigned long)f->work_us);
+        note = false;
+    }
+    if (state != BB_DUMPING) return;
+
+    if (!header_out) {
+        if (usb_tx_room() <= 2 * LINE_ROOM) return;
+        char   line[LINE_ROOM];
+        size_t off = 0;
+        for (uint8_t z = 0; z < PROF_ZONE_COUNT; ++z) {
+            off += snprintf(line + off, sizeof line - off, "%s%s", z ? "," : "", zone_name[z]);
+        }
+        uint32_t spike = (spike_at == UINT32_MAX) ? 0 : ring[spike_at % BB_FRAMES].frame;
+        USBD_UsrLog("#bb# n=%lu spike=%lu thr=%lu period=%lu zones=%s#",
+                    (unsigned long)(dump_end - dump_pos), (unsigned long)spike,
+                    (unsigned long)spike_us,
+                    (unsigned long)frame_clock_stats()->period_us, line);
+        header_out = true;
+    }
+
+    while (dump_pos < dump_end && usb_tx_room() > LINE_ROOM) {
+        const BbFrame *f = &ring[dump_pos++ % BB_FRAMES];
+        char   line[LINE_ROOM];
+        size_t off = snprintf(line, sizeof line, "#bbf %lu %lu %u %u", (unsigned long)f->frame,
+                              (unsigned long)f->ms, f->work_us, f->late);
+        for (uint8_t z = 0; z < PROF_ZONE_COUNT; ++z) {
+            off += snprintf(line + off, sizeof line - off, " %u", f->zone_us[z]);
+        }
+        USBD_UsrLog("%s#", line);
+    }
+
+    if (dump_pos >= dump_end && usb_tx_room() > LINE_ROOM) {
+        USBD_UsrLog("#endbb#");
+        head  = 0;                   /* the next capture starts clean */
+        note  = false;
+        state = BB_ARMED;
+#ifdef LED_TRACE
+        trace_dump_start();          /* the events next, it thaws the ring */
+#endif
+    }
+}
+
+#endif /* LED_BLACKBOX */
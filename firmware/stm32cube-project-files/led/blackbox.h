@@ -0,0 +1,109 @@
+/*
+ * blackbox.h – the frames around a stutter, kept for the app (LED_BLACKBOX)
+ *
+ * A ring of the last BB_FRAMES frames: frame number, uptime, frame time
+ * (frame_clock.h work_us) and how long each profiler zone took in it. A
+ * frame over the threshold (BB_SPIKE_US, "bb <us>" on the console, 0 = a
+ * frame that ran past its slot) is the spike: BB_POST more frames are
+ * recorded, then the ring is held, the BB_FRAMES - BB_POST - 1 before it
+ * included, and the trace ring (LED_TRACE) frozen with it. "#bbspike#"
+ * tells the console; "bb dump" streams it:
+ *
+ *   #bb# n=<frames> spike=<frame> thr=<us> period=<us> zones=<ANIM,...>#
+ *   #bbf <frame> <ms> <work_us> <late> <µs per zone>...#   (oldest first)
+ *   #endbb#
+ *
+ * followed by the trace dump, app/blackbox.py saves both to logs/. The box
+ * arms again once the dump is out ("bb arm" drops a capture unsent).
+ *
+ * Zone times need LED_PROFILE (zeros without); work that runs between two
+ * frames (USB, SLEEP) counts to the frame after it.
+ */
+
+#ifndef _BLACKBOX_H_
+#define _BLACKBOX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "profiler.h"       /* ProfZone */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef BB_FRAMES
+  #define BB_FRAMES         64
+#endif
+
+/* frames recorded after the spike */
+#ifndef BB_POST
+  #define BB_POST           16
+#endif
+
+/* frame time that counts as a spike, µs; 0: a frame late for its slot */
+#ifndef BB_SPIKE_US
+  #define BB_SPIKE_US       0
+#endif
+
+typedef struct {
+    uint32_t frame;
+    uint32_t ms;                        /* HAL_GetTick() at its end */
+    uint16_t work_us;
+    uint8_t  late;
+    uint8_t  _pad;
+    uint16_t zone_us[PROF_ZONE_COUNT];  /* saturating */
+} BbFrame;
+
+#ifdef LED_BLACKBOX
+
+/**
+ * Frame clock: the frame just ended (frame_clock_end)
+ */
+void bb_frame(uint32_t frame, uint32_t work_us, bool late);
+
+/**
+ * Profiler: a zone call of this frame (prof_end)
+ */
+void bb_zone(ProfZone z, uint32_t us);
+
+/**
+ * Threshold in µs, 0 = late frames
+ */
+void     bb_set_spike_us(uint32_t us);
+uint32_t bb_spike_us(void);
+
+/**
+ * Stream the held capture, or what the ring has now when nothing was
+ * caught ("bb dump")
+ */
+void bb_dump_start(void);
+
+/**
+ * Drop a held capture and wait for the next spike ("bb arm")
+ */
+void bb_arm(void);
+
+/**
+ * Console status line ("bb")
+ */
+void bb_report(void);
+
+/**
+ * Main loop: the #bbspike# note, the dump lines as the USB TX ring has room
+ */
+void bb_tick(void);
+
+#else
+
+#define bb_frame(frame, work_us, late)  ((void)0)
+#define bb_zone(z, us)                  ((void)0)
+#define bb_tick()                       ((void)0)
+
+#endif /* LED_BLACKBOX */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLACKBOX_H_ */
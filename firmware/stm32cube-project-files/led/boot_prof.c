@@ -0,0 +1,68 @@
+/* --------------------------------------------------------------------------
+ * boot_prof.c – boot phase timestamps (DWT), reported once USB is open
+ * -------------------------------------------------------------------------- */
+#include <stdio.h>
+#include "boot_prof.h"
+#include "led_render.h"      /* render_frame_seq / shown: first frame lit */
+#include "usb_comms.h"       /* host_open */
+#include "usb_device.h"      /* USBD_UsrLog */
+#include "stm32f4xx_hal.h"   /* DWT, SystemCoreClock, HAL_GetTick */
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+#define BOOT_NAME(name, text) text,
+    BOOT_PHASES(BOOT_NAME)
+#undef BOOT_NAME
+};
+
+static uint32_t phase_us[BOOT_PHASE_COUNT];
+static uint32_t last_cyc;           /* previous mark, DWT */
+static uint32_t elapsed_us;         /* up to the previous mark */
+static bool     booted;
+static uint32_t seq_boot;           /* frames submitted before the first lit one */
+static uint32_t lit_us, enum_ms, open_ms;   /* 0 = not yet */
+static bool     reported;
+
+void boot_mark(BootPhase p)
+{
+    if (booted) return;
+    uint32_t cyc = DWT->CYCCNT;
+    uint32_t us  = (cyc - last_cyc) / (SystemCoreClock / 1000000u);
+    last_cyc     = cyc;
+    phase_us[p] += us;
+    elapsed_us  += us;
+    if (p == BOOT_RENDER) seq_boot = render_frame_seq();   /* its dark frame is not "lit" */
+    if (p == BOOT_LOOP) booted = true;
+}
+
+void boot_tick(void)
+{
+    if (!lit_us) {
+        uint32_t end;
+        if ((int32_t)(render_frame_shown(&end) - seq_boot) > 0) {
+            /* the frame ended after the last mark or before it, DWT is fine either way */
+            lit_us = elapsed_us + (uint32_t)((int32_t)(end - last_cyc) / (int32_t)(SystemCoreClock / 1000000u));
+            if (!lit_us) lit_us = 1;
+        }
+    }
+    if (!enum_ms && hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED) enum_ms = HAL_GetTick();
+    if (!open_ms && host_open) open_ms = HAL_GetTick();
+    if (!reported && open_ms) {
+        reported = true;
+        boot_report();
+    }
+}
+
+void boot_report(void)
+{
+    char line[200];
+    int  k = snprintf(line, sizeof line, "boot:");
+    for (uint8_t p = 0; p < BOOT_PHASE_COUNT && k < (int)sizeof line; ++p) {
+        k += snprintf(line + k, sizeof line - (size_t)k, " %s %lu.%lu", phase_names[p],
+                      (unsigned long)(phase_us[p] / 1000u), (unsigned long)(phase_us[p] / 100u % 10u));
+    }
+    USBD_UsrLog("%s ms, lit at %lu.%lu ms, enumerated at %lu ms, host open at %lu ms\n", line,
+                (unsigned long)(lit_us / 1000u), (unsigned long)(lit_us / 100u % 10u),
+                (unsigned long)enum_ms, (unsigned long)open_ms);
+}
@@ -0,0 +1,71 @@
+/*
+ * boot_prof.h – how long boot takes, phase by phase
+ *
+ * main() and scene_load() mark the end of each boot phase with
+ * boot_mark(); main() starts the DWT cycle counter right after HAL_Init(),
+ * so the times count from there (HAL_Init() and the startup code's .data /
+ * .bss copy are not in them). Once the board runs, boot_tick() notes when
+ * the first frame's DMA finished (the sculpture is lit), when USB
+ * enumerated and when a terminal opened the port, and prints the whole lot
+ * then (nobody could read it earlier); "boot" on the console prints it
+ * again:
+ *
+ *   boot: clock 0.5 periph 0.1 geometry 0.4 mapping 2.1 ... ms,
+ *         lit at 6.8 ms, enumerated at 420 ms, host open at 1310 ms
+ *
+ * Phases are converted at the core clock they ended at, CLOCK (HSI to PLL)
+ * is only roughly right. After boot boot_mark() does nothing, a runtime
+ * "scene" rebuild is not counted.
+ */
+
+#ifndef _BOOT_PROF_H_
+#define _BOOT_PROF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* in boot order: X(name, text) */
+#define BOOT_PHASES(X)                  \
+    X(CLOCK,       "clock")             \
+    X(PERIPH,      "periph")            \
+    X(GEOMETRY,    "geometry")          \
+    X(MAPPING,     "mapping")           \
+    X(GEODESIC,    "geodesic")          \
+    X(RENDER,      "render")            \
+    X(FIRST_FRAME, "first frame")       \
+    X(USB,         "usb")               \
+    X(LOOP,        "loop")
+
+typedef enum {
+#define BOOT_ENUM(name, text) BOOT_##name,
+    BOOT_PHASES(BOOT_ENUM)
+#undef BOOT_ENUM
+    BOOT_PHASE_COUNT
+} BootPhase;
+
+/**
+ * Phase p just ended (a phase not marked takes no time, the next one
+ * counts from the last mark). BOOT_LOOP ends boot.
+ */
+void boot_mark(BootPhase p);
+
+/**
+ * Once per main loop pass: first frame out, enumeration, host open
+ */
+void boot_tick(void);
+
+/**
+ * Print the report (USBD_UsrLog)
+ */
+void boot_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BOOT_PROF_H_ */
@@ -0,0 +1,128 @@
+/* --------------------------------------------------------------------------
+ * calib.c – Gray coded block patterns for the camera, the map it finds
+ * -------------------------------------------------------------------------- */
+#include "calib.h"
+
+#ifdef LED_CALIB
+
+#include <string.h>
+#include "led_debug.h"       /* debug_apply_map */
+#include "led_mapping.h"
+#include "led_render.h"
+#include "scene.h"           /* poly */
+#include "usb_comms.h"       /* USBD_UsrLog() */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick */
+
+static bool       running;
+static uint8_t    shown;             /* pattern on the LEDs, announced */
+static uint16_t   hold;
+static uint32_t   t0;
+
+static poly_idx_t stage_map[POLY_MAX_E];
+static bool       stage_flip[POLY_MAX_E];
+static bool       staged[POLY_MAX_E];
+
+static uint8_t bits_for(poly_idx_t n)
+{
+    uint8_t b = 0;
+    while (b < 16 && (1u << b) < n) ++b;
+    return b;
+}
+
+static uint8_t pattern_count(void)
+{
+    return (uint8_t)(bits_for(poly.E) + 3);
+}
+
+void calib_start(uint16_t hold_ms)
+{
+    hold    = hold_ms ? hold_ms : CALIB_HOLD_MS;
+    t0      = HAL_GetTick();
+    shown   = 0xFF;
+    running = true;
+}
+
+void calib_stop(void)
+{
+    running = false;
+}
+
+bool calib_running(void)
+{
+    return running;
+}
+
+/* block `phys` lit in pattern k? i: LED along the block in wiring order */
+static bool lit(uint8_t k, poly_idx_t phys, uint16_t i, uint16_t count, uint8_t bits)
+{
+    if (k == 0) return false;
+    if (k == 1) return true;
+    if (k < 2 + bits) {
+        uint16_t gray = (uint16_t)(phys ^ (phys >> 1));
+        return (gray >> (k - 2)) & 1u;
+    }
+    return i < count / 2;
+}
+
+bool calib_tick(void)
+{
+    if (!running) return false;
+
+    uint8_t k = (uint8_t)((HAL_GetTick() - t0) / hold);
+    if (k >= pattern_count()) {
+        running = false;
+        USBD_UsrLog("#endcalib#");
+        return false;
+    }
+
+    const poly_idx_t  *emap = mapping_edit_edge_map();
+    const bool        *fmap = mapping_edit_flip_map();
+    const EdgeLedInfo *li   = mapping_get_edge_info();
+    const uint8_t      bits = bits_for(poly.E);
+
+    /* walked along the logical edge A -> B, the wiring runs the other way
+     * when flipped; the block is the physical one the edge sits on */
+    g_global_brightness = 255;
+    set_all_pixels_color(0, 0, 0);
+    for (poly_idx_t e = 0; e < poly.E; ++e) {
+        for (uint16_t i = 0; i < li[e].count; ++i) {
+            uint16_t wire = fmap[e] ? (uint16_t)(li[e].count - 1u - i) : i;
+            if (lit(k, emap[e], wire, li[e].count, bits)) {
+                set_pixel_color((uint16_t)(li[e].start + i * li[e].step),
+                                CALIB_LEVEL, CALIB_LEVEL, CALIB_LEVEL);
+            }
+        }
+    }
+    update_leds();
+
+    if (k != shown) {
+        shown = k;
+        USBD_UsrLog("#calib# k=%u n=%u bits=%u E=%u hold=%u#", (unsigned)k,
+                    (unsigned)pattern_count(), (unsigned)bits, (unsigned)poly.E, (unsigned)hold);
+    }
+    return true;
+}
+
+bool calib_set(poly_idx_t logical, poly_idx_t phys, bool flip)
+{
+    if (logical >= poly.E || phys >= poly.E) return false;
+    stage_map[logical]  = phys;
+    stage_flip[logical] = flip;
+    staged[logical]     = true;
+    return true;
+}
+
+bool calib_apply(void)
+{
+    static bool used[POLY_MAX_E];
+    memset(used, 0, sizeof used);
+    for (poly_idx_t e = 0; e < poly.E; ++e) {
+        if (!staged[e] || used[stage_map[e]]) return false;
+        used[stage_map[e]] = true;
+    }
+    debug_apply_map(stage_map, stage_flip);
+    memset(staged, 0, sizeof staged);
+    return true;
+}
+
+#endif /* LED_CALIB */
@@ -0,0 +1,92 @@
+/*
+ * calib.h – edge mapping found by a camera, Gray coded flashes (LED_CALIB)
+ *
+ * "calib" on the console takes the frames over and shows, one after the
+ * other for CALIB_HOLD_MS each, grey (CALIB_LEVEL) on black by physical
+ * block (wiring order, whatever USER_MAP says):
+ *
+ *   0            all off   (what the camera sees anyway)
+ *   1            all on    (where the edges are, how bright)
+ *   2 .. 1+bits  bit k of gray(block) lights the block, lowest bit first
+ *   2+bits       the first half of every block in wiring order (direction)
+ *
+ * bits = ceil(log2(E)): 5 for 30 edges, 8 patterns. "#calib# k=<i> n=<n>
+ * bits=<b> E=<E> hold=<ms>#" goes out when pattern i is lit, "#endcalib#"
+ * after the last one, then the animation is back.
+ *
+ * app/calibrate.py grabs a webcam picture per pattern, decodes the block
+ * and wiring start of every lit segment, joins segments meeting in a
+ * corner into vertices (over several views, the sculpture turned between
+ * them), matches that graph onto the polyhedron's and sends the result:
+ *
+ *   calib set <logical edge> <physical block> <flip 0|1>   (each edge)
+ *   calib apply
+ *
+ * apply takes the staged map when it is a permutation, writes it into the
+ * mapping, saves it to flash (LED_MAP_STORE) and dumps it as USER_MAP /
+ * USER_FLIP (debug_apply_map).
+ */
+
+#ifndef _CALIB_H_
+#define _CALIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "polyhedron.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ms each pattern stays lit: a camera frame or two plus the USB line */
+#ifndef CALIB_HOLD_MS
+  #define CALIB_HOLD_MS     400
+#endif
+
+/* grey level of a lit LED: plenty for a camera, a quarter of full white's
+ * current with every LED on */
+#ifndef CALIB_LEVEL
+  #define CALIB_LEVEL       64
+#endif
+
+#ifdef LED_CALIB
+
+/**
+ * Show the patterns from the start (hold_ms 0: CALIB_HOLD_MS)
+ */
+void calib_start(uint16_t hold_ms);
+
+void calib_stop(void);
+
+bool calib_running(void);
+
+/**
+ * Per frame tick, before anything draws (debug_ui_tick)
+ * @return true while the patterns own the frame
+ */
+bool calib_tick(void);
+
+/**
+ * Stage logical edge -> physical block, wired B->A (calib set)
+ * @return false out of range
+ */
+bool calib_set(poly_idx_t logical, poly_idx_t phys, bool flip);
+
+/**
+ * The staged map into the mapping and flash (calib apply)
+ * @return false when an edge is not staged or two share a block
+ */
+bool calib_apply(void);
+
+#else
+
+#define calib_tick()    (false)
+
+#endif /* LED_CALIB */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CALIB_H_ */
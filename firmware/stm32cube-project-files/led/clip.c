@@ -0,0 +1,313 @@
+/* --------------------------------------------------------------------------
+ * clip.c – clip upload into the store's sector, frames decoded out of
+ *          flash into the back buffer on the frame clock (clip.h)
+ * -------------------------------------------------------------------------- */
+#include "clip.h"
+
+#ifdef LED_CLIP
+
+#include <string.h>
+#include "crc.h"             /* hcrc (MX_CRC_Init) */
+#include "proto.h"           /* ProtoClip* */
+#include "led_render.h"      /* render_acquire_back, render_mark_dirty, render_submit */
+#include "led_mapping.h"     /* mapping_get_total_pixels */
+#include "led_stream.h"      /* STREAM_FRAME_*, STREAM_DELTA_SKIP */
+#include "frame_clock.h"     /* frame_clock_stats */
+#include "stm32f4xx_hal.h"
+
+#define CLIP_MAGIC      0x50494C43u             /* "CLIP" */
+#define HEAD_BYTES      16u
+#define IMAGE           ((const uint8_t *)(CLIP_ADDR + HEAD_BYTES))
+#define ROOM            (CLIP_SIZE - HEAD_BYTES)
+
+/* the partition's first words, the magic programmed last */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t spare;
+} ClipHead;
+
+#define HEAD            ((const ClipHead *)CLIP_ADDR)
+
+/* app/show.py's header, the image starts with it */
+typedef struct __attribute__((packed)) {
+    char     magic[4];       /* "IPSH" */
+    uint8_t  version;
+    uint8_t  spare;
+    uint16_t leds;
+    uint32_t geometry;
+    float    fps;
+    uint32_t frames;
+    uint64_t end;            /* the index in a show, the frames' end here */
+} ShowHead;
+
+#define SHOW_VERSION    1
+
+/* upload */
+static bool     up_open;
+static uint32_t up_size, up_at;
+
+/* playback */
+static bool     playing, looping;
+static bool     started;                /* the first tick came: the clock counts */
+static bool     base;                   /* back buffer holds the last frame */
+static uint32_t at, end;                /* image offsets: next frame, frames' end */
+static uint32_t fb_len;                 /* 3 * LEDs */
+static uint32_t frame_us, owed_us;      /* clip's period, clock time not played yet */
+static uint32_t ticks;                  /* frame clock ticks seen */
+static uint8_t  pal[256][3];
+
+static ClipStats stats;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * The stored clip
+ */
+static bool show_head(ShowHead *s)
+{
+    const ClipHead *h = HEAD;
+    if (h->magic != CLIP_MAGIC || h->size < sizeof *s || h->size > ROOM) return false;
+    memcpy(s, IMAGE, sizeof *s);
+    return memcmp(s->magic, "IPSH", 4) == 0 && s->version == SHOW_VERSION
+        && s->end >= sizeof *s && s->end <= h->size && s->fps > 0.0f;
+}
+
+bool clip_info(uint16_t *leds, float *fps, uint32_t *frames, uint32_t *bytes)
+{
+    ShowHead s;
+    if (!show_head(&s)) return false;
+    *leds   = s.leds;
+    *fps    = s.fps;
+    *frames = s.frames;
+    *bytes  = HEAD->size;
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Upload
+ */
+static bool program(uint32_t addr, const uint8_t *p, uint32_t n)
+{
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < n; i += 4) {
+        uint32_t w;
+        memcpy(&w, p + i, 4);                    /* payload is not aligned */
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + i, w) == HAL_OK;
+    }
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+static ClipStatus up_begin(uint32_t size)
+{
+    clip_stop();                                 /* no reads from a sector being erased */
+    up_open = false;
+    if (size < sizeof(ShowHead) || size > ROOM || (size & 3u)) return CLIP_ERR_RANGE;
+    if (!flash_store_erase_keep()) return CLIP_ERR_FLASH;
+    up_open = true;
+    up_size = size;
+    up_at   = 0;
+    return CLIP_OK;
+}
+
+static ClipStatus up_data(uint32_t offset, const uint8_t *p, uint32_t n)
+{
+    if (!up_open) return CLIP_ERR_STATE;
+    if (offset != up_at || (n & 3u) || n > up_size - up_at) return CLIP_ERR_RANGE;
+    if (!program(CLIP_ADDR + HEAD_BYTES + offset, p, n)) {
+        up_open = false;
+        return CLIP_ERR_FLASH;
+    }
+    up_at += n;
+    return CLIP_OK;
+}
+
+static ClipStatus up_end(uint32_t crc, uint32_t *found)
+{
+    if (!up_open || up_at != up_size) return CLIP_ERR_STATE;
+    up_open = false;
+    *found  = HAL_CRC_Calculate(&hcrc, (uint32_t *)IMAGE, up_size / 4u);
+    if (*found != crc) return CLIP_ERR_CRC;
+    const ClipHead h = { CLIP_MAGIC, up_size, crc, 0xFFFFFFFFu };
+    if (!program(CLIP_ADDR + 4u, (const uint8_t *)&h.size, 8)
+        || !program(CLIP_ADDR, (const uint8_t *)&h.magic, 4)) return CLIP_ERR_FLASH;
+    return CLIP_OK;
+}
+
+int16_t clip_packet(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    ProtoClipReply r = { p[0], CLIP_ERR_RANGE, 0 };
+    if (p[0] == CLIP_OP_BEGIN && n >= PROTO_CLIP_BEGIN_SIZE) {
+        ProtoClipBegin b;
+        proto_clip_begin_decode(p, &b);
+        r.status = up_begin(b.size);
+        r.value  = ROOM;
+    } else if (p[0] == CLIP_OP_DATA && n >= PROTO_CLIP_DATA_SIZE) {
+        ProtoClipData d;
+        proto_clip_data_decode(p, &d);
+        r.status = up_data(d.offset, p + PROTO_CLIP_DATA_SIZE, n - PROTO_CLIP_DATA_SIZE);
+        r.value  = up_at;
+    } else if (p[0] == CLIP_OP_END && n >= PROTO_CLIP_END_SIZE) {
+        ProtoClipEnd e;
+        proto_clip_end_decode(p, &e);
+        r.status = up_end(e.crc, &r.value);
+    }
+    if (cap < PROTO_CLIP_REPLY_SIZE) return -1;
+    proto_clip_reply_encode(out, &r);
+    return PROTO_CLIP_REPLY_SIZE;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Playback: one frame out of flash into the back buffer, only what it
+ * changes marked dirty
+ */
+#ifdef LED_PIXEL_32
+#define FB(px, i)       (((uint8_t *)&(px)[(i) / 3u])[(i) % 3u])
+#else
+#define FB(px, i)       (((uint8_t *)(px))[i])
+#endif
+
+static void mark(uint32_t first_byte, uint32_t n)
+{
+    const uint32_t p0 = first_byte / 3u, p1 = (first_byte + n - 1u) / 3u;
+    render_mark_dirty((uint16_t)p0, (uint16_t)(p1 - p0 + 1u));
+}
+
+static bool decode(rgb_8b *px)
+{
+    if (end - at < 4u + 2u) return false;
+    uint32_t len;
+    memcpy(&len, IMAGE + at, 4);
+    if (len < 2u || len > end - at - 4u) return false;
+    const uint8_t *f = IMAGE + at + 4u;
+    const uint8_t *e = f + len - 1u;            /* the 'E' */
+    if (*e != STREAM_FRAME_END) return false;
+
+    switch (*f++) {
+    case STREAM_FRAME_RAW:
+        if ((uint32_t)(e - f) != fb_len) return false;
+#ifdef LED_PIXEL_32
+        for (uint32_t i = 0; i < fb_len; i += 3, f += 3) px[i / 3u] = (rgb_8b){ f[0], f[1], f[2] };
+#else
+        memcpy(px, f, fb_len);
+#endif
+        mark(0, fb_len);
+        base = true;
+        break;
+    case STREAM_FRAME_DELTA: {
+        if (!base) return false;
+        uint32_t i = 0;
+        while (f < e) {
+            const uint8_t  c    = *f++;
+            const uint32_t span = (c & (STREAM_DELTA_SKIP - 1u)) + 1u;
+            if (span > fb_len - i) return false;
+            if (!(c & STREAM_DELTA_SKIP)) {
+                if ((uint32_t)(e - f) < span) return false;
+                for (uint32_t k = 0; k < span; ++k) FB(px, i + k) ^= f[k];
+                mark(i, span);
+                f += span;
+            }
+            i += span;
+        }
+        if (i != fb_len) return false;
+        break;
+    }
+    case STREAM_FRAME_PALETTE: {
+        const uint32_t n = *f++;
+        if ((uint32_t)(e - f) != 3u * n + fb_len / 3u) return false;
+        memcpy(pal, f, 3u * n);
+        f += 3u * n;
+        for (uint32_t p = 0; p < fb_len / 3u; ++p) {
+            const uint8_t *c = pal[f[p]];
+            px[p] = (rgb_8b){ c[0], c[1], c[2] };
+        }
+        mark(0, fb_len);
+        base = true;
+        break;
+    }
+    default:
+        return false;
+    }
+    at += 4u + len;
+    return true;
+}
+
+bool clip_play(bool loop)
+{
+    ShowHead s;
+    if (!show_head(&s) || s.leds != mapping_get_total_pixels()) return false;
+    if (HAL_CRC_Calculate(&hcrc, (uint32_t *)IMAGE, HEAD->size / 4u) != HEAD->crc) return false;
+
+    fb_len   = 3u * s.leds;
+    end      = (uint32_t)s.end;
+    at       = sizeof s;
+    base     = false;
+    frame_us = (uint32_t)(1e6f / s.fps);
+    if (!frame_us) frame_us = 1;
+    started  = false;
+    looping  = loop;
+    playing  = true;
+    memset(&stats, 0, sizeof stats);
+    return true;
+}
+
+void clip_stop(void) { playing = false; }
+
+bool clip_playing(void) { return playing; }
+
+bool clip_tick(void)
+{
+    if (!playing) return false;
+    if (HEAD->magic != CLIP_MAGIC) {            /* the store erased it */
+        playing = false;
+        return false;
+    }
+
+    const FrameClockStats *fc = frame_clock_stats();
+    const uint32_t t = fc->frames + fc->missed;
+    owed_us  = started ? owed_us + (t - ticks) * fc->period_us : frame_us;  /* the first at once */
+    ticks    = t;
+    started  = true;
+
+    rgb_8b *px = render_acquire_back();
+    if (!px) return true;
+
+    bool    drawn = false;
+    uint8_t n     = 0;
+    while (owed_us >= frame_us && n++ < CLIP_CATCH_UP) {
+        owed_us -= frame_us;
+        if (at >= end) {
+            if (!looping) {
+                playing = false;
+                break;
+            }
+            at   = sizeof(ShowHead);
+            base = false;                       /* frame 0 must stand on its own */
+            ++stats.loops;
+        }
+        const uint32_t t0 = DWT->CYCCNT;
+        if (!decode(px)) {
+            ++stats.bad;
+            playing = false;
+            break;
+        }
+        const uint32_t us = (DWT->CYCCNT - t0) / (SystemCoreClock / 1000000u);
+        if (us > stats.max_us) stats.max_us = us;
+        ++stats.frames;
+        drawn = true;
+    }
+    owed_us %= frame_us;                        /* too far behind: the clip slows */
+
+    if (drawn) {
+        render_submit();
+        ++stats.shown;
+    }
+    return drawn || playing;                    /* ended: the animation has this one */
+}
+
+const ClipStats *clip_stats(void) { return &stats; }
+
+#endif /* LED_CLIP */
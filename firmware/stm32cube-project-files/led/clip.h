@@ -0,0 +1,116 @@
+/*
+ * clip.h – a pre-rendered clip played out of flash (LED_CLIP)
+ *
+ * The clip is a recorded show (app/show.py) without its index, uploaded by
+ * "python show.py upload" into the part of the flash store's sector past
+ * FLASH_STORE_SIZE (flash_store.h), ~112 kB. The partition:
+ *
+ *   magic u32 | size u32 | crc u32 | 0xFFFFFFFF | image[size]
+ *
+ * image is the show's 28 byte header (leds, fps, frames) and its frames,
+ * each length u32 | 'F' / 'D' / 'P' … 'E' as led_stream.h has them, padded
+ * with zeros to whole words; crc is the CRC unit's over the padded image.
+ * The magic is programmed last, so an upload cut short reads as no clip.
+ *
+ * Upload (PKT_CLIP): CLIP_OP_BEGIN erases the sector and writes the store's
+ * records back (~1-2 s), CLIP_OP_DATA programs the image in order,
+ * CLIP_OP_END checks the CRC and closes it. Every step is answered with
+ * ProtoClipReply, the host waits for it before sending the next.
+ *
+ * "clip play" / "clip loop" take the frames over like a stream (the
+ * animation stops) and decode the frames from the memory mapped flash
+ * straight into the back buffer, no copy in RAM but the palette: raw frames
+ * are a memcpy, 'D' frames only xor and mark the runs that changed, so the
+ * encoder redoes only those. The clip runs at its own fps against the frame
+ * clock, a frame per tick at the same rate, frames dropped from the output
+ * (still decoded, the deltas need them) when it is faster. A loop starts
+ * over at frame 0, which must be a raw or palette frame.
+ *
+ * A clip made for another LED count does not play. The store filling up
+ * erases the clip along with its own records (it reads as none then).
+ */
+
+#ifndef _CLIP_H_
+#define _CLIP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "flash_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLIP_ADDR           (FLASH_STORE_ADDR + FLASH_STORE_SIZE)
+#define CLIP_SIZE           (FLASH_SECTOR_BYTES - FLASH_STORE_SIZE)
+
+/* frames decoded in one tick at most when the clip runs faster than the
+ * frame clock (or the loop fell behind) */
+#ifndef CLIP_CATCH_UP
+  #define CLIP_CATCH_UP     4
+#endif
+
+/* PKT_CLIP's op byte */
+#define CLIP_OP_BEGIN       0
+#define CLIP_OP_DATA        1
+#define CLIP_OP_END         2
+
+typedef enum {
+    CLIP_OK,
+    CLIP_ERR_RANGE,         /* too big, or data not where the upload is at */
+    CLIP_ERR_FLASH,         /* erase / program failed */
+    CLIP_ERR_CRC,           /* the image does not match the host's CRC */
+    CLIP_ERR_STATE,         /* data / end without a begin */
+} ClipStatus;
+
+typedef struct {
+    uint32_t frames;        /* decoded */
+    uint32_t shown;         /* of them submitted */
+    uint32_t loops;
+    uint32_t bad;           /* playback stopped on a frame that did not parse */
+    uint32_t max_us;        /* longest decode of a frame */
+} ClipStats;
+
+#ifdef LED_CLIP
+
+/**
+ * Start playing from frame 0
+ * @return false: no valid clip, or not for this LED count
+ */
+bool clip_play(bool loop);
+
+void clip_stop(void);
+
+bool clip_playing(void);
+
+/**
+ * Per frame tick, before anything draws (debug_ui_tick)
+ * @return true while the clip owns the frame
+ */
+bool clip_tick(void);
+
+/**
+ * PKT_CLIP: one upload step, answered with ProtoClipReply
+ */
+int16_t clip_packet(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap);
+
+/**
+ * The stored clip's header, for "clip"
+ * @return false: none (or torn, or erased by the store)
+ */
+bool clip_info(uint16_t *leds, float *fps, uint32_t *frames, uint32_t *bytes);
+
+const ClipStats *clip_stats(void);
+
+#else
+
+#define clip_tick()     (false)
+
+#endif /* LED_CLIP */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CLIP_H_ */
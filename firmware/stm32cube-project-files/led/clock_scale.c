@@ -0,0 +1,106 @@
+/* --------------------------------------------------------------------------
+ * clock_scale.c – HCLK by frame load, peripherals re-derived (clock_scale.h)
+ * -------------------------------------------------------------------------- */
+#include "clock_scale.h"
+
+#ifdef LED_CLOCK_SCALE
+
+#if defined(LED_OUTPUT_GPIO) || defined(LED_OUTPUT_APA102) || defined(LED_RENDER_STREAM)
+#error "LED_CLOCK_SCALE re-derives the WS SPI ping-pong output only"
+#endif
+#if defined(LED_AUDIO) || defined(LED_PC_SAMPLE) || defined(LED_ITM) || \
+    defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE) || defined(LED_RTOS)
+#error "LED_CLOCK_SCALE: audio, PC sampling, ITM, the board link and the RTOS set their clocks up once"
+#endif
+
+#include "frame_clock.h"     /* frame_clock_stats, frame_clock_reclock */
+#include "led_render.h"      /* render_wire_idle, render_clock_* */
+#include "led_governor.h"    /* gov_level: the governor stepping in means full clock */
+#include "usb_comms.h"       /* USBD_UsrLog() */
+#include "stm32f4xx_hal.h"
+
+extern PCD_HandleTypeDef hpcd_USB_OTG_FS;    /* usbd_conf.c */
+
+static const uint32_t ahb_div[CLK_LEVELS]  = { RCC_SYSCLK_DIV1, RCC_SYSCLK_DIV2, RCC_SYSCLK_DIV4 };
+static const uint32_t flash_ws[CLK_LEVELS] = { FLASH_LATENCY_2, FLASH_LATENCY_1, FLASH_LATENCY_0 };
+
+static uint8_t  clk_lvl    = 0;
+static uint8_t  clk_want   = 0;         /* applied once the strips are idle */
+static bool     clk_pinned = false;
+static uint32_t clk_frames = 0;         /* frame_clock frames last looked at */
+static uint16_t clk_under  = 0;         /* frames in a row under CLK_DOWN_PCT */
+static uint32_t clk_ups, clk_downs;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * The switch itself, interrupts off: nothing may run on a half changed
+ * clock tree. HAL_RCC_ClockConfig() orders the wait states and moves
+ * SysTick, the rest is re-derived from the new PCLKs right after.
+ */
+static bool apply(uint8_t lvl)
+{
+    const int8_t shift = (int8_t)(lvl - clk_lvl);
+    if (!render_clock_fits(shift)) return false;
+
+    RCC_ClkInitTypeDef c = { 0 };
+    c.ClockType      = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+    c.AHBCLKDivider  = ahb_div[lvl];
+    c.APB1CLKDivider = RCC_HCLK_DIV2;        /* as SystemClock_Config(): both follow HCLK */
+    c.APB2CLKDivider = RCC_HCLK_DIV1;
+
+    /* the turnaround time for the slower of the two clocks while switching */
+    const uint32_t hclk = HAL_RCC_GetSysClockFreq() >> lvl;
+    __disable_irq();
+    if (shift > 0) USB_SetTurnaroundTime(hpcd_USB_OTG_FS.Instance, hclk, USBD_FS_SPEED);
+    bool ok = HAL_RCC_ClockConfig(&c, flash_ws[lvl]) == HAL_OK;
+    if (ok) {
+        frame_clock_reclock();
+        ok = render_clock_changed();
+        if (shift < 0) USB_SetTurnaroundTime(hpcd_USB_OTG_FS.Instance, hclk, USBD_FS_SPEED);
+    }
+    __enable_irq();
+    if (!ok) return false;
+
+    if (shift > 0) clk_downs++;
+    else           clk_ups++;
+    clk_lvl = lvl;
+    return true;
+}
+
+void clk_scale_tick(void)
+{
+    const FrameClockStats *st = frame_clock_stats();
+    if (st->frames != clk_frames && st->period_us) {
+        clk_frames = st->frames;
+        uint32_t pct = st->work_us * 100u / st->period_us;
+        clk_under = (pct < CLK_DOWN_PCT) ? clk_under + 1 : 0;
+        if (!clk_pinned) {
+            if (pct > CLK_UP_PCT || gov_level() > 0) {
+                clk_want  = 0;
+                clk_under = 0;
+            } else if (clk_under >= CLK_DOWN_FRAMES && clk_want == clk_lvl && clk_lvl < CLK_LEVELS - 1) {
+                clk_want  = (uint8_t)(clk_lvl + 1);
+                clk_under = 0;
+            }
+        }
+    }
+    if (clk_want == clk_lvl || frame_clock_pending() || !render_wire_idle()) return;
+    if (!apply(clk_want)) clk_want = clk_lvl;    /* no strip rate there: stay */
+}
+
+uint8_t clk_scale_level(void) { return clk_lvl; }
+
+void clk_scale_force(int8_t level)
+{
+    clk_pinned = (level >= 0 && level < CLK_LEVELS);
+    clk_want   = clk_pinned ? (uint8_t)level : 0;
+    clk_under  = 0;
+}
+
+void clk_scale_report(void)
+{
+    USBD_UsrLog("clock: level %u, HCLK %lu MHz%s, %lu down / %lu up\n", clk_lvl,
+                (unsigned long)(HAL_RCC_GetHCLKFreq() / 1000000u), clk_pinned ? "" : " (auto)",
+                (unsigned long)clk_downs, (unsigned long)clk_ups);
+}
+
+#endif /* LED_CLOCK_SCALE */
@@ -0,0 +1,93 @@
+/*
+ * clock_scale.h – core clock down while the frames are light (LED_CLOCK_SCALE)
+ *
+ * Watches the frame clock's work time against its period, like the quality
+ * governor: a long stretch under CLK_DOWN_PCT halves HCLK (84 → 42 → 21 MHz),
+ * a frame over CLK_UP_PCT, or the governor having to step in, puts it
+ * straight back to 84. A palette, a static face or a skipped unchanged
+ * frame takes a few percent of the slot, the heavy effects keep the full
+ * clock, the closed stand runs cooler in between.
+ *
+ * Only the AHB prescaler moves, the PLL stays: USB keeps its 48 MHz and
+ * the regulator its scale (VOS only changes with the PLL off on the F401).
+ * Both APB buses follow HCLK, so every peripheral clock halves alike and the
+ * things timed off them are re-derived on the spot, between two frames with
+ * the strips idle (render_wire_idle()):
+ *
+ *   strip SPIs   prescaler halved as often, same bit rate and pattern
+ *                (render_clock_changed()); a level no strip rate can be
+ *                had at is not used
+ *   TIM2, TIM5   1 µs again, the running frame slot keeps its count
+ *   SysTick      HAL_RCC_ClockConfig() does it
+ *   USB          turnaround time for the new HCLK (≥ 14.2 MHz for FS)
+ *   flash        wait states down with HCLK
+ *
+ * DWT times convert with SystemCoreClock, so a span that straddles a switch
+ * (one frame's dt, a profiler call) is off once. Not with what sets its
+ * clock up once: LED_OUTPUT_GPIO / APA102, LED_RENDER_STREAM, LED_AUDIO,
+ * LED_PC_SAMPLE, LED_ITM, the board link or LED_RTOS (its tick).
+ *
+ * "clock" prints level and HCLK, "clock <0-2>" pins a level, "clock auto".
+ */
+
+#ifndef _CLOCK_SCALE_H_
+#define _CLOCK_SCALE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLK_LEVELS              3       /* HCLK 84, 42, 21 MHz */
+
+/* share of the frame period (%): under it long enough halves the clock (the
+ * work about doubles then, it has to stay well under CLK_UP_PCT), over it
+ * once goes back to full */
+#ifndef CLK_DOWN_PCT
+  #define CLK_DOWN_PCT          20
+#endif
+#ifndef CLK_UP_PCT
+  #define CLK_UP_PCT            60
+#endif
+/* frames in a row under CLK_DOWN_PCT to step down */
+#ifndef CLK_DOWN_FRAMES
+  #define CLK_DOWN_FRAMES       120
+#endif
+
+#ifdef LED_CLOCK_SCALE
+
+/**
+ * Main loop, every pass: looks at each new frame, a change waits for the
+ * strips to be idle
+ */
+void clk_scale_tick(void);
+
+/**
+ * Current level, 0 = full clock
+ */
+uint8_t clk_scale_level(void);
+
+/**
+ * Pin a level (0 .. CLK_LEVELS - 1), anything else = automatic again
+ */
+void clk_scale_force(int8_t level);
+
+/**
+ * Level, HCLK, pinned or not and the switches so far (USBD_UsrLog)
+ */
+void clk_scale_report(void);
+
+#else
+
+#define clk_scale_tick()        ((void)0)
+
+#endif /* LED_CLOCK_SCALE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CLOCK_SCALE_H_ */
@@ -8,11 +8,35 @@
 
 #define EDGE_CNT 30
 
+/* Uncomment for solids with more than 254 vertices, edges or faces (geodesic
+ * builds): vertex / edge / face indices (poly_idx_t, polyhedron.h) go from 8
+ * to 16 bit, every index table (faces, edge maps, topology refs) doubles.
+ * Raise FLASH_STORE_MAX_LEN for LED_MAP_STORE, a mapping needs 3 bytes per
+ * edge then. POLY_MAX_V / _E / _F (defaults 512 / 1024 / 512) cap the stack
+ * scratch used while building.
+ */
+//#define POLY_INDEX_16
+
+/* Uncomment to give every physical block (edge bar, wire order) its own LED
+ * count instead of deriving it from the edge length. EDGE_CNT entries, LEDs
+ * that are soldered but hidden go into LED_SKIP_RANGES, not in here.
+ */
+//#define LED_EDGE_LEDS { 24,24,24,24,24,24,24,24,24,24, 24,24,24,24,24,24,24,24,24,24, 24,24,24,24,24,24,24,24,24,24 }
+
+/* Uncomment for dark LEDs on the strips (corner spacers, cut-off pixels behind
+ * the frame): { wire position, count } pairs, wire position counts every LED
+ * along the strips (dark ones too, strip 0 first), ascending. They are no
+ * pixels: nothing draws or encodes them, the renderer writes them black once.
+ * LED_STRIP_LENGTHS still counts the lit LEDs only. Only with the SPI strip
+ * buffer (not with LED_RENDER_STREAM or LED_OUTPUT_GPIO).
+ */
+//#define LED_SKIP_RANGES { { 0, 1 }, { 25, 2 }, { 51, 2 } }
+
 /* ======================================= */
 // USER MAPS TO MAP EDGE TO EDGE (PHYSICAL TO VIRTUAL)
 // AND ALSO DIRECTION (FACE WINDING CCW TO WIRED)
 
-static const uint8_t USER_MAP[EDGE_CNT] = {
+static const uint16_t USER_MAP[EDGE_CNT] = {
       10,  29,   4,  22,   0,  19,  21,  12,
       20,  17,  28,   5,  14,  27,   6,  13,
       24,   2,  15,  26,   9,  16,   3,   7,
@@ -44,21 +68,115 @@ static const bool USER_FLIP[EDGE_CNT] = {
 
 /* ======================================= */
 
-#define LED_DEBUG_ANIM
+/* Cycle profiler (profiler.h): per zone min/avg/p99/max and overruns over
+ * PROF_WINDOW_MS windows, sent to the app in the telemetry packet
+ * (telemetry.h). PROF_TEXT prints them as #prof lines too. Comment out and
+ * all PROF_BEGIN / PROF_END compile to nothing.
+ */
+#define LED_PROFILE
+
+#ifdef LED_PROFILE
+#define PROF_WINDOW_MS          200
+//#define PROF_TEXT
+#endif
+
+/* Event timeline (trace.h): profiler zones, SPI DMA start/complete, CDC RX/TX
+ * ISRs and flush_usb_buffer() go into a TRACE_DEPTH record ring (8 bytes each),
+ * the "trace" command dumps it, the app saves it as Chrome trace JSON.
+ */
+//#define LED_TRACE
+//#define TRACE_DEPTH 512
 
-#ifdef LED_DEBUG_ANIM
-#define ANIMTIME_PRINT_INTERVAL_MS  200
-#define ANIMTIME_HISTORY           	10
+/* SWO output (itm.h): the profiler zones (LED_PROFILE) and trace events
+ * (LED_TRACE) go out on ITM stimulus ports through the debug probe as they
+ * happen, a few cycles each and nothing without a probe attached. ITM_LOG
+ * sends the printf text there too, instead of the CDC console (the app
+ * sees none of it then). Takes PB3 (SPI3's SCK, unused by WS2812 strips)
+ * for SWO; app/itm_decode.py reads the probe's capture.
+ */
+//#define LED_ITM
+#ifdef LED_ITM
+//#define ITM_LOG
+//#define ITM_SWO_HZ 2000000
 #endif
 
+/* PC sampling (pc_sample.h): "pcs <hz>" samples the interrupted PC from a
+ * TIM4 interrupt and streams the samples to the app, app/pc_profile.py turns
+ * them into a hot function histogram against the ELF. Off until asked for.
+ */
+//#define LED_PC_SAMPLE
+
+/* Interrupt load (irq_stats.h): calls, cycles and the longest call of each
+ * handler (SysTick, USB, the strip DMAs, the frame / latch timers), DWT
+ * timed, per second. "irq" prints the last second, "irq on" every one.
+ */
+//#define LED_IRQ_STATS
+
+/* Black box (blackbox.h): the last 64 frames' zone times (LED_PROFILE) and
+ * the trace ring (LED_TRACE) are held when a frame runs late, or over
+ * "bb <us>", with the frames after it; "bb dump" sends them to the app.
+ */
+//#define LED_BLACKBOX
+
+/* Input record / replay (replay.h): "rec start" restarts the animation from
+ * its seed on fixed time steps and keeps every command with its frame
+ * number, "rec play" hands them over again at the same frames; "rec dump"
+ * sends the recording to the app for the host build (led_host -p).
+ */
+//#define LED_REPLAY
+
+/* Edge mapping by camera (calib.h): "calib" flashes Gray coded patterns over
+ * the physical blocks, app/calibrate.py decodes them from a webcam, solves
+ * USER_MAP / USER_FLIP and sends them back to be saved ("calib apply").
+ */
+//#define LED_CALIB
+
+/* Audio input (audio.h): a microphone on ADC1 channel AUDIO_ADC_CH (PA1),
+ * sampled by TIM3 through DMA2 stream 4, FFT'd into band levels and beat
+ * onsets the animations read per frame (the "audio" animation). Analysis
+ * runs only in a frame slot with room; "audio" prints its counts. ~7 KB RAM.
+ */
+//#define LED_AUDIO
+
+/* Audio from the app (audio.h): the same band levels and beats, analysed on
+ * the show PC (app/audio_sync.py) and sent as PKT_AUDIO every frame, no
+ * sampling or DSP here. With LED_AUDIO too, the packets win while they come.
+ */
+//#define LED_AUDIO_HOST
+
+/* Clip playback (clip.h): a recorded show (app/show.py) uploaded into the
+ * flash store's sector ("show.py upload"), played from flash straight into
+ * the framebuffer at its own fps by "clip play" / "clip loop". The store
+ * keeps FLASH_STORE_SIZE (16 kB) of the sector, the clip gets the rest.
+ */
+//#define LED_CLIP
+
+/* Deferred logging (dlog.h): DLOG() sends the format string's address and the
+ * raw arguments as a binary packet, the app formats them from the ELF
+ * (app/config.py FIRMWARE_ELF). The strings stay out of flash. Comment out to
+ * print text again, for a plain terminal.
+ */
+#define LOG_DEFERRED
+
+/* Uncomment to enumerate as a composite device: the CDC console plus a vendor
+ * bulk interface (usb_bulk.h) for packets and stream frames, so dumps and
+ * pixels don't queue behind log text. The app needs pyusb / libusb for it
+ * (WinUSB bound to interface 2 on Windows, e.g. with Zadig), the console
+ * works as before without.
+ */
+//#define USB_BULK
+
 /* ======================================= */
 
-#define LED_DEBUG_RENDER
+/* Keep the edge / flip map in flash: "save" writes it (besides dumping it as
+ * USER_MAP / USER_FLIP), boot loads it over the maps above, "forget" goes back
+ * to them. Uses flash sector 5, cut off the linker script's FLASH region.
+ */
+#define LED_MAP_STORE
 
-#ifdef LED_DEBUG_RENDER
-#define FRAMETIME_PRINT_INTERVAL_MS  200
-#define FRAMETIME_HISTORY            10
-#endif
+/* ======================================= */
+
+#define LED_DEBUG_RENDER
 
 
 /* ======================================= */
@@ -66,6 +184,15 @@ static const bool USER_FLIP[EDGE_CNT] = {
 //#define GAMMA_CORRECTION 1.8f
 #define GAMMA_CORRECTION 2.2f
 
+/* Uncomment to take the oriented dodecahedron from flash (led/rom_tables.inc,
+ * see tools/poly_gen.c) instead of building it at boot. Regenerate the file after
+ * changing the solid or its orientation. (The solid then takes nothing of
+ * the scene pool, SCENE_ARENA_BYTES only limits switching to other solids.)
+ * (Gamma comes from led/lut_tables.inc either way, for the exponents in
+ * LUT_GAMMA_LIST, others are built into 256 B of the scene pool at init.)
+ */
+//#define LED_ROM_TABLES
+
 
 
 // Uncomment to overwrite buffer sizes. defaults are 4k bytes and 256 bytes dropped.
@@ -73,11 +200,277 @@ static const bool USER_FLIP[EDGE_CNT] = {
 //#define DEBUG_TX_DROP_CHUNK 256     /* drop oldest bytes on overflow */
 
 
+/* Uncomment for the pipelined renderer: front/back framebuffer pair, frames that
+ * can't be encoded yet are queued and encoded from the SPI DMA-complete ISR while
+ * the next one is being drawn. Costs one more framebuffer (3 bytes per pixel),
+ * 720 pixels need LED_RENDER_MAX_ALLOC raised to ~18 kbytes.
+ */
+//#define LED_RENDER_PIPELINE
+
+/* Uncomment to keep the framebuffer in logical order: index i is the i-th pixel
+ * walking the edges 0..E-1, EdgeLedInfo runs start = first pixel of the edge with
+ * step +1, and the USER_MAP / USER_FLIP permutation is applied once per frame
+ * while the encoder gathers into the strip buffers. Costs 2 bytes per pixel
+ * (inverse map) in the scene pool.
+ */
+//#define LED_RENDER_LOGICAL
+
+/* Uncomment for palette-indexed frames: effects that only produce a hue /
+ * palette position (the index textures: rainbow, vertex palettes, gradient)
+ * store one byte per LED into the framebuffer's memory plus a 256 entry
+ * palette, the encoder looks the colour up on its way into the strip bits.
+ * Rotating the palette (render_palette_rotate) animates every LED without
+ * touching one. Costs 1.5 kbytes of palettes in the scene pool, 720 pixels
+ * need LED_RENDER_MAX_ALLOC raised to ~18 kbytes. Not with LED_RENDER_STREAM /
+ * LED_LINK_MASTER (they take RGB frames).
+ */
+//#define LED_FB_INDEXED
+
+/* Uncomment to store each pixel as a 32 bit word (r, g, b, spare) instead of
+ * 3 bytes: fills, compares and the add / subtract kernels become word loads
+ * and stores with one UQADD8 / UQSUB8 per pixel. A third more framebuffer RAM
+ * (raise LED_RENDER_MAX_ALLOC), the wire format is unchanged. Not with
+ * LED_LINK_MASTER / LED_LINK_SLAVE (their frames are packed RGB).
+ */
+//#define LED_PIXEL_32
+
+/* Uncomment to keep the LED position cache (led_mapping.h, LedPos) as int16
+ * Q1.14 instead of float: 6 instead of 12 bytes per LED, integer distance math.
+ */
+//#define LED_POS_Q14
+
+/* Place the encoder and pixel hot path in SRAM instead of flash (no wait states,
+ * deterministic timing). Costs RAM for the code, size is reported with
+ * LED_DEBUG_RENDER_HEAP. Comment out to keep everything in flash.
+ */
+#define LED_RENDER_RAMFUNC
+
+/* Uncomment to give every strip its own LED count (in strip order, must add up to
+ * the total pixel count), default splits evenly. Physical LED order runs strip 0
+ * first. Balance by wire time: SPI1 runs /32 off APB2, SPI2/3 /16 off APB1, the
+ * predicted time per strip is printed with LED_DEBUG_RENDER.
+ */
+//#define LED_STRIP_LENGTHS { 240, 240, 240 }
+
+/* WS2812 bit encoding on the SPIs: 3, 4 or 5 SPI bits per LED bit (3 or 4
+ * bytes per LED channel more with each step). Every SPI is clocked as fast as
+ * its APB clock allows with a pattern inside the LED_WS_*_NS windows
+ * (led_render.h, WS2812B datasheet by default), printed with LED_DEBUG_RENDER.
+ * At 84 MHz that is 3 bits at 2.625 MHz, 1.14 us per LED bit. A tested
+ * overclock, e.g. 5 bits with LED_WS_T0L_MIN_NS 550 and LED_WS_T1L_MIN_NS 180,
+ * runs 5.25 MHz: 0.95 us per LED bit, for 15 instead of 9 bytes per LED.
+ * 720 pixels then need LED_RENDER_MAX_ALLOC raised to ~20 (4 bits) or ~24
+ * kbytes (5 bits; the default SCENE_MEM_BYTES follows).
+ */
+//#define LED_WS_SPI_BITS 5
+//#define LED_WS_T0L_MIN_NS 550
+//#define LED_WS_T1L_MIN_NS 180
+
+/* Uncomment to stream the strips instead of keeping a 9 byte/LED strip buffer.
+ * Each SPI DMA runs circular over a ring of 2 x LED_STREAM_RING_LEDS LEDs and the
+ * half/full-transfer interrupts encode the next LEDs straight from the framebuffer,
+ * so strip RAM no longer grows with the LED count. Needs the ISR to keep up (one
+ * half is ~220 us at the current SPI clocks), no dirty tracking here.
+ * Without LED_RENDER_PIPELINE a frame drawn while streaming can tear.
+ */
+//#define LED_RENDER_STREAM
+//#define LED_STREAM_RING_LEDS 8
+
+/* Uncomment to drive the strips from GPIO pins instead of the 3 SPIs.
+ * TIM1 paces DMA2 writes into the port's BSRR, so up to 16 strips run in parallel
+ * and every strip only carries total/LED_GPIO_STRIPS LEDs (higher refresh rate).
+ * Strip s is the s-th pin set in LED_GPIO_PIN_MASK (default PB0..PB7).
+ * Uses TIM1 and DMA2 streams 1, 2 and 6. Not combinable with LED_RENDER_STREAM.
+ */
+//#define LED_OUTPUT_GPIO
+//#define LED_GPIO_STRIPS    8
+//#define LED_GPIO_PORT      GPIOB
+//#define LED_GPIO_PIN_MASK  0x00FFu
+
+/* Uncomment for clocked APA102 / SK9822 strips on the same 3 SPIs (SCK + MOSI).
+ * 4 bytes per LED instead of 9, no reset time, SPI re-clocked to at most
+ * LED_APA102_SPI_HZ: 240 LEDs per strip take ~0.8 ms, so raise FRAME_CLOCK_FPS.
+ * g_global_brightness becomes the 5-bit LED brightness field. These strips are
+ * usually wired BGR, set LED_COLOR_ORDER to match.
+ */
+//#define LED_OUTPUT_APA102
+//#define LED_APA102_SPI_HZ 12000000UL
+
+/* Uncomment for SK6812 RGBW strips: LED_COLOR_ORDER then names four channels
+ * ("GRBW" for most of them) and the encoder sends 4 instead of 3 channels,
+ * 12 instead of 9 bytes per LED at 3 SPI bits (720 pixels need
+ * LED_RENDER_MAX_ALLOC raised to ~20 kbytes). White is taken out of r, g and b
+ * while encoding (min of the three), the framebuffer stays RGB. A tinted W die
+ * is matched with LED_RGBW_WHITE_R / _G / _B (led_render.h). The
+ * LED_POWER_LIMIT_MA estimate keeps counting RGB, which is the upper bound.
+ * WS SPI output only, not with LED_OUTPUT_APA102 or LED_OUTPUT_GPIO.
+ */
+//#define LED_RGBW
+//#define LED_RGBW_WHITE_B 200
+
+/* Uncomment to calibrate the strips against each other (batches differ in
+ * white point): per strip and channel a gain and a gamma on the level that
+ * reaches the LED, folded into that strip's own encode tables when they are
+ * built, nothing more per LED. LED_STRIP_CAL_INIT holds the boot values,
+ * { { gain r, g, b }, { gamma r, g, b } } per strip, 0 or left out = as is;
+ * "cal <strip> <r|g|b|w> <gain> <gamma>" tries others at run time. Each strip
+ * takes 3.75 kbytes more of the scene pool (3 SPI bits, 5 kbytes RGBW), raise
+ * LED_RENDER_MAX_ALLOC to match, the default SCENE_MEM_BYTES follows. WS SPI
+ * output only.
+ */
+//#define LED_STRIP_CAL
+//#define LED_STRIP_CAL_INIT { { { 1.0f, 0.95f, 0.90f }, { 0 } }, { { 0 }, { 1.0f, 1.0f, 1.1f } } }
+
+/* Uncomment to send the SPI strips as 16 bit frames. The TX DMAs move halfwords
+ * through their FIFO and read memory in 4-beat bursts: one bus request per 8
+ * strip bytes instead of one per byte, so the animation drawn meanwhile loses
+ * less of the bus. The encoder writes the strip buffer in halfword order, and
+ * each strip is padded to whole bursts (up to 7 more latch / end frame bytes).
+ * Not with LED_RENDER_STREAM or LED_OUTPUT_GPIO.
+ */
+//#define LED_SPI_16BIT
+
+/* Uncomment on one board of a multi-board build (led_link.h): it animates the
+ * whole scene and sends every node its LED range over USART1 (PA9 → all node
+ * PA10s), PB12 latches them together. LED_LINK_NODES lists each node's LED
+ * count in wiring order, the scene's total must match. The master drives no
+ * strips and needs ~6 bytes of RAM per LED besides its framebuffer.
+ */
+//#define LED_LINK_MASTER
+//#define LED_LINK_NODES { 720, 720 }
+/* ... or on the nodes, each with its own LED_LINK_NODE number and scene.
+ * Uses DMA2 stream 2, not combinable with LED_OUTPUT_GPIO.
+ */
+//#define LED_LINK_SLAVE
+//#define LED_LINK_NODE 0
+
+
+/* Uncomment to cap the estimated strip current (mA). encode_frame() sums the
+ * drive levels of what it encodes, and the next frame is dimmed below
+ * g_global_brightness until the estimate fits the budget. Tune the model with
+ * LED_MA_PER_CHANNEL (default 20) and LED_IDLE_MA_PER_LED (default 1).
+ * Not available with LED_RENDER_STREAM.
+ */
+//#define LED_POWER_LIMIT_MA 10000
+
+/* Uncomment to measure what the limiter only estimates (supply.h): ADC1 scans
+ * a supply divider (PB0) and a current sensor (PB1) by DMA, the measured /
+ * modelled ratio corrects LED_POWER_LIMIT_MA's model and a sagging supply
+ * lowers its budget. The readings go out with the telemetry. Needs
+ * LED_POWER_LIMIT_MA, uses DMA2 stream 0, not combinable with LED_AUDIO.
+ */
+//#define LED_SUPPLY_MON
+
+/* Uncomment for temporal dithering: brightness + gamma are kept at 8.8 fixed
+ * point and every LED carries the fraction into the next frame, so dim gradients
+ * get in-between levels instead of collapsing to a few steps. Wants a high
+ * FRAME_CLOCK_FPS (a 1/4 level repeats every 4 frames). Costs 3 bytes per pixel,
+ * 720 pixels need LED_RENDER_MAX_ALLOC raised to ~18 kbytes.
+ * Not available with LED_RENDER_STREAM.
+ */
+//#define LED_RENDER_DITHER
+
+/* Cross-fade on mode changes (led_transition.h): the outgoing picture is kept
+ * as RGB565 (2 bytes per pixel, only while fading) and mixed over the incoming
+ * animation. Default 600 ms, 0 cuts. Not with overlay layers on.
+ */
+//#define ANIM_FADE_MS 600
+
+/* The animation and geometry code does its math in single precision through
+ * fast_math.h (table sine, polynomial atan2 / exp2 / log2, VSQRT). MATH_LIBM
+ * puts libm's float functions back, to see what the approximations change
+ * (the host build's goldens with and without).
+ */
+//#define MATH_LIBM
+
+/* Boot seed of the animation random streams (led_rng.h), every effect replays
+ * the same from the same seed. "seed <n>" changes it at runtime.
+ */
+//#define RNG_SEED 0xA5A5A5A5u
+
+/* Target frame rate of the TIM2 frame clock. The main loop renders one frame per
+ * tick, missed / late deadlines are counted (printed as #frameclock with
+ * LED_DEBUG_RENDER). Steady cadence looks better in the mirrors than peak fps.
+ */
+#define FRAME_CLOCK_FPS 60
+
+/* Trim the frame clock's rate to the host's USB start of frame (sof_lock.h):
+ * frames streamed on the host's clock are shown at a constant latency, none
+ * doubled or dropped as the two crystals drift. One SOF interrupt per ms.
+ * "sync" shows the trim.
+ */
+//#define FRAME_SOF_LOCK
+
+/* Sleep the core (WFI) between main loop passes, woken by the frame clock,
+ * the DMAs, USB and SysTick: less power and heat in the stand, and the time
+ * asleep is the SLEEP profiler zone, i.e. the load (idle.h). Comment out to
+ * spin as before.
+ */
+#define MAIN_LOOP_WFI
+
+/* FreeRTOS instead of the bare-metal main loop: render, anim and comms as
+ * tasks with preemption, frames handed over by queue, all static
+ * (rtos_app.h). Needs the FreeRTOS kernel (ARM_CM4F port) in the build and
+ * Core/Inc/FreeRTOSConfig.h; the task stacks take ~9 kB, shrink
+ * SCENE_MEM_BYTES to suit. The bare-metal loop has the lower latency.
+ */
+//#define LED_RTOS
+
+/* Draw the first animation frame as soon as the renderer is up, before USB is
+ * started and the frame clock runs: the sculpture lights right after power is
+ * applied instead of after enumeration setup and the first frame clock tick.
+ * boot_prof.h times every boot phase ("boot" on the console).
+ */
+#define BOOT_EARLY_FRAME
+
+/* Quality governor (led_governor.h): frames over GOV_HIGH_PCT of the period
+ * make the animations cheaper (minefield: fewer explosions, no sqrtf, half the
+ * LEDs per frame), a long run under GOV_LOW_PCT brings quality back.
+ * "quality <0-3>" pins a level, "quality auto" hands it back.
+ */
+//#define GOV_HIGH_PCT 85
+//#define GOV_LOW_PCT 50
+
+/* Clock scaling (clock_scale.h): a long run of frames under CLK_DOWN_PCT of
+ * the slot halves HCLK (84 → 42 → 21 MHz, AHB prescaler, PLL and USB
+ * untouched), the strip SPI prescalers and frame / latch timers re-derived
+ * for the same bit rate and period; a heavy frame puts it straight back.
+ * Cooler in the closed stand. "clock" shows it, "clock <0-2>" pins a level,
+ * "clock auto". WS SPI output only, not with audio, PC sampling, ITM, the
+ * board link or LED_RTOS.
+ */
+//#define LED_CLOCK_SCALE
+
+/* Skip frames that did not change: render_submit() runs the framebuffer through
+ * the CRC unit and neither encodes nor starts the DMAs when it matches the last
+ * frame sent. Strips still get refreshed every LED_REFRESH_MIN_MS (default 1000)
+ * in case one glitched. Comment out to always send.
+ */
+#define LED_RENDER_SKIP_UNCHANGED
+//#define LED_REFRESH_MIN_MS 1000
+
+
 /* Uncomment to overwrite the maximum allocation for framebuffers before it errors (sanity check sorta)
  * you need 24 bits (RGB 8 bits per color) per pixel, so 1000 pixel would need 3kbytes.
  * default limit is 16 kbytes
  */
 //#define LED_RENDER_MAX_ALLOC (16 * 1024) /* MAX ALLOCATION FOR BUFFERS */
 
+/* Uncomment to resize the static pool the scene is built in (geometry, mapping,
+ * distance tables, render / DMA buffers; scene_mem.h). "mem" on the console
+ * prints what it holds and the peak, size it to that with a little headroom.
+ * Default 38 kbytes: the 720 LED boot scene takes ~31, ~37 with the lazy tables;
+ * LED_RENDER_PIPELINE adds 3, a raised LED_RENDER_MAX_ALLOC what it is raised by.
+ * A lazy table that does not fit is logged.
+ */
+//#define SCENE_MEM_BYTES (38 * 1024)
+
+/* Interrupts on a stack of their own, this many bytes (multiple of 8, in .bss):
+ * the main loop and the interrupts then get separate high water marks
+ * ("stack" on the console, telemetry, bench; stack_mon.h). Comment out for
+ * the one shared stack, its peak is still measured.
+ */
+#define STACK_IRQ_BYTES 1024
+
 
 #endif
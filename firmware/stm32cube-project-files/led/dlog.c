@@ -0,0 +1,52 @@
+/* --------------------------------------------------------------------------
+ * dlog.c – argument packing for DLOG(), one packet per entry
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "dlog.h"
+#include "usb_packet.h"      /* usb_packet_send, PKT_LOG */
+
+#ifdef LOG_DEFERRED
+
+/* an argument that does not fit is left out, the host marks the line */
+static void put(DlogArgs *a, const void *v, uint8_t n)
+{
+    if (n > DLOG_BYTES_MAX - a->n) {
+        a->n = DLOG_BYTES_MAX;
+        return;
+    }
+    memcpy(&a->b[a->n], v, n);
+    a->n += n;
+}
+
+void dlog_u(DlogArgs *a, uint32_t v) { put(a, &v, 4); }
+
+void dlog_f(DlogArgs *a, float v)
+{
+    put(a, &v, 4);
+}
+
+void dlog_p(DlogArgs *a, const void *p)
+{
+    uint32_t v = (uint32_t)(uintptr_t)p;
+    put(a, &v, 4);
+}
+
+void dlog_s(DlogArgs *a, const char *s)
+{
+    if (!s) s = "(null)";
+    size_t  len = strlen(s);
+    uint8_t n   = (uint8_t)(len < 255u ? len : 255u);
+    put(a, &n, 1);
+    put(a, s, n);
+}
+
+void dlog_emit(const char *fmt, const DlogArgs *a)
+{
+    uint8_t  p[4 + DLOG_BYTES_MAX];
+    uint32_t id = (uint32_t)(uintptr_t)fmt;     /* address in .logstr */
+    memcpy(p, &id, 4);
+    memcpy(&p[4], a->b, a->n);
+    usb_packet_send(PKT_LOG, p, (uint8_t)(4u + a->n));
+}
+
+#endif /* LOG_DEFERRED */
@@ -0,0 +1,99 @@
+/*
+ * dlog.h – deferred logging: the host formats, the MCU only copies
+ *
+ * DLOG(fmt, ...) is USBD_UsrLog() without the printf: the format string goes
+ * into .logstr, a section the linker keeps in the ELF but not in flash, and
+ * the log entry is a PKT_LOG packet (usb_packet.h) holding its address and
+ * the raw arguments. app/serial_manager.py reads the strings out of the ELF
+ * it is given and prints the line where the packet was, so #tags# parse as
+ * before.
+ *
+ * Arguments are packed by type (_Generic): integers as 32 bit (the format
+ * says signed or not), float and double as float32, strings as a length
+ * byte and the bytes. The format takes the usual conversions (d i u x X o
+ * c s p e f g with flags, width, precision, l / h / z modifiers), but no
+ * '*' widths. At most DLOG_ARGS_MAX arguments, main loop only (it shares
+ * the packet TX buffer).
+ *
+ * DLOG() ends the line like USBD_UsrLog(), DLOG_RAW() does not (for lines
+ * built in pieces). Without LOG_DEFERRED both print as text again.
+ */
+
+#ifndef _DLOG_H_
+#define _DLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "config.h"
+#include "usb_comms.h"       /* USBD_UsrLog, printf retarget */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLOG_ARGS_MAX           12
+#define DLOG_BYTES_MAX          251     /* PKT_PAYLOAD_MAX - the format id */
+
+#ifdef LOG_DEFERRED
+
+typedef struct {
+    uint8_t n;
+    uint8_t b[DLOG_BYTES_MAX];
+} DlogArgs;
+
+void dlog_u(DlogArgs *a, uint32_t v);
+void dlog_f(DlogArgs *a, float v);     /* a double is narrowed at the call */
+void dlog_s(DlogArgs *a, const char *s);
+void dlog_p(DlogArgs *a, const void *p);
+void dlog_emit(const char *fmt, const DlogArgs *a);
+
+#define DLOG_PUT(x) _Generic((x),                                   \
+        float:        dlog_f,  double:       dlog_f,                \
+        char *:       dlog_s,  const char *: dlog_s,                \
+        void *:       dlog_p,  const void *: dlog_p,                \
+        default:      dlog_u)(&dlog_a_, (x));
+
+#define DLOG_(nl, fmt, ...) do {                                                    \
+        static const char dlog_f_[] __attribute__((section(".logstr"), used)) = fmt nl; \
+        DlogArgs dlog_a_;                                                           \
+        dlog_a_.n = 0;                                                              \
+        DLOG_EACH(__VA_ARGS__)                                                      \
+        dlog_emit(dlog_f_, &dlog_a_);                                               \
+    } while (0)
+
+#define DLOG(fmt, ...)          DLOG_("\n", fmt, ##__VA_ARGS__)
+#define DLOG_RAW(fmt, ...)      DLOG_("",   fmt, ##__VA_ARGS__)
+
+/* DLOG_PUT for each argument, 0..DLOG_ARGS_MAX of them */
+#define DLOG_NARGS(...)         DLOG_NARGS_(0, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+#define DLOG_CAT(a, b)          DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b)         a##b
+#define DLOG_EACH(...)          DLOG_CAT(DLOG_EACH_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define DLOG_EACH_0()
+#define DLOG_EACH_1(x)          DLOG_PUT(x)
+#define DLOG_EACH_2(x, ...)     DLOG_PUT(x) DLOG_EACH_1(__VA_ARGS__)
+#define DLOG_EACH_3(x, ...)     DLOG_PUT(x) DLOG_EACH_2(__VA_ARGS__)
+#define DLOG_EACH_4(x, ...)     DLOG_PUT(x) DLOG_EACH_3(__VA_ARGS__)
+#define DLOG_EACH_5(x, ...)     DLOG_PUT(x) DLOG_EACH_4(__VA_ARGS__)
+#define DLOG_EACH_6(x, ...)     DLOG_PUT(x) DLOG_EACH_5(__VA_ARGS__)
+#define DLOG_EACH_7(x, ...)     DLOG_PUT(x) DLOG_EACH_6(__VA_ARGS__)
+#define DLOG_EACH_8(x, ...)     DLOG_PUT(x) DLOG_EACH_7(__VA_ARGS__)
+#define DLOG_EACH_9(x, ...)     DLOG_PUT(x) DLOG_EACH_8(__VA_ARGS__)
+#define DLOG_EACH_10(x, ...)    DLOG_PUT(x) DLOG_EACH_9(__VA_ARGS__)
+#define DLOG_EACH_11(x, ...)    DLOG_PUT(x) DLOG_EACH_10(__VA_ARGS__)
+#define DLOG_EACH_12(x, ...)    DLOG_PUT(x) DLOG_EACH_11(__VA_ARGS__)
+
+#else
+
+#define DLOG(...)               do { USBD_UsrLog(__VA_ARGS__); } while (0)
+#define DLOG_RAW(...)           printf(__VA_ARGS__)
+
+#endif /* LOG_DEFERRED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DLOG_H_ */
@@ -0,0 +1,98 @@
+/* --------------------------------------------------------------------------
+ * dma_mem.c – DMA2 Stream0 memory-to-memory jobs
+ * -------------------------------------------------------------------------- */
+#include "dma_mem.h"
+#include "profiler.h"
+#include "irq_stats.h"
+
+#include <string.h>
+
+#define MEM_DMA          DMA2_Stream0
+/* all interrupt flags of stream 0 (FEIF, DMEIF, TEIF, HTIF, TCIF) */
+#define MEM_DMA_FLAGS    0x3Du
+
+static volatile bool busy = false;
+static uint32_t      fill_word;        /* source of a fill, must outlive the job */
+
+void dma_mem_init(void)
+{
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    MEM_DMA->CR &= ~DMA_SxCR_EN;
+    while (MEM_DMA->CR & DMA_SxCR_EN) { }
+    DMA2->LIFCR = MEM_DMA_FLAGS;
+    busy = false;
+
+    /* below the strip DMAs (2), a clear may wait, the wire may not */
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * In memory-to-memory mode the peripheral port is the source. FIFO is
+ * mandatory there, 4-beat bursts on both sides when the addresses allow.
+ */
+static bool mem_start(uint8_t *dst, const uint8_t *src, size_t bytes, bool src_inc)
+{
+    size_t words = bytes / 4;
+    if (busy || words > 0xFFFF) return false;
+    if (!words) return true;
+
+    busy = true;
+    DMA2->LIFCR   = MEM_DMA_FLAGS;
+    MEM_DMA->PAR  = (uint32_t)src;
+    MEM_DMA->M0AR = (uint32_t)dst;
+    MEM_DMA->NDTR = (uint16_t)words;
+    MEM_DMA->FCR  = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH;          /* full FIFO */
+    MEM_DMA->CR   = DMA_SxCR_DIR_1                             /* memory → memory */
+                  | DMA_SxCR_PSIZE_1 | DMA_SxCR_MSIZE_1        /* 32 bit */
+                  | DMA_SxCR_MBURST_0
+                  | (src_inc ? DMA_SxCR_PINC | DMA_SxCR_PBURST_0 : 0)
+                  | DMA_SxCR_MINC
+                  | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    MEM_DMA->CR  |= DMA_SxCR_EN;
+    return true;
+}
+
+bool dma_mem_copy(void *dst, const void *src, size_t bytes)
+{
+    uint8_t       *d = dst;
+    const uint8_t *s = src;
+    size_t body = bytes & ~(size_t)3;
+
+    if (!mem_start(d, s, body, true)) return false;
+    memcpy(d + body, s + body, bytes - body);
+    return true;
+}
+
+bool dma_mem_fill(void *dst, uint32_t word, size_t bytes)
+{
+    if (busy) return false;                 /* fill_word is still being read */
+    uint8_t *d    = dst;
+    size_t   body = bytes & ~(size_t)3;
+
+    fill_word = word;
+    if (!mem_start(d, (const uint8_t *)&fill_word, body, false)) return false;
+    memcpy(d + body, &fill_word, bytes - body);
+    return true;
+}
+
+bool dma_mem_busy(void)
+{
+    return busy;
+}
+
+void dma_mem_wait(void)
+{
+    if (!busy) return;
+    PROF_BEGIN(DMA_WAIT);
+    while (busy) { }
+    PROF_END(DMA_WAIT);
+}
+
+void DMA2_Stream0_IRQHandler(void)
+{
+    IRQ_ENTER(MEM_DMA);
+    DMA2->LIFCR = MEM_DMA_FLAGS;
+    busy = false;                           /* done or transfer error, either way it stopped */
+    IRQ_EXIT(MEM_DMA);
+}
@@ -0,0 +1,55 @@
+/*
+ * dma_mem.h – background memory fills / copies on a spare DMA2 stream
+ *
+ * Only DMA2 can do memory-to-memory. Stream 0 is free in every build
+ * (SPI1 TX sits on stream 5, LED_OUTPUT_GPIO uses 1, 2 and 6).
+ * One job at a time, word transfers; the < 4 byte tail is done by the CPU
+ * right away. Buffers must be word aligned (malloc'd and scene_alloc'd ones are).
+ */
+
+#ifndef _DMA_MEM_H_
+#define _DMA_MEM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "stm32f4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Clock and IRQ for the stream, safe to call again.
+ */
+void dma_mem_init(void);
+
+/**
+ * Copy bytes from src to dst in the background. Overlap only works forward
+ * and with dst >= src + 32 (reads run up to the 16 byte FIFO plus one burst
+ * ahead of the writes), enough to replicate a pattern seeded at src.
+ * @return false if a job is still running or the length is out of range
+ */
+bool dma_mem_copy(void *dst, const void *src, size_t bytes);
+
+/**
+ * Fill bytes at dst with a repeated 32-bit word in the background.
+ * @return false if a job is still running or the length is out of range
+ */
+bool dma_mem_fill(void *dst, uint32_t word, size_t bytes);
+
+/**
+ * True while a job is running
+ */
+bool dma_mem_busy(void);
+
+/**
+ * Block until the running job (if any) is done.
+ */
+void dma_mem_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DMA_MEM_H_ */
@@ -0,0 +1,147 @@
+/*
+ * fast_math.h – single-precision math for the animation and geometry code
+ *
+ * The M4F's FPU does float only: a double, or a libm call that takes one,
+ * runs in software, and even the float libm functions carry errno and
+ * range-reduction paths the LEDs do not need. These stay in float and
+ * inline:
+ *
+ *   fm_sinf / fm_cosf      quarter-wave table (lut.h), linear   abs < 2e-5
+ *   fm_atan2f              octant reduction, odd polynomial      abs < 3e-6 rad
+ *   fm_asinf / fm_acosf    through fm_atan2f                     abs < 3e-6 rad
+ *   fm_sqrtf               VSQRT, one instruction, no errno      exact
+ *   fm_rsqrtf              bit guess and two Newton steps        rel < 5e-6
+ *   fm_exp2f / fm_log2f    polynomials on the reduced argument   < 5e-7
+ *   fm_powf                fm_exp2f(y · fm_log2f(x)), x > 0       rel < 1e-5
+ *
+ * MATH_LIBM (config.h) maps each onto libm's float function instead, to
+ * measure what the approximations cost: record the host build's goldens
+ * with it, check without (tools/host, "make golden" / "make check").
+ * Tables built once at init keep libm's exact values.
+ */
+
+#ifndef _FAST_MATH_H_
+#define _FAST_MATH_H_
+
+#include <math.h>
+#include <stdint.h>
+#include "config.h"
+#include "lut.h"            /* lut_sinf */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FM_PI       3.14159265f
+#define FM_PI_2     1.57079633f
+#define FM_2PI      6.28318531f
+
+#ifdef MATH_LIBM
+
+static inline float fm_sinf(float x)             { return sinf(x); }
+static inline float fm_cosf(float x)             { return cosf(x); }
+static inline float fm_atan2f(float y, float x)  { return atan2f(y, x); }
+static inline float fm_asinf(float x)            { return asinf(x); }
+static inline float fm_acosf(float x)            { return acosf(x); }
+static inline float fm_sqrtf(float x)            { return sqrtf(x); }
+static inline float fm_rsqrtf(float x)           { return 1.0f / sqrtf(x); }
+static inline float fm_exp2f(float x)            { return exp2f(x); }
+static inline float fm_log2f(float x)            { return log2f(x); }
+static inline float fm_powf(float x, float y)    { return powf(x, y); }
+
+#else
+
+static inline float fm_sinf(float x) { return lut_sinf(x); }
+static inline float fm_cosf(float x) { return lut_cosf(x); }
+
+static inline float fm_sqrtf(float x)
+{
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+    float r;
+    __asm__ ("vsqrt.f32 %0, %1" : "=t"(r) : "t"(x));
+    return r;
+#else
+    return sqrtf(x);
+#endif
+}
+
+static inline float fm_rsqrtf(float x)
+{
+    union { float f; uint32_t i; } u = { x };
+    u.i = 0x5F375A86u - (u.i >> 1);
+    float h = 0.5f * x, y = u.f;
+    y *= 1.5f - h * y * y;
+    y *= 1.5f - h * y * y;
+    return y;
+}
+
+/* atan on [0, 1] (Abramowitz & Stegun 4.4.49) */
+static inline float fm_atan_unit(float z)
+{
+    float s = z * z;
+    return z * (0.99997726f + s * (-0.33262347f + s * (0.19354346f +
+               s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+}
+
+static inline float fm_atan2f(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float hi = ax > ay ? ax : ay, lo = ax > ay ? ay : ax;
+    if (hi == 0.0f) return 0.0f;
+    float a = fm_atan_unit(lo / hi);
+    if (ay > ax)   a = FM_PI_2 - a;
+    if (x < 0.0f)  a = FM_PI - a;
+    return y < 0.0f ? -a : a;
+}
+
+static inline float fm_asinf(float x)
+{
+    float c = 1.0f - x * x;
+    return fm_atan2f(x, fm_sqrtf(c > 0.0f ? c : 0.0f));
+}
+
+static inline float fm_acosf(float x)
+{
+    float c = 1.0f - x * x;
+    return fm_atan2f(fm_sqrtf(c > 0.0f ? c : 0.0f), x);
+}
+
+/* 2^x: the nearest integer into the exponent, 2^f for |f| <= 1/2 by its
+ * series (ln2^k / k!, the 7th term is under 2e-7) */
+static inline float fm_exp2f(float x)
+{
+    if (x < -126.0f) return 0.0f;
+    if (x >  127.0f) return INFINITY;
+    int32_t i = (int32_t)(x + (x >= 0.0f ? 0.5f : -0.5f));
+    float   f = x - (float)i;
+    float   p = 1.0f + f * (0.69314718f + f * (0.24022651f + f * (0.05550411f +
+                f * (0.00961813f + f * (0.00133336f + f * 0.00015404f)))));
+    union { uint32_t i; float f; } u = { (uint32_t)(i + 127) << 23 };
+    return u.f * p;
+}
+
+/* log2 x, x > 0 normal: mantissa into [√½, √2), 2/ln2 · atanh((m-1)/(m+1)) */
+static inline float fm_log2f(float x)
+{
+    union { float f; uint32_t i; } u = { x };
+    int32_t e = (int32_t)((u.i >> 23) & 0xFF) - 127;
+    u.i = (u.i & 0x7FFFFFu) | 0x3F800000u;          /* m in [1, 2) */
+    if (u.f > 1.41421356f) { u.f *= 0.5f; ++e; }
+    float s = (u.f - 1.0f) / (u.f + 1.0f), s2 = s * s;
+    float t = s * (2.0f + s2 * (0.66666667f + s2 * (0.4f + s2 * 0.28571429f)));
+    return (float)e + t * 1.44269504f;
+}
+
+static inline float fm_powf(float x, float y)
+{
+    if (x <= 0.0f) return x == 0.0f ? 0.0f : NAN;
+    return fm_exp2f(y * fm_log2f(x));
+}
+
+#endif /* MATH_LIBM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FAST_MATH_H_ */
@@ -0,0 +1,204 @@
+/* --------------------------------------------------------------------------
+ * flash_store.c – append-only records in FLASH_STORE_SECTOR, CRC checked
+ * -------------------------------------------------------------------------- */
+#include "flash_store.h"
+#include "crc.h"                 /* hcrc (MX_CRC_Init) */
+
+#include <string.h>
+
+#define STORE_MAGIC     0x5354524Fu            /* "OTRS" */
+#define ERASED          0xFFFFFFFFu
+#define PAYLOAD_WORDS   ((FLASH_STORE_MAX_LEN + 3) / 4)
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Record = header + payload padded to words. Programmed in address order
+ * with crc last, so a record cut short by a reset never validates.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t key;
+    uint16_t len;
+    uint32_t seq;          /* newest wins */
+    uint32_t crc;          /* over magic, key/len, seq and the padded payload */
+} StoreHdr;
+
+#define HDR_WORDS    (sizeof(StoreHdr) / 4)
+#define REC_WORDS(l) (HDR_WORDS + ((uint32_t)(l) + 3) / 4)
+
+static uint32_t staging[PAYLOAD_WORDS];         /* padded payload / CRC input */
+static struct { uint16_t key, len; uint32_t data[PAYLOAD_WORDS]; } carry[FLASH_STORE_KEYS];
+
+static inline const uint32_t *sector_word(uint32_t w)
+{
+    return (const uint32_t *)(FLASH_STORE_ADDR + 4 * w);
+}
+
+static uint32_t record_crc(const StoreHdr *h, const uint32_t *payload)
+{
+    uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)h, 3);   /* not the crc word */
+    uint32_t n   = (h->len + 3) / 4;
+    if (n) crc = HAL_CRC_Accumulate(&hcrc, (uint32_t *)payload, n);
+    return crc;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Walk the records. Stops at erased space (returned as the write offset) or
+ * at anything that is not a header, then the sector counts as full.
+ * For every valid record of `key` (any key if 0) calls back with it.
+ */
+typedef void (*record_fn)(const StoreHdr *h, const uint32_t *payload, void *ctx);
+
+static uint32_t scan(record_fn fn, void *ctx)
+{
+    const uint32_t total = FLASH_STORE_SIZE / 4;
+    uint32_t w = 0;
+    while (w + HDR_WORDS <= total) {
+        const StoreHdr *h = (const StoreHdr *)sector_word(w);
+        if (h->magic == ERASED) return w;
+        if (h->magic != STORE_MAGIC || h->len > FLASH_STORE_MAX_LEN
+            || w + REC_WORDS(h->len) > total) break;
+
+        const uint32_t *payload = sector_word(w + HDR_WORDS);
+        if (h->crc == record_crc(h, payload) && fn) fn(h, payload, ctx);
+        w += REC_WORDS(h->len);
+    }
+    return total;                                /* full (or garbage) */
+}
+
+typedef struct { uint16_t key; uint16_t len; uint32_t seq; const uint32_t *payload; } Newest;
+
+static void find_newest(const StoreHdr *h, const uint32_t *payload, void *ctx)
+{
+    Newest *n = ctx;
+    if (h->key == n->key && h->len == n->len && (!n->payload || h->seq > n->seq)) {
+        n->seq     = h->seq;
+        n->payload = payload;
+    }
+}
+
+static void find_top_seq(const StoreHdr *h, const uint32_t *payload, void *ctx)
+{
+    (void)payload;
+    uint32_t *top = ctx;
+    if (h->seq > *top) *top = h->seq;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * newest record of every key into carry[], before an erase
+ */
+static void collect_carry(const StoreHdr *h, const uint32_t *payload, void *ctx)
+{
+    uint8_t *count = ctx;
+    for (uint8_t i = 0; i < *count; ++i) {
+        if (carry[i].key == h->key) {            /* later in the sector = newer */
+            carry[i].len = h->len;
+            memcpy(carry[i].data, payload, 4 * ((h->len + 3) / 4));
+            return;
+        }
+    }
+    if (*count == FLASH_STORE_KEYS) return;      /* out of slots, dropped */
+    carry[*count].key = h->key;
+    carry[*count].len = h->len;
+    memcpy(carry[*count].data, payload, 4 * ((h->len + 3) / 4));
+    ++*count;
+}
+
+static bool program_record(uint32_t w, uint16_t key, const uint32_t *payload,
+                           uint16_t len, uint32_t seq)
+{
+    StoreHdr h = { STORE_MAGIC, key, len, seq, 0 };
+    h.crc = record_crc(&h, payload);
+
+    const uint32_t *hw = (const uint32_t *)&h;
+    uint32_t addr = FLASH_STORE_ADDR + 4 * w;
+    for (uint32_t i = 0; i < 3; ++i, addr += 4)
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, hw[i]) != HAL_OK) return false;
+    addr += 4;                                   /* crc word, programmed last */
+    for (uint32_t i = 0; i < (len + 3u) / 4; ++i, addr += 4)
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, payload[i]) != HAL_OK) return false;
+    return HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, FLASH_STORE_ADDR + 4 * w + 12, h.crc) == HAL_OK;
+}
+
+static bool erase_sector(void)
+{
+    FLASH_EraseInitTypeDef er = {
+        .TypeErase    = FLASH_TYPEERASE_SECTORS,
+        .Sector       = FLASH_STORE_SECTOR,
+        .NbSectors    = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,   /* 2.7 – 3.6 V, word programming */
+    };
+    uint32_t bad = 0;
+    return HAL_FLASHEx_Erase(&er, &bad) == HAL_OK;
+}
+
+/* keep the newest record of every key but skip, erase, write them back;
+ * w: where the next goes, top: the sequence numbers so far (flash unlocked) */
+static bool compact(uint16_t skip, uint32_t *w, uint32_t *top)
+{
+    uint8_t count = 0;
+    scan(collect_carry, &count);
+    bool ok = erase_sector();
+    *w = 0;
+    for (uint8_t i = 0; ok && i < count; ++i) {
+        if (carry[i].key == skip) continue;      /* replaced by the caller */
+        ok = program_record(*w, carry[i].key, carry[i].data, carry[i].len, ++*top);
+        *w += REC_WORDS(carry[i].len);
+    }
+    return ok;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * PUBLIC API
+ */
+bool flash_store_get(uint16_t key, void *buf, uint16_t len)
+{
+    if (len > FLASH_STORE_MAX_LEN) return false;
+    Newest n = { key, len, 0, NULL };
+    scan(find_newest, &n);
+    if (!n.payload) return false;
+    memcpy(buf, n.payload, len);
+    return true;
+}
+
+bool flash_store_put(uint16_t key, const void *buf, uint16_t len)
+{
+    if (len > FLASH_STORE_MAX_LEN) return false;
+
+    memset(staging, 0xFF, sizeof staging);
+    memcpy(staging, buf, len);
+
+    uint32_t top = 0;
+    uint32_t w   = scan(find_top_seq, &top);
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    bool ok = true;
+    if (w + REC_WORDS(len) > FLASH_STORE_SIZE / 4) {
+        ok = compact(key, &w, &top);             /* full */
+    }
+    if (ok) ok = program_record(w, key, staging, len, ++top);
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+bool flash_store_erase(void)
+{
+    HAL_FLASH_Unlock();
+    bool ok = erase_sector();
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+bool flash_store_erase_keep(void)
+{
+    uint32_t top = 0, w;
+    scan(find_top_seq, &top);
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    bool ok = compact(0, &w, &top);
+    HAL_FLASH_Lock();
+    return ok;
+}
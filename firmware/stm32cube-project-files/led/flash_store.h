@@ -0,0 +1,83 @@
+/*
+ * flash_store.h – small key/value records in a reserved flash sector
+ *
+ * Records are appended to the sector (wear levelling: it is only erased
+ * once full, then the newest record of every key is carried over) and each
+ * one is checked with the CRC unit, so a torn write just reads as absent.
+ * The sector is cut off the FLASH region in the linker script.
+ *
+ * With LED_CLIP the records keep only the first FLASH_STORE_SIZE of the
+ * sector, clip.h has the rest. Both go with an erase: the store carrying
+ * its records over when it fills drops the clip, an upload writes the
+ * records back (flash_store_erase_keep).
+ */
+
+#ifndef _FLASH_STORE_H_
+#define _FLASH_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx_hal.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* STM32F401CC: sector 5, the upper 128 kB (must match the linker script) */
+#ifndef FLASH_STORE_SECTOR
+  #define FLASH_STORE_SECTOR    FLASH_SECTOR_5
+  #define FLASH_STORE_ADDR      0x08020000UL
+  #define FLASH_SECTOR_BYTES    (128UL * 1024)
+#endif
+/* the records' part of it, the clip (LED_CLIP) has the rest */
+#ifndef FLASH_STORE_SIZE
+  #ifdef LED_CLIP
+    #define FLASH_STORE_SIZE    (16UL * 1024)
+  #else
+    #define FLASH_STORE_SIZE    FLASH_SECTOR_BYTES
+  #endif
+#endif
+
+/* largest payload, and how many keys survive an erase */
+#ifndef FLASH_STORE_MAX_LEN
+  #define FLASH_STORE_MAX_LEN   256
+#endif
+#ifndef FLASH_STORE_KEYS
+  #define FLASH_STORE_KEYS      5
+#endif
+
+/* keys in use */
+#define STORE_KEY_MAPPING       0x4D50u     /* "MP": edge map + flip map */
+
+/**
+ * Newest valid record of a key.
+ * @param buf  Filled with the payload
+ * @param len  Expected payload length, records of another length don't match
+ * @return false if there is none (never saved, CRC mismatch, torn write)
+ */
+bool flash_store_get(uint16_t key, void *buf, uint16_t len);
+
+/**
+ * Append a record. Blocks while programming (a few ms), and for the sector
+ * erase (~1-2 s, CPU stalls on flash reads) when the sector is full.
+ * @return false on a flash error or len > FLASH_STORE_MAX_LEN
+ */
+bool flash_store_put(uint16_t key, const void *buf, uint16_t len);
+
+/**
+ * Erase the sector, every key reads as absent afterwards.
+ */
+bool flash_store_erase(void);
+
+/**
+ * Erase the sector and write the newest record of every key back: the
+ * space past FLASH_STORE_SIZE is blank for the clip. Blocks ~1-2 s.
+ */
+bool flash_store_erase_keep(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FLASH_STORE_H_ */
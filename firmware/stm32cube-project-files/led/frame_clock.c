@@ -0,0 +1,185 @@
+/* --------------------------------------------------------------------------
+ * frame_clock.c – TIM2 frame clock with deadline bookkeeping
+ * -------------------------------------------------------------------------- */
+#include "frame_clock.h"
+#include "irq_stats.h"
+#include "blackbox.h"       /* bb_frame */
+
+#include <string.h>
+
+#ifdef LED_DEBUG_RENDER
+#include "usb_comms.h"   /* USBD_UsrLog() */
+#endif
+
+static volatile uint32_t ticks_pending = 0;   /* raised by the TIM2 ISR */
+static volatile uint32_t tick_cyc      = 0;   /* DWT->CYCCNT at the last tick */
+static FrameClockStats   stats;
+static uint32_t          slot_us;               /* this slot's length, trimmed */
+static int32_t           trim_ppm;              /* frame_clock_set_trim */
+static int32_t           trim_acc;              /* ppm × µs not yet in a slot */
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * TIM2 runs off APB1, doubled when APB1 is divided (84 MHz here).
+ */
+static uint32_t tim2_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE1) ? 2 * pclk : pclk;
+}
+
+bool frame_clock_init(uint16_t fps)
+{
+    if (fps == 0 || fps > 1000) return false;
+
+    memset(&stats, 0, sizeof stats);
+    stats.period_us = 1000000UL / fps;
+    slot_us         = stats.period_us;
+    ticks_pending   = 0;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    TIM2->CR1  = 0;
+    TIM2->PSC  = tim2_clock() / 1000000UL - 1;     /* 1 MHz */
+    TIM2->ARR  = stats.period_us - 1;
+    TIM2->CNT  = 0;
+    TIM2->EGR  = TIM_EGR_UG;                       /* load PSC and ARR */
+    TIM2->SR   = 0;
+    TIM2->DIER = TIM_DIER_UIE;
+
+    /* below the strip DMAs (2), they must never wait on the frame clock */
+    HAL_NVIC_SetPriority(TIM2_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+    /* ARR preloaded: a new period starts with the next slot, never cuts
+     * the running one short of CNT */
+    TIM2->CR1  = TIM_CR1_ARPE | TIM_CR1_CEN;
+    return true;
+}
+
+void frame_clock_reclock(void)
+{
+    /* PSC only loads on an update: force one, URS keeps it from being a
+     * tick, and put the count back */
+    uint32_t cnt = TIM2->CNT;
+    TIM2->CR1 |= TIM_CR1_URS;
+    TIM2->PSC  = tim2_clock() / 1000000UL - 1;
+    TIM2->EGR  = TIM_EGR_UG;
+    TIM2->CNT  = cnt;
+    TIM2->CR1 &= ~TIM_CR1_URS;
+}
+
+void TIM2_IRQHandler(void)
+{
+    IRQ_ENTER(FRAME_TIM);
+    tick_cyc = DWT->CYCCNT;
+    TIM2->SR = 0;
+    ticks_pending++;
+    frame_clock_tick_hook();
+    IRQ_EXIT(FRAME_TIM);
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Tick hook, override in the application (runs in the ISR).
+ */
+__weak void frame_clock_tick_hook(void)
+{
+}
+
+/* the period in TIM2 µs, trimmed; the fraction of a µs is carried over to
+ * the next slot, so the slots average out exact */
+static uint32_t trimmed_period(void)
+{
+    trim_acc += (int32_t)stats.period_us * trim_ppm;
+    int32_t whole = trim_acc / 1000000;
+    trim_acc -= whole * 1000000;
+    return (uint32_t)((int32_t)stats.period_us + whole);
+}
+
+void frame_clock_set_period(uint32_t us)
+{
+    if (us < 1000 || us > 1000000UL) return;
+    stats.period_us = us;
+    slot_us   = trimmed_period();
+    TIM2->ARR = slot_us - 1;
+}
+
+void frame_clock_set_trim(int32_t ppm)
+{
+    if (ppm >  FRAME_TRIM_MAX_PPM) ppm =  FRAME_TRIM_MAX_PPM;
+    if (ppm < -FRAME_TRIM_MAX_PPM) ppm = -FRAME_TRIM_MAX_PPM;
+    trim_ppm = ppm;
+}
+
+int32_t frame_clock_trim(void)
+{
+    return trim_ppm;
+}
+
+void frame_clock_adjust(int32_t us)
+{
+    int32_t p = (int32_t)slot_us + us;
+    if (p < (int32_t)stats.period_us / 2)     p = (int32_t)stats.period_us / 2;
+    if (p > (int32_t)stats.period_us * 3 / 2) p = (int32_t)stats.period_us * 3 / 2;
+    TIM2->ARR = (uint32_t)p - 1;
+}
+
+uint32_t frame_clock_tick_cyc(void)
+{
+    return tick_cyc;
+}
+
+bool frame_clock_begin(void)
+{
+    __disable_irq();
+    uint32_t pending = ticks_pending;
+    ticks_pending = 0;
+    __enable_irq();
+
+    if (!pending) return false;
+    slot_us   = trimmed_period();
+    TIM2->ARR = slot_us - 1;                       /* undo frame_clock_adjust() */
+    stats.missed += pending - 1;
+    stats.frames++;
+    return true;
+}
+
+bool frame_clock_pending(void)
+{
+    return ticks_pending != 0;
+}
+
+uint32_t frame_clock_slack_us(void)
+{
+    uint32_t cnt = TIM2->CNT;
+    if (ticks_pending || cnt >= stats.period_us) return 0;
+    return stats.period_us - cnt;
+}
+
+void frame_clock_end(void)
+{
+    /* CNT restarts every tick, so it is the time spent into this slot */
+    uint32_t used = TIM2->CNT;
+    bool     late = ticks_pending != 0;
+    if (late) {
+        stats.late++;
+        used = stats.period_us;                    /* ran past the slot */
+    }
+    stats.work_us = used;
+    if (used > stats.work_us_max) stats.work_us_max = used;
+    bb_frame(stats.frames, used, late);
+
+#ifdef LED_DEBUG_RENDER // ───────────────────────────────────────────────────────
+    static uint32_t last_print = 0;
+    uint32_t now = HAL_GetTick();
+    if ((now - last_print) >= 1000) {
+        USBD_UsrLog("#frameclock missed=%lu late=%lu work=%lu/%lu#",
+                    (unsigned long)stats.missed, (unsigned long)stats.late,
+                    (unsigned long)stats.work_us_max, (unsigned long)stats.period_us);
+        last_print = now;
+    }
+#endif // ───────────────────────────────────────────────────────────────────────
+}
+
+const FrameClockStats *frame_clock_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,119 @@
+/*
+ * frame_clock.h – TIM2 driven fixed-cadence frame clock
+ *
+ * TIM2 ticks at FRAME_CLOCK_FPS; the main loop runs one anim → encode → DMA
+ * frame per tick and the clock keeps score of deadlines that were missed.
+ * frame_sync.h steers it onto a host's frame clock: one slot at a time made
+ * longer or shorter, the period taken from the host. sof_lock.h trims its
+ * rate onto the host's USB clock.
+ */
+
+#ifndef _FRAME_CLOCK_H_
+#define _FRAME_CLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx_hal.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* target frame rate */
+#ifndef FRAME_CLOCK_FPS
+  #define FRAME_CLOCK_FPS   60
+#endif
+
+/* most a trim may correct; a crystal is off by 50 ppm or so */
+#ifndef FRAME_TRIM_MAX_PPM
+  #define FRAME_TRIM_MAX_PPM 1000
+#endif
+
+/**
+ * Frame clock bookkeeping
+ */
+typedef struct {
+    uint32_t frames;        /* frames started                                   */
+    uint32_t missed;        /* ticks that passed without a frame                */
+    uint32_t late;          /* frames still busy when the next tick came        */
+    uint32_t work_us;       /* anim + encode + DMA launch time of the last frame */
+    uint32_t work_us_max;   /* worst case since init                            */
+    uint32_t period_us;     /* 1e6 / fps                                        */
+} FrameClockStats;
+
+/**
+ * Start TIM2 at the given rate (1 µs resolution).
+ * @param fps  Target frames per second (1…1000)
+ * @return false if fps is out of range
+ */
+bool frame_clock_init(uint16_t fps);
+
+/**
+ * Poll from the main loop: true once per tick, then run the frame and
+ * call frame_clock_end(). Ticks that piled up count as missed.
+ */
+bool frame_clock_begin(void);
+
+/**
+ * A tick came that frame_clock_begin() has not taken yet (ISR safe read)
+ */
+bool frame_clock_pending(void);
+
+/**
+ * µs left until the next tick (by the nominal period), 0 once it came
+ */
+uint32_t frame_clock_slack_us(void);
+
+/**
+ * Frame work done, checks it against the next tick (deadline).
+ */
+void frame_clock_end(void);
+
+/**
+ * New nominal period (1 ms … 1 s), from the next slot on
+ */
+void frame_clock_set_period(uint32_t us);
+
+/**
+ * Make the next slot (the one after the running one) this much longer,
+ * shorter when negative, by half a period at most. For that slot only:
+ * frame_clock_begin() puts the period back.
+ */
+void frame_clock_adjust(int32_t us);
+
+/**
+ * Our µs run this many ppm fast against a reference (sof_lock.h): every
+ * slot is made as much longer, fractions of a µs carried over, so periods
+ * are the reference's µs. Clamped to ±FRAME_TRIM_MAX_PPM.
+ */
+void frame_clock_set_trim(int32_t ppm);
+int32_t frame_clock_trim(void);
+
+/**
+ * APB1 changed (clock_scale.h): TIM2 at 1 µs again, the running slot keeps
+ * the count it has
+ */
+void frame_clock_reclock(void);
+
+/**
+ * DWT->CYCCNT when the last tick came (taken in the ISR, no main loop delay)
+ */
+uint32_t frame_clock_tick_cyc(void);
+
+/**
+ * Called from the TIM2 ISR on every tick. Weak, override to wake a task
+ * (rtos_app.c).
+ */
+void frame_clock_tick_hook(void);
+
+/**
+ * Current statistics
+ */
+const FrameClockStats *frame_clock_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAME_CLOCK_H_ */
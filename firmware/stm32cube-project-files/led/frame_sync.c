@@ -0,0 +1,89 @@
+/* --------------------------------------------------------------------------
+ * frame_sync.c – frame clock disciplined to the host's, shared frame number
+ * -------------------------------------------------------------------------- */
+#include "frame_sync.h"
+#include "frame_clock.h"         /* frame_clock_adjust, frame_clock_tick_cyc */
+#include "stm32f4xx_hal.h"       /* DWT, SystemCoreClock */
+
+static FrameSyncStats sync;
+static uint32_t       ref_host;     /* host µs at which ref_frame ticked */
+static uint32_t       ref_frame;
+static uint32_t       period;       /* host's, µs */
+static uint32_t       rx_last;      /* our µs at the last sample */
+
+/* DWT cycles → µs since boot; cyc within 25 s of the last call, both
+ * callers are the main loop, once per frame at least */
+static uint32_t base_cyc, base_us;
+
+static uint32_t cyc_us(uint32_t cyc)
+{
+    uint32_t cpu = SystemCoreClock / 1000000u;
+    int32_t  d   = (int32_t)(cyc - base_cyc);
+    if (d < 0) return base_us - (uint32_t)(-d) / cpu;   /* stamped before the last tick */
+    uint32_t us = (uint32_t)d / cpu;
+    base_cyc += us * cpu;
+    base_us  += us;
+    return base_us;
+}
+
+void frame_sync_sample(uint32_t host_us, uint32_t frame, uint32_t phase_us,
+                       uint32_t period_us, uint32_t rx_cyc)
+{
+    if (period_us < 1000 || period_us > 1000000UL || phase_us >= period_us) return;
+
+    uint32_t rx  = cyc_us(rx_cyc);
+    int32_t  off = (int32_t)(rx - host_us);
+    if (!sync.samples || rx - rx_last > SYNC_STALE_US) {
+        sync.offset_us = off;                   /* (re)start */
+        sync.samples   = 0;
+    } else {
+        /* the fastest transit is the best estimate; creep ~250 ppm so
+         * crystal drift is followed too */
+        int32_t creep = sync.offset_us + (int32_t)((rx - rx_last) >> 12);
+        sync.offset_us = (off - creep < 0) ? off : creep;
+    }
+    if (period_us != period) frame_clock_set_period(period_us);
+
+    ref_host  = host_us - phase_us;
+    ref_frame = frame;
+    period    = period_us;
+    rx_last   = rx;
+    sync.samples++;
+}
+
+void frame_sync_tick(void)
+{
+    uint32_t t = cyc_us(frame_clock_tick_cyc());
+
+    sync.locked = sync.samples >= SYNC_LOCK_SAMPLES && t - rx_last <= SYNC_STALE_US;
+    if (!sync.locked) {
+        if (sync.samples && t - rx_last > SYNC_STALE_US) sync.samples = 0;
+        sync.frame++;
+        return;
+    }
+
+    /* this tick in host time, against the frame grid: nearest frame and how
+     * far off it we are */
+    int32_t p = (int32_t)period;
+    int32_t d = (int32_t)(t - (uint32_t)sync.offset_us - ref_host);
+    int32_t k = (d >= 0 ? d + p / 2 : d - p / 2) / p;
+    int32_t e = d - k * p;
+
+    sync.frame    = ref_frame + (uint32_t)k;
+    sync.error_us = e;
+    frame_clock_adjust(-e / 4);     /* lands one slot later: gain under 1/2 stays stable */
+}
+
+uint32_t frame_sync_frame(void)  { return sync.frame; }
+bool     frame_sync_locked(void) { return sync.locked; }
+
+bool frame_sync_due(uint32_t frame)
+{
+    int32_t ahead = (int32_t)(frame - sync.frame);
+    return !sync.locked || ahead <= 0 || ahead > SYNC_LATCH_MAX;
+}
+
+const FrameSyncStats *frame_sync_stats(void)
+{
+    return &sync;
+}
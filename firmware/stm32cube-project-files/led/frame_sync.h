@@ -0,0 +1,94 @@
+/*
+ * frame_sync.h – several sculptures on one host frame clock
+ *
+ * The host keeps a frame grid of its own (frame n ticks at epoch + n ×
+ * period, host µs) and sends every device a PKT_SYNC (usb_packet.h) a few
+ * times a second:
+ *
+ *   host_us u32 (sent) | frame u32 | phase_us u32 (since that frame ticked)
+ *   period_us u32
+ *
+ * The device takes the period for its frame clock, maps host time onto its
+ * own (the fastest transit seen, as led_view.h does; the packet is stamped
+ * in the USB ISR) and from then on measures every TIM2 tick against the
+ * host's grid: the slot after next is made shorter or longer by a quarter
+ * of the error (frame_clock_adjust), and the frame gets the host's number.
+ * Every device on the same host ticks within the USB transit jitter of the
+ * others, well under a millisecond, and the host needs to send nothing per
+ * frame.
+ *
+ * The shared number is what latches: the animation clock runs on it
+ * (anim_clock.h, frame × period), so identical scenes and seeds draw the
+ * same picture on every device, and a stream frame can carry the number it
+ * is to be shown at (led_stream.h, 'S'). Without SYNC_LOCK_SAMPLES fresh
+ * samples, or SYNC_STALE_US after the last, the clock runs free again and
+ * the number just counts on.
+ */
+
+#ifndef _FRAME_SYNC_H_
+#define _FRAME_SYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* samples before the frame clock follows the host */
+#ifndef SYNC_LOCK_SAMPLES
+  #define SYNC_LOCK_SAMPLES     4
+#endif
+
+/* no sample for this long: free running again */
+#ifndef SYNC_STALE_US
+  #define SYNC_STALE_US         2000000
+#endif
+
+/* a stream frame numbered further ahead than this is shown at once (the host
+ * numbers on another grid) */
+#ifndef SYNC_LATCH_MAX
+  #define SYNC_LATCH_MAX        120
+#endif
+
+typedef struct {
+    uint32_t samples;       /* since (re)start                               */
+    int32_t  offset_us;     /* our µs - host µs, fastest transit              */
+    int32_t  error_us;      /* last tick against the host's grid, + = late    */
+    uint32_t frame;         /* number of the running frame                    */
+    bool     locked;        /* the frame clock follows the host               */
+} FrameSyncStats;
+
+/**
+ * A PKT_SYNC came in (packet handler)
+ * @param rx_cyc  DWT->CYCCNT when it arrived (usb_packet_rx_time)
+ */
+void frame_sync_sample(uint32_t host_us, uint32_t frame, uint32_t phase_us,
+                       uint32_t period_us, uint32_t rx_cyc);
+
+/**
+ * Once per frame clock tick, before anything draws: numbers the frame and
+ * steers the clock
+ */
+void frame_sync_tick(void);
+
+/**
+ * Number of the running frame (the host's while locked)
+ */
+uint32_t frame_sync_frame(void);
+
+bool frame_sync_locked(void);
+
+/**
+ * Is a frame numbered this due? Always when not locked.
+ */
+bool frame_sync_due(uint32_t frame);
+
+const FrameSyncStats *frame_sync_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAME_SYNC_H_ */
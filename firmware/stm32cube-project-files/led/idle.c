@@ -0,0 +1,33 @@
+/* --------------------------------------------------------------------------
+ * idle.c – WFI between main loop passes
+ * -------------------------------------------------------------------------- */
+#include "idle.h"
+
+#ifdef MAIN_LOOP_WFI
+
+#include "frame_clock.h"     /* frame_clock_pending */
+#include "usb_comms.h"       /* usb_comms_rx_pending */
+#include "profiler.h"        /* PROF_BEGIN(SLEEP) */
+#include "stm32f4xx_hal.h"   /* __WFI, HAL_DBGMCU_EnableDBGSleepMode */
+
+void idle_init(void)
+{
+    /* HCLK stays on in sleep: the cycle counter runs on (boot, trace and
+     * latency stamps, the profiler), the core still stops fetching */
+    HAL_DBGMCU_EnableDBGSleepMode();
+}
+
+void idle_wait(void)
+{
+    /* with interrupts masked an IRQ that comes after the check still ends
+     * the WFI, it just runs after __enable_irq() instead of being missed */
+    __disable_irq();
+    if (!frame_clock_pending() && !usb_comms_rx_pending()) {
+        PROF_BEGIN(SLEEP);
+        __WFI();
+        PROF_END(SLEEP);
+    }
+    __enable_irq();
+}
+
+#endif /* MAIN_LOOP_WFI */
@@ -0,0 +1,50 @@
+/*
+ * idle.h – sleep the core between main loop passes (MAIN_LOOP_WFI)
+ *
+ * The main loop has nothing to do unless an interrupt brought something: the
+ * frame clock tick (TIM2), a finished strip DMA, bytes from the host (USB)
+ * or the 1 ms SysTick that the timed tasks (USB flush, telemetry, the link
+ * ring) go by. idle_wait() at the end of a pass stops the core in WFI until
+ * the next one, unless a tick or received bytes are already waiting.
+ *
+ * The time asleep is the SLEEP profiler zone, so the telemetry window has
+ * the load directly: 1 - sleep / window. DWT keeps counting in WFI
+ * (idle_init() keeps HCLK running in sleep), every cycle timestamp stays
+ * comparable across a sleep.
+ */
+
+#ifndef _IDLE_H_
+#define _IDLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MAIN_LOOP_WFI
+
+/**
+ * Let DWT run on in sleep. Once, before the main loop.
+ */
+void idle_init(void);
+
+/**
+ * Sleep until the next interrupt, back at once if there is work pending
+ */
+void idle_wait(void);
+
+#else
+
+#define idle_init()  ((void)0)
+#define idle_wait()  ((void)0)
+
+#endif /* MAIN_LOOP_WFI */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IDLE_H_ */
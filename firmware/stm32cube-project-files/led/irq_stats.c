@@ -0,0 +1,106 @@
+/* --------------------------------------------------------------------------
+ * irq_stats.c – per vector handler time, windows of IRQ_WINDOW_MS
+ * -------------------------------------------------------------------------- */
+#include "irq_stats.h"
+
+#ifdef LED_IRQ_STATS
+
+#include <string.h>
+#include "dlog.h"            /* DLOG(), USBD_UsrLog() */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick */
+
+static const char *const vector_name[IRQ_V_COUNT] = {
+#define IRQ_NAME(name) #name,
+    IRQ_VECTORS(IRQ_NAME)
+#undef IRQ_NAME
+};
+
+volatile uint32_t irq_busy_cyc;
+
+static IrqStats  cur[IRQ_V_COUNT];   /* written by the handlers */
+static IrqStats  last[IRQ_V_COUNT];
+static uint32_t  last_close, last_ms;
+static uint32_t  busy_at_close, last_busy;
+static bool      stream;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * The handler's own time is what it took minus what the handlers that
+ * preempted it took; those moved irq_busy_cyc on by their whole time, and
+ * this one sets it to where it was plus its own whole time, so a handler
+ * is only ever taken out once, by the one it preempted.
+ */
+void irq_exit(IrqVector v, IrqMark m)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t dur  = DWT->CYCCNT - m.t0;
+    uint32_t self = dur - (irq_busy_cyc - m.busy0);
+    irq_busy_cyc  = m.busy0 + dur;
+
+    IrqStats *s = &cur[v];
+    s->count++;
+    s->cycles += self;
+    if (self > s->max_cyc) s->max_cyc = self;
+    __set_PRIMASK(primask);
+}
+
+void irq_tick(void)
+{
+    uint32_t now = HAL_GetTick();
+    if (now - last_close < IRQ_WINDOW_MS) return;
+    last_ms    = now - last_close;
+    last_close = now;
+
+    __disable_irq();
+    memcpy(last, cur, sizeof last);
+    memset(cur, 0, sizeof cur);
+    uint32_t busy = irq_busy_cyc;
+    __enable_irq();
+    last_busy     = busy - busy_at_close;
+    busy_at_close = busy;
+
+    if (!stream) return;
+    uint32_t cpu    = SystemCoreClock / 1000000u;
+    uint32_t window = last_ms * (SystemCoreClock / 1000u);
+    DLOG("#irq t=%lu load=%lu#", (unsigned long)now,
+         (unsigned long)((uint64_t)last_busy * 1000u / window));
+    for (uint8_t v = 0; v < IRQ_V_COUNT; ++v) {
+        if (!last[v].count) continue;
+        DLOG("#irq %s n=%lu us=%lu max=%lu#", vector_name[v], (unsigned long)last[v].count,
+             (unsigned long)(last[v].cycles / cpu), (unsigned long)(last[v].max_cyc / cpu));
+    }
+}
+
+const IrqStats *irq_last(uint32_t *window_ms)
+{
+    if (window_ms) *window_ms = last_ms;
+    return last;
+}
+
+void irq_report(void)
+{
+    uint32_t cpu    = SystemCoreClock / 1000000u;
+    uint32_t window = last_ms * (SystemCoreClock / 1000u);
+    if (!window) {
+        USBD_UsrLog("irq: no window closed yet\n");
+        return;
+    }
+    USBD_UsrLog("irq: %lu ms, %lu.%lu %% in handlers\n", (unsigned long)last_ms,
+                (unsigned long)((uint64_t)last_busy * 100u / window),
+                (unsigned long)((uint64_t)last_busy * 1000u / window % 10u));
+    for (uint8_t v = 0; v < IRQ_V_COUNT; ++v) {
+        const IrqStats *s = &last[v];
+        if (!s->count) continue;
+        USBD_UsrLog("  %-10s %7lu calls %8lu us (%lu permille), max %lu us\n", vector_name[v],
+                    (unsigned long)s->count, (unsigned long)(s->cycles / cpu),
+                    (unsigned long)((uint64_t)s->cycles * 1000u / window),
+                    (unsigned long)(s->max_cyc / cpu));
+    }
+}
+
+void irq_set_stream(bool on)
+{
+    stream = on;
+}
+
+#endif /* LED_IRQ_STATS */
@@ -0,0 +1,117 @@
+/*
+ * irq_stats.h – CPU time of the interrupt handlers (LED_IRQ_STATS)
+ *
+ *   void OTG_FS_IRQHandler(void)
+ *   {
+ *       IRQ_ENTER(OTG_FS);
+ *       HAL_PCD_IRQHandler(&hpcd_USB_OTG_FS);
+ *       IRQ_EXIT(OTG_FS);
+ *   }
+ *
+ * Per vector: calls, cycles and the longest call, DWT timed. A handler that
+ * was preempted does not count the one that preempted it, so the vectors add
+ * up to the time spent in interrupts. irq_tick() closes a window every
+ * IRQ_WINDOW_MS; "irq" on the console prints the last one, "irq on" every
+ * one as it closes (#irq lines, uptime in ms to line them up with the frame
+ * times), "irq off" stops that. Without LED_IRQ_STATS the macros are empty.
+ *
+ * Cost: two loads on entry, ~30 cycles on exit (interrupts masked for it).
+ */
+
+#ifndef _IRQ_STATS_H_
+#define _IRQ_STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the accounted handlers, in the order they are reported */
+#define IRQ_VECTORS(X)  \
+    X(SYSTICK)          \
+    X(OTG_FS)           \
+    X(SPI1_DMA)         \
+    X(SPI2_DMA)         \
+    X(SPI3_DMA)         \
+    X(FRAME_TIM)        \
+    X(LATCH_TIM)        \
+    X(MEM_DMA)          \
+    X(GPIO_DMA)         \
+    X(GPIO_TIM)         \
+    X(AUDIO_DMA)
+
+typedef enum {
+#define IRQ_ENUM(name) IRQ_V_##name,
+    IRQ_VECTORS(IRQ_ENUM)
+#undef IRQ_ENUM
+    IRQ_V_COUNT
+} IrqVector;
+
+#ifndef IRQ_WINDOW_MS
+  #define IRQ_WINDOW_MS     1000
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t cycles;        /* preempting handlers taken out */
+    uint32_t max_cyc;
+} IrqStats;
+
+#ifdef LED_IRQ_STATS
+
+#include "stm32f4xx.h"      /* DWT */
+
+typedef struct {
+    uint32_t t0;            /* DWT at entry */
+    uint32_t busy0;         /* irq_busy_cyc at entry */
+} IrqMark;
+
+/* cycles in accounted handlers since boot, nested ones counted once */
+extern volatile uint32_t irq_busy_cyc;
+
+static inline IrqMark irq_enter(void)
+{
+    return (IrqMark){ DWT->CYCCNT, irq_busy_cyc };
+}
+
+void irq_exit(IrqVector v, IrqMark m);
+
+#define IRQ_ENTER(v)    IrqMark irq_mark_ = irq_enter()
+#define IRQ_EXIT(v)     irq_exit(IRQ_V_##v, irq_mark_)
+
+/**
+ * Main loop: closes the window when due (and prints it with "irq on")
+ */
+void irq_tick(void);
+
+/**
+ * The last closed window, IRQ_V_COUNT entries; its length in ms
+ */
+const IrqStats *irq_last(uint32_t *window_ms);
+
+/**
+ * Print the last window (USBD_UsrLog)
+ */
+void irq_report(void);
+
+/**
+ * #irq lines every window on / off
+ */
+void irq_set_stream(bool on);
+
+#else
+
+#define IRQ_ENTER(v)    ((void)0)
+#define IRQ_EXIT(v)     ((void)0)
+#define irq_tick()      ((void)0)
+
+#endif /* LED_IRQ_STATS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IRQ_STATS_H_ */
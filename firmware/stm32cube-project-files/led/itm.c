@@ -0,0 +1,70 @@
+/* --------------------------------------------------------------------------
+ * itm.c – stimulus ports out on SWO
+ * -------------------------------------------------------------------------- */
+#include "itm.h"
+
+#ifdef LED_ITM
+
+#include <string.h>
+#include "stm32f4xx_hal.h"
+
+#ifdef LED_OUTPUT_APA102
+#error "LED_ITM takes PB3 for SWO, that is SPI3's SCK, the clock of an APA102 strip"
+#endif
+
+#define ITM_UNLOCK      0xC5ACCE55u
+#define TPI_SPPR_NRZ    2u             /* asynchronous, UART framing */
+#define TPI_FFCR_TRIGIN (1u << 8)      /* formatter off: ITM packets as they are */
+
+void itm_init(void)
+{
+    if (!(CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)) return;   /* no probe */
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DBGMCU->CR       |= DBGMCU_CR_TRACE_IOEN;           /* TRACE_MODE 00: async SWO */
+
+    /* PB3 back to AF0 (TRACESWO): MX_SPI3_Init() took it for SCK, which a
+     * WS2812 strip never needs */
+    GPIOB->AFR[0] &= ~GPIO_AFRL_AFSEL3;
+    GPIOB->MODER   = (GPIOB->MODER & ~GPIO_MODER_MODER3) | GPIO_MODER_MODER3_1;
+    GPIOB->OSPEEDR |= GPIO_OSPEEDER_OSPEEDR3;
+
+    TPI->SPPR = TPI_SPPR_NRZ;
+    TPI->ACPR = SystemCoreClock / ITM_SWO_HZ - 1u;
+    TPI->FFCR = TPI_FFCR_TRIGIN;
+
+    ITM->LAR = ITM_UNLOCK;
+    ITM->TCR = (1u << ITM_TCR_TraceBusID_Pos) | ITM_TCR_SYNCENA_Msk | ITM_TCR_ITMENA_Msk;
+    ITM->TPR = 0;                                       /* all ports unprivileged */
+    ITM->TER = (1u << ITM_PORTS) - 1u;
+}
+
+bool itm_port_on(uint8_t port)
+{
+    return (ITM->TCR & ITM_TCR_ITMENA_Msk) && (ITM->TER & (1u << port));
+}
+
+void itm_put32(uint8_t port, uint32_t v)
+{
+    if (!itm_port_on(port)) return;
+    while (ITM->PORT[port].u32 == 0) { }                /* FIFO full */
+    ITM->PORT[port].u32 = v;
+}
+
+void itm_write(uint8_t port, const void *buf, uint32_t len)
+{
+    if (!itm_port_on(port)) return;
+    const uint8_t *p = buf;
+    for (; len >= 4; len -= 4, p += 4) {                /* little endian: bytes in order */
+        uint32_t w;
+        memcpy(&w, p, 4);
+        while (ITM->PORT[port].u32 == 0) { }
+        ITM->PORT[port].u32 = w;
+    }
+    for (; len; --len, ++p) {
+        while (ITM->PORT[port].u32 == 0) { }
+        ITM->PORT[port].u8 = *p;
+    }
+}
+
+#endif /* LED_ITM */
@@ -0,0 +1,86 @@
+/*
+ * itm.h – SWO / ITM output through the debug probe (LED_ITM)
+ *
+ * The Cortex-M4's instrumentation trace: a write to a stimulus port is a few
+ * cycles, the ITM packs it and the TPIU clocks it out on the SWO pin (PB3)
+ * at ITM_SWO_HZ, no USB, no ring, no interrupt. One port per channel:
+ *
+ *   ITM_PORT_LOG    printf text (ITM_LOG: instead of the CDC text channel)
+ *   ITM_PORT_PROF   profiler zones, one word per PROF_END:
+ *                   zone << 24 | cycles (saturated at 2^24 - 1, ~200 ms)
+ *   ITM_PORT_TRACE  trace events (LED_TRACE), live besides the ring: two
+ *                   words per event, DWT cycles, then event | flags << 8 |
+ *                   arg << 16 (trace.h's TraceRecord)
+ *
+ * itm_init() only switches the ports on with a debugger attached
+ * (DHCSR.C_DEBUGEN); without one, or with a port the probe switched off,
+ * every write is one register test. The probe has to listen at the same
+ * rate, NRZ, e.g. OpenOCD (target/stm32f4x.cfg):
+ *
+ *   stm32f4x.tpiu configure -protocol uart -output swo.bin \
+ *                           -traceclk 84000000 -pin-freq 2000000
+ *   stm32f4x.tpiu enable
+ *   itm ports on
+ *
+ * app/itm_decode.py splits the capture into the log, zone statistics and a
+ * Chrome trace. A port whose FIFO is full waits for it: the SWO rate is the
+ * budget, ITM_SWO_HZ / 10 bytes per second.
+ */
+
+#ifndef _ITM_H_
+#define _ITM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ITM_PORT_LOG    0u
+#define ITM_PORT_PROF   1u
+#define ITM_PORT_TRACE  2u
+#define ITM_PORTS       3u
+
+#ifndef ITM_SWO_HZ
+  #define ITM_SWO_HZ    2000000u
+#endif
+
+#ifdef LED_ITM
+
+/**
+ * SWO pin, TPIU and ITM set up, the ports on with a debugger attached.
+ * From main() once the clock runs (the SWO prescaler is taken from it).
+ */
+void itm_init(void);
+
+/**
+ * Port switched on (by itm_init() or the probe)
+ */
+bool itm_port_on(uint8_t port);
+
+/**
+ * One word to a port, any context. Nothing with the port off.
+ */
+void itm_put32(uint8_t port, uint32_t v);
+
+/**
+ * Bytes to a port, as words while there are four left
+ */
+void itm_write(uint8_t port, const void *buf, uint32_t len);
+
+#else
+
+#define itm_init()               ((void)0)
+#define itm_port_on(port)        false
+#define itm_put32(port, v)       ((void)0)
+#define itm_write(port, b, n)    ((void)0)
+
+#endif /* LED_ITM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ITM_H_ */
@@ -0,0 +1,60 @@
+/* --------------------------------------------------------------------------
+ * latency.c – PKT_PROBE: arrival, handler, draw and DMA-done times
+ * -------------------------------------------------------------------------- */
+#include "latency.h"
+#include "usb_packet.h"      /* usb_packet_send */
+#include "led_render.h"      /* render_frame_seq, render_frame_shown */
+#include "stm32f4xx_hal.h"   /* DWT, SystemCoreClock, HAL_GetTick */
+
+typedef enum {
+    PROBE_IDLE,
+    PROBE_ARMED,            /* handled, waiting for the next tick */
+    PROBE_DRAWING,          /* waiting for a frame submitted after seq */
+} ProbeState;
+
+static ProbeState state;
+static uint32_t   id, host_us, since_ms;
+static uint32_t   rx_cyc, handled_cyc, render_cyc;
+static uint32_t   seq;
+
+static uint32_t us_after_rx(uint32_t cyc)
+{
+    return (cyc - rx_cyc) / (SystemCoreClock / 1000000u);
+}
+
+void latency_probe(uint32_t probe_id, uint32_t host, uint32_t rx)
+{
+    id          = probe_id;
+    host_us     = host;
+    rx_cyc      = rx;
+    handled_cyc = DWT->CYCCNT;
+    since_ms    = HAL_GetTick();
+    state       = PROBE_ARMED;
+}
+
+void latency_frame(void)
+{
+    if (state != PROBE_ARMED) return;
+    render_cyc = DWT->CYCCNT;
+    seq        = render_frame_seq();
+    state      = PROBE_DRAWING;
+}
+
+void latency_tick(void)
+{
+    if (state != PROBE_DRAWING) return;
+
+    uint32_t end;
+    uint32_t shown = LATENCY_NONE;
+    if ((int32_t)(render_frame_shown(&end) - seq) > 0) {
+        shown = us_after_rx(end);
+    } else if (HAL_GetTick() - since_ms < LATENCY_TIMEOUT_MS) {
+        return;
+    }
+
+    uint32_t v[6] = { id, host_us, us_after_rx(handled_cyc), us_after_rx(render_cyc),
+                      shown, 0 };
+    v[5] = us_after_rx(DWT->CYCCNT);
+    usb_packet_send(PKT_PROBE | PKT_REPLY, (const uint8_t *)v, sizeof v);
+    state = PROBE_IDLE;
+}
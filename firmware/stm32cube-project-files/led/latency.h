@@ -0,0 +1,59 @@
+/*
+ * latency.h – input-to-light probe
+ *
+ * A PKT_PROBE (usb_packet.h) rides along with a command, id u32 | host_us
+ * u32. The device notes when the packet arrived (USB ISR), when its handler
+ * ran, when the next frame clock tick started drawing and when the DMA of
+ * the first frame submitted from then on finished – the first frame that
+ * can show what came in with the probe – and answers with PKT_PROBE |
+ * PKT_REPLY:
+ *
+ *   id u32 | host_us u32 | handled_us u32 | render_us u32 | shown_us u32
+ *   reply_us u32
+ *
+ * all but the echoed two in µs after the arrival. shown_us is
+ * LATENCY_NONE when no frame went out within LATENCY_TIMEOUT_MS (render
+ * not running, LED_LINK_MASTER). With the host's send and receive times
+ * and reply_us the app takes out the USB transit both ways and gets input
+ * to light (app/latency.py). One probe at a time: a new one replaces one
+ * still waiting.
+ */
+
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef LATENCY_TIMEOUT_MS
+  #define LATENCY_TIMEOUT_MS    1000
+#endif
+
+#define LATENCY_NONE            0xFFFFFFFFu
+
+/**
+ * A PKT_PROBE came in (packet handler)
+ * @param rx_cyc  DWT->CYCCNT when it arrived (usb_packet_rx_time)
+ */
+void latency_probe(uint32_t id, uint32_t host_us, uint32_t rx_cyc);
+
+/**
+ * Frame clock tick, before anything draws
+ */
+void latency_frame(void);
+
+/**
+ * Every main loop pass: answers once the frame is out
+ */
+void latency_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LATENCY_H_ */
@@ -6,7 +6,29 @@
 #include <stdlib.h>
 #include "polyhedron.h"
 #include "led_mapping.h"         /* mapping_* getters */
+#include "led_spatial.h"         /* spatial_shell_* radius queries */
+#include "led_paths.h"           /* path_get, path_span */
+#include "led_wave.h"            /* wave_* edge graph simulation */
 #include "led_render.h"          /* set_all_pixels_color, add_pixel_color, update_leds */
+#include "profiler.h"            /* PROF_BEGIN / PROF_END */
+#include "lut.h"                 /* lut_sinf */
+#include "fast_math.h"           /* fm_atan2f, fm_sqrtf, ... */
+#include "led_view.h"            /* view_matrix, live tilt */
+#include "led_shader.h"          /* shader_run, per-LED kernels */
+#include "led_palette.h"         /* palette_shade, palette_tick */
+#include "led_layers.h"          /* layers_frame */
+#include "led_transition.h"      /* cross-fade on mode changes */
+#include "led_particles.h"       /* star pool */
+#include "led_raster.h"          /* raster_warm: the stars' point kernel */
+#include "led_rng.h"             /* per-animation random streams */
+#include "led_symmetry.h"        /* sym_run: symmetric kernels on the fundamental domain */
+#include "led_texture.h"         /* tex_run_*: per-edge control points, DDA fill */
+#include "led_governor.h"        /* gov_level: cheaper minefield / plasma under load */
+#include "led_noise.h"           /* simplex noise: lava, aurora */
+#include "anim_clock.h"          /* frame step: speeds per second, not per tick */
+#include "led_vm.h"              /* uploaded per-LED programs: script */
+#include "audio.h"               /* band levels and beats: audio */
+#include "led_hud.h"             /* performance gauges: hud */
 #include "led_anim.h"
 #include <time.h>
 
@@ -21,81 +43,25 @@ extern Polyhedron poly;
 
 
 typedef struct { float x,y,z; } Vec3;
-static Vec3 *led_pos = NULL;        /* len = mapping_get_total_pixels() */
 
-static bool build_led_pos_cache()
+/* scratch sizes for the animation arena, poly_arena_alloc() aligns every block to 4 */
+#define ANIM_ALIGN4(n) POLY_ARENA_ALIGN(n)
+
+/* LED position from the mapping's cache (float, or Q1.14 with LED_POS_Q14) */
+static inline Vec3 led_xyz(const LedPos *pos, uint16_t i)
 {
-    if (led_pos) return true;                                        /* already done */
-    uint16_t tot = mapping_get_total_pixels();
-    led_pos = malloc(sizeof(Vec3) * tot);
-    if (!led_pos) return false;                                       /* OOM – bail */
-
-    const EdgeLedInfo *ei = mapping_get_edge_info();
-    for (uint8_t e = 0; e < poly.E; ++e) {
-        const float *A = poly.v[ poly.e[e].a ];
-        const float *B = poly.v[ poly.e[e].b ];
-        for (uint16_t i = 0; i < ei[e].count; ++i) {
-            float t  = (ei[e].count>1) ? (float)i/(ei[e].count-1) : 0.f;
-            float x  = A[0] + (B[0]-A[0])*t;
-            float y  = A[1] + (B[1]-A[1])*t;
-            float z  = A[2] + (B[2]-A[2])*t;
-            uint16_t phys = ei[e].start + i*ei[e].step;
-            led_pos[phys] = (Vec3){x,y,z};
-        }
-    }
-    return true;
+    return (Vec3){ LED_POS_F(pos[i].x), LED_POS_F(pos[i].y), LED_POS_F(pos[i].z) };
 }
 
 
 /* ##################################################################################################### */
-#ifdef LED_DEBUG_ANIM // ───────────────────────────────────────────────────────────────
-#include "usb_comms.h"    // for USBD_UsrLog()
-#include "stm32f4xx.h"    // for DWT->CYCCNT & HAL_RCC_GetHCLKFreq()
-#include <stdint.h>
-
-// MCU‐side rolling‐average state for animation prep times
-static uint32_t anim_hist[ANIMTIME_HISTORY];
-static uint8_t  anim_idx        = 0;
-static uint8_t  anim_count      = 0;
-static uint32_t last_anim_print = 0;
-static uint32_t start = 0;
-#endif // ─────────────────────────────────────────────────────────────────────────────
-
+// animation prep time, reported by the profiler (ANIM zone, #animtime)
 void anim_time_start(void){
-#ifdef LED_DEBUG_ANIM // ───────────────────────────────────────────────────────────
-    // ===| Start DWT timing for animation prep
-    start = DWT->CYCCNT;
-#endif // ─────────────────────────────────────────────────────────────────────────
+    PROF_BEGIN(ANIM);
 }
 
 void anim_time_end(void){
-#ifdef LED_DEBUG_ANIM // ───────────────────────────────────────────────────────────
-    // ===| Stop timing & convert to µs
-    uint32_t end    = DWT->CYCCNT;
-    uint32_t cycles = end - start;
-    uint64_t tmp    = (uint64_t)cycles * 1000000U;
-    uint32_t cpu_hz = HAL_RCC_GetHCLKFreq();
-    uint32_t us     = (uint32_t)(tmp / cpu_hz);
-
-    // ===| Push into circ‐buffer & compute average
-    anim_hist[anim_idx] = us;
-    anim_idx = (anim_idx + 1) % ANIMTIME_HISTORY;
-    if (anim_count < ANIMTIME_HISTORY) {
-        anim_count++;
-    }
-    uint64_t sum = 0;
-    for (uint8_t j = 0; j < anim_count; j++) {
-        sum += anim_hist[j];
-    }
-    uint32_t avg_us = (uint32_t)(sum / anim_count);
-
-    // ===| Print the averaged µs at up to 5 Hz
-    uint32_t now = HAL_GetTick();
-    if ((now - last_anim_print) >= ANIMTIME_PRINT_INTERVAL_MS) {
-        USBD_UsrLog("#animtime %lu#", (unsigned long)avg_us);
-        last_anim_print = now;
-    }
-#endif // ─────────────────────────────────────────────────────────────────────────
+    PROF_END(ANIM);
 }
 /* ##################################################################################################### */
 
@@ -108,48 +74,6 @@ void anim_time_end(void){
 /* #################################################################################################### */
 
 
-static inline float time_delta(uint32_t *last_ms) {
-    uint32_t now = ms();
-    float    dt  = *last_ms ? (now - *last_ms) * 0.001f : 0.0f;
-    *last_ms      = now;
-    return dt;
-}
-
-
-// fast approximation of x^y
-static inline float fast_powf(float x, float y) {
-    // --- 1) extract exponent and mantissa of x
-    union { float f; uint32_t i; } ux = { x };
-    int    ex = (int)((ux.i >> 23) & 0xFF) - 127;
-    float  mant = (ux.i & 0x7FFFFF) / 8388608.0f + 1.0f;
-
-    // --- 2) approximate log2(x) = ex + log2(mant)
-    //    use a 3rd-order Taylor around mant ≈ 1:
-    float   f1 = mant - 1.0f;
-    float   log2_m = f1
-                    - 0.5f * f1*f1
-                    + (1.0f/3.0f) * f1*f1*f1;
-    float   log2x = ex + log2_m;
-
-    // --- 3) scale by y to get z = y * log2(x)
-    float z = y * log2x;
-    int   iz = (int)floorf(z);
-    float frac = z - (float)iz;      // fractional part
-
-    // --- 4) approximate 2^frac on [0,1) with a quadratic
-    //     2^f ≈ 1 + f·ln2 + f²·(ln2)²/2
-    const float LN2 = 0.69314718f;
-    float exp2_frac = 1.0f
-                    + frac * LN2
-                    + frac*frac * (LN2*LN2 * 0.5f);
-
-    // --- 5) rebuild result = 2^iz * exp2_frac
-    int  ez = iz + 127;
-    if (ez <= 0) return 0.0f;        // underflow
-    if (ez >= 255) return INFINITY;  // overflow
-    union { uint32_t i; float f; } uz = { (uint32_t)ez << 23 };
-    return uz.f * exp2_frac;
-}
 
 
 
@@ -169,48 +93,26 @@ static inline float fast_powf(float x, float y) {
 /* ========================================================================================== */
 
 static void fade_frame(uint8_t fade_amt, uint8_t power /* 1…8 ≈ power */) {
-    // invert so 0 = no fade, 255 = full fade
-    uint8_t factor_q8 = 255 - fade_amt;
-    uint16_t tot = mapping_get_total_pixels();
-    for (uint16_t i = 0; i < tot; ++i) {
-        rgb_8b c = framebuffer[i];
-        /* scale each channel with (v * f)^γ  in 8-bit integer space          */
-        uint16_t r = (c.r * factor_q8) >> 8;
-        uint16_t g = (c.g * factor_q8) >> 8;
-        uint16_t b = (c.b * factor_q8) >> 8;
-        for (uint8_t k = 1; k < power; ++k) { r = (r * factor_q8) >> 8;
-                                              g = (g * factor_q8) >> 8;
-                                              b = (b * factor_q8) >> 8; }
-        framebuffer[i].r = (uint8_t)r;
-        framebuffer[i].g = (uint8_t)g;
-        framebuffer[i].b = (uint8_t)b;
-    }
+    // packed 4-bytes-at-a-time kernel in the renderer, marks what it changed
+    fade_pixels(fade_amt, power);
 }
 
 /* ========================================================================================== */
 
-// Returns a random LED index in [0..pixels_total-1]
-uint16_t random_pixel_index(void) {
-    // 1) PRNG state lives here, initialized non-zero on first call
-    static uint32_t state = 0xA5A5A5A5;
-
-    // 2) xorshift32 step
-    uint32_t x = state;
-    x ^= x << 13;
-    x ^= x >> 17;
-    x ^= x << 5;
-    state = x;
+// Returns a random LED index in [0..pixels_total-1] from stream r
+static inline uint16_t rng_pixel(Rng *r) {
+    return (uint16_t)rng_below(r, mapping_get_total_pixels());   // 0 LEDs: 0
+}
 
-    // 3) map into your LED count
-    uint16_t total = mapping_get_total_pixels();
-    if (total == 0) return 0;
-    return (uint16_t)(x % total);
+// same on the shared stream
+uint16_t random_pixel_index(void) {
+    return rng_pixel(&rng_global);
 }
 
 /* ========================================================================================== */
 
 
-static inline void face_index_to_rgb(uint8_t face,
+static inline void face_index_to_rgb(poly_idx_t face,
                                      uint8_t *r, uint8_t *g, uint8_t *b)
 {
     /* evenly spaced around the colour-wheel */
@@ -235,8 +137,8 @@ void vertex_hsv_from_xyz(const float v[3],
                                 uint8_t *out_val)
 {
     // 1) Azimut (XY-Ebene) → Hue 0…1
-    float az   = atan2f(v[1], v[0]);
-    float huef = (az + M_PI) / (2.0f * M_PI);
+    float az   = fm_atan2f(v[1], v[0]);
+    float huef = (az + FM_PI) / FM_2PI;
     // 2) Z-Höhe (–1…1) → Saturation 0…1
     float satf = (v[2] + 1.0f) * 0.5f;
     // 3) Value fest auf voll
@@ -252,17 +154,17 @@ void vertex_hv_from_xyz(const float v[3],
                                 uint8_t *out_val)
 {
     // 1) XY-Azimuth → 0…1
-    float az   = atan2f(v[1], v[0]);
-    float hueXY = (az + (float)M_PI) / (2.0f * (float)M_PI);
+    float az   = fm_atan2f(v[1], v[0]);
+    float hueXY = (az + FM_PI) / FM_2PI;
 
     // 2) Pitch (Z-Differenz) → 0…1
-    float r_xy  = sqrtf(v[0]*v[0] + v[1]*v[1]);
-    float pitch = atan2f(v[2], r_xy);
-    float hueZ  = (pitch + (float)M_PI/2.0f) / (float)M_PI;
+    float r_xy  = fm_sqrtf(v[0]*v[0] + v[1]*v[1]);
+    float pitch = fm_atan2f(v[2], r_xy);
+    float hueZ  = (pitch + FM_PI_2) / FM_PI;
 
     // 3) Kombiniertes Hue und Helligkeit
     float combined_hue = hueXY * 0.7f + hueZ * 0.3f;
-    float brightness   = 0.5f + 0.5f * sinf(v[2] * ((float)M_PI/2.0f));
+    float brightness   = 0.5f + 0.5f * fm_sinf(v[2] * FM_PI_2);
 
     *out_hue = (uint8_t)(combined_hue * 255.0f + 0.5f);
     *out_val = (uint8_t)(brightness   * 255.0f + 0.5f);
@@ -279,8 +181,8 @@ void vertex_hue_from_z(const float v[3],
     uint8_t hue = (uint8_t)(nz * 255.0f + 0.5f);
 
     // map angle ∈ [0…1] → saturation
-    float angle = atan2f(v[1], v[0]);
-    float norm = (angle + M_PI) / (2.0f * M_PI);
+    float angle = fm_atan2f(v[1], v[0]);
+    float norm = (angle + FM_PI) / FM_2PI;
     uint8_t sat = (uint8_t)(norm * 255.0f + 0.5f);
 
     *out_hue = hue + hue_offset;
@@ -294,7 +196,7 @@ void vertex_hue_from_spherical(const float v[3],
                                uint8_t hue_offset)
 {
     // radial distance
-    float r = sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    float r = fm_sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
     if (r == 0.0f) {
         *out_hue = hue_offset;
         *out_sat = 0;
@@ -302,13 +204,13 @@ void vertex_hue_from_spherical(const float v[3],
     }
 
     // longitude → hue
-    float theta = atan2f(v[1], v[0]);            // –π…+π
-    float norm_h = (theta + M_PI) / (2.0f*M_PI); // 0…1
+    float theta = fm_atan2f(v[1], v[0]);            // –π…+π
+    float norm_h = (theta + FM_PI) / FM_2PI; // 0…1
     uint8_t hue = (uint8_t)(norm_h * 255.0f + 0.5f);
 
     // latitude → saturation
-    float phi = acosf(v[2] / r);    // 0…π
-    float norm_s = phi / M_PI;      // 0…1
+    float phi = fm_acosf(v[2] / r);    // 0…π
+    float norm_s = phi / FM_PI;      // 0…1
     uint8_t sat = (uint8_t)(norm_s * 255.0f + 0.5f);
 
     *out_hue = hue + hue_offset;    // wraps modulo 256
@@ -319,8 +221,8 @@ void vertex_hue_from_spherical(const float v[3],
 void vertex_hue_from_xyz(const float v[3], uint8_t *out_hue, uint8_t hue_offset)
 {
     // 1) compute base hue from XY-angle
-    float angle = atan2f(v[1], v[0]);                 // –π … +π
-    float norm  = (angle + (float)M_PI) / (2.0f * (float)M_PI);
+    float angle = fm_atan2f(v[1], v[0]);                 // –π … +π
+    float norm  = (angle + FM_PI) / FM_2PI;
     uint8_t base = (uint8_t)(norm * 255.0f + 0.5f);
 
     // 2) add offset (wraps modulo 256 via uint8_t)
@@ -383,50 +285,57 @@ void blackout_all_pixels(void)
  * - Der Start-Hue wird getauscht, wenn rev==true, damit auch verdrehte
  *   Verkabelung immer logisch A→B wiedergibt.
  */
+typedef struct {
+    const float (*R)[3];               // view rotation
+    uint8_t       hue_offset;
+} PaletteUniforms;
+
+// hue_offset + endpoint hues as control points, the shorter way round
+static uint8_t palette_xyz_stops(poly_idx_t e, const void *uniforms, TexIndexStop *st)
+{
+    const PaletteUniforms *u = uniforms;
+    Edge edge = poly_get_edge(&poly, e);
+
+    // 1) Raw hues at the endpoints
+    //    (in the view's frame, so the palette follows the tilt)
+    uint8_t raw_hA, raw_hB;
+    float   wA[3], wB[3];
+    view_apply(u->R, poly.v[edge.a], wA);
+    view_apply(u->R, poly.v[edge.b], wB);
+    vertex_hue_from_xyz(wA, &raw_hA, u->hue_offset);
+    vertex_hue_from_xyz(wB, &raw_hB, u->hue_offset);
+
+    // 2) signed delta, handling wrap; the fill walks A→B in fixed point
+    int16_t dh = (int16_t)raw_hB - raw_hA;
+    if (dh > 128)       dh -= 256;
+    else if (dh < -128) dh += 256;
+    st[0] = (TexIndexStop){   0, (int32_t)raw_hA << 8 };
+    st[1] = (TexIndexStop){ 255, ((int32_t)raw_hA + dh) << 8 };
+    return 2;
+}
+
+// hsv_to_rgb_rainbow(i, sat, val) for every hue, rebuilt when sat / val change
+static const rgb_8b *rainbow_table(uint8_t sat, uint8_t val)
+{
+    static rgb_8b   lut[256];
+    static uint16_t built = 0xFFFF;                 // sat << 8 | val, none yet
+    uint16_t key = (uint16_t)(sat << 8 | val);
+    if (built != key) {
+        hsv_rainbow_span(NULL, lut, 256, sat, val);
+        built = key;
+    }
+    return lut;
+}
+
 void show_vertex_palette_xyz(uint8_t sat,
                              uint8_t val,
                              uint8_t hue_offset)
 {
 	g_global_brightness = 200;
-    set_all_pixels_color(0, 0, 0);
     anim_time_start();
-    const EdgeLedInfo *info = mapping_get_edge_info();
-    uint8_t            E    = poly_edge_count(&poly);
-
-    for (uint8_t e = 0; e < E; ++e) {
-        EdgeLedInfo inf = info[e];
-        Edge        edge = poly_get_edge(&poly, e);
-
-        // 1) Raw hues at the endpoints
-        uint8_t raw_hA, raw_hB;
-        vertex_hue_from_xyz(poly.v[edge.a], &raw_hA, hue_offset);
-        vertex_hue_from_xyz(poly.v[edge.b], &raw_hB, hue_offset);
-
-        // 2) Compute signed float delta, handling wrap
-        float hA = raw_hA;
-        float hB = raw_hB;
-        float dh = hB - hA;
-        if (dh > 128.0f)  dh -= 256.0f;
-        else if (dh < -128.0f) dh += 256.0f;
-
-        // 3) Walk the LEDs with float interpolation
-        for (uint16_t i = 0; i < inf.count; ++i) {
-            uint16_t phys = inf.start + i * inf.step;
-            // t ∈ [0..1]
-            float t = (inf.count > 1)
-                    ? (float)i / (float)(inf.count - 1)
-                    : 0.0f;
-            // hue_f ∈ [hA..hA+dh]
-            float hue_f = hA + dh * t;
-            // wrap back into [0..256)
-            uint8_t h = (uint8_t)fmodf(hue_f + 256.0f, 256.0f);
-
-            uint8_t R, G, B;
-            hsv_to_rgb_rainbow(h, sat, val, &R, &G, &B);
-            add_pixel_color(phys, R, G, B);
-        }
-
-    }
+    // every LED gets written, no clear needed
+    const PaletteUniforms u = { view_matrix(), hue_offset };
+    tex_run_index(palette_xyz_stops, &u, rainbow_table(sat, val));
     anim_time_end();
 
     update_leds();
@@ -436,72 +345,56 @@ void show_vertex_palette_xyz(uint8_t sat,
 
 
 
-void show_vertex_gradient(uint8_t vertex,
+typedef struct {
+    const float *dir;
+    float        mag;
+    uint8_t      hue_offset;
+} GradientUniforms;
+
+// hue of a point: projection onto dir, dp∈[–1…+1] → [0…255] (stretched by hue_offset)
+static int32_t gradient_hue_q8(const GradientUniforms *u, const float *p)
+{
+    float dp = (p[0]*u->dir[0] + p[1]*u->dir[1] + p[2]*u->dir[2]) / u->mag;
+    if      (dp < -1.0f) dp = -1.0f;
+    else if (dp > +1.0f) dp = +1.0f;
+    float scaled = (dp + 1.0f) * 0.5f * (1+(float)u->hue_offset/40) * 255.0f;
+    return (int32_t)((scaled + 0.5f) * 256.0f);       // rounding folded in
+}
+
+static uint8_t gradient_stops(poly_idx_t e, const void *uniforms, TexIndexStop *st)
+{
+    const GradientUniforms *u    = uniforms;
+    Edge                    edge = poly_get_edge(&poly, e);
+    st[0] = (TexIndexStop){   0, gradient_hue_q8(u, poly.v[edge.a]) };
+    st[1] = (TexIndexStop){ 255, gradient_hue_q8(u, poly.v[edge.b]) };
+    return 2;
+}
+
+void show_vertex_gradient(poly_idx_t vertex,
                           uint8_t sat,
                           uint8_t val,
                           uint8_t hue_offset)
 {
-    // 1) clear all
-    set_all_pixels_color(0, 0, 0);
+    // 1) every LED sits on an edge and gets written below, no clear needed
+    //    (unchanged LEDs then stay clean for the renderer)
     g_global_brightness = 200;
 
     anim_time_start();
 
-    // 2) grab edge‐LED layout
-    const EdgeLedInfo *info = mapping_get_edge_info();
-    uint8_t            E    = poly_edge_count(&poly);
-
-    // 3) unit direction from origin → chosen vertex
+    // 2) unit direction from origin → chosen vertex
     const float *dir_v = poly.v[vertex];
-    float mag = sqrtf(dir_v[0]*dir_v[0]
+    float mag = fm_sqrtf(dir_v[0]*dir_v[0]
                     + dir_v[1]*dir_v[1]
                     + dir_v[2]*dir_v[2]);
     if (mag == 0.0f) return;  // avoid div0
 
-    // 4) for each edge…
-    for (uint8_t e = 0; e < E; ++e) {
-        EdgeLedInfo inf = info[e];
-        Edge        edge = poly_get_edge(&poly, e);
-        const float *A   = poly.v[edge.a];
-        const float *B   = poly.v[edge.b];
-
-        // 5) for each LED on this edge…
-        for (uint16_t i = 0; i < inf.count; ++i) {
-            // 5a) lerp world‐space position
-            float t = (inf.count > 1)
-                    ? ((float)i / (float)(inf.count - 1))
-                    : 0.0f;
-            float px = A[0] + (B[0] - A[0]) * t;
-            float py = A[1] + (B[1] - A[1]) * t;
-            float pz = A[2] + (B[2] - A[2]) * t;
-
-            // 5b) project onto dir_v, normalize → dp∈[–1…+1]
-            float dp = (px*dir_v[0] + py*dir_v[1] + pz*dir_v[2]) / mag;
-            if      (dp < -1.0f) dp = -1.0f;
-            else if (dp > +1.0f) dp = +1.0f;
-
-            // 5c) map dp→ hue in [0…255] with integer‐style rounding
-            //     raw_h = round( (dp + 1)/2 * 255 )
-            float  scaled = (dp + 1.0f) * 0.5f * (1+(float)hue_offset/40) * 255.0f;
-            uint8_t raw_h = (uint8_t)(scaled + 0.5f);
-
-
-            // apply hue offset (wraps mod 256)
-            //uint8_t h     = raw_h + hue_offset;
-            uint8_t h     = raw_h;
-            // 5d) physical index via step (precomputed +1 or -1)
-            uint16_t phys = inf.start + i * inf.step;
-
-            // 5e) HSV→RGB & set  (val handled in expand_led())
-            uint8_t R, G, B;
-            hsv_to_rgb_rainbow(h, sat, val, &R, &G, &B);
-            add_pixel_color(phys, R, G, B);
-        }
-    }
+    // 3) the projection is linear along an edge: its ends are all it takes
+    const GradientUniforms u = { dir_v, mag, hue_offset };
+    tex_run_index(gradient_stops, &u, rainbow_table(sat, val));
 
     anim_time_end();
 
-    // 6) push to strips
+    // 4) push to strips
     update_leds();
 }
 
@@ -516,10 +409,10 @@ void show_vertex_palette_index(uint8_t sat, uint8_t val, uint8_t hue_offset) {
 	set_all_pixels_color(0, 0, 0);
 	anim_time_start();
     const EdgeLedInfo *info = mapping_get_edge_info();
-    uint8_t            E    = poly_edge_count(&poly);
-    uint8_t            V    = poly.V;  // total vertices
+    poly_idx_t         E    = poly_edge_count(&poly);
+    poly_idx_t         V    = poly.V;  // total vertices
 
-    for (uint8_t e = 0; e < E; ++e) {
+    for (poly_idx_t e = 0; e < E; ++e) {
         EdgeLedInfo inf = info[e];
         Edge        edge = poly_get_edge(&poly, e);
 
@@ -538,23 +431,16 @@ void show_vertex_palette_index(uint8_t sat, uint8_t val, uint8_t hue_offset) {
         }
         int16_t dh = hue_diff(hStart, hEnd);
 
-        // step along the LEDs
+        // interpolated hues along the LEDs, converted as one span
+        uint8_t hues[256];                  // an edge has at most 255 LEDs (u8 per block)
         for (uint16_t i = 0; i < inf.count; ++i) {
             // linear parameter 0..1
             float t = (inf.count > 1)
                     ? ((float)i / (float)(inf.count - 1))
                     : 0.0f;
-            // interpolated hue
-            uint8_t h = (uint8_t)(hStart + dh * t + 0.5f);
-
-            // physical index, honoring rev
-            uint16_t phys = inf.start + i * inf.step;
-
-            // convert & set
-            uint8_t R, G, B;
-            hsv_to_rgb_rainbow(h, sat, val, &R, &G, &B);
-            add_pixel_color(phys, R, G, B);
+            hues[i] = (uint8_t)(hStart + dh * t + 0.5f);
         }
+        hsv_rainbow_pixels(inf.start, inf.count, inf.step, hues, sat, val);
     }
     anim_time_end();
     update_leds();
@@ -567,23 +453,18 @@ void show_vertex_palette_index(uint8_t sat, uint8_t val, uint8_t hue_offset) {
 /* ────────────────────────────────────────────────────────────────────────── */
 /* SHOW A SINGLE FACE IN ITS “NICE” RGB                                     */
 /* ────────────────────────────────────────────────────────────────────────── */
-void show_face(uint8_t f)
+void show_face(poly_idx_t f)
 {
     set_all_pixels_color(0, 0, 0);
 
     uint8_t r, g, b; face_index_to_rgb(f, &r, &g, &b);
-    const PixelMapping *pm   = mapping_get_map();
-    uint16_t            tot  = mapping_get_total_pixels();
-
-    for (uint8_t i = 0; i < poly.fv[f]; ++i) {
-        uint8_t v0 = poly.f[f][i];
-        uint8_t v1 = poly.f[f][(i + 1) % poly.fv[f]];
-        uint8_t le = poly_find_edge(&poly, v0, v1);
-
-        /* colour every pixel whose mapping.edge == le */
-        for (uint16_t idx = 0; idx < tot; ++idx)
-            if (pm[idx].edge == le)
-                add_pixel_color(pm[idx].phys, r, g, b);
+    uint8_t        n;
+    const EdgeRef *refs = mapping_face_edges(f, &n);
+
+    /* one span per edge of the face */
+    for (uint8_t i = 0; i < n; ++i) {
+        EdgeLedInfo s = mapping_ref_span(&refs[i]);
+        fill_pixels(s.start, s.count, s.step, (rgb_8b){ r, g, b });
     }
     update_leds();
 }
@@ -595,20 +476,38 @@ void show_face(uint8_t f)
 /* --------------------------------------------------------------------------
  * Rainbow cycle (hue moves over time across all pixels)
  * -------------------------------------------------------------------------- */
-static uint8_t rainbow_offset = 0;
-void anim_rainbow_tick(void)
+static uint8_t  rainbow_offset = 0;
+static AnimRate rainbow_rate;
+
+typedef struct {
+    const uint16_t *base;                            /* logical index of every edge's LED 0 */
+    uint16_t        total;
+} RainbowUniforms;
+
+/* hue = logical index * 256 / total, linear along every edge; the offset
+ * turns the table instead, so the indices stay put frame to frame */
+static uint8_t rainbow_stops(poly_idx_t e, const void *uniforms, TexIndexStop *st)
 {
-    const PixelMapping *pm = mapping_get_map();
-    uint16_t total = mapping_get_total_pixels();
+    const RainbowUniforms *u   = uniforms;
+    uint16_t               cnt = mapping_get_edge_info()[e].count;
+    st[0] = (TexIndexStop){   0, (int32_t)((uint32_t)u->base[e] * 65536u / u->total) };
+    st[1] = (TexIndexStop){ 255, (int32_t)((uint32_t)(u->base[e] + cnt - 1) * 65536u / u->total) };
+    return 2;
+}
 
-    for (uint16_t i = 0; i < total; ++i) {
-        uint8_t hue = (uint8_t)( ( (uint32_t)i * 256 / total + rainbow_offset) & 0xFF );
-        uint8_t r,g,b; hsv_to_rgb_rainbow(hue, 255, 120, &r,&g,&b);
-        set_pixel_color(pm[i].phys, r, g, b);
-    }
+void anim_rainbow_tick(void)
+{
+    const RainbowUniforms u = { mapping_get_edge_base(), mapping_get_total_pixels() };
+    if (!u.total || !u.base) return;
+
+    /* the palette may be blending: its shades once per frame, not per LED,
+     * turned by the offset (indexed frames: only the palette changes) */
+    static rgb_8b shade[256];
+    for (uint16_t i = 0; i < 256; ++i) shade[i] = palette_shade((uint8_t)(i + rainbow_offset), 255, 120);
+    tex_run_index(rainbow_stops, &u, shade);
     update_leds();
 
-    rainbow_offset += 1;  /* speed: higher = faster */
+    rainbow_offset += (uint8_t)anim_ref_ticks(&rainbow_rate);  /* one hue step per 1/60 s */
 }
 
 /* --------------------------------------------------------------------------
@@ -616,7 +515,7 @@ void anim_rainbow_tick(void)
  * -------------------------------------------------------------------------- */
 void anim_breath_tick(void)
 {
-    float phase = (sin( (float)HAL_GetTick() * 0.002f ) + 1.0f) * 0.5f;  /* 0..1 */
+    float phase = (fm_sinf((float)HAL_GetTick() * 0.002f) + 1.0f) * 0.5f;  /* 0..1 */
     uint8_t v = (uint8_t)(phase * 255);
 
     set_all_pixels_color(v, v, v);
@@ -625,28 +524,304 @@ void anim_breath_tick(void)
 
 /* --------------------------------------------------------------------------
  * Twinkle – random pixels sparkle
+ *
+ * Sparse: only the live sparkles are touched, a frame costs O(TWINKLE_MAX)
+ * whatever the LED count, and only their dirty blocks get re-encoded. Each
+ * one rises and falls once (phase 0..255), writes its pixel every frame and
+ * black when done. A bitmap per pixel keeps two off the same LED.
  * -------------------------------------------------------------------------- */
+static volatile uint8_t TWINKLE_RATE = 2;    // new sparkles per 1/60 s (while there is room)
+static volatile uint8_t TWINKLE_STEP = 8;    // phase per 1/60 s, 256 / step of them per sparkle
+static AnimRate         twinkle_phase_rate, twinkle_spawn_rate;
+
+#define TWINKLE_MAX 48                       // live sparkles at once
+
+typedef struct {
+    uint16_t px;      // framebuffer index
+    uint8_t  phase;   // 0..255 through the sparkle
+    uint8_t  hue;     // palette position
+} Sparkle;
+
+// carved from the animation arena while it runs (anim_registry)
+static Sparkle  *sparkles    = NULL;   // TWINKLE_MAX, live ones dense in [0, sparkle_n)
+static uint8_t  *sparkle_map = NULL;   // bit per pixel: taken
+static uint16_t  sparkle_n   = 0;
+static uint16_t  twinkle_px  = 0;      // pixels the bitmap was sized for
+static uint32_t  twinkle_layout = 0;
+static bool      twinkle_clean  = false;   // frame cleared for us
+static Rng       twinkle_rng;
+
+static size_t twinkle_scratch(void) {
+    return ANIM_ALIGN4(TWINKLE_MAX * sizeof *sparkles) + (mapping_get_total_pixels() + 7u) / 8u;
+}
+
+static bool twinkle_init(PolyArena *a) {
+    twinkle_px  = mapping_get_total_pixels();
+    sparkles    = poly_arena_alloc(a, TWINKLE_MAX * sizeof *sparkles);
+    sparkle_map = poly_arena_alloc(a, (twinkle_px + 7u) / 8u);
+    if (!sparkles || !sparkle_map) return false;
+    memset(sparkle_map, 0, (twinkle_px + 7u) / 8u);
+    sparkle_n     = 0;
+    twinkle_clean = false;
+    rng_stream(&twinkle_rng, "twinkle");
+    return true;
+}
+
+static void twinkle_teardown(void) {
+    sparkles    = NULL;
+    sparkle_map = NULL;
+    sparkle_n   = 0;
+    twinkle_px  = 0;
+}
+
+static inline bool sparkle_taken(uint16_t p) { return sparkle_map[p >> 3] & (1u << (p & 7)); }
+
 void anim_twinkle_tick(void)
 {
-    const PixelMapping *pm = mapping_get_map();
-    uint16_t total = mapping_get_total_pixels();
-
-    /* fade all pixels slightly */
-    for (uint16_t i = 0; i < total; ++i) {
-        uint8_t r,g,b;
-        get_pixel_color(pm[i].phys, &r,&g,&b); // DOESNT EXIST
-        r = (uint8_t)(r * 0.9f);
-        g = (uint8_t)(g * 0.9f);
-        b = (uint8_t)(b * 0.9f);
-        add_pixel_color(pm[i].phys, r,g,b);
+    if (!sparkles || twinkle_px != mapping_get_total_pixels()) return;   // only through the registry
+    const uint16_t *pm = mapping_get_map();
+
+    /* sparkles own the frame: start from black, again on a new layout; while
+     * a cross-fade mixes into the frame, redraw on black every tick */
+    if (!twinkle_clean || twinkle_layout != mapping_layout_generation() || transition_active()) {
+        if (twinkle_layout != mapping_layout_generation()) {
+            sparkle_n = 0;
+            memset(sparkle_map, 0, (twinkle_px + 7u) / 8u);
+        }
+        set_all_pixels_color(0, 0, 0);
+        twinkle_clean  = !transition_active();
+        twinkle_layout = mapping_layout_generation();
+    }
+    anim_time_start();
+    uint32_t step  = anim_rate_take(&twinkle_phase_rate, TWINKLE_STEP * ANIM_REF_HZ);
+    uint32_t spawn = anim_rate_take(&twinkle_spawn_rate, TWINKLE_RATE * ANIM_REF_HZ);
+    if (step > 255) step = 255;
+
+    /* 1) advance & draw the live ones, retire by moving the last one in */
+    for (uint16_t i = 0; i < sparkle_n; ) {
+        Sparkle *s = &sparkles[i];
+        if (s->phase > 255 - step) {
+            set_pixel_color(MAP_PX(pm, s->px), 0, 0, 0);
+            sparkle_map[s->px >> 3] &= ~(1u << (s->px & 7));
+            *s = sparkles[--sparkle_n];
+            continue;
+        }
+        s->phase += (uint8_t)step;
+        uint8_t v = s->phase < 128 ? s->phase * 2 : (255 - s->phase) * 2;   // up, then down
+        rgb_8b  c = palette_shade(s->hue, 200, v);
+        set_pixel_color(MAP_PX(pm, s->px), c.r, c.g, c.b);
+        ++i;
+    }
+
+    /* 2) a few new ones on free pixels */
+    for (uint32_t k = 0; k < spawn && sparkle_n < TWINKLE_MAX && sparkle_n < twinkle_px; ++k) {
+        uint16_t p = (uint16_t)rng_below(&twinkle_rng, twinkle_px);
+        if (sparkle_taken(p)) continue;                  // try again next tick
+        sparkle_map[p >> 3] |= 1u << (p & 7);
+        sparkles[sparkle_n++] = (Sparkle){ p, 0, (uint8_t)rng_u32(&twinkle_rng) };
+    }
+    anim_time_end();
+
+    update_leds();
+}
+
+
+
+/* --------------------------------------------------------------------------
+ * Kaleidoscope – rings travelling out of every vertex at once
+ *
+ * The colour only depends on how far an LED is from the nearer end of its
+ * edge, so it looks the same after any rotation of the solid: shaded on the
+ * fundamental domain only (led_symmetry), the rest copied.
+ * -------------------------------------------------------------------------- */
+static volatile uint8_t KALEIDO_RINGS = 3;    // palette sweeps from vertex to edge middle
+static volatile uint8_t KALEIDO_SPEED = 2;    // palette steps per 1/60 s
+static uint8_t          kaleido_phase = 0;
+static AnimRate         kaleido_rate;
+
+typedef struct {
+    uint8_t phase;
+    uint8_t rings;
+} KaleidoUniforms;
+
+static void kaleido_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const KaleidoUniforms *u = uniforms;
+    const LedAttr         *a = b->attr;
+    for (uint16_t k = 0; k < b->n; ++k, a += b->step) {
+        uint8_t d   = a->t < 128 ? a->t : 255 - a->t;               // 0 at a vertex, 127 mid edge
+        uint8_t i   = (uint8_t)(d * 2 * u->rings - u->phase);
+        uint8_t val = (uint8_t)(255 - ((d * 301) >> 8));            // brighter at the vertices
+        out[k] = palette_shade(i, 255, val);
+    }
+}
+
+static void anim_kaleido_tick(void)
+{
+    anim_time_start();
+    static const Shader kaleido = { kaleido_kernel, SHADER_IN_ATTR, SHADER_WRITE };
+    const KaleidoUniforms u = { kaleido_phase, KALEIDO_RINGS };
+    sym_run(&kaleido, &u);
+    kaleido_phase += (uint8_t)anim_rate_take(&kaleido_rate, KALEIDO_SPEED * ANIM_REF_HZ);
+    anim_time_end();
+    update_leds();
+}
+
+static void kaleido_teardown(void) { sym_release(); }
+static bool kaleido_warm(uint32_t step) { (void)step; sym_ready(); return false; }
+
+
+
+/* --------------------------------------------------------------------------
+ * Face spin – a comet running round the rim of every face
+ *
+ * LedAttr.perim has each LED's place around both its faces, so an LED only
+ * compares two bytes with the head: the brighter of its faces' tails wins,
+ * in that face's colour. Neighbouring faces run their shared edge in
+ * opposite directions (both wound outward), the comets cross there.
+ * -------------------------------------------------------------------------- */
+static volatile uint8_t FACESPIN_TAIL  = 96;  // of a turn (256)
+static volatile uint8_t FACESPIN_SPEED = 3;   // 1/256 turns per 1/60 s
+static uint8_t          facespin_head  = 0;
+static AnimRate         facespin_rate;
+
+typedef struct {
+    uint8_t    head;
+    uint8_t    tail;
+    poly_idx_t faces;
+} FaceSpinUniforms;
+
+static void facespin_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const FaceSpinUniforms *u = uniforms;
+    poly_idx_t f[2];
+    poly_edge_faces(&poly, b->edge, f);
+    const uint8_t hue[2] = { (uint8_t)((uint16_t)f[0] * 256u / u->faces),
+                             (uint8_t)((uint16_t)f[1] * 256u / u->faces) };
+
+    const LedAttr *a = b->attr;
+    for (uint16_t k = 0; k < b->n; ++k, a += b->step) {
+        uint8_t val = 0, h = 0;
+        for (uint8_t j = 0; j < 2; ++j) {
+            if (f[j] == POLY_IDX_NONE) continue;
+            uint8_t d = (uint8_t)(u->head - a->perim[j]);           // behind the head
+            if (d >= u->tail) continue;
+            uint8_t v = (uint8_t)(255 - d * 255u / u->tail);
+            if (v > val) { val = v; h = hue[j]; }
+        }
+        out[k] = palette_shade(h, 255, val);
+    }
+}
+
+static void anim_facespin_tick(void)
+{
+    anim_time_start();
+    static const Shader facespin = { facespin_kernel, SHADER_IN_ATTR, SHADER_WRITE };
+    const FaceSpinUniforms u = { facespin_head, FACESPIN_TAIL ? FACESPIN_TAIL : 1, poly.F };
+    shader_run(&facespin, &u);
+    facespin_head += (uint8_t)anim_rate_take(&facespin_rate, FACESPIN_SPEED * ANIM_REF_HZ);
+    anim_time_end();
+    update_leds();
+}
+
+
+
+/* --------------------------------------------------------------------------
+ * Scanline – a plane rising and falling through the sculpture
+ *
+ * spatial_band() hands over the LEDs within SCAN_WIDTH of the plane as one
+ * slice of the axis' sorted order, the rest only fades: the cost is the
+ * band, not the 720 LEDs.
+ * -------------------------------------------------------------------------- */
+static volatile uint8_t SCAN_AXIS  = SPATIAL_AXIS_Z;
+static float            SCAN_WIDTH = 0.15f;   // half the band, unit sphere
+static float            SCAN_SPEED = 0.6f;    // plane travel, units per second
+static float            scan_at    = -1.0f;
+static int8_t           scan_dir   = 1;
+static AnimRate         scan_fade_rate;
+
+// the axis order sorted before the first band
+static bool scanline_warm(uint32_t step)
+{
+    (void)step;
+    spatial_warm((SpatialAxis)(SCAN_AXIS % SPATIAL_AXIS_COUNT));
+    return false;
+}
+
+static void anim_scanline_tick(void)
+{
+    uint32_t fades = anim_ref_ticks(&scan_fade_rate);
+    if (fades) fade_frame(40, (uint8_t)(fades > 8 ? 8 : fades));
+    anim_time_start();
+
+    scan_at += scan_dir * SCAN_SPEED * anim_clock_dt();
+    if (scan_at >  1.0f) { scan_at =  1.0f; scan_dir = -1; }
+    if (scan_at < -1.0f) { scan_at = -1.0f; scan_dir =  1; }
+
+    const SpatialAxis a = (SpatialAxis)(SCAN_AXIS % SPATIAL_AXIS_COUNT);
+    const float       w = SCAN_WIDTH > 0.01f ? SCAN_WIDTH : 0.01f;
+    float dir[3];
+    const uint16_t *idx;
+    uint16_t n = spatial_axis_dir(a, dir) ? spatial_band(a, scan_at - w, scan_at + w, &idx) : 0;
+
+    const LedPos *pos = mapping_get_led_pos();
+    const uint8_t hue = (uint8_t)((scan_at + 1.0f) * 127.5f);
+    for (uint16_t k = 0; k < n; ++k) {
+        const uint16_t p = idx[k];
+        float d = LED_POS_F(pos[p].x) * dir[0] + LED_POS_F(pos[p].y) * dir[1]
+                + LED_POS_F(pos[p].z) * dir[2] - scan_at;
+        uint8_t v = (uint8_t)(255.0f * (1.0f - fabsf(d) / w));
+        rgb_8b  c = palette_shade(hue, 255, v);
+        set_pixel_color(p, c.r, c.g, c.b);
+    }
+
+    anim_time_end();
+    update_leds();
+}
+
+
+
+/* --------------------------------------------------------------------------
+ * Snake – one head along a closed walk of the whole frame (led_paths)
+ *
+ * The walk is a list of directed edges found when the scene loaded, so the
+ * head only counts LEDs and steps on at an edge's end; the fade draws the
+ * body. Hue runs once round the colours per lap.
+ * -------------------------------------------------------------------------- */
+static volatile uint8_t SNAKE_PATH  = PATH_HAMILTON;   // PathKind, EULER_2 if the solid has none
+static volatile uint8_t SNAKE_SPEED = 1;               // LEDs per 1/60 s
+static volatile uint8_t SNAKE_FADE  = 24;              // per 1/60 s, shorter body when higher
+static uint16_t         snake_step, snake_led;
+static AnimRate         snake_rate;
+
+static void anim_snake_tick(void)
+{
+    uint16_t        n;
+    const PathStep *path = path_get((PathKind)SNAKE_PATH, &n);
+    if (!n) path = path_get(PATH_EULER_2, &n);
+    uint32_t ticks = anim_ref_ticks(&snake_rate);
+    if (!n || !ticks) {
+        update_leds();
+        return;
     }
+    if (ticks > 8) ticks = 8;
+    fade_frame(SNAKE_FADE, (uint8_t)ticks);
+    anim_time_start();
 
-    /* randomly pick 5% of LEDs to flash */
-    for (uint16_t k = 0; k < total/20; ++k){
-        uint16_t idx = rand() % total;
-        uint8_t r,g,b; hsv_to_rgb_rainbow(rand() & 0xFF, 200, 255, &r,&g,&b);
-        add_pixel_color(pm[idx].phys, r,g,b);
+    for (uint32_t k = ticks * SNAKE_SPEED; k--; ) {
+        if (snake_step >= n) snake_step = 0;               /* another walk picked */
+        EdgeLedInfo sp = path_span(path[snake_step]);
+        if (snake_led >= sp.count) {
+            snake_led = 0;
+            if (++snake_step >= n) snake_step = 0;
+            sp = path_span(path[snake_step]);
+        }
+        rgb_8b c = palette_color((uint8_t)((uint32_t)snake_step * 256u / n));
+        set_pixel_color((uint16_t)(sp.start + snake_led * sp.step), c.r, c.g, c.b);
+        ++snake_led;
     }
+
+    anim_time_end();
     update_leds();
 }
 
@@ -657,28 +832,182 @@ void anim_twinkle_tick(void)
  * ==================================================================================================================================================== */
 static float plasma_phase = 0.f;
 float K1=4.3f, K2=2.7f, K3=3.7f; /* spatial frequencies */
-float speed = 0.015f;            /* radians per frame   */
+float speed = 0.015f;            /* radians per 1/60 s  */
+
+/* sin(a + p) = sin a · cos p + cos a · sin p: the spatial part a_i = k_i · v
+ * is fixed per LED, so its sin / cos are cached (Q14) and a frame costs six
+ * lut_sinf() in total plus three multiply-adds per axis and LED. Rebuilt when
+ * K1..K3, the view (k_i has R folded in) or the LED positions change. */
+typedef struct {
+    int16_t s[3], c[3];                // sin / cos of k_i · v, Q14
+} PlasmaBasis;
+
+#define PLASMA_Q14 16384.0f
+
+static PlasmaBasis *plasma_basis = NULL;   // per framebuffer index, animation arena
+static float        plasma_k[3];           // K1..K3 it was built for
+static uint32_t     plasma_view_gen, plasma_map_gen;
+static bool         plasma_valid = false;
+
+static size_t plasma_scratch(void) { return mapping_get_total_pixels() * sizeof *plasma_basis; }
+
+static bool plasma_init(PolyArena *a) {
+    plasma_basis = poly_arena_alloc(a, mapping_get_total_pixels() * sizeof *plasma_basis);
+    plasma_valid = false;
+    return plasma_basis != NULL;
+}
+
+static void plasma_teardown(void) { plasma_basis = NULL; plasma_valid = false; }
+
+static bool plasma_build_basis(void)
+{
+    const LedPos *led_pos = mapping_get_led_pos();
+    if (!led_pos) return false;
+    uint32_t view_gen = view_generation();
+    uint32_t map_gen  = mapping_generation();
+    if (plasma_valid && plasma_k[0] == K1 && plasma_k[1] == K2 && plasma_k[2] == K3
+        && plasma_view_gen == view_gen && plasma_map_gen == map_gen) return true;
+
+    /* the view rotation folded into the spatial frequencies:
+     * K1 * (R·v).x == (K1 * R[0]) · v */
+    const float (*R)[3] = view_matrix();
+    const float  K[3]   = { K1, K2, K3 };
+    uint16_t     tot    = mapping_get_total_pixels();
+    for (uint16_t p = 0; p < tot; ++p) {
+        Vec3 v = led_xyz(led_pos, p);
+        for (int i = 0; i < 3; ++i) {
+            float a = K[i] * (R[i][0]*v.x + R[i][1]*v.y + R[i][2]*v.z);
+            plasma_basis[p].s[i] = (int16_t)(lut_sinf(a) * PLASMA_Q14);
+            plasma_basis[p].c[i] = (int16_t)(lut_cosf(a) * PLASMA_Q14);
+        }
+    }
+    plasma_k[0] = K1; plasma_k[1] = K2; plasma_k[2] = K3;
+    plasma_view_gen = view_gen;
+    plasma_map_gen  = map_gen;
+    plasma_valid    = true;
+    return true;
+}
+
+typedef struct {
+    const PlasmaBasis *basis;
+    int16_t            sp[3], cp[3];   // sin / cos of the per-axis phase, Q14
+} PlasmaUniforms;
+
+static void plasma_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const PlasmaUniforms *u = uniforms;
+    const PlasmaBasis    *q = u->basis + b->px;
+    for (uint16_t k = 0; k < b->n; ++k, q += b->step) {
+        /* Σ sin(a_i + p_i), Q28, |sum| <= 3 << 28 */
+        int32_t n = q->s[0] * u->cp[0] + q->c[0] * u->sp[0]
+                  + q->s[1] * u->cp[1] + q->c[1] * u->sp[1]
+                  + q->s[2] * u->cp[2] + q->c[2] * u->sp[2];
+        /* map [-3..+3] → [0..255]: (n + 3) * 255/6, in Q14 */
+        int32_t n14 = (n >> 14) + 3 * 16384;
+        if (n14 < 0) n14 = 0;
+        uint8_t hue = (uint8_t)((n14 * 85) >> 15);
+        out[k] = palette_shade(hue, 255, 180);
+    }
+}
 
 void anim_plasma_swirl_tick(void)
 {
-    if(!build_led_pos_cache()){
+    if (!plasma_basis || !plasma_build_basis()) {   // only through the registry
     	return;
     }
 
     g_global_brightness = 200;
 
-    uint16_t tot = mapping_get_total_pixels();
-    for (uint16_t p=0; p<tot; ++p){
-        Vec3 v = led_pos[p];
-        float n =  sinf(K1*v.x + plasma_phase)
-                 + sinf(K2*v.y + plasma_phase*0.8f)
-                 + sinf(K3*v.z + plasma_phase*1.3f);
-        /* clamp & map [-3..+3] → [0..255] */
-        uint8_t hue = (uint8_t)(((n + 3.f) * 42.5f));   /* 255/6 ≈ 42.5 */
-        uint8_t r,g,b; hsv_to_rgb_rainbow(hue, 255, 180, &r,&g,&b);
-        set_pixel_color(p, r,g,b);
+    const float ph[3] = { plasma_phase, plasma_phase * 0.8f, plasma_phase * 1.3f };
+    PlasmaUniforms u = { .basis = plasma_basis };
+    for (int i = 0; i < 3; ++i) {
+        u.sp[i] = (int16_t)(lut_sinf(ph[i]) * PLASMA_Q14);
+        u.cp[i] = (int16_t)(lut_cosf(ph[i]) * PLASMA_Q14);
     }
-    plasma_phase += speed;
+    /* the field is smooth along an edge: worked out every 4th LED (every
+     * 8th under load), the LEDs between are blended */
+    uint8_t q      = gov_level();
+    Shader  plasma = { plasma_kernel, 0, SHADER_WRITE, 0, q >= 2 ? SHADER_COARSE_8 : SHADER_COARSE_4 };
+    shader_run(&plasma, &u);
+    plasma_phase += speed * anim_clock_ref();
+    update_leds();
+}
+
+
+
+/* ====================================================================================================================================================
+ * ------[ LAVA / AURORA  (simplex noise, led_noise)
+ * ==================================================================================================================================================== */
+/* the noise repeats every 256 cells, time wraps there without a seam */
+#define NOISE_T_WRAP  (256 * NOISE_ONE - 1)
+
+static volatile uint8_t LAVA_SCALE   = 3;     // noise cells across the unit sphere
+static volatile uint8_t LAVA_SPEED   = 3;     // 1/256 cells per 1/60 s, upwards
+static volatile uint8_t AURORA_SCALE = 2;
+static volatile uint8_t AURORA_SPEED = 2;
+static int32_t          lava_t = 0, aurora_t = 0;   // Q16
+
+typedef struct {
+    const float (*R)[3];    // view: world z is up
+    float         scale;
+    int32_t       t;        // Q16
+} NoiseUniforms;
+
+static void lava_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const NoiseUniforms *u = uniforms;
+    for (uint16_t k = 0; k < b->n; ++k) {
+        const float v[3] = { b->x[k], b->y[k], b->z[k] };
+        float       w[3];
+        view_apply(u->R, v, w);
+        /* blobs rising through the solid, two octaves */
+        int16_t n = noise3_fbm(noise_coord(w[0], u->scale), noise_coord(w[1], u->scale),
+                               noise_coord(w[2], u->scale) - u->t, 2);
+        out[k] = palette_shade((uint8_t)((n + 32768) >> 8), 255, 255);
+    }
+}
+
+static void aurora_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const NoiseUniforms *u = uniforms;
+    for (uint16_t k = 0; k < b->n; ++k) {
+        const float v[3] = { b->x[k], b->y[k], b->z[k] };
+        float       w[3];
+        view_apply(u->R, v, w);
+        /* curtains: bright along the zero lines of a horizontal field that drifts
+         * with time, colour by height */
+        int16_t  n     = noise3_q15(noise_coord(w[0], u->scale), noise_coord(w[1], u->scale), u->t);
+        uint32_t ridge = 32767u - (uint32_t)(n < 0 ? -n : n);            // 32767 on the line
+        uint8_t  val   = (uint8_t)((ridge * ridge) >> 22);               // ^2, 0..255
+        float    h     = w[2] < -1.0f ? -1.0f : (w[2] > 1.0f ? 1.0f : w[2]);
+        out[k] = palette_shade((uint8_t)(128.0f + h * 127.0f), 255, val);
+    }
+}
+
+static void noise_run(ShaderKernel kernel, float scale, int32_t t, uint8_t interlace)
+{
+    const NoiseUniforms u = { view_matrix(), scale, t };
+    const Shader        s = { kernel, SHADER_IN_POS, SHADER_WRITE, interlace };
+    shader_run(&s, &u);
+}
+
+static void anim_lava_tick(void)
+{
+    anim_time_start();
+    uint8_t q = gov_level();
+    noise_run(lava_kernel, LAVA_SCALE, lava_t,
+              q >= 2 ? SHADER_IL_4 | SHADER_IL_BLEND : q ? SHADER_IL_2 | SHADER_IL_BLEND : 0);
+    lava_t = (lava_t + (int32_t)(LAVA_SPEED * (NOISE_ONE / 256) * anim_clock_ref())) & NOISE_T_WRAP;
+    anim_time_end();
+    update_leds();
+}
+
+static void anim_aurora_tick(void)
+{
+    anim_time_start();
+    noise_run(aurora_kernel, AURORA_SCALE, aurora_t, gov_level() >= 2 ? SHADER_IL_2 : 0);
+    aurora_t = (aurora_t + (int32_t)(AURORA_SPEED * (NOISE_ONE / 256) * anim_clock_ref())) & NOISE_T_WRAP;
+    anim_time_end();
     update_leds();
 }
 
@@ -691,213 +1020,86 @@ void anim_plasma_swirl_tick(void)
 // Configuration (tweak as desired)
 static volatile uint8_t NUM_STARS = 13;
 static volatile uint8_t TAIL_LEN = 5;
-static volatile uint8_t STAR_SPEED = 1;  // LEDs per animation tick
+static volatile uint8_t STAR_SPEED = 1;  // LEDs per 1/60 s
 
-bool initialized_stars = false;
+#define STARS_MAX 30                   // NUM_STARS upper bound
 
-// Per-star state
-typedef struct {
-    uint8_t  edge;        // current edge
-    uint8_t  prev_edge;   // previous edge (for tail spill)
-    bool     dir;         // false=A→B, true=B→A
-    bool     prev_dir;    // direction on prev_edge
-    int16_t  pos;         // head position on current edge
-} Star;
-
-// Static storage
-static Star stars[30];
-/* -------------------------------------------------------------------------- */
-// Initialize stars: random start edges & directions
-void init_shooting_stars(void) {
-	if (initialized_stars == true){
-		return;
-	}
-    const uint8_t E = poly.E;
-    const EdgeLedInfo *info = mapping_get_edge_info();
-    for (int i = 0; i < NUM_STARS; ++i) {
-        stars[i].edge      = rand() % E;
-        stars[i].prev_edge = stars[i].edge;
-        stars[i].dir       = rand() & 1;
-        stars[i].prev_dir  = stars[i].dir;
-        // start just off the tail, so they “enter” cleanly
-        uint16_t cnt = info[ stars[i].edge ].count;
-        uint16_t offset = rand() % cnt;                 /* random start */
-        stars[i].pos = (int16_t)offset;
-    }
-    initialized_stars = true;
+// pool carved from the animation arena while the stars run (anim_registry)
+static ParticlePool stars_pool;
+static bool         initialized_stars = false;
+static uint32_t     stars_layout = 0;  // mapping_layout_generation() they were placed for
+static AnimRate     stars_rate;        // pool steps (1/60 s each) owed
+static AnimRate     stars_fade_rate;   // fades, 2 per step
+
+static size_t stars_scratch(void) {
+    return particles_bytes(STARS_MAX, poly.E);
 }
-/* -------------------------------------------------------------------------- */
 
-// returns true if any star is currently sitting on edge `e`
-static bool edge_is_occupied(uint8_t e) {
-    for (int i = 0; i < NUM_STARS; ++i) {
-        if (stars[i].edge == e) return true;
-    }
-    return false;
+static bool stars_init(PolyArena *a) {
+    initialized_stars = false;         // placed on the first tick
+    if (!particles_init(&stars_pool, a, STARS_MAX)) return false;
+    rng_stream(&stars_pool.rng, "stars");
+    return true;
 }
 
-/*
- * Pick a new edge at vertex v, excluding the edge we came from.
- * Prefer edges with no star on them right now.
- *
- * Uses reservoir sampling to choose uniformly at random
- * without storing all candidates in an array.
- */
-static uint8_t pick_next_edge(uint8_t v, uint8_t exclude_edge) {
-    uint8_t choice;
-    int     count = 0;
-
-    // 1) Try to pick among *free* edges
-    for (uint8_t e = 0; e < poly.E; ++e) {
-        if (e == exclude_edge) continue;
-        Edge ed = poly.e[e];
-        if ((ed.a != v && ed.b != v) || edge_is_occupied(e))
-            continue;
-        // reservoir: each candidate *could* become the choice with prob 1/count
-        if (rand() % (++count) == 0) {
-            choice = e;
-        }
-    }
-    if (count > 0) {
-        return choice;
-    }
+static void stars_teardown(void) {
+    memset(&stars_pool, 0, sizeof stars_pool);
+    initialized_stars = false;
+}
 
-    // 2) No free edges? pick among *busy* edges instead
-    count = 0;
-    for (uint8_t e = 0; e < poly.E; ++e) {
-        if (e == exclude_edge) continue;
-        Edge ed = poly.e[e];
-        if (ed.a != v && ed.b != v) continue;
-        if (!edge_is_occupied(e)) continue;
-        if (rand() % (++count) == 0) {
-            choice = e;
-        }
+static bool stars_warm(uint32_t step) { (void)step; raster_warm(); return false; }
+/* -------------------------------------------------------------------------- */
+// one white star at a random edge, position & direction
+static void spawn_star(void) {
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    Rng       *r = &stars_pool.rng;
+    poly_idx_t e = (poly_idx_t)rng_below(r, poly.E);
+    particles_spawn(&stars_pool, e, rng_u32(r) & 1, (int16_t)rng_below(r, info[e].count),
+                    STAR_SPEED, TAIL_LEN, 0, (rgb_8b){ 255, 255, 255 });
+}
+
+// (re)place all stars on a new layout, follow NUM_STARS when changed from the debugger
+static void init_shooting_stars(void) {
+	if (initialized_stars == false || stars_layout != mapping_layout_generation()){
+		particles_clear(&stars_pool);
+		initialized_stars = true;
+		stars_layout      = mapping_layout_generation();
+	}
+    uint8_t want = NUM_STARS > STARS_MAX ? STARS_MAX : NUM_STARS;
+    while (stars_pool.n > want) particles_retire(&stars_pool, stars_pool.n - 1);
+    while (stars_pool.n < want) spawn_star();
+    for (uint16_t i = 0; i < stars_pool.n; ++i) {
+        stars_pool.speed[i] = STAR_SPEED;
+        stars_pool.tail[i]  = TAIL_LEN;
     }
-    // if still nothing (shouldn’t happen), fall back
-    return (count > 0) ? choice : exclude_edge;
 }
 /* -------------------------------------------------------------------------- */
 // Animation tick: call this from your main loop
 void anim_shooting_stars_tick(void) {
-    // 1) clear frame
+    if (!stars_pool.cap) return;       // only through the registry
 	init_shooting_stars();
-	fade_frame(50, 2);
-    anim_time_start();
-    const EdgeLedInfo *info = mapping_get_edge_info();
 
-    // 2) advance & draw each star
-    for (int i = 0; i < NUM_STARS; ++i) {
-        Star *S = &stars[i];
-        EdgeLedInfo inf = info[S->edge];
-        uint16_t leds = inf.count;
-
-        // advance head
-        S->pos += (S->dir ? -STAR_SPEED : STAR_SPEED);
-        bool crossed = (S->pos < 0 || S->pos >= (int)leds);
-
-        if (crossed) {
-            /* remember where we came from *before* we change anything       */
-            S->prev_edge = S->edge;
-            S->prev_dir  = S->dir;
-            // determine arrival vertex
-            Edge ed = poly.e[S->edge];
-            uint8_t arrived = S->dir ? ed.a : ed.b;
-            // pick next edge & direction
-            uint8_t next = pick_next_edge(arrived, S->edge);
-            Edge ne = poly.e[next];
-            // determine logical direction along new edge
-            S->dir = (ne.b == arrived);
-            S->edge = next;
-            // reset pos just beyond start
-            //S->pos  = S->dir ? leds - 1 + STAR_SPEED : -STAR_SPEED;
-            uint16_t cnt2 = info[next].count;
-            S->pos  = S->dir ? (cnt2 - 1) : 0;        /* no overshoot? */
-        }
-        /* draw tail – may span current *and* previous edge */
-        const EdgeLedInfo *inf_cur  = &info[S->edge];
-        const EdgeLedInfo *inf_prev = &info[S->prev_edge];
-        // draw tail behind head
-        for (int t = 0; t < TAIL_LEN; ++t) {
-            int16_t p = S->pos + (S->dir ? +t : -t);
-            uint8_t bright = 255 * (TAIL_LEN - t) / TAIL_LEN;
-
-            /* 1) on current edge? */
-            if (p >= 0 && p < (int)inf_cur->count) {
-                uint16_t phys = inf_cur->start + p * inf_cur->step;
-                add_pixel_color(phys, bright, bright, bright);
-            }
-            /* 2) overspill onto previous edge */
-            else {
-                int16_t pp = p;
-                /* map p into [0..count-1] of previous edge respecting dir */
-                if (S->prev_dir)  pp += inf_prev->count;   /* came from A→B */
-                else              pp -= inf_prev->count;   /* came from B→A */
-                if (pp >= 0 && pp < (int)inf_prev->count) {
-                    uint16_t phys = inf_prev->start + pp * inf_prev->step;
-                    add_pixel_color(phys, bright, bright, bright);
-                }
-            }
-        }
+    // whole pool steps at 60 per second (the speeds are LEDs per step), a
+    // slow frame catches up on them; drawn again at every fade (120 per
+    // second) with the heads between two steps; none due: the picture stays
+    uint32_t steps = anim_sim_take(&stars_rate, ANIM_REF_HZ);
+    uint32_t fades = anim_rate_take(&stars_fade_rate, 2 * ANIM_REF_HZ);
+    if (!fades) {
+        update_leds();
+        return;
     }
+	fade_frame(50, (uint8_t)(fades > 8 ? 8 : fades));
+    anim_time_start();
+    while (steps--) particles_step(&stars_pool);   // advance, hop edges at the vertices
+    // head + tail, spilling onto the previous edge
+    particles_draw(&stars_pool, (uint8_t)(anim_sim_alpha(&stars_rate) * 255.0f));
     anim_time_end();
 
-    // 3) push to strips
+    // push to strips
     update_leds();
 }
 
 
-/*
-
-		typedef struct {
-		  const char * name;
-		  MinefieldSettings data;
-		} Preset;
-
-		static Preset minefield_presets[] = {
-		  { "default",      { 1.2f, 0.015f, 0.3f, 241, 2.3f } },
-		  { "deep_slow",    { 0.5f, 0.010f, 0.5f, 200, 3.0f } },
-		  { "fast_shallow", { 3.0f, 0.020f, 0.1f, 255, 1.0f } },
-		};
-		static const size_t minefield_preset_count =
-		  sizeof(minefield_presets)/sizeof(*minefield_presets);
-
-
-typedef void (*AnimTickFn)(void);
-
-typedef struct {
-  const char     *name;
-  AnimTickFn      tick;
-  ParamDef       *params;
-  size_t          param_count;
-} Animation;
-
-static Animation animations[] = {
-  { "minefield", anim_minefield_tick, minefield_params, minefield_param_count },
-  // { "plasma",    anim_plasma_swirl_tick,    plasma_params, plasma_count },
-  // …more…
-};
-static const size_t animation_count = sizeof(animations)/sizeof(*animations);
-
-
-typedef enum { PT_FLOAT, PT_UINT8 } ParamType;
-
-typedef struct {
-  const char *name;
-  const char *desc;
-  ParamType   type;
-  void       *ptr;    // &minefield.wave_speed, etc.
-  float       min, max;
-} ParamDef;
-
-static ParamDef minefield_params[] = {
-  { "burst_hz",        "Explosions per second",        PT_FLOAT,  &minefield.burst_hz,        0.1f, 10.0f },
-  { "wave_speed",      "Wave speed (units per tick)",  PT_FLOAT,  &minefield.wave_speed,      0.001f, 1.0f },
-  { "shell_thickness", "Shell half-width",             PT_FLOAT,  &minefield.shell_thickness, 0.0f,   1.0f },
-  { "fade_amount",     "Fade amount (0–255)",          PT_UINT8,  &minefield.fade_amount,     0,     255   },
-  { "falloff_exp",     "Falloff exponent",             PT_FLOAT,  &minefield.falloff_exp,     0.5f,  8.0f  },
-};
-static const size_t minefield_param_count = sizeof(minefield_params)/sizeof(*minefield_params);
-*/
 
 /* ====================================================================================================================================================
  * ------[ Minefield shockwave
@@ -906,8 +1108,6 @@ static const size_t minefield_param_count = sizeof(minefield_params)/sizeof(*min
 #define MAX_CONCURRENT_EXPLOSIONS 20
 #define POLY_RADIUS              2.0f  // normalized polyhedron radius
 
-#define PALETTE_SIZE			16
-
 // User-tweakable settings struct, with randomization ranges
 typedef struct {
     float   expl_per_sec;         // explosions per second
@@ -918,8 +1118,7 @@ typedef struct {
     uint8_t fade_amount;          // frame fade (0–255)
     float   falloff_exp;          // spatial exponent for shell edge
     float   radial_falloff_exp;   // exponent for distance fade
-    uint8_t palette[PALETTE_SIZE];          // hue values for explosions;               // explosion lifetime in seconds
-} MinefieldSettings;
+} MinefieldSettings;         // colours: the active palette (led_palette, "minefield" by default)
 
 static MinefieldSettings minefield = {
     .expl_per_sec            = 0.35f,
@@ -930,17 +1129,9 @@ static MinefieldSettings minefield = {
     .fade_amount             = 11,
     .falloff_exp             = 2.1f,
     .radial_falloff_exp      = 2.2f, //1.3
-    .palette                 = { 240, 136, 46, 47, 48, 243, 237, 165,160 } //240 - 245 //46 - 48
 };
 
 
-//    .palette = { 232, 168, 46 },  // Neon Pink, Electric Blue, Acid Yellow
-//    .palette = { 240, 176, 136, 4 },  // Hot Pink, Deep Blue, Aqua, Vivid Red
-//    .palette = { 248, 170, 46, 8 },  // Magenta, Cool Blue, Neon Yellow, Bright Red
-//    .palette = { 208, 136, 48 },  // Purple, Aqua, Lime
-//    .palette = { 240, 168, 8 },  // Hot Pink, Electric Blue, Bright Red
-
-
 // Explosion state with per-instance parameters and age
 typedef struct {
     bool     active;
@@ -949,146 +1140,566 @@ typedef struct {
     float    speed;
     float    thickness;
 
-    uint8_t  hue;
-    float    min_r2;
-    float    max_r2;
+    uint8_t  color;       // palette index
 } Explosion;
 
-extern uint8_t debug_hue;
+// carved from the animation arena while the minefield runs (anim_registry)
+static Explosion *explosions = NULL;   // MAX_CONCURRENT_EXPLOSIONS
+static uint16_t  *best       = NULL;   // per pixel: intensity << 8 | palette index, rebuilt every frame
+static Rng        minefield_rng;       // reseeded on every start
+static AnimRate   minefield_sim;       // ANIM_SIM_HZ steps of the shells
+static float      minefield_due;       // explosions owed, spawned at 1
+
+/* falloff curves 255 * (i / 255)^exp for the shell edge and the distance
+ * fade, rebuilt when falloff_exp / radial_falloff_exp change (debugger) */
+#define FALLOFF_STEPS 256
+static uint8_t  *falloff_shell  = NULL;  // FALLOFF_STEPS, falloff_exp
+static uint8_t  *falloff_radial = NULL;  // FALLOFF_STEPS, radial_falloff_exp
+static float     falloff_built[2];       // exponents the curves hold
+
+static size_t minefield_scratch(void) {
+    return ANIM_ALIGN4(MAX_CONCURRENT_EXPLOSIONS * sizeof *explosions)
+         + 2 * FALLOFF_STEPS
+         + mapping_get_total_pixels() * sizeof *best;
+}
+
+static bool minefield_init(PolyArena *a) {
+    explosions     = poly_arena_alloc(a, MAX_CONCURRENT_EXPLOSIONS * sizeof *explosions);
+    falloff_shell  = poly_arena_alloc(a, 2 * FALLOFF_STEPS);
+    falloff_radial = falloff_shell ? falloff_shell + FALLOFF_STEPS : NULL;
+    best           = poly_arena_alloc(a, mapping_get_total_pixels() * sizeof *best);
+    if (!explosions || !falloff_shell || !best) return false;
+    memset(explosions, 0, MAX_CONCURRENT_EXPLOSIONS * sizeof *explosions);
+    falloff_built[0] = falloff_built[1] = -1.0f;   // built on the first tick
+    rng_stream(&minefield_rng, "minefield");
+    minefield_sim = (AnimRate){ 0 };
+    minefield_due = 1.0f;                          // the first one right away
+    return true;
+}
+
+static void minefield_teardown(void) {
+    explosions     = NULL;
+    falloff_shell  = NULL;
+    falloff_radial = NULL;
+    best           = NULL;
+}
 
-static Explosion explosions[MAX_CONCURRENT_EXPLOSIONS];
+// the edge spheres the shell queries start from
+static bool minefield_warm(uint32_t step) { (void)step; spatial_warm(SPATIAL_AXIS_COUNT); return false; }
+
+static void falloff_curve(uint8_t *c, float ex) {
+    for (int i = 0; i < FALLOFF_STEPS; ++i)
+        c[i] = (uint8_t)(255.0f * powf(i / (float)(FALLOFF_STEPS - 1), ex) + 0.5f);
+}
+
+static void falloff_update(void) {
+    if (falloff_built[0] != minefield.falloff_exp) {
+        falloff_curve(falloff_shell, minefield.falloff_exp);
+        falloff_built[0] = minefield.falloff_exp;
+    }
+    if (falloff_built[1] != minefield.radial_falloff_exp) {
+        falloff_curve(falloff_radial, minefield.radial_falloff_exp);
+        falloff_built[1] = minefield.radial_falloff_exp;
+    }
+}
+
+// curve value for x in [0..1]
+static inline uint8_t falloff_at(const uint8_t *c, float x) {
+    return c[(uint8_t)(x * (FALLOFF_STEPS - 1) + 0.5f)];
+}
 
 // helper to pick a random value in [base-range, base+range]
 static inline float rand_range(float base, float range) {
-    return base + range * ((rand()/(float)RAND_MAX) * 2.0f - 1.0f);
+    return base + range * (rng_float(&minefield_rng) * 2.0f - 1.0f);
 }
 
-// Spawn a new explosion with randomized speed and thickness
-static void spawn_explosion(void) {
+// Spawn a new explosion with randomized speed and thickness, none if `cap` are running
+static void spawn_explosion(int cap) {
+    int running = 0;
+    for (int i = 0; i < MAX_CONCURRENT_EXPLOSIONS; ++i) running += explosions[i].active;
+    if (running >= cap) return;
     for (int i = 0; i < MAX_CONCURRENT_EXPLOSIONS; ++i) {
         Explosion *xpl = &explosions[i];
         if (!xpl->active) {
-        	if(debug_hue != 0){
-        		for (int p_idx; p_idx < PALETTE_SIZE; p_idx++){
-        		        		minefield.palette[p_idx] = 0;
-        		        	}
-        		        	// Select palette based on debug_hue (0-255)
-        		        	if (debug_hue < 51) {
-        		        	    minefield.palette[0] = 232;  // Neon Pink, Electric Blue, Acid Yellow
-        		        	    minefield.palette[1] = 168;
-        		        	    minefield.palette[2] = 46;
-        		        	} else if (debug_hue < 102) {
-        		        	    minefield.palette[0] = 240;  // Hot Pink, Deep Blue, Aqua, Vivid Red
-        		        	    minefield.palette[1] = 176;
-        		        	    minefield.palette[2] = 136;
-        		        	    minefield.palette[3] = 4;
-        		        	} else if (debug_hue < 153) {
-        		        	    minefield.palette[0] = 248;  // Magenta, Cool Blue, Neon Yellow, Bright Red
-        		        	    minefield.palette[1] = 170;
-        		        	    minefield.palette[2] = 46;
-        		        	    minefield.palette[3] = 8;
-        		        	} else if (debug_hue < 204) {
-        		        	    minefield.palette[0] = 208;  // Purple, Aqua, Lime
-        		        	    minefield.palette[1] = 136;
-        		        	    minefield.palette[2] = 48;
-        		        	} else {
-        		        	    minefield.palette[0] = 240;  // Hot Pink, Electric Blue, Bright Red
-        		        	    minefield.palette[1] = 168;
-        		        	    minefield.palette[2] = 8;
-        		        	}
-        	}
-
-
-
-            uint16_t idx = random_pixel_index();
-            xpl->center    = led_pos[idx];
+            uint16_t idx = rng_pixel(&minefield_rng);
+            xpl->center    = led_xyz(mapping_get_led_pos(), idx);
             xpl->radius    = 0.0f;
             xpl->speed     = rand_range(minefield.shell_speed, minefield.shell_speed_rng);
             xpl->thickness = rand_range(minefield.shell_thickness, minefield.shell_thickness_rng);
             if (xpl->thickness < 0.0f) xpl->thickness = 0.0f;
 
-            do {xpl->hue = minefield.palette[rand() % PALETTE_SIZE];
-            } while (xpl->hue == 0);
+            // one of the palette's stops, so hue lists stay distinct colours
+            const PaletteDef *pal = palette_get(palette_active());
+            xpl->color = pal->stop[rng_below(&minefield_rng, pal->count)].pos;
 
             xpl->active    = true;
-            xpl->min_r2    = 0.0f;
-            xpl->max_r2    = xpl->thickness * xpl->thickness;
             break;
         }
     }
 }
 
+// best[] (framebuffer order) → colour, added on top of the faded frame
+static void minefield_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const uint16_t *bst = uniforms;
+    uint16_t        p   = b->px;
+    for (uint16_t k = 0; k < b->n; ++k, p += b->step) {
+        uint8_t intensity = bst[p] >> 8;
+        if (intensity) {
+            out[k] = palette_shade((uint8_t)bst[p], 255 - intensity / 2, intensity);
+        } else {
+            out[k] = (rgb_8b){ 0, 0, 0 };
+        }
+    }
+}
+
 void anim_minefield_tick(void) {
-    if (!build_led_pos_cache()) return;
+    if (!explosions || !mapping_get_led_pos()) return;   // only through the registry
 
-    // timing
-    uint32_t now = ms();
-    static uint32_t last_burst_ms = 0, last_frame_ms = 0;
-    float dt_s = time_delta(&last_frame_ms);
+    // timing: the shells move at ANIM_SIM_HZ and are drawn between two steps
+    static AnimRate fade_rate;
+    const float     step_s = 1.0f / ANIM_SIM_HZ;
 
-    // fade and timing
-    fade_frame(minefield.fade_amount, 2);
+    // fade and timing: 2 fade steps per 1/60 s whatever the frame rate
+    uint32_t fades = anim_rate_take(&fade_rate, 2 * ANIM_REF_HZ);
+    if (fades) fade_frame(minefield.fade_amount, (uint8_t)(fades > 8 ? 8 : fades));
     anim_time_start();
 
-    // spawn based on explosion rate
-    uint32_t interval = (uint32_t)(1000.0f / minefield.expl_per_sec);
-    if (now - last_burst_ms >= interval) {
-        last_burst_ms = now;
-        spawn_explosion();
+    /* quality (led_governor): 1 = half the explosions at once, 2 = shell
+     * distance without sqrtf, 3 = every other LED per frame, the others
+     * keep last frame's value */
+    const uint8_t q = gov_level();
+    static uint8_t parity = 0;
+    parity ^= 1;
+
+    // simulation steps: spawn at the explosion rate, advance, retire by lifetime
+    for (uint32_t steps = anim_sim_take(&minefield_sim, ANIM_SIM_HZ); steps--; ) {
+        minefield_due += minefield.expl_per_sec * step_s;
+        if (minefield_due >= 1.0f) {
+            minefield_due -= 1.0f;
+            if (minefield_due > 1.0f) minefield_due = 0.0f;     // no backlog burst
+            spawn_explosion(q >= 1 ? MAX_CONCURRENT_EXPLOSIONS / 2 : MAX_CONCURRENT_EXPLOSIONS);
+        }
+        for (int i = 0; i < MAX_CONCURRENT_EXPLOSIONS; ++i) {
+            Explosion *xpl = &explosions[i];
+            if (!xpl->active) continue;
+            xpl->radius += xpl->speed * step_s;
+            if (xpl->radius > POLY_RADIUS + xpl->thickness) xpl->active = false;
+        }
     }
 
-    // advance, retire by lifetime, compute bounds & collect actives
+    // collect actives, drawn where they are between this step and the next
+    const float ahead = anim_sim_alpha(&minefield_sim) * step_s;
     int active_indices[MAX_CONCURRENT_EXPLOSIONS], active_count = 0;
+    float radius[MAX_CONCURRENT_EXPLOSIONS];
     for (int i = 0; i < MAX_CONCURRENT_EXPLOSIONS; ++i) {
-        Explosion *xpl = &explosions[i];
-        if (!xpl->active) continue;
-        xpl->radius += xpl->speed * dt_s;
-        if (xpl->radius > POLY_RADIUS + xpl->thickness) {
-            xpl->active = false;
-            continue;
-        }
-        float r0 = xpl->radius > xpl->thickness ? xpl->radius - xpl->thickness : 0.0f;
-        xpl->min_r2 = r0 * r0;
-        float r1 = xpl->radius + xpl->thickness;
-        xpl->max_r2 = r1 * r1;
+        if (!explosions[i].active) continue;
+        radius[i] = explosions[i].radius + explosions[i].speed * ahead;
         active_indices[active_count++] = i;
     }
 
-    // draw shells using per-instance thickness
+    // draw shells using per-instance thickness: only the LEDs inside each
+    // shell are visited (led_spatial), best (intensity << 8 | hue) per pixel
     uint16_t total_pixels = mapping_get_total_pixels();
-    for (uint16_t p = 0; p < total_pixels; ++p) {
-        float best_w = 0.0f;
-        uint8_t best_h = 0;
-        Vec3 pos = led_pos[p];
-        for (int ai = 0; ai < active_count; ++ai) {
-            Explosion *xpl = &explosions[active_indices[ai]];
-            Vec3 d = { pos.x - xpl->center.x,
-                       pos.y - xpl->center.y,
-                       pos.z - xpl->center.z };
-            float dist2 = d.x*d.x + d.y*d.y + d.z*d.z;
-            if (dist2 < xpl->min_r2 || dist2 > xpl->max_r2) continue;
-            float dist = sqrtf(dist2);
-            float delta = fabsf(dist - xpl->radius);
+    if (q >= 3) {
+        for (uint16_t p = parity; p < total_pixels; p += 2) best[p] = 0;
+    } else {
+        memset(best, 0, total_pixels * sizeof *best);
+    }
+
+    falloff_update();
+    for (int ai = 0; ai < active_count; ++ai) {
+        Explosion *xpl = &explosions[active_indices[ai]];
+        const float r  = radius[active_indices[ai]];
+        if (xpl->thickness <= 0.0f) continue;
+        const float c[3] = { xpl->center.x, xpl->center.y, xpl->center.z };
+        LedShellIter it;
+        spatial_shell_begin(&it, c, r - xpl->thickness, r + xpl->thickness);
+
+        // distance fade is the same for the whole shell
+        float    radial   = 1.0f - fminf(r / (POLY_RADIUS + xpl->thickness), 1.0f);
+        uint16_t rad      = falloff_at(falloff_radial, radial) + 1u;
+        float    inv_th   = 1.0f / xpl->thickness;
+        // |d - r| ≈ |d² - r²| / 2r, off by (d - r)² / 2r: fine once the shell is wider than thick
+        bool     coarse   = q >= 2 && r > 2.0f * xpl->thickness;
+        float    r2       = r * r;
+        float    inv_2r   = coarse ? 0.5f / r : 0.0f;
+
+        uint16_t p;
+        float    dist2;
+        while (spatial_shell_next(&it, &p, &dist2)) {
+            if (q >= 3 && (p & 1) != parity) continue;
+            float delta = coarse ? fabsf(dist2 - r2) * inv_2r : fabsf(fm_sqrtf(dist2) - r);
             if (delta > xpl->thickness) continue;
-            float base = 1.0f - (delta / xpl->thickness);
-            float radial = 1.0f - fminf(xpl->radius / (POLY_RADIUS + xpl->thickness), 1.0f);
-            float w    = fast_powf(base, minefield.falloff_exp) * fast_powf(radial, minefield.radial_falloff_exp);
-            if (w > best_w) {
-                best_w = w;
-                best_h = xpl->hue;
-            }
-        }
-        if (best_w > 0.0f) {
-            uint8_t intensity = (uint8_t)(best_w * 255);
-            uint8_t r, g, b;
-            hsv_to_rgb_rainbow(best_h,
-                               255 - intensity / 2,
-                               intensity,
-                               &r, &g, &b);
-            add_pixel_color(p, r, g, b);
+            uint8_t  w      = (uint8_t)((falloff_at(falloff_shell, 1.0f - delta * inv_th) * rad) >> 8);
+            uint16_t packed = (uint16_t)(w << 8 | xpl->color);
+            if (packed > best[p]) best[p] = packed;
         }
     }
 
+    static const Shader composite = { minefield_kernel, 0, SHADER_ADD };
+    shader_run(&composite, best);
+
     anim_time_end();
     update_leds();
 }
+
+
+/* ====================================================================================================================================================
+ * ------[ RIPPLE  (waves along the struts, led_wave)
+ * ==================================================================================================================================================== */
+#define RIPPLE_HZ               100     // simulation steps per second, whatever the frame rate
+
+static volatile uint8_t RIPPLE_DROPS = 3;     // per second
+static volatile uint8_t RIPPLE_SPEED = 160;   // c² of 256 (LEDs per step)²
+static volatile uint8_t RIPPLE_LOSS  = 200;   // per step, of 65536 (~3 s to fade)
+static WaveSim          ripple;               // buffers in the animation arena
+static uint32_t         ripple_layout;
+static AnimRate         ripple_step_rate, ripple_drop_rate, ripple_hue_rate;
+static uint8_t          ripple_hue;
+static Rng              ripple_rng;
+
+static size_t ripple_scratch(void) { return wave_bytes(); }
+
+static bool ripple_init(PolyArena *a) {
+    rng_stream(&ripple_rng, "ripple");
+    ripple_layout = mapping_layout_generation();
+    return wave_init(&ripple, a);
+}
+
+static void ripple_teardown(void) { ripple.u = ripple.prev = NULL; }
+
+static void anim_ripple_tick(void)
+{
+    if (!ripple.u) return;                    // only through the registry
+    if (ripple_layout != mapping_layout_generation() || ripple.n != mapping_get_total_pixels()) {
+        if (ripple.n != mapping_get_total_pixels()) return;
+        wave_clear(&ripple);                  // LEDs moved along the edges
+        ripple_layout = mapping_layout_generation();
+    }
+    anim_time_start();
+    ripple.c2   = RIPPLE_SPEED ? RIPPLE_SPEED : 1;
+    ripple.damp = (uint16_t)(65535u - RIPPLE_LOSS);
+
+    for (uint32_t d = anim_rate_take(&ripple_drop_rate, RIPPLE_DROPS); d--; ) {
+        int16_t amp = (int16_t)(rng_u32(&ripple_rng) & 1 ? WAVE_ONE : -WAVE_ONE);
+        if (rng_u32(&ripple_rng) & 1) wave_poke_vertex(&ripple, (poly_idx_t)rng_below(&ripple_rng, poly.V), amp);
+        else                          wave_poke(&ripple, rng_pixel(&ripple_rng), (int16_t)(2 * amp));
+    }
+    uint32_t steps = anim_sim_take(&ripple_step_rate, RIPPLE_HZ);
+    while (steps--) wave_step(&ripple);
+
+    ripple_hue += (uint8_t)anim_rate_take(&ripple_hue_rate, 8);
+    wave_render(&ripple, ripple_hue);
+    anim_time_end();
+    update_leds();
+}
+
+
+/* ====================================================================================================================================================
+ * ------[ SCRIPT  (uploaded per-LED program, led_vm)
+ * ==================================================================================================================================================== */
+static void anim_script_tick(void)
+{
+    anim_time_start();
+    uint8_t q = gov_level();
+    vm_run(q >= 2 ? SHADER_IL_4 | SHADER_IL_BLEND : q ? SHADER_IL_2 | SHADER_IL_BLEND : 0);
+    anim_time_end();
+    update_leds();
+}
+
+
+/* ====================================================================================================================================================
+ * ------[ PARAMETERS  (led_params: "param" / "preset" on the console, binary frames)
+ * ==================================================================================================================================================== */
+#define PARAM_PALETTE_BLEND_MS 800
+
+static uint8_t param_palette = 0;      // last one set through the parameter
+
+static void param_palette_changed(void) {
+    if (!palette_select(param_palette, PARAM_PALETTE_BLEND_MS)) param_palette = palette_active();
+}
+
+/* ids are what presets and the host tool keep: never reuse or renumber one */
+static const ParamDef anim_params[] = {
+    {  1, "plasma.k1",       PARAM_FLOAT, &K1,                             0.1f,   16.0f, NULL },
+    {  2, "plasma.k2",       PARAM_FLOAT, &K2,                             0.1f,   16.0f, NULL },
+    {  3, "plasma.k3",       PARAM_FLOAT, &K3,                             0.1f,   16.0f, NULL },
+    {  4, "plasma.speed",    PARAM_FLOAT, &speed,                          0.0f,    0.5f, NULL },
+    { 10, "stars.count",     PARAM_U8,    (void *)&NUM_STARS,              0,  STARS_MAX, NULL },
+    { 11, "stars.tail",      PARAM_U8,    (void *)&TAIL_LEN,               1, PARTICLE_TAIL_MAX, NULL },
+    { 12, "stars.speed",     PARAM_U8,    (void *)&STAR_SPEED,             1,       8,    NULL },
+    { 20, "twinkle.rate",    PARAM_U8,    (void *)&TWINKLE_RATE,           0,      16,    NULL },
+    { 21, "twinkle.step",    PARAM_U8,    (void *)&TWINKLE_STEP,           1,      64,    NULL },
+    { 30, "kaleido.rings",   PARAM_U8,    (void *)&KALEIDO_RINGS,          1,       8,    NULL },
+    { 31, "kaleido.speed",   PARAM_U8,    (void *)&KALEIDO_SPEED,          0,      16,    NULL },
+    { 40, "lava.scale",      PARAM_U8,    (void *)&LAVA_SCALE,             1,      16,    NULL },
+    { 41, "lava.speed",      PARAM_U8,    (void *)&LAVA_SPEED,             0,      64,    NULL },
+    { 42, "aurora.scale",    PARAM_U8,    (void *)&AURORA_SCALE,           1,      16,    NULL },
+    { 43, "aurora.speed",    PARAM_U8,    (void *)&AURORA_SPEED,           0,      64,    NULL },
+    { 50, "mine.rate",       PARAM_FLOAT, &minefield.expl_per_sec,         0.05f,  10.0f, NULL },
+    { 51, "mine.speed",      PARAM_FLOAT, &minefield.shell_speed,          0.01f,   4.0f, NULL },
+    { 52, "mine.speed_rng",  PARAM_FLOAT, &minefield.shell_speed_rng,      0.0f,    2.0f, NULL },
+    { 53, "mine.thick",      PARAM_FLOAT, &minefield.shell_thickness,      0.01f,   1.0f, NULL },
+    { 54, "mine.thick_rng",  PARAM_FLOAT, &minefield.shell_thickness_rng,  0.0f,    0.5f, NULL },
+    { 55, "mine.fade",       PARAM_U8,    &minefield.fade_amount,          0,     255,    NULL },
+    { 56, "mine.falloff",    PARAM_FLOAT, &minefield.falloff_exp,          0.5f,    8.0f, NULL },   // curves rebuild
+    { 57, "mine.radial",     PARAM_FLOAT, &minefield.radial_falloff_exp,   0.5f,    8.0f, NULL },   // on their own
+    { 60, "palette",         PARAM_U8,    &param_palette,                  0,     254,    param_palette_changed },
+    { 70, "script.u0",       PARAM_U8,    &vm_user[0],                     0,     255,    NULL },
+    { 71, "script.u1",       PARAM_U8,    &vm_user[1],                     0,     255,    NULL },
+    { 72, "script.u2",       PARAM_U8,    &vm_user[2],                     0,     255,    NULL },
+    { 73, "script.u3",       PARAM_U8,    &vm_user[3],                     0,     255,    NULL },
+    { 80, "facespin.tail",   PARAM_U8,    (void *)&FACESPIN_TAIL,          1,     255,    NULL },
+    { 81, "facespin.speed",  PARAM_U8,    (void *)&FACESPIN_SPEED,         0,      32,    NULL },
+    { 82, "scan.axis",       PARAM_U8,    (void *)&SCAN_AXIS,              0, SPATIAL_AXIS_COUNT - 1, NULL },
+    { 83, "scan.width",      PARAM_FLOAT, &SCAN_WIDTH,                     0.01f,  1.0f,  NULL },
+    { 84, "scan.speed",      PARAM_FLOAT, &SCAN_SPEED,                     0.0f,   4.0f,  NULL },
+    { 85, "snake.path",      PARAM_U8,    (void *)&SNAKE_PATH,             0,   PATH_COUNT - 1, NULL },
+    { 86, "snake.speed",     PARAM_U8,    (void *)&SNAKE_SPEED,            1,      16,    NULL },
+    { 87, "snake.fade",      PARAM_U8,    (void *)&SNAKE_FADE,             1,     255,    NULL },
+    { 88, "ripple.drops",    PARAM_U8,    (void *)&RIPPLE_DROPS,           0,      32,    NULL },
+    { 89, "ripple.speed",    PARAM_U8,    (void *)&RIPPLE_SPEED,           1,     255,    NULL },
+    { 90, "ripple.loss",     PARAM_U8,    (void *)&RIPPLE_LOSS,            0,     255,    NULL },
+};
+
+uint8_t anim_param_count(void) { return (uint8_t)(sizeof anim_params / sizeof *anim_params); }
+
+const ParamDef *anim_param_get(uint8_t i) { return i < anim_param_count() ? &anim_params[i] : NULL; }
+
+
+
+#ifdef AUDIO_FRAMES
+/* ====================================================================================================================================================
+ * ------[ AUDIO
+ * ==================================================================================================================================================== */
+
+/* every edge a level meter of one band (edge % AUDIO_BANDS), lit from its
+ * start by the band's level in the band's palette colour; a beat flashes
+ * the dark rest, fading in AUDIO_FLASH ticks. With a tempo the colours
+ * turn a band per beat, smoothly along the beat phase. */
+#define AUDIO_FLASH 12
+static float audio_flash;
+
+static void anim_audio_tick(void)
+{
+    const AudioFrame  *a    = audio_frame();
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    const poly_idx_t   E    = mapping_get_edge_count();
+
+    if (a->onset) audio_flash = 1.0f;
+    const uint8_t rest = (uint8_t)(audio_flash * 96.0f);
+    const uint8_t turn = a->bpm > 0.0f ? (uint8_t)(uint32_t)((a->onsets % AUDIO_BANDS + a->beat_phase) * 256.0f / AUDIO_BANDS) : 0;
+
+    anim_time_start();
+    for (poly_idx_t e = 0; e < E; ++e) {
+        const EdgeLedInfo inf = info[e];
+        const uint8_t     b   = (uint8_t)(e % AUDIO_BANDS);
+        const uint16_t    lit = (uint16_t)(a->band[b] * inf.count + 0.5f);
+        const rgb_8b      c   = palette_shade((uint8_t)(b * 256u / AUDIO_BANDS + turn), 255, 255);
+        fill_pixels(inf.start, lit, inf.step, c);
+        fill_pixels((uint16_t)(inf.start + lit * inf.step), inf.count - lit, inf.step,
+                    (rgb_8b){ rest, rest, rest });
+    }
+    anim_time_end();
+    update_leds();
+
+    audio_flash -= anim_clock_ref() / AUDIO_FLASH;
+    if (audio_flash < 0.0f) audio_flash = 0.0f;
+}
+#endif
+
+
+
+/* ====================================================================================================================================================
+ * ------[ ANIMATION REGISTRY
+ * ==================================================================================================================================================== */
+
+static void tick_vertex_palette_xyz(void) { show_vertex_palette_xyz(255, 255, debug_hue); }
+static void tick_vertex_gradient(void)    { show_vertex_gradient(0, 255, 255, debug_hue); }
+
+poly_idx_t debug_highlight_vertex = POLY_IDX_NONE;
+
+// overlay: the edges meeting at debug_highlight_vertex, fading out from it
+static void tick_highlight(void)
+{
+    set_all_pixels_color(0, 0, 0);
+    uint8_t        n;
+    const EdgeRef *refs = mapping_vertex_edges(debug_highlight_vertex, &n);   /* n = 0 if none */
+    for (uint8_t i = 0; i < n; ++i) {
+        EdgeLedInfo sp = mapping_ref_span(&refs[i]);
+        blend_pixels(sp.start, sp.count, sp.step, (rgb_8b){ 255, 255, 255 }, (rgb_8b){ 0, 0, 0 });
+    }
+    update_leds();
+}
+
+/* order = debug modes (led_debug.h, DEBUG_MODE .. ANIM_5), overlays after */
+static const Animation anim_registry[] = {
+    { "minefield", minefield_scratch, minefield_init, anim_minefield_tick,     minefield_teardown, "minefield", minefield_warm },
+    { "palette",   NULL,              NULL,           tick_vertex_palette_xyz, NULL,               NULL,        NULL          },
+    { "gradient",  NULL,              NULL,           tick_vertex_gradient,    NULL,               NULL,        NULL          },
+    { "stars",     stars_scratch,     stars_init,     anim_shooting_stars_tick, stars_teardown,    NULL,        stars_warm    },
+    { "rainbow",   NULL,              NULL,           anim_rainbow_tick,       NULL,               "rainbow",   NULL          },
+    { "plasma",    plasma_scratch,    plasma_init,    anim_plasma_swirl_tick,  plasma_teardown,    "rainbow",   NULL          },
+    { "highlight", NULL,              NULL,           tick_highlight,          NULL,               NULL,        NULL          },
+    { "twinkle",   twinkle_scratch,   twinkle_init,   anim_twinkle_tick,       twinkle_teardown,   "rainbow",   NULL          },
+    { "kaleido",   NULL,              NULL,           anim_kaleido_tick,       kaleido_teardown,   "neon",      kaleido_warm  },
+    { "lava",      NULL,              NULL,           anim_lava_tick,          NULL,               "lava",      NULL          },
+    { "aurora",    NULL,              NULL,           anim_aurora_tick,        NULL,               "aurora",    NULL          },
+    { "script",    vm_bytes,          vm_init,        anim_script_tick,        vm_release,         NULL,        NULL          },
+    { "facespin",  NULL,              NULL,           anim_facespin_tick,      NULL,               "rainbow",   NULL          },
+    { "scanline",  NULL,              NULL,           anim_scanline_tick,      NULL,               "rainbow",   scanline_warm },
+    { "snake",     NULL,              NULL,           anim_snake_tick,         NULL,               "rainbow",   NULL          },
+    { "ripple",    ripple_scratch,    ripple_init,    anim_ripple_tick,        ripple_teardown,    "ocean",     NULL          },
+    { "hud",       NULL,              anim_hud_init,  anim_hud_tick,           NULL,               NULL,        NULL          },
+#ifdef AUDIO_FRAMES
+    { "audio",     NULL,              NULL,           anim_audio_tick,         NULL,               "rainbow",   NULL          },
+#endif
+};
+#define ANIM_COUNT ((uint8_t)(sizeof anim_registry / sizeof *anim_registry))
+
+/* the animations keep their state in statics, so one slot per animation:
+ * starting it somewhere else takes it away from the slot that had it */
+static AnimSlot *anim_owner[ANIM_COUNT];
+
+static uint8_t   anim_want = 0;     // selected, set up on the next tick
+static AnimSlot  base_slot;         // the selected one, layer 0
+
+uint8_t anim_count(void) { return ANIM_COUNT; }
+
+const Animation *anim_get(uint8_t i) { return i < ANIM_COUNT ? &anim_registry[i] : NULL; }
+
+int anim_find(const char *name)
+{
+    if (!name) return -1;
+    for (uint8_t i = 0; i < ANIM_COUNT; ++i)
+        if (strcmp(anim_registry[i].name, name) == 0) return i;
+    return -1;
+}
+
+void anim_slot_stop(AnimSlot *s)
+{
+    if (s->anim) {
+        if (s->anim->teardown) s->anim->teardown();
+        anim_owner[s->anim - anim_registry] = NULL;
+    }
+    s->anim = NULL;
+    free(s->mem);
+    s->mem = NULL;
+}
+
+bool anim_slot_start(AnimSlot *s, const Animation *a)
+{
+    anim_slot_stop(s);
+    AnimSlot **owner = &anim_owner[a - anim_registry];
+    if (*owner) anim_slot_stop(*owner);
+
+    size_t need = a->scratch ? a->scratch() : 0;
+    if (need) {
+        s->mem = malloc(need);
+        if (!s->mem) return false;
+    }
+    poly_arena_init(&s->arena, s->mem, need);
+    if (a->init && !a->init(&s->arena)) {
+        if (a->teardown) a->teardown();
+        free(s->mem);
+        s->mem = NULL;
+        return false;
+    }
+    s->anim = a;
+    *owner  = s;
+    return true;
+}
+
+void anim_release(void)
+{
+    transition_cancel();
+    layers_release();
+    anim_slot_stop(&base_slot);
+}
+
+void anim_select(uint8_t i)
+{
+    anim_want = i;
+    if (i >= ANIM_COUNT) anim_release();      // nothing runs, give the RAM back
+}
+
+uint8_t anim_selected(void)
+{
+    return anim_want;
+}
+
+void anim_tick(void)
+{
+    const Animation *a = anim_get(anim_want);
+    if (!a) return;
+    if (base_slot.anim != a) {
+        // the old picture is still in the framebuffer: fade from it, as RGB
+        render_index_end();
+        if (base_slot.anim && !layers_active()) transition_begin();
+        if (!anim_slot_start(&base_slot, a)) return;
+        int pal = palette_find(a->palette);
+        if (pal >= 0) palette_select((uint8_t)pal, 0);
+    }
+    anim_clock_tick();                        // one dt for everything drawn this frame
+    palette_tick();
+    gov_update();                             // quality for this frame from the last one's time
+    if (layers_active()) {
+        transition_cancel();
+        layers_frame(a);                      // own buffer, overlays, one composite pass
+    } else if (transition_active()) {
+        transition_frame(a->tick);            // incoming + snapshot, one mix pass
+    } else {
+        a->tick();                            // straight into the framebuffer
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Warm-up: the next and the previous animation in the registry, one warm()
+ * step per BULK slice, over again when the selection or the mapping moves.
+ * One that stops being a neighbour without having run gets its teardown,
+ * so what it built on the heap (kaleido's orbits) goes back.
+ */
+#define WARM_AHEAD 2                // candidates: the next one, the previous one
+
+static uint8_t  warm_sel = 0xFF;    // selection the candidates are for
+static uint32_t warm_gen;           // and mapping generation
+static uint8_t  warm_k;             // candidate in turn, WARM_AHEAD = all done
+static uint32_t warm_step;          // its next warm() step
+static uint8_t  warmed[WARM_AHEAD] = { 0xFF, 0xFF };
+
+static uint8_t warm_candidate(uint8_t k)
+{
+    return (uint8_t)((anim_want + (k ? ANIM_COUNT - 1u : 1u)) % ANIM_COUNT);
+}
+
+static void warm_cool(void)
+{
+    for (uint8_t k = 0; k < WARM_AHEAD; ++k) {
+        const uint8_t i = warmed[k];
+        warmed[k] = 0xFF;
+        if (i >= ANIM_COUNT || i == anim_want || anim_owner[i]) continue;
+        if (i == warm_candidate(0) || i == warm_candidate(1)) continue;
+        if (anim_registry[i].teardown) anim_registry[i].teardown();
+    }
+}
+
+void anim_warm_tick(void)
+{
+    if (anim_want >= ANIM_COUNT) return;
+    if (warm_sel != anim_want || warm_gen != mapping_generation()) {
+        warm_cool();
+        warm_sel  = anim_want;
+        warm_gen  = mapping_generation();
+        warm_k    = 0;
+        warm_step = 0;
+    }
+    for (; warm_k < WARM_AHEAD; ++warm_k, warm_step = 0) {
+        const uint8_t    i = warm_candidate(warm_k);
+        const Animation *a = &anim_registry[i];
+        if (!a->warm || i == anim_want) continue;
+        warmed[warm_k] = i;
+        if (!a->warm(warm_step++)) { ++warm_k; warm_step = 0; }
+        return;                     // one step per slice
+    }
+}
@@ -2,10 +2,15 @@
 #define LED_ANIM_H
 
 #include <stdint.h>       // for uint8_t, uint16_t
+#include <stdbool.h>
+#include <stddef.h>       // size_t
 #include "led_render.h"   // for set_pixel_color(), update_leds(), etc.
+#include "polyhedron.h"   // poly_idx_t, PolyArena
+#include "led_params.h"   // ParamDef
 
-// Live-editable index; set to 0xFF (i.e. UINT8_MAX) to disable per-vertex highlight.
-extern uint8_t debug_highlight_vertex;
+// Live-editable index; set to POLY_IDX_NONE to disable per-vertex highlight
+// (drawn by the "highlight" animation, run it as an overlay layer).
+extern poly_idx_t debug_highlight_vertex;
 
 /**
  * @brief Convert an XYZ coordinate to a hue (0–255) based on polar angle in XY.
@@ -36,7 +41,7 @@ void vertex_hv_from_xyz(const float v[3],
 
 void show_vertex_palette_xyz(uint8_t sat, uint8_t val, uint8_t hue_offset);
 
-void show_vertex_gradient(uint8_t vertex, uint8_t sat, uint8_t val, uint8_t hue_offset);
+void show_vertex_gradient(poly_idx_t vertex, uint8_t sat, uint8_t val, uint8_t hue_offset);
 
 /**
  * @brief Draw a per-vertex hue gradient (full palette), or only edges connected
@@ -50,7 +55,7 @@ void show_vertex_palette(uint8_t sat, uint8_t val, uint8_t hue_offset);
  * @brief Show a single face colored with a unique face-indexed RGB.
  * @param face_idx Index into polyhedron faces
  */
-void show_face(uint8_t face_idx);
+void show_face(poly_idx_t face_idx);
 
 /**
  * @brief Animate continuous rainbow gradient across all LEDs.
@@ -67,4 +72,98 @@ void anim_breath_tick(void);
  */
 void anim_twinkle_tick(void);
 
+/* ─────────────────────────────────────────────────────────────────────────
+ * Animation registry
+ *
+ * Every effect declares what scratch memory it needs, the active one gets it
+ * carved from a single heap block (PolyArena), switching effects tears the
+ * old one down and frees the block. Only the effect that runs holds RAM.
+ * What an effect builds outside it (scene pool orders, symmetry orbits) its
+ * warm() can build ahead, while a neighbour runs (anim_warm_tick()).
+ */
+typedef struct {
+    const char *name;
+    size_t    (*scratch)(void);          /* arena bytes init() takes, NULL = none   */
+    bool      (*init)(PolyArena *a);     /* carve + reset state, NULL = nothing     */
+    void      (*tick)(void);             /* one frame                               */
+    void      (*teardown)(void);         /* drop pointers into the arena, NULL = -  */
+    const char *palette;                 /* led_palette name picked on start, NULL = keep */
+    bool      (*warm)(uint32_t step);    /* shared tables ahead of a start, one step per
+                                            call, true while more; NULL = none       */
+} Animation;
+
+/* Where an animation runs: the selected one (layer 0) or a compositor layer
+ * (led_layers). Holds its scratch block while it is set up. */
+typedef struct {
+    const Animation *anim;               /* set up here, NULL = empty               */
+    void            *mem;
+    PolyArena        arena;
+} AnimSlot;
+
+/**
+ * @brief Number of registered animations.
+ */
+uint8_t anim_count(void);
+
+/**
+ * @brief Registry entry i, NULL if out of range.
+ */
+const Animation *anim_get(uint8_t i);
+
+/**
+ * @brief Registry index of the animation called name, -1 if there is none.
+ */
+int anim_find(const char *name);
+
+/**
+ * @brief Set a up in slot s (whatever s held is torn down first, a slot that
+ *        had a loses it). false if its scratch does not fit.
+ */
+bool anim_slot_start(AnimSlot *s, const Animation *a);
+
+/**
+ * @brief Tear down what s holds and free its scratch block.
+ */
+void anim_slot_stop(AnimSlot *s);
+
+/**
+ * @brief Make animation i the active one, its resources are allocated on the
+ *        next anim_tick(). Out of range (e.g. 0xFF) stops and releases.
+ */
+void anim_select(uint8_t i);
+
+/**
+ * @brief Index of the selected animation (0xFF or out of range: none).
+ */
+uint8_t anim_selected(void);
+
+/**
+ * @brief Run one frame of the active animation (allocating it first if needed,
+ *        tried again next tick if the heap is short).
+ */
+void anim_tick(void);
+
+/**
+ * @brief One step of warming up the animations a mode switch most likely
+ *        goes to: the selected one's neighbours in the registry, where `m`
+ *        steps. Their warm() builds the shared tables their first frame
+ *        would (spatial orders, symmetry orbits, ...), so the switch costs
+ *        a frame like any other. A BULK task (sched.h): runs in frame slack only.
+ */
+void anim_warm_tick(void);
+
+/**
+ * @brief Tear down the active animation and the layers' ones, free their
+ *        scratch and layer buffers (the next anim_tick() sets everything up
+ *        again). Called before the scene is rebuilt.
+ */
+void anim_release(void);
+
+/**
+ * @brief The animations' tunable parameters (led_params), entry i, NULL if
+ *        out of range.
+ */
+uint8_t anim_param_count(void);
+const ParamDef *anim_param_get(uint8_t i);
+
 #endif // LED_ANIM_H
@@ -7,8 +7,20 @@
 #include "led_mapping.h"
 #include "led_render.h"
 #include "usb_comms.h"
+#include "dlog.h"
 #include "led_debug.h"
+#include "proto.h"         /* ProtoControlOp */
 #include "led_anim.h"
+#include "led_stream.h"
+#include "led_link.h"
+#include "bench.h"
+#include "calib.h"
+#include "clip.h"
+#ifdef LED_MAP_STORE
+#include "flash_store.h"
+#include "scene_mem.h"
+#include "sched.h"
+#endif
 
 extern Polyhedron poly;
 
@@ -16,18 +28,22 @@ extern Polyhedron poly;
  * Runtime state
  * ========================================================================== */
 static DebugMode  dbg_mode        = DEBUG_MODE;
-static uint8_t    dbg_face        = 0;
+static poly_idx_t dbg_face        = 0;
 static uint8_t    dbg_edge_slot   = 0;
 static uint16_t   dbg_bar_index   = 0;
 
 uint8_t 	  debug_hue = 0;
 
 
+/* the edge editor's mode: edits only apply (and show) there */
+#define EDIT_MODE   ANIM_6
+
 static float      acc_bar   = 0.0f;
 static float      acc_face  = 0.0f;
 static float      acc_slot  = 0.0f;
 
-static uint8_t   *saved_map = NULL;
+static poly_idx_t *saved_map = NULL;
+static bool        saved     = false;
 
 static const uint32_t BLINK_MS = 300;
 
@@ -35,18 +51,44 @@ static const uint32_t BLINK_MS = 300;
  *
  * ========================================================================== */
 
-static void show_edge_reassignement(uint8_t face);
+static void show_edge_reassignement(poly_idx_t face);
 
 /* ==========================================================================
  *
  * ========================================================================== */
 
 
-static inline void clear_saved(void) {if (saved_map) { free(saved_map); saved_map = NULL; } }
+/* saved_map is taken from the scene pool once per scene, saved says it holds a map */
+static inline void clear_saved(void) { saved = false; }
 
-static inline void ensure_saved(void) { if (!saved_map) { saved_map = malloc(poly.E); memcpy(saved_map, mapping_edit_edge_map(), poly.E); } }
+static inline void ensure_saved(void)
+{
+    if (saved) return;
+    if (!saved_map) saved_map = scene_alloc("saved_map", poly.E * sizeof *saved_map);
+    if (!saved_map) return;
+    memcpy(saved_map, mapping_edit_edge_map(), poly.E * sizeof *saved_map);
+    saved = true;
+}
 
-static inline void restore_saved(void) { if (saved_map) {memcpy(mapping_edit_edge_map(), saved_map, poly.E); } }
+void debug_reset(void)
+{
+    clear_saved();
+    saved_map     = NULL;         /* the scene pool is emptied next */
+    dbg_face      = 0;
+    dbg_edge_slot = 0;
+    dbg_bar_index = 0;
+    acc_bar = acc_face = acc_slot = 0.0f;
+}
+
+/* only the edges that differ get patched */
+static inline void restore_saved(void)
+{
+    if (!saved) return;
+    const poly_idx_t *emap = mapping_edit_edge_map();
+    for (poly_idx_t e = 0; e < poly.E; ++e) {
+        if (emap[e] != saved_map[e]) mapping_assign(e, saved_map[e]);
+    }
+}
 
 
 //MODE_FACE_EDIT         = 0,
@@ -56,140 +98,125 @@ static inline void restore_saved(void) { if (saved_map) {memcpy(mapping_edit_edg
 
  void debug_ui_tick(void)
  {
-    if (dbg_mode == DEBUG_MODE)
-    {
-    	g_global_brightness = 255;
-    	anim_minefield_tick();
-    }
-    else if (dbg_mode == ANIM_1)
-    {
-    	g_global_brightness = 255;
-    	show_vertex_palette_xyz(255, 255, debug_hue);
-    }
-    else if (dbg_mode == ANIM_2)
-    {
-    	g_global_brightness = 255;
-    	show_vertex_gradient(0, 255, 255, debug_hue);
-    }
-    else if (dbg_mode == ANIM_3)
-    {
-    	g_global_brightness = 255;
-    	anim_shooting_stars_tick();
-    }
-    else if (dbg_mode == ANIM_4)
+    if (bench_tick()) return;        // a benchmark run owns the frames (bench.h)
+    if (link_tick()) return;         // a link node: the master draws (led_link.h)
+    if (stream_tick()) return;       // the host draws (led_stream.h)
+    if (calib_tick()) return;        // edge calibration patterns (calib.h)
+    if (clip_tick()) return;         // a clip out of flash (clip.h)
+    if (dbg_mode == ANIM_6)
     {
-    	g_global_brightness = 255;
-    	anim_rainbow_tick();
+    	g_global_brightness = 40;
+    	show_edge_reassignement(dbg_face);//
     }
-    else if (dbg_mode == ANIM_5)
+    else
     {
     	g_global_brightness = 255;
-    	anim_plasma_swirl_tick();
-    }
-    else if (dbg_mode == ANIM_6)
-    {
-    	g_global_brightness = 40;
-    	show_edge_reassignement(dbg_face);//
+    	anim_tick();                     // DEBUG_MODE .. ANIM_5 = anim_registry order
     }
  }
 
 
 /* ==========================================================================
- *
+ * Edits only change the maps and the selection; the next debug_ui_tick()
+ * draws them, input never renders a frame of its own.
  * ========================================================================== */
-void debug_change_bar(float delta)
+bool debug_set_bar(uint16_t bar)
 {
-	if (dbg_mode != DEBUG_MODE) {
-		return;
+	if (dbg_mode != EDIT_MODE || bar >= poly.E) {
+		return false;
 	}
-    acc_bar += delta;
-    int32_t steps = (int32_t)acc_bar;
-    if (!steps) return;
-    acc_bar -= steps;
-
-    dbg_bar_index = (dbg_bar_index + steps + poly.E) % poly.E;
+    dbg_bar_index = bar;
 
     ensure_saved();
     restore_saved();
 
-    const uint8_t *verts = poly_face_vertices(&poly, dbg_face);
-    uint8_t fv = poly_face_vertex_count(&poly, dbg_face);
-    uint8_t v0 = verts[dbg_edge_slot];
-    uint8_t v1 = verts[(dbg_edge_slot + 1) % fv];
-    uint8_t logical_edge = poly_find_edge(&poly, v0, v1);
+    uint8_t    fv;
+    poly_idx_t logical_edge = mapping_face_edges(dbg_face, &fv)[dbg_edge_slot].edge;
 
-    uint8_t *emap = mapping_edit_edge_map();
-    uint8_t tmp  = emap[logical_edge];
-    emap[logical_edge]      = emap[dbg_bar_index];
-    emap[dbg_bar_index]     = tmp;
+    mapping_swap_edges(logical_edge, dbg_bar_index);
+    return true;
+}
 
-    update_mappings();
-    show_edge_reassignement(dbg_face);
+void debug_change_bar(float delta)
+{
+    acc_bar += delta;
+    int32_t steps = (int32_t)acc_bar;
+    if (!steps) return;
+    acc_bar -= steps;
+    debug_set_bar((uint16_t)((dbg_bar_index + steps % (int32_t)poly.E + poly.E) % poly.E));
 }
 /* ────────────────────────────────────────────────────────────────────────
  * change the active face were debugging
  */
-void debug_change_face(float delta)
+bool debug_set_face(poly_idx_t face)
 {
-	if (dbg_mode != DEBUG_MODE) {
-		return;
+	if (dbg_mode != EDIT_MODE || face >= poly.F) {
+		return false;
 	}
-    acc_face += delta;
-    int32_t steps = (int32_t)acc_face;
-    if (!steps) return;
-    acc_face -= steps;
-
-    dbg_face = (dbg_face + steps + poly.F) % poly.F;
+    dbg_face = face;
     dbg_edge_slot = 0;
     clear_saved();
-    show_edge_reassignement(dbg_face);
-    static uint8_t last_face = 0xFF;
+    static poly_idx_t last_face = POLY_IDX_NONE;
     if (dbg_face != last_face) {
         USBD_UsrLog("#face# %u", dbg_face);
         last_face = dbg_face;
     }
+    return true;
+}
 
+void debug_change_face(float delta)
+{
+    acc_face += delta;
+    int32_t steps = (int32_t)acc_face;
+    if (!steps) return;
+    acc_face -= steps;
+    debug_set_face((poly_idx_t)((dbg_face + steps % (int32_t)poly.F + poly.F) % poly.F));
 }
 /* ────────────────────────────────────────────────────────────────────────
  *
  */
-void debug_change_slot(float delta)
+bool debug_set_slot(uint8_t slot)
 {
-	if (dbg_mode != DEBUG_MODE) {
-		return;
+    uint8_t fv = poly_face_vertex_count(&poly, dbg_face);
+	if (dbg_mode != EDIT_MODE || slot >= fv) {
+		return false;
 	}
+    dbg_edge_slot = slot;
+    clear_saved();
+    return true;
+}
+
+void debug_change_slot(float delta)
+{
     acc_slot += delta;
     int32_t steps = (int32_t)acc_slot;
     if (!steps) return;
     acc_slot -= steps;
 
-    uint8_t fv = poly_face_vertex_count(&poly, dbg_face);
-    dbg_edge_slot = (dbg_edge_slot + steps + fv) % fv;
-    clear_saved();
-    show_edge_reassignement(dbg_face);
+    int32_t fv = poly_face_vertex_count(&poly, dbg_face);
+    debug_set_slot((uint8_t)((dbg_edge_slot + steps % fv + fv) % fv));
 }
 /* ────────────────────────────────────────────────────────────────────────
  *
  */
-void debug_toggle_flip(void)
+void debug_set_flip(bool flip)
 {
-	if (dbg_mode != DEBUG_MODE) {
+	if (dbg_mode != EDIT_MODE) {
 		return;
 	}
     ensure_saved();
     restore_saved();
 
-    const uint8_t *verts = poly_face_vertices(&poly, dbg_face);
-    uint8_t fv = poly_face_vertex_count(&poly, dbg_face);
-    uint8_t v0 = verts[dbg_edge_slot];
-    uint8_t v1 = verts[(dbg_edge_slot + 1) % fv];
-    uint8_t e_id = poly_find_edge(&poly, v0, v1);
-
-    bool *fmap = mapping_edit_flip_map();
-    fmap[e_id] = !fmap[e_id];
+    uint8_t    fv;
+    poly_idx_t e_id = mapping_face_edges(dbg_face, &fv)[dbg_edge_slot].edge;
+    mapping_set_flip(e_id, flip);
+}
 
-    update_mappings();
-    show_edge_reassignement(dbg_face);
+void debug_toggle_flip(void)
+{
+    uint8_t    fv;
+    poly_idx_t e_id = mapping_face_edges(dbg_face, &fv)[dbg_edge_slot].edge;
+    debug_set_flip(!mapping_edit_flip_map()[e_id]);
 }
 
 
@@ -212,6 +239,12 @@ void debug_change_hue(float delta)
     debug_hue = (uint8_t)debug_hue_acc;
 }
 
+void debug_set_hue(uint8_t hue)
+{
+    debug_hue_acc = (float)(hue % 255u);
+    debug_hue     = (uint8_t)debug_hue_acc;
+}
+
 
 
 
@@ -222,15 +255,14 @@ void debug_change_hue(float delta)
 static uint32_t last_blink_time = 0;
 static bool blink_on = false;
 
-static void show_edge_reassignement(uint8_t face)
+static void show_edge_reassignement(poly_idx_t face)
 {
     set_all_pixels_color(0, 0, 0);
 
     // 1) prep
-    const uint8_t         *verts  = poly_face_vertices(&poly, face);
-    const uint8_t          fv     = poly_face_vertex_count(&poly, face);
-    const PixelMapping    *pm     = mapping_get_map();            // length = total pixels
-    const uint8_t         *lpe    = mapping_get_leds_per_edge(); // length = edge_cnt
+    const poly_idx_t      *verts  = poly_face_vertices(&poly, face);
+    uint8_t                fv;
+    const EdgeRef         *refs   = mapping_face_edges(face, &fv); // winding order
     uint32_t               now    = ms();
 
     // blink toggle
@@ -241,20 +273,13 @@ static void show_edge_reassignement(uint8_t face)
 
     // 2) for each edge‐slot in this face
     for (uint8_t slot = 0; slot < fv; ++slot) {
-        uint8_t v0   = verts[slot];
-        uint8_t v1   = verts[(slot + 1) % fv];
-        uint8_t edge = poly_find_edge(&poly, v0, v1);
-
-        // 3) compute start and length of pixel_map block for this edge
-        uint16_t start_idx = 0;
-        for (uint8_t k = 0; k < edge; ++k) {
-            start_idx += lpe[k];
-        }
-        uint16_t len  = lpe[edge];
-        uint16_t half = len / 2;
+        poly_idx_t v0 = verts[slot];
+        poly_idx_t v1 = verts[(slot + 1) % fv];
 
-        // 4) true face winding test
-        bool ccw = poly_face_edge_is_ccw(&poly, face, edge);
+        // 3+4) LED span of this edge, already walking v0 → v1 (face winding)
+        EdgeLedInfo span = mapping_ref_span(&refs[slot]);
+        uint16_t len  = span.count;
+        uint16_t half = len / 2;
 
         // 5) endpoint hues + blink sat
         uint8_t h0, h1;
@@ -263,12 +288,8 @@ static void show_edge_reassignement(uint8_t face)
         uint8_t sat = ((slot == dbg_edge_slot) && !blink_on) ? 128 : 255;
 
         // 6) draw first half in h0, second half in h1
-        //    if ccw==false, reverse the block
         for (uint16_t i = 0; i < len; ++i) {
-            uint16_t idx = ccw ? (start_idx + i)
-                               : (start_idx + (len - 1 - i));
-
-            uint16_t phys = pm[idx].phys;
+            uint16_t phys = span.start + i * span.step;
             uint8_t  hue  = (i < half) ? h0 : h1;
 
             uint8_t r, g, b;
@@ -289,6 +310,50 @@ static void show_edge_reassignement(uint8_t face)
 void debug_change_mode(uint8_t mode)
 {
 	dbg_mode = (DebugMode)mode;
+	anim_select(mode < ANIM_6 ? mode : 0xFF);   // edge editor: animation RAM freed
+}
+
+uint8_t debug_mode(void)
+{
+    return (uint8_t)dbg_mode;
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * PKT_CONTROL: all ops checked first, then applied in one go
+ */
+#define OP_SIZE PROTO_CONTROL_OP_SIZE
+
+int16_t debug_control(const uint8_t *p, uint8_t n)
+{
+    if (n % OP_SIZE) return (int16_t)(n / OP_SIZE);
+    for (uint8_t i = 0; i < n / OP_SIZE; ++i) {
+        uint8_t op = p[i * OP_SIZE] & (uint8_t)~DBG_OP_DELTA;
+        if (op < DBG_OP_FACE || op > DBG_OP_FLIP) return i;
+    }
+
+    for (uint8_t i = 0; i < n; i += OP_SIZE) {
+        ProtoControlOp c;
+        proto_control_op_decode(&p[i], &c);
+        uint8_t op    = c.op;
+        bool    delta = (op & DBG_OP_DELTA) != 0;
+        float   v     = c.value;
+        if (!delta && v < 0.0f)     v = 0.0f;
+        if (!delta && v > 65535.0f) v = 65535.0f;     /* out of range, refused below */
+
+        switch (op & (uint8_t)~DBG_OP_DELTA) {
+        case DBG_OP_FACE: if (delta) debug_change_face(v); else debug_set_face((poly_idx_t)v); break;
+        case DBG_OP_SLOT: if (delta) debug_change_slot(v); else debug_set_slot((uint8_t)v);    break;
+        case DBG_OP_BAR:  if (delta) debug_change_bar(v);  else debug_set_bar((uint16_t)v);    break;
+        case DBG_OP_HUE:  if (delta) debug_change_hue(v);  else debug_set_hue((uint8_t)v);     break;
+        case DBG_OP_MODE: {
+            int32_t m = delta ? (int32_t)dbg_mode + (int32_t)v : (int32_t)v;
+            debug_change_mode((uint8_t)((m % DEBUG_MODE_COUNT + DEBUG_MODE_COUNT) % DEBUG_MODE_COUNT));
+            break;
+        }
+        case DBG_OP_FLIP: if (delta) { if (v != 0.0f) debug_toggle_flip(); } else debug_set_flip(v != 0.0f); break;
+        }
+    }
+    return -1;
 }
 
 
@@ -297,55 +362,85 @@ void debug_change_mode(uint8_t mode)
   * Dumps the current edge map and flip map as C initializers.
   * Uses the #noprefix# and #endnoprefix# tags to mark the dump section.
   * This ensures that the output can be directly copied without prefixes.
+  * One line per step, a background job (sched.h).
   * ========================================================================== */
  #define ENTRY_PER_LINE 8
- void debug_save_and_dump(void)
+ static bool dump_maps_step(uint32_t step)
  {
-     const uint8_t *emap = mapping_edit_edge_map();
+     const poly_idx_t *emap = mapping_edit_edge_map();
      const bool    *fmap = mapping_edit_flip_map();
-
-     // Start the no-prefix section for raw output
-     USBD_UsrLog("#noprefix#\n ");
-
-     // 1) Edge Map
-     USBD_UsrLog("static const uint8_t USER_MAP[EDGE_CNT] = {");
-     char line[128];
-     for (uint8_t i = 0; i < poly.E; i += ENTRY_PER_LINE) {
-         size_t off = 0;
-         line[0] = '\0';
-
-         // Add 4 spaces at the beginning of each line for indentation
-         off += snprintf(line + off, sizeof(line) - off, "    ");
-
+     uint32_t e_lines = (poly.E + ENTRY_PER_LINE - 1) / ENTRY_PER_LINE;
+     uint32_t f_lines = (poly.E + ENTRY_PER_LINE / 2 - 1) / (ENTRY_PER_LINE / 2);
+
+     // Start the no-prefix section for raw output, 1) Edge Map
+     if (step == 0) {
+         DLOG("#noprefix#\n ");
+         DLOG("static const uint16_t USER_MAP[EDGE_CNT] = {");
+         return true;
+     }
+     step -= 1;
+     if (step < e_lines) {
+         uint16_t i = (uint16_t)(step * ENTRY_PER_LINE);
+         // 4 spaces at the beginning of each line for indentation
+         DLOG_RAW("    ");
          for (uint8_t j = 0; j < ENTRY_PER_LINE && (i + j) < poly.E; ++j) {
-             off += snprintf(line + off, sizeof(line) - off,
-                             " %3u%s",
-                             emap[i + j],
-                             (i + j + 1 < poly.E) ? "," : "");
+             DLOG_RAW(" %3u%s", emap[i + j], (i + j + 1 < poly.E) ? "," : "");
          }
-         USBD_UsrLog("%s", line);
+         DLOG_RAW("\n");
+         return true;
      }
-     USBD_UsrLog("};\n ");
+     step -= e_lines;
 
      // 2) Flip Map
-     USBD_UsrLog("static const bool USER_FLIP[EDGE_CNT] = {");
-     for (uint8_t i = 0; i < poly.E; i += ENTRY_PER_LINE / 2) {
-         size_t off = 0;
-         line[0] = '\0';
-
-         // Add 4 spaces at the beginning of each line for indentation
-         off += snprintf(line + off, sizeof(line) - off, "    ");
-
+     if (step == 0) {
+         DLOG("};\n ");
+         DLOG("static const bool USER_FLIP[EDGE_CNT] = {");
+         return true;
+     }
+     step -= 1;
+     if (step < f_lines) {
+         uint16_t i = (uint16_t)(step * (ENTRY_PER_LINE / 2));
+         DLOG_RAW("    ");
          for (uint8_t j = 0; j < ENTRY_PER_LINE / 2 && (i + j) < poly.E; ++j) {
-             off += snprintf(line + off, sizeof(line) - off,
-                             " %s%s",
-                             fmap[i + j] ? "true" : "false",
-                             (i + j + 1 < poly.E) ? "," : "");
+             DLOG_RAW(" %s%s", fmap[i + j] ? "true" : "false", (i + j + 1 < poly.E) ? "," : "");
          }
-         USBD_UsrLog("%s", line);
+         DLOG_RAW("\n");
+         return true;
      }
-     USBD_UsrLog("};\n ");
 
      // End the no-prefix section
-     USBD_UsrLog("#endnoprefix#");
+     DLOG("};\n ");
+     DLOG("#endnoprefix#");
+     return false;
+ }
+
+ void debug_save_and_dump(void)
+ {
+#ifdef LED_MAP_STORE
+     if (mapping_store_save()) { USBD_UsrLog("mapping saved to flash, loaded on boot\n"); }
+     else                      { USBD_UsrLog("mapping NOT saved, flash write failed\n"); }
+#endif
+     if (!sched_job("save", dump_maps_step)) {
+         /* queue full: out now, in one go */
+         for (uint32_t step = 0; dump_maps_step(step); ++step) { }
+     }
+ }
+
+ void debug_apply_map(const poly_idx_t *map, const bool *flip)
+ {
+     memcpy(mapping_edit_edge_map(), map, poly.E * sizeof *map);
+     memcpy(mapping_edit_flip_map(), flip, poly.E * sizeof *flip);
+     update_mappings();
+     clear_saved();
+     debug_save_and_dump();
+ }
+
+ void debug_forget_saved(void)
+ {
+#ifdef LED_MAP_STORE
+     if (flash_store_erase()) { USBD_UsrLog("saved mapping erased, config.h applies after reset\n"); }
+     else                     { USBD_UsrLog("flash erase failed\n"); }
+#else
+     USBD_UsrLog("forget: built without LED_MAP_STORE\n");
+#endif
  }
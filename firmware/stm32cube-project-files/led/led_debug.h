@@ -19,47 +19,96 @@ typedef enum {
 	ANIM_3 = 3,
 	ANIM_4 = 4,
 	ANIM_5 = 5,
-	ANIM_6 = 6,
+	ANIM_6 = 6,        /* edge editor, the others run led_anim's registry */
+	DEBUG_MODE_COUNT
 } DebugMode;
 
 extern uint8_t debug_hue;
 
+/**
+ * PKT_CONTROL ops: op u8 | value float32, 5 bytes each. The value is the
+ * new setting, or a step with DBG_OP_DELTA or-ed into the op.
+ */
+typedef enum {
+	DBG_OP_FACE = 1,
+	DBG_OP_SLOT = 2,
+	DBG_OP_BAR  = 3,
+	DBG_OP_HUE  = 4,
+	DBG_OP_MODE = 5,
+	DBG_OP_FLIP = 6,       /* absolute: 0 / 1, step: any non-zero toggles */
+	DBG_OP_DELTA = 0x80
+} DebugOp;
+
 /**
  * Re-render debug UI if enough time has elapsed.
  */
 void debug_ui_tick(void);
 
 /**
- * Change active face (cyclic, float delta accumulated).
+ * Change active face (cyclic, float delta accumulated), or set it (false if
+ * out of range or not in the edge editor, ANIM_6). Edits draw on the next
+ * debug_ui_tick(), not right away.
  */
 void debug_change_face(float delta);
+bool debug_set_face(poly_idx_t face);
 
 /**
- * Change edge slot within active face (cyclic, float delta accumulated).
+ * Change edge slot within active face (cyclic, float delta accumulated), or
+ * set it.
  */
 void debug_change_slot(float delta);
+bool debug_set_slot(uint8_t slot);
 
 /**
- * Change selected bar (physical bar index). Triggers edge reassignment.
+ * Change / set selected bar (physical bar index). Triggers edge reassignment.
  */
 void debug_change_bar(float delta);
+bool debug_set_bar(uint16_t bar);
 
 /**
- * Toggle flip direction for selected edge.
+ * Toggle / set flip direction for selected edge.
  */
 void debug_toggle_flip(void);
+void debug_set_flip(bool flip);
 
 /**
- * Save current edge and flip maps, then dump them to USB log.
+ * Save current edge and flip maps (flash, LED_MAP_STORE), then dump them to USB log
+ * (a background job, sched.h).
  */
 void debug_save_and_dump(void);
 
+/**
+ * Drop the mapping saved in flash, config.h applies again from the next boot.
+ */
+void debug_forget_saved(void);
+
+/**
+ * Replace the whole edge and flip map (a permutation, p->E entries each,
+ * calib.h), then save and dump it as debug_save_and_dump() does. The edge
+ * editor's undo copy goes with the old map.
+ */
+void debug_apply_map(const poly_idx_t *map, const bool *flip);
+
 /**
  * Directly set debug mode by index.
  */
 void debug_change_mode(uint8_t mode);
 
 void debug_change_hue(float delta);
+void debug_set_hue(uint8_t hue);
+uint8_t debug_mode(void);
+
+/**
+ * Apply a batch of DebugOps (PKT_CONTROL payload) before the next frame,
+ * all or none: the batch is refused when one op is unknown.
+ * @return -1 applied, else the index of the first bad op
+ */
+int16_t debug_control(const uint8_t *p, uint8_t n);
+
+/**
+ * Forget the selection and the undo copy of the edge map (new geometry).
+ */
+void debug_reset(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,167 @@
+/* --------------------------------------------------------------------------
+ * led_geodesic.c – wireframe distance tables (Floyd–Warshall, again only when
+ *                   the polyhedron's gen moved)
+ * -------------------------------------------------------------------------- */
+#include "led_geodesic.h"
+
+#include <math.h>
+#include "led_mapping.h"
+#include "scene_mem.h"
+#include "fast_math.h"
+
+typedef struct {
+    uint16_t to_a;         /* arc to the edge's vertex a */
+    uint16_t to_b;         /* arc to vertex b            */
+    poly_idx_t edge;
+} GeoLed;
+
+static const Polyhedron *geo      = NULL;
+static poly_idx_t        vert_cnt = 0;
+static uint8_t          *hops     = NULL;   /* len = V * V */
+static uint16_t         *arc      = NULL;   /* len = V * V */
+static uint16_t         *edge_arc = NULL;   /* len = E, arc length of each edge */
+static uint32_t          vert_gen = 0;      /* geo->gen the tables were built for */
+
+static GeoLed           *leds     = NULL;   /* len = total pixels, lazily (scene pool too) */
+static uint16_t          led_cnt  = 0;
+static uint32_t          led_gen  = 0;      /* mapping_generation() it was built for */
+static uint32_t          led_vgen = 0;      /* and vert_gen */
+
+static float edge_len(const Polyhedron *p, poly_idx_t e)
+{
+    const float *A = p->v[p->e[e].a];
+    const float *B = p->v[p->e[e].b];
+    float dx = A[0] - B[0], dy = A[1] - B[1], dz = A[2] - B[2];
+    return fm_sqrtf(dx*dx + dy*dy + dz*dz);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * VERTEX TABLES, O(V³) at init and whenever geo->gen moved (V = 20: 8000 steps)
+ */
+static void compute_tables(void)
+{
+    const Polyhedron *p = geo;
+    const uint16_t V = p->V, E = p->E;
+
+    float max_len = 0.f;
+    for (uint16_t e = 0; e < E; ++e)
+        if (edge_len(p, (poly_idx_t)e) > max_len) max_len = edge_len(p, (poly_idx_t)e);
+    for (uint16_t e = 0; e < E; ++e)
+        edge_arc[e] = (uint16_t)lrintf(edge_len(p, (poly_idx_t)e) / max_len * GEO_ARC_ONE);
+
+    for (uint32_t i = 0; i < (uint32_t)V * V; ++i) {
+        hops[i] = 0xFF;
+        arc[i]  = GEO_UNREACHABLE;
+    }
+    for (uint16_t v = 0; v < V; ++v) {
+        hops[v * V + v] = 0;
+        arc [v * V + v] = 0;
+    }
+    for (uint16_t e = 0; e < E; ++e) {
+        poly_idx_t a = p->e[e].a, b = p->e[e].b;
+        hops[a * V + b] = hops[b * V + a] = 1;
+        if (edge_arc[e] < arc[a * V + b]) arc[a * V + b] = arc[b * V + a] = edge_arc[e];
+    }
+
+    for (uint16_t k = 0; k < V; ++k) {
+        for (uint16_t i = 0; i < V; ++i) {
+            const uint8_t  h_ik = hops[i * V + k];
+            const uint16_t a_ik = arc [i * V + k];
+            if (a_ik == GEO_UNREACHABLE) continue;
+            for (uint16_t j = 0; j < V; ++j) {
+                uint16_t h = (uint16_t)h_ik + hops[k * V + j];
+                uint32_t d = (uint32_t)a_ik + arc [k * V + j];
+                if (h < hops[i * V + j]) hops[i * V + j] = (uint8_t)h;
+                if (d < arc [i * V + j]) arc [i * V + j] = (uint16_t)d;
+            }
+        }
+    }
+    vert_gen = p->gen;
+}
+
+/* vertices moved / solid rebuilt in place since the tables were made? */
+static inline bool sync_tables(void)
+{
+    if (!arc) return false;
+    if (geo->gen != vert_gen) compute_tables();
+    return true;
+}
+
+void geodesic_shutdown(void)
+{
+    hops     = NULL;                         /* in the scene pool, emptied as a whole */
+    arc      = NULL;
+    edge_arc = NULL;
+    leds     = NULL;
+    led_cnt  = 0;
+    vert_cnt = 0;
+    geo      = NULL;
+}
+
+bool geodesic_init(const Polyhedron *p)
+{
+    geodesic_shutdown();
+    geo      = p;
+    vert_cnt = p->V;
+
+    const uint16_t V = p->V, E = p->E;
+    hops     = scene_alloc("hops",     (size_t)V * V);
+    arc      = scene_alloc("arc",      (size_t)V * V * sizeof *arc);
+    edge_arc = scene_alloc("edge_arc", E * sizeof *edge_arc);
+    if (!hops || !arc || !edge_arc) return false;
+    compute_tables();
+    return true;
+}
+
+uint8_t geodesic_hops(poly_idx_t a, poly_idx_t b)
+{
+    return (sync_tables() && a < vert_cnt && b < vert_cnt) ? hops[a * vert_cnt + b] : 0xFF;
+}
+
+uint16_t geodesic_arc(poly_idx_t a, poly_idx_t b)
+{
+    return (sync_tables() && a < vert_cnt && b < vert_cnt) ? arc[a * vert_cnt + b] : GEO_UNREACHABLE;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * LED TABLE, O(pixels), only when the mapping changed. LED i of an edge sits
+ * at i / (count - 1) from a (see build_edge_pos), indexed by pixel index.
+ */
+static bool ensure_leds(void)
+{
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    if (!sync_tables() || !info) return false;
+    if (leds && led_gen == mapping_generation() && led_vgen == vert_gen) return true;
+
+    if (!leds) {                             /* the LED count is fixed per scene */
+        uint16_t total = mapping_get_total_pixels();
+        leds    = scene_alloc("geo leds", total * sizeof *leds);
+        led_cnt = leds ? total : 0;
+        if (!leds) return false;
+    }
+    for (poly_idx_t e = 0; e < geo->E; ++e) {
+        const EdgeLedInfo inf = info[e];
+        for (uint16_t i = 0; i < inf.count; ++i) {
+            uint16_t to_a = inf.count > 1
+                          ? (uint16_t)(((uint32_t)edge_arc[e] * i + (inf.count - 1) / 2) / (inf.count - 1))
+                          : 0;
+            leds[inf.start + i * inf.step] = (GeoLed){ to_a, (uint16_t)(edge_arc[e] - to_a), e };
+        }
+    }
+    led_gen  = mapping_generation();
+    led_vgen = vert_gen;
+    return true;
+}
+
+uint16_t geodesic_led_arc(uint16_t idx, poly_idx_t v)
+{
+    if (!ensure_leds() || idx >= led_cnt || v >= vert_cnt) return GEO_UNREACHABLE;
+
+    const GeoLed  l  = leds[idx];
+    const uint16_t va = arc[geo->e[l.edge].a * vert_cnt + v];
+    const uint16_t vb = arc[geo->e[l.edge].b * vert_cnt + v];
+    uint32_t da = (va == GEO_UNREACHABLE) ? GEO_UNREACHABLE : (uint32_t)l.to_a + va;
+    uint32_t db = (vb == GEO_UNREACHABLE) ? GEO_UNREACHABLE : (uint32_t)l.to_b + vb;
+    uint32_t d  = da < db ? da : db;
+    return d < GEO_UNREACHABLE ? (uint16_t)d : GEO_UNREACHABLE;
+}
@@ -0,0 +1,58 @@
+/*
+ * led_geodesic.h – distances along the wireframe
+ *
+ * geodesic_init() runs Floyd–Warshall over the polyhedron's edge graph once:
+ * vertex → vertex hop counts (uint8) and arc lengths (uint16, GEO_ARC_ONE =
+ * the longest edge). Per LED the arc to both ends of its edge is built lazily
+ * (again when the mapping generation moves), so the wireframe distance of
+ * any LED to any vertex is two lookups and a min, no graph search per frame.
+ */
+
+#ifndef _LED_GEODESIC_H_
+#define _LED_GEODESIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "polyhedron.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GEO_ARC_ONE      256u        /* arc length of the longest edge */
+#define GEO_UNREACHABLE  0xFFFFu     /* vertices in different components */
+
+/**
+ * Build the vertex tables for p in the scene pool. Keeps p, the LED
+ * table follows its vertices' edges and the mapping. The tables take
+ * 3 bytes per vertex pair (V = 20: 1.2 kB, V = 62: 11.5 kB).
+ * @return false on allocation failure
+ */
+bool geodesic_init(const Polyhedron *p);
+
+/**
+ * Drop the tables (geodesic_* return "unreachable" until the next init).
+ */
+void geodesic_shutdown(void);
+
+/**
+ * Edges on the shortest path a → b (by hops), 0xFF if unreachable.
+ */
+uint8_t  geodesic_hops(poly_idx_t a, poly_idx_t b);
+
+/**
+ * Shortest arc length a → b along the edges, GEO_UNREACHABLE if none.
+ */
+uint16_t geodesic_arc(poly_idx_t a, poly_idx_t b);
+
+/**
+ * Arc length from LED idx (pixel index, as used by set_pixel_color & co)
+ * to vertex v along the wireframe, GEO_UNREACHABLE if idx is out of range.
+ */
+uint16_t geodesic_led_arc(uint16_t idx, poly_idx_t v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_GEODESIC_H_ */
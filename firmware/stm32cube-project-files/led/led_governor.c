@@ -0,0 +1,52 @@
+/* --------------------------------------------------------------------------
+ * led_governor.c – frame budget watch, quality level with hysteresis
+ * -------------------------------------------------------------------------- */
+#include "led_governor.h"
+#include "frame_clock.h"   /* frame_clock_stats: work_us / period_us */
+
+#define GOV_HOLD_MAX   8                /* longest down hold, x GOV_DOWN_FRAMES */
+
+static uint8_t  gov_lvl     = 0;
+static bool     gov_pinned  = false;
+static uint32_t gov_frames  = 0;        /* frame_clock frames last looked at   */
+static uint16_t gov_over    = 0;        /* frames in a row over the budget     */
+static uint16_t gov_under   = 0;        /* ... comfortably under it            */
+static uint8_t  gov_hold    = 1;        /* down wait, x GOV_DOWN_FRAMES        */
+static uint16_t gov_since   = 0xFFFF;   /* frames since the last step down     */
+
+void gov_update(void)
+{
+    const FrameClockStats *st = frame_clock_stats();
+    if (st->frames == gov_frames || !st->period_us) return;   /* no new frame */
+    gov_frames = st->frames;
+    if (gov_since < 0xFFFF) ++gov_since;
+    if (gov_pinned) return;
+
+    uint32_t pct = st->work_us * 100u / st->period_us;
+    gov_over  = (pct > GOV_HIGH_PCT) ? gov_over + 1  : 0;
+    gov_under = (pct < GOV_LOW_PCT)  ? gov_under + 1 : 0;
+
+    if (gov_over >= GOV_UP_FRAMES && gov_lvl < GOV_LEVELS - 1) {
+        ++gov_lvl;
+        /* straight back up after stepping down: that level doesn't hold */
+        if (gov_since < 2u * GOV_DOWN_FRAMES && gov_hold < GOV_HOLD_MAX) gov_hold *= 2;
+        gov_over = gov_under = 0;
+    } else if (gov_under >= (uint32_t)GOV_DOWN_FRAMES * gov_hold && gov_lvl > 0) {
+        --gov_lvl;
+        gov_since = 0;
+        gov_over  = gov_under = 0;
+    } else if (gov_since >= (uint32_t)GOV_DOWN_FRAMES * GOV_HOLD_MAX * 2u) {
+        gov_hold = 1;                   /* quiet for long: forget the history */
+    }
+}
+
+uint8_t gov_level(void) { return gov_lvl; }
+
+void gov_force(int8_t level)
+{
+    gov_pinned = (level >= 0 && level < GOV_LEVELS);
+    if (gov_pinned) gov_lvl = (uint8_t)level;
+    gov_over = gov_under = 0;
+}
+
+bool gov_forced(void) { return gov_pinned; }
@@ -0,0 +1,63 @@
+/*
+ * led_governor.h – quality levels that hold the frame budget
+ *
+ * Watches the frame clock's work time against its period. A few frames in
+ * a row over GOV_HIGH_PCT raise the level (cheaper rendering), a long stretch
+ * under GOV_LOW_PCT lowers it again; a level that had to come straight back
+ * waits longer before the next try, so it doesn't flicker between two.
+ * Animations read gov_level() and pick their own shortcuts, 0 = full quality.
+ */
+
+#ifndef _LED_GOVERNOR_H_
+#define _LED_GOVERNOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GOV_LEVELS              4       /* 0 full .. 3 cheapest */
+
+/* share of the frame period (%) that counts as over / comfortably under */
+#ifndef GOV_HIGH_PCT
+  #define GOV_HIGH_PCT          85
+#endif
+#ifndef GOV_LOW_PCT
+  #define GOV_LOW_PCT           50
+#endif
+/* frames in a row over to step up, under to step back down */
+#ifndef GOV_UP_FRAMES
+  #define GOV_UP_FRAMES         3
+#endif
+#ifndef GOV_DOWN_FRAMES
+  #define GOV_DOWN_FRAMES       60
+#endif
+
+/**
+ * Once per frame, before the animation draws (anim_tick does it)
+ */
+void gov_update(void);
+
+/**
+ * Quality level for this frame, 0 .. GOV_LEVELS - 1
+ */
+uint8_t gov_level(void);
+
+/**
+ * Pin the level (0 .. GOV_LEVELS - 1), anything else = automatic again
+ */
+void gov_force(int8_t level);
+
+/**
+ * Pinned by gov_force()
+ */
+bool gov_forced(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_GOVERNOR_H_ */
@@ -0,0 +1,191 @@
+/* --------------------------------------------------------------------------
+ * led_gpio_out.c – timer-paced GPIO DMA backend for parallel WS2812 strips
+ * -------------------------------------------------------------------------- */
+#include "led_gpio_out.h"
+#include "irq_stats.h"
+
+#ifdef LED_OUTPUT_GPIO
+
+/* DMA2 request mapping (RM0368, table 28), channel 6 for all three:
+ *   Stream1 = TIM1_CH1, Stream2 = TIM1_CH2, Stream6 = TIM1_CH3
+ * none of them collide with SPI1 TX on Stream5. */
+#define GPIO_DMA_CHSEL   (6u << DMA_SxCR_CHSEL_Pos)
+#define DMA_SET          DMA2_Stream1
+#define DMA_DATA         DMA2_Stream2
+#define DMA_CLR          DMA2_Stream6
+
+/* all interrupt flags of one stream (FEIF, DMEIF, TEIF, HTIF, TCIF) */
+#define DMA_FLAGS        0x3Du
+
+static uint16_t pin_mask = 0;          /* BSRR bits of the active strips */
+static uint32_t tim_hz   = 0;
+static volatile uint32_t dma_errors = 0;   /* transfer / direct mode errors */
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * TIM1 runs off APB2, doubled when APB2 is divided.
+ */
+static uint32_t tim1_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE2) ? 2 * pclk : pclk;
+}
+
+static inline uint32_t ns_to_ticks(uint32_t ns)
+{
+    return (uint32_t)(((uint64_t)tim_hz * ns + 500000000U) / 1000000000U);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Half-word memory → peripheral, paced by the timer request.
+ */
+static void dma_arm(DMA_Stream_TypeDef *st, const void *src, volatile void *dst,
+                    uint16_t count, bool minc, bool tcie)
+{
+    st->CR &= ~DMA_SxCR_EN;
+    while (st->CR & DMA_SxCR_EN) { }
+
+    st->PAR  = (uint32_t)dst;
+    st->M0AR = (uint32_t)src;
+    st->NDTR = count;
+    st->FCR  = 0;                                      /* direct mode */
+    st->CR   = GPIO_DMA_CHSEL
+             | DMA_SxCR_DIR_0                          /* memory → peripheral */
+             | DMA_SxCR_PSIZE_0 | DMA_SxCR_MSIZE_0     /* 16 bit */
+             | DMA_SxCR_PL_1                           /* high priority */
+             | (minc ? DMA_SxCR_MINC : 0)
+             | (tcie ? DMA_SxCR_TCIE : 0);
+    st->CR  |= DMA_SxCR_EN;
+}
+
+static void dma_clear_flags(void)
+{
+    DMA2->LIFCR = (DMA_FLAGS << 6) | (DMA_FLAGS << 16);   /* stream 1, 2 */
+    DMA2->HIFCR = (DMA_FLAGS << 16);                      /* stream 6    */
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Pins, timer and NVIC. DMA streams are armed per frame.
+ */
+bool gpio_out_init(uint8_t strip_count, uint16_t *pins)
+{
+    pin_mask = 0;
+    uint8_t s = 0;
+    for (uint8_t p = 0; p < 16 && s < strip_count; ++p) {
+        if (LED_GPIO_PIN_MASK & (1u << p)) {
+            pins[s++] = (uint16_t)(1u << p);
+            pin_mask |= (uint16_t)(1u << p);
+        }
+    }
+    if (s < strip_count) return false;
+
+    /* GPIO clocks are already on from MX_GPIO_Init() */
+    LED_GPIO_PORT->BSRR = (uint32_t)pin_mask << 16;       /* start low */
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin   = pin_mask;
+    gpio.Mode  = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull  = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    HAL_GPIO_Init(LED_GPIO_PORT, &gpio);
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    __HAL_RCC_TIM1_CLK_ENABLE();
+    tim_hz = tim1_clock();
+
+    TIM1->CR1  = 0;
+    TIM1->PSC  = 0;
+    TIM1->DIER = 0;
+    TIM1->SR   = 0;
+
+    HAL_NVIC_SetPriority(DMA2_Stream6_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+    HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Arm the three streams and let TIM1 pace them, one request each per bit.
+ */
+void gpio_out_start(const uint16_t *slices, uint16_t count)
+{
+    static uint16_t all_pins;
+    all_pins = pin_mask;
+
+    volatile uint16_t *bsrr_set   = (volatile uint16_t *)&LED_GPIO_PORT->BSRR;
+    volatile uint16_t *bsrr_reset = bsrr_set + 1;
+
+    TIM1->CR1  = 0;
+    TIM1->CNT  = 0;
+    TIM1->ARR  = ns_to_ticks(LED_GPIO_BIT_NS) - 1;
+    TIM1->CCR1 = 1;
+    TIM1->CCR2 = 1 + ns_to_ticks(LED_GPIO_T0H_NS);
+    TIM1->CCR3 = 1 + ns_to_ticks(LED_GPIO_T1H_NS);
+    TIM1->SR   = 0;
+
+    dma_clear_flags();
+    dma_arm(DMA_SET,  &all_pins, bsrr_set,   count, false, false);
+    dma_arm(DMA_DATA, slices,    bsrr_reset, count, true,  false);
+    dma_arm(DMA_CLR,  &all_pins, bsrr_reset, count, false, true);   /* last write of a bit */
+
+    TIM1->DIER = TIM_DIER_CC1DE | TIM_DIER_CC2DE | TIM_DIER_CC3DE;
+    TIM1->CR1  = TIM_CR1_CEN;
+}
+
+void gpio_out_stop(void)
+{
+    TIM1->CR1  = 0;
+    TIM1->DIER = 0;
+    DMA_SET->CR  &= ~DMA_SxCR_EN;
+    DMA_DATA->CR &= ~DMA_SxCR_EN;
+    DMA_CLR->CR  &= ~DMA_SxCR_EN;
+    LED_GPIO_PORT->BSRR = (uint32_t)pin_mask << 16;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Last bit written: reuse TIM1 as a one-shot for the latch time, the frame
+ * only counts as done once the lines have been low long enough.
+ */
+void DMA2_Stream6_IRQHandler(void)
+{
+    IRQ_ENTER(GPIO_DMA);
+    if (!(DMA2->HISR & DMA_HISR_TCIF6)) {
+        if (DMA2->HISR & (DMA_HISR_TEIF6 | DMA_HISR_DMEIF6)) ++dma_errors;
+        DMA2->HIFCR = (DMA_FLAGS << 16);
+        IRQ_EXIT(GPIO_DMA);
+        return;
+    }
+    dma_clear_flags();
+
+    uint32_t ticks = (uint32_t)(((uint64_t)tim_hz * LED_GPIO_LATCH_US) / 1000000U);
+    uint32_t psc   = ticks >> 16;                 /* keep ARR within 16 bit */
+
+    TIM1->CR1  = 0;
+    TIM1->DIER = 0;
+    TIM1->PSC  = psc;
+    TIM1->ARR  = ticks / (psc + 1);
+    TIM1->CNT  = 0;
+    TIM1->EGR  = TIM_EGR_UG;                      /* load PSC */
+    TIM1->SR   = 0;
+    TIM1->DIER = TIM_DIER_UIE;
+    TIM1->CR1  = TIM_CR1_OPM | TIM_CR1_CEN;
+    IRQ_EXIT(GPIO_DMA);
+}
+
+uint32_t gpio_out_errors(void)
+{
+    return dma_errors;
+}
+
+void TIM1_UP_TIM10_IRQHandler(void)
+{
+    IRQ_ENTER(GPIO_TIM);
+    TIM1->SR   = 0;
+    TIM1->DIER = 0;
+    TIM1->PSC  = 0;                               /* next gpio_out_start() reloads on CEN */
+    TIM1->EGR  = TIM_EGR_UG;
+    TIM1->SR   = 0;
+    gpio_out_tx_done();
+    IRQ_EXIT(GPIO_TIM);
+}
+
+#endif /* LED_OUTPUT_GPIO */
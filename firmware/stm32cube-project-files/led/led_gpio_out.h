@@ -0,0 +1,89 @@
+/*
+ * led_gpio_out.h – Parallel WS2812 output on one GPIO port (LED_OUTPUT_GPIO)
+ *
+ * TIM1 paces three DMA2 streams that write the port's BSRR every bit period:
+ *   CC1 → set all strip pins high
+ *   CC2 → reset the pins whose bit is 0   (T0H)
+ *   CC3 → reset all strip pins            (T1H)
+ * so up to 16 strips are clocked out in parallel from one bit-sliced buffer.
+ */
+
+#ifndef _LED_GPIO_OUT_H_
+#define _LED_GPIO_OUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx_hal.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* parallel strips to drive (main.c passes this to init_render) */
+#ifndef LED_GPIO_STRIPS
+  #define LED_GPIO_STRIPS     8
+#endif
+
+/* which port and pins; strip s drives the s-th set bit of the mask */
+#ifndef LED_GPIO_PORT
+  #define LED_GPIO_PORT       GPIOB
+#endif
+#ifndef LED_GPIO_PIN_MASK
+  #define LED_GPIO_PIN_MASK   0x00FFu          /* PB0..PB7 */
+#endif
+
+/* WS2812 timing */
+#ifndef LED_GPIO_BIT_NS
+  #define LED_GPIO_BIT_NS     1250
+#endif
+#ifndef LED_GPIO_T0H_NS
+  #define LED_GPIO_T0H_NS     400
+#endif
+#ifndef LED_GPIO_T1H_NS
+  #define LED_GPIO_T1H_NS     800
+#endif
+#ifndef LED_GPIO_LATCH_US
+  #define LED_GPIO_LATCH_US   300
+#endif
+
+/* one half-word per WS2812 bit, 24 per LED row */
+#define LED_GPIO_SLOTS_PER_LED 24
+
+/**
+ * Configure the strip pins, TIM1 and the DMA2 streams.
+ * @param strip_count  Number of parallel strips (<= set bits in LED_GPIO_PIN_MASK)
+ * @param pins         Filled with the BSRR bit of each strip (length = strip_count)
+ * @return false if the pin mask has too few pins
+ */
+bool gpio_out_init(uint8_t strip_count, uint16_t *pins);
+
+/**
+ * Clock out one frame. A slice bit set in row[i] means WS2812 bit i is 0 on
+ * that pin. Must not be called while a frame (or its latch) is still running.
+ * @param slices  Bit-sliced frame, leds_per_strip * LED_GPIO_SLOTS_PER_LED entries
+ * @param count   Number of entries
+ */
+void gpio_out_start(const uint16_t *slices, uint16_t count);
+
+/**
+ * Abort a running frame and release the pins (driven low).
+ */
+void gpio_out_stop(void);
+
+/**
+ * DMA errors (transfer, direct mode) on the clearing stream since boot
+ */
+uint32_t gpio_out_errors(void);
+
+/**
+ * Called from the TIM1 ISR once a frame and its latch time are done.
+ * Implemented by the renderer.
+ */
+void gpio_out_tx_done(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_GPIO_OUT_H_ */
@@ -0,0 +1,153 @@
+/* --------------------------------------------------------------------------
+ * led_hud.c – fps, frame budget, interrupt load and USB drops as bar graphs
+ *             on edges (led_hud.h)
+ * -------------------------------------------------------------------------- */
+#include "led_hud.h"
+
+#include "led_render.h"      /* set_all_pixels_color, fill_pixels, update_leds */
+#include "led_mapping.h"     /* edge spans */
+#include "led_anim.h"        /* anim_find */
+#include "led_layers.h"      /* layers_set / layers_clear / layers_anim */
+#include "frame_clock.h"     /* frames, work_us, period_us */
+#include "irq_stats.h"       /* irq_last (LED_IRQ_STATS) */
+#include "usb_comms.h"       /* usb_tx_dropped */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick, SystemCoreClock */
+
+enum { HUD_FPS, HUD_BUDGET, HUD_IRQ, HUD_DROPS, HUD_BARS };
+
+enum { HUD_OK, HUD_WARN, HUD_BAD, HUD_NONE };
+
+static const poly_idx_t hud_edges[] = HUD_EDGES;
+_Static_assert(sizeof hud_edges / sizeof *hud_edges == HUD_BARS, "HUD_EDGES: one edge per gauge, four");
+
+static const rgb_8b hud_color[] = {
+    [HUD_OK]   = {   0, 255,   0 },
+    [HUD_WARN] = { 255, 140,   0 },
+    [HUD_BAD]  = { 255,   0,   0 },
+    [HUD_NONE] = {  24,  24,  24 },
+};
+static const rgb_8b hud_scale = { 0, 0, 20 };   /* the unlit rest of an edge */
+
+static uint16_t bar_q8[HUD_BARS];       /* fill, 256 = the whole edge */
+static uint8_t  bar_state[HUD_BARS];
+
+/* the window being taken */
+static uint32_t win_t0;
+static uint32_t win_frames;
+static uint32_t win_dropped;
+static uint32_t win_work_max;
+
+static uint32_t dropped_now(void)
+{
+    return usb_tx_dropped(TX_CH_TEXT) + usb_tx_dropped(TX_CH_PACKET);
+}
+
+static uint8_t load_state(uint32_t q8)
+{
+    if (q8 * 100u > HUD_BAD_PCT * 256u)  return HUD_BAD;
+    if (q8 * 100u > HUD_WARN_PCT * 256u) return HUD_WARN;
+    return HUD_OK;
+}
+
+static uint16_t clamp_q8(uint32_t q8) { return (uint16_t)(q8 > 256u ? 256u : q8); }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * One closed window into the four bars
+ */
+static void hud_window(uint32_t now, const FrameClockStats *st)
+{
+    const uint32_t dt = now - win_t0;
+
+    /* frames in the window against dt / period: 256 = every tick had one */
+    const uint32_t fps_q8 = st->period_us
+        ? (uint32_t)((uint64_t)(st->frames - win_frames) * st->period_us * 256u / (dt * 1000u)) : 0;
+    bar_q8[HUD_FPS]    = clamp_q8(fps_q8);
+    bar_state[HUD_FPS] = (fps_q8 * 100u >= HUD_FPS_WARN_PCT * 256u) ? HUD_OK
+                       : (fps_q8 * 100u >= HUD_FPS_BAD_PCT * 256u)  ? HUD_WARN : HUD_BAD;
+
+    const uint32_t budget_q8 = st->period_us ? win_work_max * 256u / st->period_us : 0;
+    bar_q8[HUD_BUDGET]    = clamp_q8(budget_q8);
+    bar_state[HUD_BUDGET] = load_state(budget_q8);
+
+#ifdef LED_IRQ_STATS
+    uint32_t        window_ms;
+    const IrqStats *is  = irq_last(&window_ms);
+    uint64_t        cyc = 0;
+    for (uint8_t v = 0; v < IRQ_V_COUNT; ++v) cyc += is[v].cycles;
+    const uint32_t irq_q8 = window_ms
+        ? (uint32_t)(cyc * 256u / ((uint64_t)window_ms * (SystemCoreClock / 1000u))) : 0;
+    bar_q8[HUD_IRQ]    = clamp_q8(irq_q8);
+    bar_state[HUD_IRQ] = load_state(irq_q8);
+#else
+    bar_q8[HUD_IRQ]    = 256;
+    bar_state[HUD_IRQ] = HUD_NONE;
+#endif
+
+    const uint32_t dropped = dropped_now();
+    const uint32_t lost    = dropped - win_dropped;
+    bar_q8[HUD_DROPS]    = clamp_q8(lost * 256u / HUD_DROPS_FULL);
+    bar_state[HUD_DROPS] = lost ? HUD_BAD : HUD_OK;
+    if (lost && !bar_q8[HUD_DROPS]) bar_q8[HUD_DROPS] = 1;
+
+    win_t0       = now;
+    win_frames   = st->frames;
+    win_dropped  = dropped;
+    win_work_max = 0;
+}
+
+static void gauge(uint8_t bar)
+{
+    const poly_idx_t e = hud_edges[bar];
+    if (e >= mapping_get_edge_count()) return;
+    const EdgeLedInfo inf = mapping_get_edge_info()[e];
+    if (!inf.count) return;
+
+    uint16_t lit = (uint16_t)((bar_q8[bar] * inf.count + 128u) >> 8);
+    if (bar_q8[bar] && !lit) lit = 1;                   /* something there shows */
+    fill_pixels(inf.start, lit, inf.step, hud_color[bar_state[bar]]);
+    if (lit < inf.count)
+        fill_pixels((uint16_t)(inf.start + lit * inf.step), (uint16_t)(inf.count - lit), inf.step, hud_scale);
+}
+
+bool anim_hud_init(PolyArena *a)
+{
+    (void)a;
+    const FrameClockStats *st = frame_clock_stats();
+    win_t0       = HAL_GetTick();
+    win_frames   = st->frames;
+    win_dropped  = dropped_now();
+    win_work_max = 0;
+    for (uint8_t b = 0; b < HUD_BARS; ++b) {
+        bar_q8[b]    = 0;
+        bar_state[b] = HUD_OK;
+    }
+    return true;
+}
+
+void anim_hud_tick(void)
+{
+    const FrameClockStats *st  = frame_clock_stats();
+    const uint32_t         now = HAL_GetTick();
+    if (st->work_us > win_work_max) win_work_max = st->work_us;   /* the frame before this one */
+    if (now - win_t0 >= HUD_WINDOW_MS) hud_window(now, st);
+
+    set_all_pixels_color(0, 0, 0);
+    for (uint8_t b = 0; b < HUD_BARS; ++b) gauge(b);
+    update_leds();
+}
+
+bool hud_show(bool on)
+{
+    if (!on) {
+        if (hud_shown()) layers_clear(LAYER_OVERLAYS);
+        return true;
+    }
+    const int anim = anim_find("hud");
+    return anim >= 0 && layers_set(LAYER_OVERLAYS, (uint8_t)anim, LAYER_BLEND_ALPHA, 255);
+}
+
+bool hud_shown(void)
+{
+    const int anim = anim_find("hud");
+    return anim >= 0 && layers_anim(LAYER_OVERLAYS) == anim;
+}
@@ -0,0 +1,84 @@
+/*
+ * led_hud.h – performance gauges drawn on the sculpture itself
+ *
+ * The "hud" animation lights HUD_EDGES as bar graphs, one value each, and
+ * leaves every other LED black. Run as the top overlay layer (hud_show(),
+ * "hud" on the console, a controller button in the app) with alpha blending
+ * it sits over whatever runs, black is transparent: a venue without a PC
+ * still shows the frame rate dropping or the slot filling up.
+ *
+ *   edge 0   fps against the frame clock's target, full = on target
+ *   edge 1   frame budget: the longest frame of the window / the period
+ *   edge 2   interrupt load, the share of the CPU in handlers
+ *            (LED_IRQ_STATS, a grey edge without it)
+ *   edge 3   USB bytes dropped in the window, HUD_DROPS_FULL fills it,
+ *            any drop lights the first LED
+ *
+ * Each bar is green, amber past HUD_WARN_PCT, red past HUD_BAD_PCT of its
+ * range (fps: under HUD_FPS_WARN_PCT, HUD_FPS_BAD_PCT of the target), the
+ * rest of the edge glows dim so its length reads as the scale. The values
+ * are taken over HUD_WINDOW_MS, the bars step once a window. The edges are
+ * logical ones (led_mapping), each walked from its start.
+ */
+
+#ifndef _LED_HUD_H_
+#define _LED_HUD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "polyhedron.h"    /* PolyArena */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the gauges' edges, in the order above */
+#ifndef HUD_EDGES
+  #define HUD_EDGES             { 0, 1, 2, 3 }
+#endif
+#ifndef HUD_WINDOW_MS
+  #define HUD_WINDOW_MS         500
+#endif
+/* budget and load: amber, red past these (%) */
+#ifndef HUD_WARN_PCT
+  #define HUD_WARN_PCT          60
+#endif
+#ifndef HUD_BAD_PCT
+  #define HUD_BAD_PCT           85
+#endif
+/* fps: amber, red under these (% of the target) */
+#ifndef HUD_FPS_WARN_PCT
+  #define HUD_FPS_WARN_PCT      98
+#endif
+#ifndef HUD_FPS_BAD_PCT
+  #define HUD_FPS_BAD_PCT       90
+#endif
+/* dropped bytes in a window that fill the USB gauge */
+#ifndef HUD_DROPS_FULL
+  #define HUD_DROPS_FULL        1024
+#endif
+
+/**
+ * Registry hooks of the "hud" animation
+ */
+bool anim_hud_init(PolyArena *a);
+void anim_hud_tick(void);
+
+/**
+ * Put the HUD on the top overlay layer (LAYER_OVERLAYS, alpha blended,
+ * replacing what was there) or take it off
+ * @return false if "hud" is not registered or runs on another layer
+ */
+bool hud_show(bool on);
+
+/**
+ * HUD on the top layer
+ */
+bool hud_shown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_HUD_H_ */
@@ -0,0 +1,191 @@
+/* --------------------------------------------------------------------------
+ * led_layers.c – overlay layers and the composite pass
+ * -------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <string.h>
+#include "led_layers.h"
+#include "led_render.h"    /* render_target, render_store_block, framebuffer */
+#include "led_mapping.h"   /* mapping_get_total_pixels */
+
+typedef struct {
+    bool       on;
+    uint8_t    anim;          /* registry index */
+    LayerBlend blend;
+    uint8_t    alpha;
+    AnimSlot   slot;
+} Layer;
+
+static Layer    layers[LAYER_OVERLAYS];
+static rgb_8b  *layer_buf = NULL;     /* base, then one per overlay that is on */
+static uint16_t layer_px  = 0;        /* pixels per layer it was sized for     */
+static uint8_t  layer_cnt = 0;        /* buffers in it                         */
+
+static const char *const blend_names[] = { "add", "max", "alpha", "mul" };
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Buffers: zeroed, sized to what is on, dropped when that changes
+ */
+static void free_buffers(void)
+{
+    free(layer_buf);
+    layer_buf = NULL;
+    layer_px  = 0;
+    layer_cnt = 0;
+}
+
+static bool ensure_buffers(uint8_t count)
+{
+    uint16_t px = mapping_get_total_pixels();
+    if (layer_buf && layer_px == px && layer_cnt == count) return true;
+    free_buffers();
+    if (!px) return false;
+    layer_buf = calloc((size_t)count * px, sizeof *layer_buf);
+    if (!layer_buf) return false;
+    layer_px  = px;
+    layer_cnt = count;
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Blend modes, a = alpha + 1 (1..256)
+ */
+static inline uint8_t mix8(uint8_t c, uint8_t o, uint16_t a)
+{
+    return (uint8_t)(c + (((int16_t)o - c) * a >> 8));
+}
+
+static inline rgb_8b blend_px(rgb_8b c, rgb_8b o, LayerBlend m, uint16_t a)
+{
+    switch (m) {
+    case LAYER_BLEND_ADD: {
+        uint16_t r = c.r + (o.r * a >> 8), g = c.g + (o.g * a >> 8), b = c.b + (o.b * a >> 8);
+        return (rgb_8b){ r > 255 ? 255 : r, g > 255 ? 255 : g, b > 255 ? 255 : b };
+    }
+    case LAYER_BLEND_MAX: {
+        uint8_t r = o.r * a >> 8, g = o.g * a >> 8, b = o.b * a >> 8;
+        return (rgb_8b){ r > c.r ? r : c.r, g > c.g ? g : c.g, b > c.b ? b : c.b };
+    }
+    case LAYER_BLEND_ALPHA:
+        if (!(o.r | o.g | o.b)) return c;
+        return (rgb_8b){ mix8(c.r, o.r, a), mix8(c.g, o.g, a), mix8(c.b, o.b, a) };
+    case LAYER_BLEND_MUL:
+        return (rgb_8b){ mix8(c.r, c.r * (o.r + 1) >> 8, a),
+                         mix8(c.g, c.g * (o.g + 1) >> 8, a),
+                         mix8(c.b, c.b * (o.b + 1) >> 8, a) };
+    }
+    return c;
+}
+
+/* one sweep over the framebuffer whatever the layer count, per dirty block
+ * only what changed gets marked */
+static LED_RAMFUNC void composite(const rgb_8b *base, const rgb_8b *const *src,
+                                  const Layer *const *l, uint8_t n)
+{
+    uint16_t a[LAYER_OVERLAYS];
+    for (uint8_t k = 0; k < n; ++k) a[k] = l[k]->alpha + 1u;
+
+    for (uint16_t b0 = 0; b0 < layer_px; b0 += LED_DIRTY_BLOCK) {
+        uint16_t end = b0 + LED_DIRTY_BLOCK;
+        if (end > layer_px) end = layer_px;
+        rgb_8b blk[LED_DIRTY_BLOCK];
+        for (uint16_t p = b0; p < end; ++p) {
+            rgb_8b c = base[p];
+            for (uint8_t k = 0; k < n; ++k) c = blend_px(c, src[k][p], l[k]->blend, a[k]);
+            blk[p - b0] = c;
+        }
+        render_store_block(b0, end - b0, blk);
+    }
+}
+
+/* ==========================================================================
+ * API
+ * ========================================================================== */
+bool layers_set(uint8_t layer, uint8_t anim, LayerBlend blend, uint8_t alpha)
+{
+    if (layer < 1 || layer > LAYER_OVERLAYS || !anim_get(anim)) return false;
+    if (blend > LAYER_BLEND_MUL) return false;
+    for (uint8_t i = 0; i < LAYER_OVERLAYS; ++i)
+        if (i != layer - 1 && layers[i].on && layers[i].anim == anim) return false;
+
+    Layer *L = &layers[layer - 1];
+    if (!L->on || L->anim != anim) anim_slot_stop(&L->slot);
+    L->on    = true;
+    L->anim  = anim;
+    L->blend = blend;
+    L->alpha = alpha;
+    return true;
+}
+
+void layers_clear(uint8_t layer)
+{
+    if (layer < 1 || layer > LAYER_OVERLAYS) return;
+    Layer *L = &layers[layer - 1];
+    anim_slot_stop(&L->slot);
+    L->on = false;
+    if (!layers_active()) free_buffers();
+}
+
+int layers_anim(uint8_t layer)
+{
+    if (layer < 1 || layer > LAYER_OVERLAYS || !layers[layer - 1].on) return -1;
+    return layers[layer - 1].anim;
+}
+
+bool layers_active(void)
+{
+    for (uint8_t i = 0; i < LAYER_OVERLAYS; ++i)
+        if (layers[i].on) return true;
+    return false;
+}
+
+void layers_release(void)
+{
+    for (uint8_t i = 0; i < LAYER_OVERLAYS; ++i) anim_slot_stop(&layers[i].slot);
+    free_buffers();
+}
+
+int layers_blend_find(const char *name)
+{
+    if (!name) return -1;
+    for (uint8_t i = 0; i < sizeof blend_names / sizeof *blend_names; ++i)
+        if (strcmp(blend_names[i], name) == 0) return i;
+    return -1;
+}
+
+void layers_frame(const Animation *base)
+{
+    uint8_t on = 0;
+    for (uint8_t i = 0; i < LAYER_OVERLAYS; ++i) on += layers[i].on;
+    if (!framebuffer || !ensure_buffers(1 + on)) {
+        base->tick();                           /* no RAM for layers: base alone */
+        return;
+    }
+
+    /* 1. every layer draws once, into its own buffer */
+    render_target(layer_buf);
+    base->tick();
+
+    const rgb_8b *src[LAYER_OVERLAYS];
+    const Layer  *lay[LAYER_OVERLAYS];
+    uint8_t       n   = 0;
+    rgb_8b       *buf = layer_buf + layer_px;
+    for (uint8_t i = 0; i < LAYER_OVERLAYS; ++i) {
+        Layer *L = &layers[i];
+        if (!L->on) continue;
+        rgb_8b          *mine = buf;
+        const Animation *a    = anim_get(L->anim);
+        buf += layer_px;
+        if (a == base) continue;                /* the base has it */
+        if (L->slot.anim != a && !anim_slot_start(&L->slot, a)) continue;
+        render_target(mine);
+        a->tick();
+        src[n] = mine;
+        lay[n] = L;
+        ++n;
+    }
+    render_target(NULL);
+
+    /* 2. one pass into the framebuffer, one submit */
+    composite(layer_buf, src, lay, n);
+    update_leds();
+}
@@ -0,0 +1,82 @@
+/*
+ * led_layers.h – layer stack on top of the selected animation
+ *
+ * Without overlays the selected animation draws straight into the
+ * framebuffer, as before. With overlays every layer (selected animation =
+ * layer 0, then overlays 1..LAYER_OVERLAYS) draws once into its own buffer
+ * through render_target(), so fade trails etc. stay per layer, and one sweep
+ * blends them all into the framebuffer before the single update_leds().
+ * Costs 3 bytes per pixel per layer (base included) while overlays are on.
+ */
+
+#ifndef _LED_LAYERS_H_
+#define _LED_LAYERS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_anim.h"      /* Animation, AnimSlot */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* overlay layers on top of the base */
+#ifndef LAYER_OVERLAYS
+  #define LAYER_OVERLAYS        2
+#endif
+
+typedef enum {
+    LAYER_BLEND_ADD,        /* saturating add of overlay * alpha               */
+    LAYER_BLEND_MAX,        /* per channel max with overlay * alpha            */
+    LAYER_BLEND_ALPHA,      /* crossfade by alpha, black overlay = transparent */
+    LAYER_BLEND_MUL,        /* multiply, alpha mixes it in                     */
+} LayerBlend;
+
+/**
+ * Run registry animation anim as overlay layer (1..LAYER_OVERLAYS).
+ * Set up lazily on the next frame. An overlay showing the selected animation
+ * is skipped (see anim_slot_start).
+ * @param alpha  opacity 0..255
+ * @return false if layer / anim is out of range or anim is on another layer
+ */
+bool layers_set(uint8_t layer, uint8_t anim, LayerBlend blend, uint8_t alpha);
+
+/**
+ * Switch an overlay off (its animation torn down, buffers shrink next frame)
+ */
+void layers_clear(uint8_t layer);
+
+/**
+ * Registry index of the animation on overlay layer (1..LAYER_OVERLAYS),
+ * -1 if it is off
+ */
+int layers_anim(uint8_t layer);
+
+/**
+ * Any overlay on
+ */
+bool layers_active(void);
+
+/**
+ * One composited frame: base and overlays into their buffers, blended into
+ * the framebuffer, update_leds(). Falls back to base alone if the layer
+ * buffers don't fit.
+ */
+void layers_frame(const Animation *base);
+
+/**
+ * Tear the overlays' animations down and free the buffers (settings stay,
+ * set up again on the next frame)
+ */
+void layers_release(void);
+
+/**
+ * Blend mode by name (add max alpha mul), -1 if unknown
+ */
+int layers_blend_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_LAYERS_H_ */
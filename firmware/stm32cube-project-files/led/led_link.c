@@ -0,0 +1,444 @@
+/* --------------------------------------------------------------------------
+ * led_link.c – USART1 + DMA frame link between boards, PB12 latch
+ * -------------------------------------------------------------------------- */
+#include "led_link.h"
+
+#if defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE)
+
+#include <stdlib.h>
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#include "led_stream.h"      /* STREAM_FRAME_*, the frame format */
+#include "led_render.h"      /* render_acquire_back, render_submit (node) */
+#include "scene_mem.h"       /* scene_alloc, buffers live with the scene */
+
+/* DMA2 request mapping (RM0368, table 28), channel 4: Stream7 = USART1_TX,
+ * Stream2 = USART1_RX */
+#define LINK_DMA_CHSEL   (4u << DMA_SxCR_CHSEL_Pos)
+#define LINK_DMA_TX      DMA2_Stream7
+#define LINK_DMA_RX      DMA2_Stream2
+
+/* all interrupt flags of one stream (FEIF, DMEIF, TEIF, HTIF, TCIF) */
+#define DMA_FLAGS        0x3Du
+
+#define SYNC_PORT        GPIOB
+#define SYNC_PIN         GPIO_PIN_12
+
+static LinkStats stats;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * USART1 on PA9 (TX) / PA10 (RX), AF7, 8N1, 16x oversampling
+ */
+static void usart_init(uint32_t cr1)
+{
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_USART1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin       = GPIO_PIN_9 | GPIO_PIN_10;
+    gpio.Mode      = GPIO_MODE_AF_PP;
+    gpio.Pull      = GPIO_PULLUP;                 /* idle high with no master on the line */
+    gpio.Speed     = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate = GPIO_AF7_USART1;
+    HAL_GPIO_Init(GPIOA, &gpio);
+
+    USART1->CR1 = 0;
+    USART1->CR2 = 0;
+    USART1->BRR = (HAL_RCC_GetPCLK2Freq() + LED_LINK_BAUD / 2) / LED_LINK_BAUD;
+    USART1->CR3 = USART_CR3_DMAT | USART_CR3_DMAR;
+    USART1->CR1 = USART_CR1_UE | cr1;
+}
+
+static void usart_stop(void)
+{
+    LINK_DMA_TX->CR &= ~DMA_SxCR_EN;
+    LINK_DMA_RX->CR &= ~DMA_SxCR_EN;
+    USART1->CR1 = 0;
+}
+
+#ifdef LED_LINK_MASTER
+/* ─────────────────────────────────────────────────────────────────────────
+ * Master: every node's packet into one buffer, one DMA transfer
+ */
+static const uint16_t nodes[] = LED_LINK_NODES;
+#define NODES            (sizeof nodes / sizeof nodes[0])
+
+static uint8_t          *shadow;        /* what the nodes show, 3 bytes per LED */
+static uint8_t          *tx;            /* all packets of a frame */
+static uint32_t          shadow_len;
+static volatile bool     sending;       /* DMA runs */
+static volatile bool     sent;          /* a whole frame is out, latch at the next tick */
+static uint16_t          key_in;        /* frames until every node gets a raw one */
+
+bool link_init(uint16_t total_pixels)
+{
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < NODES; ++i) sum += nodes[i];
+    if (sum != total_pixels || NODES > 255) return false;
+
+    link_shutdown();
+    shadow_len = 3u * sum;
+    shadow = scene_calloc("link shadow", shadow_len, 1);
+    tx     = scene_alloc("link tx", shadow_len + NODES * (LINK_HDR + 2u));   /* all raw, the worst case */
+    if (!shadow || !tx) {
+        link_shutdown();
+        return false;
+    }
+    key_in  = 0;
+    sending = false;
+    sent    = false;
+    memset(&stats, 0, sizeof stats);
+
+    usart_init(USART_CR1_TE);
+    HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    HAL_GPIO_WritePin(SYNC_PORT, SYNC_PIN, GPIO_PIN_RESET);
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin   = SYNC_PIN;
+    gpio.Mode  = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull  = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(SYNC_PORT, &gpio);
+    return true;
+}
+
+void link_shutdown(void)
+{
+    usart_stop();
+    HAL_NVIC_DisableIRQ(DMA2_Stream7_IRQn);
+    sending = false;
+    shadow = tx = NULL;                  /* scene pool */
+}
+
+/* one node's frame at p: a delta against the shadow, raw when that is no
+ * shorter (or a key frame is due); the shadow becomes cur */
+static uint8_t *encode_node(uint8_t *p, const uint8_t *cur, uint8_t *sh, uint32_t n, bool raw)
+{
+    uint8_t *start = p;
+    uint8_t *limit = p + 1 + n;                   /* raw size without the 'E' */
+    if (!raw) {
+        *p++ = STREAM_FRAME_DELTA;
+        uint32_t i = 0;
+        while (i < n && !raw) {
+            uint32_t j = i + 1;
+            if (cur[i] == sh[i]) {
+                while (j < n && j - i < 128 && cur[j] == sh[j]) ++j;
+                *p++ = (uint8_t)(STREAM_DELTA_SKIP - 1u + (j - i));
+            } else {
+                while (j < n && j - i < 128 && cur[j] != sh[j]) ++j;
+                if (p + 1 + (j - i) >= limit) {
+                    raw = true;
+                    break;
+                }
+                *p++ = (uint8_t)(j - i - 1u);
+                for (uint32_t k = i; k < j; ++k) *p++ = cur[k] ^ sh[k];
+            }
+            i = j;
+        }
+        if (p >= limit) raw = true;
+    }
+    if (raw) {
+        p = start;
+        *p++ = STREAM_FRAME_RAW;
+        memcpy(p, cur, n);
+        p += n;
+    }
+    *p++ = STREAM_FRAME_END;
+    memcpy(sh, cur, n);
+    return p;
+}
+
+void link_submit(const uint8_t *rgb, uint8_t brightness)
+{
+    if (!tx) return;
+    if (sending || sent) {                        /* the last frame is not latched yet */
+        ++stats.dropped;
+        return;
+    }
+    bool raw = key_in == 0;
+    key_in   = raw ? LINK_KEY_FRAMES - 1 : key_in - 1;
+
+    uint8_t *p     = tx;
+    uint32_t first = 0;
+    for (uint8_t i = 0; i < NODES; ++i) {
+        uint32_t n   = 3u * nodes[i];
+        uint8_t *hdr = p;
+        p = encode_node(hdr + LINK_HDR, rgb + first, shadow + first, n, raw);
+        uint16_t len = (uint16_t)(p - hdr - LINK_HDR);
+        hdr[0] = LINK_SOF;
+        hdr[1] = i;
+        hdr[2] = brightness;
+        hdr[3] = (uint8_t)len;
+        hdr[4] = (uint8_t)(len >> 8);
+        first += n;
+    }
+    uint32_t total = (uint32_t)(p - tx);
+    stats.bytes += total;
+
+    sending = true;
+    DMA2->HIFCR = DMA_FLAGS << 22;                /* stream 7 */
+    LINK_DMA_TX->PAR  = (uint32_t)&USART1->DR;
+    LINK_DMA_TX->M0AR = (uint32_t)tx;
+    LINK_DMA_TX->NDTR = total;
+    LINK_DMA_TX->FCR  = 0;                        /* direct mode */
+    LINK_DMA_TX->CR   = LINK_DMA_CHSEL
+                      | DMA_SxCR_DIR_0            /* memory → peripheral */
+                      | DMA_SxCR_MINC
+                      | DMA_SxCR_PL_0             /* medium, below the strips */
+                      | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    LINK_DMA_TX->CR  |= DMA_SxCR_EN;
+}
+
+void DMA2_Stream7_IRQHandler(void)
+{
+    uint32_t isr = DMA2->HISR;
+    DMA2->HIFCR = DMA_FLAGS << 22;
+    if (isr & (DMA_HISR_TEIF7 | DMA_HISR_DMEIF7)) ++stats.errors;
+    if (isr & (DMA_HISR_TCIF7 | DMA_HISR_TEIF7)) {
+        sending = false;
+        sent    = !(isr & DMA_HISR_TEIF7);
+    }
+}
+
+bool link_tick(void)
+{
+    /* the last byte may still be in the shift register: it is in before the
+     * node's main loop gets to it, latch */
+    if (sent) {
+        HAL_GPIO_TogglePin(SYNC_PORT, SYNC_PIN);
+        sent = false;
+        ++stats.frames;
+    }
+    return false;
+}
+
+void link_poll(void) { }
+
+#else /* LED_LINK_SLAVE */
+/* ─────────────────────────────────────────────────────────────────────────
+ * Node: circular DMA into the ring, decoded by the main loop
+ */
+typedef enum {
+    RX_SOF,
+    RX_HDR,
+    RX_TYPE,                /* 'F' or 'D' */
+    RX_RAW,
+    RX_TOKEN,
+    RX_XOR,                 /* literal bytes of a token */
+    RX_TRAILER,             /* 'E' */
+    RX_SKIP,                /* another node's packet */
+} RxState;
+
+static uint8_t          *ring;
+static uint32_t          ring_tail;
+static RxState           rx_st;
+static uint8_t           hdr[LINK_HDR - 1];
+static uint8_t           hdr_n;
+static uint16_t          len;           /* packet bytes left */
+static uint8_t          *fb;
+static uint32_t          fb_len;
+static uint32_t          got, run;
+static bool              delta, base;
+static bool              ready;         /* a whole frame in fb, waiting for the edge */
+static uint8_t           bright;
+static volatile uint32_t edges;         /* EXTI */
+static uint32_t          edges_seen;
+
+bool link_init(uint16_t total_pixels)
+{
+    link_shutdown();
+    ring = scene_alloc("link ring", LINK_RX_RING);
+    if (!ring || !total_pixels) {
+        link_shutdown();
+        return false;
+    }
+    fb_len     = 3u * total_pixels;
+    fb         = NULL;
+    ring_tail  = 0;
+    rx_st      = RX_SOF;
+    ready      = false;
+    base       = false;
+    edges_seen = edges;
+    memset(&stats, 0, sizeof stats);
+
+    usart_init(USART_CR1_RE);
+    DMA2->LIFCR = DMA_FLAGS << 16;                /* stream 2 */
+    LINK_DMA_RX->PAR  = (uint32_t)&USART1->DR;
+    LINK_DMA_RX->M0AR = (uint32_t)ring;
+    LINK_DMA_RX->NDTR = LINK_RX_RING;
+    LINK_DMA_RX->FCR  = 0;
+    LINK_DMA_RX->CR   = LINK_DMA_CHSEL
+                      | DMA_SxCR_MINC | DMA_SxCR_CIRC
+                      | DMA_SxCR_PL_0;            /* peripheral → memory */
+    LINK_DMA_RX->CR  |= DMA_SxCR_EN;
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin  = SYNC_PIN;
+    gpio.Mode = GPIO_MODE_IT_RISING_FALLING;
+    gpio.Pull = GPIO_PULLDOWN;
+    HAL_GPIO_Init(SYNC_PORT, &gpio);
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+    return true;
+}
+
+void link_shutdown(void)
+{
+    HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+    usart_stop();
+    ring = NULL;                         /* scene pool, the DMA stopped above */
+}
+
+void EXTI15_10_IRQHandler(void)
+{
+    if (EXTI->PR & SYNC_PIN) {
+        EXTI->PR = SYNC_PIN;
+        ++edges;
+    }
+}
+
+static void torn(void)
+{
+    ++stats.torn;
+    if (rx_st != RX_SKIP && rx_st != RX_HDR && rx_st != RX_TYPE) base = false;   /* fb half written */
+    rx_st = RX_SOF;
+}
+
+/* one byte of the link stream; false once a frame is ready (stop there) */
+static bool rx_byte(uint8_t c)
+{
+    switch (rx_st) {
+    case RX_SOF:
+        if (c == LINK_SOF) {
+            hdr_n = 0;
+            rx_st = RX_HDR;
+        }
+        break;
+    case RX_HDR:
+        hdr[hdr_n++] = c;
+        if (hdr_n < sizeof hdr) break;
+        len = (uint16_t)(hdr[2] | hdr[3] << 8);
+        if (!len) {
+            torn();
+        } else if (hdr[0] != LED_LINK_NODE) {
+            rx_st = RX_SKIP;
+        } else {
+            bright = hdr[1];
+            rx_st  = RX_TYPE;
+        }
+        break;
+    case RX_SKIP:
+        if (--len == 0) rx_st = RX_SOF;
+        break;
+    default:
+        /* own packet: every byte counts against len, the 'E' is the last */
+        if (len-- == 0) {
+            torn();
+            break;
+        }
+        stats.bytes++;
+        switch (rx_st) {
+        case RX_TYPE: {
+            rgb_8b *back = render_acquire_back();
+            if (!back || (c != STREAM_FRAME_RAW && c != STREAM_FRAME_DELTA)) {
+                torn();
+                break;
+            }
+            fb    = (uint8_t *)back;
+            delta = c == STREAM_FRAME_DELTA;
+            got   = 0;
+            run   = 0;
+            rx_st = delta ? RX_TOKEN : RX_RAW;
+            break;
+        }
+        case RX_RAW:
+            fb[got++] = c;
+            if (got >= fb_len) rx_st = RX_TRAILER;
+            break;
+        case RX_TOKEN: {
+            uint32_t span = (c & (STREAM_DELTA_SKIP - 1u)) + 1u;
+            if (span > fb_len - got) {
+                torn();
+                break;
+            }
+            if (c & STREAM_DELTA_SKIP) got += span;
+            else {
+                run   = span;
+                rx_st = RX_XOR;
+            }
+            if (got >= fb_len) rx_st = RX_TRAILER;
+            break;
+        }
+        case RX_XOR:
+            if (base) fb[got] ^= c;               /* no base: read through, thrown away */
+            ++got;
+            if (--run == 0) rx_st = (got >= fb_len) ? RX_TRAILER : RX_TOKEN;
+            break;
+        case RX_TRAILER:
+            if (c != STREAM_FRAME_END || len != 0) {
+                torn();
+                break;
+            }
+            rx_st = RX_SOF;
+            if (delta && !base) {
+                ++stats.no_base;
+                break;
+            }
+            base  = true;
+            ready = true;
+            return false;
+        default:
+            torn();
+            break;
+        }
+        break;
+    }
+    return true;
+}
+
+bool link_tick(void)
+{
+    return true;                                  /* the master draws */
+}
+
+void link_poll(void)
+{
+    if (!ring) return;
+    if (USART1->SR & (USART_SR_ORE | USART_SR_FE | USART_SR_NE)) {
+        (void)USART1->DR;                         /* clears them */
+        ++stats.errors;
+    }
+
+    uint32_t head = (LINK_RX_RING - LINK_DMA_RX->NDTR) & (LINK_RX_RING - 1u);
+    while (!ready && ring_tail != head) {
+        uint8_t c = ring[ring_tail];
+        ring_tail = (ring_tail + 1u) & (LINK_RX_RING - 1u);
+        rx_byte(c);
+    }
+
+    uint32_t e = edges;
+    if (e == edges_seen) return;
+    edges_seen = e;
+    if (!ready) {
+        ++stats.dropped;                          /* nothing new: the old frame stays */
+        return;
+    }
+    g_global_brightness = bright;
+    render_mark_dirty(0, (uint16_t)(fb_len / 3u));
+    render_submit();
+    ready = false;
+    ++stats.frames;
+}
+
+#endif /* LED_LINK_MASTER */
+
+const LinkStats *link_stats(void)
+{
+    return &stats;
+}
+
+#endif /* LED_LINK_MASTER || LED_LINK_SLAVE */
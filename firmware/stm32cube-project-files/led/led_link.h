@@ -0,0 +1,135 @@
+/*
+ * led_link.h – board-to-board link: one MCU animates, several drive LEDs
+ *
+ * LED_LINK_MASTER runs the geometry and the animations for the whole build
+ * and drives no strips itself: render_submit() hands the frame to the link,
+ * which sends every node its LED range (LED_LINK_NODES, wiring order) over
+ * USART1 TX (PA9, DMA2 stream 7) in one transfer. All node RX pins hang on
+ * that one line. Per node:
+ *
+ *   LINK_SOF | node u8 | brightness u8 | len u16 (little endian) | frame[len]
+ *
+ * frame is a led_stream.h frame, 'F' | rgb | 'E' or 'D' | tokens | 'E'
+ * against what the node shows, whichever is shorter; every LINK_KEY_FRAMES
+ * frames a raw one, so a node that lost one is back without a way to ask.
+ *
+ * The frame sent during one frame clock slot is latched at the next tick:
+ * the master toggles PB12, every node's EXTI sees the edge and submits what
+ * it decoded, so all of them start within a main loop pass of each other.
+ *
+ * LED_LINK_SLAVE (node LED_LINK_NODE) receives on USART1 RX (PA10, DMA2
+ * stream 2, circular), decodes its own range straight into the framebuffer
+ * and skips everything else. Its LED count is its own scene's, the master's
+ * entry for it must match. The animations do not run on a node.
+ */
+
+#ifndef _LED_LINK_H_
+#define _LED_LINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(LED_LINK_MASTER) && defined(LED_LINK_SLAVE)
+  #error "LED_LINK_MASTER and LED_LINK_SLAVE: one or the other"
+#endif
+#if defined(LED_LINK_MASTER) && (defined(LED_RENDER_STREAM) || defined(LED_OUTPUT_GPIO) || \
+    defined(LED_OUTPUT_APA102) || defined(LED_SKIP_RANGES) || defined(LED_RENDER_LOGICAL))
+  #error "LED_LINK_MASTER drives no strips: output options belong to the nodes, LED_RENDER_LOGICAL would send logical order"
+#endif
+#if defined(LED_LINK_SLAVE) && defined(LED_OUTPUT_GPIO)
+  #error "LED_LINK_SLAVE receives on DMA2 stream 2, LED_OUTPUT_GPIO uses it"
+#endif
+#if defined(LED_LINK_SLAVE) && (defined(LED_RENDER_PIPELINE) || defined(LED_RENDER_STREAM))
+  #error "LED_LINK_SLAVE applies deltas to the framebuffer in place, no LED_RENDER_PIPELINE / LED_RENDER_STREAM"
+#endif
+#if defined(LED_LINK_SLAVE) && defined(LED_RENDER_LOGICAL)
+  #error "LED_LINK_SLAVE decodes in wiring order, no LED_RENDER_LOGICAL"
+#endif
+#if defined(LED_LINK_MASTER) && !defined(LED_LINK_NODES)
+  #error "LED_LINK_MASTER needs LED_LINK_NODES { LEDs of node 0, node 1, ... }"
+#endif
+
+/* USART1 bit rate: 84 MHz / 16 at most; ~525 kB/s, a raw 720 LED node takes
+ * 4 ms, a delta a fraction of it */
+#ifndef LED_LINK_BAUD
+  #define LED_LINK_BAUD         5250000UL
+#endif
+
+#ifndef LED_LINK_NODE
+  #define LED_LINK_NODE         0
+#endif
+
+/* a raw frame to every node this often */
+#ifndef LINK_KEY_FRAMES
+  #define LINK_KEY_FRAMES       30
+#endif
+
+/* node receive ring (power of two), bytes the main loop may fall behind */
+#ifndef LINK_RX_RING
+  #define LINK_RX_RING          4096
+#endif
+
+#define LINK_SOF                0xA5
+#define LINK_HDR                5u
+
+typedef struct {
+    uint32_t frames;        /* latched                                              */
+    uint32_t bytes;         /* master: sent; node: its own packets                  */
+    uint32_t dropped;       /* master: link still busy at submit; node: latch, nothing decoded */
+    uint32_t torn;          /* node: bad packet, thrown away                        */
+    uint32_t no_base;       /* node: 'D' frame without the one before it            */
+    uint32_t errors;        /* DMA / USART errors                                   */
+} LinkStats;
+
+#if defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE)
+
+/**
+ * Set up USART1, its DMA and PB12 (init_render does it)
+ * @param total_pixels  master: must be the sum of LED_LINK_NODES;
+ *                      node: its own LED count
+ * @return false: counts do not match or no RAM
+ */
+bool link_init(uint16_t total_pixels);
+
+/**
+ * Stop the transfers, drop the buffers (led_render_shutdown)
+ */
+void link_shutdown(void);
+
+/**
+ * Master: send a frame (render_submit), dropped while the last one is
+ * still on the wire
+ */
+void link_submit(const uint8_t *rgb, uint8_t brightness);
+
+/**
+ * Per frame tick, before anything draws. Master: latch the frame sent in
+ * the last slot.
+ * @return true on a node: the master draws, skip the animations
+ */
+bool link_tick(void);
+
+/**
+ * Every main loop pass. Node: decode what came in, submit it on the edge.
+ */
+void link_poll(void);
+
+const LinkStats *link_stats(void);
+
+#else
+
+#define link_tick()             (false)
+#define link_poll()             ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_LINK_H_ */
@@ -7,36 +7,71 @@
 #include <stdlib.h>
 #include <string.h>
 #include "polyhedron.h"
+#include "scene_mem.h"
+#include "fast_math.h"
 #include "config.h"
+#ifdef LED_RENDER_LOGICAL
+#include "led_render.h"  /* render_set_remap */
+#endif
+#ifdef LED_MAP_STORE
+#include "flash_store.h"
+#endif
 
 
 #if defined(LED_DEBUG_MAPPING) || defined(LED_DEBUG_MAPPING_HEAP)
-#include "usb_comms.h"   /* USBD_UsrLog */
+#include "dlog.h"        /* DLOG */
 #endif
 
 /* ─────────────────────────────────────────────────────────────────────────
- * DYNAMIC ARRAYS (allocated once per polyhedron)
+ * DYNAMIC ARRAYS (once per polyhedron, in the scene pool)
  */
-static uint8_t *leds_per_edge = NULL;   /* len = E */
-static uint8_t *edge_map      = NULL;   /* len = E */
+static uint8_t *leds_per_edge = NULL;   /* len = E, logical: LEDs of the block it is on */
+static uint8_t *block_leds    = NULL;   /* len = E, LEDs of physical block p (wire order) */
+static poly_idx_t *edge_map   = NULL;   /* len = E */
 static bool    *flip_map      = NULL;   /* len = E */
-static struct PixelMapping *pixel_map = NULL; /* len = total_pixels */
+static uint16_t *edge_base     = NULL;   /* len = E + 1, prefix sum of leds_per_edge */
+static uint16_t *block_base    = NULL;   /* len = E + 1, prefix sum of block_leds */
+static uint16_t *pixel_map     = NULL;   /* len = total_pixels, logical → phys */
+#ifdef LED_RENDER_LOGICAL
+static uint16_t *pixel_inv     = NULL;   /* len = total_pixels, phys → logical, for the encoder */
+#endif
 
 static EdgeLedInfo         *edge_info    = NULL;   /* len = E */
 
+static LedPos   *led_pos       = NULL;   /* len = total_pixels, indexed like the framebuffer */
+static LedAttr  *led_attr      = NULL;   /* len = total_pixels, same index */
+static FaceFrame *face_frame   = NULL;   /* len = F, follows led_pos */
+static const Polyhedron *geo   = NULL;   /* geometry led_pos follows */
+
+/* topology CSR, see EdgeRef */
+static uint16_t *face_off      = NULL;   /* len = F + 1 */
+static EdgeRef  *face_ref      = NULL;   /* len = sum of face vertex counts */
+static EdgeRef  *vert_ref      = NULL;   /* len = 2 * E, offsets = poly v2e_off */
+
 static uint16_t pixels_total = 0;       /* cached total LED count */
-static uint8_t  edge_cnt     = 0;       /* cached p->E */
+static uint32_t map_generation = 0;     /* bumped on every rebuild / patch */
+static uint32_t layout_generation = 0;  /* bumped when edges / their LED counts move */
+static uint32_t geo_gen        = 0;     /* geo->gen led_pos was built for */
+static poly_idx_t edge_cnt     = 0;     /* cached p->E */
 
 /* ─────────────────────────────────────────────────────────────────────────
  * PRIVATE FORWARD DECLARATIONS
  *
  */
-static void  compute_leds_per_edge(const Polyhedron *p);
-static bool  alloc_core_arrays(uint8_t E);
+static bool  compute_leds_per_edge(const Polyhedron *p);
+static bool  alloc_core_arrays(poly_idx_t E);
 static void  free_core_arrays(void);
-static size_t bytes_free_heap(void);
 
+static void  build_edge_base(void);
+static bool  layout_changed(void);
+static bool  build_layout(void);
+static void  build_edge_pixels(poly_idx_t logical);
+static void  build_edge_info(poly_idx_t e);
 static void  build_edge_index_map(void);
+static void  build_edge_pos(poly_idx_t e);
+static void  build_face_frames(void);
+static bool  build_topology(const Polyhedron *p);
+static void  fill_topology(void);
 static void mapping_build_pixel_map(void);
 static void debug_print_mapping_heap(void);
 
@@ -44,120 +79,535 @@ static void debug_print_mapping_heap(void);
  * PUBLIC  API
  */
 bool init_mapping(const Polyhedron           *p,
-                  const uint8_t              *user_map,
+                  const poly_idx_t           *user_map,
                   const bool                 *user_flip,
-                  uint8_t                     user_len)
+                  poly_idx_t                  user_len)
 {
-    /* 0) tear down any previous buffers */
+    /* 0) drop any previous buffers (scene_load() emptied the pool) */
     free_core_arrays();
 
 
     /* 1) calculate expected sizes */
     edge_cnt = p->E;
+    geo      = p;
 
     /* allocate leds_per_edge / edge_map / flip_map */
     if (!alloc_core_arrays(edge_cnt)) return false;
 
-    /* 2) compute LED count per edge */
-    compute_leds_per_edge(p);
+    /* 2) compute LED count per block, offsets once */
+    if (!compute_leds_per_edge(p)) {
+        free_core_arrays();
+        return false;
+    }
+    memcpy(leds_per_edge, block_leds, edge_cnt);   /* update_mappings() follows edge_map */
+    build_edge_base();
 
     /* initialize remap / flip arrays */
-    for (uint8_t i = 0; i < edge_cnt; ++i) {
+    for (poly_idx_t i = 0; i < edge_cnt; ++i) {
         edge_map[i] = i;
         flip_map[i] = false;
     }
     if (user_map && user_flip && user_len == edge_cnt) {
-        memcpy(edge_map, user_map,  edge_cnt);
+        memcpy(edge_map, user_map,  edge_cnt * sizeof *edge_map);
         memcpy(flip_map, user_flip, edge_cnt);
     }
 
     /* 3) allocate pixel_map */
     size_t px_bytes = sizeof *pixel_map * pixels_total;
-    pixel_map = malloc(px_bytes);
-    if (!pixel_map) {
+    pixel_map = scene_alloc("pixel_map", px_bytes);
+#ifdef LED_RENDER_LOGICAL
+    pixel_inv = scene_alloc("pixel_inv", px_bytes);
+    if (!pixel_inv) {
+        free_core_arrays();
+        return false;
+    }
+#endif
+    led_pos   = scene_alloc("led_pos",  sizeof *led_pos * pixels_total);
+    led_attr  = scene_alloc("led_attr", sizeof *led_attr * pixels_total);
+    face_frame = scene_alloc("face_frame", sizeof *face_frame * p->F);
+    if (!pixel_map || !led_pos || !led_attr || !face_frame || !build_topology(p)) {
         free_core_arrays();
         return false;
     }
 
+    geo_gen = p->gen;                        /* update_mappings() builds led_pos */
+    layout_generation++;
+    build_face_frames();
     update_mappings();
     debug_print_mapping_heap();
     return true;
 }
 
+void mapping_shutdown(void)
+{
+    free_core_arrays();
+    edge_cnt     = 0;
+    pixels_total = 0;
+    geo          = NULL;
+    map_generation++;          /* caches built on the old geometry are stale */
+    layout_generation++;
+}
+
 
 
 void update_mappings(void){
+    if (build_layout()) {                    /* logical ranges moved */
+        fill_topology();
+        layout_generation++;
+    }
     mapping_build_pixel_map();
     build_edge_index_map();
+    for (poly_idx_t e = 0; e < edge_cnt; ++e)
+        build_edge_pos(e);
+    map_generation++;
+#ifdef LED_RENDER_LOGICAL
+    render_set_remap(pixel_map, pixel_inv);
+#endif
 }
 
 
 uint16_t 					 mapping_get_total_pixels(void)     { return pixels_total; }
-const struct PixelMapping 	*mapping_get_map(void)      		{ return pixel_map;    }
+const uint16_t 	 			*mapping_get_map(void)      		{ return pixel_map;    }
+const uint16_t 	 			*mapping_get_edge_base(void)      	{ return edge_base;    }
+poly_idx_t 					 mapping_get_edge_count(void)       { return edge_cnt;     }
 const uint8_t 				*mapping_get_leds_per_edge(void)    { return leds_per_edge;}
-uint8_t       				*mapping_edit_edge_map(void)        { return edge_map;     }
+poly_idx_t    				*mapping_edit_edge_map(void)        { return edge_map;     }
 bool          				*mapping_edit_flip_map(void)        { return flip_map;     }
 
 const EdgeLedInfo 			*mapping_get_edge_info(void) 		{return edge_info; }
+/* vertices moved since led_pos was built (poly_rotate, poly_orient_*, ...)? */
+static inline void sync_geometry(void)
+{
+    if (geo && led_pos && geo->gen != geo_gen) mapping_refresh_geometry();
+}
+
+const LedPos 				*mapping_get_led_pos(void) 			{sync_geometry(); return led_pos;   }
+const LedAttr 				*mapping_get_led_attr(void) 		{sync_geometry(); return led_attr;  }
+
+void mapping_led_faces(uint16_t px, poly_idx_t out[2])
+{
+    out[0] = out[1] = POLY_IDX_NONE;
+    if (!led_attr || px >= pixels_total) return;
+    poly_edge_faces(geo, led_attr[px].edge, out);
+}
+
+const FaceFrame *mapping_face_frame(poly_idx_t f)
+{
+    if (!face_frame || f >= geo->F) return NULL;
+    sync_geometry();
+    return &face_frame[f];
+}
+
+const EdgeRef *mapping_face_edges(poly_idx_t f, uint8_t *n)
+{
+    if (!face_off || f >= geo->F) { *n = 0; return NULL; }
+    *n = (uint8_t)(face_off[f + 1] - face_off[f]);
+    return &face_ref[face_off[f]];
+}
+
+const EdgeRef *mapping_vertex_edges(poly_idx_t v, uint8_t *n)
+{
+    if (!vert_ref || v >= geo->V) { *n = 0; return NULL; }
+    *n = (uint8_t)(geo->v2e_off[v + 1] - geo->v2e_off[v]);
+    return &vert_ref[geo->v2e_off[v]];
+}
+
+void mapping_refresh_geometry(void)
+{
+    if (!led_pos) return;
+    geo_gen = geo->gen;
+    build_face_frames();
+    for (poly_idx_t e = 0; e < edge_cnt; ++e)
+        build_edge_pos(e);
+    map_generation++;
+}
 
 /* ─────────────────────────────────────────────────────────────────────────
- * BUILD PIXEL_MAP (call after any remap change)
+ * PREFIX SUMS: physical blocks are fixed by the wiring, logical edges take
+ * the count of the block they are mapped to (equal on uniform builds, so the
+ * logical layout only moves with LED_EDGE_LEDS)
  */
+static void build_edge_base(void)
+{
+    uint16_t sum = 0, blk = 0;
+    for (poly_idx_t e = 0; e < edge_cnt; ++e) {
+        edge_base[e]  = sum;
+        block_base[e] = blk;
+        sum += leds_per_edge[e];
+        blk += block_leds[e];
+    }
+    edge_base[edge_cnt]  = sum;
+    block_base[edge_cnt] = blk;
+}
+
+/* Counts only follow edge_map once it is a permutation again (they add up),
+ * mapping_assign() passes through states that are not: the old layout stays
+ * and build_edge_pixels() clamps to the block meanwhile. */
+static bool layout_changed(void)
+{
+    uint16_t sum     = 0;
+    bool     changed = false;
+    for (poly_idx_t e = 0; e < edge_cnt; ++e) {
+        uint8_t n = block_leds[edge_map[e]];
+        sum     += n;
+        changed |= n != leds_per_edge[e];
+    }
+    return changed && sum == pixels_total;
+}
+
+static bool build_layout(void)
+{
+    if (!layout_changed()) return false;
+    for (poly_idx_t e = 0; e < edge_cnt; ++e)
+        leds_per_edge[e] = block_leds[edge_map[e]];
+    build_edge_base();
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * BUILD PIXEL_MAP (call after any remap change), O(pixels)
+ * Logical edge e owns pixel_map[edge_base[e] .. edge_base[e+1]), so every
+ * edge can be rebuilt on its own (see PATCHING below).
+ */
+static void build_edge_pixels(poly_idx_t logical)
+{
+    uint16_t *out     = &pixel_map[edge_base[logical]];
+    uint8_t   led_cnt = leds_per_edge[logical];
+    uint8_t   blk_cnt = block_leds[edge_map[logical]];
+    uint16_t  base    = block_base[edge_map[logical]];
+
+    if (led_cnt > blk_cnt) led_cnt = blk_cnt;        /* see layout_changed() */
+    if (flip_map[logical]) {
+        for (uint16_t phys = base + led_cnt; phys-- > base; ) *out++ = phys;
+    } else {
+        for (uint16_t phys = base; phys < base + led_cnt; ++phys) *out++ = phys;
+    }
+    for (uint8_t i = led_cnt; i < leds_per_edge[logical]; ++i, ++out) *out = out[-1];
+#ifdef LED_RENDER_LOGICAL
+    for (uint16_t i = edge_base[logical]; i < edge_base[logical + 1]; ++i)
+        pixel_inv[pixel_map[i]] = i;
+#endif
+}
+
+static void build_edge_info(poly_idx_t e)
+{
+    uint16_t cnt = leds_per_edge[e];           // number of LEDs on edge e
+
+#ifdef LED_RENDER_LOGICAL
+    // framebuffer is in logical order, the encoder applies the remap
+    edge_info[e].start = edge_base[e];
+    edge_info[e].count = cnt;
+    edge_info[e].step  = +1;
+#else
+    // base index of the physical strip (block) this edge lives on
+    uint16_t base = block_base[edge_map[e]];
+    if (cnt > block_leds[edge_map[e]]) cnt = block_leds[edge_map[e]];   /* see layout_changed() */
+    bool     rev  = flip_map[e];               // true → traverse B→A
+
+    // pick the physical start index
+    uint16_t start = rev
+                   ? (uint16_t)(base + cnt - 1)  // last LED in this block
+                   : (uint16_t)(base);           // first LED
+
+    // signed step: +1 to go A→B, or -1 to go B→A
+    int8_t step = rev ? -1 : +1;
+
+    // write into edge_info[]
+    edge_info[e].start = start;
+    edge_info[e].count = cnt;
+    edge_info[e].step  = step;
+#endif
+}
+
 static void mapping_build_pixel_map(void)
 {
     if (!pixel_map || !leds_per_edge) return;
 
-    uint16_t px_idx = 0;
-    for (uint8_t logical = 0; logical < edge_cnt; ++logical) {
-        uint8_t led_cnt = leds_per_edge[logical];
-        uint8_t phys    = edge_map[logical];
-        bool    rev     = flip_map[logical];
-
-        uint16_t base = 0;
-        for (uint8_t i = 0; i < phys; ++i)
-            base += leds_per_edge[i];
-
-        for (uint8_t i = 0; i < led_cnt; ++i) {
-            uint16_t offset = rev ? (led_cnt - 1 - i) : i;
-            pixel_map[px_idx].edge = logical;
-            pixel_map[px_idx].phys = base + offset;
-            ++px_idx;
+    for (poly_idx_t logical = 0; logical < edge_cnt; ++logical)
+        build_edge_pixels(logical);
+}
+
+static void build_edge_index_map(void)
+{
+    // edge_cnt, leds_per_edge[], edge_map[], flip_map[], edge_base[] are already initialized
+    for (poly_idx_t e = 0; e < edge_cnt; ++e)
+        build_edge_info(e);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * LED POSITIONS: evenly spaced A→B along each edge, written where the
+ * animations address them (edge_info), so they follow remaps and flips.
+ * Vertices are on the unit sphere (poly_radial_normalize), Q1.14 fits.
+ * The attributes come along, the trig runs here once per LED and rebuild.
+ */
+static inline uint8_t unit8(float f)            /* 0..1 → 0..255, clamped */
+{
+    if (f <= 0.f) return 0;
+    if (f >= 1.f) return 255;
+    return (uint8_t)lrintf(f * 255.f);
+}
+
+static void build_led_attr(LedAttr *a, poly_idx_t e, float t, float x, float y, float z)
+{
+    float r = fm_sqrtf(x * x + y * y + z * z);
+    a->azim   = (uint8_t)(int32_t)lrintf(fm_atan2f(y, x) * (128.f / FM_PI));   /* wraps */
+    a->elev   = unit8(r > 0.f ? fm_asinf(z / r) / FM_PI + 0.5f : 0.5f);
+    a->radius = unit8(r);
+    a->t      = unit8(t);
+    a->edge   = e;
+}
+
+static inline float dist3(const float a[3], const float b[3])
+{
+    const float dx = b[0] - a[0], dy = b[1] - a[1], dz = b[2] - a[2];
+    return fm_sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+/* where edge e starts (at its winding's first end) and runs around face f,
+ * in turns: *at, *len; whether the face walks it B→A */
+static bool edge_on_face(poly_idx_t f, poly_idx_t e, float *at, float *len)
+{
+    const float inv = face_frame[f].perim > 0.f ? 1.f / face_frame[f].perim : 0.f;
+    float       run = 0.f;
+    for (uint16_t k = face_off[f]; k < face_off[f + 1]; ++k) {
+        const Edge *g = &geo->e[face_ref[k].edge];
+        const float l = dist3(geo->v[g->a], geo->v[g->b]) * inv;
+        if (face_ref[k].edge == e) {
+            *at  = run;
+            *len = l;
+            return face_ref[k].rev;
         }
+        run += l;
+    }
+    *at = *len = 0.f;
+    return false;
+}
+
+static void build_edge_pos(poly_idx_t e)
+{
+    const float      *A   = geo->v[geo->e[e].a];
+    const float      *B   = geo->v[geo->e[e].b];
+    const EdgeLedInfo inf = edge_info[e];
+
+    /* the LEDs' place around either face: at + t·len (B→A: from the B end) */
+    float at[2] = { 0.f, 0.f }, len[2] = { 0.f, 0.f };
+    bool  rev[2] = { false, false };
+    for (uint8_t k = 0; k < 2; ++k) {
+        const poly_idx_t f = geo->e2f[e][k];
+        if (f < geo->F) rev[k] = edge_on_face(f, e, &at[k], &len[k]);
     }
 
+    for (uint16_t i = 0; i < inf.count; ++i) {
+        float t = (inf.count > 1) ? (float)i / (inf.count - 1) : 0.f;
+        float x = A[0] + (B[0] - A[0]) * t;
+        float y = A[1] + (B[1] - A[1]) * t;
+        float z = A[2] + (B[2] - A[2]) * t;
+        uint16_t px  = (uint16_t)(inf.start + i * inf.step);
+        LedPos  *out = &led_pos[px];
+#ifdef LED_POS_Q14
+        out->x = (int16_t)lrintf(x * LED_POS_ONE);
+        out->y = (int16_t)lrintf(y * LED_POS_ONE);
+        out->z = (int16_t)lrintf(z * LED_POS_ONE);
+#else
+        *out = (LedPos){ x, y, z };
+#endif
+        build_led_attr(&led_attr[px], e, t, x, y, z);
+        for (uint8_t k = 0; k < 2; ++k) {
+            const float turn = at[k] + (rev[k] ? 1.f - t : t) * len[k];
+            led_attr[px].perim[k] = (uint8_t)(int32_t)lrintf(turn * 256.f);     /* wraps */
+        }
+    }
 }
 
-static void build_edge_index_map(void)
+/* centroid, normal, tangents and perimeter of every face (before the LED
+ * positions, which place themselves by the perimeters) */
+static void build_face_frames(void)
 {
-    // edge_cnt, leds_per_edge[], edge_map[], flip_map[] are already initialized
-    for (uint8_t e = 0; e < edge_cnt; ++e) {
-        // which physical strip (block) this edge lives on
-        uint8_t  phys_strip = edge_map[e];
+    for (poly_idx_t f = 0; f < geo->F; ++f) {
+        FaceFrame *fr = &face_frame[f];
+        poly_face_centroid(geo, f, fr->c);
+        poly_face_normal(geo, f, fr->n);
+
+        /* u: towards the first vertex, its part in the plane */
+        const float *v0 = geo->v[geo->f[f][0]], *n = fr->n;
+        float d[3] = { v0[0] - fr->c[0], v0[1] - fr->c[1], v0[2] - fr->c[2] };
+        const float dn = d[0] * n[0] + d[1] * n[1] + d[2] * n[2];
+        for (uint8_t k = 0; k < 3; ++k) d[k] -= dn * n[k];
+        const float inv = 1.f / fm_sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        for (uint8_t k = 0; k < 3; ++k) fr->u[k] = d[k] * inv;
+        fr->v[0] = n[1] * fr->u[2] - n[2] * fr->u[1];
+        fr->v[1] = n[2] * fr->u[0] - n[0] * fr->u[2];
+        fr->v[2] = n[0] * fr->u[1] - n[1] * fr->u[0];
+
+        fr->perim = 0.f;
+        for (uint8_t i = 0; i < geo->fv[f]; ++i)
+            fr->perim += dist3(geo->v[geo->f[f][i]], geo->v[geo->f[f][(i + 1) % geo->fv[f]]]);
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * TOPOLOGY CSR (geometry only, logical ranges: no rebuild on remaps)
+ */
+static EdgeRef edge_ref(poly_idx_t e, bool rev)
+{
+    return (EdgeRef){ edge_base[e], leds_per_edge[e], e, rev };
+}
 
-        // compute base index = sum of LEDs in all earlier strips
-        uint16_t base = 0;
-        for (uint8_t s = 0; s < phys_strip; ++s) {
-            base += leds_per_edge[s];
+static bool build_topology(const Polyhedron *p)
+{
+    uint16_t slots = 0;
+    for (poly_idx_t f = 0; f < p->F; ++f) slots += p->fv[f];
+
+    face_off = scene_alloc("face_off", (p->F + 1) * sizeof *face_off);
+    face_ref = scene_alloc("face_ref", slots      * sizeof *face_ref);
+    vert_ref = scene_alloc("vert_ref", 2u * p->E  * sizeof *vert_ref);
+    if (!face_off || !face_ref || !vert_ref) return false;
+
+    /* faces: slot i is f[i] → f[i+1], edges are stored a < b */
+    uint16_t k = 0;
+    for (poly_idx_t f = 0; f < p->F; ++f) {
+        face_off[f] = k;
+        for (uint8_t i = 0; i < p->fv[f]; ++i) {
+            poly_idx_t v0 = p->f[f][i];
+            poly_idx_t v1 = p->f[f][(i + 1) % p->fv[f]];
+            poly_idx_t e  = poly_find_edge(p, v0, v1);
+            if (e >= p->E) return false;
+            face_ref[k++] = edge_ref(e, p->e[e].a != v0);
         }
+    }
+    face_off[p->F] = k;
 
-        uint16_t cnt = leds_per_edge[e];       // number of LEDs on edge e
-        bool     rev = flip_map[e];            // true → traverse B→A
+    /* vertices: same layout as the polyhedron's v2e */
+    for (poly_idx_t v = 0; v < p->V; ++v) {
+        for (uint16_t i = p->v2e_off[v]; i < p->v2e_off[v + 1]; ++i) {
+            poly_idx_t e = p->v2e[i];
+            vert_ref[i] = edge_ref(e, p->e[e].b == v);        /* rev: ends at v */
+        }
+    }
+    return true;
+}
 
-        // pick the physical start index
-        uint16_t start = rev
-                       ? (uint16_t)(base + cnt - 1)  // last LED in this block
-                       : (uint16_t)(base);           // first LED
+/* logical ranges moved (build_layout), edges and directions stay */
+static void fill_topology(void)
+{
+    for (uint16_t k = 0; k < face_off[geo->F]; ++k)
+        face_ref[k] = edge_ref(face_ref[k].edge, face_ref[k].rev);
+    for (uint16_t i = 0; i < 2u * edge_cnt; ++i)
+        vert_ref[i] = edge_ref(vert_ref[i].edge, vert_ref[i].rev);
+}
 
-        // signed step: +1 to go A→B, or -1 to go B→A
-        int8_t step = rev ? -1 : +1;
+/* ─────────────────────────────────────────────────────────────────────────
+ * PATCHING: one edge at a time, O(LEDs of that edge). Moving an edge onto a
+ * block with another LED count shifts the logical ranges, that takes the
+ * full update_mappings().
+ */
+static void patch_edge(poly_idx_t e)
+{
+    build_edge_pixels(e);
+    build_edge_info(e);
+#ifndef LED_RENDER_LOGICAL
+    build_edge_pos(e);             /* logical order: positions never move */
+#endif
+#ifdef LED_RENDER_LOGICAL
+    /* framebuffer did not change, only where it goes */
+    render_remap_patched(edge_base[e], leds_per_edge[e]);
+#endif
+}
 
-        // write into edge_info[]
-        edge_info[e].start = start;
-        edge_info[e].count = cnt;
-        edge_info[e].step  = step;
+bool mapping_swap_edges(poly_idx_t a, poly_idx_t b)
+{
+    if (!pixel_map || a >= edge_cnt || b >= edge_cnt) return false;
+    if (a == b) return true;
+
+    poly_idx_t tmp = edge_map[a];
+    edge_map[a] = edge_map[b];
+    edge_map[b] = tmp;
+    if (layout_changed()) {
+        update_mappings();
+        return true;
     }
+    patch_edge(a);
+    patch_edge(b);
+    map_generation++;
+    return true;
 }
 
+bool mapping_set_flip(poly_idx_t e, bool on)
+{
+    if (!pixel_map || e >= edge_cnt) return false;
+    if (flip_map[e] == on) return true;
+
+    flip_map[e] = on;
+    patch_edge(e);
+    map_generation++;
+    return true;
+}
+
+bool mapping_assign(poly_idx_t logical, poly_idx_t phys)
+{
+    if (!pixel_map || logical >= edge_cnt || phys >= edge_cnt) return false;
+    if (edge_map[logical] == phys) return true;
+
+    edge_map[logical] = phys;
+    if (layout_changed()) {
+        update_mappings();
+        return true;
+    }
+    patch_edge(logical);
+    map_generation++;
+    return true;
+}
+
+uint32_t mapping_generation(void)        { sync_geometry(); return map_generation; }
+uint32_t mapping_layout_generation(void) { return layout_generation; }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * FLASH PERSISTENCE, record = edge_map[E] (poly_idx_t, native byte order)
+ * then flip_map[E] (one byte each). A build with the other index width
+ * has another record length and doesn't read it.
+ */
+#ifdef LED_MAP_STORE
+#define MAP_REC_LEN(E)  ((uint32_t)(E) * (sizeof(poly_idx_t) + 1u))
+
+bool mapping_store_save(void)
+{
+    if (!pixel_map || MAP_REC_LEN(edge_cnt) > FLASH_STORE_MAX_LEN) return false;
+
+    uint8_t rec[FLASH_STORE_MAX_LEN];
+    uint8_t *flips = rec + edge_cnt * sizeof(poly_idx_t);
+    memcpy(rec, edge_map, edge_cnt * sizeof(poly_idx_t));
+    for (poly_idx_t e = 0; e < edge_cnt; ++e)
+        flips[e] = flip_map[e] ? 1 : 0;
+    return flash_store_put(STORE_KEY_MAPPING, rec, (uint16_t)MAP_REC_LEN(edge_cnt));
+}
+
+bool mapping_store_load(poly_idx_t *user_map, bool *user_flip, poly_idx_t len)
+{
+    uint8_t rec[FLASH_STORE_MAX_LEN];
+    if (MAP_REC_LEN(len) > FLASH_STORE_MAX_LEN
+        || !flash_store_get(STORE_KEY_MAPPING, rec, (uint16_t)MAP_REC_LEN(len))) return false;
+
+    /* every physical block exactly once, else keep the compiled-in map */
+    poly_idx_t     map[FLASH_STORE_MAX_LEN / (sizeof(poly_idx_t) + 1u)];
+    const uint8_t *flips = rec + len * sizeof(poly_idx_t);
+    uint8_t        seen[(POLY_MAX_E + 7) / 8] = { 0 };
+    memcpy(map, rec, len * sizeof(poly_idx_t));
+    for (poly_idx_t e = 0; e < len; ++e) {
+        poly_idx_t p = map[e];
+        if (p >= len || (seen[p >> 3] & (1u << (p & 7)))) return false;
+        seen[p >> 3] |= 1u << (p & 7);
+    }
+    for (poly_idx_t e = 0; e < len; ++e) {
+        user_map[e]  = map[e];
+        user_flip[e] = flips[e] != 0;
+    }
+    return true;
+}
+#else
+bool mapping_store_save(void)                          { return false; }
+bool mapping_store_load(poly_idx_t *m, bool *f, poly_idx_t l) { (void)m; (void)f; (void)l; return false; }
+#endif
+
 
 
 
@@ -166,75 +616,103 @@ static void build_edge_index_map(void)
 /* ─────────────────────────────────────────────────────────────────────────
  * INTERNAL HELPERS
  */
-static bool alloc_core_arrays(uint8_t E)
+static bool alloc_core_arrays(poly_idx_t E)
 {
-	leds_per_edge   = malloc(E * sizeof *leds_per_edge);
-	edge_map        = malloc(E * sizeof *edge_map);
-	flip_map        = malloc(E * sizeof *flip_map);
+	leds_per_edge   = scene_alloc("leds_per_edge", E * sizeof *leds_per_edge);
+	block_leds      = scene_alloc("block_leds",    E * sizeof *block_leds);
+	edge_map        = scene_alloc("edge_map",      E * sizeof *edge_map);
+	flip_map        = scene_alloc("flip_map",      E * sizeof *flip_map);
 
-	edge_info  	= malloc(E * sizeof *edge_info);
+	edge_info  	= scene_alloc("edge_info",     E * sizeof *edge_info);
+	edge_base       = scene_alloc("edge_base",     (E + 1) * sizeof *edge_base);
+	block_base      = scene_alloc("block_base",    (E + 1) * sizeof *block_base);
 
-    if (!leds_per_edge || !edge_map || !flip_map || !edge_info) {
+    if (!leds_per_edge || !block_leds || !edge_map || !flip_map || !edge_info
+        || !edge_base || !block_base) {
         free_core_arrays();
         return false;
     }
     return true;
 }
 /* ─────────────────────────────────────────────────────────────────────────
- *
+ * Pointers only, the scene pool is emptied as a whole (scene_mem_reset)
  */
 static void free_core_arrays(void)
 {
-	free(leds_per_edge);   	leds_per_edge   = NULL;
-	free(edge_map);        	edge_map        = NULL;
-	free(flip_map);        	flip_map        = NULL;
-
-	free(edge_info);  	edge_info  	= NULL;
+	leds_per_edge   = NULL;
+	block_leds      = NULL;
+	edge_map        = NULL;
+	flip_map        = NULL;
+
+	edge_info  	= NULL;
+	edge_base       = NULL;
+	block_base      = NULL;
+	pixel_map       = NULL;
+	led_pos         = NULL;
+	led_attr        = NULL;
+	face_frame      = NULL;
+	face_off        = NULL;
+	face_ref        = NULL;
+	vert_ref        = NULL;
+#ifdef LED_RENDER_LOGICAL
+	pixel_inv       = NULL;
+#endif
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
- *
+ * LEDs per physical block: LED_EDGE_LEDS if given (wire order), else block p
+ * gets edge p's share of LEDS_LONGEST_EDGE by length.
  */
-static void compute_leds_per_edge(const Polyhedron *p)
+static bool compute_leds_per_edge(const Polyhedron *p)
 {
+#ifdef LED_EDGE_LEDS
+    static const uint8_t counts[] = LED_EDGE_LEDS;
+    if (sizeof counts != p->E) return false;
+#endif
     /* longest edge */
-    double max_len = 0.0;
-    for (uint8_t e = 0; e < p->E; ++e) {
+    float max_len = 0.0f;
+    for (poly_idx_t e = 0; e < p->E; ++e) {
         const float *A = p->v[p->e[e].a];
         const float *B = p->v[p->e[e].b];
-        double dx = A[0] - B[0], dy = A[1] - B[1], dz = A[2] - B[2];
-        double len = sqrt(dx*dx + dy*dy + dz*dz);
+        float dx = A[0] - B[0], dy = A[1] - B[1], dz = A[2] - B[2];
+        float len = fm_sqrtf(dx*dx + dy*dy + dz*dz);
         if (len > max_len) max_len = len;
     }
 
     pixels_total = 0;
 
 #ifdef LED_DEBUG_MAPPING
-    USBD_UsrLog("\n ");
-    USBD_UsrLog("────[ compute_leds_per_edge ]────");
-    USBD_UsrLog("=================================");
-    USBD_UsrLog("   | edge   | length  | pixels |");
+    DLOG("\n ");
+    DLOG("────[ compute_leds_per_edge ]────");
+    DLOG("=================================");
+    DLOG("   | edge   | length  | pixels |");
 #endif
-    for (uint8_t e = 0; e < p->E; ++e) {
+    for (poly_idx_t e = 0; e < p->E; ++e) {
         const float *A = p->v[p->e[e].a];
         const float *B = p->v[p->e[e].b];
-        double dx = A[0] - B[0], dy = A[1] - B[1], dz = A[2] - B[2];
-        double len = sqrt(dx*dx + dy*dy + dz*dz);
-        double ratio = len / max_len;
-        uint8_t leds = (uint8_t)roundf(ratio * (double)LEDS_LONGEST_EDGE);
+        float dx = A[0] - B[0], dy = A[1] - B[1], dz = A[2] - B[2];
+        float len = fm_sqrtf(dx*dx + dy*dy + dz*dz);
+#ifdef LED_EDGE_LEDS
+        uint8_t leds = counts[e];
+        if (leds == 0) return false;               /* every block needs a LED */
+#else
+        float ratio = len / max_len;
+        uint8_t leds = (uint8_t)roundf(ratio * (float)LEDS_LONGEST_EDGE);
         if (leds == 0) leds = 1;
-        leds_per_edge[e] = leds;
+#endif
+        block_leds[e] = leds;
         pixels_total += leds;
 
 #ifdef LED_DEBUG_MAPPING
-        USBD_UsrLog("   | %-6u | %-7.2f | %-6u |", (unsigned)e, len, (unsigned)leds);
+        DLOG("   | %-6u | %-7.2f | %-6u |", (unsigned)e, len, (unsigned)leds);
 
 #endif
     }
 #ifdef LED_DEBUG_MAPPING
-    USBD_UsrLog("\n ");
-    USBD_UsrLog("   longest edge: length %-7.3f, pixels %-7u\n ", max_len, (unsigned)LEDS_LONGEST_EDGE);
+    DLOG("\n ");
+    DLOG("   longest edge: length %-7.3f, pixels %-7u\n ", max_len, (unsigned)LEDS_LONGEST_EDGE);
 #endif
+    return true;
 }
 
 
@@ -246,25 +724,32 @@ static void debug_print_mapping_heap(void)
 #if defined(LED_DEBUG_MAPPING_HEAP)
     size_t core_bytes = edge_cnt * (
           sizeof *leds_per_edge
+        + sizeof *block_leds
         + sizeof *edge_map
         + sizeof *flip_map
     );
     size_t edg_led_bytes = edge_cnt * (
           sizeof *edge_info
-    );
-    size_t px_bytes   = pixels_total * sizeof *pixel_map;
+    ) + (edge_cnt + 1) * (sizeof *edge_base + sizeof *block_base)
+      + (geo->F + 1) * sizeof *face_off
+      + (face_off[geo->F] + 2u * edge_cnt) * sizeof *face_ref
+      + geo->F * sizeof *face_frame;
+    size_t px_bytes   = pixels_total * (sizeof *pixel_map + sizeof *led_pos + sizeof *led_attr);
+#ifdef LED_RENDER_LOGICAL
+    px_bytes         += pixels_total * sizeof *pixel_inv;   /* + inverse */
+#endif
     size_t total_bytes= core_bytes + px_bytes + edg_led_bytes;
 
-    USBD_UsrLog(
+    DLOG(
         "\n ───[ LED-Mapping-Heap ]───\n"
         "==========================\n"
         "   %-5u pixels\n"
         "   %-5u edges\n"
         "   %-5.1f kB core\n"
     	"   %-5.1f kB edge to led\n"
-        "   %-5.1f kB pixel map\n"
+        "   %-5.1f kB pixel map + positions + attributes\n"
         "   %-5.1f kB total\n"
-        "   %-5.1f kB heap left\n "
+        "   %-5.1f kB scene pool left\n "
         ,
         (unsigned)pixels_total,
         (unsigned)edge_cnt,
@@ -272,17 +757,8 @@ static void debug_print_mapping_heap(void)
 		edg_led_bytes	  / 1024.0f,
         px_bytes          / 1024.0f,
         total_bytes       / 1024.0f,
-        bytes_free_heap() / 1024.0f
+        scene_mem_free()  / 1024.0f
     );
-}
-/* ─────────────────────────────────────────────────────────────────────────
- * INTERNAL HELPERS
- */
-extern char _estack;
-extern char _sbrk(int incr);
-static size_t bytes_free_heap(void) {
-    char *brk = (char*)_sbrk(0);
-    return (size_t) (&_estack - brk);
 #endif
 }
 
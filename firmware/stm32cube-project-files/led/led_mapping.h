@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "polyhedron.h"  // For Polyhedron and Edge definitions
+#include "config.h"      // LED_RENDER_LOGICAL
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,12 +18,71 @@ extern "C" {
 #endif
 
 /* --------------------------------------------------------------------------
- * PixelMapping
+ * LED_EDGE_LEDS { ... } (config.h) overrides the counts, one entry per
+ * physical block in wire order. A logical edge has as many LEDs as the block
+ * it is mapped to. Dark LEDs on the wire (spacers) are LED_SKIP_RANGES, the
+ * renderer's business, they are neither pixels nor counted here.
  * -------------------------------------------------------------------------- */
-typedef struct PixelMapping {
-    uint8_t  edge;    /* logical edge index */
-    uint16_t phys;    /* physical LED start index */
-} PixelMapping;
+
+/* --------------------------------------------------------------------------
+ * Pixel map: map[logical] = physical LED index (dense, 2 bytes per LED).
+ * Logical pixels run edge by edge, edge e owns
+ * [edge_base[e], edge_base[e+1]) – see mapping_get_edge_base().
+ *
+ * MAP_PX(pm, i) is the index to hand the pixel functions for logical pixel i:
+ * pm[i], or just i with LED_RENDER_LOGICAL (the framebuffer is in logical
+ * order then and EdgeLedInfo is {edge_base[e], count, +1}).
+ * -------------------------------------------------------------------------- */
+#ifdef LED_RENDER_LOGICAL
+#define MAP_PX(pm, i)  ((void)(pm), (uint16_t)(i))
+#else
+#define MAP_PX(pm, i)  ((pm)[i])
+#endif
+
+/* --------------------------------------------------------------------------
+ * LED position cache (mapping_get_led_pos), one entry per framebuffer index.
+ * float by default; LED_POS_Q14 stores Q1.14 (LED_POS_ONE == 1.0, vertices
+ * are on the unit sphere) at half the size, for integer distance math.
+ * LED_POS_F() reads a coordinate as float either way.
+ * -------------------------------------------------------------------------- */
+#ifdef LED_POS_Q14
+typedef struct { int16_t x, y, z; } LedPos;
+#define LED_POS_ONE    16384
+#define LED_POS_F(c)   ((float)(c) * (1.0f / LED_POS_ONE))
+#else
+typedef struct { float x, y, z; } LedPos;
+#define LED_POS_F(c)   (c)
+#endif
+
+/* --------------------------------------------------------------------------
+ * Static per-LED attributes (mapping_get_led_attr), indexed like LedPos and
+ * in LED space (the view does not turn them). Worked out with the positions,
+ * so animations read an angle or edge parameter instead of atan2 / sqrt /
+ * division per LED per frame. 0..255 scales, ready for the 256 entry
+ * palette and hue tables. Faces: the edge's two, mapping_led_faces().
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    uint8_t    azim;    // around z, atan2(y, x): 0 = +x, 64 = +y, 256 = full turn
+    uint8_t    elev;    // 0 at the -z pole, 128 on the equator, 255 at +z
+    uint8_t    radius;  // |pos| * 255, vertices (unit sphere) 255
+    uint8_t    t;       // along the edge, 0 at A .. 255 at B
+    uint8_t    perim[2];// around face k of mapping_led_faces() by length, 0 at
+                        // its first vertex, on with the winding, 256 = once round
+    poly_idx_t edge;    // logical edge it sits on
+} LedAttr;
+
+/* --------------------------------------------------------------------------
+ * Face frames (mapping_face_frame), one per face, rebuilt with the LED
+ * positions: centroid, unit normal (Newell, along the winding's right hand)
+ * and a tangent basis in the face's plane, u towards the face's first
+ * vertex and v = n × u, so u → v turns with the winding like perim[].
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    float c[3];         // centroid
+    float n[3];         // unit normal
+    float u[3], v[3];   // unit tangents, u · v = 0
+    float perim;        // perimeter length
+} FaceFrame;
 
 typedef struct {
     uint16_t 	start;  // physical index of the first LED on this edge
@@ -30,6 +90,20 @@ typedef struct {
     int8_t  	step;    // +1 or –1 direction to walk the LEDs
 } EdgeLedInfo;
 
+/* --------------------------------------------------------------------------
+ * Topology tables, built once at init_mapping (CSR: an offset array plus one
+ * flat EdgeRef array). Faces list their edges in winding order, vertices
+ * their incident edges. [first, first + count) is the edge's logical pixel
+ * range; rev = the face walks it B→A / the edge ends at the vertex.
+ * mapping_ref_span() turns one into a span for fill_pixels() & co.
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    uint16_t first;     /* logical index of the edge's first LED (A end) */
+    uint8_t    count;   /* LEDs on the edge                              */
+    poly_idx_t edge;    /* logical edge                                  */
+    bool     rev;       /* walked B→A                                    */
+} EdgeRef;
+
 /* --------------------------------------------------------------------------
  * Initialize and Shutdown Mapping
  * -------------------------------------------------------------------------- */
@@ -42,12 +116,12 @@ typedef struct {
  * Returns true on success, false on memory allocation failure.
  */
 bool init_mapping(const Polyhedron *p,
-                  const uint8_t    *user_map,
+                  const poly_idx_t *user_map,
                   const bool       *user_flip,
-                  uint8_t           user_len);
+                  poly_idx_t        user_len);
 
 /**
- * Shutdown mapping and free all allocated memory.
+ * Shutdown mapping, its arrays go with the scene pool (scene_mem.h).
  */
 void mapping_shutdown(void);
 
@@ -61,19 +135,32 @@ void mapping_shutdown(void);
 uint16_t mapping_get_total_pixels(void);
 
 /**
- * Get pointer to pixel_map array (length = mapping_get_total_pixels()).
+ * Get pointer to pixel_map array (length = mapping_get_total_pixels()),
+ * logical → physical LED index.
  */
-const PixelMapping *mapping_get_map(void);
+const uint16_t *mapping_get_map(void);
 
 /**
- * Get pointer to array of LEDs per edge (length = p->E).
+ * Prefix sum of leds_per_edge (length = p->E + 1, last entry = total).
+ * Logical pixels of edge e are [base[e], base[e+1]). With uniform counts the
+ * same offsets are the start of physical block e.
+ */
+const uint16_t *mapping_get_edge_base(void);
+
+/**
+ * Number of edges (p->E of the mapped polyhedron).
+ */
+poly_idx_t mapping_get_edge_count(void);
+
+/**
+ * Get pointer to array of LEDs per logical edge (length = p->E).
  */
 const uint8_t *mapping_get_leds_per_edge(void);
 
 /**
  * Get pointer to edge_map[] for in-place editing (length = p->E).
  */
-uint8_t *mapping_edit_edge_map(void);
+poly_idx_t *mapping_edit_edge_map(void);
 
 /**
  * Get pointer to flip_map[] for in-place editing (length = p->E).
@@ -84,12 +171,128 @@ bool *mapping_edit_flip_map(void);
 /** Returns a pointer to an array[poly.E] of EdgeLedInfo */
 const EdgeLedInfo *mapping_get_edge_info(void);
 
+/**
+ * Edges of face f in winding order (slot i runs f[i] → f[i+1]).
+ * @param n  Set to the number of entries (0 if out of range)
+ */
+const EdgeRef *mapping_face_edges(poly_idx_t f, uint8_t *n);
+
+/**
+ * Edges incident to vertex v, rev = the edge ends at v (walk reversed to
+ * move away from the vertex).
+ * @param n  Set to the number of entries (0 if out of range)
+ */
+const EdgeRef *mapping_vertex_edges(poly_idx_t v, uint8_t *n);
+
+/**
+ * start/count/step for the pixel span functions, walking the edge in the
+ * direction of the ref. Follows remaps (uses edge_info).
+ */
+static inline EdgeLedInfo mapping_ref_span(const EdgeRef *r)
+{
+    EdgeLedInfo inf = mapping_get_edge_info()[r->edge];
+    if (r->rev) {
+        inf.start = (uint16_t)(inf.start + (inf.count - 1) * inf.step);
+        inf.step  = (int8_t)-inf.step;
+    }
+    return inf;
+}
+
+/**
+ * LED positions, indexed like the pixel functions (length = total pixels).
+ * Built with the mapping and kept up to date by rebuilds and patches, check
+ * mapping_generation() when caching anything derived from it.
+ */
+const LedPos *mapping_get_led_pos(void);
+
+/**
+ * Per-LED attributes, indexed like the pixel functions, kept up to date
+ * together with the positions
+ */
+const LedAttr *mapping_get_led_attr(void);
+
+/**
+ * The two faces either side of the LED at framebuffer index px
+ * (POLY_IDX_NONE on an open edge or out of range)
+ */
+void mapping_led_faces(uint16_t px, poly_idx_t out[2]);
+
+/**
+ * Face f's frame, kept up to date together with the positions
+ * @return NULL out of range or before init_mapping()
+ */
+const FaceFrame *mapping_face_frame(poly_idx_t f);
+
+/**
+ * Polyhedron vertices moved (poly_orient_to_*, poly_rotate): recompute the
+ * LED positions (and attributes) and bump the generation. Happens on its own at the next
+ * mapping_get_led_pos() / mapping_generation() (Polyhedron gen moved).
+ */
+void mapping_refresh_geometry(void);
+
 /* --------------------------------------------------------------------------
  * Build Pixel Map
  * Rebuilds the pixel_map array after modifying edge_map or flip_map.
  */
 void update_mappings(void);
 
+/* --------------------------------------------------------------------------
+ * Live remapping: each call rewrites only the LED ranges of the edges it
+ * touches (no full rebuild) and bumps the generation.
+ * All return false if an index is out of range or mapping is not initialized.
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Swap the physical blocks of logical edges a and b.
+ * Blocks with different LED counts move the logical ranges (full rebuild).
+ */
+bool mapping_swap_edges(poly_idx_t a, poly_idx_t b);
+
+/**
+ * Set the flip (B→A wiring) of logical edge e.
+ */
+bool mapping_set_flip(poly_idx_t e, bool on);
+
+/**
+ * Put logical edge `logical` on physical block `phys`. The caller keeps the
+ * edge map a permutation (assign the displaced edge as well).
+ */
+bool mapping_assign(poly_idx_t logical, poly_idx_t phys);
+
+/* --------------------------------------------------------------------------
+ * Flash persistence (LED_MAP_STORE, flash_store.h)
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Save the current edge map and flip map to flash.
+ * @return false on a flash error, if mapping is not initialized or the record
+ *         (E * (sizeof(poly_idx_t) + 1) bytes) exceeds FLASH_STORE_MAX_LEN
+ */
+bool mapping_store_save(void);
+
+/**
+ * Overwrite user_map / user_flip with the saved mapping, for init_mapping().
+ * Left untouched if nothing was saved for `len` edges or the saved edge map
+ * is not a permutation.
+ * @return true if a saved mapping was loaded
+ */
+bool mapping_store_load(poly_idx_t *user_map, bool *user_flip, poly_idx_t len);
+
+/**
+ * Incremented on every rebuild or patch and when the polyhedron's vertices
+ * moved, caches derived from the map (LED positions, ...) compare it to know
+ * they are stale.
+ */
+uint32_t mapping_generation(void);
+
+/**
+ * Incremented only when the edge set or an edge's LED range moved (new
+ * polyhedron, LED_EDGE_LEDS blocks of another length remapped), not by flips
+ * or same-length swaps: for state that holds edge indices / positions along
+ * an edge (shooting stars) and should survive ordinary remaps.
+ */
+uint32_t mapping_layout_generation(void);
+
 
 #ifdef __cplusplus
 }
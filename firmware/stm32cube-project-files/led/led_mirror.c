@@ -0,0 +1,68 @@
+/* --------------------------------------------------------------------------
+ * led_mirror.c – PKT_PIXELS, the drawn frame for the host's preview
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "led_mirror.h"
+#include "led_render.h"      /* render_acquire_back, g_global_brightness */
+#include "led_mapping.h"     /* mapping_get_total_pixels */
+#include "frame_clock.h"     /* period_us */
+#include "usb_packet.h"      /* usb_packet_send, PKT_OVERHEAD */
+#include "usb_comms.h"       /* usb_tx_channel_room */
+
+static MirrorStats stats;
+static uint8_t     fps;
+static uint16_t    every;           /* frame clock ticks per mirrored frame */
+static uint16_t    count;
+static uint16_t    frame;
+
+void mirror_set_fps(uint8_t f)
+{
+    fps   = f;
+    count = 0;
+    if (!f) return;
+    uint32_t clock = 1000000u / frame_clock_stats()->period_us;
+    every = (uint16_t)((clock + f / 2u) / f);
+    if (!every) every = 1;
+}
+
+uint8_t mirror_fps(void)
+{
+    return fps;
+}
+
+void mirror_frame(void)
+{
+    if (!fps || ++count < every) return;
+    count = 0;
+
+    const rgb_8b *fb = render_acquire_back();
+    uint16_t      n  = mapping_get_total_pixels();
+    if (!fb || !n) return;
+
+    uint16_t packets = (uint16_t)((n + MIRROR_CHUNK - 1) / MIRROR_CHUNK);
+    if (usb_tx_channel_room(TX_CH_PACKET) < 3u * n + packets * (5u + PKT_OVERHEAD)) {
+        ++stats.skipped;            /* the last one is still going out */
+        return;
+    }
+
+    uint8_t b[5 + 3 * MIRROR_CHUNK];
+    memcpy(&b[0], &frame, 2);
+    b[4] = g_global_brightness;
+    for (uint16_t first = 0; first < n; first += MIRROR_CHUNK) {
+        uint16_t k = (uint16_t)(n - first < MIRROR_CHUNK ? n - first : MIRROR_CHUNK);
+        memcpy(&b[2], &first, 2);
+#ifdef LED_PIXEL_32
+        for (uint16_t i = 0; i < k; ++i) memcpy(&b[5 + 3u * i], &fb[first + i], 3);   /* spare byte dropped */
+#else
+        memcpy(&b[5], fb + first, 3u * k);
+#endif
+        usb_packet_send(PKT_PIXELS, b, (uint8_t)(5u + 3u * k));
+    }
+    ++frame;
+    ++stats.sent;
+}
+
+const MirrorStats *mirror_stats(void)
+{
+    return &stats;
+}
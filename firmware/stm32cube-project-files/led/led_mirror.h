@@ -0,0 +1,53 @@
+/*
+ * led_mirror.h – the framebuffer back to the host, for a live preview
+ *
+ * "mirror <fps>" on the console (0 stops it, off at boot) sends the frame
+ * just drawn as PKT_PIXELS packets (usb_packet.h), at most that many a
+ * second, each packet a run of LEDs:
+ *
+ *   frame u16 | first LED u16 | brightness u8 | rgb[n] (n <= MIRROR_CHUNK)
+ *
+ * LEDs in framebuffer order, as "L:" in the geometry dump addresses them
+ * (app/led_preview.py), colours before brightness and gamma. A frame goes
+ * out whole in one main loop pass or not at all (no torn frames): when the
+ * TX ring has no room for it the frame is skipped and counted. 720 LEDs at
+ * 60 fps are ~135 kB/s, well within full speed USB.
+ */
+
+#ifndef _LED_MIRROR_H_
+#define _LED_MIRROR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* LEDs per packet: 5 + 3 × 80 = 245 of PKT_PAYLOAD_MAX */
+#define MIRROR_CHUNK            80
+
+typedef struct {
+    uint32_t sent;          /* frames */
+    uint32_t skipped;       /* no room in the TX ring */
+} MirrorStats;
+
+/**
+ * Once per frame clock tick, after the frame is drawn: sends it when due
+ */
+void mirror_frame(void);
+
+/**
+ * Frames a second, 0 = off
+ */
+void    mirror_set_fps(uint8_t fps);
+uint8_t mirror_fps(void);
+
+const MirrorStats *mirror_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_MIRROR_H_ */
@@ -0,0 +1,113 @@
+/* --------------------------------------------------------------------------
+ * led_noise.c – Q16 / Q15 simplex noise, tables in flash
+ * -------------------------------------------------------------------------- */
+#include "led_noise.h"
+#include "led_render.h"    /* LED_RAMFUNC */
+
+/* Ken Perlin's reference permutation, indexed with uint8_t wrap-around */
+static const uint8_t perm[256] = {
+    151,160,137, 91, 90, 15,131, 13,201, 95, 96, 53,194,233,  7,225,
+    140, 36,103, 30, 69,142,  8, 99, 37,240, 21, 10, 23,190,  6,148,
+    247,120,234, 75,  0, 26,197, 62, 94,252,219,203,117, 35, 11, 32,
+     57,177, 33, 88,237,149, 56, 87,174, 20,125,136,171,168, 68,175,
+     74,165, 71,134,139, 48, 27,166, 77,146,158,231, 83,111,229,122,
+     60,211,133,230,220,105, 92, 41, 55, 46,245, 40,244,102,143, 54,
+     65, 25, 63,161,  1,216, 80, 73,209, 76,132,187,208, 89, 18,169,
+    200,196,135,130,116,188,159, 86,164,100,109,198,173,186,  3, 64,
+     52,217,226,250,124,123,  5,202, 38,147,118,126,255, 82, 85,212,
+    207,206, 59,227, 47, 16, 58, 17,182,189, 28, 42,223,183,170,213,
+    119,248,152,  2, 44,154,163, 70,221,153,101,155,167, 43,172,  9,
+    129, 22, 39,253, 19, 98,108,110, 79,113,224,232,178,185,112,104,
+    218,246, 97,228,251, 34,242,193,238,210,144, 12,191,179,162,241,
+     81, 51,145,235,249, 14,239,107, 49,192,214, 31,181,199,106,157,
+    184, 84,204,176,115,121, 50, 45,127,  4,150,254,138,236,205, 93,
+    222,114, 67, 29, 24, 72,243,141,128,195, 78, 66,215, 61,156,180,
+};
+
+/* edge midpoints of a cube, 12 + 4 repeats so h & 15 picks one */
+static const int8_t grad3[16][3] = {
+    { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+    { 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
+    { 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 },
+    { 1, 1, 0 }, { 0, -1, 1 }, { -1, 1, 0 }, { 0, -1, -1 },
+};
+
+/* unskew factor 1/6 in Q16, and the radius² of a corner's kernel (0.5) in Q30 */
+#define G3_Q16      10923
+#define R2_Q30      536870912u
+
+static inline uint8_t hash3(int32_t i, int32_t j, int32_t k)
+{
+    return perm[(uint8_t)(i + perm[(uint8_t)(j + perm[(uint8_t)k])])];
+}
+
+/* one corner: (0.5 - d²)^4 * (g · d), d in Q16. Result Q15 of the final
+ * value, the * 76 that scales the sum of four to about ±1 folded in.
+ * (Radius² 0.5, not the often seen 0.6: that one leaks past the simplex
+ * and steps at its faces.) */
+static inline int32_t corner(int32_t x, int32_t y, int32_t z, uint8_t h)
+{
+    int32_t  ax = x >> 1, ay = y >> 1, az = z >> 1;                            /* Q15 */
+    uint32_t d2 = (uint32_t)ax * (uint32_t)ax + (uint32_t)ay * (uint32_t)ay
+                + (uint32_t)az * (uint32_t)az;                               /* Q30, |d| < 1 */
+    if (d2 >= R2_Q30) return 0;
+    int32_t t = (int32_t)((R2_Q30 - d2) >> 15);                                /* Q15 */
+    t = (t * t) >> 15;                                                         /* Q15 */
+    t = (t * t) >> 11;                                                         /* Q19, < 2^17 */
+    const int8_t *g   = grad3[h & 15];
+    int32_t       dot = (g[0] * ax + g[1] * ay + g[2] * az) >> 1;              /* Q14, |g·d| < 1.1 */
+    return ((t * dot) >> 12) * 19 >> 4;                                        /* Q21 * 76/32 */
+}
+
+/* ==========================================================================
+ * API
+ * ========================================================================== */
+LED_RAMFUNC int16_t noise3_q15(int32_t x, int32_t y, int32_t z)
+{
+    /* skew to the cube lattice, find the cell and which of its 6 tetrahedra */
+    int32_t s = (x + y + z) / 3;
+    int32_t i = (x + s) >> 16, j = (y + s) >> 16, k = (z + s) >> 16;
+    int32_t t = (i + j + k) * NOISE_ONE / 6;                      /* back by (i+j+k)/6, exact */
+    int32_t x0 = x - i * NOISE_ONE + t, y0 = y - j * NOISE_ONE + t, z0 = z - k * NOISE_ONE + t;
+
+    int32_t i1, j1, k1, i2, j2, k2;
+    if (x0 >= y0) {
+        if      (y0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+        else if (x0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1; }
+        else               { i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1; }
+    } else {
+        if      (y0 <  z0) { i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1; }
+        else if (x0 <  z0) { i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1; }
+        else               { i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+    }
+
+    int32_t n = corner(x0, y0, z0, hash3(i, j, k))
+              + corner(x0 - i1 * NOISE_ONE + G3_Q16,     y0 - j1 * NOISE_ONE + G3_Q16,     z0 - k1 * NOISE_ONE + G3_Q16,
+                       hash3(i + i1, j + j1, k + k1))
+              + corner(x0 - i2 * NOISE_ONE + 2 * G3_Q16, y0 - j2 * NOISE_ONE + 2 * G3_Q16, z0 - k2 * NOISE_ONE + 2 * G3_Q16,
+                       hash3(i + i2, j + j2, k + k2))
+              + corner(x0 - NOISE_ONE + 3 * G3_Q16,  y0 - NOISE_ONE + 3 * G3_Q16,  z0 - NOISE_ONE + 3 * G3_Q16,
+                       hash3(i + 1, j + 1, k + 1));
+
+    if (n >  32767) n =  32767;
+    if (n < -32767) n = -32767;
+    return (int16_t)n;
+}
+
+LED_RAMFUNC int16_t noise3_fbm(int32_t x, int32_t y, int32_t z, uint8_t octaves)
+{
+    /* 2^(o-1) / (2^o - 1) in Q15: amplitudes 1, 1/2, ... summed back to 1 */
+    static const int32_t norm[NOISE_OCTAVES_MAX + 1] = { 0, 32768, 21845, 18725, 17476 };
+    if (octaves < 1) octaves = 1;
+    if (octaves > NOISE_OCTAVES_MAX) octaves = NOISE_OCTAVES_MAX;
+
+    int32_t acc = 0;
+    for (uint8_t o = 0; o < octaves; ++o) {
+        acc += noise3_q15(x, y, z) >> o;
+        /* twice as fine, shifted off the lattice so the octaves don't line up */
+        x = 2 * x + 0x9E37;
+        y = 2 * y + 0x7F4A;
+        z = 2 * z + 0x3C6E;
+    }
+    return (int16_t)((acc * norm[octaves]) >> 15);
+}
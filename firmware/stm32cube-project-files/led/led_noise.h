@@ -0,0 +1,46 @@
+/*
+ * led_noise.h – fixed point 3D simplex noise for the shader kernels
+ *
+ * Integer only: coordinates in Q16 (1.0 = 65536 = one noise cell), result
+ * Q15 in about [-32767, 32767]. Permutation and gradient tables are const
+ * (flash), nothing to set up and no RAM. Sampled over the LED positions
+ * (unit sphere) times a scale, with time as an offset, for lava / aurora
+ * like fields; noise3_fbm() stacks octaves, each twice as fine and half
+ * as strong.
+ */
+
+#ifndef _LED_NOISE_H_
+#define _LED_NOISE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NOISE_ONE               65536   /* Q16 1.0, one cell */
+
+#define NOISE_OCTAVES_MAX       4       /* noise3_fbm() takes at most */
+
+/**
+ * Simplex noise at (x, y, z), Q16 in, Q15 out, continuous, period 256 cells.
+ * |x|, |y|, |z| up to 2^29 (8192 cells, plenty for time offsets).
+ */
+int16_t noise3_q15(int32_t x, int32_t y, int32_t z);
+
+/**
+ * Fractal sum of 1..NOISE_OCTAVES_MAX octaves (lacunarity 2, gain 1/2),
+ * scaled back into the Q15 range of one octave
+ */
+int16_t noise3_fbm(int32_t x, int32_t y, int32_t z, uint8_t octaves);
+
+/**
+ * Float position → Q16 noise coordinate (scale = cells per unit)
+ */
+static inline int32_t noise_coord(float v, float scale) { return (int32_t)(v * scale * NOISE_ONE); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_NOISE_H_ */
@@ -0,0 +1,142 @@
+/* --------------------------------------------------------------------------
+ * led_palette.c – named gradient palettes and the active 256 entry table
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "led_palette.h"
+#include "config.h"        /* ms() */
+
+/* ==========================================================================
+ * Registry (stops from lut_rainbow_raw() of the hues they were picked as)
+ * ========================================================================== */
+static const PaletteDef palettes[] = {
+    { "rainbow",   9, { {   0,255,  0,  0 }, {  32,171, 85,  0 }, {  64,171,170,  0 },
+                        {  96,  0,255,  0 }, { 128,  0,171, 85 }, { 160,  0,  0,255 },
+                        { 192, 85,  0,171 }, { 224,170,  0, 85 }, { 255,255,  0,  0 } } },
+    /* hues 240 136 46 47 48 243 237 165 160, the minefield's own */
+    { "minefield", 9, { {   0,212,  0, 43 }, {  32,  0,129,127 }, {  64,171,122,  0 },
+                        {  96,171,124,  0 }, { 128,171,127,  0 }, { 159,220,  0, 35 },
+                        { 191,204,  0, 51 }, { 223, 13,  0,242 }, { 255,  0,  0,255 } } },
+    /* neon pink, electric blue, acid yellow */
+    { "neon",      3, { {   0,191,  0, 64 }, { 128, 21,  0,234 }, { 255,171,122,  0 } } },
+    /* hot pink, deep blue, aqua, vivid red */
+    { "hotpink",   4, { {   0,212,  0, 43 }, {  85, 42,  0,213 }, { 170,  0,129,127 },
+                        { 255,245, 10,  0 } } },
+    /* magenta, cool blue, neon yellow, bright red */
+    { "magenta",   4, { {   0,233,  0, 22 }, {  85, 26,  0,229 }, { 170,171,122,  0 },
+                        { 255,234, 21,  0 } } },
+    /* purple, aqua, lime */
+    { "purple",    3, { {   0,127,  0,129 }, { 128,  0,129,127 }, { 255,171,127,  0 } } },
+    /* hot pink, electric blue, bright red */
+    { "pinkblue",  3, { {   0,212,  0, 43 }, { 128, 21,  0,234 }, { 255,234, 21,  0 } } },
+    { "lava",      5, { {   0,  0,  0,  0 }, {  96,128,  0,  0 }, { 160,255, 32,  0 },
+                        { 224,255,160,  0 }, { 255,255,255,128 } } },
+    { "ocean",     4, { {   0,  0,  0, 64 }, {  96,  0, 64,192 }, { 192,  0,192,192 },
+                        { 255,170,255,255 } } },
+    /* night sky, green curtains, violet tops */
+    { "aurora",    4, { {   0,  0, 16,  8 }, {  96,  0,192, 48 }, { 176,  0,160,140 },
+                        { 255,150,  0,200 } } },
+};
+#define PALETTE_COUNT ((uint8_t)(sizeof palettes / sizeof *palettes))
+
+/* ==========================================================================
+ * Runtime state
+ * ========================================================================== */
+rgb_8b palette_lut[256];
+
+static uint8_t  pal_target   = 0;
+static bool     pal_ready    = false;   // palette_lut holds something
+static bool     pal_blending = false;
+static uint16_t pal_blend_ms = 0;
+static uint32_t pal_last_ms  = 0;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Colour at index i, i walked upwards: *k is the segment cursor
+ */
+static rgb_8b stop_color(const PaletteDef *d, uint8_t *k, uint8_t i)
+{
+    if (d->count < 2) return (rgb_8b){ d->stop[0].r, d->stop[0].g, d->stop[0].b };
+    while (*k + 2 < d->count && i > d->stop[*k + 1].pos) ++*k;
+
+    const PaletteStop *a = &d->stop[*k], *b = &d->stop[*k + 1];
+    if (i <= a->pos) return (rgb_8b){ a->r, a->g, a->b };
+    if (i >= b->pos) return (rgb_8b){ b->r, b->g, b->b };
+    int32_t f = ((int32_t)(i - a->pos) << 8) / (b->pos - a->pos);   /* 0..255 */
+    return (rgb_8b){
+        (uint8_t)(a->r + (((b->r - a->r) * f) >> 8)),
+        (uint8_t)(a->g + (((b->g - a->g) * f) >> 8)),
+        (uint8_t)(a->b + (((b->b - a->b) * f) >> 8)),
+    };
+}
+
+void palette_expand(const PaletteDef *d, rgb_8b *out)
+{
+    uint8_t k = 0;
+    for (uint16_t i = 0; i < 256; ++i) out[i] = stop_color(d, &k, (uint8_t)i);
+}
+
+static inline uint8_t toward(uint8_t c, uint8_t t, uint8_t amt)
+{
+    if (c < t) return (t - c > amt) ? c + amt : t;
+    return (c - t > amt) ? c - amt : t;
+}
+
+/* ==========================================================================
+ * API
+ * ========================================================================== */
+uint8_t palette_count(void) { return PALETTE_COUNT; }
+
+const PaletteDef *palette_get(uint8_t i) { return i < PALETTE_COUNT ? &palettes[i] : NULL; }
+
+int palette_find(const char *name)
+{
+    if (!name) return -1;
+    for (uint8_t i = 0; i < PALETTE_COUNT; ++i)
+        if (strcmp(palettes[i].name, name) == 0) return i;
+    return -1;
+}
+
+uint8_t palette_active(void) { return pal_target; }
+
+bool palette_select(uint8_t i, uint16_t blend_ms)
+{
+    if (i >= PALETTE_COUNT) return false;
+    pal_target = i;
+    if (!blend_ms || !pal_ready) {
+        palette_expand(&palettes[i], palette_lut);
+        pal_ready    = true;
+        pal_blending = false;
+    } else {
+        pal_blend_ms = blend_ms;
+        pal_last_ms  = ms();
+        pal_blending = true;
+    }
+    return true;
+}
+
+/* every channel moves at most 255 * dt / blend_ms per step, the target is
+ * re-interpolated from the stops on the way (no second table) */
+void palette_tick(void)
+{
+    if (!pal_ready) { palette_select(pal_target, 0); return; }
+    if (!pal_blending) return;
+
+    uint32_t now = ms();
+    uint32_t dt  = now - pal_last_ms;
+    if (!dt) return;
+    pal_last_ms = now;
+    uint32_t amt = (255u * dt + pal_blend_ms - 1) / pal_blend_ms;
+    if (amt > 255) amt = 255;
+
+    const PaletteDef *d    = &palettes[pal_target];
+    uint8_t           k    = 0;
+    bool              done = true;
+    for (uint16_t i = 0; i < 256; ++i) {
+        rgb_8b  t = stop_color(d, &k, (uint8_t)i);
+        rgb_8b *c = &palette_lut[i];
+        c->r = toward(c->r, t.r, (uint8_t)amt);
+        c->g = toward(c->g, t.g, (uint8_t)amt);
+        c->b = toward(c->b, t.b, (uint8_t)amt);
+        if (c->r != t.r || c->g != t.g || c->b != t.b) done = false;
+    }
+    pal_blending = !done;
+}
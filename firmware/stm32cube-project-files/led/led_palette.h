@@ -0,0 +1,102 @@
+/*
+ * led_palette.h – gradient palettes, expanded to a 256 entry RGB table
+ *
+ * A palette is up to PALETTE_MAX_STOPS { index, r, g, b } stops (FastLED
+ * gradient style, first at 0, last at 255) and lives in flash. The active
+ * one is expanded into palette_lut[], so a colour is one load instead of a
+ * hsv_to_rgb_rainbow(). Switching can blend: palette_tick() walks the table
+ * towards the new palette over blend_ms.
+ */
+
+#ifndef _LED_PALETTE_H_
+#define _LED_PALETTE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_render.h"    /* rgb_8b */
+#include "lut.h"           /* lut_scale8_video */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PALETTE_MAX_STOPS       16
+
+typedef struct {
+    uint8_t pos, r, g, b;
+} PaletteStop;
+
+typedef struct {
+    const char *name;
+    uint8_t     count;                  /* stops used, 1..PALETTE_MAX_STOPS */
+    PaletteStop stop[PALETTE_MAX_STOPS];
+} PaletteDef;
+
+/* active palette (mid-blend while one runs), valid after the first palette_tick() */
+extern rgb_8b palette_lut[256];
+
+static inline rgb_8b palette_color(uint8_t i) { return palette_lut[i]; }
+
+/**
+ * Palette colour with saturation / value on top, same "video" rules as
+ * hsv_to_rgb_rainbow() steps 3 + 4 (sat 255 / val 255 = plain lookup)
+ */
+static inline rgb_8b palette_shade(uint8_t i, uint8_t sat, uint8_t val)
+{
+    rgb_8b c = palette_lut[i];
+    if (sat != 255) {
+        uint8_t desat  = lut_scale8_video(255 - sat, 255 - sat);
+        uint8_t satfix = 255 - desat;
+        c.r = lut_scale8_video(c.r, satfix) + desat;
+        c.g = lut_scale8_video(c.g, satfix) + desat;
+        c.b = lut_scale8_video(c.b, satfix) + desat;
+    }
+    if (val != 255) {
+        c.r = lut_scale8_video(c.r, val);
+        c.g = lut_scale8_video(c.g, val);
+        c.b = lut_scale8_video(c.b, val);
+    }
+    return c;
+}
+
+/**
+ * Number of palettes in the registry
+ */
+uint8_t palette_count(void);
+
+/**
+ * Registry entry i, NULL if out of range
+ */
+const PaletteDef *palette_get(uint8_t i);
+
+/**
+ * Index of the palette called name, -1 if there is none
+ */
+int palette_find(const char *name);
+
+/**
+ * Index of the active (or blending-towards) palette
+ */
+uint8_t palette_active(void);
+
+/**
+ * Switch to palette i, blending over blend_ms (0 = at once)
+ * @return false if i is out of range
+ */
+bool palette_select(uint8_t i, uint16_t blend_ms);
+
+/**
+ * Expand a palette into 256 entries
+ */
+void palette_expand(const PaletteDef *d, rgb_8b *out);
+
+/**
+ * Once per frame before drawing: first expansion, blend steps
+ */
+void palette_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_PALETTE_H_ */
@@ -0,0 +1,160 @@
+/* --------------------------------------------------------------------------
+ * led_params.c – parameter get / set, presets in flash, binary frames
+ * -------------------------------------------------------------------------- */
+#include <math.h>
+#include <string.h>
+#include "led_params.h"
+#include "led_anim.h"      /* anim_param_count / anim_param_get */
+#include "flash_store.h"
+
+#define STORE_KEY_PRESET(n)     (0x5030u + (n))     /* "P0", "P1", ... */
+#define PRESET_ENTRY            5u                  /* id + float32 */
+#define PRESET_LEN              (FLASH_STORE_MAX_LEN / PRESET_ENTRY * PRESET_ENTRY)
+
+#if PARAM_PRESETS + 2 > FLASH_STORE_KEYS
+  #error "PARAM_PRESETS + the mapping + the script (led_vm) need more FLASH_STORE_KEYS"
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Lookup
+ */
+const ParamDef *param_find(const char *name)
+{
+    if (!name) return NULL;
+    for (uint8_t i = 0; i < anim_param_count(); ++i)
+        if (strcmp(anim_param_get(i)->name, name) == 0) return anim_param_get(i);
+    return NULL;
+}
+
+const ParamDef *param_by_id(uint8_t id)
+{
+    for (uint8_t i = 0; i < anim_param_count(); ++i)
+        if (anim_param_get(i)->id == id) return anim_param_get(i);
+    return NULL;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Values
+ */
+float param_get(const ParamDef *p)
+{
+    switch (p->type) {
+    case PARAM_U8:    return *(const uint8_t  *)p->ptr;
+    case PARAM_U16:   return *(const uint16_t *)p->ptr;
+    case PARAM_FLOAT: return *(const float    *)p->ptr;
+    }
+    return 0.0f;
+}
+
+bool param_set(const ParamDef *p, float v)
+{
+    if (!p || !(v >= p->min && v <= p->max)) return false;     /* NaN fails too */
+    bool changed = false;
+    switch (p->type) {
+    case PARAM_U8: {
+        uint8_t n = (uint8_t)lrintf(v);
+        changed = *(uint8_t *)p->ptr != n;
+        *(uint8_t *)p->ptr = n;
+        break;
+    }
+    case PARAM_U16: {
+        uint16_t n = (uint16_t)lrintf(v);
+        changed = *(uint16_t *)p->ptr != n;
+        *(uint16_t *)p->ptr = n;
+        break;
+    }
+    case PARAM_FLOAT:
+        changed = *(float *)p->ptr != v;
+        *(float *)p->ptr = v;
+        break;
+    }
+    if (changed && p->changed) p->changed();
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Presets: (id, float32) pairs, read back by id. flash_store only matches
+ * records of the length asked for, so every preset is the same size and
+ * unused entries are PARAM_ID_NONE: builds with more or fewer parameters
+ * still read each other's presets.
+ */
+bool param_preset_save(uint8_t slot)
+{
+    uint8_t rec[PRESET_LEN];
+    if (slot >= PARAM_PRESETS || anim_param_count() > PRESET_LEN / PRESET_ENTRY) return false;
+    memset(rec, PARAM_ID_NONE, sizeof rec);
+    for (uint8_t i = 0; i < anim_param_count(); ++i) {
+        const ParamDef *p = anim_param_get(i);
+        float           v = param_get(p);
+        rec[i * PRESET_ENTRY] = p->id;
+        memcpy(&rec[i * PRESET_ENTRY + 1], &v, sizeof v);
+    }
+    return flash_store_put(STORE_KEY_PRESET(slot), rec, sizeof rec);
+}
+
+bool param_preset_load(uint8_t slot)
+{
+    uint8_t rec[PRESET_LEN];
+    if (slot >= PARAM_PRESETS || !flash_store_get(STORE_KEY_PRESET(slot), rec, sizeof rec)) return false;
+    for (uint16_t k = 0; k + PRESET_ENTRY <= sizeof rec; k += PRESET_ENTRY) {
+        if (rec[k] == PARAM_ID_NONE) continue;
+        float v;
+        memcpy(&v, &rec[k + 1], sizeof v);
+        param_set(param_by_id(rec[k]), v);          /* unknown id: NULL, skipped */
+    }
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Binary frames
+ */
+static uint16_t put_f32(uint8_t *o, float v) { memcpy(o, &v, 4); return 4; }
+
+uint16_t param_frame(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t cap)
+{
+    if (cap < 8) return 0;
+    uint8_t op = len > 1 ? in[1] : 0;
+    uint8_t id = len > 2 ? in[2] : 0;
+    uint16_t n = 4;
+    out[0] = PARAM_FRAME_MAGIC;
+    out[1] = op;
+    out[2] = PARAM_ERR_FRAME;
+    out[3] = id;
+    if (len < 3 || in[0] != PARAM_FRAME_MAGIC) return n;
+
+    const ParamDef *p = param_by_id(id);
+    switch (op) {
+    case 'G':
+    case 'S':
+        if (!p) { out[2] = PARAM_ERR_ID; break; }
+        if (op == 'S') {
+            float v;
+            if (len < 7) break;
+            memcpy(&v, &in[3], sizeof v);
+            if (!param_set(p, v)) { out[2] = PARAM_ERR_RANGE; break; }
+        }
+        out[2] = PARAM_OK;
+        n += put_f32(&out[n], param_get(p));
+        break;
+
+    case 'I': {
+        if (!p) { out[2] = PARAM_ERR_ID; break; }
+        size_t name = strlen(p->name) + 1;
+        if (n + 9 + name > cap) return 0;
+        out[2]   = PARAM_OK;
+        out[n++] = (uint8_t)p->type;
+        n += put_f32(&out[n], p->min);
+        n += put_f32(&out[n], p->max);
+        memcpy(&out[n], p->name, name);
+        n += (uint16_t)name;
+        break;
+    }
+
+    case 'W':
+    case 'L':
+        if (id >= PARAM_PRESETS) { out[2] = PARAM_ERR_ID; break; }
+        out[2] = (op == 'W' ? param_preset_save(id) : param_preset_load(id)) ? PARAM_OK : PARAM_ERR_FLASH;
+        break;
+    }
+    return n;
+}
@@ -0,0 +1,101 @@
+/*
+ * led_params.h – typed, live tunable animation parameters
+ *
+ * The animations' knobs (plasma frequencies, star count, minefield shell,
+ * ...) are listed once in a table (led_anim.c, anim_param_get) with a type,
+ * a range and a stable id. They are read and written by name over the text
+ * console ("param", "preset") or by id with small binary frames, so a host
+ * tool can tune without a rebuild. Values are checked against the range,
+ * a hook runs only when a value really changed; derived tables (falloff,
+ * fade, plasma basis) already rebuild on their own once their inputs move.
+ * Presets keep every value by id in flash (flash_store), one record per slot.
+ */
+
+#ifndef _LED_PARAMS_H_
+#define _LED_PARAMS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* preset slots, one flash_store key each (with the mapping's and the script's: FLASH_STORE_KEYS) */
+#ifndef PARAM_PRESETS
+  #define PARAM_PRESETS         3
+#endif
+
+typedef enum {
+    PARAM_U8,
+    PARAM_U16,
+    PARAM_FLOAT,
+} ParamType;
+
+#define PARAM_ID_NONE           0xFFu   /* never a parameter's id */
+
+typedef struct {
+    uint8_t     id;             /* stable across builds: binary frames, presets */
+    const char *name;
+    ParamType   type;
+    void       *ptr;
+    float       min, max;
+    void      (*changed)(void); /* after a set that changed it, NULL = nothing */
+} ParamDef;
+
+/**
+ * Lookup by name / by id, NULL if there is none
+ */
+const ParamDef *param_find(const char *name);
+const ParamDef *param_by_id(uint8_t id);
+
+/**
+ * Current value (integers widened)
+ */
+float param_get(const ParamDef *p);
+
+/**
+ * Set (integers rounded), runs the hook if the value changed
+ * @return false if v is outside [min, max], nothing changed then
+ */
+bool param_set(const ParamDef *p, float v);
+
+/**
+ * Every parameter into / from preset slot (0..PARAM_PRESETS-1). Unknown
+ * ids in a saved preset are skipped, parameters it lacks stay as they are.
+ * @return false on a bad slot, a flash error, or nothing saved there
+ */
+bool param_preset_save(uint8_t slot);
+bool param_preset_load(uint8_t slot);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Binary frames (all values float32, little endian):
+ *   'G' id              → 'G' st id value
+ *   'S' id value        → 'S' st id value        (value as it is now)
+ *   'I' id              → 'I' st id type min max name '\0'
+ *   'W' slot / 'L' slot → 'W' / 'L' st slot      (preset save / load)
+ * every frame starts with PARAM_FRAME_MAGIC, st is a ParamStatus; they
+ * travel as PKT_PARAM packets (usb_packet.h)
+ */
+#define PARAM_FRAME_MAGIC       0xA7u
+
+typedef enum {
+    PARAM_OK,
+    PARAM_ERR_ID,               /* no such id / slot */
+    PARAM_ERR_RANGE,            /* value outside [min, max] */
+    PARAM_ERR_FRAME,            /* unknown op, too short */
+    PARAM_ERR_FLASH,            /* preset not saved / not there */
+} ParamStatus;
+
+/**
+ * Handle one request frame, reply into out
+ * @return reply length (0: out too small)
+ */
+uint16_t param_frame(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_PARAMS_H_ */
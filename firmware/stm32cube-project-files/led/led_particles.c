@@ -0,0 +1,189 @@
+/* --------------------------------------------------------------------------
+ * led_particles.c – particle pool: spawn / retire / step / draw
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "led_particles.h"
+#include "led_mapping.h"   /* edge_info */
+#include "led_raster.h"    /* raster_tap, the head between two LEDs */
+
+/* External polyhedron instance (created in main.c) */
+extern Polyhedron poly;
+
+#define ALIGN4(n) POLY_ARENA_ALIGN(n)     /* as poly_arena_alloc() places them */
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Pool layout, same order in bytes and init
+ */
+size_t particles_bytes(uint16_t cap, poly_idx_t E)
+{
+    return 2 * ALIGN4(cap * sizeof(poly_idx_t))        /* edge, prev_edge */
+         + ALIGN4(cap * sizeof(int16_t))               /* pos             */
+         + 3 * ALIGN4(cap)                             /* flags speed tail */
+         + ALIGN4(cap * sizeof(uint16_t))              /* life            */
+         + ALIGN4(cap * sizeof(rgb_8b))                /* color           */
+         + E;                                          /* occ             */
+}
+
+bool particles_init(ParticlePool *pp, PolyArena *a, uint16_t cap)
+{
+    memset(pp, 0, sizeof *pp);
+    pp->E         = poly.E;
+    pp->edge      = poly_arena_alloc(a, cap * sizeof *pp->edge);
+    pp->prev_edge = poly_arena_alloc(a, cap * sizeof *pp->prev_edge);
+    pp->pos       = poly_arena_alloc(a, cap * sizeof *pp->pos);
+    pp->flags     = poly_arena_alloc(a, cap);
+    pp->speed     = poly_arena_alloc(a, cap);
+    pp->tail      = poly_arena_alloc(a, cap);
+    pp->life      = poly_arena_alloc(a, cap * sizeof *pp->life);
+    pp->color     = poly_arena_alloc(a, cap * sizeof *pp->color);
+    pp->occ       = poly_arena_alloc(a, pp->E);
+    if (!pp->edge || !pp->prev_edge || !pp->pos || !pp->flags || !pp->speed ||
+        !pp->tail || !pp->life || !pp->color || !pp->occ) return false;
+    pp->cap = cap;
+    rng_stream(&pp->rng, "particles");
+    particles_clear(pp);
+    return true;
+}
+
+void particles_clear(ParticlePool *pp)
+{
+    pp->n = 0;
+    if (pp->occ) memset(pp->occ, 0, pp->E);
+}
+
+int particles_spawn(ParticlePool *pp, poly_idx_t edge, bool rev, int16_t pos,
+                    uint8_t speed, uint8_t tail, uint16_t life, rgb_8b color)
+{
+    if (pp->n >= pp->cap || edge >= pp->E) return -1;
+    uint16_t i = pp->n++;
+    pp->edge[i]      = edge;
+    pp->prev_edge[i] = edge;
+    pp->pos[i]       = pos;
+    pp->flags[i]     = rev ? (PARTICLE_REV | PARTICLE_PREV_REV) : 0;
+    pp->speed[i]     = speed;
+    pp->tail[i]      = tail;
+    pp->life[i]      = life;
+    pp->color[i]     = color;
+    if (pp->occ[edge] < 255) pp->occ[edge]++;
+    return i;
+}
+
+void particles_retire(ParticlePool *pp, uint16_t i)
+{
+    if (i >= pp->n) return;
+    if (pp->occ[pp->edge[i]]) pp->occ[pp->edge[i]]--;
+    uint16_t last = --pp->n;
+    if (i == last) return;
+    pp->edge[i]      = pp->edge[last];
+    pp->prev_edge[i] = pp->prev_edge[last];
+    pp->pos[i]       = pp->pos[last];
+    pp->flags[i]     = pp->flags[last];
+    pp->speed[i]     = pp->speed[last];
+    pp->tail[i]      = pp->tail[last];
+    pp->life[i]      = pp->life[last];
+    pp->color[i]     = pp->color[last];
+}
+
+/*
+ * Edge to continue on at vertex v, not the one we came from.
+ * Prefer edges with no particle on them right now; reservoir sampling
+ * picks uniformly without collecting the candidates.
+ */
+static poly_idx_t pick_next_edge(ParticlePool *pp, poly_idx_t v, poly_idx_t from)
+{
+    uint8_t           deg;
+    const poly_idx_t *inc = poly_vertex_edges(&poly, v, &deg);
+    poly_idx_t        choice = from;
+    int               count  = 0;
+
+    for (int busy = 0; busy < 2 && count == 0; ++busy) {
+        for (uint8_t k = 0; k < deg; ++k) {
+            poly_idx_t e = inc[k];
+            if (e == from || (pp->occ[e] != 0) != busy) continue;
+            if (rng_below(&pp->rng, ++count) == 0) choice = e;
+        }
+    }
+    return choice;            /* dead end: turn around on the same edge */
+}
+
+void particles_step(ParticlePool *pp)
+{
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    if (!info) return;
+
+    for (uint16_t i = 0; i < pp->n; ) {
+        if (pp->life[i] && --pp->life[i] == 0) {
+            particles_retire(pp, i);          /* i now holds the last one */
+            continue;
+        }
+        bool    rev = pp->flags[i] & PARTICLE_REV;
+        int16_t p   = pp->pos[i] + (rev ? -pp->speed[i] : pp->speed[i]);
+
+        if (p < 0 || p >= (int)info[pp->edge[i]].count) {
+            /* arrived at a vertex: remember where we came from, hop */
+            poly_idx_t e       = pp->edge[i];
+            Edge       ed      = poly.e[e];
+            poly_idx_t arrived = rev ? ed.a : ed.b;
+            poly_idx_t next    = pick_next_edge(pp, arrived, e);
+            bool       nrev    = (poly.e[next].b == arrived);
+
+            pp->prev_edge[i] = e;
+            pp->flags[i]     = (uint8_t)((rev ? PARTICLE_PREV_REV : 0) | (nrev ? PARTICLE_REV : 0));
+            if (pp->occ[e]) pp->occ[e]--;
+            if (pp->occ[next] < 255) pp->occ[next]++;
+            pp->edge[i] = next;
+            p = nrev ? (int16_t)(info[next].count - 1) : 0;   /* no overshoot */
+        }
+        pp->pos[i] = p;
+        ++i;
+    }
+}
+
+void particles_draw(const ParticlePool *pp, uint8_t ahead)
+{
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    if (!info) return;
+    rgb_8b row[PARTICLE_TAIL_MAX];
+
+    for (uint16_t i = 0; i < pp->n; ++i) {
+        uint8_t L = pp->tail[i];
+        if (L > PARTICLE_TAIL_MAX) L = PARTICLE_TAIL_MAX;
+        if (!L) continue;
+
+        /* the head f / 256 past LED p (walk order), not past the edge's end */
+        EdgeLedInfo cur  = info[pp->edge[i]];
+        bool        rev  = pp->flags[i] & PARTICLE_REV;
+        int32_t     walk = (rev ? cur.count - 1 - pp->pos[i] : pp->pos[i]) * RASTER_ONE
+                         + ahead * pp->speed[i];
+        if (walk > (cur.count - 1) * RASTER_ONE) walk = (cur.count - 1) * RASTER_ONE;
+        const uint16_t f = (uint16_t)(walk & (RASTER_ONE - 1));
+        int16_t        p = (int16_t)(walk >> 8);
+        if (rev) p = (int16_t)(cur.count - 1 - p);
+
+        /* tail colours: LED t behind is t + f behind the head, fading out
+         * linearly; the LED ahead gets the fraction */
+        rgb_8b c = pp->color[i];
+        for (uint8_t t = 0; t < L; ++t) {
+            uint32_t w = (uint32_t)(256u * L - 256u * t - f) / L;
+            row[t] = (rgb_8b){ (uint8_t)(c.r * w >> 8), (uint8_t)(c.g * w >> 8), (uint8_t)(c.b * w >> 8) };
+        }
+        if (f) {
+            const EdgeRef r = { 0, 0, pp->edge[i], rev };
+            raster_tap(&r, (walk >> 8) + 1, c, f);
+        }
+
+        /* 1) back along the current edge from the head */
+        uint16_t    n   = rev ? (uint16_t)(cur.count - p) : (uint16_t)(p + 1);
+        if (n > L) n = L;
+        add_pixels((uint16_t)(cur.start + p * cur.step), n, (int8_t)(rev ? cur.step : -cur.step), row);
+        if (n == L || pp->prev_edge[i] == pp->edge[i]) continue;
+
+        /* 2) the rest spills back onto the edge it came from, from its exit end */
+        EdgeLedInfo prv  = info[pp->prev_edge[i]];
+        bool        prev = pp->flags[i] & PARTICLE_PREV_REV;
+        uint16_t    m    = L - n;
+        if (m > prv.count) m = prv.count;
+        uint16_t    exit = prev ? 0 : (uint16_t)(prv.count - 1);
+        add_pixels((uint16_t)(prv.start + exit * prv.step), m, (int8_t)(prev ? prv.step : -prv.step), row + n);
+    }
+}
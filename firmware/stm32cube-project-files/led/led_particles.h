@@ -0,0 +1,98 @@
+/*
+ * led_particles.h – pooled particles moving along the wireframe
+ *
+ * A pool is structure-of-arrays carved from an animation's arena. Live
+ * particles are kept dense: spawn appends, retire moves the last one into
+ * the gap, both O(1), and step / draw only touch the live ones. Each
+ * particle runs along an edge at `speed` LEDs per step. At the end vertex it
+ * picks another edge there, preferring one without particles (per-edge
+ * counts, O(degree)). Its tail is drawn as at most two add_pixels() spans:
+ * back along the current edge, and the rest on the edge it came from.
+ * Drawn between two steps, the head is that far on at a fraction of an LED:
+ * the tail is shaded for where it really is and the LED ahead gets the
+ * fraction (led_raster), so slow particles glide instead of jumping.
+ */
+
+#ifndef _LED_PARTICLES_H_
+#define _LED_PARTICLES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "polyhedron.h"    /* poly_idx_t, PolyArena */
+#include "led_render.h"    /* rgb_8b */
+#include "led_rng.h"       /* Rng */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* longest tail drawn (LEDs), longer ones are cut */
+#ifndef PARTICLE_TAIL_MAX
+  #define PARTICLE_TAIL_MAX     32
+#endif
+
+#define PARTICLE_REV            0x01u   /* moving B→A on edge           */
+#define PARTICLE_PREV_REV       0x02u   /* moved B→A on prev_edge       */
+
+typedef struct {
+    uint16_t    cap;        /* slots                                    */
+    uint16_t    n;          /* live, [0, n) of every array              */
+    poly_idx_t  E;          /* edges occ[] was sized for                */
+    poly_idx_t *edge;       /* current edge                             */
+    poly_idx_t *prev_edge;  /* edge before it (tail spill)              */
+    int16_t    *pos;        /* head LED along edge, 0 = A end           */
+    uint8_t    *flags;      /* PARTICLE_*                               */
+    uint8_t    *speed;      /* LEDs per step                            */
+    uint8_t    *tail;       /* tail length incl. head                   */
+    uint16_t   *life;       /* steps left, 0 = until retired            */
+    rgb_8b     *color;      /* head colour, the tail fades out from it  */
+    uint8_t    *occ;        /* per edge: live particles on it           */
+    Rng         rng;        /* turns at the vertices, "particles" stream */
+} ParticlePool;
+
+/**
+ * Arena bytes particles_init() takes for cap particles on E edges
+ */
+size_t particles_bytes(uint16_t cap, poly_idx_t E);
+
+/**
+ * Carve a pool for cap particles on the current mapping from a
+ * @return false if the arena is too small
+ */
+bool particles_init(ParticlePool *pp, PolyArena *a, uint16_t cap);
+
+/**
+ * Retire everything
+ */
+void particles_clear(ParticlePool *pp);
+
+/**
+ * New particle, head at LED pos of edge, moving B→A if rev
+ * @return its index (until the next retire), -1 if the pool is full
+ */
+int  particles_spawn(ParticlePool *pp, poly_idx_t edge, bool rev, int16_t pos,
+                     uint8_t speed, uint8_t tail, uint16_t life, rgb_8b color);
+
+/**
+ * Retire particle i (the last live one takes its index)
+ */
+void particles_retire(ParticlePool *pp, uint16_t i);
+
+/**
+ * Move all by their speed, hop edges at the vertices, retire expired ones
+ */
+void particles_step(ParticlePool *pp);
+
+/**
+ * Add heads + tails onto the framebuffer
+ * @param ahead  how far into the next step (0 … 255 of it, anim_sim_alpha),
+ *               heads stop at the end LED of their edge until they hop
+ */
+void particles_draw(const ParticlePool *pp, uint8_t ahead);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_PARTICLES_H_ */
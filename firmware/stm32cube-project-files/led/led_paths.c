@@ -0,0 +1,178 @@
+/* --------------------------------------------------------------------------
+ * led_paths.c – Euler circuits and a Hamiltonian cycle over the edge graph
+ *               (led_paths.h)
+ * -------------------------------------------------------------------------- */
+#include "led_paths.h"
+
+#include <stdlib.h>
+#include "scene_mem.h"
+
+static PathStep *walk[PATH_COUNT];   /* scene pool */
+static uint16_t  walk_len[PATH_COUNT];
+
+/* the step leaving v along e */
+static inline PathStep step_from(const Polyhedron *p, poly_idx_t e, poly_idx_t v)
+{
+    return (PathStep)(e << 1 | (p->e[e].b == v));
+}
+
+/* the vertex a step arrives at */
+static inline poly_idx_t step_to(const Polyhedron *p, PathStep s)
+{
+    const Edge ed = p->e[PATH_EDGE(s)];
+    return (poly_idx_t)(PATH_REV(s) ? ed.a : ed.b);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Hierholzer, iterative: walk unused steps until stuck, then back off the
+ * stack into the circuit (which comes out reversed). `twice`: every edge is
+ * two arcs, one each way, else one edge used in either direction uses it.
+ * len = E or 2E, O(len · degree).
+ */
+static uint16_t euler(const Polyhedron *p, bool twice, PathStep *out)
+{
+    const uint16_t len = (uint16_t)(twice ? 2u * p->E : p->E);
+    uint8_t  *used  = calloc(2u * p->E, 1);        /* by step, or by edge (<< 1) */
+    PathStep *stack = malloc(len * sizeof *stack);
+    uint16_t  sp = 0, n = 0;
+    if (!used || !stack) {
+        free(used); free(stack);
+        return 0;
+    }
+
+    poly_idx_t v = p->e[0].a;
+    for (;;) {
+        /* an unused step out of v, not straight back along the edge we came by if there is another */
+        uint8_t           deg;
+        const poly_idx_t *inc  = poly_vertex_edges(p, v, &deg);
+        const poly_idx_t  came = sp ? PATH_EDGE(stack[sp - 1]) : POLY_IDX_NONE;
+        PathStep          next = 0;
+        bool              any  = false;
+        for (uint8_t k = 0; k < deg; ++k) {
+            const PathStep s = step_from(p, inc[k], v);
+            if (used[twice ? s : (s & ~1u)]) continue;
+            if (!any || PATH_EDGE(next) == came) next = s;
+            any = true;
+        }
+        if (any && sp < len) {
+            used[twice ? next : (next & ~1u)] = 1;
+            stack[sp++] = next;
+            v = step_to(p, next);
+            continue;
+        }
+        if (!sp) break;
+        out[len - 1u - n++] = stack[--sp];         /* reversed into place */
+        v = sp ? step_to(p, stack[sp - 1]) : p->e[0].a;
+    }
+    free(used); free(stack);
+    return n == len ? len : 0;                     /* disconnected */
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Depth first from vertex 0, neighbours with the fewest unvisited
+ * neighbours first (Warnsdorff): the Platonic solids close without backing
+ * off far.
+ */
+static uint8_t free_degree(const Polyhedron *p, poly_idx_t v, const uint8_t *seen)
+{
+    uint8_t deg, n = 0;
+    const poly_idx_t *inc = poly_vertex_edges(p, v, &deg);
+    for (uint8_t k = 0; k < deg; ++k) n += !seen[step_to(p, step_from(p, inc[k], v))];
+    return n;
+}
+
+static uint16_t hamilton(const Polyhedron *p, PathStep *out)
+{
+    const uint16_t V = p->V;
+    uint8_t *seen  = calloc(V, 1);
+    uint8_t *tried = calloc(V, 1);                 /* per depth: neighbours tried */
+    uint16_t n = 0;
+    if (!seen || !tried || V < 3) goto done;
+
+    seen[0] = 1;
+    uint16_t depth = 0;                            /* out[0 .. depth) taken */
+    uint32_t budget = PATH_HAMILTON_BUDGET;
+    while (budget--) {
+        const poly_idx_t v = depth ? step_to(p, out[depth - 1]) : 0;
+        if (depth == V - 1u) {                     /* all in: closes back to 0? */
+            const poly_idx_t e = poly_find_edge(p, v, 0);
+            if (e != POLY_IDX_NONE) {
+                out[depth] = step_from(p, e, v);
+                n = V;
+                break;
+            }
+        } else {
+            /* the tried[depth]-th best neighbour, by free degree then index */
+            uint8_t deg;
+            const poly_idx_t *inc = poly_vertex_edges(p, v, &deg);
+            PathStep pick = 0;
+            int16_t  pick_key = -1;
+            uint8_t  rank = 0;
+            for (uint8_t r = 0; r <= tried[depth] && r < deg; ++r) {
+                /* r-th candidate: smallest key above the previous one */
+                int16_t  best = 0x7FFF;
+                PathStep bs   = 0;
+                for (uint8_t k = 0; k < deg; ++k) {
+                    const PathStep   s = step_from(p, inc[k], v);
+                    const poly_idx_t w = step_to(p, s);
+                    if (seen[w]) continue;
+                    const int16_t key = (int16_t)(free_degree(p, w, seen) << 8 | k);
+                    if (key > pick_key && key < best) { best = key; bs = s; }
+                }
+                if (best == 0x7FFF) break;
+                pick_key = best;
+                pick     = bs;
+                rank     = (uint8_t)(r + 1);
+            }
+            if (rank == tried[depth] + 1u) {
+                tried[depth] = rank;
+                out[depth++] = pick;
+                seen[step_to(p, pick)] = 1;
+                tried[depth] = 0;
+                continue;
+            }
+        }
+        /* dead end: back off a vertex */
+        if (!depth) break;
+        seen[step_to(p, out[--depth])] = 0;
+    }
+done:
+    free(seen); free(tried);
+    return n;
+}
+
+bool paths_init(const Polyhedron *p)
+{
+    paths_shutdown();
+    const uint16_t cap[PATH_COUNT] = { p->E, (uint16_t)(2u * p->E), p->V };
+    static const char *const name[PATH_COUNT] = { "path_euler", "path_euler2", "path_hamilton" };
+
+    bool even = true;
+    for (poly_idx_t v = 0; v < p->V && even; ++v) {
+        uint8_t deg;
+        poly_vertex_edges(p, v, &deg);
+        even = !(deg & 1u);
+    }
+    for (uint8_t k = 0; k < PATH_COUNT; ++k) {
+        if (!p->E || (k == PATH_EULER && !even)) continue;
+        walk[k] = scene_alloc(name[k], cap[k] * sizeof(PathStep));
+        if (!walk[k]) return false;
+        walk_len[k] = k == PATH_HAMILTON ? hamilton(p, walk[k]) : euler(p, k == PATH_EULER_2, walk[k]);
+        if (!walk_len[k]) scene_mem_trim(walk[k], 0);      /* none on this solid */
+    }
+    return true;
+}
+
+void paths_shutdown(void)
+{
+    for (uint8_t k = 0; k < PATH_COUNT; ++k) {
+        walk[k]     = NULL;                /* emptied with the scene pool */
+        walk_len[k] = 0;
+    }
+}
+
+const PathStep *path_get(PathKind k, uint16_t *n)
+{
+    *n = (unsigned)k < PATH_COUNT ? walk_len[k] : 0;
+    return *n ? walk[k] : NULL;
+}
@@ -0,0 +1,82 @@
+/*
+ * led_paths.h – closed walks over the wireframe, found once per scene
+ *
+ * paths_init() searches the polyhedron's edge graph when the scene loads and
+ * keeps the results as sequences of directed edges (2 bytes a step):
+ *
+ *   PATH_EULER      every edge once (Hierholzer), only if every vertex has
+ *                   an even degree (octahedron, not the dodecahedron)
+ *   PATH_EULER_2    every edge twice, once each way: always exists on a
+ *                   connected solid, turning straight back only where
+ *                   Hierholzer splices its loops (7 times on the dodecahedron)
+ *   PATH_HAMILTON   every vertex once and back to the start (depth first,
+ *                   at most PATH_HAMILTON_BUDGET steps of search)
+ *
+ * A step's LEDs are path_span(), the edge's pixel span walked in the step's
+ * direction; it follows remaps like mapping_ref_span(). A path effect keeps
+ * (step, LED) and moves on to the next step at an edge's end: no search
+ * per frame, the cycle closes onto step 0.
+ */
+
+#ifndef _LED_PATHS_H_
+#define _LED_PATHS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "polyhedron.h"
+#include "led_mapping.h"   /* EdgeRef, mapping_ref_span */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* search steps for the Hamiltonian cycle before the solid goes without */
+#ifndef PATH_HAMILTON_BUDGET
+  #define PATH_HAMILTON_BUDGET  100000u
+#endif
+
+typedef enum {
+    PATH_EULER,
+    PATH_EULER_2,
+    PATH_HAMILTON,
+    PATH_COUNT
+} PathKind;
+
+/* edge << 1 | walked B→A */
+typedef uint16_t PathStep;
+
+#define PATH_EDGE(s)    ((poly_idx_t)((s) >> 1))
+#define PATH_REV(s)     ((bool)((s) & 1u))
+
+/**
+ * Search the walks on p, into the scene pool (scene load, after the mapping)
+ * @return false on allocation failure; a walk the solid has none of is no
+ *         failure (path_get says so)
+ */
+bool paths_init(const Polyhedron *p);
+
+/**
+ * Drop the walks, before the scene pool is reused
+ */
+void paths_shutdown(void);
+
+/**
+ * The walk's steps, a closed cycle
+ * @param n  Set to the number of steps, 0 if the solid has no such walk
+ */
+const PathStep *path_get(PathKind k, uint16_t *n);
+
+/**
+ * The step's LEDs in walk order, for fill_pixels() & co.
+ */
+static inline EdgeLedInfo path_span(PathStep s)
+{
+    const EdgeRef r = { 0, 0, PATH_EDGE(s), PATH_REV(s) };
+    return mapping_ref_span(&r);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_PATHS_H_ */
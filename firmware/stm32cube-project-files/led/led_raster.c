@@ -0,0 +1,96 @@
+/* --------------------------------------------------------------------------
+ * led_raster.c – sub-LED points and segments along the edges (led_raster.h)
+ * -------------------------------------------------------------------------- */
+#include "led_raster.h"
+
+extern Polyhedron poly;
+
+#if RASTER_TAPS == 3
+/* quadratic B-spline weights of the LEDs before, at and after the nearest
+ * one, by the point's offset from it (-1/2 … 1/2 in 64 steps), sum 256 */
+#define KERN_STEPS      64
+static uint8_t kern[KERN_STEPS][3];
+static bool    kern_built;
+
+static void build_kern(void)
+{
+    for (int k = 0; k < KERN_STEPS; ++k) {
+        float f = (k + 0.5f) / KERN_STEPS - 0.5f;
+        kern[k][0] = (uint8_t)(128.0f * (0.5f - f) * (0.5f - f) + 0.5f);
+        kern[k][2] = (uint8_t)(128.0f * (0.5f + f) * (0.5f + f) + 0.5f);
+        kern[k][1] = (uint8_t)(256 - kern[k][0] - kern[k][2]);
+    }
+    kern_built = true;
+}
+#elif RASTER_TAPS != 2
+#error "RASTER_TAPS is 2 or 3"
+#endif
+
+static inline void add_scaled(uint16_t px, rgb_8b c, uint16_t w)
+{
+    add_pixel_color(px, (uint8_t)(c.r * w >> 8), (uint8_t)(c.g * w >> 8), (uint8_t)(c.b * w >> 8));
+}
+
+void raster_tap(const EdgeRef *r, int32_t i, rgb_8b c, uint16_t w)
+{
+    if (!w) return;
+    const EdgeLedInfo s = mapping_ref_span(r);
+    if (i >= 0 && i < (int32_t)s.count) {
+        add_scaled((uint16_t)(s.start + i * s.step), c, w);
+        return;
+    }
+    if (i != -1 && i != (int32_t)s.count) return;
+
+    /* over the vertex: the LED next to it on each of its other edges */
+    const Edge       ed  = poly.e[r->edge];
+    const poly_idx_t v   = (i < 0) != r->rev ? ed.a : ed.b;
+    uint8_t          n;
+    const EdgeRef   *out = mapping_vertex_edges(v, &n);
+    if (n < 2) return;
+    w = (uint16_t)(w / (n - 1u));
+    for (uint8_t k = 0; k < n; ++k) {
+        if (out[k].edge == r->edge) continue;
+        const EdgeLedInfo o = mapping_ref_span(&out[k]);     /* walks away from v */
+        if (o.count) add_scaled(o.start, c, w);
+    }
+}
+
+void raster_warm(void)
+{
+#if RASTER_TAPS == 3
+    if (!kern_built) build_kern();
+#endif
+}
+
+void raster_point(const EdgeRef *r, int32_t at, rgb_8b c)
+{
+#if RASTER_TAPS == 3
+    if (!kern_built) build_kern();
+    const int32_t  i = (at + RASTER_ONE / 2) >> 8;                  /* nearest LED */
+    const uint8_t *k = kern[(at + RASTER_ONE / 2 - i * RASTER_ONE) * KERN_STEPS / RASTER_ONE];
+    raster_tap(r, i - 1, c, k[0]);
+    raster_tap(r, i,     c, k[1]);
+    raster_tap(r, i + 1, c, k[2]);
+#else
+    const int32_t  i = at >> 8;
+    const uint16_t f = (uint16_t)(at & (RASTER_ONE - 1));
+    raster_tap(r, i,     c, (uint16_t)(RASTER_ONE - f));
+    raster_tap(r, i + 1, c, f);
+#endif
+}
+
+void raster_segment(const EdgeRef *r, int32_t a0, int32_t a1, rgb_8b c)
+{
+    if (a1 < a0) { int32_t t = a0; a0 = a1; a1 = t; }
+    /* LED i covers [i - 1/2, i + 1/2) */
+    const int32_t lo = (a0 + RASTER_ONE / 2) >> 8;
+    const int32_t hi = (a1 + RASTER_ONE / 2) >> 8;
+    if (lo == hi) {
+        raster_tap(r, lo, c, (uint16_t)(a1 - a0));
+        return;
+    }
+    raster_tap(r, lo, c, (uint16_t)(lo * RASTER_ONE + RASTER_ONE / 2 - a0));
+    const int32_t count = mapping_ref_span(r).count;
+    for (int32_t i = lo + 1 > -1 ? lo + 1 : -1; i < hi && i <= count; ++i) raster_tap(r, i, c, RASTER_ONE);
+    raster_tap(r, hi, c, (uint16_t)(a1 - (hi * RASTER_ONE - RASTER_ONE / 2)));
+}
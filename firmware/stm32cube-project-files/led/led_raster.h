@@ -0,0 +1,63 @@
+/*
+ * led_raster.h – points and segments between the LEDs of an edge
+ *
+ * Positions are along a walked edge (an EdgeRef: the edge and its
+ * direction) in 1/256 LED (RASTER_ONE): 0 is the walk's first LED,
+ * (count - 1) · RASTER_ONE its last. A point is splatted onto the LEDs
+ * around it with a precomputed kernel (RASTER_TAPS: 2 = linear between the
+ * two nearest, 3 = quadratic B-spline, softer and even in brightness as it
+ * moves), a segment covers its LEDs fully and its two end LEDs by the part
+ * they overlap. Everything is added saturating (add_pixel_color), so
+ * primitives overlap like light.
+ *
+ * A tap one LED past either end of the edge lands on the vertex's other
+ * edges instead, on their LED next to the vertex, split evenly between them
+ * (mapping_vertex_edges): a point crossing a vertex fades over into all the
+ * ways it can go on. Further out is dropped.
+ */
+
+#ifndef _LED_RASTER_H_
+#define _LED_RASTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_mapping.h"   /* EdgeRef */
+#include "led_render.h"    /* rgb_8b */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RASTER_ONE      256         /* one LED */
+
+#ifndef RASTER_TAPS
+  #define RASTER_TAPS   3
+#endif
+
+/**
+ * Add c at walk position at (RASTER_ONE per LED) along r
+ */
+void raster_point(const EdgeRef *r, int32_t at, rgb_8b c);
+
+/**
+ * Add c over [a0, a1] along r (either order), end LEDs by coverage
+ */
+void raster_segment(const EdgeRef *r, int32_t a0, int32_t a1, rgb_8b c);
+
+/**
+ * Build the point kernel ahead of the first raster_point() (it is built on
+ * its first use otherwise)
+ */
+void raster_warm(void);
+
+/**
+ * Add c · w / 256 onto LED i of the walk (-1 and count: the vertex's other
+ * edges), the taps above are made of this
+ */
+void raster_tap(const EdgeRef *r, int32_t i, rgb_8b c, uint16_t w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_RASTER_H_ */
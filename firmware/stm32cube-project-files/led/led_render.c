@@ -7,14 +7,109 @@
 #include <time.h>
 
 #include "led_render.h"
+#include "pixel_simd.h"
+#include "dma_mem.h"
+#include "profiler.h"
+#include "trace.h"
+#include "irq_stats.h"
+#include "led_rng.h"     /* rng_global */
+#include "led_link.h"    /* LED_LINK_MASTER: the nodes drive the LEDs */
 #include "stm32f4xx_hal.h"
 
 #include "config.h"
 
+#ifdef LED_OUTPUT_GPIO
+#include "led_gpio_out.h"
+#if defined(LED_RENDER_STREAM)
+#error "LED_RENDER_STREAM is SPI only, not supported with LED_OUTPUT_GPIO"
+#endif
+#endif
+
+#ifdef LED_OUTPUT_APA102
+#if defined(LED_RENDER_STREAM) || defined(LED_OUTPUT_GPIO)
+#error "LED_OUTPUT_APA102 is the plain SPI path, not combinable with LED_RENDER_STREAM / LED_OUTPUT_GPIO"
+#endif
+#define BYTES_PER_LED   4        /* brightness header + 3 color bytes */
+#else
+#if LED_WS_SPI_BITS < 3 || LED_WS_SPI_BITS > 5
+#error "LED_WS_SPI_BITS is 3, 4 or 5 SPI bits per WS2812 bit"
+#endif
+#define WS_BYTES        LED_WS_SPI_BITS          /* one channel: 8 bits as patterns */
+#ifdef LED_RGBW
+#define BYTES_PER_LED   (4 * WS_BYTES)
+#else
+#define BYTES_PER_LED   (3 * WS_BYTES)
+#endif
+#endif
+
+#if defined(LED_RGBW) && (defined(LED_OUTPUT_APA102) || defined(LED_OUTPUT_GPIO))
+#error "LED_RGBW is the WS SPI encoder only, not supported with LED_OUTPUT_APA102 / LED_OUTPUT_GPIO"
+#endif
+#ifdef LED_RGBW
+_Static_assert(sizeof(LED_COLOR_ORDER) == 5, "LED_RGBW: LED_COLOR_ORDER names 4 channels, e.g. \"GRBW\"");
+#else
+_Static_assert(sizeof(LED_COLOR_ORDER) == 4, "LED_COLOR_ORDER names 3 channels, e.g. \"GRB\"");
+#endif
+
+#if defined(LED_RENDER_DITHER) && defined(LED_RENDER_STREAM)
+#error "LED_RENDER_DITHER carries state per encoded LED, not supported with LED_RENDER_STREAM"
+#endif
+
+#if defined(LED_POWER_LIMIT_MA) && defined(LED_RENDER_STREAM)
+#error "LED_POWER_LIMIT_MA sums up in encode_frame(), LED_RENDER_STREAM does not use it"
+#endif
+
+#if defined(LED_SKIP_RANGES) && (defined(LED_RENDER_STREAM) || defined(LED_OUTPUT_GPIO))
+#error "LED_SKIP_RANGES are gaps in the SPI strip buffer, not supported with LED_RENDER_STREAM / LED_OUTPUT_GPIO"
+#endif
+
+#if defined(LED_SPI_16BIT) && (defined(LED_RENDER_STREAM) || defined(LED_OUTPUT_GPIO))
+#error "LED_SPI_16BIT pads the strips of the SPI strip buffer, not supported with LED_RENDER_STREAM / LED_OUTPUT_GPIO"
+#endif
+
+#if defined(LED_PIXEL_32) && (defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE))
+#error "LED_PIXEL_32: the link carries the framebuffer as packed RGB, not supported with LED_LINK_*"
+#endif
+#ifdef LED_PIXEL_32
+_Static_assert(sizeof(rgb_8b) == 4, "LED_PIXEL_32: one word per pixel");
+#endif
+
+#if defined(LED_STRIP_CAL) && (defined(LED_OUTPUT_APA102) || defined(LED_OUTPUT_GPIO))
+#error "LED_STRIP_CAL lives in the WS SPI encode tables, not supported with LED_OUTPUT_APA102 / LED_OUTPUT_GPIO"
+#endif
+
+#if defined(LED_FB_INDEXED) && (defined(LED_RENDER_STREAM) || defined(LED_LINK_MASTER))
+#error "LED_FB_INDEXED frames are looked up in encode_frame(), LED_RENDER_STREAM / LED_LINK_MASTER take RGB"
+#endif
+
+#ifdef LED_RENDER_SKIP_UNCHANGED
+#include "crc.h"         /* hcrc */
+#endif
+
+#include "lut.h"         /* gamma / bit pattern / rainbow tables in flash */
+#include "fast_math.h"   /* fm_powf */
+#include "scene_mem.h"   /* scene_alloc, the buffers live with the scene */
+
 #if defined(LED_DEBUG_RENDER) || defined(LED_DEBUG_RENDER_HEAP)
 #include "usb_comms.h"   /* USBD_UsrLog() */
 #endif
 
+#if !defined(LED_RENDER_STREAM) && !defined(LED_OUTPUT_GPIO) && !defined(LED_OUTPUT_APA102)
+#define RENDER_LATCH_TIMER       /* SPI ping-pong: TIM5 times the WS2812 reset */
+#endif
+#if !defined(LED_RENDER_STREAM) && !defined(LED_OUTPUT_GPIO)
+#define RENDER_WIRE_CUTS         /* strip-major byte buffer, see WireCut */
+#endif
+#if !defined(LED_OUTPUT_GPIO) && !defined(LED_OUTPUT_APA102)
+#define RENDER_WS_SPI            /* WS2812 bits as SPI patterns, see ws_spi_clock() */
+#endif
+#ifdef LED_SPI_16BIT
+#define SPI_FRAME_BYTES  2       /* HAL_SPI_Transmit_DMA counts SPI frames */
+#define SPI_BURST_BYTES  8       /* 4 halfword beats: strips start and end on these */
+#else
+#define SPI_FRAME_BYTES  1
+#endif
+
 
 
 
@@ -23,18 +118,180 @@
  * -------------------------------------------------------------------------- */
 
 static uint16_t  pixels_total   = 0;   /* logical LEDs */
-static uint16_t  pixels_per_str = 0;   /* ceil(total/strip_cnt) */
+static uint16_t  pixels_per_str = 0;   /* LEDs on the longest strip */
 static uint8_t   strip_cnt      = 0;   /* saved from init */
 static SPI_HandleTypeDef **spi_arr = NULL; /* external array copy */
+static StripInfo *strips        = NULL; /* per strip: first LED, count, clock, wire time */
+static uint16_t  dark_total     = 0;   /* LED_SKIP_RANGES LEDs that made it onto a strip */
+static uint16_t  pad_total      = 0;   /* LED_SPI_16BIT burst padding of all strips */
+
+#ifdef RENDER_WIRE_CUTS
+/* Where the byte walk through a strip half jumps: right before pixel `at`
+ * come `bytes` that are no pixel (tail + head of strips ending there, then
+ * `dark` spacer LEDs). Sorted by at, ends with at = UINT16_MAX. */
+typedef struct {
+    uint16_t at;
+    uint16_t dark;
+    uint32_t bytes;
+} WireCut;
+static WireCut  *cuts           = NULL;
+#endif
 
 rgb_8b  *framebuffer  = NULL;
-static uint8_t *strip_buffer = NULL;   /* strip_cnt * pixels_per_str * 9 */
+static rgb_8b  *fb_alloc     = NULL;   /* owning pointer, framebuffer may be swapped */
+static rgb_8b  *fb_target_saved = NULL; /* framebuffer while render_target() redirects it */
+static uint8_t *strip_buffer = NULL;   /* 2 halves, see strip_offset()                */
+static uint8_t *strip_front  = NULL;   /* half currently owned by the SPI DMAs        */
+static uint8_t *strip_back   = NULL;   /* half the encoder is filling                 */
+static size_t   strip_frame_bytes = 0; /* bytes of one half                           */
+static uint8_t  strip_head   = 0;      /* bytes before a strip's first LED (APA102 start frame) */
+static uint8_t  strip_tail   = 1;      /* bytes after its last (WS2812 latch / APA102 end frame) */
+
+static volatile uint32_t dma_busy_mask = 0;     /* bit s set while strip s is on the wire */
+static volatile uint32_t dma_errors    = 0;     /* SPI error callbacks (render_dma_errors) */
+static volatile bool     back_pending  = false; /* back half encoded, waiting for the DMAs */
+static volatile bool     frame_done    = false; /* last strip of a frame finished          */
+#ifdef LED_RTOS
+static bool              frame_drawn   = false; /* render_submit() from the anim task      */
+static bool              submit_now    = false; /* render_send_drawn() is sending          */
+#endif
+static uint32_t          frame_start_cyc = 0;   /* DWT when the strips were started        */
+
+/* frame numbers (render_frame_seq): submitted, held by each strip half, on
+ * the wire, finished and when */
+static uint32_t          seq_submitted;
+#ifdef LED_RENDER_PIPELINE
+static volatile uint32_t seq_queued;            /* of fb_front                             */
+#endif
+static volatile uint32_t seq_back, seq_front;
+static volatile uint32_t seq_shown, shown_cyc;
+
+#ifdef RENDER_LATCH_TIMER
+static volatile bool     latch_wait    = false; /* TIM5 counting down the reset interval   */
+static uint32_t          frame_end_cyc = 0;     /* DWT when the last strip finished        */
+#endif
+
+#ifdef LED_RENDER_PIPELINE
+static rgb_8b           *fb_front      = NULL;  /* submitted frame, read by the encoder    */
+static volatile bool     frame_queued  = false; /* fb_front submitted but not yet encoded  */
+#endif
+
+#ifdef LED_RENDER_SKIP_UNCHANGED
+static uint32_t  sent_crc     = 0;      /* CRC of the last frame actually sent         */
+static uint32_t  sent_ms      = 0;      /* HAL_GetTick() when it was sent              */
+static bool      sent_valid   = false;  /* nothing sent yet                            */
+#endif
+
+/* dirty tracking, one bit per block of LED_DIRTY_BLOCK physical LEDs
+ * (dirty_fb counts framebuffer indices, logical with LED_RENDER_LOGICAL) */
+static uint32_t *dirty_alloc = NULL;   /* owning pointer for the maps below           */
+static uint32_t *dirty_fb    = NULL;   /* changed in framebuffer since last submit    */
+static uint32_t *dirty_sub   = NULL;   /* submitted, not yet encoded                  */
+static uint32_t *dirty_last  = NULL;   /* encoded into the other half last time       */
+static uint16_t  dirty_words = 0;
+
+#ifdef LED_RENDER_LOGICAL
+static const uint16_t *remap_phys = NULL;  /* logical → physical, from the mapping */
+static const uint16_t *remap_log  = NULL;  /* physical → logical                  */
+static uint32_t *dirty_tmp   = NULL;   /* remap_dirty() scratch                       */
+#endif
+
+#ifdef LED_FB_INDEXED
+/* indexed frames: the framebuffer's first pixels_total bytes are palette
+ * indices instead of RGB, the palette is latched for the encoder per frame */
+static rgb_8b   *pal_draw    = NULL;   /* 256, what the animations set              */
+static rgb_8b   *pal_enc     = NULL;   /* 256, pal_draw rotated, what gets encoded   */
+static uint8_t   pal_shift   = 0;      /* index i shows pal_draw[i + pal_shift]      */
+static bool      fb_indexed  = false;  /* framebuffer holds indices                 */
+static bool      enc_indexed = false;  /* the frame handed to the encoder does      */
+#endif
+
+#ifdef LED_OUTPUT_GPIO
+/* GPIO backend: strip halves are bit-sliced, pixels_per_str rows of 24 half-words,
+ * bit of strip s set where its WS2812 bit is 0 */
+static uint16_t  strip_pin[16];        /* BSRR bit per strip */
+#endif
+
+#if defined(LED_OUTPUT_GPIO) || defined(LED_POWER_LIMIT_MA)
+static uint8_t   level_tbl[256];       /* value -> level reaching the LED, brightness + gamma applied */
+#endif
+
+#ifdef LED_RENDER_DITHER
+/* temporal dithering: fused levels keep 8 fractional bits, carried per LED */
+static uint16_t  level16[256];         /* value -> 8.8 level, brightness + gamma applied */
+static uint8_t  *dither_err  = NULL;   /* fraction each LED channel carries to the next frame */
+static uint32_t *dither_map  = NULL;   /* blocks that still dither, re-encoded every frame */
+#endif
+
+#ifdef LED_POWER_LIMIT_MA
+/* current estimate, kept up to date by encode_frame() one dirty block at a time */
+static uint16_t *power_blk   = NULL;   /* sum of the channel levels per dirty block   */
+static volatile uint32_t power_total = 0;   /* sum over all blocks                    */
+#define LEVEL_SUM(c)  (level_tbl[(c).r] + level_tbl[(c).g] + level_tbl[(c).b])
+#endif
+
+#ifdef LED_RENDER_STREAM
+/* streaming output: strip_buffer holds one circular ring of 2 halves per strip */
+typedef struct {
+    uint16_t first;        /* framebuffer index of the strip's first LED      */
+    uint16_t count;        /* LEDs on this strip                              */
+    uint16_t next_led;     /* next LED to encode, == count once data is done  */
+    uint16_t latch_bytes;  /* zero bytes needed for LED_STREAM_LATCH_US       */
+    uint16_t zeros_sent;   /* trailing zero bytes already on the wire         */
+    uint16_t half_zeros[2];/* trailing zero bytes in each half                */
+    bool     half_data[2]; /* half holds LED data                             */
+} StripStream;
+
+static StripStream  *stream      = NULL;
+static const rgb_8b *stream_src  = NULL;   /* frame currently being streamed */
+static size_t        ring_half_bytes = 0;  /* LED_STREAM_RING_LEDS * BYTES_PER_LED */
+#endif
 
 bool    render_ready        = false;
 uint8_t g_global_brightness = 255;
 
-static uint32_t encode_tbl[256];
-static uint8_t color_map[3];
+#ifdef RENDER_WS_SPI
+#if LED_WS_SPI_BITS > 4
+typedef uint64_t WsBits;              /* 40 bit patterns */
+#else
+typedef uint32_t WsBits;
+#endif
+#ifdef LED_STRIP_CAL
+/* a table per strip and channel, the strip's calibration folded in */
+#define ENC_CHANNELS   (sizeof(LED_COLOR_ORDER) - 1)
+typedef WsBits EncodeTbl[ENC_CHANNELS][256];
+static EncodeTbl *encode_tbl = NULL;  /* scene pool, strip_cnt of them                           */
+static uint8_t  (*cal_curve)[ENC_CHANNELS][256] = NULL;   /* level -> calibrated level, same   */
+static StripCal strip_cal[LED_STRIP_CAL_MAX]
+#ifdef LED_STRIP_CAL_INIT
+                = LED_STRIP_CAL_INIT
+#endif
+                ;
+#define STRIP_TBL(s)   ((const EncodeTbl *)&encode_tbl[s])
+#define TBL_CH(ch)     (ch)
+#else
+typedef WsBits EncodeTbl[1][256];     /* every strip and channel alike */
+static EncodeTbl encode_tbl[1];       /* value -> its 8 SPI patterns, brightness + gamma applied */
+#define STRIP_TBL(s)   ((const EncodeTbl *)&encode_tbl[0])
+#define TBL_CH(ch)     0
+#endif
+static uint32_t ws_nibble[16];        /* 4 bits -> their SPI patterns, as ws_spi_clock() picked */
+static uint8_t  ws_h0, ws_h1;         /* SPI bits high in a 0 / a 1, 0 = not picked yet         */
+#elif defined(LED_OUTPUT_APA102)
+static uint8_t  apa_header;           /* 0xE0 | 5-bit global brightness, first byte of each LED  */
+typedef uint8_t EncodeTbl;            /* nothing looked up but gamma, see expand_led()          */
+#define STRIP_TBL(s)   ((const EncodeTbl *)NULL)
+#endif
+static uint8_t  encode_brightness;    /* g_global_brightness encode_tbl was built for           */
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Color order, resolved at compile time: LED_COLOR_ORDER is a literal, so
+ * "GRB"[n] folds to a constant and WIRE_CH(c, n) becomes a fixed field load
+ * (wire byte n of pixel c). Anything that is not 'G' or 'B' counts as R.
+ */
+#define ORDER_IDX(n)   (LED_COLOR_ORDER[n] == 'G' ? 1 : LED_COLOR_ORDER[n] == 'B' ? 2 : \
+                        LED_COLOR_ORDER[n] == 'W' ? 3 : 0)
+#define WIRE_CH(c, n)  ((&(c).r)[ORDER_IDX(n)])
 
 
 
@@ -43,17 +300,69 @@ static uint8_t color_map[3];
  * Set all pixels to the same RGB value
  *
  */
-static uint8_t gamma8[256];
+static const uint8_t *gamma8;       /* flash (lut_gamma_table), else gamma_ram */
+static uint8_t       *gamma_ram;    /* GAMMA_CORRECTION not in LUT_GAMMA_LIST: built at init (scene pool) */
 #endif
 
 /* ─────────────────────────────────────────────────────────────────────────
  * Set all pixels to the same RGB value
  *
  */
-static size_t bytes_free_heap(void);
+#ifdef LED_DEBUG_RENDER_HEAP
+static size_t bytes_ramfunc(void);
+#endif
 static void   free_buffers(void);
-static void   init_encode_tbl(void);
-static void   init_color_map(void);
+static void   init_encode_tbl(uint8_t brightness);
+#ifdef LED_STRIP_CAL
+static void   build_cal_curve(uint8_t s, uint8_t ch);
+#endif
+#ifdef LED_POWER_LIMIT_MA
+static uint8_t power_limit(uint8_t want);
+#endif
+#ifndef LED_RENDER_STREAM
+static void   start_back_buffer(void);
+static void   encode_and_send(const rgb_8b *src);
+#ifndef LED_OUTPUT_GPIO
+static void   launch_strip(uint8_t s);
+#endif
+#endif
+static void   render_mark_all_dirty(void);
+#ifdef LED_RENDER_SKIP_UNCHANGED
+static bool   frame_unchanged(void);
+#endif
+static bool   init_strips(SPI_HandleTypeDef * const *spi_handles);
+#ifdef RENDER_WIRE_CUTS
+static bool   init_cuts(const uint16_t *skip_at, const uint16_t *skip_n, uint8_t skips);
+#endif
+#ifdef LED_SKIP_RANGES
+static void   fill_dark(size_t half_bytes);
+#endif
+#ifdef LED_OUTPUT_APA102
+static bool   apa_spi_clock(SPI_HandleTypeDef *hspi);
+#endif
+#ifdef LED_SPI_16BIT
+static bool   spi_16bit(SPI_HandleTypeDef *hspi);
+#endif
+#ifdef RENDER_WS_SPI
+static bool   ws_spi_clock(SPI_HandleTypeDef *hspi);
+static void   init_ws_nibbles(void);
+#endif
+#ifdef RENDER_LATCH_TIMER
+static void   latch_timer_init(void);
+#endif
+#ifdef LED_RENDER_STREAM
+static bool   stream_init(void);
+static void   stream_start(const rgb_8b *src);
+static void   stream_submit(void);
+static void   stream_abort(uint8_t s);
+#elif !defined(LED_OUTPUT_GPIO)
+static void   strip_tx_done(uint8_t s);
+#endif
+#ifndef LED_OUTPUT_GPIO
+static uint8_t spi_strip(const SPI_HandleTypeDef *hspi);
+static uint32_t spi_pclk(const SPI_HandleTypeDef *hspi);
+#endif
+static void   dma_watchdog(void);
 
 #ifdef GAMMA_CORRECTION
 /**
@@ -71,41 +380,216 @@ bool init_render(uint16_t total_pixels,
                  uint8_t   strip_count,
                  SPI_HandleTypeDef * const *spi_handles)
 {
-    render_ready = false;
-
+#ifdef LED_LINK_MASTER
+    strip_count = 0;               /* no strips here, the link nodes have them */
+    spi_handles = NULL;
+    if (!total_pixels)
+        return false;
+#elif defined(LED_OUTPUT_GPIO)
+    if (!total_pixels || !strip_count || strip_count > 16)   /* spi_handles unused */
+        return false;
+#else
     if (!total_pixels || !strip_count || !spi_handles)
         return false;
+#endif
+    if (strip_count > 32)                  /* one dma_busy_mask bit per strip */
+        return false;
+
+    /* stop any transfer of a previous init before the geometry changes */
+    led_render_shutdown();
+    dma_mem_init();
 
     pixels_total   = total_pixels;
     strip_cnt      = strip_count;
-    pixels_per_str = (pixels_total + strip_cnt - 1) / strip_cnt; // ceil div
+    spi_arr        = (SPI_HandleTypeDef **)spi_handles;
+#ifndef LED_LINK_MASTER
+    if (!init_strips(spi_handles)) {        /* sets pixels_per_str */
+        free_buffers();
+        return false;
+    }
+#endif
 
     const size_t fb_bytes = sizeof(rgb_8b) * pixels_total;
-    // for each strip: pixels_per_str LEDs × 9 bytes + 1 latch byte
-    const size_t sb_bytes = (size_t)strip_cnt * (pixels_per_str * 9 + 1);
+#ifdef LED_RENDER_STREAM
+    // for each strip: a ring of 2 × LED_STREAM_RING_LEDS × 9 bytes, refilled by the DMA ISRs
+    ring_half_bytes = (size_t)LED_STREAM_RING_LEDS * BYTES_PER_LED;
+    const size_t sb_bytes = (size_t)strip_cnt * 2 * ring_half_bytes;
+    const size_t sb_count = 1;
+#elif defined(LED_OUTPUT_GPIO)
+    // all strips in one bit-sliced buffer: pixels_per_str × 24 half-words, latch is timed
+    strip_frame_bytes = (size_t)pixels_per_str * LED_GPIO_SLOTS_PER_LED * sizeof(uint16_t);
+    const size_t sb_bytes = strip_frame_bytes;
+    const size_t sb_count = 2;     /* the encoder fills one while the DMA drains the other */
+#elif defined(LED_LINK_MASTER)
+    // nothing to encode: the link keeps its own buffers (led_link.c)
+    const size_t sb_bytes = 0;
+    const size_t sb_count = 0;
+#else
+    // for each strip: head, its LEDs × BYTES_PER_LED, tail (WS2812: 1 latch byte,
+    // APA102: start and end frame)
+    strip_frame_bytes = (size_t)(pixels_total + dark_total) * BYTES_PER_LED
+                      + (size_t)strip_cnt * (strip_head + strip_tail) + pad_total;
+    const size_t sb_bytes = strip_frame_bytes;
+    const size_t sb_count = 2;     /* the encoder fills one while the DMAs drain the other */
+#endif
 
-    const size_t alloc_total = fb_bytes + sb_bytes;
+#ifdef LED_RENDER_PIPELINE
+    const size_t fb_count = 2;     /* front (encoder) + back (animations) */
+#else
+    const size_t fb_count = 1;
+#endif
+    const uint16_t dirty_blocks = (pixels_total + LED_DIRTY_BLOCK - 1) >> LED_DIRTY_BLOCK_SHIFT;
+    dirty_words = (dirty_blocks + 31) / 32;
+#ifdef LED_RENDER_LOGICAL
+    const size_t dirty_bytes = 4 * sizeof(uint32_t) * dirty_words;   /* + remap scratch */
+#else
+    const size_t dirty_bytes = 3 * sizeof(uint32_t) * dirty_words;
+#endif
 
-    if (LED_RENDER_MAX_ALLOC && alloc_total > LED_RENDER_MAX_ALLOC)
-        return false;
+#ifdef LED_POWER_LIMIT_MA
+    const size_t power_bytes = sizeof(uint16_t) * dirty_blocks;
+#else
+    const size_t power_bytes = 0;
+#endif
+#ifdef LED_RENDER_DITHER
+    const size_t dither_bytes = fb_bytes + sizeof(uint32_t) * dirty_words;
+#else
+    const size_t dither_bytes = 0;
+#endif
+#ifdef LED_FB_INDEXED
+    const size_t pal_bytes = 2 * 256 * sizeof(rgb_8b);   /* pal_draw + pal_enc */
+#else
+    const size_t pal_bytes = 0;
+#endif
+#ifdef LED_STRIP_CAL
+    const size_t cal_bytes = (size_t)strip_cnt * (sizeof(EncodeTbl) + sizeof *cal_curve);
+#else
+    const size_t cal_bytes = 0;
+#endif
+    const size_t alloc_total = fb_count * fb_bytes + sb_count * sb_bytes + dirty_bytes
+                             + power_bytes + dither_bytes + pal_bytes + cal_bytes
+                             + sizeof(StripInfo) * strip_cnt;
 
-    free_buffers();
+    if (LED_RENDER_MAX_ALLOC && alloc_total > LED_RENDER_MAX_ALLOC) {
+        free_buffers();
+        return false;
+    }
 
-    framebuffer  = malloc(fb_bytes);
-    strip_buffer = malloc(sb_bytes);
-    spi_arr      = (SPI_HandleTypeDef **)spi_handles;
+    framebuffer  = scene_alloc("framebuffer", fb_count * fb_bytes);
+    fb_alloc     = framebuffer;
+#ifdef LED_SPI_16BIT
+    /* bursts must not cross a 1 KB boundary: whole bursts from an 8 byte
+     * aligned start, the pool only guarantees words */
+    strip_buffer = sb_count ? scene_alloc("strip_buffer", sb_count * sb_bytes + SPI_BURST_BYTES) : NULL;
+    if (strip_buffer)
+        strip_buffer = (uint8_t *)(((uintptr_t)strip_buffer + SPI_BURST_BYTES - 1) & ~(uintptr_t)(SPI_BURST_BYTES - 1));
+#else
+    strip_buffer = sb_count ? scene_alloc("strip_buffer", sb_count * sb_bytes) : NULL;
+#endif
+    dirty_alloc  = scene_alloc("dirty", dirty_bytes);
+#ifdef LED_POWER_LIMIT_MA
+    power_blk    = scene_calloc("power_blk", dirty_blocks, sizeof(uint16_t));   /* framebuffer starts black */
+    power_total  = 0;
+    if (!power_blk) {
+        free_buffers();
+        return false;
+    }
+#endif
+#ifdef LED_RENDER_DITHER
+    dither_err   = scene_calloc("dither_err", pixels_total, 3);
+    dither_map   = scene_calloc("dither_map", dirty_words, sizeof(uint32_t));
+    if (!dither_err || !dither_map) {
+        free_buffers();
+        return false;
+    }
+#endif
+#ifdef LED_FB_INDEXED
+    pal_draw     = scene_calloc("palette", 2 * 256, sizeof(rgb_8b));
+    pal_enc      = pal_draw ? pal_draw + 256 : NULL;
+    pal_shift    = 0;
+    fb_indexed   = enc_indexed = false;
+    if (!pal_draw) {
+        free_buffers();
+        return false;
+    }
+#endif
+#ifdef LED_STRIP_CAL
+    encode_tbl   = scene_alloc("encode_tbl", (size_t)strip_cnt * sizeof(EncodeTbl));
+    cal_curve    = scene_alloc("cal_curve", (size_t)strip_cnt * sizeof *cal_curve);
+    if (!encode_tbl || !cal_curve) {
+        free_buffers();
+        return false;
+    }
+    for (uint8_t s = 0; s < strip_cnt; ++s)
+        for (uint8_t ch = 0; ch < ENC_CHANNELS; ++ch)
+            build_cal_curve(s, ch);
+#endif
 
-    if (!framebuffer || !strip_buffer) {
+    if (!framebuffer || (!strip_buffer && sb_count) || !dirty_alloc) {
         free_buffers();
         return false;
     }
 
-    memset(framebuffer,  0, fb_bytes);
-    memset(strip_buffer, 0, sb_bytes);
-    init_encode_tbl();
-    init_color_map();
+    /* zeroed once: unused tail LEDs and the latch bytes are never written again */
+    memset(framebuffer,  0, fb_count * fb_bytes);
+    if (strip_buffer) memset(strip_buffer, 0, sb_count * sb_bytes);
+#ifdef LED_RENDER_PIPELINE
+    fb_front      = framebuffer + pixels_total;
+    frame_queued  = false;
+#endif
+    frame_done    = false;
+    strip_front   = strip_buffer;
+    strip_back    = strip_buffer + sb_bytes;
+    dirty_fb      = dirty_alloc;
+    dirty_sub     = dirty_alloc + dirty_words;
+    dirty_last    = dirty_alloc + 2 * dirty_words;
+#ifdef LED_RENDER_LOGICAL
+    dirty_tmp     = dirty_alloc + 3 * dirty_words;
+#endif
+    /* a zeroed strip buffer is not encoded black: both halves need a full pass */
+    render_mark_all_dirty();
+    memcpy(dirty_last, dirty_fb, sizeof(uint32_t) * dirty_words);
+#ifdef LED_RENDER_SKIP_UNCHANGED
+    sent_valid    = false;
+#endif
 #ifdef GAMMA_CORRECTION
-    buildGammaTable(GAMMA_CORRECTION);
+    /* before the encode table, it is folded in */
+    gamma8 = lut_gamma_table(GAMMA_CORRECTION);
+    if (!gamma8) {
+        gamma_ram = scene_alloc("gamma_ram", 256);
+        if (!gamma_ram) {
+            free_buffers();
+            return false;
+        }
+        buildGammaTable(GAMMA_CORRECTION);
+        gamma8 = gamma_ram;
+    }
+#endif
+    init_encode_tbl(g_global_brightness);
+#ifdef LED_SKIP_RANGES
+    fill_dark(sb_bytes);
+#endif
+#ifdef LED_RENDER_STREAM
+    if (!stream_init()) {
+        free_buffers();
+        return false;
+    }
+#endif
+#ifdef LED_OUTPUT_GPIO
+    if (!gpio_out_init(strip_cnt, strip_pin)) {
+        free_buffers();
+        return false;
+    }
+#endif
+#ifdef RENDER_LATCH_TIMER
+    latch_timer_init();
+    frame_end_cyc = DWT->CYCCNT;   /* line state unknown before, wait one reset */
+#endif
+#if defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE)
+    if (!link_init(pixels_total)) {
+        free_buffers();
+        return false;
+    }
 #endif
 
 #ifdef LED_DEBUG_RENDER
@@ -114,18 +598,32 @@ bool init_render(uint16_t total_pixels,
         "=========================\n"
         "   %-5u pixels\n"
         "   %-5u strips\n"
-        "   %-5.1f kB framebuffer\n"
-        "   %-5.1f kB stripbuffer(s)\n"
+        "   %-5.1f kB framebuffer(s)\n"
+        "   %-5.1f kB stripbuffer(s) x%u\n"
         "   %-5.1f kB total\n"
-        "   %-5.1f kB heap left\n"
+        "   %-5.1f kB scene pool left\n"
     	"\n ",
         (unsigned)pixels_total,
         (unsigned)strip_cnt,
-        fb_bytes    / 1024.0f,
-        sb_bytes    / 1024.0f,
+        fb_count * fb_bytes / 1024.0f,
+        sb_count * sb_bytes / 1024.0f,
+        (unsigned)sb_count,
         alloc_total / 1024.0f,
-        bytes_free_heap() / 1024.0f
+        scene_mem_free()  / 1024.0f
     );
+#ifdef LED_DEBUG_RENDER_HEAP
+    USBD_UsrLog("   %-5u B  hot path in RAM (.RamFunc)\n", (unsigned)bytes_ramfunc());
+#endif
+#ifdef RENDER_WS_SPI
+    USBD_UsrLog("   ws2812: %u SPI bits per bit, 0 = %u high, 1 = %u high\n",
+                (unsigned)LED_WS_SPI_BITS, (unsigned)ws_h0, (unsigned)ws_h1);
+#endif
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        USBD_UsrLog("   strip %u: %4u leds @ %5lu kHz -> %5lu us\n",
+                    (unsigned)s, (unsigned)strips[s].count,
+                    (unsigned long)(strips[s].bitrate / 1000),
+                    (unsigned long)strips[s].wire_us);
+    }
 #endif
 	render_ready = true;
 	return true;
@@ -134,8 +632,34 @@ bool init_render(uint16_t total_pixels,
 
 void led_render_shutdown(void)
 {
-    free_buffers();
     render_ready = false;
+    dma_mem_wait();                /* a background fill may still write the framebuffer */
+
+    /* never free a half the DMAs are still reading from */
+#ifdef LED_OUTPUT_GPIO
+    if (dma_busy_mask) gpio_out_stop();
+#else
+    for (uint8_t s = 0; s < strip_cnt && spi_arr; ++s) {
+        if (dma_busy_mask & (1u << s)) {
+            HAL_SPI_DMAStop(spi_arr[s]);
+        }
+    }
+#endif
+    dma_busy_mask = 0;
+    back_pending  = false;
+    render_target(NULL);
+#ifdef LED_RENDER_PIPELINE
+    frame_queued  = false;
+#endif
+#ifdef RENDER_LATCH_TIMER
+    TIM5->CR1     = 0;
+    latch_wait    = false;
+#endif
+#if defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE)
+    link_shutdown();
+#endif
+
+    free_buffers();
 }
 
 
@@ -143,12 +667,74 @@ void led_render_shutdown(void)
 #ifdef GAMMA_CORRECTION
 static void buildGammaTable(float gamma) {
   for (int i = 0; i < 256; ++i) {
-    gamma8[i] = (uint8_t)(powf(i / 255.0f, gamma) * 255.0f + 0.5f);
+    gamma_ram[i] = (uint8_t)(powf(i / 255.0f, gamma) * 255.0f + 0.5f);
   }
 }
 #endif
 
 
+/* ─────────────────────────────────────────────────────────────────────────
+ * Set all pixels to the same RGB value
+ *
+ */
+static inline void mark_dirty(uint16_t idx) {
+    uint16_t blk = idx >> LED_DIRTY_BLOCK_SHIFT;
+    dirty_fb[blk >> 5] |= 1u << (blk & 31);
+}
+
+#ifdef LED_PIXEL_32
+/* a pixel as its word (r in the low byte), one load; the spare byte is
+ * masked out of compares, whoever built the pixel may have left it set */
+#define PX_RGB_MASK  0x00FFFFFFu
+
+static inline uint32_t px_word(rgb_8b c) { uint32_t w; memcpy(&w, &c, 4); return w; }
+static inline rgb_8b   px_from(uint32_t w) { rgb_8b c; memcpy(&c, &w, 4); return c; }
+
+static inline bool rgb_eq(rgb_8b a, rgb_8b b) {
+    return !((px_word(a) ^ px_word(b)) & PX_RGB_MASK);
+}
+#else
+static inline bool rgb_eq(rgb_8b a, rgb_8b b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Mark LEDs as changed after writing `framebuffer` directly
+ *
+ */
+void render_mark_dirty(uint16_t first, uint16_t count)
+{
+    if (!render_ready || !count || first >= pixels_total) return;
+    if (count > pixels_total - first) count = pixels_total - first;
+
+    uint16_t blk_end = (first + count - 1) >> LED_DIRTY_BLOCK_SHIFT;
+    for (uint16_t blk = first >> LED_DIRTY_BLOCK_SHIFT; blk <= blk_end; ++blk) {
+        dirty_fb[blk >> 5] |= 1u << (blk & 31);
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Store a block of pixels computed elsewhere, marking it only if one changed
+ *
+ */
+LED_RAMFUNC void render_store_block(uint16_t first, uint16_t count, const rgb_8b *src)
+{
+    rgb_8b *fb = framebuffer + first;
+    bool changed = false;
+    for (uint16_t i = 0; i < count; ++i) {
+        if (rgb_eq(fb[i], src[i])) continue;
+        fb[i]   = src[i];
+        changed = true;
+    }
+    if (changed) render_mark_dirty(first, count);
+}
+
+static void render_mark_all_dirty(void)
+{
+    memset(dirty_fb, 0xFF, sizeof(uint32_t) * dirty_words);
+}
+
 /* ─────────────────────────────────────────────────────────────────────────
  * Set all pixels to the same RGB value
  *
@@ -166,32 +752,98 @@ static inline uint8_t qadd8(uint8_t a, uint8_t b) {
 void set_all_pixels_color(uint8_t r, uint8_t g, uint8_t b)
 {
     if (!render_ready) return;
+    const rgb_8b c = {r, g, b};
+#ifdef LED_FB_INDEXED
+    if (fb_indexed) {              /* overwritten whole, nothing to expand */
+        fb_indexed = false;
+        render_mark_all_dirty();
+    }
+#endif
     for(uint16_t i = 0; i < pixels_total; ++i) {
-        framebuffer[i] = (rgb_8b){r, g, b};
+        if (rgb_eq(framebuffer[i], c)) continue;
+        framebuffer[i] = c;
+        mark_dirty(i);
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Same as set_all_pixels_color(), but the DMA does the stores. Gray levels
+ * (any color with LED_PIXEL_32) are a plain word fill; any other color is
+ * written to the first FILL_SEED pixels by the CPU, then copied forward
+ * onto itself, 48 bytes behind is far enough that the DMA only reads what
+ * it already wrote.
+ */
+#define FILL_SEED  16              /* pixels, 48 bytes = 12 words */
+
+void render_fill_async(uint8_t r, uint8_t g, uint8_t b)
+{
+    if (!render_ready) return;
+    dma_mem_wait();
+    const rgb_8b c = {r, g, b};
+    const size_t bytes = sizeof(rgb_8b) * pixels_total;
+    uint8_t *fb = (uint8_t *)framebuffer;
+
+#ifdef LED_FB_INDEXED
+    fb_indexed = false;            /* overwritten whole, nothing to expand */
+#endif
+    render_mark_all_dirty();
+#ifdef LED_PIXEL_32
+    dma_mem_fill(fb, px_word(c), bytes);              /* any color is one word */
+#else
+    if (r == g && g == b) {
+        dma_mem_fill(fb, r * 0x01010101u, bytes);
+        return;
+    }
+    if (pixels_total <= 2 * FILL_SEED) {              /* not worth a DMA job */
+        for (uint16_t i = 0; i < pixels_total; ++i) framebuffer[i] = c;
+        return;
+    }
+
+    for (uint16_t i = 0; i < FILL_SEED; ++i) framebuffer[i] = c;
+    const size_t seed = sizeof(rgb_8b) * FILL_SEED;
+    const size_t body = (bytes - seed) & ~(size_t)3;
+    for (size_t t = seed + body; t < bytes; ++t) {    /* tail directly, it only depends on t % 3 */
+        fb[t] = (&c.r)[t % 3];
     }
+    dma_mem_copy(fb + seed, fb, body);
+#endif
+}
+
+void render_fill_wait(void)
+{
+    dma_mem_wait();
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
  * Set individual pixel to a specific RGB value
  *
  */
-void set_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b)
+LED_RAMFUNC void set_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b)
 {
     if (!render_ready || idx >= pixels_total) return;
-    framebuffer[idx] = (rgb_8b){r, g, b};
+    const rgb_8b c = {r, g, b};
+    if (rgb_eq(framebuffer[idx], c)) return;
+    framebuffer[idx] = c;
+    mark_dirty(idx);
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
  * Add pixel color with clamping (saturating addition)
  *
  */
-void add_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b)
+LED_RAMFUNC void add_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b)
 {
     if ((r | g | b) == 0) return;
     rgb_8b *c = &framebuffer[idx];
+    const rgb_8b old = *c;
+#ifdef LED_PIXEL_32
+    *c = px_from(px_qadd8x4(px_word(old), px_word((rgb_8b){ r, g, b })));
+#else
     c->r = qadd8(c->r, r);
     c->g = qadd8(c->g, g);
     c->b = qadd8(c->b, b);
+#endif
+    if (!rgb_eq(old, *c)) mark_dirty(idx);   /* saturated pixels stay clean */
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
@@ -200,109 +852,242 @@ void add_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b)
  */
 void subtract_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b) {
     rgb_8b c = framebuffer[idx];
+#ifdef LED_PIXEL_32
+    c = px_from(px_qsub8x4(px_word(c), px_word((rgb_8b){ r, g, b })));
+#else
     c.r = (c.r > r) ? c.r - r : 0;
     c.g = (c.g > g) ? c.g - g : 0;
     c.b = (c.b > b) ? c.b - b : 0;
+#endif
+    if (rgb_eq(framebuffer[idx], c)) return;
     framebuffer[idx] = c;
+    mark_dirty(idx);
 }
 
 
 /* ─────────────────────────────────────────────────────────────────────────
- * HSV → RGB conversion (8-bit fixed-point, fast integer math)
- *
+ * SPAN PRIMITIVES
+ * start/count/step as in EdgeLedInfo, step +1 / -1 along an edge or any
+ * other nonzero stride (interlaced shaders). The range is checked once per
+ * call instead of once per pixel: first and last pixel both in the buffer.
  */
-void hsv_to_rgb(uint8_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b)
+static inline rgb_8b *span_begin(uint16_t start, uint16_t count, int8_t step)
 {
-    if (s == 0) {
-        *r = *g = *b = v;
-        return;
-    }
-    uint8_t region = h / 43;
-    uint8_t rem = (h - region * 43) * 6;
-    uint16_t p = (uint16_t)v * (255 - s) >> 8;
-    uint16_t q = (uint16_t)v * (255 - ((uint16_t)s * rem >> 8)) >> 8;
-    uint16_t t = (uint16_t)v * (255 - ((uint16_t)s * (255 - rem) >> 8)) >> 8;
-    switch (region) {
-        case 0: *r = v; *g = t; *b = p; break;
-        case 1: *r = q; *g = v; *b = p; break;
-        case 2: *r = p; *g = v; *b = t; break;
-        case 3: *r = p; *g = q; *b = v; break;
-        case 4: *r = t; *g = p; *b = v; break;
-        default: *r = v; *g = p; *b = q; break;
-    }
+    if (!render_ready || !count || !step || start >= pixels_total) return NULL;
+    int32_t last = (int32_t)start + (int32_t)(count - 1) * step;
+    if (last < 0 || last >= (int32_t)pixels_total) return NULL;
+    return &framebuffer[start];
+}
+
+static inline void span_store(rgb_8b *p, rgb_8b c)
+{
+    if (rgb_eq(*p, c)) return;
+    *p = c;
+    mark_dirty((uint16_t)(p - framebuffer));
 }
 
 /* ─────────────────────────────────────────────────────────────────────────
- * Rainbow HSV→RGB conversion (8-band, evenly-spaced “rainbow”)
- *
+ * Fill a range with one color
  */
-/* --------------------------------------------------------------------------
- * FastLED‑style “rainbow” HSV → RGB conversion (8‑bit, constant brightness)
- * Fixes:
- *   • proper cyan→blue fade (region 4)
- *   • exact scale8_video() behaviour (+1 fudge)
- * -------------------------------------------------------------------------- */
-static inline uint8_t scale8(uint8_t i, uint8_t scale) {
-    return ((uint16_t)i * scale) >> 8;        /* 0…255 → 0…255 (trunc)   */
-}
-static inline uint8_t scale8_video(uint8_t i, uint8_t scale) {
-    /* keep one LSB of light when both inputs non‑zero                     */
-    return ((uint16_t)i * scale >> 8) + ((i && scale) ? 1 : 0);
+LED_RAMFUNC void fill_pixels(uint16_t start, uint16_t count, int8_t step, rgb_8b c)
+{
+    rgb_8b *p = span_begin(start, count, step);
+    if (!p) return;
+    for (uint16_t i = 0; i < count; ++i, p += step) {
+        span_store(p, c);
+    }
 }
 
-void hsv_to_rgb_rainbow(uint8_t hue, uint8_t sat, uint8_t val,
-                        uint8_t *pr, uint8_t *pg, uint8_t *pb)
+/* ─────────────────────────────────────────────────────────────────────────
+ * Linear blend from → to along the range (8-bit fixed point)
+ */
+void blend_pixels(uint16_t start, uint16_t count, int8_t step, rgb_8b from, rgb_8b to)
 {
-    /* ───── 1. coarse → fine decode of the hue byte ──────────────────── */
-    uint8_t offset   = hue & 0x1F;          /* 0…31 within 1/8th          */
-    uint8_t offset8  = offset << 3;         /* 0…248 (×8)                 */
-    uint8_t third    = scale8(offset8,  85);/* 0…85  == ⅓ of offset8      */
-    uint8_t twothird = scale8(offset8, 170);/* 0…170 == ⅔ of offset8      */
-
-    uint8_t r=0, g=0, b=0;
-
-    /* ───── 2. raw un‑saturated rainbow (Y‑boost, green fixes op‑in) ─── */
-    const uint8_t Y1 = 1, Y2 = 0;           /* yellow brightness tweak    */
-    const uint8_t G2 = 0, Gscale = 0;       /* green dimming (unused)     */
-
-    if (!(hue & 0x80)) {                    /* 0XXX = regions 0‑3         */
-        if (!(hue & 0x40)) {                /* 00XX = 0‑1                 */
-            if (!(hue & 0x20)) {            /* 000X = region 0 R→O        */
-                r = 255 - third;  g = third;          b = 0;
-            } else {                        /* 001X = region 1 O→Y        */
-                if (Y1) { r = 171;          g = 85 + third; b = 0; }
-                if (Y2) { r = 170 + third;  g = 85 + twothird; b = 0; }
-            }
-        } else {                            /* 01XX = 2‑3                 */
-            if (!(hue & 0x20)) {            /* 010X = region 2 Y→G        */
-                if (Y1) { r = 171 - twothird; g = 170 + third; b = 0; }
-                if (Y2) { r = 255 - offset8; g = 255;         b = 0; }
-            } else {                        /* 011X = region 3 G→C        */
-                r = 0;            g = 255 - third;  b = third;
-            }
-        }
-    } else {                                /* 1XXX = regions 4‑7         */
-        if (!(hue & 0x40)) {                /* 10XX = 4‑5                 */
-            if (!(hue & 0x20)) {            /* 100X = region 4 C→B  **FIX** */
-                r = 0;
-                g = 171 - twothird;         /* fade G 171→0               */
-                b =  85 + twothird;         /* rise B 85→255              */
-            } else {                        /* 101X = region 5 B→P        */
-                r = third;       g = 0;              b = 255 - third;
-            }
-        } else {                            /* 11XX = 6‑7                 */
-            if (!(hue & 0x20)) {            /* 110X = region 6 P→M        */
-                r =  85 + third; g = 0;      b = 171 - third;
-            } else {                        /* 111X = region 7 M→R        */
-                r = 170 + third; g = 0;      b =  85 - third;
-            }
-        }
+    rgb_8b *p = span_begin(start, count, step);
+    if (!p) return;
+
+    /* t in Q16, 0 at the first pixel, 1.0 at the last */
+    const uint32_t dt = (count > 1) ? (65536u / (count - 1)) : 0;
+    uint32_t t = 0;
+    for (uint16_t i = 0; i < count; ++i, p += step, t += dt) {
+        if (i == count - 1 && count > 1) t = 65536u;   /* dt rounds down, end on `to` */
+        rgb_8b c = {
+            (uint8_t)(from.r + (((int32_t)to.r - from.r) * (int32_t)t >> 16)),
+            (uint8_t)(from.g + (((int32_t)to.g - from.g) * (int32_t)t >> 16)),
+            (uint8_t)(from.b + (((int32_t)to.b - from.b) * (int32_t)t >> 16)),
+        };
+        span_store(p, c);
     }
+}
 
-    if (G2)     g >>= 1;                    /* optional green trim        */
-    if (Gscale) g = scale8_video(g, Gscale);
-
-    /* ───── 3. apply saturation (FastLED video style) ─────────────────── */
+/* ─────────────────────────────────────────────────────────────────────────
+ * Saturating add of src[0..count) onto the range
+ */
+/* ─────────────────────────────────────────────────────────────────────────
+ * Run a byte kernel over contiguous pixels one dirty block at a time, so
+ * only blocks that really changed get marked.
+ */
+typedef uint32_t (*px_kernel2)(uint8_t *dst, const uint8_t *src, size_t n);
+
+LED_RAMFUNC static void span_kernel(uint16_t first, uint16_t count, const rgb_8b *src, px_kernel2 k)
+{
+    while (count) {
+        uint16_t n = LED_DIRTY_BLOCK - (first & (LED_DIRTY_BLOCK - 1));   /* to block end */
+        if (n > count) n = count;
+        if (k((uint8_t *)&framebuffer[first], (const uint8_t *)src, sizeof(rgb_8b) * n)) {
+            mark_dirty(first);
+        }
+        first += n;
+        src   += n;
+        count -= n;
+    }
+}
+
+void add_pixels(uint16_t start, uint16_t count, int8_t step, const rgb_8b *src)
+{
+    rgb_8b *p = span_begin(start, count, step);
+    if (!p || !src) return;
+    if (step == 1) {                   /* forward: 4 bytes at a time */
+        span_kernel(start, count, src, px_add_sat);
+        return;
+    }
+    for (uint16_t i = 0; i < count; ++i, p += step) {
+#ifdef LED_PIXEL_32
+        span_store(p, px_from(px_qadd8x4(px_word(*p), px_word(src[i]))));
+#else
+        rgb_8b c = { qadd8(p->r, src[i].r), qadd8(p->g, src[i].g), qadd8(p->b, src[i].b) };
+        span_store(p, c);
+#endif
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Saturating subtract of src[0..count) from the range
+ */
+void subtract_pixels(uint16_t start, uint16_t count, int8_t step, const rgb_8b *src)
+{
+    rgb_8b *p = span_begin(start, count, step);
+    if (!p || !src) return;
+    if (step == 1) {                   /* forward: 4 bytes at a time */
+        span_kernel(start, count, src, px_sub_sat);
+        return;
+    }
+    for (uint16_t i = 0; i < count; ++i, p += step) {
+#ifdef LED_PIXEL_32
+        span_store(p, px_from(px_qsub8x4(px_word(*p), px_word(src[i]))));
+#else
+        rgb_8b c = {
+            (uint8_t)(p->r > src[i].r ? p->r - src[i].r : 0),
+            (uint8_t)(p->g > src[i].g ? p->g - src[i].g : 0),
+            (uint8_t)(p->b > src[i].b ? p->b - src[i].b : 0),
+        };
+        span_store(p, c);
+#endif
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Fade the whole frame towards black: every channel scaled by
+ * (255 - fade_amt) / 256, `power` times, rounded down after each step.
+ * The curve is a 256 entry table, rebuilt only when (fade_amt, power)
+ * changes, so each channel is one lookup, 4 bytes per word load / store.
+ */
+static uint8_t fade_lut[256];
+static uint8_t fade_lut_amt = 0, fade_lut_pow = 0;   /* pow 0 = not built */
+
+static void fade_lut_build(uint8_t fade_amt, uint8_t power)
+{
+    const uint8_t f = 255 - fade_amt;
+    for (uint16_t v = 0; v < 256; ++v) {
+        uint16_t c = v;
+        for (uint8_t k = 0; k < power; ++k) c = (c * f) >> 8;
+        fade_lut[v] = (uint8_t)c;
+    }
+    fade_lut_amt = fade_amt;
+    fade_lut_pow = power;
+}
+
+LED_RAMFUNC void fade_pixels(uint8_t fade_amt, uint8_t power)
+{
+    if (!render_ready) return;
+
+    PROF_BEGIN(FADE);
+    if (!power) power = 1;
+    if (fade_lut_pow != power || fade_lut_amt != fade_amt) fade_lut_build(fade_amt, power);
+
+    const size_t blk_bytes = sizeof(rgb_8b) * LED_DIRTY_BLOCK;
+    uint8_t     *p         = (uint8_t *)framebuffer;
+    size_t       left      = sizeof(rgb_8b) * pixels_total;
+    for (uint16_t blk = 0; left; ++blk, p += blk_bytes) {
+        size_t n = (left < blk_bytes) ? left : blk_bytes;
+        if (px_lut(p, n, fade_lut)) {
+            dirty_fb[blk >> 5] |= 1u << (blk & 31);
+        }
+        left -= n;
+    }
+    PROF_END(FADE);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Copy a precomputed row src[0..count) into the range
+ */
+LED_RAMFUNC void copy_pixels(uint16_t start, uint16_t count, int8_t step, const rgb_8b *src)
+{
+    rgb_8b *p = span_begin(start, count, step);
+    if (!p || !src) return;
+    for (uint16_t i = 0; i < count; ++i, p += step) {
+        span_store(p, src[i]);
+    }
+}
+
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * HSV → RGB conversion (8-bit fixed-point, fast integer math)
+ *
+ */
+void hsv_to_rgb(uint8_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    if (s == 0) {
+        *r = *g = *b = v;
+        return;
+    }
+    uint8_t region = h / 43;
+    uint8_t rem = (h - region * 43) * 6;
+    uint16_t p = (uint16_t)v * (255 - s) >> 8;
+    uint16_t q = (uint16_t)v * (255 - ((uint16_t)s * rem >> 8)) >> 8;
+    uint16_t t = (uint16_t)v * (255 - ((uint16_t)s * (255 - rem) >> 8)) >> 8;
+    switch (region) {
+        case 0: *r = v; *g = t; *b = p; break;
+        case 1: *r = q; *g = v; *b = p; break;
+        case 2: *r = p; *g = v; *b = t; break;
+        case 3: *r = p; *g = q; *b = v; break;
+        case 4: *r = t; *g = p; *b = v; break;
+        default: *r = v; *g = p; *b = q; break;
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Rainbow HSV→RGB conversion (8-band, evenly-spaced “rainbow”)
+ *
+ */
+/* --------------------------------------------------------------------------
+ * FastLED‑style “rainbow” HSV → RGB conversion (8‑bit, constant brightness)
+ * Fixes:
+ *   • proper cyan→blue fade (region 4)
+ *   • exact scale8_video() behaviour (+1 fudge)
+ * -------------------------------------------------------------------------- */
+static inline uint8_t scale8_video(uint8_t i, uint8_t scale) {
+    /* keep one LSB of light when both inputs non‑zero                     */
+    return ((uint16_t)i * scale >> 8) + ((i && scale) ? 1 : 0);
+}
+
+LED_RAMFUNC void hsv_to_rgb_rainbow(uint8_t hue, uint8_t sat, uint8_t val,
+                        uint8_t *pr, uint8_t *pg, uint8_t *pb)
+{
+    /* ───── 1.+2. raw rainbow, lut_rainbow_raw() precomputed (lut.h) ──── */
+    uint8_t r = lut_rainbow[hue][0], g = lut_rainbow[hue][1], b = lut_rainbow[hue][2];
+
+    /* ───── 3. apply saturation (FastLED video style) ─────────────────── */
     if (sat != 255) {
         if (sat == 0) {
             r = g = b = 255;
@@ -333,6 +1118,162 @@ void hsv_to_rgb_rainbow(uint8_t hue, uint8_t sat, uint8_t val,
 }
 
 
+/* ─────────────────────────────────────────────────────────────────────────
+ * The same for a run of hues at one sat / val: the branches of steps 3 + 4
+ * are taken once, each loop is the table load and at most two
+ * scale8_video per channel. hue NULL: 0, 1, 2, ... (a whole table).
+ */
+#define HSV_HUE(hue, i)     ((hue) ? (hue)[i] : (uint8_t)(i))
+
+static inline rgb_8b hsv_sat(rgb_8b c, uint8_t satfix, uint8_t desat)
+{
+    c.r = (uint8_t)(scale8_video(c.r, satfix) + desat);
+    c.g = (uint8_t)(scale8_video(c.g, satfix) + desat);
+    c.b = (uint8_t)(scale8_video(c.b, satfix) + desat);
+    return c;
+}
+
+static inline rgb_8b hsv_val(rgb_8b c, uint8_t val)
+{
+    c.r = scale8_video(c.r, val);
+    c.g = scale8_video(c.g, val);
+    c.b = scale8_video(c.b, val);
+    return c;
+}
+
+static inline rgb_8b hsv_raw(uint8_t h)
+{
+    return (rgb_8b){ lut_rainbow[h][0], lut_rainbow[h][1], lut_rainbow[h][2] };
+}
+
+/* the one colour sat 0 or val 0 leave, or false: it depends on the hue */
+static bool hsv_flat(uint8_t sat, uint8_t val, rgb_8b *c)
+{
+    if (val == 0) { *c = (rgb_8b){ 0, 0, 0 }; return true; }
+    if (sat != 0) return false;
+    uint8_t w = (val == 255) ? 255 : scale8_video(255, val);
+    *c = (rgb_8b){ w, w, w };
+    return true;
+}
+
+/* out[i * stride] = rainbow(hue[i]) at sat / val; store: through span_store */
+static inline void hsv_run(const uint8_t *hue, rgb_8b *out, int8_t stride, uint16_t n,
+                                uint8_t sat, uint8_t val, bool store)
+{
+    rgb_8b flat;
+    if (hsv_flat(sat, val, &flat)) {
+        for (uint16_t i = 0; i < n; ++i, out += stride) {
+            if (store) span_store(out, flat); else *out = flat;
+        }
+        return;
+    }
+    uint8_t desat  = scale8_video(255 - sat, 255 - sat);
+    uint8_t satfix = 255 - desat;
+    rgb_8b  c;
+#define HSV_LOOP(expr)                                                         \
+    for (uint16_t i = 0; i < n; ++i, out += stride) {                          \
+        c = (expr);                                                            \
+        if (store) span_store(out, c); else *out = c;                          \
+    }
+    if (sat == 255 && val == 255)   HSV_LOOP(hsv_raw(HSV_HUE(hue, i)))
+    else if (sat == 255)            HSV_LOOP(hsv_val(hsv_raw(HSV_HUE(hue, i)), val))
+    else if (val == 255)            HSV_LOOP(hsv_sat(hsv_raw(HSV_HUE(hue, i)), satfix, desat))
+    else                            HSV_LOOP(hsv_val(hsv_sat(hsv_raw(HSV_HUE(hue, i)), satfix, desat), val))
+#undef HSV_LOOP
+}
+
+LED_RAMFUNC void hsv_rainbow_span(const uint8_t *hue, rgb_8b *out, uint16_t n, uint8_t sat, uint8_t val)
+{
+    hsv_run(hue, out, 1, n, sat, val, false);
+}
+
+LED_RAMFUNC void hsv_rainbow_pixels(uint16_t start, uint16_t count, int8_t step,
+                                    const uint8_t *hue, uint8_t sat, uint8_t val)
+{
+    rgb_8b *p = span_begin(start, count, step);
+    if (!p) return;
+    hsv_run(hue, p, step, count, sat, val, true);
+}
+
+#ifdef LED_FB_INDEXED
+/* ─────────────────────────────────────────────────────────────────────────
+ * INDEXED FRAMES
+ * The index plane is the framebuffer's own memory, its first pixels_total
+ * bytes: switching costs no RAM, and going back to RGB expands it in place.
+ */
+uint8_t *render_index_plane(void)
+{
+    if (!render_ready || fb_target_saved) return NULL;   /* drawing into a layer */
+    if (!fb_indexed) {
+        dma_mem_wait();
+        memset(framebuffer, 0, pixels_total);
+        fb_indexed = true;
+        render_mark_all_dirty();
+    }
+    return (uint8_t *)framebuffer;
+}
+
+void render_index_end(void)
+{
+    if (!fb_indexed) return;
+    fb_indexed = false;
+    /* from the end: LED i's RGB lands on bytes 3i .. 3i + 2, never below
+     * index i, so every index is read before it is overwritten */
+    const uint8_t *idx = (const uint8_t *)framebuffer;
+    for (uint16_t i = pixels_total; i-- > 0; ) {
+        framebuffer[i] = pal_draw[(uint8_t)(idx[i] + pal_shift)];
+    }
+    render_mark_all_dirty();
+}
+
+bool render_is_indexed(void)
+{
+    return fb_indexed;
+}
+
+rgb_8b *render_palette(void)
+{
+    return pal_draw;
+}
+
+void render_palette_rotate(uint8_t shift)
+{
+    pal_shift = shift;
+}
+
+LED_RAMFUNC void index_pixels(uint16_t start, uint16_t count, int8_t step, const uint8_t *idx)
+{
+    uint8_t *p = render_index_plane();
+    if (!p || !span_begin(start, count, step)) return;
+    p += start;
+    for (uint16_t i = 0; i < count; ++i, p += step) {
+        if (*p == idx[i]) continue;
+        *p = idx[i];
+        mark_dirty((uint16_t)(p - (uint8_t *)framebuffer));
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * The palette the next frame is encoded with, pal_draw rotated once here
+ * instead of per LED. An entry that changed re-encodes the whole frame.
+ * Before take_dirty(), with the encoder not running (pipelined: interrupts
+ * off, it reads pal_enc from the DMA ISRs).
+ */
+static void latch_palette(void)
+{
+    enc_indexed = fb_indexed;
+    if (!fb_indexed) return;
+    bool changed = false;
+    for (uint16_t i = 0; i < 256; ++i) {
+        rgb_8b c = pal_draw[(uint8_t)(i + pal_shift)];
+        if (rgb_eq(pal_enc[i], c)) continue;
+        pal_enc[i] = c;
+        changed    = true;
+    }
+    if (changed) render_mark_all_dirty();
+}
+#endif
+
 /* ─────────────────────────────────────────────────────────────────────────
  * Hue difference calculation (for smooth transitions)
  *
@@ -348,7 +1289,7 @@ int16_t hue_diff(uint8_t a, uint8_t b) {
  * Generate random hue
  * -------------------------------------------------------------------------- */
 uint8_t random_hue(void) {
-    return (uint8_t)(rand() & 0xFF);
+    return (uint8_t)rng_u32(&rng_global);
 }
 
 
@@ -365,186 +1306,1815 @@ uint8_t random_hue(void) {
 
 
 /* ────────────────────────────────────────────────────────────────────────
- * Load actual data for pixel into the strip buffers.
+ * Load actual data for one pixel into its BYTES_PER_LED strip buffer bytes.
  *
  */
-static inline void expand_led(uint16_t phys_idx, rgb_8b c)
-{
-    const size_t BYTES_PER_LED = 9;
-
-    // compute strip & led index, then byte offset
-    uint8_t  strip       = phys_idx / pixels_per_str;
-    uint16_t led         = phys_idx % pixels_per_str;
-    // each strip frame is (pixels_per_str*9 bytes) + 1 latch byte
-    const size_t frame_bytes = (size_t)pixels_per_str * BYTES_PER_LED + 1;
-    size_t offset = (size_t)strip * frame_bytes + (size_t)led * BYTES_PER_LED;
+#ifdef LED_SPI_16BIT
+/* a 16 bit frame goes out MSB first, the high byte of a little endian
+ * halfword: wire byte k sits at address k ^ 1 (strips start halfword aligned) */
+#define WIRE_BYTE(p, k)  (*(uint8_t *)(((uintptr_t)(p) + (k)) ^ 1u))
+#else
+#define WIRE_BYTE(p, k)  ((p)[k])
+#endif
 
-    // scale by global brightness (linear domain)
-    uint8_t scaled_r = ((uint16_t)c.r); //* g_global_brightness) / 255;
-    uint8_t scaled_g = ((uint16_t)c.g); //* g_global_brightness) / 255;
-    uint8_t scaled_b = ((uint16_t)c.b);//* g_global_brightness) / 255;
+/* one channel's WS_BYTES, MSB first (a constant count, unrolled) */
+#define PUT_PATTERN(p, bits)  do { for (uint8_t k_ = 0; k_ < WS_BYTES; ++k_)                 \
+                                       WIRE_BYTE(p, k_) = (uint8_t)((bits) >> (8 * (WS_BYTES - 1 - k_))); \
+                                 } while (0)
 
+#ifdef LED_OUTPUT_APA102
+/* clocked LEDs take plain bytes, gamma is the only lookup left
+ * (none when dithering, the dithered value already is the level) */
 #ifdef GAMMA_CORRECTION
-    // apply gamma correction after brightness scaling
-    scaled_r = gamma8[scaled_r];
-    scaled_g = gamma8[scaled_g];
-    scaled_b = gamma8[scaled_b];
+#define APA_GAMMA(v)  gamma8[v]
+#else
+#define APA_GAMMA(v)  (v)
+#endif
+#ifdef LED_RENDER_DITHER
+#define APA_LEVEL(v)  (v)
+#else
+#define APA_LEVEL(v)  APA_GAMMA(v)
 #endif
 
-    const uint8_t scaled[3] = { scaled_r, scaled_g, scaled_b };
+static inline void expand_led(uint8_t *dst, rgb_8b c, const EncodeTbl *t)
+{
+    (void)t;
+    WIRE_BYTE(dst, 0) = apa_header;
+    WIRE_BYTE(dst, 1) = APA_LEVEL(WIRE_CH(c, 0));
+    WIRE_BYTE(dst, 2) = APA_LEVEL(WIRE_CH(c, 1));
+    WIRE_BYTE(dst, 3) = APA_LEVEL(WIRE_CH(c, 2));
+}
+#elif defined(RENDER_WS_SPI) && defined(LED_RGBW)
+/* white is what r, g and b have in common, taken out here on the way to the
+ * wire: no pass over the framebuffer and no buffer, it stays RGB. The W die's
+ * own tint (LED_RGBW_WHITE_*, how much of each channel one step of W stands
+ * in for) scales the share, 255 / 255 / 255 is a plain min(r, g, b). */
+#define RGBW_INV(x)   ((255u * 256u) / (x))    /* Q8, rounded down: never takes too much */
+static inline uint8_t rgbw_split(rgb_8b *c)
+{
+#if LED_RGBW_WHITE_R == 255 && LED_RGBW_WHITE_G == 255 && LED_RGBW_WHITE_B == 255
+    uint8_t w = c->r < c->g ? c->r : c->g;
+    if (c->b < w) w = c->b;
+    c->r -= w; c->g -= w; c->b -= w;
+    return w;
+#else
+    uint32_t w = (c->r * RGBW_INV(LED_RGBW_WHITE_R)) >> 8;
+    uint32_t t = (c->g * RGBW_INV(LED_RGBW_WHITE_G)) >> 8;
+    if (t < w) w = t;
+    t = (c->b * RGBW_INV(LED_RGBW_WHITE_B)) >> 8;
+    if (t < w) w = t;
+    if (w > 255u) w = 255u;
+    c->r -= (uint8_t)(w * LED_RGBW_WHITE_R / 255u);
+    c->g -= (uint8_t)(w * LED_RGBW_WHITE_G / 255u);
+    c->b -= (uint8_t)(w * LED_RGBW_WHITE_B / 255u);
+    return (uint8_t)w;
+#endif
+}
 
-    // encode bits for each channel
-    uint32_t bits[3];
-    for (uint8_t ch = 0; ch < 3; ++ch) {
-        bits[ch] = encode_tbl[ scaled[ color_map[ch] ] ];
+static inline void expand_led(uint8_t *dst, rgb_8b c, const EncodeTbl *t)
+{
+    // as below, with a fourth channel wherever LED_COLOR_ORDER has its 'W'
+    const uint8_t w = rgbw_split(&c);
+    for (uint8_t n = 0; n < 4; ++n) {
+        const WsBits b = (*t)[TBL_CH(ORDER_IDX(n))][ORDER_IDX(n) == 3 ? w : WIRE_CH(c, n)];
+        PUT_PATTERN(dst + n * WS_BYTES, b);
     }
+}
+#elif defined(RENDER_WS_SPI)
+static inline void expand_led(uint8_t *dst, rgb_8b c, const EncodeTbl *t)
+{
+    // one lookup per channel, brightness and gamma (and the strip's
+    // calibration) are baked into t, the order is fixed at compile time:
+    // three loads, BYTES_PER_LED byte stores
+    const WsBits b0 = (*t)[TBL_CH(ORDER_IDX(0))][ WIRE_CH(c, 0) ];
+    const WsBits b1 = (*t)[TBL_CH(ORDER_IDX(1))][ WIRE_CH(c, 1) ];
+    const WsBits b2 = (*t)[TBL_CH(ORDER_IDX(2))][ WIRE_CH(c, 2) ];
+    PUT_PATTERN(dst + 0 * WS_BYTES, b0);
+    PUT_PATTERN(dst + 1 * WS_BYTES, b1);
+    PUT_PATTERN(dst + 2 * WS_BYTES, b2);
+}
+#endif
 
-    // guard out-of-range
-    if (phys_idx >= (size_t)strip_cnt * pixels_per_str) {
-#ifdef LED_DEBUG_RENDER // —————————————————————————————————————————————————————————————————————
-        uint8_t hue = (uint8_t)(bits[0] >> 16);
-        USBD_UsrLog("expand_led error, phys out of range! phys=%u, strip=%u, led=%u, hue=%u\n",
-               (unsigned)phys_idx, (unsigned)strip, (unsigned)led, (unsigned)hue);
-#endif // ——————————————————————————————————————————————————————————————————————————————————————
-        return;
-    }
+#ifdef LED_OUTPUT_GPIO
+/* ────────────────────────────────────────────────────────────────────────
+ * Bit-sliced variant: one LED row is 24 half-words (one per wire bit, MSB
+ * first), the pin bit is set where the wire bit is 0.
+ */
+static inline void expand_led_slice(uint16_t *row, uint16_t pin, rgb_8b c)
+{
+#ifdef LED_RENDER_DITHER
+    const uint8_t val[3] = { WIRE_CH(c, 0), WIRE_CH(c, 1), WIRE_CH(c, 2) };   /* already levels */
+#else
+    const uint8_t val[3] = { level_tbl[ WIRE_CH(c, 0) ],
+                             level_tbl[ WIRE_CH(c, 1) ],
+                             level_tbl[ WIRE_CH(c, 2) ] };
+#endif
 
-    // write 9 bytes into strip buffer
-    uint8_t *dst = &strip_buffer[offset];
     for (uint8_t ch = 0; ch < 3; ++ch) {
-        dst[ch * 3 + 0] = (bits[ch] >> 16) & 0xFF;
-        dst[ch * 3 + 1] = (bits[ch] >>  8) & 0xFF;
-        dst[ch * 3 + 2] =  bits[ch]        & 0xFF;
+        uint8_t v = val[ch];
+        for (int8_t b = 7; b >= 0; --b, ++row) {
+            if ((v >> b) & 1) *row &= ~pin;
+            else              *row |=  pin;
+        }
     }
 }
+#endif
 
 
 /* ────────────────────────────────────────────────────────────────────────
- * framebuffer color -> spi buffer bits
- * then actually push data out.
+ * Framebuffer color of physical LED i. With LED_RENDER_LOGICAL the
+ * framebuffer is in logical (edge) order and the encoder gathers through
+ * the mapping's inverse permutation, the only place it gets applied.
  */
-void update_leds(void)
+#ifdef LED_RENDER_LOGICAL
+#define FB_PX(src, i)   (src)[remap_log[i]]
+#else
+#define FB_PX(src, i)   (src)[i]
+#endif
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Color the encoder sends for LED i: an indexed frame is looked up in the
+ * latched palette right here, on its way into expand_led().
+ */
+#ifdef LED_FB_INDEXED
+#define SRC_PX(src, i)  (indexed ? pal_enc[FB_PX((const uint8_t *)(src), i)] : FB_PX(src, i))
+#else
+#define SRC_PX(src, i)  FB_PX(src, i)
+#endif
+
+#ifdef LED_RENDER_DITHER
+/* ────────────────────────────────────────────────────────────────────────
+ * Temporal dithering: the fused table keeps 8 fractional bits (level16) and
+ * every LED channel carries its remainder into the next frame, so a level
+ * of 3.25 goes out as 3, 3, 3, 4. Any fraction left in a block keeps it in
+ * dither_map, re-encoded each frame; blocks on whole levels cost nothing.
+ */
+static inline uint8_t dither_ch(uint8_t v, uint8_t *err, uint8_t *frac)
 {
-    // ─── Don’t start a new frame until ALL SPI-DMAs are free ────────────────────
-    // Busy-wait here until every HAL_SPI_GetState == HAL_SPI_STATE_READY
-    bool all_ready;
-    do {
-        all_ready = true;
-        for (uint8_t s = 0; s < strip_cnt; ++s) {
-            if (HAL_SPI_GetState(spi_arr[s]) != HAL_SPI_STATE_READY) {
-                all_ready = false;
-                break;
-            }
-        }
-    } while (!all_ready);
+    uint16_t l = level16[v] + *err;    /* <= 255.0 + 255/256, fits */
+    *err   = (uint8_t)l;
+    *frac |= (uint8_t)level16[v];
+    return (uint8_t)(l >> 8);
+}
 
-#ifdef LED_DEBUG_RENDER // ───────────────────────────────────────────────────────
-    // ===| MCU-side state only when debugging
-    static uint32_t  ft_hist[FRAMETIME_HISTORY];
-    static uint8_t   ft_idx        = 0;
-    static uint8_t   ft_count      = 0;
-    static uint32_t  last_ft_print = 0;
+static inline rgb_8b dither_px(uint16_t idx, rgb_8b c, uint8_t *frac)
+{
+    uint8_t *e = &dither_err[3 * (size_t)idx];
+    rgb_8b out = { dither_ch(c.r, &e[0], frac),
+                   dither_ch(c.g, &e[1], frac),
+                   dither_ch(c.b, &e[2], frac) };
+    return out;
+}
 
-    // ===| Start the DWT timer
-    uint32_t start = DWT->CYCCNT;
-#endif // ───────────────────────────────────────────────────────────────────────
+#define ENCODE_PX(i, c) dither_px((i), (c), &frac)
 
-    // ===| Framebuffer → strip buffers → kick off DMA
-    memset(strip_buffer, 0, (size_t)strip_cnt * pixels_per_str * 9 + 1);
-    for (uint16_t i = 0; i < pixels_total; ++i) {
-        expand_led(i, framebuffer[i]);
-    }
-    const size_t frame_bytes = pixels_per_str*9 + 1;
-    for (uint8_t s = 0; s < strip_cnt; ++s) {
-    	HAL_SPI_Transmit_DMA(spi_arr[s], &strip_buffer[s * frame_bytes], frame_bytes);
+static inline bool dither_active(void)
+{
+    for (uint16_t w = 0; w < dirty_words; ++w) {
+        if (dither_map[w]) return true;
     }
+    return false;
+}
+#else
+#define ENCODE_PX(i, c) (c)
+#endif
 
-#ifdef LED_DEBUG_RENDER // ───────────────────────────────────────────────────────
-    // ===| Stop timing & convert to µs
-    uint32_t end    = DWT->CYCCNT;
-    uint32_t cycles = end - start;
-    // *** use plain integer literals here, no apostrophes! ***
-    uint64_t tmp    = (uint64_t)cycles * 1000000U;
-    uint32_t cpu_hz = HAL_RCC_GetHCLKFreq();
-    uint32_t us     = (uint32_t)(tmp / cpu_hz);
-
-    // ===| Push into circular buffer & compute average
-    ft_hist[ft_idx] = us;
-    ft_idx = (ft_idx + 1) % FRAMETIME_HISTORY;
-    if (ft_count < FRAMETIME_HISTORY) {
-        ft_count++;
+#if !defined(LED_OUTPUT_GPIO) && !defined(LED_RENDER_DITHER)
+/* ────────────────────────────────────────────────────────────────────────
+ * Uniform runs: the LED at run is encoded, `more` of the same color follow
+ * it and are copied in doubling steps instead (blackouts, solid fills).
+ * 16 bit frames keep the wire bytes swapped in halfwords: with an odd
+ * BYTES_PER_LED only even LED counts are copied, between even addresses.
+ */
+LED_RAMFUNC static void run_fill(uint8_t *run, uint16_t more, rgb_8b c, const EncodeTbl *t)
+{
+    uint16_t len = 1;                   /* encoded so far */
+#if defined(LED_SPI_16BIT) && (BYTES_PER_LED & 1)
+    if ((uintptr_t)run & 1u) {          /* copies start one LED later */
+        if (!more) return;
+        run += BYTES_PER_LED;
+        expand_led(run, c, t);
+        --more;
     }
-    uint64_t sum = 0;
-    for (uint8_t i = 0; i < ft_count; i++) {
-        sum += ft_hist[i];
+    while (more) {
+        uint16_t k = (more < len ? more : len) & ~1u;
+        if (!k) {                       /* odd one out */
+            expand_led(run + (size_t)len * BYTES_PER_LED, c, t);
+            ++len;
+            --more;
+            continue;
+        }
+        memcpy(run + (size_t)len * BYTES_PER_LED, run, (size_t)k * BYTES_PER_LED);
+        len  += k;
+        more -= k;
     }
-    uint32_t avg_us = (uint32_t)(sum / ft_count);
-
-    // ===| Print the averaged µs at up to 5 Hz
-    uint32_t now = HAL_GetTick();
-    if ((now - last_ft_print) >= FRAMETIME_PRINT_INTERVAL_MS) {
-        USBD_UsrLog("#frametime %lu#", (unsigned long)avg_us);
-        last_ft_print = now;
+#else
+    while (more) {
+        uint16_t k = more < len ? more : len;
+        memcpy(run + (size_t)len * BYTES_PER_LED, run, (size_t)k * BYTES_PER_LED);
+        len  += k;
+        more -= k;
     }
-#endif // ───────────────────────────────────────────────────────────────────────
+#endif
 }
 
+/* encode_frame(): write out the pending run (before a jump, a launch, the end) */
+#define RUN_END()  do { run_fill(run, more, run_c, tbl); run = NULL; more = 0; } while (0)
+#endif
 
-/* --------------------------------------------------------------------------
- * INTERNAL HELPERS
- * -------------------------------------------------------------------------- */
-static void free_buffers(void) {
-	if (framebuffer) {
-		free(framebuffer);
-	}
-	if (strip_buffer) {
-		free(strip_buffer);
-	}
-	framebuffer = 0;
-	strip_buffer = 0;
+#ifndef LED_RENDER_STREAM
+/* ────────────────────────────────────────────────────────────────────────
+ * Byte offset of strip s's first LED in a strip half, halves are laid out
+ * strip-major: [head | LEDs | tail] per strip.
+ */
+static inline size_t strip_offset(uint8_t s)
+{
+    size_t dark = 0, pad = 0;
+    for (uint8_t q = 0; q < s; ++q) {
+        dark += strips[q].dark;
+        pad  += strips[q].pad;
+    }
+    return ((size_t)strips[s].first + dark) * BYTES_PER_LED + (size_t)s * (strip_head + strip_tail)
+         + pad + strip_head;
 }
 
 /* ────────────────────────────────────────────────────────────────────────
- * Neopixel encoding, table to convert our RGB into 24 bit bitstream. (3 bit timing pattern)
- * 0 bit is sent as 0b100 (short HIGH, long LOW)
- * 1 bit is sent as 0b110 (long HIGH, short LOW)
+ * Strip holding physical LED idx (a handful of strips, linear is fine).
  */
-static void init_encode_tbl(void) {
-	for (uint16_t v = 0; v < 256; ++v) {
-		uint32_t out = 0;
-		for (int b = 7; b >= 0; --b) {
-			out <<= 3;
-			out |= ((v >> b) & 1) ? 0b110 : 0b100;
-		}
-		encode_tbl[v] = out;
-	}
+static inline uint8_t strip_of(uint16_t idx)
+{
+    uint8_t s = 0;
+    while (s + 1 < strip_cnt && idx >= strips[s + 1].first) ++s;
+    return s;
+}
+
+#ifdef RENDER_WIRE_CUTS
+/* ────────────────────────────────────────────────────────────────────────
+ * Byte offset of physical LED idx in a strip half, returns the next cut
+ * after it (a handful of cuts, linear is fine).
+ */
+static inline const WireCut *wire_seek(uint16_t idx, size_t *off)
+{
+    const WireCut *c = cuts;
+    size_t o = strip_head + (size_t)idx * BYTES_PER_LED;
+    for (; c->at <= idx; ++c) o += c->bytes;
+    *off = o;
+    return c;
 }
+#endif
 
 /* ────────────────────────────────────────────────────────────────────────
- * Color order mapping table
- * what bits represent what color.
+ * Encode the submitted changes into the back strip buffer.
+ * The back half was last written two encodes ago, so it is missing both the
+ * blocks changed since then (dirty_sub) and the ones the previous encode put
+ * into the other half (dirty_last). Clean blocks keep their old bits, latch
+ * bytes stay zero from init.
+ *
+ * Strip halves are laid out strip-major (head, the strip's LEDs, tail), so a
+ * run of dirty blocks is a straight pointer walk: one cut lookup where the
+ * run starts, then just jump over tail, head and spacer LEDs at each cut.
+ * LEDs of the color the one before them had are not encoded but copied
+ * (run_fill()), not with LED_RENDER_DITHER: every LED dithers on its own.
+ *
+ * Staggered (encode_and_send(), the strips idle): `half` is the front one
+ * already and every strip the walk is past goes on the wire right away
+ * instead of waiting for the ones behind it.
  */
-static void init_color_map(void) {
-    const char *order = LED_COLOR_ORDER;
-    for (int i = 0; i < 3; ++i) {
-        switch (order[i]) {
-            case 'R': color_map[i] = 0; break;
-            case 'G': color_map[i] = 1; break;
-            case 'B': color_map[i] = 2; break;
-            default:  color_map[i] = 0; /* Fallback auf R */ break;
+LED_RAMFUNC static void encode_frame(const rgb_8b *src, uint8_t *half, bool stagger)
+{
+#ifdef LED_RENDER_PIPELINE
+    seq_back = seq_queued;
+#else
+    seq_back = seq_submitted;
+#endif
+#ifdef LED_OUTPUT_GPIO
+    uint16_t  led   = 0;                /* LED index within the current strip */
+    uint8_t   strip = 0;
+    (void)stagger;
+#else
+    uint8_t  *dst  = NULL;
+    const WireCut *cut = cuts;          /* next jump of the walk              */
+    uint8_t   sent = 0;                 /* staggered: strips launched         */
+    if (stagger) seq_front = seq_back;
+#ifndef LED_RENDER_DITHER
+    uint8_t  *run  = NULL;              /* first LED of a uniform run         */
+    uint16_t  more = 0;                 /* LEDs after it, not written yet     */
+    rgb_8b    run_c = { 0, 0, 0 };
+#endif
+    const EncodeTbl *tbl = STRIP_TBL(0);   /* the walk's strip           */
+#endif
+    uint16_t  next = UINT16_MAX;        /* pixel the walk would continue at   */
+#ifdef LED_FB_INDEXED
+    const bool indexed = enc_indexed;   /* src is an index plane              */
+#endif
+
+    PROF_BEGIN(ENCODE);
+    for (uint16_t w = 0; w < dirty_words; ++w) {
+        uint32_t bits = dirty_sub[w] | dirty_last[w];
+        dirty_last[w] = dirty_sub[w];
+        dirty_sub[w]  = 0;
+
+        while (bits) {
+            uint16_t blk   = w * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+
+            uint16_t first = blk << LED_DIRTY_BLOCK_SHIFT;
+            uint16_t last  = first + LED_DIRTY_BLOCK;
+            if (last > pixels_total) last = pixels_total;
+#ifdef LED_POWER_LIMIT_MA
+            uint16_t level = 0;         /* this block's current, same pass */
+#endif
+#ifdef LED_RENDER_DITHER
+            uint8_t  frac  = 0;         /* any fraction left in this block */
+#endif
+
+#ifdef LED_OUTPUT_GPIO
+            /* strips share the rows, so walk (strip, led) instead of bytes */
+            if (first != next) {
+                strip = strip_of(first);
+                led   = first - strips[strip].first;
+            }
+            uint16_t *rows = (uint16_t *)half;
+            for (uint16_t i = first; i < last; ++i) {
+                rgb_8b c = SRC_PX(src, i);
+                expand_led_slice(&rows[(size_t)led * LED_GPIO_SLOTS_PER_LED],
+                                 strip_pin[strip], ENCODE_PX(i, c));
+#ifdef LED_POWER_LIMIT_MA
+                level += LEVEL_SUM(c);
+#endif
+                if (++led == strips[strip].count) {
+                    led = 0;
+                    while (++strip < strip_cnt && !strips[strip].count) { }
+                }
+            }
+#else
+            if (stagger) {              /* strips that end before this block are done */
+                while (sent < strip_cnt && strips[sent].first + strips[sent].count <= first) {
+#ifndef LED_RENDER_DITHER
+                    RUN_END();
+#endif
+                    launch_strip(sent++);
+                }
+            }
+            if (first != next) {        /* run broken, locate the new start */
+                size_t off;
+                cut = wire_seek(first, &off);
+                dst = &half[off];
+#ifndef LED_RENDER_DITHER
+                RUN_END();
+#endif
+                tbl = STRIP_TBL(strip_of(first));
+            }
+            for (uint16_t i = first; i < last; ++i) {
+                rgb_8b c = SRC_PX(src, i);
+#ifdef LED_RENDER_DITHER
+                expand_led(dst, ENCODE_PX(i, c), tbl);
+#else
+                if (run && rgb_eq(c, run_c)) {
+                    ++more;             /* copied with the rest of the run */
+                } else {
+                    if (more) run_fill(run, more, run_c, tbl);
+                    expand_led(dst, c, tbl);
+                    run   = dst;
+                    run_c = c;
+                    more  = 0;
+                }
+#endif
+#ifdef LED_POWER_LIMIT_MA
+                level += LEVEL_SUM(c);
+#endif
+                dst += BYTES_PER_LED;
+                if (i + 1 == cut->at) { /* strip end and / or spacers */
+#ifndef LED_RENDER_DITHER
+                    RUN_END();          /* runs do not jump */
+#endif
+                    dst += cut->bytes;
+                    ++cut;
+                    tbl = STRIP_TBL(strip_of(i + 1));
+                }
+            }
+#endif
+#ifdef LED_POWER_LIMIT_MA
+            power_total += (uint32_t)level - power_blk[blk];
+            power_blk[blk] = level;
+#endif
+#ifdef LED_RENDER_DITHER
+            if (frac) dither_map[blk >> 5] |=  (1u << (blk & 31));
+            else      dither_map[blk >> 5] &= ~(1u << (blk & 31));
+#endif
+            next = last;
         }
     }
+#ifndef LED_OUTPUT_GPIO
+#ifndef LED_RENDER_DITHER
+    RUN_END();
+#endif
+    while (stagger && sent < strip_cnt)
+        launch_strip(sent++);
+#endif
+    PROF_END(ENCODE);
+}
+
+#ifndef LED_OUTPUT_GPIO
+LED_RAMFUNC uint8_t render_encode_leds(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += BYTES_PER_LED) {
+        expand_led(dst, src[i], STRIP_TBL(0));
+    }
+    return BYTES_PER_LED;
 }
+#endif
 
+/* ────────────────────────────────────────────────────────────────────────
+ * Move the framebuffer's dirty blocks over to the submitted set.
+ * Accumulates, so a frame that is dropped or replaced before it got encoded
+ * still has its changes picked up by the next one.
+ */
+static void take_dirty(void)
+{
+    for (uint16_t w = 0; w < dirty_words; ++w) {
+#ifdef LED_RENDER_DITHER
+        dirty_sub[w] |= dirty_fb[w] | dither_map[w];
+#else
+        dirty_sub[w] |= dirty_fb[w];
+#endif
+        dirty_fb[w]   = 0;
+    }
+}
+
+#ifdef LED_RENDER_LOGICAL
+/* ────────────────────────────────────────────────────────────────────────
+ * dirty_fb is marked in logical blocks, the encoder walks physical ones:
+ * translate it in place through the permutation. Runs in the main loop
+ * before take_dirty(), never with interrupts off. An edge maps to one
+ * contiguous physical run, so mostly the same block bit gets set again.
+ */
+static void remap_dirty(void)
+{
+    memset(dirty_tmp, 0, sizeof(uint32_t) * dirty_words);
+    for (uint16_t w = 0; w < dirty_words; ++w) {
+        uint32_t bits = dirty_fb[w];
+        while (bits) {
+            uint16_t blk = w * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+
+            uint16_t first = blk << LED_DIRTY_BLOCK_SHIFT;
+            uint16_t last  = first + LED_DIRTY_BLOCK;
+            if (last > pixels_total) last = pixels_total;
+            for (uint16_t i = first; i < last; ++i) {
+                uint16_t pb = remap_phys[i] >> LED_DIRTY_BLOCK_SHIFT;
+                dirty_tmp[pb >> 5] |= 1u << (pb & 31);
+            }
+        }
+    }
+    memcpy(dirty_fb, dirty_tmp, sizeof(uint32_t) * dirty_words);
+}
+#endif
+
+#ifdef RENDER_LATCH_TIMER
+/* ────────────────────────────────────────────────────────────────────────
+ * WS2812 reset interval. Instead of padding every strip with a long run of
+ * zero bytes (or polling), the last TxCplt arms TIM5 as a one-shot for the
+ * reset time and the pending back buffer is launched from its interrupt.
+ * A frame submitted later than that starts right away, only the part of the
+ * reset interval that is actually left is waited for.
+ */
+static void latch_timer_init(void)
+{
+    uint32_t pclk   = HAL_RCC_GetPCLK1Freq();
+    uint32_t tim_hz = (RCC->CFGR & RCC_CFGR_PPRE1) ? 2 * pclk : pclk;
+
+    __HAL_RCC_TIM5_CLK_ENABLE();
+    TIM5->CR1  = 0;
+    TIM5->PSC  = tim_hz / 1000000UL - 1;           /* 1 MHz */
+    TIM5->ARR  = LED_LATCH_US - 1;
+    TIM5->EGR  = TIM_EGR_UG;                       /* load PSC */
+    TIM5->SR   = 0;
+    TIM5->DIER = TIM_DIER_UIE;
+    latch_wait = false;
+
+    /* same level as the strip DMAs, so the two never preempt each other */
+    HAL_NVIC_SetPriority(TIM5_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(TIM5_IRQn);
+}
+
+static void latch_timer_arm(uint32_t us)
+{
+    TIM5->ARR  = us ? us - 1 : 0;
+    TIM5->CNT  = 0;
+    TIM5->SR   = 0;
+    TIM5->CR1  = TIM_CR1_OPM | TIM_CR1_CEN;
+    latch_wait = true;
+}
+
+static uint32_t latch_remaining_us(void)
+{
+    uint32_t elapsed = (DWT->CYCCNT - frame_end_cyc) / (SystemCoreClock / 1000000U);
+    return (elapsed >= LED_LATCH_US) ? 0 : LED_LATCH_US - elapsed;
+}
+
+/* reset is over: launch the pending half, (pipelined) encode a queued frame */
+void TIM5_IRQHandler(void)
+{
+    IRQ_ENTER(LATCH_TIM);
+    TIM5->SR   = 0;
+    latch_wait = false;
+    if (back_pending) {
+        back_pending = false;
+        start_back_buffer();
+    }
+#ifdef LED_RENDER_PIPELINE
+    if (frame_queued) {
+        frame_queued = false;
+        encode_frame(fb_front, strip_back, false);
+        back_pending = true;       /* strips are busy again */
+    }
+#endif
+    IRQ_EXIT(LATCH_TIM);
+}
+#endif
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Hand a freshly encoded back strip buffer to the DMAs, or queue it behind
+ * the running transfer. Caller owns the back buffer (nothing else writes it).
+ */
+static void launch_or_queue(void)
+{
+    __disable_irq();
+#ifdef RENDER_LATCH_TIMER
+    if (dma_busy_mask == 0 && !latch_wait) {
+        uint32_t rem = latch_remaining_us();
+        if (rem == 0) {
+            start_back_buffer();
+        } else {
+            back_pending = true;   /* TIM5 starts it after the rest of the reset */
+            latch_timer_arm(rem);
+        }
+    } else {
+        back_pending = true;       /* TxCplt of the last strip / TIM5 starts it */
+    }
+#else
+    if (dma_busy_mask == 0) {
+        start_back_buffer();
+    } else {
+        back_pending = true;       /* TxCplt of the last strip starts it */
+    }
+#endif
+    __enable_irq();
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Encode src and send it. With the strips idle (and the reset over) the
+ * halves swap first and each strip starts the moment the encoder is past it,
+ * strip 0 no longer waits for the others to be encoded; otherwise the back
+ * half is encoded and queued behind the running transfer.
+ */
+static void encode_and_send(const rgb_8b *src)
+{
+#ifdef RENDER_WIRE_CUTS
+#ifdef RENDER_LATCH_TIMER
+    bool idle = dma_busy_mask == 0 && !latch_wait && latch_remaining_us() == 0;
+#else
+    bool idle = dma_busy_mask == 0;
+#endif
+    if (idle) {                    /* nothing but us starts the strips now */
+        __disable_irq();
+        uint8_t *tmp = strip_front;
+        strip_front  = strip_back;
+        strip_back   = tmp;
+        frame_start_cyc = DWT->CYCCNT;
+        /* all strips count as busy until launched: the first one to
+         * finish must not complete the frame */
+        dma_busy_mask = (strip_cnt < 32) ? (1u << strip_cnt) - 1u : UINT32_MAX;
+        __enable_irq();
+        encode_frame(src, strip_front, true);
+        return;
+    }
+#endif
+    encode_frame(src, strip_back, false);
+    launch_or_queue();
+}
+
+#ifdef LED_RENDER_PIPELINE
+/* ────────────────────────────────────────────────────────────────────────
+ * Pipelined path: swap framebuffers, then encode the submitted frame right
+ * away if the back strip buffer is free. Otherwise it stays queued and the
+ * TxCplt ISR encodes it the moment the pending half goes on the wire.
+ */
+static void pipeline_submit(void)
+{
+#ifdef LED_RENDER_LOGICAL
+    remap_dirty();
+#endif
+    __disable_irq();
+    rgb_8b *tmp  = fb_front;
+    fb_front     = framebuffer;
+    framebuffer  = tmp;
+    seq_queued   = seq_submitted;
+#ifdef LED_FB_INDEXED
+    latch_palette();
+#endif
+    take_dirty();
+    frame_queued = true;           /* replaces a queued frame the ISR never got to */
+    __enable_irq();
+
+    /* carry the frame over so fades / trails keep accumulating */
+#ifdef LED_FB_INDEXED
+    memcpy(framebuffer, fb_front, fb_indexed ? pixels_total : sizeof(rgb_8b) * pixels_total);
+#else
+    memcpy(framebuffer, fb_front, sizeof(rgb_8b) * pixels_total);
+#endif
+
+    __disable_irq();
+    bool claim = frame_queued && !back_pending;
+    if (claim) frame_queued = false;
+    __enable_irq();
+
+    if (claim) encode_and_send(fb_front);
+}
+#endif
+#endif /* !LED_RENDER_STREAM */
+
+/* ────────────────────────────────────────────────────────────────────────
+ * framebuffer color -> spi buffer bits
+ * then actually push data out.
+ *
+ * Ping-pong: the frame is encoded into the back strip buffer while the DMAs
+ * may still be draining the front one. If they are, the back buffer is left
+ * pending and HAL_SPI_TxCpltCallback() launches it once the last strip is
+ * done, so this never busy-waits on the SPI state. With the strips idle the
+ * encoder goes strip by strip and starts each one as soon as it is through.
+ *
+ * With LED_RENDER_PIPELINE the framebuffers are double-buffered as well and
+ * a frame that cannot be encoded yet is queued instead of dropped.
+ */
+void render_submit(void)
+{
+    if (!render_ready || fb_target_saved) return;   /* drawing into a layer */
+    dma_watchdog();
+#ifdef LED_RTOS
+    if (!submit_now) {             /* the render task sends it */
+        frame_drawn = true;
+        return;
+    }
+#endif
+#ifdef LED_RENDER_LOGICAL
+    if (!remap_log) return;        /* mapping not handed over yet */
+#endif
+    dma_mem_wait();                /* render_fill_async() still running? */
+
+#ifndef LED_RENDER_PIPELINE
+    // ─── Back buffer still queued behind the running transfer? ─────────────────
+    // Drop this frame instead of waiting; the framebuffer persists and is picked
+    // up again by the next call.
+    if (back_pending) return;
+#endif
+
+#ifndef LED_RENDER_STREAM
+    // ===| Brightness changed (or the power limiter moved it)? rebuild the
+    //      table and re-encode everything
+#ifdef LED_POWER_LIMIT_MA
+    uint8_t brightness = power_limit(g_global_brightness);
+#else
+    uint8_t brightness = g_global_brightness;
+#endif
+#ifdef LED_RENDER_PIPELINE
+    // A queued frame is encoded by the TxCplt / TIM5 ISR with this table:
+    // leave it alone until the queue is empty (only this side fills it), a
+    // later submit picks the new brightness up.
+    if (brightness != encode_brightness && !frame_queued) {
+#else
+    if (brightness != encode_brightness) {
+#endif
+        init_encode_tbl(brightness);
+        render_mark_all_dirty();
+    }
+#endif
+
+#ifdef LED_RENDER_SKIP_UNCHANGED
+    // ===| Same frame as last time? leave encoder and DMAs idle
+#ifdef LED_RENDER_DITHER
+    if (frame_unchanged() && !dither_active()) return;   /* dithering needs every frame */
+#else
+    if (frame_unchanged()) return;
+#endif
+#endif
+
+    ++seq_submitted;
+    PROF_BEGIN(SUBMIT);
+    // ===| Framebuffer → back strip buffer → kick off (or queue) DMA
+#if defined(LED_LINK_MASTER)
+    take_dirty();                  /* the link diffs against its own shadow */
+    link_submit((const uint8_t *)framebuffer, brightness);
+#elif defined(LED_RENDER_STREAM)
+    stream_submit();               /* encoded on the fly by the DMA ISRs */
+#elif defined(LED_RENDER_PIPELINE)
+    pipeline_submit();
+#else
+#ifdef LED_RENDER_LOGICAL
+    remap_dirty();
+#endif
+#ifdef LED_FB_INDEXED
+    latch_palette();
+#endif
+    take_dirty();
+    encode_and_send(framebuffer);
+#endif
+    PROF_END(SUBMIT);
+}
+
+#ifdef LED_RTOS
+bool render_send_drawn(void)
+{
+    if (!frame_drawn) return true;
+    dma_watchdog();                   /* a hung strip would hold the frame forever */
+#ifndef LED_RENDER_PIPELINE
+    if (back_pending) return false;   /* would be dropped: after the next strip */
+#endif
+    frame_drawn = false;
+    submit_now  = true;
+    render_submit();
+    submit_now  = false;
+    return true;
+}
+#endif
+
+#ifdef LED_POWER_LIMIT_MA
+/* ────────────────────────────────────────────────────────────────────────
+ * Current limiter. power_total is what the last encoded frame draws at
+ * encode_brightness (levels after brightness and gamma, so ~linear in mA).
+ * Brightness enters the levels before gamma, so the brightness that just
+ * meets the budget is (b + 1) * (budget / draw)^(1 / gamma) - 1.
+ * Applied to the next frame; going up again only in LED_POWER_HYST steps
+ * so a frame near the limit doesn't re-encode everything each time.
+ */
+#ifdef GAMMA_CORRECTION
+#define POWER_GAMMA  (GAMMA_CORRECTION)
+#else
+#define POWER_GAMMA  1.0f
+#endif
+
+/* measured / modelled current (Q8) and the budget, from supply.h's readings;
+ * the model as is and LED_POWER_LIMIT_MA without them */
+static volatile uint16_t power_gain   = 256;
+static volatile uint32_t power_budget = LED_POWER_LIMIT_MA;
+
+static uint8_t power_limit(uint8_t want)
+{
+    const uint32_t gain  = power_gain;
+    const int32_t budget = (int32_t)power_budget
+                         - (int32_t)(((pixels_total + dark_total) * LED_IDLE_MA_PER_LED * gain) >> 8);
+    const uint32_t draw  = (uint32_t)(((uint64_t)power_total * LED_MA_PER_CHANNEL * gain) / (255u << 8));
+
+    uint32_t fit = 255;
+    if (budget <= 0) {
+        fit = 0;
+    } else if (draw > 0) {
+        float f = (encode_brightness + 1) * fm_powf((float)budget / (float)draw, 1.0f / POWER_GAMMA) - 1.0f;
+        fit = (f <= 0.0f) ? 0 : (f >= 255.0f) ? 255 : (uint32_t)f;
+    }
+    uint8_t cap = (want < fit) ? want : (uint8_t)fit;
+
+    if ((int32_t)draw > budget)       return cap;   /* over budget: drop right away */
+    if (cap <= encode_brightness)     return (want < encode_brightness) ? want : encode_brightness;
+    if (cap == want || cap - encode_brightness >= LED_POWER_HYST) return cap;
+    return encode_brightness;
+}
+
+uint32_t render_power_estimate_ma(void)
+{
+    return (uint32_t)(((uint64_t)power_total * LED_MA_PER_CHANNEL) / 255u)
+         + (uint32_t)(pixels_total + dark_total) * LED_IDLE_MA_PER_LED;
+}
+
+void render_power_feedback(uint16_t gain_q8, uint32_t budget_ma)
+{
+    power_gain   = gain_q8 ? gain_q8 : 256;
+    power_budget = budget_ma < LED_POWER_LIMIT_MA ? budget_ma : LED_POWER_LIMIT_MA;
+}
+#endif
+
+#ifdef LED_RENDER_SKIP_UNCHANGED
+/* ────────────────────────────────────────────────────────────────────────
+ * CRC the framebuffer (hardware unit, one word per write) plus the
+ * brightness. True if it matches the last frame sent and the minimum
+ * refresh interval has not run out yet, otherwise it becomes the new
+ * reference. Skipped frames leave their dirty bits for the next real one.
+ */
+static bool frame_unchanged(void)
+{
+#ifdef LED_FB_INDEXED
+    /* indexed: the index plane, the palette as it will be latched */
+    const size_t   bytes = fb_indexed ? pixels_total : sizeof(rgb_8b) * pixels_total;
+#else
+    const size_t   bytes = sizeof(rgb_8b) * pixels_total;
+#endif
+    const uint32_t words = bytes / 4;                     /* framebuffer is scene_alloc'd, aligned */
+    uint32_t tail[2] = { 0, g_global_brightness | ((uint32_t)encode_brightness << 8) };
+
+    /* tail bytes, requested and applied (power limited) brightness */
+    memcpy(&tail[0], (const uint8_t *)framebuffer + 4 * words, bytes & 3);
+
+    uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)framebuffer, words);
+#ifdef LED_FB_INDEXED
+    if (fb_indexed) {
+        tail[1] |= (uint32_t)pal_shift << 16 | 1u << 24;
+        crc = HAL_CRC_Accumulate(&hcrc, (uint32_t *)pal_draw, 256 * sizeof(rgb_8b) / 4);
+    }
+#endif
+    crc = HAL_CRC_Accumulate(&hcrc, tail, 2);
+
+    uint32_t now = HAL_GetTick();
+    if (sent_valid && crc == sent_crc && (now - sent_ms) < LED_REFRESH_MIN_MS) {
+        return true;
+    }
+    sent_crc   = crc;
+    sent_ms    = now;
+    sent_valid = true;
+    return false;
+}
+#endif
+
+#ifdef LED_RENDER_LOGICAL
+void render_set_remap(const uint16_t *to_phys, const uint16_t *to_logical)
+{
+    dma_mem_wait();
+    __disable_irq();               /* the pipeline / stream ISRs encode through it */
+    remap_phys = to_phys;
+    remap_log  = to_logical;
+    __enable_irq();
+    if (!render_ready) return;     /* init_render() marks everything anyway */
+
+    render_mark_all_dirty();       /* same pixels, all in new places */
+#ifdef LED_RENDER_SKIP_UNCHANGED
+    sent_valid = false;
+#endif
+}
+
+void render_remap_patched(uint16_t first, uint16_t count)
+{
+    if (!render_ready) return;
+    render_mark_dirty(first, count);   /* remap_dirty() finds the new home */
+#ifdef LED_RENDER_SKIP_UNCHANGED
+    sent_valid = false;
+#endif
+}
+#endif
+
+void update_leds(void)
+{
+    render_submit();
+}
+
+void render_target(rgb_8b *buf)
+{
+    dma_mem_wait();                /* a fill into the old target may still run */
+    if (buf) {
+        render_index_end();        /* the pixel functions write RGB from here */
+        if (!fb_target_saved) fb_target_saved = framebuffer;
+        framebuffer = buf;
+    } else if (fb_target_saved) {
+        framebuffer     = fb_target_saved;
+        fb_target_saved = NULL;
+    }
+}
+
+rgb_8b *render_acquire_back(void)
+{
+    dma_mem_wait();
+    if (!render_ready) return NULL;
+    render_index_end();
+    return framebuffer;
+}
+
+bool render_frame_done(void)
+{
+    if (!frame_done) return false;
+    frame_done = false;
+    return true;
+}
+
+uint32_t render_frame_seq(void)
+{
+    return seq_submitted;
+}
+
+uint32_t render_frame_shown(uint32_t *end_cyc)
+{
+    __disable_irq();
+    uint32_t seq = seq_shown;
+    if (end_cyc) *end_cyc = shown_cyc;
+    __enable_irq();
+    return seq;
+}
+
+uint32_t render_dma_errors(void)
+{
+#ifdef LED_OUTPUT_GPIO
+    return dma_errors + gpio_out_errors();
+#else
+    return dma_errors;
+#endif
+}
+
+#ifndef LED_OUTPUT_GPIO
+/* strip hspi drives, strip_cnt if none */
+static uint8_t spi_strip(const SPI_HandleTypeDef *hspi)
+{
+    uint8_t s = 0;
+    while (s < strip_cnt && spi_arr[s] != hspi) ++s;
+    return s;
+}
+#endif
+
+/* ────────────────────────────────────────────────────────────────────────
+ * DMA watchdog, before each submit: a strip still busy LED_DMA_TIMEOUT_US
+ * past twice its wire time has lost its completion (a stream left stuck by
+ * an error, a missed interrupt). It is stopped and finished as if it had
+ * completed, so the frame ends and the next one restarts the bus, instead
+ * of every later frame queueing up behind it.
+ */
+static void dma_watchdog(void)
+{
+    uint32_t busy = dma_busy_mask;
+    if (!busy) return;
+    uint32_t us = (DWT->CYCCNT - frame_start_cyc) / (SystemCoreClock / 1000000U);
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        if (!(busy & (1u << s)) || us < 2u * strips[s].wire_us + LED_DMA_TIMEOUT_US) continue;
+#ifdef LED_OUTPUT_GPIO
+        __disable_irq();
+        gpio_out_stop();                   /* register writes only */
+        if (dma_busy_mask) {
+            ++strips[0].timeouts;
+            gpio_out_tx_done();
+        }
+        __enable_irq();
+#else
+        HAL_SPI_DMAStop(spi_arr[s]);       /* waits for the stream to let go: IRQs on */
+        __disable_irq();
+        if (dma_busy_mask & (1u << s)) {   /* unless it completed meanwhile */
+            ++strips[s].timeouts;
+#ifdef LED_RENDER_STREAM
+            stream_abort(s);
+#else
+            strip_tx_done(s);
+#endif
+        }
+        __enable_irq();
+#endif
+    }
+}
+
+
+#ifndef LED_RENDER_STREAM
+/* ────────────────────────────────────────────────────────────────────────
+ * Swap halves and start one DMA per strip on the freshly encoded buffer.
+ * Only called with IRQs masked or from the DMA ISR, while no strip is busy.
+ */
+static void start_back_buffer(void)
+{
+    uint8_t *tmp = strip_front;
+    strip_front  = strip_back;
+    strip_back   = tmp;
+    seq_front    = seq_back;
+    frame_start_cyc = DWT->CYCCNT;
+
+#ifdef LED_OUTPUT_GPIO
+    /* one transfer for all strips, tracked as bit 0 */
+    dma_busy_mask = 1u;
+    TRACE_BEGIN(SPI_DMA, 0);           /* one track for all pins */
+    gpio_out_start((const uint16_t *)strip_front,
+                   (uint16_t)(pixels_per_str * LED_GPIO_SLOTS_PER_LED));
+#else
+    for (uint8_t s = 0; s < strip_cnt; ++s) launch_strip(s);
+#endif
+}
+
+#ifndef LED_OUTPUT_GPIO
+/* ────────────────────────────────────────────────────────────────────────
+ * Start strip s on the front half. Masks IRQs itself, the DMA ISRs update
+ * dma_busy_mask too.
+ */
+static void launch_strip(uint8_t s)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    TRACE_BEGIN(SPI_DMA, s);
+    dma_busy_mask |= (1u << s);
+    if (HAL_SPI_Transmit_DMA(spi_arr[s], &strip_front[strip_offset(s) - strip_head],
+                             ((strips[s].count + strips[s].dark) * BYTES_PER_LED
+                              + strip_head + strip_tail + strips[s].pad) / SPI_FRAME_BYTES) != HAL_OK) {
+        dma_busy_mask &= ~(1u << s);
+        TRACE_END(SPI_DMA, s);
+        ++strips[s].errors;
+        HAL_SPI_DMAStop(spi_arr[s]);   /* a stream left enabled: free for the next frame */
+    }
+    if (!primask) __enable_irq();
+}
+#endif
+
+/* ────────────────────────────────────────────────────────────────────────
+ * All strips of a frame are done: raise the frame-done event, launch a
+ * pending back buffer and (pipelined) encode a queued frame into the freed half.
+ */
+static void frame_tx_done(void)
+{
+    frame_done = true;
+    seq_shown  = seq_front;
+    shown_cyc  = DWT->CYCCNT;
+#ifdef RENDER_LATCH_TIMER
+    frame_end_cyc = DWT->CYCCNT;
+#ifdef LED_RENDER_PIPELINE
+    if (!back_pending && frame_queued) {   /* back half is free, fill it now */
+        frame_queued = false;
+        encode_frame(fb_front, strip_back, false);
+        back_pending = true;
+    }
+#endif
+    if (back_pending) latch_timer_arm(LED_LATCH_US);
+#else
+    if (back_pending) {
+        back_pending = false;
+        start_back_buffer();
+    }
+#ifdef LED_RENDER_PIPELINE
+    if (frame_queued) {
+        frame_queued = false;
+        encode_frame(fb_front, strip_back, false);
+        if (dma_busy_mask == 0) start_back_buffer();
+        else                    back_pending = true;
+    }
+#endif
+#endif
+}
+
+#ifdef LED_OUTPUT_GPIO
+/* ────────────────────────────────────────────────────────────────────────
+ * led_gpio_out hook – bits and latch are out.
+ */
+void gpio_out_tx_done(void)
+{
+    uint32_t end = DWT->CYCCNT;
+    uint32_t us  = (end - frame_start_cyc) / (SystemCoreClock / 1000000U);
+    dma_busy_mask = 0;
+    TRACE_END(SPI_DMA, 0);
+    ++strips[0].transfers;                 /* the one bus, as dma_busy_mask has it */
+    if (us > strips[0].max_us) strips[0].max_us = us;
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        strips[s].last_us = us;            /* all pins share one transfer */
+        render_strip_done(s, end);
+    }
+    frame_tx_done();
+}
+#else
+/* ────────────────────────────────────────────────────────────────────────
+ * Strip s finished (or aborted) its transfer. The last strip to finish
+ * completes the frame. From the DMA ISRs or with IRQs masked.
+ */
+static void strip_tx_done(uint8_t s)
+{
+    if (s >= strip_cnt || !(dma_busy_mask & (1u << s))) return;   /* the watchdog had it */
+    uint32_t end = DWT->CYCCNT;
+    uint32_t us  = (end - frame_start_cyc) / (SystemCoreClock / 1000000U);
+    dma_busy_mask &= ~(1u << s);
+    TRACE_END(SPI_DMA, s);
+    strips[s].last_us = us;
+    if (us > strips[s].max_us) strips[s].max_us = us;
+    render_strip_done(s, end);
+    if (dma_busy_mask != 0) return;
+
+    frame_tx_done();
+}
+
+/* HAL hooks */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    uint8_t s = spi_strip(hspi);
+    if (s < strip_cnt) ++strips[s].transfers;
+    strip_tx_done(s);
+}
+
+/* transfer or FIFO error: the HAL stops the SPI requests but may leave the
+ * stream enabled, stop it so the next frame can start it again */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    uint8_t s = spi_strip(hspi);
+    ++dma_errors;
+    HAL_SPI_DMAStop(hspi);
+    if (s < strip_cnt) ++strips[s].errors;
+    strip_tx_done(s);
+}
+#endif
+#endif /* !LED_RENDER_STREAM */
+
+
+#ifdef LED_RENDER_STREAM
+/*##############################################################################################*/
+/*### STREAM OUTPUT ###																		*/
+/*##############################################################################################*/
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Zero bytes a strip needs to hold the line low for LED_STREAM_LATCH_US.
+ */
+static uint16_t stream_latch_bytes(uint32_t bitrate)
+{
+    return (uint16_t)(((uint64_t)LED_STREAM_LATCH_US * bitrate / 8 + 999999U) / 1000000U);
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Per-strip state + switch the TX DMAs to circular mode (CubeMX sets normal).
+ */
+static bool stream_init(void)
+{
+    stream = scene_alloc("stream", sizeof(StripStream) * strip_cnt);
+    if (!stream) return false;
+    memset(stream, 0, sizeof(StripStream) * strip_cnt);
+
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        stream[s].first       = strips[s].first;
+        stream[s].count       = strips[s].count;
+        stream[s].latch_bytes = stream_latch_bytes(strips[s].bitrate);
+
+        DMA_HandleTypeDef *hdma = spi_arr[s]->hdmatx;
+        if (!hdma) return false;
+        hdma->Init.Mode = DMA_CIRCULAR;
+        if (HAL_DMA_Init(hdma) != HAL_OK) return false;
+    }
+    return true;
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Encode the next chunk of strip s into one ring half, zero-padding after
+ * the last LED.
+ */
+LED_RAMFUNC static void stream_fill(uint8_t s, uint8_t half)
+{
+    StripStream *st  = &stream[s];
+    uint8_t     *dst = &strip_buffer[(size_t)s * 2 * ring_half_bytes + half * ring_half_bytes];
+    uint8_t     *end = dst + ring_half_bytes;
+
+    st->half_data[half] = (st->next_led < st->count);
+    for (; dst < end && st->next_led < st->count; dst += BYTES_PER_LED) {
+        expand_led(dst, FB_PX(stream_src, st->first + st->next_led), STRIP_TBL(s));
+        st->next_led++;
+    }
+    st->half_zeros[half] = (uint16_t)(end - dst);
+    memset(dst, 0, end - dst);
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Prime both halves of every ring and start the circular DMAs.
+ * Only called while no strip is busy.
+ */
+static void stream_start(const rgb_8b *src)
+{
+    stream_src = src;
+#ifdef LED_RENDER_PIPELINE
+    seq_front  = seq_queued;
+#else
+    seq_front  = seq_submitted;
+#endif
+    frame_start_cyc = DWT->CYCCNT;
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        stream[s].next_led   = 0;
+        stream[s].zeros_sent = 0;
+        stream_fill(s, 0);
+        stream_fill(s, 1);
+
+        dma_busy_mask |= (1u << s);
+        if (HAL_SPI_Transmit_DMA(spi_arr[s], &strip_buffer[(size_t)s * 2 * ring_half_bytes],
+                                 2 * ring_half_bytes) != HAL_OK) {
+            dma_busy_mask &= ~(1u << s);
+        }
+    }
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Streaming submit. The rings are encoded straight from the framebuffer, so
+ * without LED_RENDER_PIPELINE the animation writing it during a transfer can
+ * tear; a frame submitted while still streaming is dropped (or queued when
+ * pipelined, started by the ISR once the latch is out).
+ *
+ * The ISR refills the rings from encode_tbl, so a new brightness is built
+ * here with the strips idle: a frame that would need it is not queued, the
+ * strips stop after the one going out and the next submit starts it.
+ */
+static void stream_submit(void)
+{
+    bool rebuild = (g_global_brightness != encode_brightness);
+#ifdef LED_RENDER_PIPELINE
+    __disable_irq();
+    rgb_8b *tmp  = fb_front;
+    fb_front     = framebuffer;
+    framebuffer  = tmp;
+    seq_queued   = seq_submitted;
+    bool start   = (dma_busy_mask == 0);
+    frame_queued = !start && !rebuild;
+    __enable_irq();
+
+    /* carry the frame over so fades / trails keep accumulating */
+    memcpy(framebuffer, fb_front, sizeof(rgb_8b) * pixels_total);
+    if (!start) return;
+    if (rebuild) init_encode_tbl(g_global_brightness);
+    stream_start(fb_front);
+#else
+    if (dma_busy_mask) return;
+    if (rebuild) init_encode_tbl(g_global_brightness);
+    stream_start(framebuffer);
+#endif
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * A ring half went out on strip s: stop once the data and the latch are on
+ * the wire and the other half is only zeros, otherwise refill it.
+ */
+static void stream_half_done(SPI_HandleTypeDef *hspi, uint8_t half)
+{
+    uint8_t s = spi_strip(hspi);
+    if (s == strip_cnt || !(dma_busy_mask & (1u << s))) return;
+
+    StripStream *st = &stream[s];
+    st->zeros_sent = st->half_data[half] ? st->half_zeros[half]
+                                         : st->zeros_sent + st->half_zeros[half];
+
+    if (st->next_led < st->count || st->half_data[half ^ 1] || st->zeros_sent < st->latch_bytes) {
+        stream_fill(s, half);
+        return;
+    }
+
+    HAL_SPI_DMAStop(hspi);
+    dma_busy_mask &= ~(1u << s);
+    uint32_t end = DWT->CYCCNT;
+    strips[s].last_us = (end - frame_start_cyc) / (SystemCoreClock / 1000000U);
+    ++strips[s].transfers;
+    if (strips[s].last_us > strips[s].max_us) strips[s].max_us = strips[s].last_us;
+    render_strip_done(s, end);
+    if (dma_busy_mask != 0) return;
+
+    frame_done = true;
+    seq_shown  = seq_front;
+    shown_cyc  = end;
+#ifdef LED_RENDER_PIPELINE
+    if (frame_queued) {
+        frame_queued = false;
+        stream_start(fb_front);
+    }
+#endif
+}
+
+void HAL_SPI_TxHalfCpltCallback(SPI_HandleTypeDef *hspi) { stream_half_done(hspi, 0); }
+void HAL_SPI_TxCpltCallback    (SPI_HandleTypeDef *hspi) { stream_half_done(hspi, 1); }
+
+/* a strip's ring stopped before its end: error or watchdog */
+static void stream_abort(uint8_t s)
+{
+    HAL_SPI_DMAStop(spi_arr[s]);
+    dma_busy_mask &= ~(1u << s);
+    if (dma_busy_mask == 0) frame_done = true;
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    uint8_t s = spi_strip(hspi);
+    ++dma_errors;
+    if (s == strip_cnt) return;
+    ++strips[s].errors;
+    stream_abort(s);
+}
+#endif /* LED_RENDER_STREAM */
+
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Per-strip completion hook, override in the application (runs in the ISR).
+ */
+__weak void render_strip_done(uint8_t strip, uint32_t end_cycles)
+{
+    (void)strip;
+    (void)end_cycles;
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Strip descriptor accessors
+ */
+uint8_t render_strip_count(void)
+{
+    return render_ready ? strip_cnt : 0;
+}
+
+const StripInfo *render_strip_info(uint8_t strip)
+{
+    return (render_ready && strip < strip_cnt) ? &strips[strip] : NULL;
+}
+
+#if defined(LED_CLOCK_SCALE) && defined(RENDER_LATCH_TIMER)
+/* ────────────────────────────────────────────────────────────────────────
+ * Bus clock changes (clock_scale.h). The bit rates stay what init_strips()
+ * picked, so do the encoded patterns and the wire times: only the SPI
+ * prescalers move, by as many halvings as the bus clocks.
+ */
+bool render_wire_idle(void)
+{
+    return render_ready && dma_busy_mask == 0 && !back_pending && !latch_wait &&
+#ifdef LED_RENDER_PIPELINE
+           !frame_queued &&
+#endif
+           latch_remaining_us() == 0;
+}
+
+/* the prescaler (BR field) that gets `rate` out of `pclk`, -1 if none does */
+static int8_t spi_br_for(uint32_t pclk, uint32_t rate)
+{
+    for (uint8_t br = 0; br < 8; ++br)
+        if ((pclk >> (br + 1)) == rate && (pclk & ((2u << br) - 1u)) == 0) return (int8_t)br;
+    return -1;
+}
+
+bool render_clock_fits(int8_t shift)
+{
+    if (!render_ready) return false;
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        const uint32_t pclk = spi_pclk(spi_arr[s]);
+        if (spi_br_for(shift >= 0 ? pclk >> shift : pclk << -shift, strips[s].bitrate) < 0) return false;
+    }
+    return true;
+}
+
+bool render_clock_changed(void)
+{
+    bool ok = true;
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        SPI_HandleTypeDef *h  = spi_arr[s];
+        const int8_t       br = spi_br_for(spi_pclk(h), strips[s].bitrate);
+        if (br < 0) { ok = false; continue; }
+        h->Init.BaudRatePrescaler = (uint32_t)br << SPI_CR1_BR_Pos;
+        ok &= HAL_SPI_Init(h) == HAL_OK;
+    }
+    latch_timer_init();                      /* 1 MHz again */
+    return ok;
+}
+#endif
+
+
+/* --------------------------------------------------------------------------
+ * INTERNAL HELPERS
+ * -------------------------------------------------------------------------- */
+#ifndef LED_OUTPUT_GPIO
+/* ────────────────────────────────────────────────────────────────────────
+ * SPI bus clock: SPI1/4 hang off APB2, the others off APB1.
+ */
+static uint32_t spi_pclk(const SPI_HandleTypeDef *hspi)
+{
+    return (hspi->Instance == SPI1 || hspi->Instance == SPI4)
+         ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * SPI bit rate from its bus clock and prescaler.
+ */
+static uint32_t spi_bitrate(const SPI_HandleTypeDef *hspi)
+{
+    return spi_pclk(hspi) / (2u << (hspi->Init.BaudRatePrescaler >> SPI_CR1_BR_Pos));
+}
+#endif
+
+#ifdef LED_OUTPUT_APA102
+/* ────────────────────────────────────────────────────────────────────────
+ * Clocked LEDs don't care about the bit timing: re-init the SPI with the
+ * smallest prescaler that stays at or below LED_APA102_SPI_HZ.
+ */
+static bool apa_spi_clock(SPI_HandleTypeDef *hspi)
+{
+    uint32_t pclk = spi_pclk(hspi);
+    uint32_t br = 0;                                   /* /2 … /256 */
+    while (br < 7 && (pclk >> (br + 1)) > LED_APA102_SPI_HZ) ++br;
+
+    hspi->Init.BaudRatePrescaler = br << SPI_CR1_BR_Pos;
+    return HAL_SPI_Init(hspi) == HAL_OK;
+}
+#endif
+
+#ifdef RENDER_WS_SPI
+/* ────────────────────────────────────────────────────────────────────────
+ * `slots` SPI bits at `rate` last min_ns … max_ns (exact, ns × rate).
+ */
+static bool ws_slots_fit(uint32_t rate, uint8_t slots, uint32_t min_ns, uint32_t max_ns)
+{
+    const uint64_t t = (uint64_t)slots * 1000000000u;
+    return t >= (uint64_t)min_ns * rate && t <= (uint64_t)max_ns * rate;
+}
+
+/* a 0 sent as h0 high SPI bits then low ones, a 1 as h1, LED_WS_SPI_BITS each */
+static bool ws_pattern_fits(uint32_t rate, uint8_t h0, uint8_t h1)
+{
+    return ws_slots_fit(rate, h0, LED_WS_T0H_MIN_NS, LED_WS_T0H_MAX_NS) &&
+           ws_slots_fit(rate, h1, LED_WS_T1H_MIN_NS, LED_WS_T1H_MAX_NS) &&
+           ws_slots_fit(rate, (uint8_t)(LED_WS_SPI_BITS - h0), LED_WS_T0L_MIN_NS, UINT32_MAX) &&
+           ws_slots_fit(rate, (uint8_t)(LED_WS_SPI_BITS - h1), LED_WS_T1L_MIN_NS, UINT32_MAX);
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * WS2812 timing from the SPI clock: re-init the SPI with the smallest
+ * prescaler that some pattern fits at. The first strip picks the pattern,
+ * the others have to fit the same one (there is one encode_tbl).
+ */
+static bool ws_spi_clock(SPI_HandleTypeDef *hspi)
+{
+    const uint32_t pclk = spi_pclk(hspi);
+    for (uint32_t br = 0; br < 8; ++br) {              /* /2 … /256 */
+        const uint32_t rate = pclk >> (br + 1);
+        for (uint8_t h0 = 1; h0 < LED_WS_SPI_BITS; ++h0) {
+            for (uint8_t h1 = h0 + 1; h1 < LED_WS_SPI_BITS; ++h1) {
+                if (ws_h0 && (h0 != ws_h0 || h1 != ws_h1)) continue;
+                if (!ws_pattern_fits(rate, h0, h1)) continue;
+                ws_h0 = h0;
+                ws_h1 = h1;
+                hspi->Init.BaudRatePrescaler = br << SPI_CR1_BR_Pos;
+                return HAL_SPI_Init(hspi) == HAL_OK;
+            }
+        }
+    }
+    return false;
+}
+
+/* ────────────────────────────────────────────────────────────────────────
+ * 4 data bits → 4 × LED_WS_SPI_BITS SPI bits of the picked pattern, MSB
+ * first; init_encode_tbl() puts two of them together per value.
+ */
+static void init_ws_nibbles(void)
+{
+    for (uint8_t v = 0; v < 16; ++v) {
+        uint32_t bits = 0;
+        for (int8_t b = 3; b >= 0; --b) {
+            const uint8_t h = ((v >> b) & 1u) ? ws_h1 : ws_h0;
+            bits = (bits << LED_WS_SPI_BITS) | (((1u << h) - 1u) << (LED_WS_SPI_BITS - h));
+        }
+        ws_nibble[v] = bits;
+    }
+}
+#endif
+
+#ifdef LED_SPI_16BIT
+/* ────────────────────────────────────────────────────────────────────────
+ * 16 bit SPI frames out of the DMA FIFO: halfwords on both sides, memory
+ * read in 4-beat bursts (the SPI itself only takes single beats). Re-inits
+ * the CubeMX byte setup, the wire bits stay the same.
+ */
+static bool spi_16bit(SPI_HandleTypeDef *hspi)
+{
+    DMA_HandleTypeDef *dma = hspi->hdmatx;
+    if (!dma) return false;
+
+    dma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    dma->Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+    dma->Init.FIFOMode            = DMA_FIFOMODE_ENABLE;
+    dma->Init.FIFOThreshold       = DMA_FIFO_THRESHOLD_HALFFULL;   /* one burst */
+    dma->Init.MemBurst            = DMA_MBURST_INC4;
+    dma->Init.PeriphBurst         = DMA_PBURST_SINGLE;
+    hspi->Init.DataSize           = SPI_DATASIZE_16BIT;
+    return HAL_DMA_Init(dma) == HAL_OK && HAL_SPI_Init(hspi) == HAL_OK;
+}
+#endif
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Strip descriptor table: LED_STRIP_LENGTHS if configured (must add up to
+ * pixels_total), else an even split. Fills in clocks and the predicted wire
+ * time so wiring can be balanced, a frame is only as fast as its slowest strip.
+ */
+static bool init_strips(SPI_HandleTypeDef * const *spi_handles)
+{
+    strips = scene_alloc("strips", sizeof(StripInfo) * strip_cnt);
+    if (!strips) return false;
+
+#ifdef LED_STRIP_LENGTHS
+    static const uint16_t lengths[] = LED_STRIP_LENGTHS;
+    if (sizeof lengths / sizeof lengths[0] != strip_cnt) return false;
+#endif
+
+    uint32_t first = 0;
+    pixels_per_str = 0;
+    dark_total     = 0;
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+#ifdef LED_STRIP_LENGTHS
+        uint16_t count = lengths[s];
+#else
+        uint16_t even  = (pixels_total + strip_cnt - 1) / strip_cnt; // ceil div
+        uint16_t count = (first >= pixels_total) ? 0
+                       : (pixels_total - first < even ? pixels_total - first : even);
+#endif
+        strips[s].first = (uint16_t)first;
+        strips[s].count = count;
+        strips[s].dark  = 0;
+        strips[s].pad   = 0;
+        first += count;
+    }
+    if (first != pixels_total) return false;
+
+#ifdef LED_SKIP_RANGES
+    /* wire positions → the pixel the spacers come before; spacers behind the
+     * last pixel need no data at all. A range right at a strip boundary is
+     * the head of the next strip. */
+    static const uint16_t ranges[][2] = LED_SKIP_RANGES;
+    const uint8_t skips = sizeof ranges / sizeof ranges[0];
+    uint16_t skip_at[sizeof ranges / sizeof ranges[0]];
+    uint16_t skip_n [sizeof ranges / sizeof ranges[0]];
+    uint8_t  used     = 0;
+    uint16_t dark     = 0;              /* spacers before range k */
+    uint32_t wire_end = 0;
+    for (uint8_t k = 0; k < skips; ++k) {
+        if (ranges[k][0] < wire_end || !ranges[k][1]) return false;   /* ascending, no overlap */
+        uint16_t at = (uint16_t)(ranges[k][0] - dark);
+        wire_end = (uint32_t)ranges[k][0] + ranges[k][1];
+        dark    += ranges[k][1];
+        if (at >= pixels_total) break;
+        strips[strip_of(at)].dark += ranges[k][1];
+        dark_total   += ranges[k][1];
+        skip_at[used] = at;
+        skip_n[used++] = ranges[k][1];
+    }
+#endif
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        uint16_t wire = strips[s].count + strips[s].dark;
+        if (wire > pixels_per_str) pixels_per_str = wire;
+    }
+
+#ifdef LED_OUTPUT_APA102
+    /* 32 bit start frame; the data runs one clock edge behind per LED, so the
+     * end frame needs count/2 more clocks (zeros also cover SK9822's reset frame) */
+    strip_head = 4;
+    strip_tail = 4 + (pixels_per_str + 15) / 16;
+#endif
+
+    pad_total = 0;
+#ifdef RENDER_WS_SPI
+    ws_h0 = ws_h1 = 0;
+#endif
+#ifdef LED_SPI_16BIT
+    /* whole bursts per strip, so the next one starts 8 byte aligned */
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+        uint32_t bytes = (uint32_t)(strips[s].count + strips[s].dark) * BYTES_PER_LED
+                       + strip_head + strip_tail;
+        strips[s].pad = (uint8_t)(-bytes & (SPI_BURST_BYTES - 1));
+        pad_total    += strips[s].pad;
+    }
+#endif
+
+    for (uint8_t s = 0; s < strip_cnt; ++s) {
+#ifdef LED_OUTPUT_GPIO
+        (void)spi_handles;
+        strips[s].bitrate = 1000000000UL / LED_GPIO_BIT_NS;
+#else
+#ifdef LED_OUTPUT_APA102
+        if (!apa_spi_clock(spi_handles[s])) return false;
+#else
+        if (!ws_spi_clock(spi_handles[s])) return false;
+#endif
+#ifdef LED_SPI_16BIT
+        if (!spi_16bit(spi_handles[s])) return false;
+#endif
+        strips[s].bitrate = spi_bitrate(spi_handles[s]);
+        strips[s].wire_us = (uint32_t)(((uint64_t)((strips[s].count + strips[s].dark) * BYTES_PER_LED
+                                                   + strip_head + strip_tail + strips[s].pad)
+                                        * 8 * 1000000U) / strips[s].bitrate);
+#endif
+    }
+#ifdef RENDER_WS_SPI
+    init_ws_nibbles();
+#endif
+#ifdef LED_OUTPUT_GPIO
+    for (uint8_t s = 0; s < strip_cnt; ++s) {       /* all run as long as the longest */
+        strips[s].wire_us = (uint32_t)(((uint64_t)pixels_per_str * 24 * LED_GPIO_BIT_NS) / 1000U)
+                          + LED_GPIO_LATCH_US;
+    }
+#endif
+#ifdef LED_SKIP_RANGES
+    return init_cuts(skip_at, skip_n, used);
+#elif defined(RENDER_WIRE_CUTS)
+    return init_cuts(NULL, NULL, 0);
+#else
+    return true;
+#endif
+}
+
+#ifdef RENDER_WIRE_CUTS
+/* ────────────────────────────────────────────────────────────────────────
+ * Merge strip boundaries and spacer runs (both ascending) into the cut list.
+ */
+static bool init_cuts(const uint16_t *skip_at, const uint16_t *skip_n, uint8_t skips)
+{
+    cuts = scene_alloc("cuts", sizeof(WireCut) * (strip_cnt + skips));   /* boundaries + skips + end */
+    if (!cuts) return false;
+
+    uint16_t n = 0;
+    uint8_t  s = 1, k = 0;
+    while (s < strip_cnt || k < skips) {
+        uint16_t at_s = (s < strip_cnt) ? strips[s].first : UINT16_MAX;
+        uint16_t at_k = (k < skips)     ? skip_at[k]      : UINT16_MAX;
+        WireCut  c    = { at_s < at_k ? at_s : at_k, 0, 0 };
+        for (; s < strip_cnt && strips[s].first == c.at; ++s)   /* empty strips: one each */
+            c.bytes += strip_head + strip_tail + strips[s - 1].pad;
+        for (; k < skips && skip_at[k] == c.at; ++k)
+            c.dark  += skip_n[k];
+        c.bytes += (uint32_t)c.dark * BYTES_PER_LED;
+        cuts[n++] = c;
+    }
+    cuts[n] = (WireCut){ UINT16_MAX, 0, 0 };
+    return true;
+}
+#endif
+
+#ifdef LED_SKIP_RANGES
+/* ────────────────────────────────────────────────────────────────────────
+ * Spacers are black in both halves once, the encoder never gets there.
+ * (WS2812 zeros are no valid bits, APA102 zeros no LED frame.)
+ */
+static void fill_dark(size_t half_bytes)
+{
+    const rgb_8b black = { 0, 0, 0 };
+    for (const WireCut *c = cuts; c->at != UINT16_MAX; ++c) {
+        size_t off;
+        wire_seek(c->at, &off);                    /* includes c's own bytes */
+        for (uint8_t h = 0; h < 2; ++h) {
+            uint8_t *dst = strip_buffer + h * half_bytes + off - (size_t)c->dark * BYTES_PER_LED;
+            for (uint16_t d = 0; d < c->dark; ++d, dst += BYTES_PER_LED)
+                expand_led(dst, black, STRIP_TBL(0));   /* black on every strip */
+        }
+    }
+}
+#endif
+/* pointers only: the buffers are in the scene pool, emptied as a whole */
+static void free_buffers(void) {
+	dirty_alloc = 0;
+#ifdef LED_RENDER_LOGICAL
+	dirty_tmp = 0;
+#endif
+#ifdef LED_POWER_LIMIT_MA
+	power_blk = 0;
+#endif
+#ifdef LED_RENDER_DITHER
+	dither_err = 0;
+	dither_map = 0;
+#endif
+	strips = 0;
+#ifdef GAMMA_CORRECTION
+	gamma_ram = 0;
+#endif
+#ifdef RENDER_WIRE_CUTS
+	cuts = 0;
+#endif
+#ifdef LED_RENDER_STREAM
+	stream     = 0;
+	stream_src = 0;
+#endif
+	dirty_fb    = 0;
+	dirty_sub   = 0;
+	dirty_last  = 0;
+	fb_alloc    = 0;
+	framebuffer = 0;
+	strip_buffer = 0;
+	strip_front  = 0;
+	strip_back   = 0;
+#ifdef LED_RENDER_PIPELINE
+	fb_front     = 0;
+#endif
+#ifdef LED_FB_INDEXED
+	pal_draw     = 0;
+	pal_enc      = 0;
+	fb_indexed   = false;
+	enc_indexed  = false;
+#endif
+#ifdef LED_STRIP_CAL
+	encode_tbl   = 0;
+	cal_curve    = 0;
+#endif
+}
+
+#ifdef LED_RENDER_DITHER
+/* ────────────────────────────────────────────────────────────────────────
+ * Linear 0…255 (float) -> gamma corrected level in 8.8 fixed point
+ */
+static uint16_t level_fine(float lin)
+{
+#ifdef GAMMA_CORRECTION
+	float l = powf(lin / 255.0f, GAMMA_CORRECTION) * 255.0f;
+#else
+	float l = lin;
+#endif
+	if (l >= 255.0f) return 255u << 8;
+	return (uint16_t)(l * 256.0f + 0.5f);
+}
+#endif
+
+#ifdef LED_STRIP_CAL
+/* ────────────────────────────────────────────────────────────────────────
+ * Strip s, channel ch: level -> gain · 255 · (level / 255)^gamma, what
+ * init_encode_tbl() folds into the strip's tables. Strips past
+ * LED_STRIP_CAL_MAX stay as they are.
+ */
+static void build_cal_curve(uint8_t s, uint8_t ch)
+{
+	const StripCal *k = s < LED_STRIP_CAL_MAX ? &strip_cal[s] : NULL;
+	const float gain  = k && k->gain[ch]  > 0.0f ? k->gain[ch]  : 1.0f;
+	const float gamma = k && k->gamma[ch] > 0.0f ? k->gamma[ch] : 1.0f;
+	for (uint16_t v = 0; v < 256; ++v) {
+		float l = gain * 255.0f * fm_powf(v / 255.0f, gamma) + 0.5f;
+		cal_curve[s][ch][v] = l >= 255.0f ? 255 : (uint8_t)l;
+	}
+}
+
+bool render_strip_cal(uint8_t strip, uint8_t ch, float gain, float gamma)
+{
+	if (strip >= LED_STRIP_CAL_MAX || ch >= ENC_CHANNELS ||
+	    !(gain >= 0.0f && gain <= 2.0f) || !(gamma >= 0.0f && gamma <= 4.0f))
+		return false;
+	strip_cal[strip].gain[ch]  = gain;
+	strip_cal[strip].gamma[ch] = gamma;
+	if (render_ready && strip < strip_cnt) {
+		build_cal_curve(strip, ch);
+		init_encode_tbl(encode_brightness);
+		render_mark_all_dirty();
+	}
+	return true;
+}
+
+const StripCal *render_strip_cal_get(uint8_t strip)
+{
+	return strip < LED_STRIP_CAL_MAX ? &strip_cal[strip] : NULL;
+}
+#endif
+
+/* ────────────────────────────────────────────────────────────────────────
+ * Neopixel encoding, table to convert our RGB into the SPI bitstream:
+ * LED_WS_SPI_BITS per bit, a 0 with ws_h0 of them high (short HIGH, long LOW),
+ * a 1 with ws_h1 (long HIGH, short LOW); 3 bits at 2.6 MHz are 0b100 / 0b110.
+ * Fused: value is scaled by brightness (linear domain), then gamma corrected,
+ * then encoded. Rebuilt by render_submit() whenever g_global_brightness changes.
+ */
+#ifdef LED_OUTPUT_APA102
+/* APA102 / SK9822: brightness goes into the 5-bit global field of every LED
+ * header instead (rounded, 0 stays off), the colors keep their full 8 bits. */
+static void init_encode_tbl(uint8_t brightness) {
+	const uint8_t bright5 = (uint8_t)((brightness * 31u + 127u) / 255u);
+	apa_header = 0xE0 | bright5;
+#ifdef LED_POWER_LIMIT_MA
+	for (uint16_t v = 0; v < 256; ++v) {
+		level_tbl[v] = (uint8_t)((APA_GAMMA(v) * bright5) / 31u);
+	}
+#endif
+#ifdef LED_RENDER_DITHER
+	/* brightness stays in the header, only gamma gets the extra precision */
+	for (uint16_t v = 0; v < 256; ++v) {
+		level16[v] = level_fine((float)v);
+	}
+#endif
+	encode_brightness = brightness;
+}
+#else
+#ifdef RENDER_WS_SPI
+static inline WsBits ws_pattern(uint8_t v) {
+	return ((WsBits)ws_nibble[v >> 4] << (4 * LED_WS_SPI_BITS)) | ws_nibble[v & 15u];
+}
+#endif
+
+static void init_encode_tbl(uint8_t brightness) {
+	for (uint16_t v = 0; v < 256; ++v) {
+#ifdef LED_RENDER_DITHER
+		/* brightness + gamma at 8.8 for the ditherer, the pattern table
+		 * then encodes output levels as they are */
+		level16[v] = level_fine(v * (brightness + 1u) / 256.0f);
+		uint8_t pattern = (uint8_t)v;
+#else
+		uint8_t scaled = (uint8_t)((v * (brightness + 1u)) >> 8);
+#ifdef GAMMA_CORRECTION
+		scaled = gamma8[scaled];
+#endif
+		uint8_t pattern = scaled;
+#endif
+#if defined(LED_OUTPUT_GPIO) || defined(LED_POWER_LIMIT_MA)
+#ifdef LED_RENDER_DITHER
+		uint8_t scaled = (uint8_t)((level16[v] + 128u) >> 8);
+#endif
+		level_tbl[v] = scaled;
+#endif
+#if defined(RENDER_WS_SPI) && defined(LED_STRIP_CAL)
+		for (uint8_t s = 0; s < strip_cnt; ++s)
+			for (uint8_t ch = 0; ch < ENC_CHANNELS; ++ch)
+				encode_tbl[s][ch][v] = ws_pattern(cal_curve[s][ch][pattern]);
+#elif defined(RENDER_WS_SPI)
+		encode_tbl[0][0][v] = ws_pattern(pattern);
+#else
+		(void)pattern;
+#endif
+	}
+	encode_brightness = brightness;
+}
+#endif
 
 #ifdef LED_DEBUG_RENDER_HEAP
 /* ────────────────────────────────────────────────────────────────────────
- * To report remaining free heap (ram)
+ * To report what the hot path costs in RAM
  */
-extern char _estack;
-extern char _sbrk(int incr);
-static size_t bytes_free_heap(void) {
-	char *brk = (char*) _sbrk(0);
-	return (size_t) (&_estack - brk);
+extern char _sramfunc, _eramfunc;
+static size_t bytes_ramfunc(void) {
+	return (size_t) (&_eramfunc - &_sramfunc);
 }
 #endif
@@ -21,22 +21,154 @@ extern "C" {
   #define LED_RENDER_MAX_ALLOC  (16 * 1024)
 #endif
 
+/* flash runs with 2 wait states at 84 MHz: the encoder / pixel hot path goes to
+ * SRAM (.RamFunc, copied over with .data by the startup code). Tables it uses
+ * (encode_tbl, gamma8, level_tbl) are non-const and already live in RAM. */
+#ifdef LED_RENDER_RAMFUNC
+  #define LED_RAMFUNC           __attribute__((section(".RamFunc"), noinline))
+#else
+  #define LED_RAMFUNC
+#endif
+
 /* what order the strip expects bytes in (usually “GRB” or “RGB”) */
 #ifndef LED_COLOR_ORDER
   #define LED_COLOR_ORDER       "GRB"
 #endif
 
+/* LED_RGBW: what one step of the W die looks like through r, g and b, 255
+ * each for a neutral white, lower a channel the white is weak in (warm white:
+ * less blue). The encoder takes that much of each out for every step of W. */
+/* LED_STRIP_CAL: strips calibrated one by one, the first LED_STRIP_CAL_MAX */
+#ifndef LED_STRIP_CAL_MAX
+  #define LED_STRIP_CAL_MAX     3
+#endif
+
+#ifdef LED_RGBW
+#ifndef LED_RGBW_WHITE_R
+  #define LED_RGBW_WHITE_R      255
+#endif
+#ifndef LED_RGBW_WHITE_G
+  #define LED_RGBW_WHITE_G      255
+#endif
+#ifndef LED_RGBW_WHITE_B
+  #define LED_RGBW_WHITE_B      255
+#endif
+#endif
+
+/* WS2812 reset (latch) time between two frames, WS2812B needs > 280 µs */
+#ifndef LED_LATCH_US
+  #define LED_LATCH_US          300
+#endif
+
+/* WS2812 on SPI: SPI bits per LED bit (3, 4 or 5) and the windows a 0 and a 1
+ * have to meet (WS2812B datasheet). init_render() clocks every SPI as fast as
+ * its bus clock allows within them, widen them for a tested overclock. */
+#ifndef LED_WS_SPI_BITS
+  #define LED_WS_SPI_BITS       3
+#endif
+#ifndef LED_WS_T0H_MIN_NS
+  #define LED_WS_T0H_MIN_NS     250
+#endif
+#ifndef LED_WS_T0H_MAX_NS
+  #define LED_WS_T0H_MAX_NS     550
+#endif
+#ifndef LED_WS_T1H_MIN_NS
+  #define LED_WS_T1H_MIN_NS     650
+#endif
+#ifndef LED_WS_T1H_MAX_NS
+  #define LED_WS_T1H_MAX_NS     950
+#endif
+#ifndef LED_WS_T0L_MIN_NS
+  #define LED_WS_T0L_MIN_NS     700
+#endif
+#ifndef LED_WS_T1L_MIN_NS
+  #define LED_WS_T1L_MIN_NS     300
+#endif
+
+/* LED_OUTPUT_APA102: SPI clock ceiling (10.5 MHz on all three SPIs here) */
+#ifndef LED_APA102_SPI_HZ
+  #define LED_APA102_SPI_HZ     12000000UL
+#endif
+
+/* LED_POWER_LIMIT_MA: per channel at full level, quiescent per LED (WS2812B),
+ * and how far the limiter must be able to go up before it re-encodes */
+#ifndef LED_MA_PER_CHANNEL
+  #define LED_MA_PER_CHANNEL    20
+#endif
+#ifndef LED_IDLE_MA_PER_LED
+  #define LED_IDLE_MA_PER_LED   1
+#endif
+#ifndef LED_POWER_HYST
+  #define LED_POWER_HYST        4
+#endif
+
+/* LED_RENDER_SKIP_UNCHANGED: unchanged frames are resent at least this often */
+#ifndef LED_REFRESH_MIN_MS
+  #define LED_REFRESH_MIN_MS    1000
+#endif
+
+/* DMA watchdog: a strip still busy this long past twice its wire time is
+ * aborted (render_submit()), its frame completes without it */
+#ifndef LED_DMA_TIMEOUT_US
+  #define LED_DMA_TIMEOUT_US    2000
+#endif
+
+/* LED_RENDER_STREAM: LEDs per ring half and WS2812 reset time */
+#ifndef LED_STREAM_RING_LEDS
+  #define LED_STREAM_RING_LEDS  8
+#endif
+#ifndef LED_STREAM_LATCH_US
+  #define LED_STREAM_LATCH_US   LED_LATCH_US
+#endif
+
+/* dirty-tracking granularity: 1 << LED_DIRTY_BLOCK_SHIFT physical LEDs per bit */
+#ifndef LED_DIRTY_BLOCK_SHIFT
+  #define LED_DIRTY_BLOCK_SHIFT 3
+#endif
+#define LED_DIRTY_BLOCK         (1u << LED_DIRTY_BLOCK_SHIFT)
+
 /**
- * 8-bit RGB color structure
+ * 8-bit RGB color structure. With LED_PIXEL_32 one aligned word per pixel:
+ * a spare byte after b, never sent, so a pixel is one load / store and the
+ * byte kernels (pixel_simd.h) work on whole pixels.
  */
+#ifdef LED_PIXEL_32
+typedef struct __attribute__((aligned(4))) {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t x;          /* spare, not part of the colour */
+} rgb_8b;
+#else
 typedef struct {
     uint8_t r;
     uint8_t g;
     uint8_t b;
 } rgb_8b;
+#endif
+
+/**
+ * One output strip (SPI bus or GPIO pin), physical LEDs [first, first + count)
+ */
+typedef struct {
+    uint16_t first;     /* physical index of the strip's first LED              */
+    uint16_t count;     /* LEDs on this strip                                   */
+    uint16_t dark;      /* LED_SKIP_RANGES spacers on it (on the wire, no pixels) */
+    uint8_t  pad;       /* LED_SPI_16BIT: tail bytes up to whole DMA bursts      */
+    uint32_t bitrate;   /* output clock in Hz (SPI bit rate, WS2812 rate on GPIO) */
+    uint32_t wire_us;   /* predicted time on the wire for one frame             */
+    uint32_t last_us;   /* measured (DWT) start → TxCplt of the last frame      */
+    /* bus health since boot (telemetry.h) */
+    uint32_t transfers; /* completed                                            */
+    uint32_t errors;    /* SPI / DMA error callbacks, failed starts             */
+    uint32_t timeouts;  /* hung transfers the watchdog aborted                  */
+    uint32_t max_us;    /* longest last_us                                      */
+} StripInfo;
 
 /**
  * Framebuffer holding RGB data for each logical pixel
+ * (with LED_RENDER_PIPELINE this is the back buffer and moves on every
+ *  render_submit(), so don't cache the pointer across frames)
  */
 extern rgb_8b *framebuffer;
 
@@ -47,6 +179,8 @@ extern bool render_ready;
 
 /**
  * Global brightness factor (0-255)
+ * Applied at encode time; changing it rebuilds the encode table and
+ * re-encodes the whole frame on the next render_submit().
  */
 extern uint8_t g_global_brightness;
 
@@ -54,7 +188,8 @@ extern uint8_t g_global_brightness;
  * Initialize the LED renderer
  * @param total_pixels   Total number of logical LEDs
  * @param strip_count    Number of SPI-connected strips
- * @param spi_handles    Array of SPI handle pointers (length = strip_count)
+ * @param spi_handles    Array of SPI handle pointers (length = strip_count),
+ *                       unused (may be NULL) with LED_OUTPUT_GPIO
  * @return true on success, false on failure or insufficient memory
  */
 bool init_render(uint16_t total_pixels,
@@ -62,7 +197,45 @@ bool init_render(uint16_t total_pixels,
                  SPI_HandleTypeDef * const *spi_handles);
 
 /**
- * Shutdown the LED renderer and free resources
+ * Number of strips the renderer drives (0 if not ready)
+ */
+uint8_t render_strip_count(void);
+
+/**
+ * Strip descriptor (LED range, clock, predicted wire time)
+ * @return NULL if not ready or strip out of range
+ */
+const StripInfo *render_strip_info(uint8_t strip);
+
+/**
+ * Bus clock changes (LED_CLOCK_SCALE, WS SPI output only): the strips are
+ * between frames, nothing on the wire or waiting for it, the reset is over.
+ */
+bool render_wire_idle(void);
+
+/**
+ * Would every strip keep its bit rate with the bus clocks divided by
+ * 2^shift (negative: multiplied)?
+ */
+bool render_clock_fits(int8_t shift);
+
+/**
+ * The bus clocks changed: SPI prescalers for the same bit rates as before,
+ * the latch timer at 1 MHz again. Only while render_wire_idle().
+ * @return false if a strip's rate could not be kept
+ */
+bool render_clock_changed(void);
+
+/**
+ * Per-strip completion hook, called from the DMA ISR when a strip finished
+ * its frame. Weak, override to get per-strip timing.
+ * @param strip       Strip index
+ * @param end_cycles  DWT->CYCCNT at the end of transmission
+ */
+void render_strip_done(uint8_t strip, uint32_t end_cycles);
+
+/**
+ * Shutdown the LED renderer: stops the DMAs and drops its buffers (scene pool)
  */
 void led_render_shutdown(void);
 
@@ -71,6 +244,18 @@ void led_render_shutdown(void);
  */
 void set_all_pixels_color(uint8_t r, uint8_t g, uint8_t b);
 
+/**
+ * Start filling the framebuffer with one color on the DMA (dma_mem) and
+ * return right away, everything is marked dirty. Don't touch the
+ * framebuffer until render_fill_wait(); render_submit() waits by itself.
+ */
+void render_fill_async(uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * Block until a render_fill_async() is done (returns at once if none runs)
+ */
+void render_fill_wait(void);
+
 /**
  * Set a single pixel to a specific RGB color
  * @param idx  Pixel index (0-based)
@@ -83,6 +268,57 @@ void set_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b);
  */
 void add_pixel_color(uint16_t idx, uint8_t r, uint8_t g, uint8_t b);
 
+/*
+ * Span primitives: start/count/step like EdgeLedInfo (step +1 or -1, or any
+ * other nonzero stride), the range is validated once per call, out-of-range
+ * calls do nothing.
+ */
+
+/**
+ * Fill a range with one color
+ */
+void fill_pixels(uint16_t start, uint16_t count, int8_t step, rgb_8b c);
+
+/**
+ * Linear blend along a range, `from` at start, `to` at the last pixel
+ */
+void blend_pixels(uint16_t start, uint16_t count, int8_t step, rgb_8b from, rgb_8b to);
+
+/**
+ * Saturating add of src[0..count) onto a range
+ */
+void add_pixels(uint16_t start, uint16_t count, int8_t step, const rgb_8b *src);
+
+/**
+ * Saturating subtract of src[0..count) from a range
+ */
+void subtract_pixels(uint16_t start, uint16_t count, int8_t step, const rgb_8b *src);
+
+/**
+ * Fade the whole frame: channels scaled by ((255 - fade_amt) / 256)^power
+ */
+void fade_pixels(uint8_t fade_amt, uint8_t power);
+
+/**
+ * Copy a precomputed row src[0..count) into a range
+ */
+void copy_pixels(uint16_t start, uint16_t count, int8_t step, const rgb_8b *src);
+
+/**
+ * Mark pixels as changed after writing `framebuffer[]` directly.
+ * The set/add helpers do this themselves; only changed blocks get re-encoded.
+ * @param first  First pixel index (0-based)
+ * @param count  Number of pixels
+ */
+void render_mark_dirty(uint16_t first, uint16_t count);
+
+/**
+ * Write src[0..count) to framebuffer[first..], marking the range dirty only
+ * if a pixel differs: blend passes that rewrite every pixel (layers, fades,
+ * symmetry) leave the unchanged blocks clean. One LED_DIRTY_BLOCK at a time.
+ */
+void render_store_block(uint16_t first, uint16_t count, const rgb_8b *src);
+
 /**
  * Convert HSV (8-bit) to RGB (8-bit)
  */
@@ -95,6 +331,65 @@ void hsv_to_rgb(uint8_t h, uint8_t s, uint8_t v,
 void hsv_to_rgb_rainbow(uint8_t hue, uint8_t sat, uint8_t val,
                      uint8_t *r, uint8_t *g, uint8_t *b);
 
+/**
+ * hsv_to_rgb_rainbow() for n hues at one sat / val, out[i] for hue[i]; the
+ * sat / val work is hoisted out of the loop. hue NULL: hues 0 … n-1.
+ */
+void hsv_rainbow_span(const uint8_t *hue, rgb_8b *out, uint16_t n, uint8_t sat, uint8_t val);
+
+/**
+ * The same straight into the framebuffer, the span as copy_pixels() takes
+ * it: pixel start + i * step gets hue[i], changed ones marked dirty.
+ */
+void hsv_rainbow_pixels(uint16_t start, uint16_t count, int8_t step,
+                        const uint8_t *hue, uint8_t sat, uint8_t val);
+
+#ifdef LED_FB_INDEXED
+/*
+ * Indexed frames: one palette index per LED instead of RGB, looked up in a
+ * 256 entry palette by the encoder. The plane is the framebuffer's memory,
+ * so while it is on the RGB pixel functions must not be used; a full fill
+ * (set_all_pixels_color, render_fill_async) or render_index_end() hands it
+ * back. Anything reading the frame as RGB (render_acquire_back, layers,
+ * transitions) ends it first.
+ */
+
+/**
+ * Switch the framebuffer to indices (cleared to 0 if it was RGB, all dirty).
+ * @return the index plane, total pixels long, framebuffer order; NULL if
+ *         not ready or drawing into a layer (render_target): draw RGB then
+ */
+uint8_t *render_index_plane(void);
+
+/**
+ * Back to RGB, the picture expanded in place through the palette
+ */
+void render_index_end(void);
+
+bool render_is_indexed(void);
+
+/**
+ * The 256 entry palette, taken over (and compared) on render_submit();
+ * a changed entry re-encodes the whole frame
+ */
+rgb_8b *render_palette(void);
+
+/**
+ * Colour cycling: index i shows palette[(i + shift) & 255] from the next
+ * render_submit() on, no LED written
+ */
+void render_palette_rotate(uint8_t shift);
+
+/**
+ * copy_pixels() for indices: pixel start + i * step gets idx[i], changed
+ * ones marked dirty; switches to indexed if it was RGB
+ */
+void index_pixels(uint16_t start, uint16_t count, int8_t step, const uint8_t *idx);
+#else
+#define render_index_end()      ((void)0)
+#define render_is_indexed()     false
+#endif
+
 /**
  * Hue difference calculation (for smooth transitions)
  * @param a  Start hue
@@ -111,9 +406,134 @@ uint8_t random_hue(void);
 
 /**
  * Push current framebuffer out to LED strips via SPI
+ * (same as render_submit(), kept for the animations)
  */
 void update_leds(void);
 
+/**
+ * Submit the framebuffer as the next frame.
+ * Never waits on the SPI DMAs. Without LED_RENDER_PIPELINE a frame submitted
+ * while both strip buffers are busy is dropped; with it the frame is queued
+ * and encoded from the DMA-complete ISR, and `framebuffer` is swapped to the
+ * back buffer (content carried over, so fades keep working).
+ * With LED_RENDER_STREAM the frame is encoded on the fly by the DMA ISRs.
+ * With LED_RENDER_SKIP_UNCHANGED a frame identical to the last one sent (CRC)
+ * is skipped, except once every LED_REFRESH_MIN_MS.
+ */
+void render_submit(void);
+
+#ifdef LED_RTOS
+/**
+ * The RTOS build draws in one task and sends from another (rtos_app.h):
+ * render_submit() only notes that a frame was drawn, this sends it.
+ * @return false while the strips cannot take it yet (both halves busy
+ *         without LED_RENDER_PIPELINE), try again after a strip DMA
+ */
+bool render_send_drawn(void);
+#endif
+
+#ifdef LED_STRIP_CAL
+/*
+ * Strip calibration: the level a channel sends to the LED (brightness and
+ * gamma already applied) goes through gain · 255 · (level / 255)^gamma, per
+ * strip, folded into that strip's encode tables. A 0 counts as 1.
+ */
+typedef struct {
+    float gain[4];      /* r g b (w) */
+    float gamma[4];
+} StripCal;
+
+/**
+ * Change one channel of a strip (0 r, 1 g, 2 b, 3 w with LED_RGBW), the
+ * tables are rebuilt and the whole frame re-encoded
+ * @return false if strip or channel is out of range, gain outside 0 … 2 or
+ *         gamma outside 0 … 4
+ */
+bool render_strip_cal(uint8_t strip, uint8_t ch, float gain, float gamma);
+
+/**
+ * @return the strip's calibration, NULL if strip >= LED_STRIP_CAL_MAX
+ */
+const StripCal *render_strip_cal_get(uint8_t strip);
+#endif
+
+#ifdef LED_POWER_LIMIT_MA
+/**
+ * Estimated current of the frame last encoded (mA), what the limiter sees.
+ * While over LED_POWER_LIMIT_MA the next frame goes out darker than
+ * g_global_brightness.
+ */
+uint32_t render_power_estimate_ma(void);
+
+/**
+ * Correct the limiter with a measurement (supply.h): the model's current is
+ * scaled by gain_q8 / 256 (measured / render_power_estimate_ma()), the
+ * budget lowered to budget_ma (never above LED_POWER_LIMIT_MA). Takes effect
+ * with the next frame's brightness.
+ */
+void render_power_feedback(uint16_t gain_q8, uint32_t budget_ma);
+#endif
+
+#ifdef LED_RENDER_LOGICAL
+/**
+ * Hand over the edge permutation (led_mapping does this on every rebuild).
+ * The framebuffer is indexed logically, the encoder gathers physical LED p
+ * from framebuffer[to_logical[p]]. The arrays must stay valid, length = total
+ * pixels. Nothing is sent until it was called once.
+ */
+void render_set_remap(const uint16_t *to_phys, const uint16_t *to_logical);
+
+/**
+ * The mapping rewrote the arrays for logical pixels [first, first + count)
+ * in place, re-encode them at their new physical place.
+ */
+void render_remap_patched(uint16_t first, uint16_t count);
+#endif
+
+/**
+ * Point the pixel functions at buf (total pixels long, e.g. a compositor
+ * layer) instead of the framebuffer. render_submit() / update_leds() do
+ * nothing until render_target(NULL) switches back.
+ */
+void render_target(rgb_8b *buf);
+
+/**
+ * Framebuffer the next frame should be drawn into (== framebuffer).
+ * @return NULL if the renderer is not ready
+ */
+rgb_8b *render_acquire_back(void);
+
+/**
+ * Frame-done event: true once after the last strip of a frame finished
+ * transmitting, then cleared.
+ */
+bool render_frame_done(void);
+
+/**
+ * Frames by number: render_frame_seq() counts the submitted ones,
+ * render_frame_shown() is the number of the last whose DMA finished (a
+ * dropped or skipped frame is never shown, a later one is) and when.
+ * @param end_cyc  DWT->CYCCNT at its completion, may be NULL
+ */
+uint32_t render_frame_seq(void);
+uint32_t render_frame_shown(uint32_t *end_cyc);
+
+/**
+ * Output DMA errors since boot (SPI error callbacks, GPIO DMA errors); the
+ * per strip counters are in render_strip_info()
+ */
+uint32_t render_dma_errors(void);
+
+/**
+ * The encoder's inner loop on its own: n LEDs of src into dst the way the
+ * frame encoder writes them (tables, gamma, brightness, color order), with
+ * no dirty walk, strip cuts or remap. The reference the encoder micro-
+ * benchmarks time (render_bench.h); not with LED_OUTPUT_GPIO. With
+ * LED_SPI_16BIT in halfword order: dst halfword aligned, an even count.
+ * @return bytes per LED written
+ */
+uint8_t render_encode_leds(uint8_t *dst, const rgb_8b *src, uint16_t n);
+
 #ifdef __cplusplus
 }
 #endif
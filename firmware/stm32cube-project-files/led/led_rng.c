@@ -0,0 +1,67 @@
+/* --------------------------------------------------------------------------
+ * led_rng.c – global seed, named streams, bulk fills
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "led_rng.h"
+
+static uint32_t rng_seed_val = RNG_SEED;
+
+Rng rng_global = { RNG_SEED ? RNG_SEED : 1u };
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Integer hash, spreads seed ^ name so neighbouring seeds / similar names
+ * give unrelated streams
+ */
+static uint32_t mix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+void rng_seed(uint32_t seed)
+{
+    rng_seed_val = seed;
+    rng_stream(&rng_global, NULL);
+}
+
+uint32_t rng_seed_get(void) { return rng_seed_val; }
+
+/* unnamed = the seed itself, so rng_global after rng_seed(RNG_SEED) is the
+ * one from boot */
+void rng_stream(Rng *r, const char *name)
+{
+    uint32_t s = rng_seed_val;
+    if (name) {
+        uint32_t h = 2166136261u;             /* FNV-1a of the name */
+        for (; *name; ++name) h = (h ^ (uint8_t)*name) * 16777619u;
+        s = mix32(s ^ h);
+    }
+    r->s = s ? s : 1u;
+}
+
+void rng_fill(Rng *r, uint8_t *dst, size_t n)
+{
+    for (; n >= 4; n -= 4, dst += 4) {
+        uint32_t w = rng_u32(r);
+        memcpy(dst, &w, 4);
+    }
+    if (n) {
+        uint32_t w = rng_u32(r);
+        memcpy(dst, &w, n);
+    }
+}
+
+void rng_fill_below(Rng *r, uint16_t *dst, size_t n, uint16_t bound)
+{
+    /* two values per draw, 16 bits each through the same multiply-shift */
+    for (; n >= 2; n -= 2, dst += 2) {
+        uint32_t w = rng_u32(r);
+        dst[0] = (uint16_t)(((w & 0xFFFFu) * bound) >> 16);
+        dst[1] = (uint16_t)(((w >> 16) * bound) >> 16);
+    }
+    if (n) *dst = (uint16_t)rng_below(r, bound);
+}
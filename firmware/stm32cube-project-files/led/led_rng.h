@@ -0,0 +1,90 @@
+/*
+ * led_rng.h – small deterministic random streams for the animations
+ *
+ * xorshift32, one word of state per stream, no hidden global state like
+ * newlib's rand(). Streams are derived from one global seed and a name
+ * (the animation's), so an effect replays the same way every time it starts
+ * with the same seed: reproducible benchmark runs, and animations don't
+ * disturb each other's sequence.
+ */
+
+#ifndef _LED_RNG_H_
+#define _LED_RNG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"        /* RNG_SEED */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* global seed at boot (changed at runtime with rng_seed / "seed <n>") */
+#ifndef RNG_SEED
+  #define RNG_SEED              0xA5A5A5A5u
+#endif
+
+typedef struct {
+    uint32_t s;             /* never 0 */
+} Rng;
+
+/* shared stream for whoever has none of their own */
+extern Rng rng_global;
+
+/**
+ * Set the global seed, rng_global restarts from it. Stream seeded afterwards
+ * follow it, running ones keep going until reseeded.
+ */
+void rng_seed(uint32_t seed);
+
+/**
+ * Current global seed
+ */
+uint32_t rng_seed_get(void);
+
+/**
+ * Seed stream r from the global seed and name (NULL = unnamed)
+ */
+void rng_stream(Rng *r, const char *name);
+
+static inline uint32_t rng_u32(Rng *r)
+{
+    uint32_t x = r->s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return r->s = x;
+}
+
+/**
+ * Uniform in [0, n), multiply-shift instead of a division (n = 0 gives 0)
+ */
+static inline uint32_t rng_below(Rng *r, uint32_t n)
+{
+    return (uint32_t)(((uint64_t)rng_u32(r) * n) >> 32);
+}
+
+/**
+ * Uniform in [0, 1)
+ */
+static inline float rng_float(Rng *r)
+{
+    return (float)(rng_u32(r) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * Fill dst with n random bytes, four per step
+ */
+void rng_fill(Rng *r, uint8_t *dst, size_t n);
+
+/**
+ * Fill dst with n values in [0, bound)
+ */
+void rng_fill_below(Rng *r, uint16_t *dst, size_t n, uint16_t bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_RNG_H_ */
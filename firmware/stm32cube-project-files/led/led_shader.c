@@ -0,0 +1,204 @@
+/* --------------------------------------------------------------------------
+ * led_shader.c – block dispatcher for the per-LED animation kernels
+ * -------------------------------------------------------------------------- */
+#include "led_shader.h"
+#include "led_mapping.h"   /* edge_info, edge_base, led_pos, led_attr */
+#include "frame_clock.h"   /* frame count: interlace phase */
+
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Inputs of one block, LED k sits at framebuffer index px + k * step and
+ * at offset + k * (inv / dt) along the edge. Runs once per LED per frame
+ * for every effect, hence in SRAM.
+ */
+static LED_RAMFUNC void gather_block(const LedPos *pos, uint16_t px, int8_t step,
+                                     uint16_t offset, uint16_t n, float inv, float dt,
+                                     float *x, float *y, float *z, float *t)
+{
+    if (x) {
+        const LedPos *p = pos + px;
+        for (uint16_t k = 0; k < n; ++k, p += step) {
+            x[k] = LED_POS_F(p->x);
+            y[k] = LED_POS_F(p->y);
+            z[k] = LED_POS_F(p->z);
+        }
+    }
+    if (t) {
+        float tk = offset * inv;
+        for (uint16_t k = 0; k < n; ++k, tk += dt) t[k] = tk;
+    }
+}
+
+/* what every run needs, looked up once */
+typedef struct {
+    const EdgeLedInfo *info;
+    const uint16_t    *base;
+    const LedPos      *pos;
+    const LedAttr     *attr;
+    float              x[SHADER_BLOCK], y[SHADER_BLOCK], z[SHADER_BLOCK], t[SHADER_BLOCK];
+    rgb_8b             out[SHADER_BLOCK];
+    ShaderBlock        b;
+    uint8_t            il_n;      /* interlace phases, 1 = off */
+    uint8_t            il_phase;  /* this frame's one          */
+} ShaderRun;
+
+static bool run_begin(ShaderRun *r, const Shader *s)
+{
+    r->info = mapping_get_edge_info();
+    r->base = mapping_get_edge_base();
+    r->pos  = NULL;
+    r->attr = NULL;
+    if (!r->info || !r->base || !s || !s->kernel) return false;
+    if (s->inputs & SHADER_IN_POS) {
+        r->pos = mapping_get_led_pos();
+        if (!r->pos) return false;
+    }
+    if (s->inputs & SHADER_IN_ATTR) {
+        r->attr = mapping_get_led_attr();
+        if (!r->attr) return false;
+    }
+    r->b.x = r->pos ? r->x : NULL;
+    r->b.y = r->pos ? r->y : NULL;
+    r->b.z = r->pos ? r->z : NULL;
+    r->b.t = (s->inputs & SHADER_IN_T) ? r->t : NULL;
+
+    /* interlace: 2 or 4 phases, one per frame in turn; additive shaders draw
+     * on a faded frame, an LED left out would just go dark */
+    uint8_t n = s->interlace & SHADER_IL_PHASES;
+    r->il_n     = (s->blend == SHADER_WRITE && (n == 2 || n == 4)) ? n : 1;
+    r->il_phase = (uint8_t)(frame_clock_stats()->frames % r->il_n);
+    return true;
+}
+
+/* evaluated LEDs halfway from what they show to the new value */
+static LED_RAMFUNC void ease_block(const ShaderBlock *b, rgb_8b *out)
+{
+    const rgb_8b *p = framebuffer + b->px;
+    for (uint16_t k = 0; k < b->n; ++k, p += b->step) {
+        out[k].r = (uint8_t)((p->r + out[k].r + 1) >> 1);
+        out[k].g = (uint8_t)((p->g + out[k].g + 1) >> 1);
+        out[k].b = (uint8_t)((p->b + out[k].b + 1) >> 1);
+    }
+}
+
+/* n LEDs of edge e from i0, stride apart, evaluated into r->out */
+static void eval_block(ShaderRun *r, const Shader *s, const void *uniforms, const EdgeLedInfo *inf,
+                       float inv, uint16_t i0, uint16_t n, uint8_t stride)
+{
+    ShaderBlock *b = &r->b;
+    b->stride  = stride;
+    b->step    = (int8_t)(inf->step * stride);
+    b->offset  = i0;
+    b->n       = n;
+    b->logical = (uint16_t)(r->base[b->edge] + i0);
+    b->px      = (uint16_t)(inf->start + i0 * inf->step);
+    b->attr    = r->attr ? r->attr + b->px : NULL;
+    gather_block(r->pos, b->px, b->step, i0, n, inv, inv * stride,
+                 r->pos ? r->x : NULL, r->y, r->z, b->t ? r->t : NULL);
+    s->kernel(b, uniforms, r->out);
+}
+
+/* LEDs [i0, i1) of edge e: control points every N-th LED and the last one,
+ * straight lines in between */
+static void run_coarse(ShaderRun *r, const Shader *s, const void *uniforms,
+                       poly_idx_t e, uint16_t i0, uint16_t i1, uint8_t N)
+{
+    const EdgeLedInfo inf = r->info[e];
+    const float       inv = (inf.count > 1) ? 1.0f / (float)(inf.count - 1) : 0.0f;
+    if (i1 > inf.count) i1 = inf.count;
+    if (i0 >= i1) return;
+    r->b.edge  = e;
+    r->b.count = inf.count;
+
+    const uint16_t last = (uint16_t)(i1 - 1u);
+    uint16_t       at   = i0;            /* the control point drawn up to */
+    rgb_8b         c    = { 0 };
+    bool           have = false;
+    for (uint16_t o = i0; o <= last; ) {
+        uint16_t n = (uint16_t)((last - o) / N + 1u);
+        if (n > SHADER_BLOCK) n = SHADER_BLOCK;
+        eval_block(r, s, uniforms, &inf, inv, o, n, N);
+        for (uint16_t k = 0; k < n; ++k, o += N) {
+            if (have) blend_pixels((uint16_t)(inf.start + at * inf.step), (uint16_t)(o - at + 1u),
+                                   inf.step, c, r->out[k]);
+            at   = o;
+            c    = r->out[k];
+            have = true;
+        }
+    }
+    if (at != last) {                    /* the last LED off the grid */
+        eval_block(r, s, uniforms, &inf, inv, last, 1, 1);
+        blend_pixels((uint16_t)(inf.start + at * inf.step), (uint16_t)(last - at + 1u),
+                     inf.step, c, r->out[0]);
+    } else if (at == i0) {               /* a single LED */
+        copy_pixels((uint16_t)(inf.start + at * inf.step), 1, inf.step, &c);
+    }
+}
+
+/* LEDs [i0, i1) of edge e (this frame's share of them), in blocks */
+static void run_range(ShaderRun *r, const Shader *s, const void *uniforms,
+                      poly_idx_t e, uint16_t i0, uint16_t i1)
+{
+    if (s->coarse > 1 && s->blend == SHADER_WRITE) {
+        run_coarse(r, s, uniforms, e, i0, i1, s->coarse);
+        return;
+    }
+    EdgeLedInfo  inf    = r->info[e];
+    ShaderBlock *b      = &r->b;
+    float        inv    = (inf.count > 1) ? 1.0f / (float)(inf.count - 1) : 0.0f;
+    uint8_t      stride = 1;
+    if (i1 > inf.count) i1 = inf.count;
+
+    if (r->il_n > 1) {
+        if (s->interlace & SHADER_IL_EDGES) {
+            if (e % r->il_n != r->il_phase) return;
+        } else {
+            /* every N-th logical pixel, so neighbours across a vertex alternate too */
+            i0 += (uint16_t)((r->il_phase + r->il_n - (r->base[e] + i0) % r->il_n) % r->il_n);
+            stride = r->il_n;
+        }
+    }
+    b->edge   = e;
+    b->count  = inf.count;
+    b->stride = stride;
+    b->step   = (int8_t)(inf.step * stride);
+
+    for (; i0 < i1; i0 += SHADER_BLOCK * stride) {
+        uint16_t n = (uint16_t)((i1 - i0 + stride - 1) / stride);
+        if (n > SHADER_BLOCK) n = SHADER_BLOCK;
+        b->offset  = i0;
+        b->n       = n;
+        b->logical = (uint16_t)(r->base[e] + i0);
+        b->px      = (uint16_t)(inf.start + i0 * inf.step);
+        b->attr    = r->attr ? r->attr + b->px : NULL;
+
+        gather_block(r->pos, b->px, b->step, i0, n, inv, inv * stride,
+                     r->pos ? r->x : NULL, r->y, r->z, b->t ? r->t : NULL);
+        s->kernel(b, uniforms, r->out);
+        if (r->il_n > 1 && (s->interlace & SHADER_IL_BLEND)) ease_block(b, r->out);
+
+        if (s->blend == SHADER_ADD) add_pixels (b->px, n, b->step, r->out);
+        else                        copy_pixels(b->px, n, b->step, r->out);
+    }
+}
+
+bool shader_run(const Shader *s, const void *uniforms)
+{
+    ShaderRun r;
+    if (!run_begin(&r, s)) return false;
+    poly_idx_t E = mapping_get_edge_count();
+    for (poly_idx_t e = 0; e < E; ++e) run_range(&r, s, uniforms, e, 0, r.info[e].count);
+    return true;
+}
+
+bool shader_run_spans(const Shader *s, const void *uniforms, const ShaderSpan *spans, uint16_t n)
+{
+    ShaderRun r;
+    if (!run_begin(&r, s) || (n && !spans)) return false;
+    poly_idx_t E = mapping_get_edge_count();
+    for (uint16_t i = 0; i < n; ++i) {
+        if (spans[i].edge >= E) continue;
+        run_range(&r, s, uniforms, spans[i].edge, spans[i].offset, spans[i].offset + spans[i].count);
+    }
+    return true;
+}
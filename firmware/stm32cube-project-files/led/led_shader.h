@@ -0,0 +1,124 @@
+/*
+ * led_shader.h – per-LED kernels for the animations
+ *
+ * An effect hands over a kernel plus its per-frame uniforms (whatever it
+ * worked out once for the frame: view rotation, phase, palette). shader_run()
+ * walks the edges in logical order and calls the kernel on blocks of up to
+ * SHADER_BLOCK LEDs of one edge, inputs laid out structure-of-arrays (x[],
+ * y[], z[], t[]), the kernel writes one rgb_8b per LED and the block goes
+ * out as a span (copy_pixels / add_pixels). The gather loop is the one place
+ * to tune for every effect.
+ *
+ * Interlaced (Shader.interlace): a kernel too slow for every LED every frame
+ * gets 1/2 or 1/4 of them per frame, a different share each frame (every
+ * N-th LED along the strip, or every N-th edge), the rest hold what they
+ * showed last. Cost per frame drops by N, each LED is fresh every N frames.
+ *
+ * Coarse (Shader.coarse): a kernel whose field is smooth along an edge (the
+ * plasma, a wide shockwave) is evaluated only at every N-th LED of the edge
+ * and at its last one; blend_pixels() fills the LEDs in between with the
+ * straight line from one control point to the next. Cost drops by about N
+ * every frame and every LED is fresh, so it goes before interlacing (which
+ * it replaces) for fields that are slow across a few LEDs.
+ */
+
+#ifndef _LED_SHADER_H_
+#define _LED_SHADER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_render.h"    /* rgb_8b */
+#include "polyhedron.h"    /* poly_idx_t */
+#include "led_mapping.h"   /* LedAttr */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* LEDs per kernel call, 17 bytes stack each (x, y, z, t, rgb) */
+#ifndef SHADER_BLOCK
+  #define SHADER_BLOCK          32
+#endif
+
+/* what the dispatcher gathers for a kernel (Shader.inputs) */
+#define SHADER_IN_POS           0x01u   /* x[] y[] z[]: LED position (mapping cache, LED space) */
+#define SHADER_IN_T             0x02u   /* t[]: 0 at the edge's A end .. 1 at B                 */
+#define SHADER_IN_ATTR          0x04u   /* attr: the static per-LED attributes (mapping)        */
+
+/* Shader.interlace: phase count in the low bits, flags on top */
+#define SHADER_IL_2             0x02u   /* half the LEDs per frame                              */
+#define SHADER_IL_4             0x04u   /* a quarter                                            */
+#define SHADER_IL_PHASES        0x0Fu
+#define SHADER_IL_EDGES         0x10u   /* pick whole edges (edge index) instead of every N-th LED */
+#define SHADER_IL_BLEND         0x20u   /* evaluated LEDs go halfway to the new value, softer   */
+
+/* Shader.coarse: LEDs between two control points */
+#define SHADER_COARSE_2         2
+#define SHADER_COARSE_4         4
+#define SHADER_COARSE_8         8
+
+typedef enum {
+    SHADER_WRITE,                       /* out[] replaces the pixels              */
+    SHADER_ADD,                         /* out[] is added on top (saturating),    */
+                                        /* never interlaced: held LEDs fade away  */
+} ShaderBlend;
+
+/**
+ * One block: LEDs offset, offset + stride, ... (n of them) of logical edge
+ * `edge`, walked A→B. stride is 1 unless interlaced or coarse. Inputs not
+ * asked for are NULL.
+ */
+typedef struct {
+    poly_idx_t   edge;      /* logical edge                                   */
+    uint16_t     offset;    /* LED 0 of the block along the edge (A end = 0)  */
+    uint16_t     n;         /* LEDs in the block, 1..SHADER_BLOCK             */
+    uint8_t      stride;    /* along the edge between LED k and k + 1         */
+    uint16_t     count;     /* LEDs on the whole edge                         */
+    uint16_t     logical;   /* logical pixel index of LED 0                   */
+    uint16_t     px;        /* framebuffer index of LED 0 ...                 */
+    int8_t       step;      /* ... LED k is at px + k * step (stride folded in) */
+    const float *x, *y, *z;
+    const float *t;
+    const LedAttr *attr;    /* LED k's at attr[k * step]                      */
+} ShaderBlock;
+
+/**
+ * Per-LED kernel: fill out[0..b->n) from the block and the uniforms
+ */
+typedef void (*ShaderKernel)(const ShaderBlock *b, const void *uniforms, rgb_8b *out);
+
+typedef struct {
+    ShaderKernel kernel;
+    uint8_t      inputs;    /* SHADER_IN_* */
+    ShaderBlend  blend;
+    uint8_t      interlace; /* SHADER_IL_*, 0 = every LED every frame */
+    uint8_t      coarse;    /* SHADER_COARSE_*, 0 = every LED; SHADER_WRITE only,
+                               interlace is ignored then */
+} Shader;
+
+/**
+ * Run a shader over every LED of the current mapping (its share of them
+ * this frame, if interlaced)
+ * @param uniforms  handed to every kernel call as is
+ * @return false if the mapping (or the position cache, for SHADER_IN_POS)
+ *         is not there, nothing drawn then
+ */
+bool shader_run(const Shader *s, const void *uniforms);
+
+/* LEDs [offset, offset + count) of logical edge `edge` */
+typedef struct {
+    poly_idx_t edge;
+    uint16_t   offset;
+    uint16_t   count;
+} ShaderSpan;
+
+/**
+ * Same, over the given spans only (led_symmetry's fundamental domain, ...)
+ */
+bool shader_run_spans(const Shader *s, const void *uniforms, const ShaderSpan *spans, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_SHADER_H_ */
@@ -0,0 +1,273 @@
+/* --------------------------------------------------------------------------
+ * led_spatial.c – per-edge bounding spheres and shell queries, axis sorted
+ *                 LED orders and band queries
+ * -------------------------------------------------------------------------- */
+#include "led_spatial.h"
+
+#include <math.h>
+#include "scene_mem.h"
+#include "fast_math.h"
+
+extern Polyhedron poly;
+
+typedef struct {
+    float c[3];            /* midpoint of the first and last LED */
+    float r;               /* half their distance                */
+    float d[3];            /* position step from one LED to the next (walk order) */
+    float a[3];            /* first LED of the walk                */
+} EdgeBound;
+
+static EdgeBound *bounds    = NULL;    /* len = E, scene pool */
+static poly_idx_t bound_cnt = 0;
+static uint32_t   bound_gen = 0;       /* mapping_generation() they were built for */
+
+static inline void pos_xyz(const LedPos *pos, uint16_t i, float out[3])
+{
+    out[0] = LED_POS_F(pos[i].x);
+    out[1] = LED_POS_F(pos[i].y);
+    out[2] = LED_POS_F(pos[i].z);
+}
+
+static inline float dist2_to(const float a[3], const float b[3])
+{
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx*dx + dy*dy + dz*dz;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * O(E), only when the mapping changed (remap, flip, new geometry)
+ */
+static bool ensure_bounds(void)
+{
+    const LedPos      *pos  = mapping_get_led_pos();
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    if (!pos || !info) return false;
+    if (bounds && bound_gen == mapping_generation()) return true;
+
+    poly_idx_t E = mapping_get_edge_count();
+
+    if (!bounds) {                       /* E is fixed per scene */
+        bounds    = scene_alloc("bounds", E * sizeof *bounds);
+        bound_cnt = bounds ? E : 0;
+        if (!bounds) return false;
+    }
+    for (poly_idx_t e = 0; e < E; ++e) {
+        EdgeBound *b = &bounds[e];
+        const EdgeLedInfo inf = info[e];
+        float z[3];
+        pos_xyz(pos, inf.start, b->a);
+        pos_xyz(pos, (uint16_t)(inf.start + (inf.count - 1) * inf.step), z);
+        for (int k = 0; k < 3; ++k) {
+            b->c[k] = 0.5f * (b->a[k] + z[k]);
+            b->d[k] = inf.count > 1 ? (z[k] - b->a[k]) / (inf.count - 1) : 0.f;
+        }
+        b->r = 0.5f * fm_sqrtf(dist2_to(b->a, z)) + 1e-4f;
+    }
+    bound_gen = mapping_generation();
+    return true;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Range of LEDs on edge e that can be within r1: |a + i·d - p|² <= r1²
+ * is a quadratic in i. Widened by one LED each side, next() does the exact
+ * test on the stored positions anyway.
+ */
+static bool clip_edge(LedShellIter *it, poly_idx_t e)
+{
+    const EdgeBound *b = &bounds[e];
+    float dc = fm_sqrtf(dist2_to(b->c, it->p));
+    if (dc + b->r < it->r0 || dc - b->r > it->r1) return false;   /* sphere reject */
+
+    it->inf   = mapping_get_edge_info()[e];
+    float ap[3] = { b->a[0] - it->p[0], b->a[1] - it->p[1], b->a[2] - it->p[2] };
+    float qa  = b->d[0]*b->d[0] + b->d[1]*b->d[1] + b->d[2]*b->d[2];
+    float qb  = 2.f * (ap[0]*b->d[0] + ap[1]*b->d[1] + ap[2]*b->d[2]);
+    float qc  = ap[0]*ap[0] + ap[1]*ap[1] + ap[2]*ap[2] - it->r1_2;
+
+    int32_t lo = 0, hi = it->inf.count;               /* [lo, hi) */
+    if (qa > 0.f) {
+        float disc = qb*qb - 4.f*qa*qc;
+        if (disc < 0.f) return false;
+        float s  = fm_sqrtf(disc);
+        int32_t l = (int32_t)floorf((-qb - s) / (2.f*qa)) - 1;
+        int32_t h = (int32_t)ceilf ((-qb + s) / (2.f*qa)) + 2;
+        if (l > lo) lo = l;
+        if (h < hi) hi = h;
+    }
+    if (lo >= hi) return false;
+    it->edge  = e;
+    it->i     = (uint16_t)lo;
+    it->i_end = (uint16_t)hi;
+    return true;
+}
+
+void spatial_shell_begin(LedShellIter *it, const float p[3], float r0, float r1)
+{
+    it->p[0] = p[0]; it->p[1] = p[1]; it->p[2] = p[2];
+    it->r0   = r0 > 0.f ? r0 : 0.f;
+    it->r1   = r1;
+    it->r0_2 = it->r0 * it->r0;
+    it->r1_2 = r1 * r1;
+    it->i    = it->i_end = 0;
+    it->edge = POLY_IDX_NONE;               /* before the first edge */
+    it->edge_end = (ensure_bounds() && r1 >= it->r0) ? bound_cnt : 0;
+}
+
+bool spatial_shell_next(LedShellIter *it, uint16_t *idx, float *dist2)
+{
+    const LedPos *pos = mapping_get_led_pos();
+    for (;;) {
+        while (it->i < it->i_end) {
+            uint16_t px = (uint16_t)(it->inf.start + it->i * it->inf.step);
+            ++it->i;
+            float q[3];
+            pos_xyz(pos, px, q);
+            float d2 = dist2_to(q, it->p);
+            if (d2 < it->r0_2 || d2 > it->r1_2) continue;
+            *idx   = px;
+            *dist2 = d2;
+            return true;
+        }
+        /* next edge that survives the sphere test */
+        do {
+            if ((poly_idx_t)(it->edge + 1) >= it->edge_end) return false;
+            ++it->edge;
+        } while (!clip_edge(it, it->edge));
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Axis orders: a shell sort of the pixel indices by projection, O(n^1.3),
+ * close to O(n) when re-sorting the last order after a small rotation
+ */
+typedef struct {
+    uint16_t   *ord;       /* len = total pixels, scene pool */
+    uint32_t    gen;       /* mapping_generation() it was sorted for */
+    uint32_t    used;      /* last query, for the slot to give up */
+    SpatialAxis axis;
+    float       dir[3];
+} AxisOrder;
+
+static AxisOrder axes[SPATIAL_AXIS_SLOTS];
+static uint32_t  axis_queries;
+
+static inline float proj(const LedPos *pos, uint16_t i, const float d[3])
+{
+    return LED_POS_F(pos[i].x) * d[0] + LED_POS_F(pos[i].y) * d[1] + LED_POS_F(pos[i].z) * d[2];
+}
+
+static void normalize3(float v[3])
+{
+    float l = fm_sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    if (l < 1e-6f) { v[0] = 0.f; v[1] = 0.f; v[2] = 1.f; return; }
+    v[0] /= l; v[1] /= l; v[2] /= l;
+}
+
+bool spatial_axis_dir(SpatialAxis a, float out[3])
+{
+    if ((unsigned)a >= SPATIAL_AXIS_COUNT || !mapping_get_led_pos()) return false;
+    out[0] = out[1] = out[2] = 0.f;
+    switch (a) {
+    case SPATIAL_AXIS_VERTEX:
+        out[0] = poly.v[0][0]; out[1] = poly.v[0][1]; out[2] = poly.v[0][2];
+        break;
+    case SPATIAL_AXIS_FACE: {
+        const FaceFrame *ff = mapping_face_frame(0);
+        if (ff) { out[0] = ff->n[0]; out[1] = ff->n[1]; out[2] = ff->n[2]; }
+        break;
+    }
+    case SPATIAL_AXIS_EDGE:
+        for (int k = 0; k < 3; ++k) out[k] = poly.v[poly.e[0].a][k] + poly.v[poly.e[0].b][k];
+        break;
+    default:
+        out[a] = 1.f;
+        break;
+    }
+    normalize3(out);
+    return true;
+}
+
+/* the slot holding axis a, else an empty one, else the least recently used */
+static AxisOrder *axis_slot(SpatialAxis a)
+{
+    AxisOrder *pick = &axes[0];
+    for (uint8_t s = 0; s < SPATIAL_AXIS_SLOTS; ++s) {
+        AxisOrder *ax = &axes[s];
+        if (ax->ord && ax->axis == a) return ax;
+        if (!ax->ord ? pick->ord != NULL : pick->ord && ax->used < pick->used) pick = ax;
+    }
+    pick->gen = mapping_generation() - 1u;   /* stale: sorted for the new axis */
+    pick->axis = a;
+    return pick;
+}
+
+static AxisOrder *ensure_axis(SpatialAxis a, uint16_t n)
+{
+    const LedPos *pos = mapping_get_led_pos();
+    if (!pos || !n) return NULL;
+    AxisOrder *ax = axis_slot(a);
+    ax->used = ++axis_queries;
+    if (ax->ord && ax->gen == mapping_generation()) return ax;
+
+    if (!ax->ord) {                      /* total pixels are fixed per scene */
+        ax->ord = scene_alloc("axis_ord", n * sizeof *ax->ord);
+        if (!ax->ord) return NULL;
+        for (uint16_t i = 0; i < n; ++i) ax->ord[i] = i;
+    }
+    spatial_axis_dir(a, ax->dir);
+
+    static const uint16_t gaps[] = { 701, 301, 132, 57, 23, 10, 4, 1 };
+    uint16_t *o = ax->ord;
+    for (uint8_t g = 0; g < sizeof gaps / sizeof gaps[0]; ++g) {
+        const uint16_t h = gaps[g];
+        for (uint16_t i = h; i < n; ++i) {
+            const uint16_t v = o[i];
+            const float    k = proj(pos, v, ax->dir);
+            uint16_t j = i;
+            for (; j >= h && proj(pos, o[j - h], ax->dir) > k; j -= h) o[j] = o[j - h];
+            o[j] = v;
+        }
+    }
+    ax->gen = mapping_generation();
+    return ax;
+}
+
+/* first entry of the order with pos · dir >= d (or > d with `after`) */
+static uint16_t lower(const uint16_t *o, uint16_t n, const float dir[3], float d, bool after)
+{
+    const LedPos *pos = mapping_get_led_pos();
+    uint16_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint16_t m = (uint16_t)((lo + hi) >> 1);
+        float    k = proj(pos, o[m], dir);
+        if (after ? k <= d : k < d) lo = (uint16_t)(m + 1); else hi = m;
+    }
+    return lo;
+}
+
+uint16_t spatial_band(SpatialAxis a, float d0, float d1, const uint16_t **idx)
+{
+    *idx = NULL;
+    if ((unsigned)a >= SPATIAL_AXIS_COUNT || d1 < d0) return 0;
+    const uint16_t   n  = mapping_get_total_pixels();
+    const AxisOrder *ax = ensure_axis(a, n);
+    if (!ax) return 0;
+    const uint16_t i0 = lower(ax->ord, n, ax->dir, d0, false);
+    const uint16_t i1 = lower(ax->ord, n, ax->dir, d1, true);
+    if (i1 <= i0) return 0;
+    *idx = ax->ord + i0;
+    return (uint16_t)(i1 - i0);
+}
+
+bool spatial_warm(SpatialAxis a)
+{
+    if (!ensure_bounds()) return false;
+    return (unsigned)a >= SPATIAL_AXIS_COUNT || ensure_axis(a, mapping_get_total_pixels()) != NULL;
+}
+
+void spatial_shutdown(void)
+{
+    bounds    = NULL;                    /* emptied with the scene pool */
+    bound_cnt = 0;
+    for (uint8_t s = 0; s < SPATIAL_AXIS_SLOTS; ++s) axes[s].ord = NULL;
+}
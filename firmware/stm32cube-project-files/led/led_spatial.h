@@ -0,0 +1,105 @@
+/*
+ * led_spatial.h – radius queries over the mapping's LED positions
+ *
+ * Every edge gets a bounding sphere (rebuilt lazily when the mapping
+ * generation moves). A shell query rejects whole edges by sphere first, then
+ * solves |A + i·D - P|² <= r1² for the LED range i on each remaining edge
+ * (LEDs sit evenly along the edge), so only LEDs near the outer radius are
+ * ever touched: cost ~ E + LEDs in the shell instead of LEDs × queries.
+ *
+ * Plane bands: per axis, the LEDs sorted by pos · axis (a permutation of the
+ * pixel indices, 2 bytes per LED), sorted the first time the axis is asked
+ * for and again when the mapping generation moves. SPATIAL_AXIS_SLOTS of
+ * them are kept in the scene pool, asking for another re-sorts the least
+ * recently used slot (a few ms for 720 LEDs). The LEDs with
+ * d0 <= pos · axis <= d1 are one slice of it, found by two binary searches,
+ * so a sweeping plane costs the LEDs in its band. Axes are x, y, z and the
+ * solid's symmetry axes through its first vertex, face and edge (3-, 5- and
+ * 2-fold on the dodecahedron); a tilted horizon picks the nearest of them
+ * or a shell query around a far away point.
+ */
+
+#ifndef _LED_SPATIAL_H_
+#define _LED_SPATIAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_mapping.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Shell query state, see spatial_shell_begin()
+ */
+typedef struct {
+    float       p[3];       /* query point                             */
+    float       r0_2, r1_2; /* shell bounds, squared                   */
+    float       r0, r1;
+    poly_idx_t  edge;       /* edge being walked                       */
+    poly_idx_t  edge_end;   /* edges to look at (0: empty query)       */
+    uint16_t    i, i_end;   /* LEDs [i, i_end) of it are left          */
+    EdgeLedInfo inf;
+} LedShellIter;
+
+/**
+ * Start iterating the LEDs with r0 <= |pos - p| <= r1.
+ * Don't remap between begin and the last next().
+ */
+void spatial_shell_begin(LedShellIter *it, const float p[3], float r0, float r1);
+
+/**
+ * Next LED in the shell.
+ * @param idx    Pixel index (as used by set_pixel_color & co)
+ * @param dist2  Squared distance to the query point
+ * @return false once the shell is exhausted
+ */
+bool spatial_shell_next(LedShellIter *it, uint16_t *idx, float *dist2);
+
+/* axis orders kept at once, 1.4 kB each on the 720 LED dodecahedron */
+#ifndef SPATIAL_AXIS_SLOTS
+  #define SPATIAL_AXIS_SLOTS  2
+#endif
+
+typedef enum {
+    SPATIAL_AXIS_X,
+    SPATIAL_AXIS_Y,
+    SPATIAL_AXIS_Z,
+    SPATIAL_AXIS_VERTEX,    /* centre → vertex 0                       */
+    SPATIAL_AXIS_FACE,      /* face 0's normal                         */
+    SPATIAL_AXIS_EDGE,      /* centre → middle of edge 0               */
+    SPATIAL_AXIS_COUNT
+} SpatialAxis;
+
+/**
+ * The axis' unit direction (LED space, follows the geometry)
+ * @return false out of range or before the mapping
+ */
+bool spatial_axis_dir(SpatialAxis a, float out[3]);
+
+/**
+ * The LEDs with d0 <= pos · axis <= d1, in ascending order of it.
+ * Don't remap while walking the slice.
+ * @param idx  Set to the slice's first pixel index (NULL if none)
+ * @return LEDs in the slice, 0 also out of scene memory
+ */
+uint16_t spatial_band(SpatialAxis a, float d0, float d1, const uint16_t **idx);
+
+/**
+ * Build the edge spheres and, unless a is SPATIAL_AXIS_COUNT, a's order
+ * ahead of the first query (the animation warm-up, led_anim.h)
+ * @return false before the mapping or out of scene memory
+ */
+bool spatial_warm(SpatialAxis a);
+
+/**
+ * Drop the edge spheres and axis orders (rebuilt by the next query), before a new geometry.
+ */
+void spatial_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_SPATIAL_H_ */
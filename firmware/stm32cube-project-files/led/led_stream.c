@@ -0,0 +1,412 @@
+/* --------------------------------------------------------------------------
+ * led_stream.c – host frames received / decoded in place, keyframes mixed
+ *                on the frame clock
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include <stdlib.h>
+#include "led_stream.h"
+#include "pixel_simd.h"      /* px_lerp */
+#include "led_render.h"      /* render_acquire_back, render_mark_dirty, render_submit */
+#include "led_mapping.h"     /* mapping_get_total_pixels */
+#include "usb_comms.h"       /* usb_comms_receive: bytes left over after a frame */
+#include "usb_packet.h"      /* usb_packet_rx: packets between frames */
+#include "frame_sync.h"      /* frame_sync_due */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick, NVIC */
+#include "usbd_cdc.h"        /* CDC_DATA_FS_OUT_PACKET_SIZE */
+
+typedef enum {
+    ST_OFF,
+    ST_HEADER,              /* waiting for a frame */
+    ST_KEY,                 /* 'K': time stamp, ease */
+    ST_LATCH,               /* 'S': frame number */
+    ST_PACKET,              /* a packet between frames, up to its closing 0x00 */
+    ST_PIXELS,              /* raw */
+    ST_DELTA,               /* xor / skip tokens */
+    ST_PAL_N,
+    ST_PAL,                 /* palette entries */
+    ST_INDEX,               /* palette indices */
+    ST_TRAILER,             /* waiting for 'E' */
+    ST_READY,               /* frame complete, endpoint held */
+    ST_RESYNC,              /* torn frame: dropping bytes until the host pauses */
+} StreamState;
+
+/* owned by the USB ISR while streaming, by the main loop while ST_READY
+ * (endpoint held, no ISR) or with the USB interrupt masked */
+static volatile uint8_t  st = ST_OFF;
+static uint8_t          *fb;                /* back buffer, bytes (LED_PIXEL_32: wire) */
+static uint8_t          *dst;               /* fb, or key_in for a keyframe */
+static uint32_t          fb_len;            /* 3 * LEDs */
+static uint32_t          got;               /* dst bytes done */
+static uint32_t          run;               /* 'D': literal bytes left, 'P': palette bytes */
+static bool              base;              /* framebuffer holds the host's last frame */
+static bool              kbase;             /* key_in holds the host's last keyframe */
+static bool              show;              /* this frame goes out */
+static bool              key;               /* this frame is a keyframe */
+static uint8_t           key_hdr[3];        /* time stamp (ms, le), ease */
+static uint8_t           key_hdr_n;
+static volatile bool     latch;             /* this frame waits for its number */
+static uint32_t          latch_at;
+static uint8_t           latch_n;
+static uint8_t           pal[256][3];
+static const uint8_t    *rest;              /* held bytes after the 'E' */
+static uint32_t          rest_len;
+static uint8_t          *rx_buf;            /* receive buffer of the endpoint in use */
+static uint32_t          rx_len;            /* its size */
+static StreamArm         rx_arm;            /* and how to re-arm it */
+static volatile uint32_t last_rx;           /* tick of the last byte */
+
+/* keyframes: output mixes key_from (what was showing when the key came)
+ * into key_to, key_in takes the next one (a copy of key_to, for 'D') */
+static uint8_t          *keys;              /* 3 * keys_len */
+static uint32_t          keys_len;
+#ifdef LED_PIXEL_32
+/* the host sends 3 bytes per LED, the framebuffer has 4: frames land
+ * packed in here and are widened into it when they are shown */
+static uint8_t          *wire;
+static uint32_t          wire_len;
+#endif
+static uint8_t          *key_from, *key_to, *key_in;
+static volatile bool     keyed;             /* output is being mixed (main loop writes) */
+static bool              key_stop;          /* a plain frame came in: mixing ends */
+static bool              key_done;          /* reached key_to */
+static uint16_t          key_ts;            /* host stamp of key_to */
+static uint16_t          key_ms;            /* mix time */
+static uint8_t           key_ease;
+static uint32_t          key_t0;
+
+static StreamStats stats;
+
+bool stream_start(void)
+{
+    if (st != ST_OFF) return true;
+    rgb_8b *back = render_acquire_back();
+    if (!back) return false;
+    fb_len = 3u * mapping_get_total_pixels();
+#ifdef LED_PIXEL_32
+    if (wire_len != fb_len) {       /* kept like the keys */
+        free(wire);
+        wire     = malloc(fb_len);
+        wire_len = wire ? fb_len : 0;
+    }
+    if (!wire) return false;
+    fb     = wire;
+#else
+    fb     = (uint8_t *)back;
+#endif
+    got    = 0;
+    base   = false;                 /* whatever the animation left */
+    kbase  = false;
+    key    = false;
+    keyed  = false;
+    latch  = false;
+    if (keys_len != fb_len) {       /* kept for the next session, sized per scene */
+        free(keys);
+        keys     = malloc(3u * fb_len);
+        keys_len = keys ? fb_len : 0;
+    }
+    if (keys) {
+        key_from = keys;
+        key_to   = keys + fb_len;
+        key_in   = keys + 2u * fb_len;
+    }
+    memset(&stats, 0, sizeof stats);
+    last_rx = HAL_GetTick();
+    __DMB();                        /* the ISR sees the buffer before the state */
+    st = ST_HEADER;
+    return true;
+}
+
+bool stream_active(void) { return st != ST_OFF; }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * USB ISR
+ */
+static void drop_frame(void)
+{
+    ++stats.torn;
+    if (key) kbase = false;
+    else     base  = false;
+    st = ST_RESYNC;
+}
+
+uint32_t stream_rx(const uint8_t *buf, uint32_t len)
+{
+    if (st == ST_OFF || st == ST_READY) return 0;
+    last_rx = HAL_GetTick();
+
+    /* landed in place: nothing to copy */
+    if (st == ST_PIXELS && buf == dst + got) {
+        got += len;
+        if (got >= fb_len) st = ST_TRAILER;
+        return len;
+    }
+
+    uint32_t i = 0;
+    while (i < len) {
+        switch (st) {
+        case ST_HEADER: {
+            uint8_t c = buf[i];
+            if (c == 0x00 && !key && !latch) {             /* a packet: streaming goes on */
+                static const uint8_t delim = 0x00;
+                usb_packet_rx(&delim, 1);
+                ++i;
+                st = ST_PACKET;
+                break;
+            }
+            if (c == STREAM_FRAME_SYNC && !key && !latch) {
+                ++i;
+                latch    = true;
+                latch_at = 0;
+                latch_n  = 0;
+                st       = ST_LATCH;
+                break;
+            }
+            if (c == STREAM_FRAME_KEY && !key) {
+                if (!keys) {                        /* no RAM for them */
+                    drop_frame();
+                    return len;
+                }
+                ++i;
+                key       = true;
+                key_hdr_n = 0;
+                st        = ST_KEY;
+                break;
+            }
+            if (!key && keyed) {                    /* plain frame: the main loop stops */
+                key_stop = true;                    /* mixing first, then gets it again */
+                show     = false;
+                rest     = buf + i;
+                rest_len = len - i;
+                st       = ST_READY;
+                return len;
+            }
+            if      (c == STREAM_FRAME_RAW)     st = ST_PIXELS;
+            else if (c == STREAM_FRAME_DELTA)   st = ST_DELTA;
+            else if (c == STREAM_FRAME_PALETTE) st = ST_PAL_N;
+            else if (key || latch) {                /* 'K' / 'S' without a frame */
+                drop_frame();
+                return len;
+            } else {                                /* not a frame: streaming ends */
+                st = ST_OFF;
+                return i;
+            }
+            ++i;
+            got  = 0;
+            run  = 0;
+            dst  = key ? key_in : fb;
+            show = c != STREAM_FRAME_DELTA || (key ? kbase : base);
+            break;
+        }
+        case ST_KEY:
+            key_hdr[key_hdr_n++] = buf[i++];
+            if (key_hdr_n == sizeof key_hdr) st = ST_HEADER;
+            break;
+        case ST_LATCH:
+            latch_at |= (uint32_t)buf[i++] << (8u * latch_n++);
+            if (latch_n == 4) st = ST_HEADER;
+            break;
+        case ST_PACKET: {
+            uint32_t j = i;
+            while (j < len && buf[j] != 0x00) ++j;
+            if (j < len) {                          /* closed: a frame may follow */
+                ++j;
+                st = ST_HEADER;
+            }
+            usb_packet_rx(buf + i, j - i);
+            i = j;
+            break;
+        }
+        case ST_PIXELS: {
+            uint32_t n = fb_len - got;
+            if (n > len - i) n = len - i;
+            memmove(dst + got, buf + i, n);          /* may overlap after a stall */
+            got += n;
+            i   += n;
+            if (got >= fb_len) st = ST_TRAILER;
+            break;
+        }
+        case ST_DELTA:
+            if (run) {
+                uint32_t n = run;
+                if (n > len - i) n = len - i;
+                if (show) for (uint32_t k = 0; k < n; ++k) dst[got + k] ^= buf[i + k];
+                got += n;
+                i   += n;
+                run -= n;
+            } else {
+                uint8_t  c    = buf[i++];
+                uint32_t span = (c & (STREAM_DELTA_SKIP - 1u)) + 1u;
+                if (span > fb_len - got) {          /* runs past the frame */
+                    drop_frame();
+                    return len;
+                }
+                if (c & STREAM_DELTA_SKIP) got += span;
+                else                       run  = span;
+            }
+            if (!run && got >= fb_len) st = ST_TRAILER;
+            break;
+        case ST_PAL_N:
+            run = 3u * buf[i++];
+            got = 0;
+            st  = run ? ST_PAL : ST_INDEX;
+            break;
+        case ST_PAL: {
+            uint32_t n = run - got;
+            if (n > len - i) n = len - i;
+            memcpy(&pal[0][0] + got, buf + i, n);
+            got += n;
+            i   += n;
+            if (got >= run) {
+                got = 0;
+                st  = ST_INDEX;
+            }
+            break;
+        }
+        case ST_INDEX:
+            while (i < len && got < fb_len) {
+                memcpy(dst + got, pal[buf[i++]], 3);
+                got += 3;
+            }
+            if (got >= fb_len) st = ST_TRAILER;
+            break;
+        case ST_TRAILER:
+            if (buf[i++] != STREAM_FRAME_END) {
+                drop_frame();
+                return len;
+            }
+            if (!show)    ++stats.no_base;
+            else if (key) kbase = true;
+            else          base  = true;
+            rest     = buf + i;
+            rest_len = len - i;
+            st       = ST_READY;
+            return len;
+        case ST_RESYNC:
+            return len;
+        default:
+            return i;
+        }
+    }
+    return len;
+}
+
+uint8_t *stream_rx_target(uint8_t *buf, uint32_t *len, StreamArm arm)
+{
+    rx_buf = buf;
+    rx_len = *len;
+    rx_arm = arm;
+    if (st == ST_READY) return NULL;
+    if (st == ST_PIXELS && fb_len - got >= CDC_DATA_FS_OUT_PACKET_SIZE) {
+        *len = (fb_len - got) & ~(uint32_t)(CDC_DATA_FS_OUT_PACKET_SIZE - 1u);
+        return dst + got;
+    }
+    return buf;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Main loop
+ */
+static void rx_rearm(void)
+{
+    NVIC_DisableIRQ(OTG_FS_IRQn);
+    uint32_t len = rx_len;
+    uint8_t *at  = stream_rx_target(rx_buf, &len, rx_arm);
+    rx_arm(at, len);
+    NVIC_EnableIRQ(OTG_FS_IRQn);
+}
+
+static void show_fb(void)
+{
+#ifdef LED_PIXEL_32
+    rgb_8b *px = render_acquire_back();
+    if (!px) return;
+    for (uint32_t p = 0; p < fb_len; p += 3, ++px) *px = (rgb_8b){ fb[p], fb[p + 1], fb[p + 2] };
+#endif
+    render_mark_dirty(0, (uint16_t)(fb_len / 3u));
+    render_submit();
+    ++stats.frames;
+#ifndef LED_PIXEL_32
+    rgb_8b *back = render_acquire_back();
+    if (back) fb = (uint8_t *)back;
+#endif
+}
+
+/* a keyframe is complete in key_in: mix from what shows now into it, over
+ * the time the host took since the last one */
+static void key_take(void)
+{
+    memcpy(key_from, fb, fb_len);
+    uint8_t *t = key_to;
+    key_to = key_in;
+    key_in = t;
+    memcpy(key_in, key_to, fb_len);
+
+    uint16_t ts = (uint16_t)(key_hdr[0] | key_hdr[1] << 8);
+    key_ms   = keyed ? (uint16_t)(ts - key_ts) : 0;     /* first one: at once */
+    if (key_ms > STREAM_KEY_MAX_MS) key_ms = STREAM_KEY_MAX_MS;
+    key_ts   = ts;
+    key_ease = key_hdr[2];
+    key_t0   = HAL_GetTick();
+    key_done = false;
+    keyed    = true;
+    base     = false;               /* the framebuffer holds a mix from now on */
+    ++stats.keys;
+}
+
+static void key_draw(void)
+{
+    uint32_t el = HAL_GetTick() - key_t0;
+    uint16_t t  = (el < key_ms) ? (uint16_t)((el << 8) / key_ms) : 256u;
+    if (key_ease == STREAM_EASE_SMOOTH)                 /* 3t² - 2t³ */
+        t = (uint16_t)(((uint32_t)t * t * (768u - 2u * t)) >> 16);
+    px_lerp(fb, key_from, key_to, fb_len, t);
+    show_fb();
+    key_done = t >= 256u;
+}
+
+bool stream_tick(void)
+{
+    if (st == ST_OFF) return false;
+
+    if (st == ST_READY) {
+        /* a numbered frame waits for its frame, the endpoint stays held */
+        if (!latch || frame_sync_due(latch_at)) {
+            do {
+                if (key_stop) {     /* the plain frame behind it comes in again below */
+                    keyed    = false;
+                    key_stop = false;
+                } else {
+                    if (show && key) key_take();
+                    else if (show)   show_fb();
+                    latch = false;
+                }
+                key = false;
+                got = 0;
+                st  = ST_HEADER;
+                /* what came after the 'E': the next frame's start, or the
+                 * console's if streaming ends there */
+                if (rest_len) usb_comms_receive((uint8_t *)rest, rest_len);
+            } while (st == ST_READY && (!latch || frame_sync_due(latch_at)));
+            if (st != ST_READY) rx_rearm();
+        }
+    } else if (st != ST_HEADER && HAL_GetTick() - last_rx > STREAM_TIMEOUT_MS) {
+        NVIC_DisableIRQ(OTG_FS_IRQn);
+        if (st != ST_OFF && st != ST_READY && st != ST_RESYNC && st != ST_PACKET) {   /* host gone mid frame */
+            ++stats.stalled;
+            if (key) kbase = false;
+            else     base  = false;
+        }
+        if (st != ST_OFF && st != ST_READY) {                      /* ISR may have moved on */
+            key   = false;
+            latch = false;
+            st  = ST_HEADER;
+        }
+        NVIC_EnableIRQ(OTG_FS_IRQn);
+    }
+
+    if (st == ST_OFF) return false;
+    if (keyed && !key_done) key_draw();
+    return true;
+}
+
+const StreamStats *stream_stats(void) { return &stats; }
@@ -0,0 +1,156 @@
+/*
+ * led_stream.h – pixels from the host, straight into the framebuffer
+ *
+ * "stream" on the console hands the LEDs to the PC: animations stop and
+ * every frame the host sends is shown as it is. Frames come in three kinds,
+ * each closed by an 'E':
+ *
+ *   'F' | rgb[total LEDs]                       raw, 3 bytes per LED
+ *   'D' | tokens                                xor against the last frame
+ *   'P' | n | rgb[n] | index[total LEDs]        through a 256 entry palette
+ *
+ * Pixels are in framebuffer order: the wiring order (logical order with
+ * LED_RENDER_LOGICAL).
+ *
+ * Raw frames are not copied: while at least a whole USB packet of pixels is
+ * still missing, the OUT endpoint is pointed at the framebuffer itself, so
+ * the USB core writes the pixels where they are drawn from; only the bytes
+ * around the markers go through the receive buffer (at most 63 per frame
+ * end). Frames come through the console or the bulk pipe (usb_bulk.h),
+ * whichever endpoint they arrived on is the one held.
+ *
+ * The other two are decoded from the CDC buffer into the framebuffer in the
+ * same pass, as they arrive. A 'D' frame is a list of tokens over the
+ * frame's bytes, byte c:
+ *
+ *   c < 0x80   c + 1 bytes follow, each xor-ed into the framebuffer
+ *   c >= 0x80  c - 0x7F bytes unchanged
+ *
+ * and must cover the frame exactly. The framebuffer always holds the last
+ * frame (the pipeline carries it over), so the xor is done in place. A 'P'
+ * frame replaces palette entries 0..n-1 (n = 0 keeps the palette) and then
+ * has one index per LED.
+ *
+ * Keyframes let the host send 20-30 frames a second and still have every
+ * frame clock tick drawn:
+ *
+ *   'K' | stamp u16 (host ms, little endian) | ease u8 | one of the above
+ *
+ * The frame goes into a key buffer instead (a 'D' key is against the last
+ * key). Once it is in, the output mixes from whatever shows at that moment
+ * into the new key over the host's interval between the two stamps
+ * (px_lerp, per channel, linear or smoothstep), so it lags the host by
+ * one key and has no steps. A plain frame ends the mixing.
+ *
+ * Several sculptures on one host (frame_sync.h) show a frame together when
+ * it carries the shared frame number it belongs to:
+ *
+ *   'S' | frame u32 (little endian) | a frame or keyframe as above
+ *
+ * It is held after its 'E' until the frame clock reaches that number, at
+ * once when not synced or when the number is more than SYNC_LATCH_MAX
+ * ahead. The host sends a few frames ahead and every device shows each on
+ * the same tick.
+ *
+ * After the 'E' the endpoint is held (the host gets NAKs) until the main
+ * loop has submitted the frame and got the next back buffer: that is the
+ * flow control, the host can write as fast as it likes and ends up at the
+ * frame clock.
+ *
+ * A packet (usb_packet.h, starts with its 0x00) may go between frames, the
+ * PKT_SYNC that keeps the clocks together for one; streaming goes on after
+ * it. Any other byte where a frame should start ends the mode and goes to
+ * the console, so "stream off" gets out.
+ * A frame without its 'E' is dropped along with everything after it until
+ * the host pauses for STREAM_TIMEOUT_MS; a pause in the middle of a frame
+ * drops it too. Either way the next byte is expected to start a frame
+ * again. A dropped frame may have left the framebuffer half written, 'D'
+ * frames are thrown away until an 'F' or 'P' frame gives them a base.
+ *
+ * With LED_RENDER_STREAM the encoder reads the framebuffer while the next
+ * frame comes in, expect tearing there.
+ */
+
+#ifndef _LED_STREAM_H_
+#define _LED_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef STREAM_TIMEOUT_MS
+  #define STREAM_TIMEOUT_MS     100
+#endif
+
+#define STREAM_FRAME_RAW        'F'
+#define STREAM_FRAME_DELTA      'D'
+#define STREAM_FRAME_PALETTE    'P'
+#define STREAM_FRAME_KEY        'K'
+#define STREAM_FRAME_SYNC       'S'
+#define STREAM_FRAME_END        'E'
+
+#define STREAM_EASE_LINEAR      0
+#define STREAM_EASE_SMOOTH      1
+
+/* longest mix between two keys (the host stalled or started over) */
+#ifndef STREAM_KEY_MAX_MS
+  #define STREAM_KEY_MAX_MS     1000
+#endif
+
+#define STREAM_DELTA_SKIP       0x80    /* token bit: unchanged bytes */
+
+typedef struct {
+    uint32_t frames;        /* shown, mixed ones included */
+    uint32_t keys;          /* keyframes taken */
+    uint32_t torn;          /* end marker missing, dropped */
+    uint32_t stalled;       /* timed out mid frame, dropped */
+    uint32_t no_base;       /* 'D' frames thrown away after a drop */
+} StreamStats;
+
+/**
+ * Enter streaming mode (main loop)
+ * @return false: renderer not up yet
+ */
+bool stream_start(void);
+
+bool stream_active(void);
+
+/**
+ * Take received bytes (USB ISR, before anything else sees them)
+ * @return bytes taken; the rest belongs to the console
+ */
+uint32_t stream_rx(const uint8_t *buf, uint32_t len);
+
+/* points an OUT endpoint at buf and has it receive up to len bytes (the
+ * CDC endpoint takes one packet whatever len says) */
+typedef void (*StreamArm)(uint8_t *buf, uint32_t len);
+
+/**
+ * Where the next OUT transfer should land (USB ISR, after stream_rx)
+ * @param  rx_buf the endpoint's own receive buffer
+ * @param  len    in: the size of rx_buf; out: what the target takes, for a
+ *                spot in the framebuffer the whole packets left of the frame
+ * @param  arm    how to re-arm that endpoint (the CDC one or the bulk pipe)
+ * @return rx_buf, a spot in the framebuffer, or NULL: hold the endpoint,
+ *         stream_tick() re-arms it
+ */
+uint8_t *stream_rx_target(uint8_t *rx_buf, uint32_t *len, StreamArm arm);
+
+/**
+ * Show a finished frame or the next mix step, watch for stalls (main loop,
+ * per frame tick)
+ * @return true while streaming: skip the animations
+ */
+bool stream_tick(void);
+
+const StreamStats *stream_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_STREAM_H_ */
@@ -0,0 +1,226 @@
+/* --------------------------------------------------------------------------
+ * led_symmetry.c – rotation group detection, orbit table, domain replicate
+ * -------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "led_symmetry.h"
+#include "led_mapping.h"   /* edge_info, mapping_generation */
+#include "led_render.h"    /* framebuffer, render_store_block */
+#include "fast_math.h"
+
+/* External polyhedron instance (created in main.c) */
+extern Polyhedron poly;
+
+#define SYM_TOL   2e-3f             /* position match, relative to the radius */
+
+static uint16_t   *sym_src    = NULL;   /* per framebuffer index: representative */
+static uint16_t    sym_px     = 0;
+static ShaderSpan *sym_spans  = NULL;
+static uint16_t    sym_nspans = 0;
+static uint8_t     sym_n      = 1;
+static uint32_t    sym_gen    = 0;
+static bool        sym_valid  = false;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Orthonormal frame from a vertex and a neighbour (rows), relative to the
+ * centre o. Right-handed, so two frames only ever give proper rotations.
+ */
+static bool frame_of(const float o[3], const float *p0, const float *p1, float F[3][3])
+{
+    float a[3], d[3];
+    for (int i = 0; i < 3; ++i) { a[i] = p0[i] - o[i]; d[i] = p1[i] - o[i]; }
+    float la = fm_sqrtf(a[0]*a[0] + a[1]*a[1] + a[2]*a[2]);
+    if (la < 1e-6f) return false;
+    for (int i = 0; i < 3; ++i) a[i] /= la;
+    float da = d[0]*a[0] + d[1]*a[1] + d[2]*a[2];
+    for (int i = 0; i < 3; ++i) d[i] -= da * a[i];
+    float ld = fm_sqrtf(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+    if (ld < 1e-6f) return false;
+    for (int i = 0; i < 3; ++i) { F[0][i] = a[i]; F[1][i] = d[i] / ld; }
+    F[2][0] = F[0][1]*F[1][2] - F[0][2]*F[1][1];
+    F[2][1] = F[0][2]*F[1][0] - F[0][0]*F[1][2];
+    F[2][2] = F[0][0]*F[1][1] - F[0][1]*F[1][0];
+    return true;
+}
+
+static inline float dist2(const float *a, const float *b)
+{
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx*dx + dy*dy + dz*dz;
+}
+
+/*
+ * Is R (about o) a symmetry of vertices, edges and LED counts? Fills the
+ * vertex / edge permutation and per edge whether A lands on the image's B.
+ */
+static bool try_rotation(const float R[3][3], const float o[3], float tol2,
+                         const EdgeLedInfo *info, poly_idx_t *vperm,
+                         poly_idx_t *eperm, uint8_t *eflip)
+{
+    for (poly_idx_t i = 0; i < poly.V; ++i) {
+        float d[3], q[3];
+        for (int k = 0; k < 3; ++k) d[k] = poly.v[i][k] - o[k];
+        for (int k = 0; k < 3; ++k) q[k] = R[k][0]*d[0] + R[k][1]*d[1] + R[k][2]*d[2] + o[k];
+        vperm[i] = POLY_IDX_NONE;
+        for (poly_idx_t j = 0; j < poly.V; ++j)
+            if (dist2(q, poly.v[j]) < tol2) { vperm[i] = j; break; }
+        if (vperm[i] == POLY_IDX_NONE) return false;
+    }
+    for (poly_idx_t e = 0; e < poly.E; ++e) {
+        poly_idx_t a = vperm[poly.e[e].a], b = vperm[poly.e[e].b];
+        poly_idx_t f = poly_find_edge(&poly, a, b);
+        if (f == POLY_IDX_NONE || info[f].count != info[e].count) return false;
+        eperm[e] = f;
+        eflip[e] = (poly.e[f].a != a);
+    }
+    return true;
+}
+
+/* ==========================================================================
+ * API
+ * ========================================================================== */
+void sym_release(void)
+{
+    free(sym_src);
+    free(sym_spans);
+    sym_src    = NULL;
+    sym_spans  = NULL;
+    sym_px     = 0;
+    sym_nspans = 0;
+    sym_n      = 1;
+    sym_valid  = false;
+}
+
+bool sym_build(void)
+{
+    sym_release();
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    uint16_t           px   = mapping_get_total_pixels();
+    poly_idx_t         E    = mapping_get_edge_count();
+    if (!info || !px || E != poly.E || poly.V < 2) return false;
+
+    sym_src = malloc(px * sizeof *sym_src);
+    poly_idx_t *vperm = malloc(poly.V * sizeof *vperm);
+    poly_idx_t *eperm = malloc(E * sizeof *eperm);
+    uint8_t    *eflip = malloc(E);
+    if (!sym_src || !vperm || !eperm || !eflip) {
+        free(vperm); free(eperm); free(eflip);
+        sym_release();
+        return false;
+    }
+    for (uint16_t p = 0; p < px; ++p) sym_src[p] = p;
+
+    /* centre, vertex 0 and one neighbour fix the reference frame */
+    float o[3] = { 0, 0, 0 };
+    for (poly_idx_t i = 0; i < poly.V; ++i)
+        for (int k = 0; k < 3; ++k) o[k] += poly.v[i][k];
+    for (int k = 0; k < 3; ++k) o[k] /= poly.V;
+
+    uint8_t           deg0;
+    const poly_idx_t *inc0 = poly_vertex_edges(&poly, 0, &deg0);
+    float             F0[3][3];
+    if (!deg0 || !frame_of(o, poly.v[0], poly.v[poly_edge_other(&poly, inc0[0], 0)], F0)) {
+        deg0 = 0;                                   /* no frame: identity only */
+    }
+    float r0   = fm_sqrtf(dist2(poly.v[0], o));
+    float tol2 = (SYM_TOL * r0) * (SYM_TOL * r0);
+    float l0   = deg0 ? dist2(poly.v[0], poly.v[poly_edge_other(&poly, inc0[0], 0)]) : 0.0f;
+
+    /* every rotation sends (vertex 0, neighbour) to some (w, neighbour of w):
+     * V * degree candidates, each checked against the whole solid */
+    uint16_t order = 0;
+    for (poly_idx_t w = 0; deg0 && w < poly.V; ++w) {
+        if (fabsf(dist2(poly.v[w], o) - r0 * r0) > 4.0f * tol2 + 1e-4f * r0 * r0) continue;
+        uint8_t           deg;
+        const poly_idx_t *inc = poly_vertex_edges(&poly, w, &deg);
+        if (deg != deg0) continue;
+        for (uint8_t k = 0; k < deg; ++k) {
+            poly_idx_t w1 = poly_edge_other(&poly, inc[k], w);
+            if (fabsf(dist2(poly.v[w], poly.v[w1]) - l0) > 1e-3f * l0) continue;
+            float F1[3][3], R[3][3];
+            if (!frame_of(o, poly.v[w], poly.v[w1], F1)) continue;
+            for (int i = 0; i < 3; ++i)                 /* R = F1ᵀ · F0 */
+                for (int j = 0; j < 3; ++j)
+                    R[i][j] = F1[0][i]*F0[0][j] + F1[1][i]*F0[1][j] + F1[2][i]*F0[2][j];
+            if (!try_rotation(R, o, tol2, info, vperm, eperm, eflip)) continue;
+
+            /* q = g(p) is in p's orbit: every orbit ends at its lowest index */
+            for (poly_idx_t e = 0; e < E; ++e) {
+                EdgeLedInfo a = info[e], b = info[eperm[e]];
+                for (uint16_t i = 0; i < a.count; ++i) {
+                    uint16_t p = (uint16_t)(a.start + i * a.step);
+                    uint16_t j = eflip[e] ? (uint16_t)(a.count - 1 - i) : i;
+                    uint16_t q = (uint16_t)(b.start + j * b.step);
+                    if (p < sym_src[q]) sym_src[q] = p;
+                }
+            }
+            if (order < 255) ++order;
+        }
+    }
+    free(vperm); free(eperm); free(eflip);
+
+    /* domain: runs of representatives along the edges, counted then stored */
+    for (int pass = 0; pass < 2; ++pass) {
+        uint16_t n = 0;
+        for (poly_idx_t e = 0; e < E; ++e) {
+            EdgeLedInfo inf = info[e];
+            for (uint16_t i = 0; i < inf.count; ) {
+                uint16_t p = (uint16_t)(inf.start + i * inf.step);
+                if (sym_src[p] != p) { ++i; continue; }
+                uint16_t i0 = i;
+                while (i < inf.count && sym_src[(uint16_t)(inf.start + i * inf.step)] == (uint16_t)(inf.start + i * inf.step)) ++i;
+                if (pass) sym_spans[n] = (ShaderSpan){ e, i0, (uint16_t)(i - i0) };
+                ++n;
+            }
+        }
+        if (!pass) {
+            sym_spans = malloc((n ? n : 1) * sizeof *sym_spans);
+            if (!sym_spans) { sym_release(); return false; }
+        }
+        sym_nspans = n;
+    }
+
+    sym_px    = px;
+    sym_n     = order ? (uint8_t)order : 1;
+    sym_gen   = mapping_generation();
+    sym_valid = true;
+    return true;
+}
+
+uint8_t sym_order(void) { return sym_n; }
+
+const ShaderSpan *sym_domain(uint16_t *n)
+{
+    *n = sym_valid ? sym_nspans : 0;
+    return sym_valid ? sym_spans : NULL;
+}
+
+LED_RAMFUNC void sym_replicate(void)
+{
+    rgb_8b *fb = framebuffer;
+    if (!sym_valid || !fb) return;
+    for (uint16_t b0 = 0; b0 < sym_px; b0 += LED_DIRTY_BLOCK) {
+        uint16_t end = b0 + LED_DIRTY_BLOCK;
+        if (end > sym_px) end = sym_px;
+        rgb_8b blk[LED_DIRTY_BLOCK];
+        for (uint16_t p = b0; p < end; ++p) blk[p - b0] = fb[sym_src[p]];
+        render_store_block(b0, end - b0, blk);
+    }
+}
+
+bool sym_ready(void)
+{
+    if (!sym_valid || sym_gen != mapping_generation() || sym_px != mapping_get_total_pixels())
+        sym_build();
+    return sym_valid;
+}
+
+bool sym_run(const Shader *s, const void *uniforms)
+{
+    if (!s || s->blend != SHADER_WRITE) return shader_run(s, uniforms);
+    if (!sym_ready()) return shader_run(s, uniforms);
+    if (!shader_run_spans(s, uniforms, sym_spans, sym_nspans)) return false;
+    sym_replicate();
+    return true;
+}
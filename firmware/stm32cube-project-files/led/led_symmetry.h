@@ -0,0 +1,70 @@
+/*
+ * led_symmetry.h – rotation group of the solid, fundamental domain of the LEDs
+ *
+ * sym_build() finds the rotations that map the polyhedron (vertices, edges
+ * and LED counts per edge) onto itself, up to 60 for the icosahedral solids.
+ * Under the group the LEDs fall apart into orbits. The first LED of each
+ * orbit (lowest framebuffer index) is its representative, together they are the
+ * fundamental domain. A symmetric effect (one that looks the same after any
+ * of the rotations, e.g. only depends on the distance to the nearest vertex)
+ * renders the domain and sym_replicate() copies every orbit from its
+ * representative: for a dodecahedron half an edge gets shaded instead of 30.
+ * Only the orbit table is kept (2 bytes per pixel), not the permutations.
+ */
+
+#ifndef _LED_SYMMETRY_H_
+#define _LED_SYMMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_shader.h"    /* Shader, ShaderSpan */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * (Re)build the group and the orbit table for the current polyhedron and
+ * mapping. sym_run() does it on its own when the mapping generation moved.
+ * @return false if out of heap (symmetry then is the identity only)
+ */
+bool sym_build(void);
+
+/**
+ * sym_build() unless the tables are those of the current mapping
+ * @return true with a group to use
+ */
+bool sym_ready(void);
+
+/**
+ * Free the tables (rebuilt on the next sym_run)
+ */
+void sym_release(void);
+
+/**
+ * Rotations found by the last build (1 = none but the identity)
+ */
+uint8_t sym_order(void);
+
+/**
+ * The fundamental domain as shader spans
+ */
+const ShaderSpan *sym_domain(uint16_t *n);
+
+/**
+ * Copy every representative onto the rest of its orbit (framebuffer),
+ * only the changed blocks get marked dirty
+ */
+void sym_replicate(void);
+
+/**
+ * Run a symmetric SHADER_WRITE shader on the domain, then replicate.
+ * Other blend modes (and a missing table) run the plain shader_run().
+ */
+bool sym_run(const Shader *s, const void *uniforms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_SYMMETRY_H_ */
@@ -0,0 +1,132 @@
+/* --------------------------------------------------------------------------
+ * led_texture.c – per-edge control points, DDA fill along the spans
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "led_texture.h"
+#include "led_mapping.h"   /* edge_info */
+
+#define TEX_BLOCK 32                    /* LEDs per copy_pixels() row */
+
+/* DDA state along one edge: LED k sits at u = k * du (Q16 of the edge
+ * length), stop s at q[s], values in Q16 (channel or index << 16) */
+typedef struct {
+    uint8_t        n, ch;
+    uint32_t       q[TEX_STOPS];
+    int32_t      (*v)[3];
+    uint32_t       du;
+    uint8_t        s;           /* segment: stops s, s + 1            */
+    uint32_t       q_end;       /* u past this: next segment          */
+    int32_t        acc[3], inc[3];
+} TexWalk;
+
+/* (re)start at u: the segment containing it, clamped before the first /
+ * after the last stop. Exact value at u, then one add per LED. */
+static void walk_enter(TexWalk *w, uint32_t u)
+{
+    while (w->s + 1 < w->n && u > w->q[w->s + 1]) ++w->s;
+    if (w->s + 1 >= w->n || u < w->q[w->s]) {
+        uint8_t k = (u < w->q[w->s]) ? w->s : w->n - 1;
+        for (uint8_t c = 0; c < w->ch; ++c) { w->acc[c] = w->v[k][c]; w->inc[c] = 0; }
+        w->q_end = (u < w->q[w->s]) ? w->q[w->s] - 1 : 0xFFFFFFFFu;
+        return;
+    }
+    uint32_t qa = w->q[w->s], span = w->q[w->s + 1] - qa;
+    for (uint8_t c = 0; c < w->ch; ++c) {
+        int64_t d = (int64_t)w->v[w->s + 1][c] - w->v[w->s][c];
+        w->acc[c] = w->v[w->s][c] + (span ? (int32_t)(d * (u - qa) / span) : 0);
+        w->inc[c] = span ? (int32_t)(d * w->du / span) : 0;
+    }
+    w->q_end = w->q[w->s + 1];
+}
+
+/* ch 3: RGB, ch 1: index through lut, or into the index plane with lut NULL */
+static LED_RAMFUNC void tex_edge(EdgeLedInfo inf, uint8_t n, const uint8_t *pos,
+                                 int32_t (*v)[3], uint8_t ch, const rgb_8b *lut)
+{
+    rgb_8b   row[TEX_BLOCK];
+#ifdef LED_FB_INDEXED
+    uint8_t  idx[TEX_BLOCK];
+#endif
+    uint16_t cnt = inf.count;
+    TexWalk  w   = { .n = n, .ch = ch, .v = v, .s = 0 };
+    w.du = (cnt > 1) ? (65536u / (cnt - 1)) : 0;
+    for (uint8_t i = 0; i < n; ++i) w.q[i] = ((uint32_t)pos[i] << 16) / 255u;
+
+    uint32_t u = 0;
+    walk_enter(&w, u);
+    for (uint16_t i0 = 0; i0 < cnt; i0 += TEX_BLOCK) {
+        uint16_t m = cnt - i0;
+        if (m > TEX_BLOCK) m = TEX_BLOCK;
+        for (uint16_t k = 0; k < m; ++k, u += w.du) {
+            if (i0 + k == cnt - 1 && cnt > 1) walk_enter(&w, u = 65536u);   /* du rounds down, end on B */
+            else if (u > w.q_end)             walk_enter(&w, u);
+            if (ch == 3)  row[k] = (rgb_8b){ (uint8_t)(w.acc[0] >> 16), (uint8_t)(w.acc[1] >> 16), (uint8_t)(w.acc[2] >> 16) };
+#ifdef LED_FB_INDEXED
+            else if (!lut) idx[k] = (uint8_t)(w.acc[0] >> 16);
+#endif
+            else          row[k] = lut[(uint8_t)(w.acc[0] >> 16)];
+            for (uint8_t c = 0; c < ch; ++c) w.acc[c] += w.inc[c];
+        }
+#ifdef LED_FB_INDEXED
+        if (!lut && ch == 1) {
+            index_pixels((uint16_t)(inf.start + i0 * inf.step), m, inf.step, idx);
+            continue;
+        }
+#endif
+        copy_pixels((uint16_t)(inf.start + i0 * inf.step), m, inf.step, row);
+    }
+}
+
+bool tex_run_rgb(TexRgbFn fn, const void *uniforms)
+{
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    poly_idx_t         E    = mapping_get_edge_count();
+    if (!info || !fn) return false;
+
+    TexStop st[TEX_STOPS];
+    uint8_t pos[TEX_STOPS];
+    int32_t v[TEX_STOPS][3];
+    for (poly_idx_t e = 0; e < E; ++e) {
+        uint8_t n = fn(e, uniforms, st);
+        if (!n || !info[e].count) continue;
+        if (n > TEX_STOPS) n = TEX_STOPS;
+        for (uint8_t i = 0; i < n; ++i) {
+            pos[i]  = st[i].pos;
+            v[i][0] = (int32_t)st[i].c.r << 16;
+            v[i][1] = (int32_t)st[i].c.g << 16;
+            v[i][2] = (int32_t)st[i].c.b << 16;
+        }
+        tex_edge(info[e], n, pos, v, 3, NULL);
+    }
+    return true;
+}
+
+bool tex_run_index(TexIndexFn fn, const void *uniforms, const rgb_8b lut[256])
+{
+    const EdgeLedInfo *info = mapping_get_edge_info();
+    poly_idx_t         E    = mapping_get_edge_count();
+    if (!info || !fn || !lut) return false;
+
+#ifdef LED_FB_INDEXED
+    /* indices into the plane, lut becomes the palette: one byte per LED */
+    if (render_index_plane()) {
+        memcpy(render_palette(), lut, 256 * sizeof(rgb_8b));
+        lut = NULL;
+    }
+#endif
+
+    TexIndexStop st[TEX_STOPS];
+    uint8_t      pos[TEX_STOPS];
+    int32_t      v[TEX_STOPS][3];
+    for (poly_idx_t e = 0; e < E; ++e) {
+        uint8_t n = fn(e, uniforms, st);
+        if (!n || !info[e].count) continue;
+        if (n > TEX_STOPS) n = TEX_STOPS;
+        for (uint8_t i = 0; i < n; ++i) {
+            pos[i]  = st[i].pos;
+            v[i][0] = st[i].i << 8;            /* Q8 → Q16, wraps in the lookup */
+        }
+        tex_edge(info[e], n, pos, v, 1, lut);
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+ * led_texture.h – edge textures: colour as a function of (edge, t)
+ *
+ * Most gradient effects only decide a few colours per edge (the ends, maybe
+ * a point or two in between) and interpolate along it. Here the animation
+ * hands over those control points per edge and the LEDs between them are
+ * filled by a fixed-point DDA, one add per channel per LED, the effect's own
+ * code runs once per edge instead of once per LED.
+ * Two flavours: RGB stops (channels interpolated), or index stops
+ * (a palette / hue position interpolated, unwrapped so it may run past 255,
+ * looked up in a 256 entry table), for hue sweeps that shouldn't go grey.
+ */
+
+#ifndef _LED_TEXTURE_H_
+#define _LED_TEXTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "led_render.h"    /* rgb_8b */
+#include "polyhedron.h"    /* poly_idx_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* most control points per edge */
+#ifndef TEX_STOPS
+  #define TEX_STOPS             8
+#endif
+
+/* pos: 0 at the edge's A end .. 255 at B, ascending */
+typedef struct {
+    uint8_t pos;
+    rgb_8b  c;
+} TexStop;
+
+typedef struct {
+    uint8_t pos;
+    int32_t i;              /* table index in Q8 (256 = one entry), wraps mod 256 */
+} TexIndexStop;
+
+/**
+ * Control points of logical edge e, at most TEX_STOPS
+ * @return how many (0 = leave the edge alone)
+ */
+typedef uint8_t (*TexRgbFn)  (poly_idx_t e, const void *uniforms, TexStop *stops);
+typedef uint8_t (*TexIndexFn)(poly_idx_t e, const void *uniforms, TexIndexStop *stops);
+
+/**
+ * Fill every edge from its RGB stops
+ * @return false if there is no mapping
+ */
+bool tex_run_rgb(TexRgbFn fn, const void *uniforms);
+
+/**
+ * Fill every edge from its index stops through lut
+ * @return false if there is no mapping
+ */
+bool tex_run_index(TexIndexFn fn, const void *uniforms, const rgb_8b lut[256]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_TEXTURE_H_ */
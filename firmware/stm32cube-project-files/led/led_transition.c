@@ -0,0 +1,85 @@
+/* --------------------------------------------------------------------------
+ * led_transition.c – RGB565 snapshot cross-fade between animations
+ * -------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include "led_transition.h"
+#include "led_render.h"    /* framebuffer, render_target, render_store_block */
+#include "led_mapping.h"   /* mapping_get_total_pixels */
+
+static uint16_t *snap      = NULL;   /* outgoing frame, RGB565, per framebuffer index */
+static uint16_t  snap_px   = 0;
+static uint32_t  snap_t0   = 0;      /* ms() at the switch */
+
+static const uint32_t fade_ms = ANIM_FADE_MS > 0 ? ANIM_FADE_MS : 1;   /* never begins at 0 */
+
+static inline uint16_t pack565(rgb_8b c)
+{
+    return (uint16_t)((c.r & 0xF8) << 8 | (c.g & 0xFC) << 3 | c.b >> 3);
+}
+
+static inline rgb_8b unpack565(uint16_t v)
+{
+    uint8_t r = v >> 11, g = (v >> 5) & 0x3F, b = v & 0x1F;
+    return (rgb_8b){ (uint8_t)(r << 3 | r >> 2), (uint8_t)(g << 2 | g >> 4), (uint8_t)(b << 3 | b >> 2) };
+}
+
+static inline uint8_t mix8(uint8_t from, uint8_t to, uint16_t t)
+{
+    return (uint8_t)(from + (((int16_t)to - from) * t >> 8));
+}
+
+bool transition_begin(void)
+{
+    transition_cancel();
+#if ANIM_FADE_MS > 0
+    uint16_t px = mapping_get_total_pixels();
+    if (!framebuffer || !px) return false;
+    render_fill_wait();
+    snap = malloc(px * sizeof *snap);
+    if (!snap) return false;
+    for (uint16_t p = 0; p < px; ++p) snap[p] = pack565(framebuffer[p]);
+    snap_px = px;
+    snap_t0 = ms();
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool transition_active(void) { return snap != NULL; }
+
+void transition_cancel(void)
+{
+    free(snap);
+    snap    = NULL;
+    snap_px = 0;
+}
+
+void transition_frame(void (*tick)(void))
+{
+    uint32_t el = ms() - snap_t0;
+    if (!snap || el >= fade_ms || snap_px != mapping_get_total_pixels() || !framebuffer) {
+        transition_cancel();
+        tick();
+        return;
+    }
+
+    render_target(framebuffer);        /* same buffer, submit held back */
+    tick();
+    render_target(NULL);
+
+    /* one sweep, t = share of the incoming picture (1..255) */
+    uint16_t t  = (uint16_t)(el * 256u / fade_ms);
+    rgb_8b  *fb = framebuffer;
+    for (uint16_t b0 = 0; b0 < snap_px; b0 += LED_DIRTY_BLOCK) {
+        uint16_t end = b0 + LED_DIRTY_BLOCK;
+        if (end > snap_px) end = snap_px;
+        rgb_8b blk[LED_DIRTY_BLOCK];
+        for (uint16_t p = b0; p < end; ++p) {
+            rgb_8b o = unpack565(snap[p]);
+            blk[p - b0] = (rgb_8b){ mix8(o.r, fb[p].r, t), mix8(o.g, fb[p].g, t), mix8(o.b, fb[p].b, t) };
+        }
+        render_store_block(b0, end - b0, blk);
+    }
+    update_leds();
+}
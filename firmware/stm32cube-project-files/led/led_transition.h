@@ -0,0 +1,56 @@
+/*
+ * led_transition.h – cross-fade between two animations
+ *
+ * When the mode changes, the last frame of the outgoing animation is kept
+ * as RGB565 (2 bytes per pixel). It is torn down right away, so its scratch
+ * is freed before the new one allocates. For ANIM_FADE_MS the incoming
+ * animation draws as usual, and one sweep mixes the snapshot over it before
+ * the frame goes out. The snapshot is freed when the fade ends, so there is
+ * nothing extra in steady state. The outgoing picture holds still while it
+ * fades.
+ */
+
+#ifndef _LED_TRANSITION_H_
+#define _LED_TRANSITION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"        /* ANIM_FADE_MS */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* fade length, 0 = cut */
+#ifndef ANIM_FADE_MS
+  #define ANIM_FADE_MS          600
+#endif
+
+/**
+ * Capture the framebuffer as the outgoing picture (call before the old
+ * animation is torn down).
+ * @return false if there is no framebuffer or no heap for it (the switch then just cuts)
+ */
+bool transition_begin(void);
+
+/**
+ * A fade is running
+ */
+bool transition_active(void);
+
+/**
+ * One frame of the incoming animation: tick() draws into the framebuffer with
+ * the submit held back, the snapshot is mixed in, then update_leds()
+ */
+void transition_frame(void (*tick)(void));
+
+/**
+ * Drop the snapshot (scene rebuild, overlays switched on)
+ */
+void transition_cancel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_TRANSITION_H_ */
@@ -0,0 +1,151 @@
+/* --------------------------------------------------------------------------
+ * led_view.c – per-frame view rotation (no geometry rebuild)
+ * -------------------------------------------------------------------------- */
+#include "led_view.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include "polyhedron.h"          /* poly_rotation_matrix */
+#include "fast_math.h"           /* fm_rsqrtf, fm_sinf, ... */
+#include "stm32f4xx_hal.h"       /* DWT, SystemCoreClock */
+
+static float    view_R[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+static uint32_t view_gen     = 0;
+
+/* orientation stream */
+static ViewOrientStats orient;
+static bool            streaming = false;
+static bool            fresh     = false;   /* a sample since the last view_tick */
+static float           q_last[4];           /* w x y z, unit */
+static uint32_t        t_last;              /* its host stamp */
+static uint32_t        rx_last;             /* our clock when it came */
+static float           omega[3];            /* world frame, rad/s */
+
+void view_set_euler(float yaw, float pitch, float roll)
+{
+    poly_rotation_matrix(yaw, pitch, roll, view_R);
+    view_gen++;
+}
+
+void view_set_quat(float w, float x, float y, float z)
+{
+    float n2 = w*w + x*x + y*y + z*z;
+    if (n2 < 1e-12f) { view_reset(); return; }
+    float k = fm_rsqrtf(n2);
+    w *= k; x *= k; y *= k; z *= k;
+
+    view_R[0][0] = 1 - 2*(y*y + z*z); view_R[0][1] = 2*(x*y - w*z);     view_R[0][2] = 2*(x*z + w*y);
+    view_R[1][0] = 2*(x*y + w*z);     view_R[1][1] = 1 - 2*(x*x + z*z); view_R[1][2] = 2*(y*z - w*x);
+    view_R[2][0] = 2*(x*z - w*y);     view_R[2][1] = 2*(y*z + w*x);     view_R[2][2] = 1 - 2*(x*x + y*y);
+    view_gen++;
+}
+
+void view_reset(void)
+{
+    for (uint8_t i = 0; i < 3; ++i)
+        for (uint8_t j = 0; j < 3; ++j)
+            view_R[i][j] = (i == j) ? 1.f : 0.f;
+    view_gen++;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Orientation stream
+ */
+
+/* µs since boot from DWT, needs a call at least every 51 s (main loop) */
+static uint32_t now_us(void)
+{
+    static uint32_t last_cyc, rem, us;
+    uint32_t cyc = DWT->CYCCNT;
+    uint32_t cpu = SystemCoreClock / 1000000u;
+    uint32_t d   = cyc - last_cyc + rem;
+    last_cyc = cyc;
+    us  += d / cpu;
+    rem  = d % cpu;
+    return us;
+}
+
+static void q_mul(const float a[4], const float b[4], float out[4])
+{
+    float r[4] = {
+        a[0]*b[0] - a[1]*b[1] - a[2]*b[2] - a[3]*b[3],
+        a[0]*b[1] + a[1]*b[0] + a[2]*b[3] - a[3]*b[2],
+        a[0]*b[2] - a[1]*b[3] + a[2]*b[0] + a[3]*b[1],
+        a[0]*b[3] + a[1]*b[2] - a[2]*b[1] + a[3]*b[0],
+    };
+    out[0] = r[0]; out[1] = r[1]; out[2] = r[2]; out[3] = r[3];
+}
+
+void view_orient_sample(uint32_t host_us, const float q[4])
+{
+    uint32_t rx = now_us();
+    float n2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3];
+    if (n2 < 1e-12f) return;
+    float k = fm_rsqrtf(n2);
+    float qn[4] = { q[0] * k, q[1] * k, q[2] * k, q[3] * k };
+
+    int32_t off = (int32_t)(rx - host_us);
+    int32_t dt  = (int32_t)(host_us - t_last);
+    if (!streaming || rx - rx_last > ORIENT_STALE_US || dt <= 0 || dt > ORIENT_STALE_US) {
+        orient.offset_us = off;                 /* (re)start */
+        omega[0] = omega[1] = omega[2] = 0.0f;
+    } else {
+        /* the fastest transit is the best estimate; creep ~1000 ppm so
+         * drift and a slower link are followed too */
+        int32_t creep = orient.offset_us + (int32_t)((rx - rx_last) >> 10);
+        orient.offset_us = (off - creep < 0) ? off : creep;
+
+        /* world frame rotation since the last sample, shortest way round */
+        float inv[4] = { q_last[0], -q_last[1], -q_last[2], -q_last[3] };
+        float d[4];
+        q_mul(qn, inv, d);
+        if (d[0] < 0.0f) { d[0] = -d[0]; d[1] = -d[1]; d[2] = -d[2]; d[3] = -d[3]; }
+        float s = fm_sqrtf(d[1]*d[1] + d[2]*d[2] + d[3]*d[3]);
+        float w[3] = { 0.0f, 0.0f, 0.0f };
+        if (s > 1e-7f) {
+            float k = 2.0f * fm_atan2f(s, d[0]) / s / (dt * 1e-6f);
+            w[0] = d[1] * k; w[1] = d[2] * k; w[2] = d[3] * k;
+        }
+        for (uint8_t i = 0; i < 3; ++i) omega[i] += 0.5f * (w[i] - omega[i]);  /* sensor noise */
+    }
+
+    q_last[0] = qn[0]; q_last[1] = qn[1]; q_last[2] = qn[2]; q_last[3] = qn[3];
+    t_last    = host_us;
+    rx_last   = rx;
+    streaming = true;
+    fresh     = true;
+    orient.samples++;
+    orient.rate = fm_sqrtf(omega[0]*omega[0] + omega[1]*omega[1] + omega[2]*omega[2]);
+}
+
+void view_tick(void)
+{
+    uint32_t now = now_us();
+    if (!streaming) return;
+    if (now - rx_last > ORIENT_STALE_US) {          /* stream stopped: hold still */
+        streaming = false;
+        return;
+    }
+    if (!fresh && orient.rate < 1e-4f) return;      /* nothing moves, keep view_generation */
+    fresh = false;
+
+    /* display time, in host clock, minus the sample's stamp */
+    int32_t ahead = (int32_t)(now + ORIENT_LEAD_US - orient.offset_us - t_last);
+    if (ahead < 0) ahead = 0;
+    if (ahead > ORIENT_PREDICT_MAX_US) ahead = ORIENT_PREDICT_MAX_US;
+    orient.predict_us = (uint32_t)ahead;
+
+    float q[4] = { q_last[0], q_last[1], q_last[2], q_last[3] };
+    float half = 0.5f * orient.rate * (ahead * 1e-6f);
+    if (half > 1e-6f) {
+        float k    = fm_sinf(half) / orient.rate;
+        float e[4] = { fm_cosf(half), omega[0] * k, omega[1] * k, omega[2] * k };
+        q_mul(e, q_last, q);
+    }
+    view_set_quat(q[0], q[1], q[2], q[3]);
+}
+
+const ViewOrientStats *view_orient_stats(void) { return &orient; }
+
+const float (*view_matrix(void))[3] { return (const float (*)[3])view_R; }
+uint32_t view_generation(void)      { return view_gen; }
@@ -0,0 +1,111 @@
+/*
+ * led_view.h – per-frame view rotation for the spatial animations
+ *
+ * poly_rotate() moves the vertices and everything derived from them gets
+ * rebuilt (LED positions, geodesic tables, edge spheres). For tilting the
+ * pattern live (gyro from the app) only the animations' view of the LEDs
+ * turns instead: world = R · led_pos, R set here at any rate, read once per
+ * frame. Distances don't change under R, so radius queries (led_spatial)
+ * stay in LED space and only their query points need R^T.
+ *
+ * Orientation stream (PKT_ORIENT, 100–250 Hz): each sample is a unit
+ * quaternion stamped with the host's µs clock. The host clock is mapped onto
+ * ours by the smallest (arrival − stamp) seen, let creep up slowly to follow
+ * drift; the angular velocity comes from consecutive samples. view_tick()
+ * then extrapolates the last sample to when the frame being drawn will be
+ * on the LEDs (ORIENT_LEAD_US ahead), at most ORIENT_PREDICT_MAX_US past the
+ * sample, so a stalled stream holds still instead of spinning on.
+ */
+
+#ifndef _LED_VIEW_H_
+#define _LED_VIEW_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* draw time to light: encode, DMA, latch, roughly one frame */
+#ifndef ORIENT_LEAD_US
+  #define ORIENT_LEAD_US        20000
+#endif
+#ifndef ORIENT_PREDICT_MAX_US
+  #define ORIENT_PREDICT_MAX_US 100000
+#endif
+/* no sample for this long: the next one starts over (offset, velocity) */
+#ifndef ORIENT_STALE_US
+  #define ORIENT_STALE_US       500000
+#endif
+
+typedef struct {
+    uint32_t samples;
+    int32_t  offset_us;     /* our clock − host clock (+ the fastest transit) */
+    float    rate;          /* angular speed, rad/s */
+    uint32_t predict_us;    /* how far the last frame was extrapolated */
+} ViewOrientStats;
+
+/**
+ * View from Tait-Bryan angles (radians), same convention as poly_rotate()
+ */
+void view_set_euler(float yaw, float pitch, float roll);
+
+/**
+ * View from a unit quaternion (normalized here)
+ */
+void view_set_quat(float w, float x, float y, float z);
+
+/**
+ * Back to identity
+ */
+void view_reset(void);
+
+/**
+ * One orientation sample (main loop, PKT_ORIENT)
+ * @param host_us the host's clock when it was read, µs (wraps)
+ * @param q       w x y z, any length
+ */
+void view_orient_sample(uint32_t host_us, const float q[4]);
+
+/**
+ * Once per frame before the animations: the streamed orientation,
+ * extrapolated to display time, becomes the view (no-op without a stream)
+ */
+void view_tick(void);
+
+const ViewOrientStats *view_orient_stats(void);
+
+/**
+ * Current rotation, rows = world axes in LED space
+ */
+const float (*view_matrix(void))[3];
+
+/**
+ * Incremented on every view_set_* / view_reset, for animations that cache
+ * something derived from R
+ */
+uint32_t view_generation(void);
+
+/* world = R · v */
+static inline void view_apply(const float R[3][3], const float v[3], float out[3])
+{
+    out[0] = R[0][0]*v[0] + R[0][1]*v[1] + R[0][2]*v[2];
+    out[1] = R[1][0]*v[0] + R[1][1]*v[1] + R[1][2]*v[2];
+    out[2] = R[2][0]*v[0] + R[2][1]*v[1] + R[2][2]*v[2];
+}
+
+/* LED space = R^T · w (R is orthonormal) */
+static inline void view_unapply(const float R[3][3], const float w[3], float out[3])
+{
+    out[0] = R[0][0]*w[0] + R[1][0]*w[1] + R[2][0]*w[2];
+    out[1] = R[0][1]*w[0] + R[1][1]*w[1] + R[2][1]*w[2];
+    out[2] = R[0][2]*w[0] + R[1][2]*w[1] + R[2][2]*w[2];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_VIEW_H_ */
@@ -0,0 +1,400 @@
+/* --------------------------------------------------------------------------
+ * led_vm.c – checker, decoder and block interpreter for uploaded effects
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "led_vm.h"
+#include "led_shader.h"    /* shader_run, ShaderBlock */
+#include "led_palette.h"   /* palette_shade */
+#include "led_noise.h"     /* noise3_q15 */
+#include "anim_clock.h"    /* anim_clock_us: time input */
+#include "flash_store.h"
+#include "lut.h"           /* lut_sin_q15 */
+
+#include "stm32f4xx.h"     /* CMSIS intrinsics, __UNALIGNED_UINT32_* */
+
+#define STORE_KEY_SCRIPT        0x5343u                 /* "SC" */
+#define VM_INSN_BYTES           4u
+#define VM_REC_LEN              (VM_CODE_MAX * VM_INSN_BYTES)
+
+#if VM_REC_LEN > FLASH_STORE_MAX_LEN
+  #error "VM_CODE_MAX instructions do not fit a flash_store record"
+#endif
+#if SHADER_BLOCK & 1
+  #error "SHADER_BLOCK must be even, the add / sub lanes go two at a time"
+#endif
+
+/* lane rows in the arena: the registers, then one per input (read only) */
+#define VM_ROWS                 (VM_REGS + VM_SRC_COUNT)
+#define VM_ROW_IN(s)            (VM_REGS + (s))
+
+/* inputs gathered per block / filled once per frame */
+#define SRC_BIT(s)              (1u << (s))
+#define SRC_POS                 (SRC_BIT(VM_SRC_X) | SRC_BIT(VM_SRC_Y) | SRC_BIT(VM_SRC_Z))
+#define SRC_ATTR                (SRC_BIT(VM_SRC_T) | SRC_BIT(VM_SRC_AZIM) | SRC_BIT(VM_SRC_ELEV) \
+                                 | SRC_BIT(VM_SRC_RADIUS) | SRC_BIT(VM_SRC_EDGE))
+#define SRC_FRAME               (~(SRC_POS | SRC_ATTR) & (SRC_BIT(VM_SRC_COUNT) - 1u))
+
+uint8_t vm_user[VM_USER];
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Built-in program: palette around z drifting with time, brighter towards
+ * the vertices. r0 = azim + time / 4, r1 = 255 - tri(t) / 2.
+ */
+#define VM_I(op, d, a, b)       (uint8_t)(op), (uint8_t)(d), (uint8_t)(a), (uint8_t)(b)
+
+static const uint8_t vm_builtin[] = {
+    VM_I(VM_IN,      0, VM_SRC_AZIM, 0),
+    VM_I(VM_IN,      1, VM_SRC_TIME, 0),
+    VM_I(VM_SHR,     1, 1, 2),
+    VM_I(VM_ADD,     0, 0, 1),
+    VM_I(VM_IN,      2, VM_SRC_T, 0),
+    VM_I(VM_TRI,     2, 2, 0),
+    VM_I(VM_SHR,     2, 2, 1),
+    VM_I(VM_LDI,     1, 255, 0),
+    VM_I(VM_SUB,     1, 1, 2),
+    VM_I(VM_OUT_PAL, 0, 0, 1),
+};
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Decoded instruction: operands are lane pointers (an input is just a read
+ * only row), IN became MOV, immediates widened.
+ */
+typedef struct {
+    uint8_t        op;
+    int16_t        imm;
+    int16_t       *d;
+    const int16_t *a, *b, *c;       /* c: OUT_RGB's blue */
+} VmInsn;
+
+typedef int16_t VmLanes[SHADER_BLOCK];
+
+static uint8_t   prog[VM_REC_LEN];          /* running program, as uploaded */
+static uint16_t  prog_n      = 0;
+static uint16_t  prog_src    = 0;           /* SRC_BIT() of the inputs it reads */
+static bool      prog_loaded = false;       /* flash / built-in tried once */
+static uint8_t   upload[VM_REC_LEN];        /* 'C' frames land here */
+
+/* arena (vm_init), NULL while the script animation does not run */
+static VmInsn   *code  = NULL;
+static VmLanes  *lanes = NULL;
+static uint16_t  code_n = 0;
+static int32_t   noise_t;                   /* Q16, this frame */
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+static inline uint8_t clamp8(int16_t v) { return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Checking: what every op reads / writes, so the decoder and the checker
+ * agree. A = a is a register, B = b is a register, D = d is written (else
+ * d is read, OUT_RGB).
+ */
+#define OPF_D       0x01u
+#define OPF_A       0x02u
+#define OPF_B       0x04u
+#define OPF_DREAD   0x08u
+#define OPF_OUT     0x10u
+
+static const uint8_t op_flags[VM_OP_COUNT] = {
+    [VM_IN]      = OPF_D,
+    [VM_LDI]     = OPF_D,
+    [VM_MOV]     = OPF_D | OPF_A,
+    [VM_ADD]     = OPF_D | OPF_A | OPF_B,
+    [VM_SUB]     = OPF_D | OPF_A | OPF_B,
+    [VM_MUL]     = OPF_D | OPF_A | OPF_B,
+    [VM_MIN]     = OPF_D | OPF_A | OPF_B,
+    [VM_MAX]     = OPF_D | OPF_A | OPF_B,
+    [VM_ADDI]    = OPF_D | OPF_A,
+    [VM_MULI]    = OPF_D | OPF_A,
+    [VM_SHR]     = OPF_D | OPF_A,
+    [VM_ANDI]    = OPF_D | OPF_A,
+    [VM_ABS]     = OPF_D | OPF_A,
+    [VM_SIN]     = OPF_D | OPF_A,
+    [VM_TRI]     = OPF_D | OPF_A,
+    [VM_NOISE]   = OPF_D | OPF_A | OPF_B,
+    [VM_OUT_PAL] = OPF_OUT | OPF_A | OPF_B,
+    [VM_OUT_RGB] = OPF_OUT | OPF_DREAD | OPF_A | OPF_B,
+};
+
+static VmStatus check(const uint8_t *c, uint16_t n, uint16_t *at, uint16_t *src)
+{
+    bool out = false;
+    *src = 0;
+    if (!c || n == 0 || n > VM_CODE_MAX) { *at = 0; return VM_ERR_LEN; }
+    for (uint16_t i = 0; i < n; ++i, c += VM_INSN_BYTES) {
+        *at = i;
+        if (c[0] >= VM_OP_COUNT) return VM_ERR_OP;
+        uint8_t f = op_flags[c[0]];
+        if ((f & (OPF_D | OPF_DREAD)) && c[1] >= VM_REGS) return VM_ERR_REG;
+        if ((f & OPF_A) && c[2] >= VM_REGS)              return VM_ERR_REG;
+        if ((f & OPF_B) && c[3] >= VM_REGS)              return VM_ERR_REG;
+        if (c[0] == VM_IN) {
+            if (c[2] >= VM_SRC_COUNT) return VM_ERR_SRC;
+            *src |= (uint16_t)SRC_BIT(c[2]);
+        }
+        if (c[0] == VM_NOISE) *src |= SRC_BIT(VM_SRC_TIME);
+        out |= (f & OPF_OUT) != 0;
+    }
+    *at = n;
+    return out ? VM_OK : VM_ERR_NO_OUT;
+}
+
+/* prog → code, only once the arena is there */
+static void decode(void)
+{
+    if (!code) return;
+    const uint8_t *c = prog;
+    for (uint16_t i = 0; i < prog_n; ++i, c += VM_INSN_BYTES) {
+        VmInsn *x = &code[i];
+        x->op  = c[0];
+        x->imm = 0;
+        x->d   = lanes[c[1] < VM_REGS ? c[1] : 0];
+        x->a   = lanes[c[2] < VM_REGS ? c[2] : 0];
+        x->b   = lanes[c[3] < VM_REGS ? c[3] : 0];
+        x->c   = x->b;
+        switch (c[0]) {
+        case VM_IN:      x->op = VM_MOV; x->a = lanes[VM_ROW_IN(c[2])];             break;
+        case VM_LDI:     x->imm = (int16_t)(c[2] | c[3] << 8);                       break;
+        case VM_ADDI:    x->imm = (int8_t)c[3];                                      break;
+        case VM_SHR:     x->imm = c[3] > 15 ? 15 : c[3];                             break;
+        case VM_MULI:
+        case VM_ANDI:    x->imm = c[3];                                              break;
+        case VM_OUT_RGB: x->a = lanes[c[1]]; x->b = lanes[c[2]]; x->c = lanes[c[3]]; break;
+        }
+    }
+    code_n = prog_n;
+}
+
+VmStatus vm_load(const uint8_t *c, uint16_t n, uint16_t *at)
+{
+    uint16_t where, src;
+    VmStatus st = check(c, n, &where, &src);
+    if (at) *at = where;
+    if (st != VM_OK) return st;             /* the old one keeps running */
+    memset(prog, VM_END, sizeof prog);
+    memcpy(prog, c, (size_t)n * VM_INSN_BYTES);
+    prog_n      = n;
+    prog_src    = src;
+    prog_loaded = true;
+    decode();
+    return VM_OK;
+}
+
+uint16_t vm_length(void) { return prog_n; }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Flash: the whole VM_CODE_MAX slots, VM_END after the last instruction
+ * (flash_store only matches records of the length asked for)
+ */
+bool vm_save(void)
+{
+    return prog_n && flash_store_put(STORE_KEY_SCRIPT, prog, sizeof prog);
+}
+
+bool vm_restore(void)
+{
+    uint8_t rec[VM_REC_LEN];
+    if (!flash_store_get(STORE_KEY_SCRIPT, rec, sizeof rec)) return false;
+    uint16_t n = 0;
+    while (n < VM_CODE_MAX && rec[n * VM_INSN_BYTES] != VM_END) ++n;
+    return vm_load(rec, n, NULL) == VM_OK;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Arena
+ */
+size_t vm_bytes(void)
+{
+    return VM_CODE_MAX * sizeof(VmInsn) + VM_ROWS * sizeof(VmLanes);
+}
+
+bool vm_init(PolyArena *a)
+{
+    code  = poly_arena_alloc(a, VM_CODE_MAX * sizeof(VmInsn));
+    lanes = poly_arena_alloc(a, VM_ROWS * sizeof(VmLanes));
+    if (!code || !lanes) return false;
+    memset(lanes, 0, VM_ROWS * sizeof(VmLanes));
+    if (!prog_loaded && !vm_restore()) vm_load(vm_builtin, sizeof vm_builtin / VM_INSN_BYTES, NULL);
+    decode();
+    return true;
+}
+
+void vm_release(void)
+{
+    code   = NULL;
+    lanes  = NULL;
+    code_n = 0;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Lanes. Add / sub go two int16 at a time (QADD16 / QSUB16 on the M4, the
+ * loop runs over n rounded up to even, rows are SHADER_BLOCK long).
+ */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define QADD16x2(a, b)  __QADD16((a), (b))
+#define QSUB16x2(a, b)  __QSUB16((a), (b))
+#else
+static inline uint32_t pack16(int16_t lo, int16_t hi) { return (uint16_t)lo | (uint32_t)(uint16_t)hi << 16; }
+static inline uint32_t QADD16x2(uint32_t a, uint32_t b)
+{
+    return pack16(sat16((int16_t)a + (int16_t)b), sat16((int16_t)(a >> 16) + (int16_t)(b >> 16)));
+}
+static inline uint32_t QSUB16x2(uint32_t a, uint32_t b)
+{
+    return pack16(sat16((int16_t)a - (int16_t)b), sat16((int16_t)(a >> 16) - (int16_t)(b >> 16)));
+}
+#endif
+
+/* sin of a (256 per turn) from the quarter table, Q15 → Q8 */
+static inline int16_t sin_q8(int16_t a)
+{
+    uint8_t i = (uint8_t)a;
+    uint16_t r = (uint16_t)((i & 63u) * (LUT_SIN_QUARTER / 64));
+    int16_t  s = lut_sin_q15[(i & 64u) ? LUT_SIN_QUARTER - r : r];
+    return (int16_t)((i & 128u) ? -(s >> 7) : s >> 7);
+}
+
+/* the per-LED inputs the program reads, for this block */
+static LED_RAMFUNC void vm_gather(const ShaderBlock *b)
+{
+    uint16_t n = b->n;
+    if (prog_src & SRC_POS) {
+        int16_t *x = lanes[VM_ROW_IN(VM_SRC_X)], *y = lanes[VM_ROW_IN(VM_SRC_Y)], *z = lanes[VM_ROW_IN(VM_SRC_Z)];
+        for (uint16_t k = 0; k < n; ++k) {
+            x[k] = (int16_t)(b->x[k] * 256.0f);
+            y[k] = (int16_t)(b->y[k] * 256.0f);
+            z[k] = (int16_t)(b->z[k] * 256.0f);
+        }
+    }
+    if (prog_src & SRC_ATTR) {
+        int16_t *t = lanes[VM_ROW_IN(VM_SRC_T)],      *az = lanes[VM_ROW_IN(VM_SRC_AZIM)];
+        int16_t *el = lanes[VM_ROW_IN(VM_SRC_ELEV)],  *ra = lanes[VM_ROW_IN(VM_SRC_RADIUS)];
+        int16_t *ed = lanes[VM_ROW_IN(VM_SRC_EDGE)];
+        const LedAttr *a = b->attr;
+        for (uint16_t k = 0; k < n; ++k, a += b->step) {
+            t[k]  = a->t;
+            az[k] = a->azim;
+            el[k] = a->elev;
+            ra[k] = a->radius;
+            ed[k] = a->edge;
+        }
+    }
+}
+
+static LED_RAMFUNC void vm_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    (void)uniforms;
+    const uint16_t n = b->n;
+    const uint16_t n2 = (uint16_t)((n + 1u) & ~1u);
+    vm_gather(b);
+
+    for (const VmInsn *x = code, *end = code + code_n; x < end; ++x) {
+        int16_t       *d  = x->d;
+        const int16_t *a  = x->a, *s = x->b;
+        switch (x->op) {
+        case VM_LDI:  for (uint16_t k = 0; k < n; ++k) d[k] = x->imm;                                break;
+        case VM_MOV:  if (d != a) memcpy(d, a, n * sizeof *d);                                      break;
+        case VM_ADD:
+            for (uint16_t k = 0; k < n2; k += 2)
+                __UNALIGNED_UINT32_WRITE(&d[k], QADD16x2(__UNALIGNED_UINT32_READ(&a[k]), __UNALIGNED_UINT32_READ(&s[k])));
+            break;
+        case VM_SUB:
+            for (uint16_t k = 0; k < n2; k += 2)
+                __UNALIGNED_UINT32_WRITE(&d[k], QSUB16x2(__UNALIGNED_UINT32_READ(&a[k]), __UNALIGNED_UINT32_READ(&s[k])));
+            break;
+        case VM_MUL:  for (uint16_t k = 0; k < n; ++k) d[k] = sat16(((int32_t)a[k] * s[k]) >> 8);     break;
+        case VM_MIN:  for (uint16_t k = 0; k < n; ++k) d[k] = a[k] < s[k] ? a[k] : s[k];             break;
+        case VM_MAX:  for (uint16_t k = 0; k < n; ++k) d[k] = a[k] > s[k] ? a[k] : s[k];             break;
+        case VM_ADDI: for (uint16_t k = 0; k < n; ++k) d[k] = sat16((int32_t)a[k] + x->imm);         break;
+        case VM_MULI: for (uint16_t k = 0; k < n; ++k) d[k] = sat16(((int32_t)a[k] * x->imm) >> 4);  break;
+        case VM_SHR:  for (uint16_t k = 0; k < n; ++k) d[k] = (int16_t)(a[k] >> x->imm);             break;
+        case VM_ANDI: for (uint16_t k = 0; k < n; ++k) d[k] = (int16_t)(a[k] & x->imm);              break;
+        case VM_ABS:  for (uint16_t k = 0; k < n; ++k) d[k] = sat16(a[k] < 0 ? -(int32_t)a[k] : a[k]); break;
+        case VM_SIN:  for (uint16_t k = 0; k < n; ++k) d[k] = sin_q8(a[k]);                          break;
+        case VM_TRI:
+            for (uint16_t k = 0; k < n; ++k) {
+                uint8_t v = (uint8_t)a[k];
+                d[k] = (int16_t)(v < 128 ? v * 2 : (255 - v) * 2);
+            }
+            break;
+        case VM_NOISE:
+            for (uint16_t k = 0; k < n; ++k)
+                d[k] = (int16_t)(noise3_q15((int32_t)a[k] << 8, (int32_t)s[k] << 8, noise_t) >> 7);
+            break;
+        case VM_OUT_PAL:
+            for (uint16_t k = 0; k < n; ++k) out[k] = palette_shade((uint8_t)a[k], 255, clamp8(s[k]));
+            break;
+        case VM_OUT_RGB:
+            for (uint16_t k = 0; k < n; ++k) out[k] = (rgb_8b){ clamp8(a[k]), clamp8(s[k]), clamp8(x->c[k]) };
+            break;
+        }
+    }
+}
+
+void vm_run(uint8_t interlace)
+{
+    if (!code || !code_n) return;
+
+    /* per frame inputs: the same in every lane, filled once */
+    uint32_t us   = anim_clock_us();
+    uint16_t time = (uint16_t)(((uint64_t)us << 8) / 1000000u);
+    noise_t = (int32_t)time << 8;                         /* one cell per second, 256 s period */
+    for (uint8_t s = VM_SRC_TIME; s < VM_SRC_COUNT; ++s) {
+        if (!(prog_src & SRC_BIT(s) & SRC_FRAME)) continue;
+        int16_t v = s == VM_SRC_TIME ? (int16_t)time : vm_user[s - VM_SRC_U0];
+        for (uint16_t k = 0; k < SHADER_BLOCK; ++k) lanes[VM_ROW_IN(s)][k] = v;
+    }
+
+    const Shader sh = {
+        vm_kernel,
+        (uint8_t)(((prog_src & SRC_POS) ? SHADER_IN_POS : 0) | ((prog_src & SRC_ATTR) ? SHADER_IN_ATTR : 0)),
+        SHADER_WRITE,
+        interlace,
+    };
+    shader_run(&sh, NULL);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Binary frames
+ */
+uint16_t vm_frame_handle(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t cap)
+{
+    if (cap < 4) return 0;
+    uint8_t op  = len > 1 ? in[1] : 0;
+    uint8_t arg = len > 2 ? in[2] : 0;
+    out[0] = VM_FRAME_MAGIC;
+    out[1] = op;
+    out[2] = VM_ERR_FRAME;
+    out[3] = 0;
+    if (len < 2 || in[0] != VM_FRAME_MAGIC) return 4;
+
+    switch (op) {
+    case 'C': {
+        uint16_t n = (uint16_t)((len - 3) / VM_INSN_BYTES);
+        out[3] = arg;
+        if (len < 3 + VM_INSN_BYTES || (len - 3) % VM_INSN_BYTES) break;
+        if (arg + n > VM_CODE_MAX) { out[2] = VM_ERR_LEN; break; }
+        if (arg == 0) memset(upload, VM_END, sizeof upload);       /* a new upload */
+        memcpy(&upload[arg * VM_INSN_BYTES], &in[3], (size_t)n * VM_INSN_BYTES);
+        out[2] = VM_OK;
+        break;
+    }
+
+    case 'E': {
+        uint16_t at = 0;
+        if (len < 3) break;
+        out[2] = vm_load(upload, arg, &at);
+        out[3] = (uint8_t)at;
+        break;
+    }
+
+    case 'W':
+    case 'L':
+        out[2] = (op == 'W' ? vm_save() : vm_restore()) ? VM_OK : VM_ERR_FLASH;
+        break;
+    }
+    return 4;
+}
@@ -0,0 +1,144 @@
+/*
+ * led_vm.h – uploaded per-LED effect programs ("script" animation)
+ *
+ * A small register machine run as a shader kernel: every instruction works
+ * on a whole block (SHADER_BLOCK LEDs of one edge) before the next one, so
+ * the dispatch is paid once per block, not per LED, and the lane loops are
+ * plain array arithmetic. Programs come in as 4 byte instructions over USB
+ * (binary frames below, app/script_asm.py assembles them), are checked and
+ * decoded once (operands turned into register pointers, inputs worked out),
+ * and can be kept in flash. A bad program is refused, the old one keeps
+ * running.
+ *
+ * Values are int16 lanes in Q8: 256 = 1.0 = a full turn = the whole palette.
+ * Inputs per LED: x y z (LED space, -256..256), the attributes (t, azim, elev,
+ * radius: 0..255, edge), per frame: time (1/256 s, wraps) and the user
+ * knobs u0..u3 ("script.u0".. parameters).
+ */
+
+#ifndef _LED_VM_H_
+#define _LED_VM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+#include "polyhedron.h"    /* PolyArena */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* instructions per program (4 bytes each, the flash record holds them all) */
+#ifndef VM_CODE_MAX
+  #define VM_CODE_MAX           64
+#endif
+
+#define VM_REGS                 8
+#define VM_USER                 4       /* u0..u3 */
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Instruction: op d a b. a / b are registers unless said otherwise,
+ * Q8 multiply: (a * b) >> 8, results saturate to int16.
+ */
+typedef enum {
+    VM_IN,          /* d = input a (VmSrc)                                  */
+    VM_LDI,         /* d = a | b << 8 (int16 immediate)                     */
+    VM_MOV,         /* d = a                                                */
+    VM_ADD,         /* d = a + b                                            */
+    VM_SUB,         /* d = a - b                                            */
+    VM_MUL,         /* d = a * b >> 8                                       */
+    VM_MIN,         /* d = min(a, b)                                        */
+    VM_MAX,         /* d = max(a, b)                                        */
+    VM_ADDI,        /* d = a + (int8)b                                      */
+    VM_MULI,        /* d = a * b >> 4 (b unsigned: 16 = ×1, up to ×16)      */
+    VM_SHR,         /* d = a >> b (arithmetic)                              */
+    VM_ANDI,        /* d = a & b (255: wrap an angle / palette index)       */
+    VM_ABS,         /* d = |a|                                              */
+    VM_SIN,         /* d = sin(a / 256 turns) · 256                         */
+    VM_TRI,         /* d = triangle wave of a: 0 → 255 → 0 per 256          */
+    VM_NOISE,       /* d = simplex noise (a, b, time) · 256, cells of 256   */
+    VM_OUT_PAL,     /* LED = palette entry a & 255 at brightness b (0..255) */
+    VM_OUT_RGB,     /* LED = (d, a, b), clamped to 0..255                   */
+    VM_OP_COUNT,
+    VM_END = 0xFF,  /* padding after the last instruction                   */
+} VmOp;
+
+typedef enum {
+    VM_SRC_X, VM_SRC_Y, VM_SRC_Z,               /* needs the position cache */
+    VM_SRC_T, VM_SRC_AZIM, VM_SRC_ELEV, VM_SRC_RADIUS, VM_SRC_EDGE,
+    VM_SRC_TIME,
+    VM_SRC_U0,                                  /* .. VM_SRC_U0 + VM_USER - 1 */
+    VM_SRC_COUNT = VM_SRC_U0 + VM_USER,
+} VmSrc;
+
+typedef enum {
+    VM_OK,
+    VM_ERR_OP,          /* unknown opcode        (at: its index) */
+    VM_ERR_REG,         /* register >= VM_REGS   */
+    VM_ERR_SRC,         /* input >= VM_SRC_COUNT */
+    VM_ERR_NO_OUT,      /* nothing is ever drawn */
+    VM_ERR_LEN,         /* empty / longer than VM_CODE_MAX */
+    VM_ERR_FRAME,       /* unknown op, too short */
+    VM_ERR_FLASH,       /* not saved / no program there */
+} VmStatus;
+
+/* the knobs programs read as u0..u3 */
+extern uint8_t vm_user[VM_USER];
+
+/**
+ * Check and decode n instructions (4 bytes each), run them from now on
+ * @param at  index of the offending instruction on an error, may be NULL
+ */
+VmStatus vm_load(const uint8_t *code, uint16_t n, uint16_t *at);
+
+/**
+ * Arena bytes vm_init() takes (decoded program + register file)
+ */
+size_t vm_bytes(void);
+
+/**
+ * Carve the decoded program and registers from a. The first time, the
+ * program saved in flash is restored, or the built-in one used.
+ */
+bool vm_init(PolyArena *a);
+void vm_release(void);
+
+/**
+ * Draw one frame with the current program
+ * @param interlace  Shader.interlace (SHADER_IL_*)
+ */
+void vm_run(uint8_t interlace);
+
+/**
+ * Current program into flash / the saved one back (false: none there)
+ */
+bool vm_save(void);
+bool vm_restore(void);
+
+/**
+ * Instructions in the running program
+ */
+uint16_t vm_length(void);
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Binary frames:
+ *   'C' idx insn...     → 'C' st idx        (instructions idx.. into the upload buffer)
+ *   'E' n               → 'E' st at         (load the first n uploaded, at = bad insn)
+ *   'W' / 'L'           → 'W' / 'L' st 0    (save / restore)
+ * every frame starts with VM_FRAME_MAGIC, st is a VmStatus; they travel
+ * as PKT_SCRIPT packets (usb_packet.h)
+ */
+#define VM_FRAME_MAGIC          0xA8u
+
+/**
+ * Handle one request frame, reply into out (at least 4 bytes)
+ * @return reply length (0: out too small)
+ */
+uint16_t vm_frame_handle(const uint8_t *in, uint16_t len, uint8_t *out, uint16_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_VM_H_ */
@@ -0,0 +1,128 @@
+/* --------------------------------------------------------------------------
+ * led_wave.c – fixed point wave stencil along the edges, joints at the
+ *               vertices (led_wave.h)
+ * -------------------------------------------------------------------------- */
+#include "led_wave.h"
+
+#include <string.h>
+#include "led_mapping.h"   /* edge_base, logical order */
+#include "led_shader.h"    /* shader_run */
+#include "led_palette.h"   /* palette_shade */
+
+extern Polyhedron poly;
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : v < -INT16_MAX ? -INT16_MAX : v);
+}
+
+size_t wave_bytes(void)
+{
+    const uint16_t n = mapping_get_total_pixels();
+    return 2u * POLY_ARENA_ALIGN(n * sizeof(int16_t)) + POLY_ARENA_ALIGN(poly.V * sizeof(int32_t));
+}
+
+bool wave_init(WaveSim *w, PolyArena *a)
+{
+    w->n     = mapping_get_total_pixels();
+    w->E     = mapping_get_edge_count();
+    w->V     = poly.V;
+    w->u     = poly_arena_alloc(a, w->n * sizeof *w->u);
+    w->prev  = poly_arena_alloc(a, w->n * sizeof *w->prev);
+    w->joint = poly_arena_alloc(a, w->V * sizeof *w->joint);
+    if (!w->u || !w->prev || !w->joint || !mapping_get_edge_base()) return false;
+    wave_clear(w);
+    return true;
+}
+
+void wave_clear(WaveSim *w)
+{
+    memset(w->u,    0, w->n * sizeof *w->u);
+    memset(w->prev, 0, w->n * sizeof *w->prev);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * One pass over the edge ends for the joints, one in logical order for the
+ * LEDs; the new values go over u' in place and the two swap
+ */
+void wave_step(WaveSim *w)
+{
+    const uint16_t *base = mapping_get_edge_base();
+    const Edge     *ed   = poly.e;
+    int16_t        *u    = w->u, *out = w->prev;
+    int32_t        *j    = w->joint;
+
+    memset(j, 0, w->V * sizeof *j);
+    for (poly_idx_t e = 0; e < w->E; ++e) {
+        if (base[e + 1] == base[e]) continue;
+        j[ed[e].a] += u[base[e]];
+        j[ed[e].b] += u[base[e + 1] - 1u];
+    }
+    for (poly_idx_t v = 0; v < w->V; ++v) {
+        uint8_t deg;
+        poly_vertex_edges(&poly, v, &deg);
+        if (deg) j[v] /= deg;
+    }
+
+    const int32_t c2 = w->c2, damp = w->damp;
+    for (poly_idx_t e = 0; e < w->E; ++e) {
+        const uint16_t i0 = base[e], i1 = base[e + 1];
+        if (i0 == i1) continue;
+        int32_t left = j[ed[e].a];
+        for (uint16_t i = i0; i < i1; ++i) {
+            const int32_t c     = u[i];
+            const int32_t right = i + 1u < i1 ? u[i + 1] : j[ed[e].b];
+            const int32_t v     = 2 * c - out[i] + ((c2 * (left + right - 2 * c)) >> 8);
+            out[i] = (int16_t)((sat16(v) * damp) >> 16);
+            left   = c;
+        }
+    }
+    w->u    = out;
+    w->prev = u;
+}
+
+void wave_poke(WaveSim *w, uint16_t i, int16_t amp)
+{
+    if (i >= w->n) return;
+    w->u[i]    = sat16(w->u[i] + amp);
+    w->prev[i] = sat16(w->prev[i] + amp);     /* at rest there: no kick, it spreads both ways */
+}
+
+void wave_poke_vertex(WaveSim *w, poly_idx_t v, int16_t amp)
+{
+    if (v >= w->V) return;
+    const uint16_t *base = mapping_get_edge_base();
+    uint8_t deg;
+    const poly_idx_t *inc = poly_vertex_edges(&poly, v, &deg);
+    for (uint8_t k = 0; k < deg; ++k) {
+        const poly_idx_t e = inc[k];
+        if (base[e + 1] == base[e]) continue;
+        wave_poke(w, poly.e[e].a == v ? base[e] : (uint16_t)(base[e + 1] - 1u), amp);
+    }
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Render
+ */
+typedef struct {
+    const int16_t *u;
+    uint8_t        hue;
+} WaveUniforms;
+
+static void wave_kernel(const ShaderBlock *b, const void *uniforms, rgb_8b *out)
+{
+    const WaveUniforms *wu = uniforms;
+    const int16_t      *u  = wu->u + b->logical;
+    for (uint16_t k = 0; k < b->n; ++k, u += b->stride) {
+        const int32_t v   = *u;
+        const int32_t mag = (v < 0 ? -v : v) >> 4;             /* WAVE_ONE → 256 */
+        out[k] = palette_shade((uint8_t)(wu->hue + (v >> 5)), 255, (uint8_t)(mag > 255 ? 255 : mag));
+    }
+}
+
+bool wave_render(const WaveSim *w, uint8_t hue)
+{
+    static const Shader shader = { wave_kernel, 0, SHADER_WRITE };
+    const WaveUniforms wu = { w->u, hue };
+    return shader_run(&shader, &wu);
+}
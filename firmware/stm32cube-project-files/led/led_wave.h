@@ -0,0 +1,87 @@
+/*
+ * led_wave.h – waves running along the struts, split at the vertices
+ *
+ * A 1D wave equation per edge on the LEDs, leapfrog in fixed point (int16,
+ * WAVE_ONE = 1.0): with u' the last step,
+ *
+ *   u ← (2u − u' + c² (left + right − 2u)) · damp
+ *
+ * Neighbours are the LEDs either side along the edge; past its first and
+ * last LED the neighbour is the junction at the vertex, the mean of the end
+ * LEDs of every edge meeting there (a massless joint: a pulse arriving at a
+ * degree 3 vertex goes on into both other edges at 2/3 and comes back
+ * inverted at 1/3). The state is kept in logical pixel order, so a step is
+ * one straight pass over two int16 arrays plus one over the edge ends, and
+ * rendering is a shader over the same order (|u| → brightness, the sign
+ * moves the palette index).
+ *
+ * The buffers come from the animation's arena (wave_bytes()); ~6 cycles per
+ * LED and step on the M4, 720 LEDs at 100 steps per second take ~5 % of it.
+ */
+
+#ifndef _LED_WAVE_H_
+#define _LED_WAVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "polyhedron.h"    /* poly_idx_t, PolyArena */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAVE_ONE        4096        /* Q12: ±8 of headroom before it clips */
+#define WAVE_C2_ONE     256         /* c² = 1, the most a leapfrog step holds */
+
+typedef struct {
+    int16_t        *u, *prev;       /* logical pixel order, prev becomes the next step */
+    int32_t        *joint;          /* per vertex: sum of its edge ends, then their mean */
+    uint16_t        n;              /* LEDs                                  */
+    poly_idx_t      E, V;
+    uint16_t        c2;             /* c² · WAVE_C2_ONE, 1 … WAVE_C2_ONE     */
+    uint16_t        damp;           /* kept per step, Q16 (65535 ≈ none)     */
+} WaveSim;
+
+/**
+ * Arena bytes wave_init() takes on the current mapping
+ */
+size_t wave_bytes(void);
+
+/**
+ * Carve the state from a and set it still (c2 and damp are the caller's)
+ * @return false if the arena is too small or there is no mapping
+ */
+bool wave_init(WaveSim *w, PolyArena *a);
+
+/**
+ * Everything still again (same mapping)
+ */
+void wave_clear(WaveSim *w);
+
+/**
+ * One time step over every LED
+ */
+void wave_step(WaveSim *w);
+
+/**
+ * Displace logical LED i by amp (a drop: the wave leaves both ways)
+ */
+void wave_poke(WaveSim *w, uint16_t i, int16_t amp);
+
+/**
+ * Displace the ends of every edge at vertex v by amp
+ */
+void wave_poke_vertex(WaveSim *w, poly_idx_t v, int16_t amp);
+
+/**
+ * Draw the state through the palette: brightness |u| (WAVE_ONE = full),
+ * palette index hue + u / 32, so crests and troughs differ in colour
+ */
+bool wave_render(const WaveSim *w, uint8_t hue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LED_WAVE_H_ */
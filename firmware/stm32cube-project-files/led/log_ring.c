@@ -0,0 +1,96 @@
+/* --------------------------------------------------------------------------
+ * log_ring.c – lock-free multi-producer record ring (log_ring.h)
+ *
+ * Records are a header word and the bytes, word aligned, never split: one
+ * that would run over the end is put at the start, a pad record filling
+ * the rest (reserved in the same step). The header reads
+ *
+ *     len (16) | tag (8) | LR_READY (8)
+ *
+ * and is zero until the producer is done. The consumer zeroes it again
+ * before it hands the room back, so a slot is never seen ready twice.
+ * -------------------------------------------------------------------------- */
+#include "log_ring.h"
+
+#include <string.h>
+#include "stm32f4xx.h"     /* __LDREXW / __STREXW / __CLREX / __DMB */
+
+_Static_assert(LOG_RING_SIZE >= 64 && !(LOG_RING_SIZE & (LOG_RING_SIZE - 1)),
+               "LOG_RING_SIZE: a power of two, 64 or more");
+
+#define LR_READY    0xA5u
+#define LR_PAD      0xFFu           /* the tag of a pad record */
+#define LR_MASK     (LOG_RING_SIZE - 1u)
+
+static uint32_t          ring[LOG_RING_SIZE / 4];
+static volatile uint32_t wr;        /* producers: next byte reserved, free running */
+static volatile uint32_t rd;        /* consumer: oldest byte still held  */
+static volatile uint32_t dropped;
+
+static inline uint32_t *slot(uint32_t at) { return &ring[(at & LR_MASK) / 4u]; }
+
+static void count_drop(uint32_t n)
+{
+    uint32_t d;
+    do {
+        d = __LDREXW(&dropped);
+    } while (__STREXW(d + n, &dropped));
+}
+
+bool log_ring_put(uint8_t tag, const void *buf, uint16_t len)
+{
+    uint32_t need = 4u + ((len + 3u) & ~3u);
+    uint32_t w, at, pad;
+    if (need > LOG_RING_SIZE / 2u) {
+        count_drop(len);
+        return false;
+    }
+    do {
+        w   = __LDREXW(&wr);
+        at  = w & LR_MASK;
+        pad = at + need > LOG_RING_SIZE ? LOG_RING_SIZE - at : 0u;
+        if (w + pad + need - rd > LOG_RING_SIZE) {
+            __CLREX();
+            count_drop(len);
+            return false;
+        }
+    } while (__STREXW(w + pad + need, &wr));
+
+    if (pad) {                      /* the rest of the ring, skipped */
+        __DMB();
+        *slot(w) = (pad - 4u) << 16 | (uint32_t)LR_PAD << 8 | LR_READY;
+        w += pad;
+    }
+    memcpy(slot(w) + 1, buf, len);
+    __DMB();                        /* bytes land before the header says so */
+    *slot(w) = (uint32_t)len << 16 | (uint32_t)tag << 8 | LR_READY;
+    return true;
+}
+
+const uint8_t *log_ring_peek(uint8_t *tag, uint16_t *len)
+{
+    for (;;) {
+        if (rd == wr) return NULL;
+        uint32_t h = *slot(rd);
+        if ((h & 0xFFu) != LR_READY) return NULL;   /* reserved, not written yet */
+        __DMB();                    /* header read before the bytes it covers */
+        if ((h >> 8 & 0xFFu) == LR_PAD) {
+            log_ring_pop();
+            continue;
+        }
+        *tag = (uint8_t)(h >> 8);
+        *len = (uint16_t)(h >> 16);
+        return (const uint8_t *)(slot(rd) + 1);
+    }
+}
+
+void log_ring_pop(void)
+{
+    uint32_t *h   = slot(rd);
+    uint32_t  len = *h >> 16;
+    *h = 0;
+    __DMB();                        /* the slot is cleared before it is handed back */
+    rd = rd + 4u + ((len + 3u) & ~3u);
+}
+
+uint32_t log_ring_dropped(void) { return dropped; }
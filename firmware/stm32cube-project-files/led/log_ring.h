@@ -0,0 +1,62 @@
+/*
+ * log_ring.h – lock-free record ring, any number of producers (ISRs at any
+ * priority, tasks) and one consumer
+ *
+ * The TX rings (usb_comms.c) are guarded by masking the USB interrupt only,
+ * so an other interrupt writing while the main loop is in the middle of a
+ * write would tear them. Such writes land here instead, whole records,
+ * and the main loop moves them on (flush_usb_buffer) in the order they
+ * were reserved.
+ *
+ * A producer reserves its room with LDREX / STREX on the write index, so
+ * an interrupt between two producers' reservations just takes the room
+ * after theirs, then copies and publishes the record's header last (after
+ * a DMB). The consumer takes published records from the oldest on and
+ * stops at the first one still being written; its room comes back once
+ * it is taken. Nothing masks interrupts, nothing waits: a record that
+ * does not fit is dropped and counted.
+ */
+
+#ifndef _LOG_RING_H_
+#define _LOG_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bytes, a power of two; a record takes 4 + its length rounded up to 4 */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE   1024
+#endif
+
+/**
+ * @brief  Queue one record, from any context.
+ * @param  tag  the consumer's (a TxChannel), 0..254
+ * @return false: no room, dropped
+ */
+bool log_ring_put(uint8_t tag, const void *buf, uint16_t len);
+
+/**
+ * @brief  Consumer: the oldest published record, NULL if none; stays in
+ *         the ring until log_ring_pop().
+ */
+const uint8_t *log_ring_peek(uint8_t *tag, uint16_t *len);
+
+/**
+ * @brief  Consumer: hand the peeked record's room back.
+ */
+void log_ring_pop(void);
+
+/**
+ * @brief  Bytes of records dropped for want of room since boot.
+ */
+uint32_t log_ring_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOG_RING_H_ */
@@ -0,0 +1,37 @@
+/* --------------------------------------------------------------------------
+ * lut.c – flash lookup tables (lut_tables.inc) and their accessors
+ * -------------------------------------------------------------------------- */
+#include "lut.h"
+#include <stddef.h>
+
+#include "lut_tables.inc"
+
+const uint8_t *lut_gamma_table(float gamma)
+{
+    for (unsigned k = 0; k < LUT_GAMMA_CNT; ++k)
+        if (lut_gamma_exp[k] == gamma) return lut_gamma8[k];
+    return NULL;
+}
+
+/* k in table steps, any quadrant */
+static inline int32_t sin_step(uint32_t k)
+{
+    uint32_t j = k & (LUT_SIN_QUARTER - 1);
+    switch ((k / LUT_SIN_QUARTER) & 3) {
+    case 0:  return  lut_sin_q15[j];
+    case 1:  return  lut_sin_q15[LUT_SIN_QUARTER - j];
+    case 2:  return -lut_sin_q15[j];
+    default: return -lut_sin_q15[LUT_SIN_QUARTER - j];
+    }
+}
+
+float lut_sinf(float x)
+{
+    float   t = x * (LUT_SIN_QUARTER / 1.57079633f);
+    int32_t i = (int32_t)t;
+    if ((float)i > t) --i;                      /* floor for negative x */
+    float   fr = t - (float)i;
+    int32_t a  = sin_step((uint32_t)i);
+    int32_t b  = sin_step((uint32_t)i + 1u);
+    return ((float)a + (float)(b - a) * fr) * (1.0f / 32767.0f);
+}
@@ -0,0 +1,112 @@
+/*
+ * lut.h – constant lookup tables in flash (lut_tables.inc)
+ *
+ * Generated by tools/lut_gen.c at full float precision on the host, so the
+ * firmware does no powf / sinf / bit expansion at boot and keeps none of it
+ * in RAM. Rerun after touching a generator formula (or to add a gamma):
+ *
+ *   gcc -O2 -I led tools/lut_gen.c -lm -o lut_gen
+ *   ./lut_gen > led/lut_tables.inc
+ */
+
+#ifndef _LUT_H_
+#define _LUT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* quarter sine wave: steps per quarter turn */
+#define LUT_SIN_QUARTER  256
+
+/* gamma exponents tabulated, GAMMA_CORRECTION outside the list is built at init */
+#define LUT_GAMMA_LIST   { 1.8f, 2.0f, 2.2f, 2.5f, 2.8f }
+
+extern const int16_t  lut_sin_q15[LUT_SIN_QUARTER + 1];  /* sin(i/Q · π/2) · 32767       */
+extern const uint32_t lut_ws_bits[256];     /* byte → 24 SPI bits, 1 = 110, 0 = 100, MSB first */
+extern const uint8_t  lut_rainbow[256][3];  /* lut_rainbow_raw(hue), full sat / val            */
+
+/**
+ * Gamma LUT (round(255 · (i/255)^gamma)) for a tabulated exponent.
+ * @return NULL if gamma is not in LUT_GAMMA_LIST
+ */
+const uint8_t *lut_gamma_table(float gamma);
+
+/**
+ * sinf / cosf from the quarter-wave table, linear in between
+ * (error < 2e-5, any finite x with |x| < ~1e6)
+ */
+float lut_sinf(float x);
+static inline float lut_cosf(float x) { return lut_sinf(x + 1.57079633f); }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * lut_rainbow is made of this (steps 1 + 2 of hsv_to_rgb_rainbow, the
+ * FastLED-style 8-band rainbow, kept here for the generator)
+ */
+static inline uint8_t lut_scale8(uint8_t i, uint8_t scale) {
+    return ((uint16_t)i * scale) >> 8;
+}
+static inline uint8_t lut_scale8_video(uint8_t i, uint8_t scale) {
+    return ((uint16_t)i * scale >> 8) + ((i && scale) ? 1 : 0);
+}
+static inline void lut_rainbow_raw(uint8_t hue, uint8_t *pr, uint8_t *pg, uint8_t *pb)
+{
+    /* ───── 1. coarse → fine decode of the hue byte ──────────────────── */
+    uint8_t offset   = hue & 0x1F;          /* 0…31 within 1/8th          */
+    uint8_t offset8  = offset << 3;         /* 0…248 (×8)                 */
+    uint8_t third    = lut_scale8(offset8,  85);/* 0…85  == ⅓ of offset8      */
+    uint8_t twothird = lut_scale8(offset8, 170);/* 0…170 == ⅔ of offset8      */
+
+    uint8_t r=0, g=0, b=0;
+
+    /* ───── 2. raw un‑saturated rainbow (Y‑boost, green fixes op‑in) ─── */
+    const uint8_t Y1 = 1, Y2 = 0;           /* yellow brightness tweak    */
+    const uint8_t G2 = 0, Gscale = 0;       /* green dimming (unused)     */
+
+    if (!(hue & 0x80)) {                    /* 0XXX = regions 0‑3         */
+        if (!(hue & 0x40)) {                /* 00XX = 0‑1                 */
+            if (!(hue & 0x20)) {            /* 000X = region 0 R→O        */
+                r = 255 - third;  g = third;          b = 0;
+            } else {                        /* 001X = region 1 O→Y        */
+                if (Y1) { r = 171;          g = 85 + third; b = 0; }
+                if (Y2) { r = 170 + third;  g = 85 + twothird; b = 0; }
+            }
+        } else {                            /* 01XX = 2‑3                 */
+            if (!(hue & 0x20)) {            /* 010X = region 2 Y→G        */
+                if (Y1) { r = 171 - twothird; g = 170 + third; b = 0; }
+                if (Y2) { r = 255 - offset8; g = 255;         b = 0; }
+            } else {                        /* 011X = region 3 G→C        */
+                r = 0;            g = 255 - third;  b = third;
+            }
+        }
+    } else {                                /* 1XXX = regions 4‑7         */
+        if (!(hue & 0x40)) {                /* 10XX = 4‑5                 */
+            if (!(hue & 0x20)) {            /* 100X = region 4 C→B  **FIX** */
+                r = 0;
+                g = 171 - twothird;         /* fade G 171→0               */
+                b =  85 + twothird;         /* rise B 85→255              */
+            } else {                        /* 101X = region 5 B→P        */
+                r = third;       g = 0;              b = 255 - third;
+            }
+        } else {                            /* 11XX = 6‑7                 */
+            if (!(hue & 0x20)) {            /* 110X = region 6 P→M        */
+                r =  85 + third; g = 0;      b = 171 - third;
+            } else {                        /* 111X = region 7 M→R        */
+                r = 170 + third; g = 0;      b =  85 - third;
+            }
+        }
+    }
+
+    if (G2)     g >>= 1;                    /* optional green trim        */
+    if (Gscale) g = lut_scale8_video(g, Gscale);
+
+    *pr = r;   *pg = g;   *pb = b;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LUT_H_ */
@@ -0,0 +1,99 @@
+/* --------------------------------------------------------------------------
+ * pc_sample.c – TIM4 samples the interrupted PC, PKT_PCSAMPLE to the host
+ * -------------------------------------------------------------------------- */
+#include "pc_sample.h"
+
+#ifdef LED_PC_SAMPLE
+
+#include <string.h>
+#include "usb_packet.h"      /* usb_packet_send, PKT_OVERHEAD */
+#include "usb_comms.h"       /* usb_tx_channel_room */
+#include "spsc_ring.h"
+#include "stm32f4xx_hal.h"
+
+SPSC_RING(ring, PCS_RING_BYTES);
+static PcsStats          stats;
+static volatile uint32_t dropped;   /* ISR side, stats.dropped has those reported */
+static uint16_t          hz;
+
+/* TIM4 runs off APB1, doubled when APB1 is divided (84 MHz here) */
+static uint32_t tim4_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE1) ? 2 * pclk : pclk;
+}
+
+void pcs_set_hz(uint16_t rate)
+{
+    if (rate > PCS_HZ_MAX) rate = PCS_HZ_MAX;
+    hz = rate;
+    TIM4->CR1 = 0;
+    if (!rate) return;
+
+    __HAL_RCC_TIM4_CLK_ENABLE();
+    TIM4->PSC  = tim4_clock() / 1000000UL - 1;     /* 1 MHz */
+    TIM4->ARR  = 1000000UL / rate - 1;
+    TIM4->CNT  = 0;
+    TIM4->EGR  = TIM_EGR_UG;
+    TIM4->SR   = 0;
+    TIM4->DIER = TIM_DIER_UIE;
+    HAL_NVIC_SetPriority(TIM4_IRQn, 1, 0);         /* under USB, above everything else */
+    HAL_NVIC_EnableIRQ(TIM4_IRQn);
+    TIM4->CR1  = TIM_CR1_CEN;
+}
+
+uint16_t pcs_hz(void)
+{
+    return hz;
+}
+
+/* frame: the exception frame the interrupted code stacked, r0 r1 r2 r3 r12
+ * lr pc xpsr */
+void pcs_sample(const uint32_t *frame)
+{
+    TIM4->SR = 0;
+    uint32_t pc = frame[6];
+    stats.samples++;
+    if (spsc_push(&ring, (const uint8_t *)&pc, 4) != 4) dropped++;
+}
+
+/* The frame is on the stack the interrupted code was using: the process
+ * stack (main loop after stack_init(), RTOS tasks) or the main stack (an
+ * interrupted ISR), EXC_RETURN bit 2 tells which. Naked, nothing pushed
+ * before the stack pointer is read. */
+__attribute__((naked)) void TIM4_IRQHandler(void)
+{
+    __asm volatile(
+        "tst   lr, #4      \n"
+        "ite   eq          \n"
+        "mrseq r0, msp     \n"
+        "mrsne r0, psp     \n"
+        "b     pcs_sample  \n");
+}
+
+void pcs_tick(void)
+{
+    for (;;) {
+        uint16_t n = (uint16_t)(spsc_used(&ring) / 4u);
+        if (!n || (n < PCS_CHUNK && hz)) return;   /* whole packets while sampling */
+        if (n > PCS_CHUNK) n = PCS_CHUNK;
+        if (usb_tx_channel_room(TX_CH_PACKET) < 4u + 4u * n + PKT_OVERHEAD) return;
+
+        uint8_t  b[4 + 4 * PCS_CHUNK];
+        uint32_t d    = dropped - stats.dropped;
+        uint16_t lost = (uint16_t)(d > UINT16_MAX ? UINT16_MAX : d);
+        stats.dropped += lost;
+        memcpy(&b[0], &hz, 2);
+        memcpy(&b[2], &lost, 2);
+        spsc_pop(&ring, &b[4], (uint16_t)(4u * n));
+        usb_packet_send(PKT_PCSAMPLE, b, (uint8_t)(4u + 4u * n));
+        stats.sent += n;
+    }
+}
+
+const PcsStats *pcs_stats(void)
+{
+    return &stats;
+}
+
+#endif /* LED_PC_SAMPLE */
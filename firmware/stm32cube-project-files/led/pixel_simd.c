@@ -0,0 +1,124 @@
+/* --------------------------------------------------------------------------
+ * pixel_simd.c – packed byte kernels for fades and additive blends
+ * -------------------------------------------------------------------------- */
+#include "pixel_simd.h"
+#include "led_render.h"          /* LED_RAMFUNC */
+
+#include "stm32f4xx.h"           /* __UNALIGNED_UINT32_* */
+
+static inline uint8_t qadd8(uint8_t a, uint8_t b) { uint16_t s = a + b; return s > 255 ? 255 : (uint8_t)s; }
+static inline uint8_t qsub8(uint8_t a, uint8_t b) { return a > b ? a - b : 0; }
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * (v * f) >> 8 on all four bytes: even and odd bytes each get a 16-bit lane,
+ * 255 * 255 still fits, so two multiplies do four channels.
+ */
+static inline uint32_t scale8x4(uint32_t w, uint32_t f)
+{
+    uint32_t even = (((w       & 0x00FF00FFu) * f) >> 8) & 0x00FF00FFu;
+    uint32_t odd  = (((w >> 8) & 0x00FF00FFu) * f)       & 0xFF00FF00u;
+    return even | odd;
+}
+
+/* the same lanes for a mix: both products of a lane add up to 255 * 256 at
+ * most, still no carry into the next one */
+static inline uint32_t lerp8x4(uint32_t a, uint32_t b, uint32_t t)
+{
+    uint32_t s    = 256u - t;
+    uint32_t even = ((( a       & 0x00FF00FFu) * s + ( b       & 0x00FF00FFu) * t) >> 8) & 0x00FF00FFu;
+    uint32_t odd  =  (((a >> 8) & 0x00FF00FFu) * s + ((b >> 8) & 0x00FF00FFu) * t)       & 0xFF00FF00u;
+    return even | odd;
+}
+
+
+LED_RAMFUNC uint32_t px_add_sat(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    uint32_t diff = 0;
+    for (; n >= 4; n -= 4, dst += 4, src += 4) {
+        uint32_t a = __UNALIGNED_UINT32_READ(dst);
+        uint32_t r = px_qadd8x4(a, __UNALIGNED_UINT32_READ(src));
+        __UNALIGNED_UINT32_WRITE(dst, r);
+        diff |= a ^ r;
+    }
+    for (; n; --n, ++dst, ++src) {
+        uint8_t r = qadd8(*dst, *src);
+        diff |= *dst ^ r;
+        *dst = r;
+    }
+    return diff;
+}
+
+LED_RAMFUNC uint32_t px_sub_sat(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    uint32_t diff = 0;
+    for (; n >= 4; n -= 4, dst += 4, src += 4) {
+        uint32_t a = __UNALIGNED_UINT32_READ(dst);
+        uint32_t r = px_qsub8x4(a, __UNALIGNED_UINT32_READ(src));
+        __UNALIGNED_UINT32_WRITE(dst, r);
+        diff |= a ^ r;
+    }
+    for (; n; --n, ++dst, ++src) {
+        uint8_t r = qsub8(*dst, *src);
+        diff |= *dst ^ r;
+        *dst = r;
+    }
+    return diff;
+}
+
+LED_RAMFUNC uint32_t px_scale(uint8_t *dst, size_t n, uint8_t factor_q8)
+{
+    uint32_t diff = 0;
+    for (; n >= 4; n -= 4, dst += 4) {
+        uint32_t a = __UNALIGNED_UINT32_READ(dst);
+        if (!a) continue;                          /* dark stays dark */
+        uint32_t r = scale8x4(a, factor_q8);
+        __UNALIGNED_UINT32_WRITE(dst, r);
+        diff |= a ^ r;
+    }
+    for (; n; --n, ++dst) {
+        uint8_t r = (uint8_t)((*dst * factor_q8) >> 8);
+        diff |= *dst ^ r;
+        *dst = r;
+    }
+    return diff;
+}
+
+/* one lookup per byte, still a word load / store per four: dark words are
+ * skipped like in px_scale, which is most of a trail frame */
+LED_RAMFUNC uint32_t px_lut(uint8_t *dst, size_t n, const uint8_t *lut)
+{
+    uint32_t diff = 0;
+    for (; n >= 4; n -= 4, dst += 4) {
+        uint32_t a = __UNALIGNED_UINT32_READ(dst);
+        if (!a) continue;
+        uint32_t r = (uint32_t)lut[a & 0xFF]
+                   | (uint32_t)lut[(a >> 8) & 0xFF] << 8
+                   | (uint32_t)lut[(a >> 16) & 0xFF] << 16
+                   | (uint32_t)lut[a >> 24] << 24;
+        __UNALIGNED_UINT32_WRITE(dst, r);
+        diff |= a ^ r;
+    }
+    for (; n; --n, ++dst) {
+        uint8_t r = lut[*dst];
+        diff |= *dst ^ r;
+        *dst = r;
+    }
+    return diff;
+}
+
+LED_RAMFUNC uint32_t px_lerp(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t n, uint16_t t)
+{
+    uint32_t diff = 0;
+    for (; n >= 4; n -= 4, dst += 4, a += 4, b += 4) {
+        uint32_t old = __UNALIGNED_UINT32_READ(dst);
+        uint32_t r   = lerp8x4(__UNALIGNED_UINT32_READ(a), __UNALIGNED_UINT32_READ(b), t);
+        __UNALIGNED_UINT32_WRITE(dst, r);
+        diff |= old ^ r;
+    }
+    for (; n; --n, ++dst, ++a, ++b) {
+        uint8_t r = (uint8_t)((*a * (256u - t) + *b * t) >> 8);
+        diff |= *dst ^ r;
+        *dst = r;
+    }
+    return diff;
+}
@@ -0,0 +1,72 @@
+/*
+ * pixel_simd.h – 4-bytes-at-a-time kernels for raw framebuffer bytes
+ *
+ * Cortex-M4 DSP extension (UQADD8 / UQSUB8) with a plain C fallback, the
+ * scale kernel uses two 16-bit lanes per multiply (SWAR). Channel order does
+ * not matter to any of them, so they work on rgb_8b arrays as bytes.
+ * Every kernel returns the OR of (old ^ new) words, != 0 if anything changed.
+ */
+
+#ifndef _PIXEL_SIMD_H_
+#define _PIXEL_SIMD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32f4xx.h"           /* CMSIS intrinsics */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * 4 lanes of saturating u8 add / sub. UQADD8 / UQSUB8 on the M4, SWAR in C
+ * everywhere else (host builds). With LED_PIXEL_32 one lane set is a pixel.
+ */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define px_qadd8x4(a, b)  __UQADD8((a), (b))
+#define px_qsub8x4(a, b)  __UQSUB8((a), (b))
+#else
+static inline uint32_t px_qadd8x4(uint32_t a, uint32_t b)
+{
+    uint32_t sum   = (a & 0x7F7F7F7Fu) + (b & 0x7F7F7F7Fu);
+    uint32_t carry = ((a & b) | ((a | b) & sum)) & 0x80808080u;   /* bit 7 carry out */
+    sum ^= (a ^ b) & 0x80808080u;
+    return sum | ((carry >> 7) * 0xFFu);
+}
+static inline uint32_t px_qsub8x4(uint32_t a, uint32_t b)
+{
+    /* a - b = ~(~a + b) with saturation flipped */
+    return ~px_qadd8x4(~a, b);
+}
+#endif
+
+/**
+ * dst[i] = sat(dst[i] + src[i])
+ */
+uint32_t px_add_sat(uint8_t *dst, const uint8_t *src, size_t n);
+
+/**
+ * dst[i] = sat(dst[i] - src[i])
+ */
+uint32_t px_sub_sat(uint8_t *dst, const uint8_t *src, size_t n);
+
+/**
+ * dst[i] = (dst[i] * factor_q8) >> 8
+ */
+uint32_t px_scale(uint8_t *dst, size_t n, uint8_t factor_q8);
+
+/**
+ * dst[i] = lut[dst[i]], lut[0] must be 0 (zero words are skipped)
+ */
+uint32_t px_lut(uint8_t *dst, size_t n, const uint8_t *lut);
+
+/**
+ * dst[i] = (a[i] * (256 - t) + b[i] * t) >> 8, t 0..256 (0 = a, 256 = b)
+ */
+uint32_t px_lerp(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t n, uint16_t t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PIXEL_SIMD_H_ */
@@ -0,0 +1,142 @@
+/* --------------------------------------------------------------------------
+ * profiler.c – named DWT cycle zones
+ * -------------------------------------------------------------------------- */
+#include "profiler.h"
+
+#ifdef LED_PROFILE
+
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#ifdef PROF_TEXT
+#include "dlog.h"        /* DLOG() */
+#endif
+#include "itm.h"         /* every zone end on ITM_PORT_PROF (LED_ITM) */
+#include "blackbox.h"    /* bb_zone: the zone times of each frame */
+
+#ifdef PROF_TEXT
+static const char *const zone_name[PROF_ZONE_COUNT] = {
+#define PROF_NAME(name, budget) #name,
+    PROF_ZONES(PROF_NAME)
+#undef PROF_NAME
+};
+#endif
+
+static const uint32_t zone_budget_us[PROF_ZONE_COUNT] = {
+#define PROF_BUDGET(name, budget) budget,
+    PROF_ZONES(PROF_BUDGET)
+#undef PROF_BUDGET
+};
+
+static ProfStats   zones[PROF_ZONE_COUNT];
+static ProfSummary last[PROF_ZONE_COUNT];
+static uint32_t    last_close = 0;
+
+static inline uint32_t cyc_per_us(void)
+{
+    return SystemCoreClock / 1000000U;
+}
+
+static void zone_reset(ProfStats *st)
+{
+    uint32_t open = st->start_cyc;          /* a zone may be open across the reset */
+    memset(st, 0, sizeof *st);
+    st->min_cyc   = UINT32_MAX;
+    st->start_cyc = open;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * 0…3 µs linear, then 4 steps per power of two
+ */
+static uint8_t bucket_of(uint32_t us)
+{
+    if (us < 4) return (uint8_t)us;
+    uint32_t msb = 31u - (uint32_t)__builtin_clz(us);
+    uint32_t b   = 4 * (msb - 1) + ((us >> (msb - 2)) & 3);
+    return (b < PROF_HIST_BUCKETS) ? (uint8_t)b : PROF_HIST_BUCKETS - 1;
+}
+
+static uint32_t bucket_top_us(uint8_t b)
+{
+    if (b < 4) return b;
+    uint32_t msb = b / 4 + 1;
+    return ((4u + (b & 3) + 1) << (msb - 2)) - 1;
+}
+
+void prof_begin(ProfZone z)
+{
+    zones[z].start_cyc = DWT->CYCCNT;
+}
+
+void prof_end(ProfZone z)
+{
+    ProfStats *st  = &zones[z];
+    uint32_t   cyc = DWT->CYCCNT - st->start_cyc;
+    uint32_t   us  = cyc / cyc_per_us();
+
+    if (st->calls == 0) st->min_cyc = UINT32_MAX;
+    st->calls++;
+    st->sum_cyc += cyc;
+    if (cyc < st->min_cyc) st->min_cyc = cyc;
+    if (cyc > st->max_cyc) st->max_cyc = cyc;
+    if (zone_budget_us[z] && us > zone_budget_us[z]) st->overruns++;
+
+    uint16_t *h = &st->hist[bucket_of(us)];
+    if (*h != UINT16_MAX) (*h)++;
+
+    itm_put32(ITM_PORT_PROF, (uint32_t)z << 24 | (cyc < 0xFFFFFFu ? cyc : 0xFFFFFFu));
+    bb_zone(z, us);
+}
+
+const ProfStats *prof_stats(ProfZone z)
+{
+    return &zones[z];
+}
+
+const ProfSummary *prof_last(ProfZone z)
+{
+    return &last[z];
+}
+
+uint32_t prof_p99_us(ProfZone z)
+{
+    const ProfStats *st = &zones[z];
+    uint32_t skip = st->calls / 100;        /* the slowest 1 % */
+    uint32_t seen = 0;
+    for (int b = PROF_HIST_BUCKETS - 1; b >= 0; --b) {
+        seen += st->hist[b];
+        if (seen > skip) return bucket_top_us((uint8_t)b);
+    }
+    return 0;
+}
+
+void prof_tick(void)
+{
+    uint32_t now = HAL_GetTick();
+    if ((now - last_close) < PROF_WINDOW_MS) return;
+    last_close = now;
+
+    const uint32_t cpu = cyc_per_us();
+    for (uint8_t z = 0; z < PROF_ZONE_COUNT; ++z) {
+        ProfStats   *st = &zones[z];
+        ProfSummary *s  = &last[z];
+        memset(s, 0, sizeof *s);
+        if (!st->calls) continue;
+
+        s->calls    = st->calls;
+        s->overruns = st->overruns;
+        s->min_us   = st->min_cyc / cpu;
+        s->avg_us   = (uint32_t)(st->sum_cyc / st->calls / cpu);
+        s->p99_us   = prof_p99_us((ProfZone)z);
+        s->max_us   = st->max_cyc / cpu;
+
+#ifdef PROF_TEXT
+        DLOG("#prof %s n=%lu min=%lu avg=%lu p99=%lu max=%lu over=%lu#",
+             zone_name[z], (unsigned long)s->calls, (unsigned long)s->min_us,
+             (unsigned long)s->avg_us, (unsigned long)s->p99_us,
+             (unsigned long)s->max_us, (unsigned long)s->overruns);
+#endif
+        zone_reset(st);
+    }
+}
+
+#endif /* LED_PROFILE */
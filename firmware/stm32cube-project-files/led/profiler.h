@@ -0,0 +1,113 @@
+/*
+ * profiler.h – named DWT cycle zones (LED_PROFILE)
+ *
+ *   PROF_BEGIN(ENCODE);
+ *   encode_frame(...);
+ *   PROF_END(ENCODE);
+ *
+ * Every zone keeps call count, min / avg / max, an approximate p99 and how
+ * often it ran over its budget. prof_tick() closes the window every
+ * PROF_WINDOW_MS; prof_last() has its numbers for the telemetry packet
+ * (telemetry.h), with PROF_TEXT they are printed as "#prof <zone> ...#"
+ * lines as well. Without LED_PROFILE everything compiles to nothing.
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "trace.h"               /* zones show up on the timeline too */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* zones: name, budget in µs (0 = none); the order is the one the telemetry
+ * packet has them in (keep app/telemetry.py in sync) */
+#define PROF_ZONES(X)          \
+    X(ANIM,      8000)         \
+    X(FADE,      2000)         \
+    X(ENCODE,    4000)         \
+    X(SUBMIT,    5000)         \
+    X(DMA_WAIT,     0)         \
+    X(USB,       1000)         \
+    X(SLEEP,        0)         \
+    X(AUDIO,     1000)
+
+typedef enum {
+#define PROF_ENUM(name, budget) PROF_##name,
+    PROF_ZONES(PROF_ENUM)
+#undef PROF_ENUM
+    PROF_ZONE_COUNT
+} ProfZone;
+
+#ifndef PROF_WINDOW_MS
+  #define PROF_WINDOW_MS          1000
+#endif
+
+#ifdef LED_PROFILE
+
+/* log2 buckets with 4 linear steps each, µs up to 2^20 */
+#define PROF_HIST_BUCKETS  80
+
+typedef struct {
+    uint32_t calls;
+    uint32_t overruns;     /* calls longer than the zone budget      */
+    uint32_t min_cyc;
+    uint32_t max_cyc;
+    uint64_t sum_cyc;
+    uint32_t start_cyc;    /* set by PROF_BEGIN, one open call per zone */
+    uint16_t hist[PROF_HIST_BUCKETS];
+} ProfStats;
+
+/* one closed window of a zone, in µs */
+typedef struct {
+    uint32_t calls;
+    uint32_t overruns;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} ProfSummary;
+
+#define PROF_BEGIN(zone)  do { TRACE_BEGIN(zone, 0); prof_begin(PROF_##zone); } while (0)
+#define PROF_END(zone)    do { prof_end(PROF_##zone); TRACE_END(zone, 0); } while (0)
+
+void prof_begin(ProfZone z);
+void prof_end(ProfZone z);
+
+/**
+ * Call once per main loop pass: closes the window when due.
+ */
+void prof_tick(void);
+
+/**
+ * Stats of the current window
+ */
+const ProfStats *prof_stats(ProfZone z);
+
+/**
+ * p99 of the current window in µs (upper edge of its bucket)
+ */
+uint32_t prof_p99_us(ProfZone z);
+
+/**
+ * The last closed window (all zero for a zone that did not run in it)
+ */
+const ProfSummary *prof_last(ProfZone z);
+
+#else
+
+#define PROF_BEGIN(zone)  TRACE_BEGIN(zone, 0)
+#define PROF_END(zone)    TRACE_END(zone, 0)
+#define prof_tick()       ((void)0)
+
+#endif /* LED_PROFILE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROFILER_H_ */
@@ -0,0 +1,707 @@
+/*
+ * proto.h – generated by tools/proto_gen.py from tools/protocol.def, do not
+ * edit: change protocol.def and rerun it (app/proto.py comes out with it)
+ *
+ * Packet types, the fixed payload layouts (PROTO_<NAME>_SIZE bytes on the
+ * wire, unaligned; a struct in memory, proto_<name>_decode / _encode in
+ * between) and the console's help text. Little endian, the wire's order.
+ */
+
+#ifndef _PROTO_H_
+#define _PROTO_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PKT_PING      = 0x01,   /* payload echoed */
+    PKT_PARAM     = 0x02,   /* payload: a led_params frame (0xA7 ...), its reply */
+    PKT_SCRIPT    = 0x03,   /* payload: a led_vm frame (0xA8 ...), its reply */
+    PKT_GYRO      = 0x04,   /* roll pitch yaw, float32 rad (x y z of #gyro#), no reply */
+    PKT_LOG       = 0x05,   /* device to host only: format id u32, arguments (dlog.h) */
+    PKT_TELEMETRY = 0x06,   /* device to host only: telemetry.h */
+    PKT_CONTROL   = 0x07,   /* DebugOps (led_debug.h), a batch; reply only if refused: bad op index */
+    PKT_ORIENT    = 0x08,   /* host µs u32, quaternion w x y z float32 (led_view.h), no reply */
+    PKT_SYNC      = 0x09,   /* host µs u32, frame u32, phase µs u32, period µs u32 (frame_sync.h), no reply */
+    PKT_PROBE     = 0x0A,   /* id u32, host µs u32; replied once a frame is out (latency.h) */
+    PKT_PIXELS    = 0x0B,   /* device to host only: framebuffer run (led_mirror.h) */
+    PKT_BENCH     = 0x0C,   /* device to host only: benchmark report (bench.h) */
+    PKT_PCSAMPLE  = 0x0D,   /* device to host only: sampled PCs (pc_sample.h) */
+    PKT_GEOMETRY  = 0x0E,   /* device to host only: model dump (geo_debug.h) */
+    PKT_AUDIO     = 0x0F,   /* band levels, beat count / phase / tempo from the host's analysis (audio.h), no reply */
+    PKT_CLIP      = 0x10,   /* clip upload into flash, op u8 first (clip.h); every step replied */
+    PKT_ERROR     = 0x7F,   /* reply only: request type, PktStatus */
+    PKT_REPLY     = 0x80,   /* or-ed into the type of an answer */
+} PktType;
+
+/* PKT_GYRO */
+#define PROTO_GYRO_SIZE  12u
+
+typedef struct {
+    float    xyz[3];        /* roll pitch yaw, rad */
+} ProtoGyro;
+
+static inline void proto_gyro_decode(const uint8_t *p, ProtoGyro *r)
+{
+    memcpy(r->xyz, p + 0, 12);
+}
+
+static inline uint8_t *proto_gyro_encode(uint8_t *p, const ProtoGyro *r)
+{
+    memcpy(p + 0, r->xyz, 12);
+    return p + PROTO_GYRO_SIZE;
+}
+
+/* one op of a PKT_CONTROL batch (led_debug.h) */
+#define PROTO_CONTROL_OP_SIZE  5u
+
+typedef struct {
+    uint8_t  op;            /* DebugOp, | DBG_OP_DELTA for a step */
+    float    value;
+} ProtoControlOp;
+
+static inline void proto_control_op_decode(const uint8_t *p, ProtoControlOp *r)
+{
+    memcpy(&r->op, p + 0, 1);
+    memcpy(&r->value, p + 1, 4);
+}
+
+static inline uint8_t *proto_control_op_encode(uint8_t *p, const ProtoControlOp *r)
+{
+    memcpy(p + 0, &r->op, 1);
+    memcpy(p + 1, &r->value, 4);
+    return p + PROTO_CONTROL_OP_SIZE;
+}
+
+/* PKT_ORIENT */
+#define PROTO_ORIENT_SIZE  20u
+
+typedef struct {
+    uint32_t host_us;
+    float    q[4];          /* w x y z */
+} ProtoOrient;
+
+static inline void proto_orient_decode(const uint8_t *p, ProtoOrient *r)
+{
+    memcpy(&r->host_us, p + 0, 4);
+    memcpy(r->q, p + 4, 16);
+}
+
+static inline uint8_t *proto_orient_encode(uint8_t *p, const ProtoOrient *r)
+{
+    memcpy(p + 0, &r->host_us, 4);
+    memcpy(p + 4, r->q, 16);
+    return p + PROTO_ORIENT_SIZE;
+}
+
+/* PKT_SYNC */
+#define PROTO_SYNC_SIZE  16u
+
+typedef struct {
+    uint32_t host_us;
+    uint32_t frame;
+    uint32_t phase_us;
+    uint32_t period_us;
+} ProtoSync;
+
+static inline void proto_sync_decode(const uint8_t *p, ProtoSync *r)
+{
+    memcpy(&r->host_us, p + 0, 4);
+    memcpy(&r->frame, p + 4, 4);
+    memcpy(&r->phase_us, p + 8, 4);
+    memcpy(&r->period_us, p + 12, 4);
+}
+
+static inline uint8_t *proto_sync_encode(uint8_t *p, const ProtoSync *r)
+{
+    memcpy(p + 0, &r->host_us, 4);
+    memcpy(p + 4, &r->frame, 4);
+    memcpy(p + 8, &r->phase_us, 4);
+    memcpy(p + 12, &r->period_us, 4);
+    return p + PROTO_SYNC_SIZE;
+}
+
+/* PKT_PROBE */
+#define PROTO_PROBE_SIZE  8u
+
+typedef struct {
+    uint32_t id;
+    uint32_t host_us;
+} ProtoProbe;
+
+static inline void proto_probe_decode(const uint8_t *p, ProtoProbe *r)
+{
+    memcpy(&r->id, p + 0, 4);
+    memcpy(&r->host_us, p + 4, 4);
+}
+
+static inline uint8_t *proto_probe_encode(uint8_t *p, const ProtoProbe *r)
+{
+    memcpy(p + 0, &r->id, 4);
+    memcpy(p + 4, &r->host_us, 4);
+    return p + PROTO_PROBE_SIZE;
+}
+
+/* PKT_AUDIO */
+#define PROTO_AUDIO_FEAT_SIZE  16u
+
+typedef struct {
+    uint8_t  band[8];       /* 0 … 255, low to high, spread over AUDIO_BANDS */
+    uint8_t  level;
+    uint8_t  flux;          /* dB the bands rose, saturated */
+    uint16_t beats;         /* since the host started: a change is an onset */
+    uint16_t beat_phase;    /* 0 … 65535 through the current beat */
+    uint16_t bpm_x10;       /* 0: no tempo */
+} ProtoAudioFeat;
+
+static inline void proto_audio_feat_decode(const uint8_t *p, ProtoAudioFeat *r)
+{
+    memcpy(r->band, p + 0, 8);
+    memcpy(&r->level, p + 8, 1);
+    memcpy(&r->flux, p + 9, 1);
+    memcpy(&r->beats, p + 10, 2);
+    memcpy(&r->beat_phase, p + 12, 2);
+    memcpy(&r->bpm_x10, p + 14, 2);
+}
+
+static inline uint8_t *proto_audio_feat_encode(uint8_t *p, const ProtoAudioFeat *r)
+{
+    memcpy(p + 0, r->band, 8);
+    memcpy(p + 8, &r->level, 1);
+    memcpy(p + 9, &r->flux, 1);
+    memcpy(p + 10, &r->beats, 2);
+    memcpy(p + 12, &r->beat_phase, 2);
+    memcpy(p + 14, &r->bpm_x10, 2);
+    return p + PROTO_AUDIO_FEAT_SIZE;
+}
+
+/* PKT_CLIP, CLIP_OP_BEGIN: erases the partition */
+#define PROTO_CLIP_BEGIN_SIZE  5u
+
+typedef struct {
+    uint8_t  op;
+    uint32_t size;          /* image bytes, whole words */
+} ProtoClipBegin;
+
+static inline void proto_clip_begin_decode(const uint8_t *p, ProtoClipBegin *r)
+{
+    memcpy(&r->op, p + 0, 1);
+    memcpy(&r->size, p + 1, 4);
+}
+
+static inline uint8_t *proto_clip_begin_encode(uint8_t *p, const ProtoClipBegin *r)
+{
+    memcpy(p + 0, &r->op, 1);
+    memcpy(p + 1, &r->size, 4);
+    return p + PROTO_CLIP_BEGIN_SIZE;
+}
+
+/* PKT_CLIP, CLIP_OP_DATA, then the bytes (whole words) */
+#define PROTO_CLIP_DATA_SIZE  5u
+
+typedef struct {
+    uint8_t  op;
+    uint32_t offset;        /* into the image, where the last one ended */
+} ProtoClipData;
+
+static inline void proto_clip_data_decode(const uint8_t *p, ProtoClipData *r)
+{
+    memcpy(&r->op, p + 0, 1);
+    memcpy(&r->offset, p + 1, 4);
+}
+
+static inline uint8_t *proto_clip_data_encode(uint8_t *p, const ProtoClipData *r)
+{
+    memcpy(p + 0, &r->op, 1);
+    memcpy(p + 1, &r->offset, 4);
+    return p + PROTO_CLIP_DATA_SIZE;
+}
+
+/* PKT_CLIP, CLIP_OP_END: checks and closes the upload */
+#define PROTO_CLIP_END_SIZE  5u
+
+typedef struct {
+    uint8_t  op;
+    uint32_t crc;           /* CRC unit's over the image */
+} ProtoClipEnd;
+
+static inline void proto_clip_end_decode(const uint8_t *p, ProtoClipEnd *r)
+{
+    memcpy(&r->op, p + 0, 1);
+    memcpy(&r->crc, p + 1, 4);
+}
+
+static inline uint8_t *proto_clip_end_encode(uint8_t *p, const ProtoClipEnd *r)
+{
+    memcpy(p + 0, &r->op, 1);
+    memcpy(p + 1, &r->crc, 4);
+    return p + PROTO_CLIP_END_SIZE;
+}
+
+/* PKT_CLIP | PKT_REPLY */
+#define PROTO_CLIP_REPLY_SIZE  6u
+
+typedef struct {
+    uint8_t  op;
+    uint8_t  status;        /* ClipStatus (clip.h) */
+    uint32_t value;         /* begin: room, data: bytes in, end: the CRC found */
+} ProtoClipReply;
+
+static inline void proto_clip_reply_decode(const uint8_t *p, ProtoClipReply *r)
+{
+    memcpy(&r->op, p + 0, 1);
+    memcpy(&r->status, p + 1, 1);
+    memcpy(&r->value, p + 2, 4);
+}
+
+static inline uint8_t *proto_clip_reply_encode(uint8_t *p, const ProtoClipReply *r)
+{
+    memcpy(p + 0, &r->op, 1);
+    memcpy(p + 1, &r->status, 1);
+    memcpy(p + 2, &r->value, 4);
+    return p + PROTO_CLIP_REPLY_SIZE;
+}
+
+/* PKT_PROBE | PKT_REPLY, µs after the arrival but the echoed two */
+#define PROTO_PROBE_REPLY_SIZE  24u
+
+typedef struct {
+    uint32_t id;
+    uint32_t host_us;
+    uint32_t handled_us;
+    uint32_t render_us;
+    uint32_t shown_us;      /* LATENCY_NONE: no frame went out in time */
+    uint32_t reply_us;
+} ProtoProbeReply;
+
+static inline void proto_probe_reply_decode(const uint8_t *p, ProtoProbeReply *r)
+{
+    memcpy(&r->id, p + 0, 4);
+    memcpy(&r->host_us, p + 4, 4);
+    memcpy(&r->handled_us, p + 8, 4);
+    memcpy(&r->render_us, p + 12, 4);
+    memcpy(&r->shown_us, p + 16, 4);
+    memcpy(&r->reply_us, p + 20, 4);
+}
+
+static inline uint8_t *proto_probe_reply_encode(uint8_t *p, const ProtoProbeReply *r)
+{
+    memcpy(p + 0, &r->id, 4);
+    memcpy(p + 4, &r->host_us, 4);
+    memcpy(p + 8, &r->handled_us, 4);
+    memcpy(p + 12, &r->render_us, 4);
+    memcpy(p + 16, &r->shown_us, 4);
+    memcpy(p + 20, &r->reply_us, 4);
+    return p + PROTO_PROBE_REPLY_SIZE;
+}
+
+/* PKT_TELEMETRY, then zones × TelemZone, tasks u8, TelemTask, buses u8, TelemBus, supply u8, TelemSupply */
+#define PROTO_TELEM_HEAD_SIZE  46u
+
+typedef struct {
+    uint8_t  version;       /* TELEM_VERSION */
+    uint8_t  zones;
+    uint16_t window_ms;
+    uint32_t uptime_ms;
+    uint16_t fps_x100;
+    uint32_t frames_late;
+    uint32_t frames_missed;
+    uint32_t tx_dropped_text;
+    uint32_t tx_dropped_packet;
+    uint32_t rx_overrun;
+    uint32_t dma_errors;
+    uint32_t heap_peak;
+    uint32_t heap_left;
+    uint16_t stack_peak;
+    uint16_t irq_stack_peak;
+} ProtoTelemHead;
+
+static inline void proto_telem_head_decode(const uint8_t *p, ProtoTelemHead *r)
+{
+    memcpy(&r->version, p + 0, 1);
+    memcpy(&r->zones, p + 1, 1);
+    memcpy(&r->window_ms, p + 2, 2);
+    memcpy(&r->uptime_ms, p + 4, 4);
+    memcpy(&r->fps_x100, p + 8, 2);
+    memcpy(&r->frames_late, p + 10, 4);
+    memcpy(&r->frames_missed, p + 14, 4);
+    memcpy(&r->tx_dropped_text, p + 18, 4);
+    memcpy(&r->tx_dropped_packet, p + 22, 4);
+    memcpy(&r->rx_overrun, p + 26, 4);
+    memcpy(&r->dma_errors, p + 30, 4);
+    memcpy(&r->heap_peak, p + 34, 4);
+    memcpy(&r->heap_left, p + 38, 4);
+    memcpy(&r->stack_peak, p + 42, 2);
+    memcpy(&r->irq_stack_peak, p + 44, 2);
+}
+
+static inline uint8_t *proto_telem_head_encode(uint8_t *p, const ProtoTelemHead *r)
+{
+    memcpy(p + 0, &r->version, 1);
+    memcpy(p + 1, &r->zones, 1);
+    memcpy(p + 2, &r->window_ms, 2);
+    memcpy(p + 4, &r->uptime_ms, 4);
+    memcpy(p + 8, &r->fps_x100, 2);
+    memcpy(p + 10, &r->frames_late, 4);
+    memcpy(p + 14, &r->frames_missed, 4);
+    memcpy(p + 18, &r->tx_dropped_text, 4);
+    memcpy(p + 22, &r->tx_dropped_packet, 4);
+    memcpy(p + 26, &r->rx_overrun, 4);
+    memcpy(p + 30, &r->dma_errors, 4);
+    memcpy(p + 34, &r->heap_peak, 4);
+    memcpy(p + 38, &r->heap_left, 4);
+    memcpy(p + 42, &r->stack_peak, 2);
+    memcpy(p + 44, &r->irq_stack_peak, 2);
+    return p + PROTO_TELEM_HEAD_SIZE;
+}
+
+/* profiler window of one zone, µs saturated at 65535 */
+#define PROTO_TELEM_ZONE_SIZE  12u
+
+typedef struct {
+    uint16_t calls;
+    uint16_t overruns;
+    uint16_t min_us;
+    uint16_t avg_us;
+    uint16_t p99_us;
+    uint16_t max_us;
+} ProtoTelemZone;
+
+static inline void proto_telem_zone_decode(const uint8_t *p, ProtoTelemZone *r)
+{
+    memcpy(&r->calls, p + 0, 2);
+    memcpy(&r->overruns, p + 2, 2);
+    memcpy(&r->min_us, p + 4, 2);
+    memcpy(&r->avg_us, p + 6, 2);
+    memcpy(&r->p99_us, p + 8, 2);
+    memcpy(&r->max_us, p + 10, 2);
+}
+
+static inline uint8_t *proto_telem_zone_encode(uint8_t *p, const ProtoTelemZone *r)
+{
+    memcpy(p + 0, &r->calls, 2);
+    memcpy(p + 2, &r->overruns, 2);
+    memcpy(p + 4, &r->min_us, 2);
+    memcpy(p + 6, &r->avg_us, 2);
+    memcpy(p + 8, &r->p99_us, 2);
+    memcpy(p + 10, &r->max_us, 2);
+    return p + PROTO_TELEM_ZONE_SIZE;
+}
+
+/* one RTOS task */
+#define PROTO_TELEM_TASK_SIZE  4u
+
+typedef struct {
+    uint16_t cpu_permille;
+    uint16_t stack_free;
+} ProtoTelemTask;
+
+static inline void proto_telem_task_decode(const uint8_t *p, ProtoTelemTask *r)
+{
+    memcpy(&r->cpu_permille, p + 0, 2);
+    memcpy(&r->stack_free, p + 2, 2);
+}
+
+static inline uint8_t *proto_telem_task_encode(uint8_t *p, const ProtoTelemTask *r)
+{
+    memcpy(p + 0, &r->cpu_permille, 2);
+    memcpy(p + 2, &r->stack_free, 2);
+    return p + PROTO_TELEM_TASK_SIZE;
+}
+
+/* one output strip */
+#define PROTO_TELEM_BUS_SIZE  10u
+
+typedef struct {
+    uint32_t transfers;
+    uint16_t errors;
+    uint16_t timeouts;
+    uint16_t max_us;
+} ProtoTelemBus;
+
+static inline void proto_telem_bus_decode(const uint8_t *p, ProtoTelemBus *r)
+{
+    memcpy(&r->transfers, p + 0, 4);
+    memcpy(&r->errors, p + 4, 2);
+    memcpy(&r->timeouts, p + 6, 2);
+    memcpy(&r->max_us, p + 8, 2);
+}
+
+static inline uint8_t *proto_telem_bus_encode(uint8_t *p, const ProtoTelemBus *r)
+{
+    memcpy(p + 0, &r->transfers, 4);
+    memcpy(p + 4, &r->errors, 2);
+    memcpy(p + 6, &r->timeouts, 2);
+    memcpy(p + 8, &r->max_us, 2);
+    return p + PROTO_TELEM_BUS_SIZE;
+}
+
+/* supply monitor readings (LED_SUPPLY_MON), 0 or 1 of them */
+#define PROTO_TELEM_SUPPLY_SIZE  14u
+
+typedef struct {
+    uint16_t mv;            /* supply, filtered */
+    uint16_t ma;            /* LED current, filtered */
+    uint16_t model_ma;      /* the limiter's estimate */
+    uint16_t gain_q8;       /* measured / modelled, 256 = 1 */
+    uint16_t budget_ma;
+    uint16_t min_mv;        /* lowest since boot */
+    uint16_t sags;          /* ticks under SUPPLY_V_MIN_MV, saturated */
+} ProtoTelemSupply;
+
+static inline void proto_telem_supply_decode(const uint8_t *p, ProtoTelemSupply *r)
+{
+    memcpy(&r->mv, p + 0, 2);
+    memcpy(&r->ma, p + 2, 2);
+    memcpy(&r->model_ma, p + 4, 2);
+    memcpy(&r->gain_q8, p + 6, 2);
+    memcpy(&r->budget_ma, p + 8, 2);
+    memcpy(&r->min_mv, p + 10, 2);
+    memcpy(&r->sags, p + 12, 2);
+}
+
+static inline uint8_t *proto_telem_supply_encode(uint8_t *p, const ProtoTelemSupply *r)
+{
+    memcpy(p + 0, &r->mv, 2);
+    memcpy(p + 2, &r->ma, 2);
+    memcpy(p + 4, &r->model_ma, 2);
+    memcpy(p + 6, &r->gain_q8, 2);
+    memcpy(p + 8, &r->budget_ma, 2);
+    memcpy(p + 10, &r->min_mv, 2);
+    memcpy(p + 12, &r->sags, 2);
+    return p + PROTO_TELEM_SUPPLY_SIZE;
+}
+
+/* PKT_PIXELS, then 3 bytes per LED */
+#define PROTO_PIXELS_HEAD_SIZE  5u
+
+typedef struct {
+    uint16_t frame;
+    uint16_t first;
+    uint8_t  brightness;
+} ProtoPixelsHead;
+
+static inline void proto_pixels_head_decode(const uint8_t *p, ProtoPixelsHead *r)
+{
+    memcpy(&r->frame, p + 0, 2);
+    memcpy(&r->first, p + 2, 2);
+    memcpy(&r->brightness, p + 4, 1);
+}
+
+static inline uint8_t *proto_pixels_head_encode(uint8_t *p, const ProtoPixelsHead *r)
+{
+    memcpy(p + 0, &r->frame, 2);
+    memcpy(p + 2, &r->first, 2);
+    memcpy(p + 4, &r->brightness, 1);
+    return p + PROTO_PIXELS_HEAD_SIZE;
+}
+
+/* PKT_PCSAMPLE, then u32 PCs */
+#define PROTO_PC_SAMPLE_HEAD_SIZE  4u
+
+typedef struct {
+    uint16_t hz;
+    uint16_t dropped;
+} ProtoPcSampleHead;
+
+static inline void proto_pc_sample_head_decode(const uint8_t *p, ProtoPcSampleHead *r)
+{
+    memcpy(&r->hz, p + 0, 2);
+    memcpy(&r->dropped, p + 2, 2);
+}
+
+static inline uint8_t *proto_pc_sample_head_encode(uint8_t *p, const ProtoPcSampleHead *r)
+{
+    memcpy(p + 0, &r->hz, 2);
+    memcpy(p + 2, &r->dropped, 2);
+    return p + PROTO_PC_SAMPLE_HEAD_SIZE;
+}
+
+/* PKT_GEOMETRY, then records of the section */
+#define PROTO_GEO_PKT_SIZE  4u
+
+typedef struct {
+    uint8_t  section;       /* GEO_SEC_* */
+    uint8_t  dump;
+    uint16_t first;
+} ProtoGeoPkt;
+
+static inline void proto_geo_pkt_decode(const uint8_t *p, ProtoGeoPkt *r)
+{
+    memcpy(&r->section, p + 0, 1);
+    memcpy(&r->dump, p + 1, 1);
+    memcpy(&r->first, p + 2, 2);
+}
+
+static inline uint8_t *proto_geo_pkt_encode(uint8_t *p, const ProtoGeoPkt *r)
+{
+    memcpy(p + 0, &r->section, 1);
+    memcpy(p + 1, &r->dump, 1);
+    memcpy(p + 2, &r->first, 2);
+    return p + PROTO_GEO_PKT_SIZE;
+}
+
+/* GEO_SEC_HEAD */
+#define PROTO_GEO_COUNTS_SIZE  8u
+
+typedef struct {
+    uint16_t verts;
+    uint16_t edges;
+    uint16_t faces;
+    uint16_t leds;          /* mapped edges, 0 without the mapping */
+} ProtoGeoCounts;
+
+static inline void proto_geo_counts_decode(const uint8_t *p, ProtoGeoCounts *r)
+{
+    memcpy(&r->verts, p + 0, 2);
+    memcpy(&r->edges, p + 2, 2);
+    memcpy(&r->faces, p + 4, 2);
+    memcpy(&r->leds, p + 6, 2);
+}
+
+static inline uint8_t *proto_geo_counts_encode(uint8_t *p, const ProtoGeoCounts *r)
+{
+    memcpy(p + 0, &r->verts, 2);
+    memcpy(p + 2, &r->edges, 2);
+    memcpy(p + 4, &r->faces, 2);
+    memcpy(p + 6, &r->leds, 2);
+    return p + PROTO_GEO_COUNTS_SIZE;
+}
+
+/* GEO_SEC_VERTS */
+#define PROTO_GEO_VERT_SIZE  13u
+
+typedef struct {
+    float    xyz[3];
+    uint8_t  hue;
+} ProtoGeoVert;
+
+static inline void proto_geo_vert_decode(const uint8_t *p, ProtoGeoVert *r)
+{
+    memcpy(r->xyz, p + 0, 12);
+    memcpy(&r->hue, p + 12, 1);
+}
+
+static inline uint8_t *proto_geo_vert_encode(uint8_t *p, const ProtoGeoVert *r)
+{
+    memcpy(p + 0, r->xyz, 12);
+    memcpy(p + 12, &r->hue, 1);
+    return p + PROTO_GEO_VERT_SIZE;
+}
+
+/* GEO_SEC_EDGES */
+#define PROTO_GEO_EDGE_SIZE  4u
+
+typedef struct {
+    uint16_t a;
+    uint16_t b;
+} ProtoGeoEdge;
+
+static inline void proto_geo_edge_decode(const uint8_t *p, ProtoGeoEdge *r)
+{
+    memcpy(&r->a, p + 0, 2);
+    memcpy(&r->b, p + 2, 2);
+}
+
+static inline uint8_t *proto_geo_edge_encode(uint8_t *p, const ProtoGeoEdge *r)
+{
+    memcpy(p + 0, &r->a, 2);
+    memcpy(p + 2, &r->b, 2);
+    return p + PROTO_GEO_EDGE_SIZE;
+}
+
+/* GEO_SEC_LEDS */
+#define PROTO_GEO_LED_SIZE  5u
+
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+    int8_t   step;
+} ProtoGeoLed;
+
+static inline void proto_geo_led_decode(const uint8_t *p, ProtoGeoLed *r)
+{
+    memcpy(&r->start, p + 0, 2);
+    memcpy(&r->count, p + 2, 2);
+    memcpy(&r->step, p + 4, 1);
+}
+
+static inline uint8_t *proto_geo_led_encode(uint8_t *p, const ProtoGeoLed *r)
+{
+    memcpy(p + 0, &r->start, 2);
+    memcpy(p + 2, &r->count, 2);
+    memcpy(p + 4, &r->step, 1);
+    return p + PROTO_GEO_LED_SIZE;
+}
+
+/* GEO_SEC_END */
+#define PROTO_GEO_END_SIZE  8u
+
+typedef struct {
+    uint32_t crc;           /* CRC-32/MPEG-2 over the records before */
+    uint32_t bytes;
+} ProtoGeoEnd;
+
+static inline void proto_geo_end_decode(const uint8_t *p, ProtoGeoEnd *r)
+{
+    memcpy(&r->crc, p + 0, 4);
+    memcpy(&r->bytes, p + 4, 4);
+}
+
+static inline uint8_t *proto_geo_end_encode(uint8_t *p, const ProtoGeoEnd *r)
+{
+    memcpy(p + 0, &r->crc, 4);
+    memcpy(p + 4, &r->bytes, 4);
+    return p + PROTO_GEO_END_SIZE;
+}
+
+#define PROTO_HELP  "Valid cmds:\n" \
+    " f b e m h [++|--|<float>|=<n>]\n" \
+    " r [=0|1] (flip)\n" \
+    " save\n" \
+    " forget\n" \
+    " scene <solid>\n" \
+    " palette <name>\n" \
+    " layer <n> <anim>|off [add|max|alpha|mul] [alpha]\n" \
+    " highlight [v]\n" \
+    " seed [n]\n" \
+    " quality [auto|0-3]\n" \
+    " clock [auto|0-2]\n" \
+    " supply\n" \
+    " hud [on|off]\n" \
+    " param [<name> <value>]\n" \
+    " preset save|load <n>\n" \
+    " script [save|load]\n" \
+    " stream (host frames, any text ends it)\n" \
+    " tx [text|packet block|drop|priority]\n" \
+    " telem [ms|0]\n" \
+    " mirror [fps|0]\n" \
+    " sync\n" \
+    " link\n" \
+    " bench [frames|stop]\n" \
+    " bench encode [iterations]\n" \
+    " bench wire [frames]\n" \
+    " boot\n" \
+    " mem\n" \
+    " stack\n" \
+    " sched\n" \
+    " trace\n" \
+    " pcs [hz|0]\n" \
+    " irq [on|off]\n" \
+    " bb [us|dump|arm]\n" \
+    " rec [start|stop|play|dump]\n" \
+    " calib [ms|stop|set <e> <block> <flip>|apply]\n" \
+    " cal [<strip> <r|g|b|w> <gain> <gamma>]\n" \
+    " audio\n" \
+    " clip [play|loop|stop]\n" \
+    " help\n"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROTO_H_ */
@@ -0,0 +1,237 @@
+/* --------------------------------------------------------------------------
+ * render_bench.c – encoder variants and strip wire times, timed with DWT
+ * -------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <string.h>
+#include "render_bench.h"
+#include "led_render.h"      /* render_encode_leds, StripInfo, frame shown */
+#include "lut.h"             /* lut_ws_bits */
+#include "usb_device.h"      /* USBD_UsrLog */
+#include "stm32f4xx_hal.h"   /* DWT, __disable_irq */
+
+#define BENCH_RAM       __attribute__((section(".RamFunc"), noinline))
+#define BENCH_FLASH     __attribute__((noinline))
+#define WIRE_STRIPS     8           /* strips sampled, the rest ignored */
+
+typedef void (*EncodeFn)(uint8_t *dst, const rgb_8b *src, uint16_t n);
+
+/* what the variants read, set up by render_bench_encode() */
+static uint32_t       *tbl;         /* lut_ws_bits copied to RAM */
+static uint16_t        nib[16];     /* nibble → 12 SPI bits */
+static const uint16_t *order;       /* gather's walk */
+
+#define PUT24(p, bits)  do { (p)[0] = (uint8_t)((bits) >> 16); \
+                             (p)[1] = (uint8_t)((bits) >>  8); \
+                             (p)[2] = (uint8_t) (bits);        } while (0)
+
+/* ── the variants ─────────────────────────────────────────────────────── */
+static void enc_render(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+#ifndef LED_OUTPUT_GPIO
+    render_encode_leds(dst, src, n);
+#else
+    (void)dst; (void)src; (void)n;
+#endif
+}
+
+BENCH_FLASH static void enc_tbl24(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        PUT24(dst + 0, tbl[src[i].r]);
+        PUT24(dst + 3, tbl[src[i].g]);
+        PUT24(dst + 6, tbl[src[i].b]);
+    }
+}
+
+BENCH_RAM static void enc_tbl24_ram(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        PUT24(dst + 0, tbl[src[i].r]);
+        PUT24(dst + 3, tbl[src[i].g]);
+        PUT24(dst + 6, tbl[src[i].b]);
+    }
+}
+
+BENCH_FLASH static void enc_tbl24_rom(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        PUT24(dst + 0, lut_ws_bits[src[i].r]);
+        PUT24(dst + 3, lut_ws_bits[src[i].g]);
+        PUT24(dst + 6, lut_ws_bits[src[i].b]);
+    }
+}
+
+/* 72 bits as two (unaligned) words and a byte: big endian on the wire */
+BENCH_FLASH static void enc_words(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        uint32_t a = tbl[src[i].r], b = tbl[src[i].g], c = tbl[src[i].b];
+        uint32_t w0 = __builtin_bswap32((a << 8) | (b >> 16));
+        uint32_t w1 = __builtin_bswap32((b << 16) | (c >> 8));
+        memcpy(dst, &w0, 4);
+        memcpy(dst + 4, &w1, 4);
+        dst[8] = (uint8_t)c;
+    }
+}
+
+BENCH_FLASH static void enc_nibble(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        const uint8_t v[3] = { src[i].r, src[i].g, src[i].b };
+        for (uint8_t k = 0; k < 3; ++k) {
+            uint32_t bits = (uint32_t)nib[v[k] >> 4] << 12 | nib[v[k] & 15];
+            PUT24(dst + 3 * k, bits);
+        }
+    }
+}
+
+BENCH_FLASH static void enc_bits(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        const uint8_t v[3] = { src[i].r, src[i].g, src[i].b };
+        for (uint8_t k = 0; k < 3; ++k) {
+            uint32_t bits = 0;
+            for (int8_t b = 7; b >= 0; --b) bits = bits << 3 | ((v[k] >> b) & 1 ? 6u : 4u);
+            PUT24(dst + 3 * k, bits);
+        }
+    }
+}
+
+BENCH_FLASH static void enc_gather(uint8_t *dst, const rgb_8b *src, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; ++i, dst += 9) {
+        rgb_8b c = src[order[i]];
+        PUT24(dst + 0, tbl[c.r]);
+        PUT24(dst + 3, tbl[c.g]);
+        PUT24(dst + 6, tbl[c.b]);
+    }
+}
+
+static const struct {
+    const char *name;
+    EncodeFn    fn;
+} variants[] = {
+#ifndef LED_OUTPUT_GPIO
+    { "render",    enc_render    },
+#endif
+    { "tbl24",     enc_tbl24     },
+    { "tbl24-ram", enc_tbl24_ram },
+    { "tbl24-rom", enc_tbl24_rom },
+    { "words",     enc_words     },
+    { "nibble",    enc_nibble    },
+    { "bits",      enc_bits      },
+    { "gather",    enc_gather    },
+};
+
+/* cycles per LED ×10, minimum and average over the iterations */
+static void time_fn(EncodeFn fn, uint8_t *dst, const rgb_8b *src, uint16_t iters,
+                    bool irq_off, uint32_t *min_x10, uint32_t *avg_x10)
+{
+    uint32_t min = UINT32_MAX;
+    uint64_t sum = 0;
+    fn(dst, src, RENDER_BENCH_LEDS);            /* caches, flash prefetch warm */
+    for (uint16_t k = 0; k < iters; ++k) {
+        if (irq_off) __disable_irq();
+        uint32_t c0 = DWT->CYCCNT;
+        fn(dst, src, RENDER_BENCH_LEDS);
+        uint32_t c = DWT->CYCCNT - c0;
+        if (irq_off) __enable_irq();
+        if (c < min) min = c;
+        sum += c;
+    }
+    *min_x10 = (uint32_t)((uint64_t)min * 10u / RENDER_BENCH_LEDS);
+    *avg_x10 = (uint32_t)(sum * 10u / ((uint64_t)iters * RENDER_BENCH_LEDS));
+}
+
+bool render_bench_encode(uint16_t iterations)
+{
+    if (!iterations) iterations = RENDER_BENCH_ITERS;
+    rgb_8b   *src = malloc(RENDER_BENCH_LEDS * sizeof *src);
+    uint8_t  *dst = malloc(RENDER_BENCH_LEDS * 20u);   /* render: up to 20 (LED_WS_SPI_BITS 5, RGBW) */
+    uint16_t *idx = malloc(RENDER_BENCH_LEDS * sizeof *idx);
+    tbl = malloc(256 * sizeof *tbl);
+    if (!src || !dst || !idx || !tbl) {
+        free(src); free(dst); free(idx); free(tbl);
+        tbl = NULL;
+        return false;
+    }
+
+    uint32_t x = 0x2545F491u;                   /* same pattern every run */
+    for (uint16_t i = 0; i < RENDER_BENCH_LEDS; ++i) {
+        x = x * 1664525u + 1013904223u;
+        src[i] = (rgb_8b){ (uint8_t)(x >> 24), (uint8_t)(x >> 16), (uint8_t)(x >> 8) };
+    }
+    /* edges of 12 LEDs, every other one wired backwards */
+    for (uint16_t i = 0; i < RENDER_BENCH_LEDS; ++i) {
+        uint16_t e = i / 12u, k = i % 12u;
+        uint16_t j = (e & 1u) ? e * 12u + 11u - k : i;
+        idx[i] = j < RENDER_BENCH_LEDS ? j : i;
+    }
+    order = idx;
+    memcpy(tbl, lut_ws_bits, 256 * sizeof *tbl);
+    for (uint8_t v = 0; v < 16; ++v) nib[v] = (uint16_t)(lut_ws_bits[v] & 0xFFFu);
+
+    USBD_UsrLog("bench encode: %u LEDs x %u, cycles per LED min / avg, irq off | on\n",
+                RENDER_BENCH_LEDS, iterations);
+    for (uint8_t i = 0; i < sizeof variants / sizeof variants[0]; ++i) {
+        uint32_t off_min, off_avg, on_min, on_avg;
+        time_fn(variants[i].fn, dst, src, iterations, true,  &off_min, &off_avg);
+        time_fn(variants[i].fn, dst, src, iterations, false, &on_min,  &on_avg);
+        USBD_UsrLog("  %-10s %4lu.%lu %4lu.%lu | %4lu.%lu %4lu.%lu\n", variants[i].name,
+                    (unsigned long)(off_min / 10), (unsigned long)(off_min % 10),
+                    (unsigned long)(off_avg / 10), (unsigned long)(off_avg % 10),
+                    (unsigned long)(on_min / 10),  (unsigned long)(on_min % 10),
+                    (unsigned long)(on_avg / 10),  (unsigned long)(on_avg % 10));
+    }
+
+    free(src); free(dst); free(idx); free(tbl);
+    tbl   = NULL;
+    order = NULL;
+    return true;
+}
+
+/* ── wire times ───────────────────────────────────────────────────────── */
+static struct {
+    uint16_t want;              /* frames still to sample, 0 = idle */
+    uint16_t got;
+    uint32_t seq;
+    uint32_t min[WIRE_STRIPS];
+    uint32_t max[WIRE_STRIPS];
+    uint64_t sum[WIRE_STRIPS];
+} wire;
+
+void render_bench_wire(uint16_t frames)
+{
+    memset(&wire, 0, sizeof wire);
+    for (uint8_t s = 0; s < WIRE_STRIPS; ++s) wire.min[s] = UINT32_MAX;
+    wire.seq  = render_frame_shown(NULL);
+    wire.want = frames ? frames : RENDER_BENCH_FRAMES;
+}
+
+void render_bench_tick(void)
+{
+    if (!wire.want) return;
+    uint32_t seq = render_frame_shown(NULL);
+    if (seq == wire.seq) return;
+    wire.seq = seq;
+
+    uint8_t n = render_strip_count();
+    if (n > WIRE_STRIPS) n = WIRE_STRIPS;
+    for (uint8_t s = 0; s < n; ++s) {
+        uint32_t us = render_strip_info(s)->last_us;
+        if (us < wire.min[s]) wire.min[s] = us;
+        if (us > wire.max[s]) wire.max[s] = us;
+        wire.sum[s] += us;
+    }
+    if (++wire.got < wire.want) return;
+
+    USBD_UsrLog("bench wire: %u frames, us on the wire min / avg / max (predicted)\n", wire.got);
+    for (uint8_t s = 0; s < n; ++s) {
+        const StripInfo *si = render_strip_info(s);
+        USBD_UsrLog("  strip %u: %u LEDs at %lu Hz  %lu / %lu / %lu (%lu)\n", s, si->count,
+                    (unsigned long)si->bitrate, (unsigned long)wire.min[s],
+                    (unsigned long)(wire.sum[s] / wire.got), (unsigned long)wire.max[s],
+                    (unsigned long)si->wire_us);
+    }
+    wire.want = 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * render_bench.h – encoder and SPI wire micro-benchmarks, on the target
+ *
+ * "bench encode [iterations]" times ways of turning RGB into WS2812 SPI
+ * patterns over the same RENDER_BENCH_LEDS LED pattern (fixed, pseudo
+ * random), each iteration on its own with DWT, once with interrupts off
+ * (the kernel alone) and once with them on (what the main loop sees):
+ *
+ *   render     render_encode_leds(), the encoder as built (config.h)
+ *   tbl24      byte → 24 bit table in RAM, nine byte stores   (flash code)
+ *   tbl24-ram  the same code in SRAM (.RamFunc)
+ *   tbl24-rom  the same code reading lut_ws_bits from flash
+ *   words      tbl24 with two word stores and a byte per LED
+ *   nibble     two lookups per byte in a 16 entry table
+ *   bits       no table, the patterns built bit by bit
+ *   gather     tbl24 reading the LEDs through an index table, the way a
+ *              remap (render_set_remap) walks the framebuffer
+ *
+ * One line each: cycles per LED, minimum and average over the iterations.
+ * The variants write plain RGB order, only render applies brightness, gamma
+ * and LED_COLOR_ORDER; the numbers are for choosing between them, not for
+ * checking their output.
+ *
+ * "bench wire [frames]" watches that many frames go out (whatever draws
+ * them) and prints each strip's time on the wire, start → TxCplt as the DMA
+ * completion timestamps it (StripInfo.last_us): minimum, average, maximum
+ * next to the predicted wire_us.
+ */
+
+#ifndef _RENDER_BENCH_H_
+#define _RENDER_BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RENDER_BENCH_LEDS
+  #define RENDER_BENCH_LEDS     240     /* one strip's worth */
+#endif
+#ifndef RENDER_BENCH_ITERS
+  #define RENDER_BENCH_ITERS    50
+#endif
+#ifndef RENDER_BENCH_FRAMES
+  #define RENDER_BENCH_FRAMES   120
+#endif
+
+/**
+ * Run the encoder variants now and print a line each (blocks the main loop
+ * for iterations × variants × ~0.1 ms). false if the buffers don't fit.
+ */
+bool render_bench_encode(uint16_t iterations);
+
+/**
+ * Sample the strips' wire times over the next frames (0 =
+ * RENDER_BENCH_FRAMES), printed once they are in
+ */
+void render_bench_wire(uint16_t frames);
+
+/**
+ * Call once per main loop pass: collects the wire times
+ */
+void render_bench_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RENDER_BENCH_H_ */
@@ -0,0 +1,224 @@
+/* --------------------------------------------------------------------------
+ * replay.c – console lines and packets kept per frame, handed over again
+ * -------------------------------------------------------------------------- */
+#include "replay.h"
+
+#ifdef LED_REPLAY
+
+#include <stdio.h>
+#include <string.h>
+#include "anim_clock.h"      /* anim_clock_fixed */
+#include "frame_clock.h"     /* period_us */
+#include "led_anim.h"
+#include "led_governor.h"
+#include "led_render.h"      /* g_global_brightness */
+#include "led_rng.h"
+#include "usb_comms.h"       /* usb_comms_run_line, USBD_UsrLog(), usb_tx_room() */
+#include "usb_packet.h"      /* usb_packet_run */
+
+#define BYTES_PER_LINE  64
+#define LINE_ROOM       (2 * BYTES_PER_LINE + 16)
+
+typedef enum { REPLAY_OFF, REPLAY_REC, REPLAY_PLAY } Mode;
+
+static uint8_t           buf[REPLAY_BYTES];
+static ReplayHead        head;
+static volatile uint8_t  mode;
+static volatile uint32_t frame;      /* frames begun since the start */
+static uint32_t          pos;        /* recording: bytes kept, playing: next entry */
+static ReplayStats       stats;      /* of the last play */
+static int8_t            gov_was;    /* gov_force() before, -1 = adaptive */
+static bool              full;
+
+/* dump progress */
+static bool              dumping;
+static uint32_t          dump_pos;
+
+/* the same start for recording and playing: seed, animation from its
+ * beginning, fixed animation steps, the quality level pinned */
+static void restart(const ReplayHead *h)
+{
+    int a = anim_find(h->anim);
+    rng_seed(h->seed);
+    anim_release();
+    if (a >= 0) anim_select((uint8_t)a);
+    anim_clock_fixed(h->period_us);
+    gov_was = gov_forced() ? (int8_t)gov_level() : -1;
+    gov_force((int8_t)h->gov_level);
+    g_global_brightness = h->brightness;
+    frame = 0;
+}
+
+bool replay_record(void)
+{
+    if (mode == REPLAY_PLAY || dumping) return false;
+    replay_stop();                   /* a running recording, from the start again */
+    const Animation *a = anim_get(anim_selected());
+    memset(&head, 0, sizeof head);
+    memcpy(head.magic, REPLAY_MAGIC, 4);
+    head.version    = REPLAY_VERSION;
+    head.gov_level  = gov_level();
+    head.brightness = g_global_brightness;
+    head.seed       = rng_seed_get();
+    head.period_us  = frame_clock_stats()->period_us;
+    if (a) strncpy(head.anim, a->name, sizeof head.anim - 1);
+    restart(&head);
+    pos  = 0;
+    full = false;
+    mode = REPLAY_REC;
+    return true;
+}
+
+static void begin_play(void)
+{
+    restart(&head);
+    pos  = 0;
+    memset(&stats, 0, sizeof stats);
+    mode = REPLAY_PLAY;
+}
+
+bool replay_play(void)
+{
+    if (mode != REPLAY_OFF || dumping || !head.frames) return false;
+    begin_play();
+    return true;
+}
+
+bool replay_load(const ReplayHead *h, const uint8_t *entries)
+{
+    if (memcmp(h->magic, REPLAY_MAGIC, 4) || h->version != REPLAY_VERSION ||
+        h->bytes > REPLAY_BYTES || mode != REPLAY_OFF) return false;
+    head = *h;
+    memcpy(buf, entries, h->bytes);
+    begin_play();
+    return true;
+}
+
+void replay_stop(void)
+{
+    if (mode == REPLAY_REC) {
+        head.frames = frame;
+        head.bytes  = pos;
+    }
+    if (mode != REPLAY_OFF) {
+        anim_clock_fixed(0);
+        gov_force(gov_was);
+    }
+    mode = REPLAY_OFF;
+}
+
+bool replay_recording(void) { return mode == REPLAY_REC; }
+bool replay_playing(void)   { return mode == REPLAY_PLAY; }
+
+/* the "rec" commands themselves are neither kept nor ignored */
+static bool own_command(uint8_t type, const uint8_t *b, uint8_t len)
+{
+    return type == REPLAY_LINE && len >= 3 && memcmp(b, "rec", 3) == 0 &&
+           (len == 3 || b[3] == ' ');
+}
+
+bool replay_note(uint8_t type, const uint8_t *b, uint8_t len)
+{
+    if (mode == REPLAY_OFF || own_command(type, b, len)) return true;
+    if (mode == REPLAY_PLAY) return false;
+
+    if (pos + REPLAY_ENTRY_HEAD + len > REPLAY_BYTES) {
+        full = true;
+        replay_stop();
+        return true;
+    }
+    uint32_t f = frame;
+    memcpy(&buf[pos], &f, 4);
+    buf[pos + 4] = type;
+    buf[pos + 5] = len;
+    memcpy(&buf[pos + REPLAY_ENTRY_HEAD], b, len);
+    pos += REPLAY_ENTRY_HEAD + len;
+    return true;
+}
+
+void replay_frame(void)
+{
+    if (mode == REPLAY_PLAY) {
+        while (pos + REPLAY_ENTRY_HEAD <= head.bytes) {
+            uint32_t f;
+            memcpy(&f, &buf[pos], 4);
+            if (f > frame) break;
+            uint8_t  type = buf[pos + 4], len = buf[pos + 5];
+            uint8_t *b    = &buf[pos + REPLAY_ENTRY_HEAD];
+            pos += REPLAY_ENTRY_HEAD + len;
+            if (type == REPLAY_LINE) {
+                char line[256];
+                memcpy(line, b, len);
+                line[len] = '\0';
+                if (usb_comms_run_line(line)) ++stats.lines;
+                else                          ++stats.skipped;
+            } else {
+                usb_packet_run(type, b, len);
+                ++stats.packets;
+            }
+        }
+        if (frame >= head.frames) {
+            replay_stop();
+            return;
+        }
+    }
+    if (mode != REPLAY_OFF) ++frame;
+}
+
+void replay_report(void)
+{
+    if (mode == REPLAY_REC) {
+        USBD_UsrLog("rec: recording %s, frame %lu, %lu of %u bytes\n", head.anim,
+                    (unsigned long)frame, (unsigned long)pos, (unsigned)REPLAY_BYTES);
+    } else if (mode == REPLAY_PLAY) {
+        USBD_UsrLog("rec: playing %s, frame %lu of %lu\n", head.anim,
+                    (unsigned long)frame, (unsigned long)head.frames);
+    } else if (head.frames) {
+        USBD_UsrLog("rec: %s, %lu frames, %lu bytes, seed 0x%08lx%s; last play %lu lines "
+                    "%lu packets\n", head.anim, (unsigned long)head.frames,
+                    (unsigned long)head.bytes, (unsigned long)head.seed,
+                    full ? " (stopped full)" : "", (unsigned long)stats.lines,
+                    (unsigned long)stats.packets);
+    } else {
+        USBD_UsrLog("rec: nothing recorded\n");
+    }
+}
+
+const ReplayStats *replay_stats(void)
+{
+    return &stats;
+}
+
+void replay_dump_start(void)
+{
+    if (dumping || mode == REPLAY_REC || !head.frames) {
+        replay_report();
+        return;
+    }
+    dumping  = true;
+    dump_pos = 0;
+    USBD_UsrLog("#rec# n=%lu#", (unsigned long)(sizeof head + head.bytes));
+}
+
+/* the head, then the entries, as hex */
+void replay_tick(void)
+{
+    if (!dumping) return;
+    const uint32_t total = sizeof head + head.bytes;
+    while (dump_pos < total && usb_tx_room() > LINE_ROOM) {
+        char   line[LINE_ROOM];
+        size_t off = snprintf(line, sizeof line, "#rc ");
+        for (uint8_t k = 0; k < BYTES_PER_LINE && dump_pos < total; ++k, ++dump_pos) {
+            uint8_t v = dump_pos < sizeof head ? ((const uint8_t *)&head)[dump_pos]
+                                               : buf[dump_pos - sizeof head];
+            off += snprintf(line + off, sizeof line - off, "%02x", v);
+        }
+        USBD_UsrLog("%s#", line);
+    }
+    if (dump_pos >= total && usb_tx_room() > LINE_ROOM) {
+        USBD_UsrLog("#endrec#");
+        dumping = false;
+    }
+}
+
+#endif /* LED_REPLAY */
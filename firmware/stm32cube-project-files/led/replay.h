@@ -0,0 +1,134 @@
+/*
+ * replay.h – input record / replay for reproducible frame times (LED_REPLAY)
+ *
+ * "rec start" starts a recording from a known state: the animation
+ * restarted from the global seed, the animation clock one fixed step per
+ * frame from 0 (anim_clock_fixed), the quality level pinned where it is
+ * (led_governor.h), the brightness kept. From then every console line and
+ * every packet that passes its CRC is kept with the number of the frame it
+ * came before, until "rec stop" or REPLAY_BYTES are full.
+ *
+ * "rec play" starts from the same state again and hands every input to the
+ * console / packet handlers right before the frame it came before on the
+ * original run; anything arriving meanwhile is ignored. The same frames are
+ * drawn from the same inputs, so a stutter that came with them comes again.
+ *
+ * "rec dump" sends the recording to the app (#rec# ... #endrec#), which
+ * saves it as logs/rec_<time>.bin: a ReplayHead, then the entries. The host
+ * build plays such a file on the desktop (tools/host: led_host -p file),
+ * with the packets; console lines are handled by usb_comms.c, which the host
+ * build leaves out, and are only counted there.
+ *
+ * Entry: frame u32 | type u8 (REPLAY_LINE or the packet type) | len u8 |
+ * bytes (the line without its end, or the packet payload), little endian.
+ * Settings changed before "rec start" (palette, parameters) are not part
+ * of it: on the board the replay starts from what is set then.
+ */
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* recording buffer, bytes (6 per entry on top of its bytes) */
+#ifndef REPLAY_BYTES
+  #define REPLAY_BYTES      4096
+#endif
+
+#define REPLAY_MAGIC        "IPRC"
+#define REPLAY_VERSION      1
+#define REPLAY_LINE         0x00        /* entry type of a console line */
+#define REPLAY_ENTRY_HEAD   6
+
+/* the start a recording was made from; a saved recording begins with it */
+typedef struct {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  gov_level;                 /* quality level pinned */
+    uint8_t  brightness;
+    uint8_t  _pad;
+    uint32_t seed;                      /* rng_seed */
+    uint32_t period_us;                 /* one frame, the animation step */
+    uint32_t frames;                    /* frames the recording ran */
+    uint32_t bytes;                     /* entries that follow */
+    char     anim[16];                  /* the animation, by name */
+} ReplayHead;
+
+/* what the last play handed over */
+typedef struct {
+    uint32_t lines;
+    uint32_t packets;
+    uint32_t skipped;                   /* lines nothing ran (host build) */
+} ReplayStats;
+
+#ifdef LED_REPLAY
+
+/**
+ * Restart from a known state and record the input (false while playing)
+ */
+bool replay_record(void);
+
+/**
+ * Play the recording in RAM from the same start (false if there is none)
+ */
+bool replay_play(void);
+
+/**
+ * Play a recording from elsewhere (the host build's file): head and its
+ * entries, copied. false if it does not fit or is not one.
+ */
+bool replay_load(const ReplayHead *h, const uint8_t *entries);
+
+/**
+ * Stop recording / playing, the animation clock measured again
+ */
+void replay_stop(void);
+
+bool replay_recording(void);
+bool replay_playing(void);
+
+const ReplayStats *replay_stats(void);
+
+/**
+ * Frame start, before anything is drawn: counts the frame, hands the
+ * recorded input of this frame over while playing
+ */
+void replay_frame(void);
+
+/**
+ * Input as it is handled: a console line (REPLAY_LINE) or a packet's
+ * payload. Kept while recording; false while playing, it is not to be
+ * handled then.
+ */
+bool replay_note(uint8_t type, const uint8_t *bytes, uint8_t len);
+
+/**
+ * Console status ("rec")
+ */
+void replay_report(void);
+
+/**
+ * Send the recording to the app ("rec dump"), replay_tick() streams it
+ */
+void replay_dump_start(void);
+void replay_tick(void);
+
+#else
+
+#define replay_frame()              ((void)0)
+#define replay_note(type, b, len)   true
+#define replay_tick()               ((void)0)
+
+#endif /* LED_REPLAY */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _REPLAY_H_ */
@@ -0,0 +1,27 @@
+/* --------------------------------------------------------------------------
+ * rom_tables.c – const boot tables from rom_tables.inc (LED_ROM_TABLES)
+ * -------------------------------------------------------------------------- */
+#include "rom_tables.h"
+
+#ifdef LED_ROM_TABLES
+
+#include "rom_tables.inc"
+
+/* the Polyhedron header takes plain pointers, the tables are never written */
+void rom_poly_init(Polyhedron *p)
+{
+    p->V       = ROM_V;
+    p->v       = (float (*)[3])rom_v;
+    p->F       = ROM_F;
+    p->S       = ROM_S;
+    p->fv      = (uint8_t *)rom_fv;
+    p->f       = (poly_idx_t **)rom_f;
+    p->E       = ROM_E;
+    p->e       = (Edge *)rom_e;
+    p->e2f     = (poly_idx_t (*)[2])rom_e2f;
+    p->v2e_off = (uint16_t *)rom_v2e_off;
+    p->v2e     = (poly_idx_t *)rom_v2e;
+    poly_touch(p);
+}
+
+#endif /* LED_ROM_TABLES */
@@ -0,0 +1,37 @@
+/*
+ * rom_tables.h – boot tables precomputed on the host, linked into flash
+ *
+ * With LED_ROM_TABLES (config.h) the oriented dodecahedron comes from
+ * rom_tables.inc, written by tools/poly_gen.c with the same builders the
+ * firmware runs otherwise: nothing to compute at boot and no RAM for it. The edge / flip map (flash store) and everything derived from it
+ * is still built by init_mapping(). Without the option the runtime builders
+ * are used as before.
+ */
+
+#ifndef _ROM_TABLES_H_
+#define _ROM_TABLES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "polyhedron.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef LED_ROM_TABLES
+
+/**
+ * Point p at the flash tables (dodecahedron, already standing on vertex 0).
+ * Read only: no poly_rotate(), poly_orient_*() or poly_prepare() on it.
+ */
+void rom_poly_init(Polyhedron *p);
+
+#endif /* LED_ROM_TABLES */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ROM_TABLES_H_ */
@@ -0,0 +1,229 @@
+/* --------------------------------------------------------------------------
+ * rtos_app.c – FreeRTOS tasks, static, frames handed over by queue
+ * -------------------------------------------------------------------------- */
+#include "rtos_app.h"
+
+#ifdef LED_RTOS
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "frame_clock.h"     /* frame_clock_begin / frame_clock_tick_hook */
+#include "frame_sync.h"
+#include "latency.h"
+#include "led_view.h"
+#include "led_debug.h"       /* debug_ui_tick */
+#include "led_mirror.h"
+#include "led_render.h"      /* render_send_drawn / render_strip_done */
+#include "sched.h"           /* the comms side: sched_run */
+#include "irq_stats.h"
+#include "replay.h"          /* replay_frame */
+#include "audio.h"           /* audio_latch */
+#include "main.h"            /* Error_Handler */
+#include "stm32f4xx_hal.h"
+
+extern void vPortSVCHandler(void);
+extern void xPortPendSVHandler(void);
+extern void xPortSysTickHandler(void);
+
+/* F401: 16 system exceptions and the IRQs up to SPI4; VTOR wants the table
+ * aligned to its size rounded up to a power of two */
+#define VECTORS  (16u + (uint32_t)SPI4_IRQn + 1u)
+static uint32_t vectors[VECTORS] __attribute__((aligned(512)));
+
+#define RTOS_STACK(name, text, prio, words) static StackType_t stack_##name[words];
+RTOS_TASKS(RTOS_STACK)
+#undef RTOS_STACK
+
+static StaticTask_t  tcbs[RTOS_TASK_IDLE];
+static TaskHandle_t  tasks[RTOS_TASK_COUNT];
+static StaticTask_t  idle_tcb;
+static StackType_t   idle_stack[configMINIMAL_STACK_SIZE];
+
+/* frame numbers: ready anim → render, free render → anim (the framebuffer) */
+static StaticQueue_t ready_mem, free_mem;
+static uint8_t       ready_buf[sizeof(uint32_t)], free_buf[sizeof(uint32_t)];
+static QueueHandle_t ready_q, free_q;
+static StaticSemaphore_t lock_mem;
+static SemaphoreHandle_t engine_lock;   /* one of anim / render / comms in the engine */
+
+/* ─── interrupts ──────────────────────────────────────────────────────── */
+
+static void systick_isr(void)
+{
+    IRQ_ENTER(SYSTICK);
+    HAL_IncTick();
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) xPortSysTickHandler();
+    IRQ_EXIT(SYSTICK);
+}
+
+static void notify_from_isr(RtosTask t)
+{
+    if (!tasks[t]) return;           /* before rtos_start() */
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(tasks[t], &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/* TIM2 (frame_clock.h) */
+void frame_clock_tick_hook(void)
+{
+    notify_from_isr(RTOS_TASK_ANIM);
+}
+
+/* strip DMA done (led_render.h), overrides the weak one */
+void render_strip_done(uint8_t strip, uint32_t end_cycles)
+{
+    (void)strip;
+    (void)end_cycles;
+    notify_from_isr(RTOS_TASK_RENDER);
+}
+
+/* the generated handlers stay in flash, the kernel's go into a RAM copy */
+static void vectors_to_ram(void)
+{
+    memcpy(vectors, (const void *)SCB->VTOR, sizeof vectors);
+    /* the kernel resets the MSP to entry 0 when it starts: keep it on the
+     * interrupt stack when stack_init() split one off (thread mode on PSP) */
+    if (__get_CONTROL() & CONTROL_SPSEL_Msk) vectors[0] = __get_MSP();
+    vectors[16 + SVCall_IRQn]  = (uint32_t)(uintptr_t)vPortSVCHandler;
+    vectors[16 + PendSV_IRQn]  = (uint32_t)(uintptr_t)xPortPendSVHandler;
+    vectors[16 + SysTick_IRQn] = (uint32_t)(uintptr_t)systick_isr;
+
+    __disable_irq();
+    SCB->VTOR = (uint32_t)(uintptr_t)vectors;
+    __DSB();
+    __enable_irq();
+}
+
+/* ─── tasks ───────────────────────────────────────────────────────────── */
+
+/* highest: a drawn frame out as soon as the strips take it */
+static void render_task(void *arg)
+{
+    (void)arg;
+    uint32_t frame;
+    for (;;) {
+        xQueueReceive(ready_q, &frame, portMAX_DELAY);
+        for (;;) {
+            xSemaphoreTake(engine_lock, portMAX_DELAY);
+            bool sent = render_send_drawn();
+            xSemaphoreGive(engine_lock);
+            if (sent) break;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));   /* a strip finished */
+        }
+        xQueueSend(free_q, &frame, 0);   /* drawn into again from here */
+    }
+}
+
+/* one frame per frame clock tick, while the last one is on the wire */
+static void anim_task(void *arg)
+{
+    (void)arg;
+    uint32_t frame = 0;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!frame_clock_begin()) continue;
+        xQueueReceive(free_q, &frame, portMAX_DELAY);
+
+        xSemaphoreTake(engine_lock, portMAX_DELAY);
+        replay_frame();              /* a replay: the input this frame came after */
+        frame_sync_tick();           /* shared frame number, clock steered to the host */
+        latency_frame();             /* a probe waiting: this frame draws what came with it */
+        audio_latch();               /* the bands this frame draws with */
+        view_tick();
+        debug_ui_tick();             /* update_leds() only notes the frame */
+        mirror_frame();
+        frame_clock_end();
+        xSemaphoreGive(engine_lock);
+
+        ++frame;
+        xQueueSend(ready_q, &frame, portMAX_DELAY);
+    }
+}
+
+/* the SPSC ring fills from the USB interrupt (above the kernel), drained
+ * here every tick along with the rest of the main loop tasks */
+static void comms_task(void *arg)
+{
+    (void)arg;
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, 1);
+        xSemaphoreTake(engine_lock, portMAX_DELAY);
+        sched_run();
+        xSemaphoreGive(engine_lock);
+    }
+}
+
+static void (*const task_fns[RTOS_TASK_IDLE])(void *) = { render_task, anim_task, comms_task };
+
+void rtos_start(void)
+{
+    ready_q     = xQueueCreateStatic(1, sizeof(uint32_t), ready_buf, &ready_mem);
+    free_q      = xQueueCreateStatic(1, sizeof(uint32_t), free_buf, &free_mem);
+    engine_lock = xSemaphoreCreateMutexStatic(&lock_mem);
+    uint32_t frame = 0;
+    xQueueSend(free_q, &frame, 0);   /* the framebuffer starts out free */
+
+#define RTOS_CREATE(name, text, prio, words)                                      \
+    tasks[RTOS_TASK_##name] = xTaskCreateStatic(task_fns[RTOS_TASK_##name], text, \
+                                   words, NULL, prio, stack_##name, &tcbs[RTOS_TASK_##name]);
+    RTOS_TASKS(RTOS_CREATE)
+#undef RTOS_CREATE
+
+    vectors_to_ram();
+    vTaskStartScheduler();           /* takes the idle task from below */
+    Error_Handler();                 /* not reached */
+}
+
+/* ─── kernel hooks ────────────────────────────────────────────────────── */
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *words)
+{
+    *tcb   = &idle_tcb;
+    *stack = idle_stack;
+    *words = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationIdleHook(void)
+{
+    if (!tasks[RTOS_TASK_IDLE]) tasks[RTOS_TASK_IDLE] = xTaskGetIdleTaskHandle();
+#ifdef MAIN_LOOP_WFI
+    __WFI();                         /* idle_init() keeps DWT running in sleep */
+#endif
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name)
+{
+    (void)task;
+    (void)name;
+    Error_Handler();
+}
+
+/* ─── stats ───────────────────────────────────────────────────────────── */
+
+void rtos_task_stats(RtosTaskStat out[RTOS_TASK_COUNT])
+{
+    static uint32_t last_run[RTOS_TASK_COUNT], last_total;
+    TaskStatus_t st[RTOS_TASK_COUNT];
+    uint32_t     total;
+    UBaseType_t  n = uxTaskGetSystemState(st, RTOS_TASK_COUNT, &total);
+    uint32_t     dt = total - last_total;   /* CYCCNT wraps, differences do not */
+
+    last_total = total;
+    memset(out, 0, RTOS_TASK_COUNT * sizeof *out);
+    for (UBaseType_t i = 0; i < n; ++i) {
+        uint8_t k = 0;
+        while (k < RTOS_TASK_COUNT && tasks[k] != st[i].xHandle) ++k;
+        if (k == RTOS_TASK_COUNT) continue;
+        uint32_t run = st[i].ulRunTimeCounter - last_run[k];
+        last_run[k]  = st[i].ulRunTimeCounter;
+        out[k].cpu_permille = dt ? (uint16_t)((uint64_t)run * 1000u / dt) : 0;
+        out[k].stack_free   = (uint16_t)(st[i].usStackHighWaterMark * sizeof(StackType_t));
+    }
+}
+
+#endif /* LED_RTOS */
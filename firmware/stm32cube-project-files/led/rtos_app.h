@@ -0,0 +1,86 @@
+/*
+ * rtos_app.h – the FreeRTOS build (LED_RTOS): render, anim and comms tasks
+ *
+ * The bare-metal main loop (sched.h) stays the default, it has the lowest
+ * latency. With LED_RTOS main() calls rtos_start() instead and three tasks
+ * take over, all allocated statically:
+ *
+ *   render  (highest)  a frame from the anim task goes out as soon as the
+ *                      strips are free: woken by the strip DMA completion
+ *                      (render_strip_done()), render_submit(), the buffer
+ *                      handed back
+ *   anim               woken by the frame clock tick: sync, view, the
+ *                      animation frame, drawn while the previous one is
+ *                      still on the wire
+ *   comms              every ms: host input out of the SPSC ring, the USB
+ *                      flush, telemetry and the rest of the sched.h tasks
+ *                      (bulk dumps still in slices behind the frame)
+ *
+ * Frames go anim → render by queue (the frame number), the framebuffer comes
+ * back by a second one: the anim task only draws when render is done
+ * encoding. The engine is not reentrant, one mutex (priority inheritance)
+ * is held for a frame, a submit and a command.
+ *
+ * What FreeRTOS needs: the kernel sources (Middlewares/Third_Party/FreeRTOS,
+ * port GCC/ARM_CM4F) in the build and Core/Inc/FreeRTOSConfig.h. The
+ * generated handlers stay as they are: rtos_start() moves the vector table
+ * to RAM with the kernel's SVC, PendSV and SysTick in it. Interrupts at
+ * priority 0 and 1 (USB) never call the kernel; the strip DMAs (2) and the
+ * frame clock (3) do, so the kernel masks from 2 on (configMAX_SYSCALL_
+ * INTERRUPT_PRIORITY).
+ *
+ * rtos_task_stats() has each task's CPU share since the last call and its
+ * stack headroom; telemetry.h sends them.
+ */
+
+#ifndef _RTOS_APP_H_
+#define _RTOS_APP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* tasks: name, priority, stack in words; the order is the one telemetry has
+ * them in, after them the kernel's idle task (keep app/telemetry.py in sync) */
+#define RTOS_TASKS(X)               \
+    X(RENDER,  "render", 3, 512)    \
+    X(ANIM,    "anim",   2, 1024)   \
+    X(COMMS,   "comms",  1, 768)
+
+typedef enum {
+#define RTOS_ENUM(name, text, prio, words) RTOS_TASK_##name,
+    RTOS_TASKS(RTOS_ENUM)
+#undef RTOS_ENUM
+    RTOS_TASK_IDLE,
+    RTOS_TASK_COUNT
+} RtosTask;
+
+typedef struct {
+    uint16_t cpu_permille;   /* of the time since the last call */
+    uint16_t stack_free;     /* bytes never touched, the high water mark */
+} RtosTaskStat;
+
+#ifdef LED_RTOS
+
+/**
+ * Create the tasks and start the scheduler, from main() after the
+ * peripherals, the scene and USB are up. Does not return.
+ */
+void rtos_start(void);
+
+/**
+ * Per task numbers, RTOS_TASK_COUNT of them (comms task, telemetry)
+ */
+void rtos_task_stats(RtosTaskStat out[RTOS_TASK_COUNT]);
+
+#endif /* LED_RTOS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTOS_APP_H_ */
@@ -0,0 +1,137 @@
+/* --------------------------------------------------------------------------
+ * scene.c – build / tear down the geometry and everything derived from it
+ * -------------------------------------------------------------------------- */
+#include "scene.h"
+
+#include <string.h>
+#include "led_mapping.h"
+#include "led_geodesic.h"
+#include "led_spatial.h"
+#include "led_paths.h"
+#include "led_render.h"
+#include "led_debug.h"
+#include "led_anim.h"      /* anim_release */
+#include "usb_comms.h"   /* USBD_UsrLog() */
+#include "boot_prof.h"   /* boot_mark, the boot scene's phases */
+#include "scene_mem.h"   /* scene_alloc, the pool all of it lives in */
+#ifdef LED_ROM_TABLES
+#include "rom_tables.h"
+#endif
+
+Polyhedron poly;  /* our geometry instance */
+
+static PolyArena poly_arena;
+
+static uint8_t                    scene_strips = 0;
+static SPI_HandleTypeDef * const *scene_spis   = NULL;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Boot solid, standing on a tip
+ */
+static bool build_boot(Polyhedron *p, PolyArena *a)
+{
+#ifdef LED_ROM_TABLES
+    (void)a;
+    rom_poly_init(p);              /* precomputed by tools/poly_gen, already on the tip */
+    return true;
+#else
+    if (!poly_init_dodecahedron(p, a)) return false;
+    poly_orient_to_vertex(p, 0);   /* tools/poly_gen.c does the same */
+    return true;
+#endif
+}
+
+static const struct { const char *name; PolyBuilder build; } builders[] = {
+    { "tetra",       poly_init_tetrahedron       },
+    { "cube",        poly_init_cube              },
+    { "octa",        poly_init_octahedron        },
+    { "icosa",       poly_init_icosahedron       },
+    { "dodeca",      build_boot                  },
+    { "icosidodeca", poly_init_icosidodecahedron },
+};
+
+PolyBuilder scene_builder(const char *name)
+{
+    for (unsigned i = 0; i < sizeof builders / sizeof builders[0]; ++i)
+        if (strcmp(name, builders[i].name) == 0) return builders[i].build;
+    return NULL;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * From an empty pool, the same layout every time (scene_mem.h)
+ */
+static bool scene_load(PolyBuilder build)
+{
+    scene_mem_reset();
+
+    /* 1. geometry, given SCENE_ARENA_BYTES and trimmed to what it took */
+    poly_arena_init(&poly_arena, scene_alloc("poly", SCENE_ARENA_BYTES), SCENE_ARENA_BYTES);
+    if (!poly_arena.mem || !build(&poly, &poly_arena)) return false;
+    scene_mem_trim(poly_arena.mem, poly_arena.used);
+    if (build != build_boot) poly_orient_to_vertex(&poly, 0);
+    boot_mark(BOOT_GEOMETRY);
+
+    /* 2. logical-to-physical edge mapping
+     *    (the one saved in flash if there is one, else config.h) */
+    poly_idx_t boot_map[EDGE_CNT];
+    bool       boot_flip[EDGE_CNT];
+    bool       wired = (poly.E == EDGE_CNT);
+    if (wired) {
+        for (uint16_t e = 0; e < EDGE_CNT; ++e)
+            boot_map[e] = (poly_idx_t)USER_MAP[e];
+        memcpy(boot_flip, USER_FLIP, sizeof boot_flip);
+        mapping_store_load(boot_map, boot_flip, EDGE_CNT);
+    }
+    if (!init_mapping(&poly, wired ? boot_map : NULL, wired ? boot_flip : NULL, EDGE_CNT)) {
+        return false;
+    }
+    boot_mark(BOOT_MAPPING);
+
+    /*    wireframe distance tables for the effects (per LED part lazily),
+     *    V² sized: a big solid goes without (geodesic_* say unreachable) */
+    if (!geodesic_init(&poly)) geodesic_shutdown();
+    /*    and the closed walks for the path effects (led_paths.h) */
+    if (!paths_init(&poly)) paths_shutdown();
+    boot_mark(BOOT_GEODESIC);
+
+    /* 3. LED renderer (framebuffer + DMA buffers) */
+    if (!init_render(mapping_get_total_pixels(), scene_strips, scene_spis)) return false;
+    boot_mark(BOOT_RENDER);
+    return true;
+}
+
+static void scene_unload(void)
+{
+    anim_release();                /* heap, sized to the old scene */
+    led_render_shutdown();         /* stops the DMAs before the pool is reused */
+    spatial_shutdown();
+    paths_shutdown();
+    geodesic_shutdown();
+    mapping_shutdown();
+    debug_reset();
+}
+
+bool scene_init(PolyBuilder build, uint8_t strip_cnt, SPI_HandleTypeDef * const *spis)
+{
+    scene_strips = strip_cnt;
+    scene_spis   = spis;
+    return scene_load(build ? build : build_boot);
+}
+
+bool scene_reload(PolyBuilder build)
+{
+    uint32_t t0 = HAL_GetTick();
+    scene_unload();
+    if (scene_load(build)) {
+        USBD_UsrLog("scene: V %u E %u F %u, %u leds, %lu B of the pool, %lu ms\n", poly.V, poly.E,
+                    poly.F, mapping_get_total_pixels(), (unsigned long)scene_mem_used(),
+                    (unsigned long)(HAL_GetTick() - t0));
+        return true;
+    }
+    USBD_UsrLog("scene: does not fit (\"mem\"), back to the boot solid\n");
+    scene_unload();
+    if (!scene_load(build_boot)) {
+        USBD_UsrLog("scene: boot solid failed too\n");
+    }
+    return false;
+}
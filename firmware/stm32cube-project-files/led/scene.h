@@ -0,0 +1,65 @@
+/*
+ * scene.h – the geometry and everything derived from it, as one unit
+ *
+ * A scene is the polyhedron plus what is built on it: mapping, wireframe
+ * distances, edge spheres and the render buffers, all of it in the static
+ * scene pool (scene_mem.h). scene_reload() shuts the modules down, empties
+ * the pool and builds the new one the way boot does, so nothing fragments
+ * across switches. Call it from the main loop (not from an ISR), the
+ * renderer stops its DMAs first.
+ */
+
+#ifndef _SCENE_H_
+#define _SCENE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "polyhedron.h"
+#include "stm32f4xx_hal.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* most bytes of the scene pool the polyhedron arrays may take, the largest
+ * solid to switch to must fit (dodecahedron ~700, icosidodecahedron ~1.3k,
+ * see poly_conway_bytes()); trimmed to the real size once built */
+#ifndef SCENE_ARENA_BYTES
+#define SCENE_ARENA_BYTES  1536
+#endif
+
+/* any poly_init_* */
+typedef bool (*PolyBuilder)(Polyhedron *p, PolyArena *a);
+
+extern Polyhedron poly;    /* the current geometry */
+
+/**
+ * First scene, at boot. Keeps the strip setup for later reloads.
+ * @param build       NULL: the boot solid (dodecahedron, or the flash tables
+ *                    with LED_ROM_TABLES)
+ * @param strip_cnt   as init_render()
+ * @param spis        as init_render()
+ * @return false if anything could not be built
+ */
+bool scene_init(PolyBuilder build, uint8_t strip_cnt, SPI_HandleTypeDef * const *spis);
+
+/**
+ * Switch to another solid without a reboot. The saved / config.h edge map
+ * is used if the solid has EDGE_CNT edges, identity otherwise.
+ * @return false if it did not fit (scene pool, LED_RENDER_MAX_ALLOC), the
+ *         boot solid is loaded again then
+ */
+bool scene_reload(PolyBuilder build);
+
+/**
+ * PolyBuilder by name ("tetra", "cube", "octa", "icosa", "dodeca",
+ * "icosidodeca"), NULL if unknown.
+ */
+PolyBuilder scene_builder(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCENE_H_ */
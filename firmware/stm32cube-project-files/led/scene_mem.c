@@ -0,0 +1,94 @@
+/* --------------------------------------------------------------------------
+ * scene_mem.c – static bump pool for the scene, with named allocations
+ * -------------------------------------------------------------------------- */
+#include "scene_mem.h"
+
+#include <stdint.h>
+#include <string.h>
+#include "polyhedron.h"      /* PolyArena */
+#include "usb_comms.h"       /* USBD_UsrLog() */
+
+typedef struct {
+    const char *name;
+    uint32_t    at;          /* offset in the pool */
+    uint32_t    bytes;
+} MemTag;
+
+static uint32_t    pool[SCENE_MEM_BYTES / 4];
+static PolyArena   arena = { (uint8_t *)pool, sizeof pool, 0 };
+static MemTag      tags[SCENE_MEM_TAGS];
+static uint8_t     tag_cnt;
+static size_t      peak;
+static size_t      last_at = SIZE_MAX;   /* offset of the newest allocation */
+static const char *miss_name;    /* last request that did not fit */
+static size_t      miss_bytes;
+static bool        miss_logged;
+
+void *scene_alloc(const char *name, size_t bytes)
+{
+    uint8_t *p = poly_arena_alloc(&arena, bytes);
+    if (!p) {
+        if (!miss_logged || name != miss_name || bytes != miss_bytes) {
+            USBD_UsrLog("scene mem: %s, %lu B does not fit, %lu B free (SCENE_MEM_BYTES)\n",
+                        name, (unsigned long)bytes, (unsigned long)scene_mem_free());
+        }
+        miss_name   = name;
+        miss_bytes  = bytes;
+        miss_logged = true;
+        return NULL;
+    }
+    last_at = (size_t)(p - arena.mem);
+    if (arena.used > peak) peak = arena.used;
+    if (tag_cnt < SCENE_MEM_TAGS)
+        tags[tag_cnt++] = (MemTag){ name, (uint32_t)(p - arena.mem), (uint32_t)bytes };
+    return p;
+}
+
+void *scene_calloc(const char *name, size_t n, size_t size)
+{
+    void *p = scene_alloc(name, n * size);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void scene_mem_trim(void *p, size_t bytes)
+{
+    size_t at = (size_t)((uint8_t *)p - arena.mem);
+    if (!p || at != last_at || at + bytes > arena.used) return;   /* only the newest one */
+    arena.used = at + bytes;
+    if (tag_cnt && tags[tag_cnt - 1].at == at) tags[tag_cnt - 1].bytes = (uint32_t)bytes;
+}
+
+void scene_mem_reset(void)
+{
+    arena.used  = 0;
+    tag_cnt     = 0;
+    last_at     = SIZE_MAX;
+    miss_logged = false;
+}
+
+size_t scene_mem_used(void) { return arena.used; }
+size_t scene_mem_free(void) { return arena.size - arena.used; }
+size_t scene_mem_peak(void) { return peak; }
+
+void scene_mem_report(void)
+{
+    size_t tagged = 0;
+    USBD_UsrLog("scene mem: %lu.%lu of %lu.%lu kB used, peak %lu.%lu kB, %lu.%lu kB free\n",
+                (unsigned long)(arena.used / 1024u), (unsigned long)(arena.used % 1024u * 10u / 1024u),
+                (unsigned long)(arena.size / 1024u), (unsigned long)(arena.size % 1024u * 10u / 1024u),
+                (unsigned long)(peak / 1024u),       (unsigned long)(peak % 1024u * 10u / 1024u),
+                (unsigned long)(scene_mem_free() / 1024u),
+                (unsigned long)(scene_mem_free() % 1024u * 10u / 1024u));
+    for (uint8_t i = 0; i < tag_cnt; ++i) {
+        USBD_UsrLog("  %-14s %6lu %6lu\n", tags[i].name,
+                    (unsigned long)tags[i].at, (unsigned long)tags[i].bytes);
+        tagged += tags[i].bytes;
+    }
+    if (tag_cnt == SCENE_MEM_TAGS) {
+        USBD_UsrLog("  (untagged, alignment) %lu\n", (unsigned long)(arena.used - tagged));
+    }
+    if (miss_name) {
+        USBD_UsrLog("  did not fit: %s, %lu B\n", miss_name, (unsigned long)miss_bytes);
+    }
+}
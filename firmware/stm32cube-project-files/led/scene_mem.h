@@ -0,0 +1,97 @@
+/*
+ * scene_mem.h – the static pool everything a scene builds lives in
+ *
+ * The polyhedron, the mapping, the distance tables, the edge spheres and the
+ * render / DMA buffers are allocated once per scene and all go together at
+ * the next scene_reload(). Instead of malloc they bump-allocate from one
+ * static pool (SCENE_MEM_BYTES, in .bss, so the linker checks it fits next
+ * to the stack): nothing fragments, a reload starts from an empty pool and
+ * builds the same layout every time, and what is left is known exactly.
+ *
+ * Every allocation carries a name (the variable it goes to, by convention);
+ * "mem" on the console prints them with the high water mark since boot and
+ * the last request that did not fit:
+ *
+ *   scene mem: 31.3 of 38.0 kB used, peak 31.3 kB, 6.6 kB free
+ *     poly              0     708
+ *     leds_per_edge   712      30
+ *     ...
+ *
+ * There is no free: modules drop their pointers in their *_shutdown() and
+ * scene_mem_reset() takes the lot back. What comes and goes at runtime (the
+ * animation scratch, layers, transitions, benchmarks) stays on the heap,
+ * which now holds nothing of the scene in between.
+ */
+
+#ifndef _SCENE_MEM_H_
+#define _SCENE_MEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the whole scene: the 720 LED dodecahedron with double buffered strips
+ * ~31 kB, ~37 kB once the geodesic LED table and edge spheres are built,
+ * plus what the render options enabled in config.h take on top: the
+ * pipeline's second framebuffer, the larger strip buffers a raised
+ * LED_RENDER_MAX_ALLOC (default 16 kB) lets through */
+#ifdef LED_RENDER_PIPELINE
+  #define SCENE_MEM_PIPELINE    (3 * 1024)
+#else
+  #define SCENE_MEM_PIPELINE    0
+#endif
+#if defined(LED_RENDER_MAX_ALLOC) && LED_RENDER_MAX_ALLOC > 16 * 1024
+  #define SCENE_MEM_RENDER_MORE (LED_RENDER_MAX_ALLOC - 16 * 1024)
+#else
+  #define SCENE_MEM_RENDER_MORE 0
+#endif
+#ifndef SCENE_MEM_BYTES
+  #define SCENE_MEM_BYTES   (38 * 1024 + SCENE_MEM_PIPELINE + SCENE_MEM_RENDER_MORE)
+#endif
+/* names kept for the report, more allocations still work (untagged) */
+#ifndef SCENE_MEM_TAGS
+  #define SCENE_MEM_TAGS    40
+#endif
+
+/**
+ * bytes from the pool, POLY_ALIGN aligned (DMA safe). NULL if it does not
+ * fit, remembered for the report and logged (once until the next miss or
+ * reset: lazy tables retry every frame).
+ */
+void *scene_alloc(const char *name, size_t bytes);
+
+/**
+ * scene_alloc() of n × size, zeroed
+ */
+void *scene_calloc(const char *name, size_t n, size_t size);
+
+/**
+ * Shrink the last allocation to bytes (it was sized for the worst case)
+ */
+void scene_mem_trim(void *p, size_t bytes);
+
+/**
+ * Empty the pool. Every pointer into it is gone: scene_load() only, after
+ * the modules shut down.
+ */
+void scene_mem_reset(void);
+
+size_t scene_mem_used(void);
+size_t scene_mem_free(void);
+size_t scene_mem_peak(void);   /* since boot */
+
+/**
+ * Print the allocations (USBD_UsrLog)
+ */
+void scene_mem_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCENE_MEM_H_ */
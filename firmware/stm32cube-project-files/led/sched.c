@@ -0,0 +1,115 @@
+/* --------------------------------------------------------------------------
+ * sched.c – priority ordered main loop tasks, bulk jobs in slices
+ * -------------------------------------------------------------------------- */
+#include "sched.h"
+#include "frame_clock.h"     /* frame_clock_pending / frame_clock_slack_us */
+#include "usb_comms.h"       /* usb_tx_room, USBD_UsrLog() */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick, DWT */
+
+typedef struct {
+    const char *name;
+    SchedFn     fn;
+    uint8_t     prio;
+    uint16_t    period_ms;
+    uint32_t    last_ms;
+    uint32_t    runs;
+    uint32_t    max_cyc;
+} SchedTask;
+
+typedef struct {
+    const char *name;
+    SchedStep   step;
+    uint32_t    pos;         /* next step */
+} SchedJob;
+
+static SchedTask tasks[SCHED_TASKS];
+static uint8_t   task_cnt;
+static SchedJob  jobs[SCHED_JOBS];   /* FIFO, the first one runs */
+static uint8_t   job_head, job_cnt;
+
+bool sched_add(const char *name, SchedPrio prio, uint16_t period_ms, SchedFn fn)
+{
+    if (task_cnt >= SCHED_TASKS || prio >= SCHED_PRIO_COUNT) return false;
+    tasks[task_cnt++] = (SchedTask){ name, fn, (uint8_t)prio, period_ms, HAL_GetTick(), 0, 0 };
+    return true;
+}
+
+static void run_task(SchedTask *t)
+{
+    uint32_t c0 = DWT->CYCCNT;
+    t->fn();
+    uint32_t cyc = DWT->CYCCNT - c0;
+    t->runs++;
+    if (cyc > t->max_cyc) t->max_cyc = cyc;
+}
+
+static void run_prio(uint8_t prio, uint32_t now)
+{
+    for (uint8_t i = 0; i < task_cnt; ++i) {
+        SchedTask *t = &tasks[i];
+        if (t->prio != prio) continue;
+        if (t->period_ms && now - t->last_ms < t->period_ms) continue;
+        /* a tick came while the last one ran: the frame goes first */
+        if (prio != SCHED_RENDER && frame_clock_pending()) run_prio(SCHED_RENDER, now);
+        t->last_ms = now;
+        run_task(t);
+    }
+}
+
+/* room for one more step: the frame slot, the slice, the TX ring */
+static bool bulk_room(uint32_t c0)
+{
+    return !frame_clock_pending() &&
+           frame_clock_slack_us() >= SCHED_SLICE_US &&
+           DWT->CYCCNT - c0 < SCHED_SLICE_US * (SystemCoreClock / 1000000u) &&
+           usb_tx_room() >= SCHED_BULK_ROOM &&
+           usb_tx_channel_room(TX_CH_PACKET) >= SCHED_BULK_ROOM;   /* DLOG */
+}
+
+static void run_jobs(void)
+{
+    uint32_t c0 = DWT->CYCCNT;
+    while (job_cnt && bulk_room(c0)) {
+        SchedJob *j = &jobs[job_head];
+        if (!j->step(j->pos++)) {
+            job_head = (uint8_t)((job_head + 1u) % SCHED_JOBS);
+            job_cnt--;
+        }
+    }
+}
+
+void sched_run(void)
+{
+    uint32_t now = HAL_GetTick();
+    for (uint8_t p = SCHED_RENDER; p < SCHED_BULK; ++p) run_prio(p, now);
+    if (!bulk_room(DWT->CYCCNT)) return;     /* not enough of the slot left */
+    run_prio(SCHED_BULK, now);
+    run_jobs();
+}
+
+bool sched_job(const char *name, SchedStep step)
+{
+    if (job_cnt >= SCHED_JOBS) return false;
+    jobs[(job_head + job_cnt) % SCHED_JOBS] = (SchedJob){ name, step, 0 };
+    job_cnt++;
+    return true;
+}
+
+void sched_report(void)
+{
+    static const char *const prio_names[SCHED_PRIO_COUNT] = { "render", "comms", "ui", "bulk" };
+    uint32_t cyc_us = SystemCoreClock / 1000000u;
+
+    USBD_UsrLog("sched: %u tasks, %u jobs queued, bulk slice %u us\n",
+                (unsigned)task_cnt, (unsigned)job_cnt, (unsigned)SCHED_SLICE_US);
+    for (uint8_t i = 0; i < task_cnt; ++i) {
+        const SchedTask *t = &tasks[i];
+        USBD_UsrLog("  %-12s %-6s %4u ms %9lu runs, max %lu us\n", t->name, prio_names[t->prio],
+                    (unsigned)t->period_ms, (unsigned long)t->runs,
+                    (unsigned long)(t->max_cyc / cyc_us));
+    }
+    for (uint8_t k = 0; k < job_cnt; ++k) {
+        const SchedJob *j = &jobs[(job_head + k) % SCHED_JOBS];
+        USBD_UsrLog("  job %-8s step %lu\n", j->name, (unsigned long)j->pos);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * sched.h – cooperative main loop tasks, by priority
+ *
+ * Everything the main loop does is a task with a priority and a period
+ * (0 = every pass); sched_run() runs the due ones, highest priority first:
+ *
+ *   RENDER  the frame (anim → encode → DMA), once per frame clock tick
+ *   COMMS   host input, USB flush, the board link
+ *   UI      profiler windows, telemetry, reports
+ *   BULK    dumps, in slices
+ *
+ * Nothing is preempted, a task runs to its end, but a frame tick that came
+ * meanwhile is served before the next lower priority task starts. BULK only
+ * runs while the frame slot has SCHED_SLICE_US left and the TX ring has
+ * room, and a job (sched_job()) goes one step at a time: a model dump is a
+ * few hundred lines, each one a step, spread over as many frames as it
+ * takes instead of stealing one of them.
+ *
+ * "sched" on the console lists the tasks with runs and the longest run.
+ */
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* tasks sched_add() takes */
+#ifndef SCHED_TASKS
+  #define SCHED_TASKS       20
+#endif
+/* bulk jobs queued at once */
+#ifndef SCHED_JOBS
+  #define SCHED_JOBS        4
+#endif
+/* bulk work per pass, and the frame slot left it needs to start */
+#ifndef SCHED_SLICE_US
+  #define SCHED_SLICE_US    500
+#endif
+/* TX ring room a bulk step needs: about one dump line */
+#ifndef SCHED_BULK_ROOM
+  #define SCHED_BULK_ROOM   256
+#endif
+
+typedef enum {
+    SCHED_RENDER,
+    SCHED_COMMS,
+    SCHED_UI,
+    SCHED_BULK,
+    SCHED_PRIO_COUNT
+} SchedPrio;
+
+typedef void (*SchedFn)(void);
+
+/**
+ * One step of a bulk job: emit step number `step` (0, 1, 2, ...).
+ * @return true while there are more
+ */
+typedef bool (*SchedStep)(uint32_t step);
+
+/**
+ * Register a task, run every period_ms (0: every pass). In registration
+ * order within a priority.
+ * @return false when SCHED_TASKS are taken
+ */
+bool sched_add(const char *name, SchedPrio prio, uint16_t period_ms, SchedFn fn);
+
+/**
+ * One main loop pass
+ */
+void sched_run(void);
+
+/**
+ * Queue a bulk job, steps run in BULK slices until it returns false
+ * @return false when SCHED_JOBS are queued already
+ */
+bool sched_job(const char *name, SchedStep step);
+
+/**
+ * Print the tasks and the queued jobs (USBD_UsrLog)
+ */
+void sched_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCHED_H_ */
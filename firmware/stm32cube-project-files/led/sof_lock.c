@@ -0,0 +1,53 @@
+/* --------------------------------------------------------------------------
+ * sof_lock.c – frame clock trimmed to the USB SOF (sof_lock.h)
+ * -------------------------------------------------------------------------- */
+#include "sof_lock.h"
+
+#ifdef FRAME_SOF_LOCK
+
+#include "stm32f4xx_hal.h"
+#include "frame_clock.h"    /* frame_clock_set_trim */
+
+_Static_assert(SOF_LOCK_MS >= 64 && SOF_LOCK_MS < 2048, "SOF_LOCK_MS: 64 .. 2047");
+
+#define USB_DEV     ((USB_OTG_DeviceTypeDef *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_DEVICE_BASE))
+#define FN_MASK     0x7FFu          /* full speed: 11 bit frame number */
+
+static SofLockStats stats;
+static bool         started;
+static uint32_t     fn0, cyc0;      /* the window's first SOF */
+
+void sof_lock_isr(void)
+{
+    uint32_t cyc = DWT->CYCCNT;
+    uint32_t fn  = (USB_DEV->DSTS & USB_OTG_DSTS_FNSOF_Msk) >> USB_OTG_DSTS_FNSOF_Pos & FN_MASK;
+    if (!started) {
+        fn0 = fn; cyc0 = cyc; started = true;
+        return;
+    }
+    uint32_t ms = (fn - fn0) & FN_MASK;
+    if (ms < SOF_LOCK_MS) return;
+
+    /* cycles per host ms against ours; a window whose cycles do not fit its
+     * SOF count (numbers wrapped while SOFs were off) is out of range too */
+    uint32_t due = SystemCoreClock / 1000u * ms;
+    int32_t  ppm = (int32_t)((int64_t)(int32_t)(cyc - cyc0 - due) * 1000000 / (int64_t)due);
+    fn0 = fn; cyc0 = cyc;
+    if (ppm > FRAME_TRIM_MAX_PPM || ppm < -FRAME_TRIM_MAX_PPM) {
+        stats.rejected++;
+        return;
+    }
+    stats.last_ppm = ppm;
+    stats.ppm      = stats.windows ? stats.ppm + (ppm - stats.ppm) / 4 : ppm;
+    if (++stats.windows >= 2) {
+        frame_clock_set_trim(stats.ppm);
+        stats.locked = true;
+    }
+}
+
+const SofLockStats *sof_lock_stats(void)
+{
+    return &stats;
+}
+
+#endif /* FRAME_SOF_LOCK */
@@ -0,0 +1,62 @@
+/*
+ * sof_lock.h – frame clock rate locked to the host's USB start of frame
+ *
+ * The host controller sends a start of frame every millisecond, numbered,
+ * on its own crystal. The SOF interrupt (usbd_conf.c) stamps each with
+ * DWT->CYCCNT; over SOF_LOCK_MS of them the cycles counted against the
+ * cycles due tell how many ppm our crystal runs off the host's, and the
+ * frame clock is trimmed by that (frame_clock_set_trim), filtered over a
+ * few windows. A host that streams frames at n × 1 ms of its USB clock and
+ * the device then run at exactly the same rate: no frame doubled or
+ * dropped every few minutes, the stream's latency stays where it started.
+ *
+ * Rate only. The phase onto a host's frame grid is frame_sync.h's (PKT_SYNC),
+ * which has less to correct with the rates matched. A window with SOFs
+ * missing (suspend, bus reset, a long masked section) is thrown away.
+ */
+
+#ifndef _SOF_LOCK_H_
+#define _SOF_LOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* SOFs per measurement, under 2048 (the 11 bit frame number) */
+#ifndef SOF_LOCK_MS
+  #define SOF_LOCK_MS   1024
+#endif
+
+typedef struct {
+    uint32_t windows;       /* measured and taken                          */
+    uint32_t rejected;      /* thrown away: SOFs lost or out of range       */
+    int32_t  ppm;           /* our clock against the host's, filtered       */
+    int32_t  last_ppm;      /* the last window's                            */
+    bool     locked;        /* the frame clock is trimmed                   */
+} SofLockStats;
+
+#ifdef FRAME_SOF_LOCK
+
+/**
+ * From the SOF interrupt (HAL_PCD_SOFCallback)
+ */
+void sof_lock_isr(void);
+
+const SofLockStats *sof_lock_stats(void);
+
+#else
+
+#define sof_lock_isr()      ((void)0)
+#define sof_lock_stats()    ((const SofLockStats *)0)
+
+#endif /* FRAME_SOF_LOCK */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SOF_LOCK_H_ */
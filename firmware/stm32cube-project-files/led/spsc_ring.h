@@ -0,0 +1,72 @@
+/*
+ * spsc_ring.h – lock-free byte ring, one producer (ISR) and one consumer
+ *
+ * head and tail run freely (uint16_t) and are masked on use, the size is a
+ * power of two so full and empty never look alike. Only the producer moves
+ * head, only the consumer tail; each publishes its index after a DMB, so
+ * the other side never sees an index ahead of the bytes it covers. No
+ * interrupt masking, nothing blocks: a push that does not fit is cut short
+ * and the caller counts the loss.
+ */
+
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"     /* __DMB */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t           *buf;
+    uint16_t           mask;        /* size - 1 */
+    volatile uint16_t  head;        /* producer: next byte written */
+    volatile uint16_t  tail;        /* consumer: next byte read    */
+} SpscRing;
+
+/* static storage of n bytes (a power of two, at most 32768) */
+#define SPSC_RING(name, n)                                                      \
+    _Static_assert((n) && !((n) & ((n) - 1)) && (n) <= 32768, #name ": size"); \
+    static uint8_t name##_buf[n];                                               \
+    static SpscRing name = { name##_buf, (n) - 1, 0, 0 }
+
+static inline uint16_t spsc_used(const SpscRing *r) { return (uint16_t)(r->head - r->tail); }
+
+/**
+ * Producer: append up to n bytes
+ * @return bytes taken (< n: ring full)
+ */
+static inline uint16_t spsc_push(SpscRing *r, const uint8_t *src, uint16_t n)
+{
+    uint16_t h    = r->head;
+    uint16_t room = (uint16_t)(r->mask + 1u - (uint16_t)(h - r->tail));
+    if (n > room) n = room;
+    for (uint16_t i = 0; i < n; ++i) r->buf[(uint16_t)(h + i) & r->mask] = src[i];
+    __DMB();                        /* bytes land before head moves */
+    r->head = (uint16_t)(h + n);
+    return n;
+}
+
+/**
+ * Consumer: take up to n bytes
+ * @return bytes read (0: empty)
+ */
+static inline uint16_t spsc_pop(SpscRing *r, uint8_t *dst, uint16_t n)
+{
+    uint16_t t     = r->tail;
+    uint16_t avail = (uint16_t)(r->head - t);
+    __DMB();                        /* head read before the bytes it covers */
+    if (n > avail) n = avail;
+    for (uint16_t i = 0; i < n; ++i) dst[i] = r->buf[(uint16_t)(t + i) & r->mask];
+    __DMB();                        /* bytes read before the slots are handed back */
+    r->tail = (uint16_t)(t + n);
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SPSC_RING_H_ */
@@ -0,0 +1,128 @@
+/* --------------------------------------------------------------------------
+ * stack_mon.c – painted stacks, scanned for their high water
+ * -------------------------------------------------------------------------- */
+#include <stddef.h>
+#include "stack_mon.h"
+#include "usb_comms.h"       /* USBD_UsrLog() */
+#include "stm32f4xx_hal.h"   /* __get_MSP, __set_PSP, __set_CONTROL */
+
+extern uint8_t _estack;
+extern void *_sbrk(ptrdiff_t incr);   /* sysmem.c */
+
+#define STACK_PAINT     0xC5C5C5C5u
+#define STACK_MARGIN    256u         /* below the painting frame: its callees */
+#define PAINT_MAX       (64u * 1024u)
+
+static volatile uint32_t *paint_lo, *paint_hi;   /* main's painted span */
+
+#ifdef STACK_IRQ_BYTES
+static uint32_t irq_stack[STACK_IRQ_BYTES / 4] __attribute__((aligned(8)));   /* AAPCS */
+#endif
+
+static volatile uint32_t *brk_word(void)
+{
+    return (volatile uint32_t *)(((uintptr_t)_sbrk(0) + 3u) & ~(uintptr_t)3u);
+}
+
+/* the heap break up to STACK_MARGIN below the caller */
+static void paint_main(void)
+{
+    volatile uint32_t here = 0;
+    volatile uint32_t *lo = brk_word();
+    volatile uint32_t *hi = (volatile uint32_t *)((uintptr_t)&here & ~(uintptr_t)3u) - STACK_MARGIN / 4u;
+
+    paint_lo = NULL;
+    if (lo >= hi || (uintptr_t)(hi - lo) * 4u > PAINT_MAX) return;   /* not one RAM block (host build) */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();                /* an interrupt's frame below us stays intact */
+    for (volatile uint32_t *p = lo; p < hi; ++p) *p = STACK_PAINT;
+    __set_PRIMASK(primask);
+    paint_lo = lo;
+    paint_hi = hi;
+}
+
+/* first word that lost the paint, scanning up from p */
+static const volatile uint32_t *first_used(const volatile uint32_t *p, const volatile uint32_t *end)
+{
+    while (p < end && *p == STACK_PAINT) ++p;
+    return p;
+}
+
+#ifdef STACK_IRQ_BYTES
+/* all of it: only from thread mode, with no handler on it */
+static void paint_irq(void)
+{
+    for (uint32_t i = 0; i < STACK_IRQ_BYTES / 4; ++i) irq_stack[i] = STACK_PAINT;
+}
+#endif
+
+void stack_init(void)
+{
+#ifdef STACK_IRQ_BYTES
+    paint_irq();
+
+    /* thread mode onto the PSP at the very same address, handlers onto the
+     * fresh MSP: nothing on the stack moves, our own frame returns through
+     * the PSP */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    __set_PSP(__get_MSP());
+    __set_CONTROL(__get_CONTROL() | CONTROL_SPSEL_Msk);
+    __ISB();
+    __set_MSP((uint32_t)(uintptr_t)&irq_stack[STACK_IRQ_BYTES / 4]);
+    __set_PRIMASK(primask);
+#endif
+    paint_main();
+}
+
+void stack_repaint(void)
+{
+#ifdef STACK_IRQ_BYTES
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();                /* no handler is on it while they are off */
+    paint_irq();
+    __set_PRIMASK(primask);
+#endif
+    paint_main();
+}
+
+uint32_t stack_main_peak(void)
+{
+    if (!paint_lo) return 0;
+    const volatile uint32_t *p = brk_word();
+    if (p < paint_lo) p = paint_lo;
+    return (uint32_t)(&_estack - (const volatile uint8_t *)first_used(p, paint_hi));
+}
+
+uint32_t stack_irq_peak(void)
+{
+#ifdef STACK_IRQ_BYTES
+    const uint32_t *end = &irq_stack[STACK_IRQ_BYTES / 4];
+    return (uint32_t)((const uint8_t *)end - (const uint8_t *)first_used(irq_stack, end));
+#else
+    return 0;
+#endif
+}
+
+uint32_t stack_main_room(void)
+{
+    if (!paint_lo) return 0;
+    const volatile uint32_t *p = brk_word();
+    if (p < paint_lo) p = paint_lo;
+    return (uint32_t)((const volatile uint8_t *)first_used(p, paint_hi) - (const volatile uint8_t *)p);
+}
+
+void stack_report(void)
+{
+    uint32_t room = stack_main_room();
+#ifdef STACK_IRQ_BYTES
+    USBD_UsrLog("stack: main %lu B peak, %lu.%lu kB never touched above the heap, irq %lu of %u B\n",
+                (unsigned long)stack_main_peak(), (unsigned long)(room / 1024u),
+                (unsigned long)(room % 1024u * 10u / 1024u),
+                (unsigned long)stack_irq_peak(), (unsigned)STACK_IRQ_BYTES);
+#else
+    USBD_UsrLog("stack: %lu B peak (main and interrupts), %lu.%lu kB never touched above the heap\n",
+                (unsigned long)stack_main_peak(), (unsigned long)(room / 1024u),
+                (unsigned long)(room % 1024u * 10u / 1024u));
+#endif
+}
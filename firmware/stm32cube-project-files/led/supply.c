@@ -0,0 +1,146 @@
+/* --------------------------------------------------------------------------
+ * supply.c – ADC1 scan of supply and current, DMA2 stream 0 circular, the
+ *            limiter's feedback (supply.h)
+ * -------------------------------------------------------------------------- */
+#include "supply.h"
+
+#ifdef LED_SUPPLY_MON
+
+#ifndef LED_POWER_LIMIT_MA
+#error "LED_SUPPLY_MON corrects the LED_POWER_LIMIT_MA limiter, define both"
+#endif
+#ifdef LED_AUDIO
+#error "LED_SUPPLY_MON and LED_AUDIO both want ADC1"
+#endif
+
+#include "led_render.h"      /* render_power_estimate_ma, render_power_feedback */
+#include "usb_comms.h"       /* USBD_UsrLog() */
+#include "stm32f4xx_hal.h"
+
+_Static_assert(SUPPLY_V_CH <= 9 && SUPPLY_I_CH <= 9 && SUPPLY_V_CH != SUPPLY_I_CH,
+               "SUPPLY_V_CH / SUPPLY_I_CH: two of 0 … 9 (PA0 … PA7, PB0, PB1)");
+_Static_assert(SUPPLY_I_ZERO < 4095, "SUPPLY_I_ZERO: counts at 0 A, under full scale");
+
+#define SUPPLY_DMA        DMA2_Stream0
+/* all interrupt flags of stream 0 (FEIF, DMEIF, TEIF, HTIF, TCIF) in LISR */
+#define SUPPLY_DMA_FLAGS  0x3Du
+
+static volatile uint16_t ring[2 * SUPPLY_SAMPLES];   /* V, I, V, I, ... */
+static SupplyStats       stats;
+static uint32_t          mv_q4, ma_q4;               /* filtered, 1/16 mV / mA */
+static int32_t           gain_q16;                   /* gain_q8's filter, 65536 = 1 */
+static uint32_t          budget;
+static uint32_t          last_ms;
+
+static void pin_analog(uint8_t ch)
+{
+    if (ch < 8) {
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+        GPIOA->MODER |= 3u << (2 * ch);
+    } else {
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+        GPIOB->MODER |= 3u << (2 * (ch - 8));
+    }
+}
+
+void supply_init(void)
+{
+    pin_analog(SUPPLY_V_CH);
+    pin_analog(SUPPLY_I_CH);
+    __HAL_RCC_ADC1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    /* ADC clock PCLK2 / 4 (21 MHz), 480 cycles sampling: 23 µs a
+     * conversion, divider and sensor outputs settle, ~1 % of DMA2's time */
+    ADC->CCR    = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0;
+    ADC1->CR2   = 0;
+    ADC1->CR1   = ADC_CR1_SCAN;                             /* 12 bit, the sequence */
+    ADC1->SMPR2 = (7u << (3 * SUPPLY_V_CH)) | (7u << (3 * SUPPLY_I_CH));
+    ADC1->SQR1  = 1u << ADC_SQR1_L_Pos;                     /* two conversions */
+    ADC1->SQR3  = SUPPLY_V_CH | (SUPPLY_I_CH << 5);
+
+    SUPPLY_DMA->CR &= ~DMA_SxCR_EN;
+    while (SUPPLY_DMA->CR & DMA_SxCR_EN) { }
+    SUPPLY_DMA->PAR  = (uint32_t)&ADC1->DR;
+    SUPPLY_DMA->M0AR = (uint32_t)ring;
+    SUPPLY_DMA->NDTR = 2 * SUPPLY_SAMPLES;
+    SUPPLY_DMA->FCR  = 0;                                   /* direct mode */
+    DMA2->LIFCR      = SUPPLY_DMA_FLAGS;
+    SUPPLY_DMA->CR   = (0u << DMA_SxCR_CHSEL_Pos)           /* channel 0: ADC1 */
+                     | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0  /* low priority, no interrupts */
+                     | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_EN;
+
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_CONT;
+    for (volatile uint32_t i = 0; i < 100; ++i) { }         /* tSTAB, 3 µs */
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+
+    budget       = LED_POWER_LIMIT_MA;
+    mv_q4        = ma_q4 = 0;
+    stats        = (SupplyStats){ 0 };
+    stats.gain_q8 = 256;
+    gain_q16      = 256 << 8;
+    stats.min_mv  = UINT16_MAX;
+    last_ms      = HAL_GetTick();
+}
+
+static inline uint16_t sat16(uint32_t v) { return (uint16_t)(v > UINT16_MAX ? UINT16_MAX : v); }
+
+void supply_tick(void)
+{
+    uint32_t now = HAL_GetTick();
+    if (now - last_ms < SUPPLY_TICK_MS) return;
+    last_ms = now;
+
+    /* the ring as it stands, pairs in any phase: it is a mean anyway */
+    uint32_t sv = 0, si = 0;
+    for (uint16_t k = 0; k < 2 * SUPPLY_SAMPLES; k += 2) {
+        sv += ring[k];
+        si += ring[k + 1];
+    }
+    const uint32_t mv = (uint32_t)((uint64_t)sv * SUPPLY_V_FS_MV / (4095u * SUPPLY_SAMPLES));
+    const int32_t  ci = (int32_t)(si / SUPPLY_SAMPLES) - SUPPLY_I_ZERO;
+    const uint32_t ma = ci > 0 ? (uint32_t)ci * SUPPLY_I_FS_MA / (4095u - SUPPLY_I_ZERO) : 0;
+
+    /* a quarter per tick: ~40 ms to settle, the LED PWM ripple gone */
+    if (!mv_q4) { mv_q4 = mv << 4; ma_q4 = ma << 4; }
+    mv_q4 += (int32_t)((mv << 4) - mv_q4) / 4;
+    ma_q4 += (int32_t)((ma << 4) - ma_q4) / 4;
+    stats.mv = sat16(mv_q4 >> 4);
+    stats.ma = sat16(ma_q4 >> 4);
+    if (stats.mv < stats.min_mv) stats.min_mv = stats.mv;
+
+    /* the model against the measurement, slowly: a few seconds */
+    const uint32_t model = render_power_estimate_ma();
+    stats.model_ma = sat16(model);
+    if (model >= SUPPLY_GAIN_MIN_MA) {
+        int32_t g = (int32_t)(((uint64_t)stats.ma << 8) / model);
+        if (g < 128) g = 128;
+        if (g > 512) g = 512;
+        gain_q16     += ((g << 8) - gain_q16) / 32;     /* 8 more bits: settles on g, no dead band */
+        stats.gain_q8 = (uint16_t)((gain_q16 + 128) >> 8);
+    }
+
+    /* sagging: hold the budget under what is drawn now, climb back slowly */
+    if (stats.mv < SUPPLY_V_MIN_MV) {
+        uint32_t cap = stats.ma * 7u / 8u;
+        if (cap < SUPPLY_BUDGET_MIN_MA) cap = SUPPLY_BUDGET_MIN_MA;
+        if (cap < budget) budget = cap;
+        stats.sags++;
+    } else if (budget < LED_POWER_LIMIT_MA) {
+        budget += SUPPLY_BUDGET_RISE_MA;
+        if (budget > LED_POWER_LIMIT_MA) budget = LED_POWER_LIMIT_MA;
+    }
+    stats.budget_ma = sat16(budget);
+    render_power_feedback(stats.gain_q8, budget);
+}
+
+const SupplyStats *supply_stats(void) { return &stats; }
+
+void supply_report(void)
+{
+    USBD_UsrLog("supply: %u mV (min %u), %u mA, model %u mA x %u/256, budget %u mA, %lu sag ticks\n",
+                stats.mv, stats.min_mv, stats.ma, stats.model_ma, stats.gain_q8,
+                stats.budget_ma, (unsigned long)stats.sags);
+}
+
+#endif /* LED_SUPPLY_MON */
@@ -0,0 +1,123 @@
+/*
+ * supply.h – LED supply voltage and current, closing the power limiter's
+ *            loop (LED_SUPPLY_MON)
+ *
+ * ADC1 converts two channels back to back, continuously: the supply through
+ * a divider (SUPPLY_V_CH) and a current sensor's output (SUPPLY_I_CH, a
+ * shunt amplifier or a Hall sensor). DMA2 stream 0 writes the pairs round a
+ * circular buffer of SUPPLY_SAMPLES, no interrupts: the CPU only sees the
+ * buffer when supply_tick() averages it, every SUPPLY_TICK_MS.
+ *
+ * The current drawn is the truth the LED_POWER_LIMIT_MA model is held to:
+ * the measured / modelled ratio (render_power_estimate_ma()), slowly
+ * filtered, scales the model (render_power_feedback()), so strips that draw
+ * more or less than LED_MA_PER_CHANNEL says, with age or temperature, get
+ * the brightness that really fits the budget. A supply sagging under
+ * SUPPLY_V_MIN_MV caps the budget just below what is drawn right then, it
+ * climbs back by SUPPLY_BUDGET_RISE_MA a tick: the PSU is held short of a
+ * brownout, whatever its rating says. Both act through the fused brightness
+ * LUT, the next frame is encoded with the corrected level.
+ *
+ * Scaling: 4095 counts on SUPPLY_V_CH are SUPPLY_V_FS_MV of supply (the
+ * divider's ratio × 3.3 V), SUPPLY_I_ZERO counts are 0 A (mid supply for a
+ * bidirectional Hall sensor, 0 for a shunt amplifier) and 4095 counts are
+ * SUPPLY_I_FS_MA. Pins: channels 0 … 7 are PA0 … PA7, 8 / 9 PB0 / PB1.
+ *
+ * The readings go out with the telemetry packet, "supply" prints them.
+ * Needs LED_POWER_LIMIT_MA; ADC1 is the audio input's, not with LED_AUDIO.
+ */
+
+#ifndef _SUPPLY_H_
+#define _SUPPLY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ADC1 input channels */
+#ifndef SUPPLY_V_CH
+  #define SUPPLY_V_CH           8
+#endif
+#ifndef SUPPLY_I_CH
+  #define SUPPLY_I_CH           9
+#endif
+/* scaling, see above: a 2:1 divider on 5 V, 5 mΩ into a gain 20 amplifier */
+#ifndef SUPPLY_V_FS_MV
+  #define SUPPLY_V_FS_MV        6600
+#endif
+#ifndef SUPPLY_I_ZERO
+  #define SUPPLY_I_ZERO         0
+#endif
+#ifndef SUPPLY_I_FS_MA
+  #define SUPPLY_I_FS_MA        33000
+#endif
+/* pairs in the ring: 23 µs a conversion, 128 pairs span ~6 ms of LED PWM */
+#ifndef SUPPLY_SAMPLES
+  #define SUPPLY_SAMPLES        128
+#endif
+#ifndef SUPPLY_TICK_MS
+  #define SUPPLY_TICK_MS        10
+#endif
+/* supply under this sags: cap the budget below the current drawn */
+#ifndef SUPPLY_V_MIN_MV
+  #define SUPPLY_V_MIN_MV       4600
+#endif
+/* budget regained per tick after a sag, and never capped under this */
+#ifndef SUPPLY_BUDGET_RISE_MA
+  #define SUPPLY_BUDGET_RISE_MA 50
+#endif
+#ifndef SUPPLY_BUDGET_MIN_MA
+  #define SUPPLY_BUDGET_MIN_MA  500
+#endif
+/* the model is only corrected above this much modelled current (a ratio of
+ * small numbers is mostly noise), within 1/2 … 2 */
+#ifndef SUPPLY_GAIN_MIN_MA
+  #define SUPPLY_GAIN_MIN_MA    1000
+#endif
+
+typedef struct {
+    uint16_t mv;            /* supply, filtered                    */
+    uint16_t ma;            /* current, filtered                   */
+    uint16_t model_ma;      /* the limiter's estimate at that time */
+    uint16_t gain_q8;       /* measured / modelled, 256 = 1        */
+    uint16_t budget_ma;     /* what the limiter holds to now       */
+    uint16_t min_mv;        /* lowest filtered supply since boot   */
+    uint32_t sags;          /* ticks under SUPPLY_V_MIN_MV         */
+} SupplyStats;
+
+#ifdef LED_SUPPLY_MON
+
+/**
+ * Start the conversions (ADC1, DMA2 stream 0)
+ */
+void supply_init(void);
+
+/**
+ * Main loop: every SUPPLY_TICK_MS averages the ring, filters, corrects the
+ * limiter
+ */
+void supply_tick(void);
+
+const SupplyStats *supply_stats(void);
+
+/**
+ * The readings (USBD_UsrLog)
+ */
+void supply_report(void);
+
+#else
+
+#define supply_init()           ((void)0)
+#define supply_tick()           ((void)0)
+
+#endif /* LED_SUPPLY_MON */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SUPPLY_H_ */
@@ -0,0 +1,153 @@
+/* --------------------------------------------------------------------------
+ * telemetry.c – PKT_TELEMETRY, profiler zones and health counters
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include <stddef.h>
+#include "telemetry.h"
+#include "profiler.h"        /* prof_last */
+#include "frame_clock.h"     /* frames, late, missed */
+#include "usb_comms.h"       /* usb_tx_dropped */
+#include "usb_packet.h"      /* usb_packet_send, rx overrun */
+#include "led_render.h"      /* render_dma_errors, strip counters */
+#include "stack_mon.h"       /* stack peaks */
+#include "rtos_app.h"        /* rtos_task_stats (LED_RTOS) */
+#include "supply.h"          /* supply_stats (LED_SUPPLY_MON) */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick */
+
+extern uint8_t  _end;            /* linker script: heap start */
+extern uint8_t  _estack;
+extern uint32_t _Min_Stack_Size;
+extern void *_sbrk(ptrdiff_t incr);   /* sysmem.c */
+
+#ifdef LED_PROFILE
+  #define TELEM_ZONES   PROF_ZONE_COUNT
+#else
+  #define TELEM_ZONES   0
+#endif
+
+#ifdef LED_RTOS
+  #define TELEM_TASKS   RTOS_TASK_COUNT
+#else
+  #define TELEM_TASKS   0
+#endif
+
+#ifdef LED_SUPPLY_MON
+  #define TELEM_SUPPLY  1
+#else
+  #define TELEM_SUPPLY  0
+#endif
+
+/* layouts: tools/protocol.def (TelemHead, TelemZone, TelemTask, TelemBus, TelemSupply) */
+#define TELEM_SIZE      (PROTO_TELEM_HEAD_SIZE + PROTO_TELEM_ZONE_SIZE * TELEM_ZONES \
+                         + 1u + PROTO_TELEM_TASK_SIZE * TELEM_TASKS \
+                         + 1u + PROTO_TELEM_BUS_SIZE * TELEM_BUSES \
+                         + 1u + PROTO_TELEM_SUPPLY_SIZE * TELEM_SUPPLY)
+
+_Static_assert(TELEM_SIZE <= PKT_PAYLOAD_MAX, "telemetry packet does not fit, fewer profiler zones");
+
+static uint16_t interval = TELEM_INTERVAL_MS;
+static uint32_t last_sent;
+static uint32_t last_frames;
+
+static uint8_t *put16(uint8_t *p, uint32_t v)
+{
+    uint16_t h = (uint16_t)(v > UINT16_MAX ? UINT16_MAX : v);
+    memcpy(p, &h, 2);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+    return p + 4;
+}
+
+void telemetry_tick(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t dt  = now - last_sent;
+    if (!interval || dt < interval) return;
+    last_sent = now;
+
+    const FrameClockStats *fc = frame_clock_stats();
+    uint32_t frames = fc->frames - last_frames;
+    last_frames     = fc->frames;
+
+    uint8_t *brk  = (uint8_t *)_sbrk(0);
+    uint8_t *top  = &_estack - (uint32_t)&_Min_Stack_Size;
+
+    uint8_t  b[TELEM_SIZE];
+    uint8_t *p = b;
+    *p++ = TELEM_VERSION;
+    *p++ = TELEM_ZONES;
+#ifdef LED_PROFILE
+    p = put16(p, PROF_WINDOW_MS);
+#else
+    p = put16(p, 0);
+#endif
+    p = put32(p, now);
+    p = put16(p, frames * 100000u / dt);
+    p = put32(p, fc->late);
+    p = put32(p, fc->missed);
+    p = put32(p, usb_tx_dropped(TX_CH_TEXT));
+    p = put32(p, usb_tx_dropped(TX_CH_PACKET));
+    p = put32(p, usb_packet_stats()->overrun);
+    p = put32(p, render_dma_errors());
+    p = put32(p, (uint32_t)(brk - &_end));
+    p = put32(p, (uint32_t)(top - brk));
+    p = put16(p, stack_main_peak());
+    p = put16(p, stack_irq_peak());
+
+#ifdef LED_PROFILE
+    for (uint8_t z = 0; z < PROF_ZONE_COUNT; ++z) {
+        const ProfSummary *s = prof_last((ProfZone)z);
+        p = put16(p, s->calls);
+        p = put16(p, s->overruns);
+        p = put16(p, s->min_us);
+        p = put16(p, s->avg_us);
+        p = put16(p, s->p99_us);
+        p = put16(p, s->max_us);
+    }
+#endif
+    *p++ = TELEM_TASKS;
+#ifdef LED_RTOS
+    RtosTaskStat ts[RTOS_TASK_COUNT];
+    rtos_task_stats(ts);
+    for (uint8_t t = 0; t < RTOS_TASK_COUNT; ++t) {
+        p = put16(p, ts[t].cpu_permille);
+        p = put16(p, ts[t].stack_free);
+    }
+#endif
+    uint8_t buses = render_strip_count();
+    if (buses > TELEM_BUSES) buses = TELEM_BUSES;
+    *p++ = buses;
+    for (uint8_t s = 0; s < buses; ++s) {
+        const StripInfo *si = render_strip_info(s);
+        p = put32(p, si->transfers);
+        p = put16(p, si->errors);
+        p = put16(p, si->timeouts);
+        p = put16(p, si->max_us);
+    }
+    *p++ = TELEM_SUPPLY;
+#ifdef LED_SUPPLY_MON
+    const SupplyStats *sp = supply_stats();
+    p = put16(p, sp->mv);
+    p = put16(p, sp->ma);
+    p = put16(p, sp->model_ma);
+    p = put16(p, sp->gain_q8);
+    p = put16(p, sp->budget_ma);
+    p = put16(p, sp->min_mv);
+    p = put16(p, sp->sags);
+#endif
+    usb_packet_send(PKT_TELEMETRY, b, (uint8_t)(p - b));
+}
+
+void telemetry_set_interval(uint16_t ms)
+{
+    interval = ms;
+}
+
+uint16_t telemetry_interval(void)
+{
+    return interval;
+}
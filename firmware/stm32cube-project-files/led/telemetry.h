@@ -0,0 +1,70 @@
+/*
+ * telemetry.h – the numbers the app shows, as one binary packet
+ *
+ * telemetry_tick() sends a PKT_TELEMETRY packet (usb_packet.h) every
+ * telemetry interval, TELEM_INTERVAL_MS at boot, "telem <ms>" at runtime
+ * (0 stops it). The app decodes it with struct.unpack (app/telemetry.py),
+ * nothing to scrape out of the log. Payload, little endian:
+ *
+ *   version u8 (TELEM_VERSION) | zones u8 | window_ms u16
+ *   uptime_ms u32 | fps_x100 u16 | frames_late u32 | frames_missed u32
+ *   tx_dropped u32 [text, packet] | rx_overrun u32 | dma_errors u32
+ *   heap_peak u32 | heap_left u32 | stack_peak u16 | irq_stack_peak u16
+ *   zones × { calls, overruns, min_us, avg_us, p99_us, max_us } u16 each
+ *   tasks u8 | tasks × { cpu_permille, stack_free } u16 each
+ *   buses u8 | buses × { transfers u32, errors u16, timeouts u16, max_us u16 }
+ *   supply u8 | supply × { mv, ma, model_ma, gain_q8, budget_ma, min_mv, sags } u16 each
+ *
+ * The zone stats are the profiler's last closed window (window_ms long,
+ * LED_PROFILE, 0 zones without it), saturated at 65535. fps counts frame
+ * clock ticks since the last packet; the counters run from boot. heap_peak
+ * is the newlib break above _end (it never moves back), heap_left the room
+ * from there to the reserved stack. The stack peaks are stack_mon.h's
+ * (main loop, interrupts; 0 where not measured). The tasks are the LED_RTOS
+ * build's (rtos_app.h, RTOS_TASKS order and idle), CPU share since the last
+ * packet and stack bytes never used; 0 tasks in the bare-metal build. The
+ * buses are the output strips (render_strip_info(), one with LED_OUTPUT_
+ * GPIO): transfers completed, errors, hung ones the DMA watchdog aborted
+ * and the longest transfer, all from boot. supply is 1 with LED_SUPPLY_MON
+ * (supply.h): the measured supply and current, what the limiter modelled,
+ * the correction and the budget it holds to now.
+ */
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEM_VERSION           5
+
+/* strips (DMA buses) in the packet at most, the first ones */
+#ifndef TELEM_BUSES
+  #define TELEM_BUSES           8
+#endif
+
+#ifndef TELEM_INTERVAL_MS
+  #define TELEM_INTERVAL_MS     200
+#endif
+
+/**
+ * Call once per main loop pass: sends the packet when due.
+ */
+void telemetry_tick(void);
+
+/**
+ * Packet interval in ms, 0 = off
+ */
+void     telemetry_set_interval(uint16_t ms);
+uint16_t telemetry_interval(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TELEMETRY_H_ */
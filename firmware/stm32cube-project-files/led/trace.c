@@ -0,0 +1,100 @@
+/* --------------------------------------------------------------------------
+ * trace.c – ring of timestamped events, dumped as hex over USB CDC
+ * -------------------------------------------------------------------------- */
+#include "trace.h"
+
+#ifdef LED_TRACE
+
+#include <stdio.h>
+#include "stm32f4xx_hal.h"
+#include "usb_comms.h"   /* USBD_UsrLog(), usb_tx_room() */
+#include "itm.h"         /* live on ITM_PORT_TRACE (LED_ITM) */
+
+#define RECS_PER_LINE   8              /* 8 x 16 hex digits per line */
+#define LINE_ROOM       (RECS_PER_LINE * 16 + 16)
+
+static TraceRecord    ring[TRACE_DEPTH];
+static uint32_t       head    = 0;     /* total records written, ring[head % DEPTH] is next */
+static volatile bool  frozen  = false;
+
+/* dump progress */
+static bool           dumping = false;
+static uint32_t       dump_pos, dump_end;
+
+void trace_log(TraceEvent ev, uint8_t phase, uint16_t arg)
+{
+    uint8_t flags = phase;
+    if (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) flags |= TRACE_FLAG_ISR;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t cyc = DWT->CYCCNT;
+#ifdef LED_ITM
+    /* live, a dump running or not; both words under the mask, no other
+     * event between them */
+    itm_put32(ITM_PORT_TRACE, cyc);
+    itm_put32(ITM_PORT_TRACE, (uint32_t)ev | (uint32_t)flags << 8 | (uint32_t)arg << 16);
+#endif
+    if (!frozen) {
+        TraceRecord *r = &ring[head % TRACE_DEPTH];
+        head++;
+        r->cyc   = cyc;
+        r->event = (uint8_t)ev;
+        r->flags = flags;
+        r->arg   = arg;
+    }
+    __set_PRIMASK(primask);
+}
+
+void trace_dump_start(void)
+{
+    if (dumping) return;
+    frozen   = true;
+    dumping  = true;
+    dump_end = head;
+    dump_pos = (head > TRACE_DEPTH) ? head - TRACE_DEPTH : 0;   /* oldest still in the ring */
+
+    USBD_UsrLog("#trace# n=%lu hz=%lu#",
+                (unsigned long)(dump_end - dump_pos), (unsigned long)SystemCoreClock);
+}
+
+void trace_freeze(void)
+{
+    frozen = true;
+}
+
+void trace_thaw(void)
+{
+    if (!dumping) frozen = false;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Records go out little-endian as they sit in memory, cyc / event / flags / arg
+ */
+void trace_tick(void)
+{
+    if (!dumping) return;
+
+    while (dump_pos < dump_end && usb_tx_room() > LINE_ROOM) {
+        char     line[LINE_ROOM];
+        size_t   off = 0;
+        off += snprintf(line, sizeof line, "#tr ");
+        for (uint8_t k = 0; k < RECS_PER_LINE && dump_pos < dump_end; ++k, ++dump_pos) {
+            const uint8_t *b = (const uint8_t *)&ring[dump_pos % TRACE_DEPTH];
+            for (uint8_t i = 0; i < sizeof(TraceRecord); ++i) {
+                off += snprintf(line + off, sizeof line - off, "%02x", b[i]);
+            }
+        }
+        snprintf(line + off, sizeof line - off, "#");
+        USBD_UsrLog("%s", line);
+    }
+
+    if (dump_pos >= dump_end && usb_tx_room() > LINE_ROOM) {
+        USBD_UsrLog("#endtrace#");
+        dumping = false;
+        head    = 0;                 /* next capture starts clean */
+        frozen  = false;
+    }
+}
+
+#endif /* LED_TRACE */
@@ -0,0 +1,107 @@
+/*
+ * trace.h – on-device timeline of begin / end events (LED_TRACE)
+ *
+ * A fixed ring of TRACE_DEPTH 8-byte records (DWT timestamp, event, phase,
+ * arg) that keeps overwriting the oldest entry. The "trace" command freezes
+ * it and trace_tick() streams it out as hex lines between #trace# and
+ * #endtrace#, the host app turns that into a Chrome trace / Perfetto JSON.
+ * Without LED_TRACE every TRACE_* macro compiles to nothing.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* events, the order is the id the host sees (keep app/trace_export.py in sync) */
+#define TRACE_EVENTS(X)  \
+    X(ANIM)              \
+    X(FADE)              \
+    X(ENCODE)            \
+    X(SUBMIT)            \
+    X(DMA_WAIT)          \
+    X(USB)               \
+    X(USB_FLUSH)         \
+    X(SPI_DMA)           \
+    X(CDC_RX)            \
+    X(CDC_TX)            \
+    X(SLEEP)             \
+    X(AUDIO)
+
+typedef enum {
+#define TRACE_ENUM(name) TRACE_##name,
+    TRACE_EVENTS(TRACE_ENUM)
+#undef TRACE_ENUM
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+/* record flags: phase in bits 0..1, set bit 7 when logged from an ISR */
+#define TRACE_PH_BEGIN    0u
+#define TRACE_PH_END      1u
+#define TRACE_PH_INSTANT  2u
+#define TRACE_FLAG_ISR    0x80u
+
+#ifndef TRACE_DEPTH
+  #define TRACE_DEPTH     512          /* records, 8 bytes each */
+#endif
+
+#ifdef LED_TRACE
+
+typedef struct {
+    uint32_t cyc;          /* DWT->CYCCNT */
+    uint8_t  event;        /* TraceEvent */
+    uint8_t  flags;        /* phase | TRACE_FLAG_ISR */
+    uint16_t arg;          /* e.g. strip index */
+} TraceRecord;
+
+#define TRACE_BEGIN(ev, arg)    trace_log(TRACE_##ev, TRACE_PH_BEGIN,   (arg))
+#define TRACE_END(ev, arg)      trace_log(TRACE_##ev, TRACE_PH_END,     (arg))
+#define TRACE_INSTANT(ev, arg)  trace_log(TRACE_##ev, TRACE_PH_INSTANT, (arg))
+
+/**
+ * Append one record (any context, ISR safe). Dropped while a dump runs,
+ * with LED_ITM it goes out on ITM_PORT_TRACE as well (itm.h).
+ */
+void trace_log(TraceEvent ev, uint8_t phase, uint16_t arg);
+
+/**
+ * Freeze the ring and start streaming it out ("trace" command).
+ */
+void trace_dump_start(void);
+
+/**
+ * Stop / resume recording without a dump (blackbox.h holds the ring with
+ * its capture); a dump thaws it when it is through.
+ */
+void trace_freeze(void);
+void trace_thaw(void);
+
+/**
+ * Main loop: emits as many dump lines as the USB TX ring has room for,
+ * recording resumes once the dump is through.
+ */
+void trace_tick(void);
+
+#else
+
+#define TRACE_BEGIN(ev, arg)    ((void)0)
+#define TRACE_END(ev, arg)      ((void)0)
+#define TRACE_INSTANT(ev, arg)  ((void)0)
+#define trace_dump_start()      ((void)0)
+#define trace_freeze()          ((void)0)
+#define trace_thaw()            ((void)0)
+#define trace_tick()            ((void)0)
+
+#endif /* LED_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRACE_H_ */
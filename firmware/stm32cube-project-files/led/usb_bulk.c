@@ -0,0 +1,268 @@
+/* --------------------------------------------------------------------------
+ * usb_bulk.c – composite class: the CDC console and a vendor bulk pipe
+ * -------------------------------------------------------------------------- */
+#include "usb_bulk.h"
+
+#ifdef USB_BULK
+
+#include "usb_comms.h"       /* usb_comms_receive, usb_tx_pipe_done */
+#include "led_stream.h"      /* stream_rx_target */
+#include "usbd_cdc.h"
+#include "usbd_ctlreq.h"     /* USBD_CtlError */
+#include "stm32f4xx_hal.h"   /* HAL_GetTick, HAL_PCDEx_SetTx/RxFiFo */
+
+extern PCD_HandleTypeDef hpcd_USB_OTG_FS;   /* usbd_conf.c */
+extern uint8_t           USBD_FS_DeviceDesc[];  /* usbd_desc.c */
+extern USBD_DescriptorsTypeDef FS_Desc;         /* usbd_desc.c */
+
+#define CFG_DESC_SIZ    98u
+
+/* MS OS 2.0: the platform capability in the BOS descriptor names the vendor
+ * request that fetches the descriptor set; Windows (8.1 on) then binds
+ * WinUSB to interface 2 by itself */
+#define MSOS_VENDOR_CODE    0x20u
+#define MSOS_DESC_INDEX     7u
+#define MSOS_SET_SIZ        178u
+#define BOS_DESC_SIZ        33u
+
+static USBD_ClassTypeDef   cls;
+static USBD_HandleTypeDef *dev;
+__ALIGN_BEGIN static uint8_t rx_buf[2][BULK_RX_SIZE] __ALIGN_END;  /* ping-pong */
+static uint8_t            *rx_at;           /* where the armed OUT transfer lands */
+static volatile bool       open;
+static volatile bool       busy;
+static volatile uint32_t   busy_t0;
+
+/* USBD_CDC's configuration with an IAD in front of it and interface 2 behind */
+__ALIGN_BEGIN static uint8_t cfg_desc[CFG_DESC_SIZ] __ALIGN_END = {
+    0x09, USB_DESC_TYPE_CONFIGURATION, LOBYTE(CFG_DESC_SIZ), HIBYTE(CFG_DESC_SIZ),
+    0x03,                                   /* bNumInterfaces */
+    0x01, 0x00,
+#if (USBD_SELF_POWERED == 1U)
+    0xC0,
+#else
+    0x80,
+#endif
+    USBD_MAX_POWER,
+
+    /* IAD: interfaces 0, 1 are one CDC ACM function */
+    0x08, USB_DESC_TYPE_IAD, 0x00, 0x02, 0x02, 0x02, 0x01, 0x00,
+
+    /* CDC communication interface, functional descriptors, notify EP */
+    0x09, USB_DESC_TYPE_INTERFACE, 0x00, 0x00, 0x01, 0x02, 0x02, 0x01, 0x00,
+    0x05, 0x24, 0x00, 0x10, 0x01,           /* header, CDC 1.10 */
+    0x05, 0x24, 0x01, 0x00, 0x01,           /* call management */
+    0x04, 0x24, 0x02, 0x02,                 /* ACM */
+    0x05, 0x24, 0x06, 0x00, 0x01,           /* union */
+    0x07, USB_DESC_TYPE_ENDPOINT, CDC_CMD_EP, 0x03,
+    LOBYTE(CDC_CMD_PACKET_SIZE), HIBYTE(CDC_CMD_PACKET_SIZE), CDC_FS_BINTERVAL,
+
+    /* CDC data interface */
+    0x09, USB_DESC_TYPE_INTERFACE, 0x01, 0x00, 0x02, 0x0A, 0x00, 0x00, 0x00,
+    0x07, USB_DESC_TYPE_ENDPOINT, CDC_OUT_EP, 0x02,
+    LOBYTE(CDC_DATA_FS_MAX_PACKET_SIZE), HIBYTE(CDC_DATA_FS_MAX_PACKET_SIZE), 0x00,
+    0x07, USB_DESC_TYPE_ENDPOINT, CDC_IN_EP, 0x02,
+    LOBYTE(CDC_DATA_FS_MAX_PACKET_SIZE), HIBYTE(CDC_DATA_FS_MAX_PACKET_SIZE), 0x00,
+
+    /* vendor interface, one bulk pipe each way */
+    0x09, USB_DESC_TYPE_INTERFACE, BULK_ITF, 0x00, 0x02, 0xFF, 0x00, 0x00, 0x00,
+    0x07, USB_DESC_TYPE_ENDPOINT, BULK_OUT_EP, 0x02, LOBYTE(BULK_PACKET), HIBYTE(BULK_PACKET), 0x00,
+    0x07, USB_DESC_TYPE_ENDPOINT, BULK_IN_EP,  0x02, LOBYTE(BULK_PACKET), HIBYTE(BULK_PACKET), 0x00,
+};
+
+__ALIGN_BEGIN static uint8_t bos_desc[BOS_DESC_SIZ] __ALIGN_END = {
+    0x05, USB_DESC_TYPE_BOS, LOBYTE(BOS_DESC_SIZ), HIBYTE(BOS_DESC_SIZ), 0x01,
+
+    /* platform capability, MS OS 2.0 {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F} */
+    0x1C, 0x10, 0x05, 0x00,
+    0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,
+    0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F,
+    0x00, 0x00, 0x03, 0x06,                 /* Windows 8.1 */
+    LOBYTE(MSOS_SET_SIZ), HIBYTE(MSOS_SET_SIZ), MSOS_VENDOR_CODE, 0x00,
+};
+
+/* UTF-16LE, the way the registry property wants its strings */
+#define W(c)    (c), 0x00
+
+__ALIGN_BEGIN static const uint8_t msos_set[MSOS_SET_SIZ] __ALIGN_END = {
+    0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x06,     /* set header, 8.1 */
+    LOBYTE(MSOS_SET_SIZ), HIBYTE(MSOS_SET_SIZ),
+    0x08, 0x00, 0x01, 0x00, 0x00, 0x00, 0xA8, 0x00,     /* configuration 0, 168 */
+    0x08, 0x00, 0x02, 0x00, BULK_ITF, 0x00, 0xA0, 0x00, /* function: interface 2, 160 */
+
+    0x14, 0x00, 0x03, 0x00,                             /* compatible ID */
+    'W', 'I', 'N', 'U', 'S', 'B', 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+
+    0x84, 0x00, 0x04, 0x00, 0x07, 0x00,                 /* registry property, REG_MULTI_SZ */
+    0x2A, 0x00,
+    W('D'), W('e'), W('v'), W('i'), W('c'), W('e'), W('I'), W('n'), W('t'), W('e'),
+    W('r'), W('f'), W('a'), W('c'), W('e'), W('G'), W('U'), W('I'), W('D'), W('s'),
+    W(0),
+    0x50, 0x00,
+    W('{'), W('8'), W('F'), W('2'), W('E'), W('5'), W('A'), W('3'), W('1'), W('-'),
+    W('6'), W('C'), W('0'), W('D'), W('-'), W('4'), W('B'), W('7'), W('E'), W('-'),
+    W('9'), W('A'), W('1'), W('F'), W('-'), W('3'), W('D'), W('5'), W('C'), W('2'),
+    W('B'), W('7'), W('1'), W('E'), W('0'), W('A'), W('4'), W('}'), W(0),   W(0),
+};
+
+#undef W
+
+static void bulk_arm(uint8_t *buf, uint32_t len)
+{
+    rx_at = buf;
+    USBD_LL_PrepareReceive(dev, BULK_OUT_EP, buf, len);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Class callbacks: interface 2 / endpoint 3 here, the rest to USBD_CDC
+ */
+static uint8_t bulk_init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+    uint8_t ret = USBD_CDC.Init(pdev, cfgidx);
+    USBD_LL_OpenEP(pdev, BULK_IN_EP,  USBD_EP_TYPE_BULK, BULK_PACKET);
+    USBD_LL_OpenEP(pdev, BULK_OUT_EP, USBD_EP_TYPE_BULK, BULK_PACKET);
+    pdev->ep_in[BULK_IN_EP & 0xFU].is_used   = 1U;
+    pdev->ep_out[BULK_OUT_EP & 0xFU].is_used = 1U;
+    open = false;
+    busy = false;
+    usb_tx_pipe_done(TX_PIPE_BULK);         /* a transfer from before is gone */
+    bulk_arm(rx_buf[0], BULK_RX_SIZE);
+    return ret;
+}
+
+static uint8_t bulk_deinit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+    USBD_LL_CloseEP(pdev, BULK_IN_EP);
+    USBD_LL_CloseEP(pdev, BULK_OUT_EP);
+    pdev->ep_in[BULK_IN_EP & 0xFU].is_used   = 0U;
+    pdev->ep_out[BULK_OUT_EP & 0xFU].is_used = 0U;
+    open = false;
+    return USBD_CDC.DeInit(pdev, cfgidx);
+}
+
+static uint8_t bulk_setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+    if ((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_DEVICE &&
+        (req->bmRequest & USB_REQ_TYPE_MASK) == USB_REQ_TYPE_VENDOR &&
+        req->bRequest == MSOS_VENDOR_CODE && req->wIndex == MSOS_DESC_INDEX) {
+        return (uint8_t)USBD_CtlSendData(pdev, (uint8_t *)msos_set,
+                                         MIN(MSOS_SET_SIZ, req->wLength));
+    }
+
+    /* no class / vendor requests on interface 2; the standard ones CDC
+     * answers for any interface (alternate setting 0 only) */
+    if ((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_INTERFACE &&
+        LOBYTE(req->wIndex) == BULK_ITF &&
+        (req->bmRequest & USB_REQ_TYPE_MASK) != USB_REQ_TYPE_STANDARD) {
+        USBD_CtlError(pdev, req);
+        return (uint8_t)USBD_FAIL;
+    }
+    return USBD_CDC.Setup(pdev, req);
+}
+
+static uint8_t bulk_data_in(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+    if (epnum != (BULK_IN_EP & 0x7FU)) return USBD_CDC.DataIn(pdev, epnum);
+
+    USBD_EndpointTypeDef *ep = &pdev->ep_in[epnum];
+    if (ep->total_length && ep->total_length % BULK_PACKET == 0u) {
+        ep->total_length = 0;               /* a short packet ends the transfer */
+        USBD_LL_Transmit(pdev, BULK_IN_EP, NULL, 0);
+        return (uint8_t)USBD_OK;
+    }
+    busy = false;
+    usb_tx_pipe_done(TX_PIPE_BULK);
+    return (uint8_t)USBD_OK;
+}
+
+static uint8_t bulk_data_out(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+    if (epnum != (BULK_OUT_EP & 0x7FU)) return USBD_CDC.DataOut(pdev, epnum);
+
+    open = true;
+    uint8_t *in    = rx_at;
+    uint32_t n     = USBD_LL_GetRxDataSize(pdev, epnum);
+    uint8_t *spare = in == rx_buf[0] ? rx_buf[1] : rx_buf[0];
+
+    /* no frame to land in place: the next transfer runs while this one is read */
+    if (!stream_active()) {
+        bulk_arm(spare, BULK_RX_SIZE);
+        usb_comms_receive(in, n);
+        return (uint8_t)USBD_OK;
+    }
+
+    usb_comms_receive(in, n);
+    uint32_t len  = BULK_RX_SIZE;
+    uint8_t *next = stream_rx_target(spare, &len, bulk_arm);
+    if (next) bulk_arm(next, len);              /* else stream_tick() re-arms it */
+    return (uint8_t)USBD_OK;
+}
+
+static uint8_t *bulk_cfg_desc(uint16_t *length)
+{
+    *length = (uint16_t)sizeof cfg_desc;
+    return cfg_desc;
+}
+
+static uint8_t *bulk_bos_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    *length = (uint16_t)sizeof bos_desc;
+    return bos_desc;
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * API
+ */
+void usb_bulk_attach(USBD_HandleTypeDef *pdev)
+{
+    /* 320 words of FIFO: RX 128, EP0 16, CDC data 64, CDC notify 16, bulk 96.
+     * The core has no double buffered endpoints; a FIFO of several packets
+     * is what lets the next one go out while the host takes the last */
+    HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_FS, 0x80);
+    HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 0, 0x10);
+    HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 1, 0x40);
+    HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 2, 0x10);
+    HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 3, 0x60);
+
+    /* USB 2.01, so the host asks for the BOS descriptor */
+    USBD_FS_DeviceDesc[2] = 0x01;
+    FS_Desc.GetBOSDescriptor = bulk_bos_desc;
+
+    /* class "see the interface associations" (0xEF / 2 / 1) */
+    USBD_FS_DeviceDesc[4] = 0xEF;
+    USBD_FS_DeviceDesc[5] = 0x02;
+    USBD_FS_DeviceDesc[6] = 0x01;
+
+    cls             = USBD_CDC;
+    cls.Init        = bulk_init;
+    cls.DeInit      = bulk_deinit;
+    cls.Setup       = bulk_setup;
+    cls.DataIn      = bulk_data_in;
+    cls.DataOut     = bulk_data_out;
+    cls.GetFSConfigDescriptor         = bulk_cfg_desc;
+    cls.GetHSConfigDescriptor         = bulk_cfg_desc;
+    cls.GetOtherSpeedConfigDescriptor = bulk_cfg_desc;
+
+    dev             = pdev;
+    pdev->pClass[0] = &cls;
+    pdev->pConfDesc = cfg_desc;
+}
+
+bool usb_bulk_open(void)
+{
+    if (open && busy && HAL_GetTick() - busy_t0 > BULK_STALE_MS) open = false;   /* nobody reads */
+    return open;
+}
+
+uint8_t usb_bulk_transmit(uint8_t *buf, uint16_t len)
+{
+    if (busy || !dev) return (uint8_t)USBD_BUSY;
+    busy    = true;
+    busy_t0 = HAL_GetTick();
+    dev->ep_in[BULK_IN_EP & 0xFU].total_length = len;
+    return (uint8_t)USBD_LL_Transmit(dev, BULK_IN_EP, buf, len);
+}
+
+#endif /* USB_BULK */
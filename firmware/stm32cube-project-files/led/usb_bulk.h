@@ -0,0 +1,81 @@
+/*
+ * usb_bulk.h – a vendor bulk pipe next to the console (USB_BULK)
+ *
+ * The device enumerates as a composite: the CDC console as before
+ * (interfaces 0 and 1, under an interface association) and interface 2,
+ * class 0xFF, with one bulk endpoint each way:
+ *
+ *   BULK_OUT_EP 0x03   host → device, read like the console: stream frames
+ *                      land in place (led_stream.h), packets (usb_packet.h)
+ *                      are collected, text runs as commands
+ *   BULK_IN_EP  0x83   device → host, the packet channel (replies, PKT_LOG)
+ *
+ * The host opens the pipe by writing to it, a zero length write does. From
+ * then on packets go out here instead of between the log lines. If nothing
+ * reads them for BULK_STALE_MS the pipe counts as closed again and packets
+ * take the console, until the host writes again.
+ *
+ * Built for throughput, so that a mirrored stream to several sculptures
+ * keeps to the frame rate: OUT transfers are many packets long, into two
+ * BULK_RX_SIZE buffers in turn, and a raw stream frame takes one transfer
+ * for the rest of its pixels, straight into the framebuffer. IN transfers
+ * are as long as the ring has bytes in a row, the bulk endpoint gets the
+ * biggest TX FIFO. At full speed that is near 1 MB/s each way when the
+ * host queues enough (app/usb_bulk.py).
+ *
+ * The device carries MS OS 2.0 descriptors (a BOS platform capability and
+ * the descriptor set behind a vendor request): Windows 8.1 and later bind
+ * WinUSB to interface 2 without an .inf or Zadig; libusb finds it there.
+ *
+ * The class wraps USBD_CDC (Middlewares untouched) and is swapped in by
+ * usb_bulk_attach() right after USBD_Start(), before the host can reset
+ * the bus; it also lays out the TX FIFOs for the two extra IN endpoints.
+ */
+
+#ifndef _USB_BULK_H_
+#define _USB_BULK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "usbd_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BULK_ITF                2
+#define BULK_IN_EP              0x83U
+#define BULK_OUT_EP             0x03U
+#define BULK_PACKET             64U
+
+/* each of the two OUT buffers; one is filled while the other is read */
+#ifndef BULK_RX_SIZE
+  #define BULK_RX_SIZE          512U
+#endif
+
+#ifndef BULK_STALE_MS
+  #define BULK_STALE_MS         250
+#endif
+
+/**
+ * Replace the registered CDC class by the composite (MX_USB_DEVICE_Init)
+ */
+void usb_bulk_attach(USBD_HandleTypeDef *pdev);
+
+/**
+ * The host has written to the pipe and takes what is sent
+ */
+bool usb_bulk_open(void);
+
+/**
+ * Start one IN transfer (buffer untouched until usb_tx_pipe_done)
+ * @return USBD_OK, USBD_BUSY while one is out
+ */
+uint8_t usb_bulk_transmit(uint8_t *buf, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _USB_BULK_H_ */
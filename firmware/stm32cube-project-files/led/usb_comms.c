@@ -4,6 +4,8 @@
  *  • Captures *all* early‑boot printf output in a RAM ring.
  *  • Flushes it when USB is CONFIGURED (dev_state) – no DTR gating.
  *  • Continues via the TX‑complete ISR and opportunistic flush in _write().
+ *  • Transmits straight out of the ring; text and packets are channels with
+ *    their own overflow policy (usb_comms.h).
  *
  *   Revised: allow flush immediately once CONFIGURED to avoid missed window.
  * -------------------------------------------------------------------------- */
@@ -15,17 +17,95 @@
 
 #include "led_debug.h"
 #include "usb_comms.h"
+#include "trace.h"
+#include "scene.h"           /* scene_reload */
+#include "led_view.h"        /* view_set_euler (#gyro) */
+#include "led_anim.h"        /* anim_get (mode names) */
+#include "led_palette.h"     /* palette_find / palette_select */
+#include "led_layers.h"      /* layers_set / layers_clear */
+#include "led_rng.h"         /* rng_seed */
+#include "led_governor.h"    /* gov_force */
+#include "clock_scale.h"     /* clk_scale_force, clk_scale_report */
+#include "supply.h"          /* supply_report */
+#include "led_hud.h"         /* hud_show / hud_shown */
+#include "led_params.h"      /* param_find / param_set / param_frame */
+#include "led_vm.h"          /* vm_frame_handle, script save / load */
+#include "usb_packet.h"      /* COBS framed binary packets */
+#include "led_stream.h"      /* host pixel frames */
+#include "led_mapping.h"     /* mapping_get_total_pixels */
+#include "usb_bulk.h"        /* the packet pipe with USB_BULK */
+#include "telemetry.h"       /* telemetry_set_interval */
+#include "led_mirror.h"      /* mirror_set_fps */
+#include "frame_sync.h"      /* frame_sync_stats */
+#include "sof_lock.h"        /* sof_lock_stats */
+#include "led_link.h"        /* link_stats */
+#include "bench.h"           /* bench_start */
+#include "render_bench.h"    /* bench encode / wire */
+#include "boot_prof.h"       /* boot_report */
+#include "scene_mem.h"       /* scene_mem_report */
+#include "stack_mon.h"       /* stack_report */
+#include "sched.h"           /* sched_job, sched_report */
+#include "itm.h"             /* ITM_LOG: the text goes out on SWO */
+#include "pc_sample.h"       /* pcs_set_hz */
+#include "irq_stats.h"       /* irq_report */
+#include "blackbox.h"        /* bb_dump_start */
+#include "replay.h"          /* replay_note, the rec command */
+#include "calib.h"           /* calib_start, the calib command */
+#include "audio.h"           /* audio_stats, the audio command */
+#include "clip.h"            /* clip_play, the clip command */
+#include "spsc_ring.h"
+#include "log_ring.h"        /* writes from the other interrupts */
 #include "usbd_cdc_if.h"
 #include "usb_device.h"
 #include "stm32f4xx_hal.h"   // for HAL_GetTick()
 
-static char     rx_buffer[256];
-static uint8_t  rx_len;
-static bool     rx_ready = false;
+/* text console: the CDC ISR pushes whole USB chunks, usb_comms_process()
+ * pops them and runs every complete line (CR / LF terminated) */
+#ifndef RX_RING_SIZE
+#define RX_RING_SIZE    1024
+#endif
+SPSC_RING(rx_ring, RX_RING_SIZE);
+static char     rx_line[256];
+static uint16_t rx_line_len  = 0;
+static bool     rx_line_drop = false;  /* too long: skipped up to its end */
+static uint32_t rx_len;                /* last chunk */
+static volatile uint32_t rx_overrun = 0;  /* bytes the ring had no room for */
+static bool     rx_packet = false;     /* inside a binary packet (usb_packet.h) */
 
-static char     tx_buffer[TX_BUF_SIZE];
-static uint32_t tx_head = 0;   /* next byte to send */
-static uint32_t tx_tail = 0;   /* next free slot   */
+/* TX rings, one per pipe, indices free running (masked on use):
+ *   head .. sent    handed to the USB core, sent straight from the ring
+ *   sent .. tail    queued
+ * The main loop and the USB ISR both touch them, always with OTG_FS_IRQn
+ * masked. Any other interrupt could cut into that, its writes are queued
+ * in the log ring (log_ring.h) and moved here from the main loop. */
+typedef struct {
+    uint8_t  *buf;
+    uint32_t  size;                 /* power of two */
+    uint32_t  xfer;                 /* most one transfer takes */
+    uint32_t  head, sent, tail;
+    bool      flying;               /* head .. sent in the USB core, not ours */
+    bool    (*ready)(void);         /* a host takes what is sent */
+    uint8_t (*transmit)(uint8_t *p, uint16_t n);
+} TxRing;
+
+static bool cdc_ready(void);
+static void tx_drain(void);
+static uint8_t tx_cdc_buf[TX_BUF_SIZE];
+#ifdef USB_BULK
+static bool bulk_ready(void);
+static uint8_t tx_bulk_buf[TX_BULK_SIZE];
+#endif
+static TxRing tx_pipe[TX_PIPE_COUNT] = {
+    [TX_PIPE_CDC]  = { tx_cdc_buf,  TX_BUF_SIZE,  APP_TX_DATA_SIZE, 0, 0, 0, false, cdc_ready,  CDC_Transmit_FS   },
+#ifdef USB_BULK
+    [TX_PIPE_BULK] = { tx_bulk_buf, TX_BULK_SIZE, TX_BULK_SIZE,     0, 0, 0, false, bulk_ready, usb_bulk_transmit },
+#endif
+};
+static uint32_t tx_dropped[TX_CH_COUNT];
+static uint8_t  tx_policy[TX_CH_COUNT] = {
+    [TX_CH_TEXT]   = TX_PRIORITY,
+    [TX_CH_PACKET] = TX_BLOCK,
+};
 
 extern USBD_HandleTypeDef hUsbDeviceFS;
 volatile bool host_open = false;
@@ -48,96 +128,253 @@ void usb_set_host_open(bool s)
 /* -------------------------------------------------------------------------- */
 uint8_t usb_comms_receive(uint8_t *Buf, uint32_t Len)
 {
+    TRACE_BEGIN(CDC_RX, (uint16_t)Len);
 	if (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED && rx_len >= 10 && host_open != true){
 		host_open = true;
 		host_open_tick = 0;
 	}
-    rx_len = (Len < sizeof(rx_buffer)) ? Len : sizeof(rx_buffer) - 1;
-    memcpy(rx_buffer, Buf, rx_len);
-    rx_buffer[rx_len] = '\0';
-    rx_ready = true;
+    /* streaming: frames first, whatever ends the mode carries on below */
+    uint32_t taken = stream_rx(Buf, Len);
+    Buf += taken;
+    Len -= taken;
+    if (!Len) {
+        TRACE_END(CDC_RX, (uint16_t)taken);
+        return USBD_OK;
+    }
+    /* binary packets start with their 0x00 delimiter, text never has one */
+    if (Len && (rx_packet || Buf[0] == 0x00)) {
+        usb_packet_rx(Buf, Len);
+        rx_packet = Buf[Len - 1] != 0x00;
+        TRACE_END(CDC_RX, (uint16_t)Len);
+        return USBD_OK;
+    }
+    rx_len = Len;
+    if (Len > RX_RING_SIZE) Len = RX_RING_SIZE;
+    rx_overrun += Len - spsc_push(&rx_ring, Buf, (uint16_t)Len);
+    TRACE_END(CDC_RX, (uint16_t)Len);
     return USBD_OK;
 }
 
 /* -------------------------------------------------------------------------- */
 /* Ring‑buffer helpers                                                         */
 /* -------------------------------------------------------------------------- */
-static uint32_t room_left(void)
+static inline void tx_lock(void)   { NVIC_DisableIRQ(OTG_FS_IRQn); }
+static inline void tx_unlock(void) { NVIC_EnableIRQ(OTG_FS_IRQn); }
+
+static inline uint32_t room_left(const TxRing *r)
+{
+    return r->size - (r->tail - r->head);
+}
+
+/* the oldest queued bytes, whole chunks; not while a transfer is out (it
+ * pins the ring behind them, nothing would free) */
+static uint32_t tx_evict(TxRing *r, uint32_t need)
+{
+    if (r->flying) return 0;
+    uint32_t drop = (need + TX_DROP_CHUNK - 1u) / TX_DROP_CHUNK * TX_DROP_CHUNK;
+    if (drop > r->tail - r->sent) drop = r->tail - r->sent;
+    r->head = r->sent += drop;
+    return drop;
+}
+
+static bool cdc_ready(void)
+{
+    return hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED && host_open &&
+           (HAL_GetTick() - host_open_tick) >= 250;
+}
+
+#ifdef USB_BULK
+static bool bulk_ready(void)
+{
+    return hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED && usb_bulk_open();
+}
+#endif
+
+/* packets take the bulk pipe while the host listens there */
+static TxRing *ring_for(TxChannel ch)
 {
-    return (tx_head <= tx_tail)
-         ? (TX_BUF_SIZE - (tx_tail - tx_head) - 1)
-         : (tx_head - tx_tail - 1);
+#ifdef USB_BULK
+    if (ch == TX_CH_PACKET && usb_bulk_open()) return &tx_pipe[TX_PIPE_BULK];
+#endif
+    (void)ch;
+    return &tx_pipe[TX_PIPE_CDC];
 }
 
 /* -------------------------------------------------------------------------- */
-/* printf backend – enqueue chars and opportunistic flush when configured      */
+/* TX path – one transfer per pipe at a time, straight out of the ring         */
 /* -------------------------------------------------------------------------- */
 
-int _write(int file, char *ptr, int len)
+/* locked; the USB core reads the FIFO words unaligned, any ring offset does */
+static uint8_t flush_now(TxRing *r)
 {
-    int to_return = len;            // <-- hier merken wir uns den Original-Len
-    (void)file;
+    if (r->flying || r->sent == r->tail) return USBD_OK;
 
-    while (len--) {
-        if (!room_left()) {
-            tx_head = (tx_head + TX_DROP_CHUNK) % TX_BUF_SIZE;
-        }
-        tx_buffer[tx_tail] = *ptr++;
-        tx_tail = (tx_tail + 1) % TX_BUF_SIZE;
-    }
+    uint32_t at    = r->sent & (r->size - 1u);
+    uint32_t chunk = r->tail - r->sent;
+    if (chunk > r->size - at)        chunk = r->size - at;      /* contiguous part */
+    if (chunk > r->xfer)             chunk = r->xfer;
 
-    if (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED && host_open) {
-        flush_usb_buffer();
+    uint8_t res = r->transmit(&r->buf[at], (uint16_t)chunk);
+    if (res == USBD_OK) {
+        r->sent  += chunk;
+        r->flying = true;
     }
+    return res;
+}
+
+static void tx_flush(TxRing *r)
+{
+    if (!r->buf || !r->ready()) return;
+    tx_lock();
+    flush_now(r);                   /* the TX-complete ISR sends the rest */
+    tx_unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* Drain buffers – CDC only requires CONFIGURED, ignores DTR gating            */
+/* -------------------------------------------------------------------------- */
+
+void flush_usb_buffer(void)
+{
+    TRACE_BEGIN(USB_FLUSH, 0);
+    if (__get_IPSR() == 0) tx_drain();
+    for (uint8_t i = 0; i < TX_PIPE_COUNT; ++i) tx_flush(&tx_pipe[i]);
+    TRACE_END(USB_FLUSH, 0);
+}
 
-    return to_return;               // <-- statt 0
+uint32_t usb_tx_room(void)
+{
+    return room_left(&tx_pipe[TX_PIPE_CDC]);
 }
 
+uint32_t usb_tx_channel_room(TxChannel ch)
+{
+    return room_left(ring_for(ch));
+}
 
 /* -------------------------------------------------------------------------- */
-/* TX path – send chunks, advance head                                         */
+/* Channels – enqueue in at most two spans, opportunistic flush                */
 /* -------------------------------------------------------------------------- */
 
-static uint8_t flush_now(void)
+static uint32_t tx_write_now(TxChannel ch, const void *buf, uint32_t len)
 {
-    if (tx_head == tx_tail) return USBD_OK;
+    const uint8_t *p      = buf;
+    uint32_t       lost   = 0;
+    TxPolicy       policy = (TxPolicy)tx_policy[ch];
+    TxRing        *r      = ring_for(ch);
 
-    uint32_t chunk = (tx_tail > tx_head)
-                   ? (tx_tail - tx_head)
-                   : (TX_BUF_SIZE - tx_head);
+    /* TX_BLOCK: let the host take some, from the main loop and with a host */
+    if (policy == TX_BLOCK && room_left(r) < len && __get_IPSR() == 0 && r->ready()) {
+        uint32_t t0 = HAL_GetTick();
+        while (room_left(r) < len && HAL_GetTick() - t0 < TX_BLOCK_MS) tx_flush(r);
+    }
 
-    extern uint8_t UserTxBufferFS[];   //from usbd_cdc_if.c
-    if (chunk > APP_TX_DATA_SIZE) chunk = APP_TX_DATA_SIZE;
+    tx_lock();
+    uint32_t cap = r->size - (r->sent - r->head);          /* in flight stays put */
+    if (policy == TX_PRIORITY) {
+        if (len > cap) {                        /* only the end fits anyway */
+            lost += len - cap;
+            p    += len - cap;
+            len   = cap;
+        }
+        if (room_left(r) < len) lost += tx_evict(r, len - room_left(r));
+        uint32_t room = room_left(r);
+        if (room < len) {                       /* in flight: the end, if anything */
+            lost += len - room;
+            p    += len - room;
+            len   = room;
+        }
+    } else if (room_left(r) < len) {
+        lost += len;
+        len   = 0;
+    }
 
-    memcpy(UserTxBufferFS, &tx_buffer[tx_head], chunk);
-    uint8_t res = CDC_Transmit_FS(UserTxBufferFS, chunk);
-    if (res == USBD_OK) {
-        tx_head = (tx_head + chunk) % TX_BUF_SIZE;
+    uint32_t at    = r->tail & (r->size - 1u);
+    uint32_t first = r->size - at;
+    if (first > len) first = len;
+    memcpy(&r->buf[at], p, first);
+    memcpy(r->buf, p + first, len - first);
+    r->tail += len;
+    tx_dropped[ch] += lost;
+    tx_unlock();
+
+    if (len) tx_flush(r);
+    return len;
+}
+
+/* the log ring's records into the TX rings, oldest first; thread mode only,
+ * one task at a time (the others find it busy and leave it) */
+static void tx_drain(void)
+{
+    static volatile uint8_t draining;
+    const uint8_t *p;
+    uint8_t  tag;
+    uint16_t n;
+
+    if (__LDREXB(&draining) || __STREXB(1, &draining)) {
+        __CLREX();
+        return;
     }
-    return res;
+    while ((p = log_ring_peek(&tag, &n)) != NULL) {
+        tx_write_now((TxChannel)tag, p, n);
+        log_ring_pop();
+    }
+    __DMB();
+    draining = 0;
 }
 
+uint32_t usb_tx_write(TxChannel ch, const void *buf, uint32_t len)
+{
+    uint32_t ipsr = __get_IPSR();
+    if (!len) return 0;
+
+    /* an interrupt other than the USB one: queued whole, the main loop
+     * sends it on (the TX rings may be half updated under us) */
+    if (ipsr && ipsr != (uint32_t)OTG_FS_IRQn + 16u) {
+        if (len > UINT16_MAX) len = UINT16_MAX;
+        return log_ring_put((uint8_t)ch, buf, (uint16_t)len) ? len : 0u;
+    }
+    if (!ipsr) tx_drain();          /* what the interrupts wrote came first */
+    return tx_write_now(ch, buf, len);
+}
+
+void     usb_tx_set_policy(TxChannel ch, TxPolicy p) { tx_policy[ch] = (uint8_t)p; }
+TxPolicy usb_tx_policy(TxChannel ch)                 { return (TxPolicy)tx_policy[ch]; }
+uint32_t usb_tx_dropped(TxChannel ch)                { return tx_dropped[ch]; }
+
 /* -------------------------------------------------------------------------- */
-/* Drain buffer – only require CONFIGURED, ignore DTR gating                  */
+/* printf backend – the text channel                                           */
 /* -------------------------------------------------------------------------- */
 
-void flush_usb_buffer(void)
+int _write(int file, char *ptr, int len)
 {
-    if (hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED || !host_open) return;
-    if ((HAL_GetTick() - host_open_tick) < 250) return;
-    // drain until empty or USB busy
-    while (tx_head != tx_tail) {
-        if (flush_now() != USBD_OK) break;
-    }
+    (void)file;
+    if (len <= 0) return 0;
+#ifdef ITM_LOG
+    itm_write(ITM_PORT_LOG, ptr, (uint32_t)len);   /* the probe has it, not the app */
+#else
+    usb_tx_write(TX_CH_TEXT, ptr, (uint32_t)len);
+#endif
+    return len;                     /* dropped or not, newlib is done with it */
 }
 
 /* -------------------------------------------------------------------------- */
-/* Called from CDC Tx complete callback to continue draining                   */
+/* Called from the TX complete callbacks to continue draining                  */
 /* -------------------------------------------------------------------------- */
 
+void usb_tx_pipe_done(TxPipe pipe)
+{
+    TxRing *r = &tx_pipe[pipe];
+    r->head   = r->sent;            /* the ring memory is ours again */
+    r->flying = false;
+    tx_flush(r);
+}
+
 void usb_tx_complete_isr(void)
 {
-    flush_usb_buffer();
+    TRACE_BEGIN(CDC_TX, 0);
+    usb_tx_pipe_done(TX_PIPE_CDC);
+    TRACE_END(CDC_TX, 0);
 }
 
 /* ────────────────────────────────────────────────────────────────────────  */
@@ -153,7 +390,26 @@ void usb_tx_complete_isr(void)
  *   e  – edge/slot     (dbg_edge_slot)
  *   m  – debug mode    (cycles or relative delta)
  *   r  – reverse / flip current logical edge
+ *   h  – hue of the vertex colours
  *   save  – persist current mapping & dump tables
+ *   forget – erase the saved mapping (LED_MAP_STORE)
+ *   trace – dump the event timeline (LED_TRACE)
+ *   bb [us|dump|arm] – black box: spike threshold / send the capture (LED_BLACKBOX)
+ *   rec [start|stop|play|dump] – record / replay the input from a known start (LED_REPLAY)
+ *   calib [ms|stop|set|apply] – camera edge calibration patterns, the map it found (LED_CALIB)
+ *   palette <name> – blend the animations over to a named palette
+ *   layer <n> <anim> [add|max|alpha|mul] [alpha] – overlay n (1..), "layer <n> off"
+ *   highlight <v> – light the edges at vertex v (run "highlight" as a layer),
+ *                   "highlight" alone switches it off
+ *   hud [on|off] – performance gauges on the top layer (led_hud.h), bare toggles
+ *   param [<name> <value>] – list the tunable parameters / set one
+ *   preset save|load <n> – all parameters into / from flash slot n
+ *   script [save|load] – running script length / into / from flash
+ *   #gyro x=<roll>,y=<pitch>,z=<yaw># – tilt the spatial animations (rad)
+ *   0x00 ... 0x00 – COBS framed binary packet (usb_packet.h), any length;
+ *                   parameter (0xA7) and script (0xA8) frames travel in them
+ *
+ *   Text commands end with CR or LF, every complete one is run per poll.
  *   help  – list valid commands
  *
  *   Suffix syntax:
@@ -161,15 +417,19 @@ void usb_tx_complete_isr(void)
  *       "++"        -> +1
  *       "--"        -> -1
  *       <float>     -> delta value (e.g. "0.1", "1.5", "-3")
+ *       "=" <n>     -> set it (f b e m h, "r=0|1"), no deltas to add up
  *
  *   Examples:
- *       "f"     , "f++"   , "f  2" , "f-1"
- *       "b--"   , "e  0.5", "m--", "r" , "save"
+ *       "f"     , "f++"   , "f  2" , "f-1", "f=3"
+ *       "b--"   , "e  0.5", "m--", "r" , "h = 143", "save"
+ *
+ *   A controller sends PKT_CONTROL packets instead: several of these at
+ *   once, applied together before the next frame.
  * -------------------------------------------------------------------------- */
 
 static void send_help(void)
 {/* no actually, please someone help me */
-	USBD_UsrLog("Valid cmds:\n f b e m [++|--|<float>]\n r (flip)\n save\n help\n");
+	USBD_UsrLog(PROTO_HELP);                /* the list is tools/protocol.def */
 }
 
 /* ────────────────────────────────────────────────────────────────────────  */
@@ -180,6 +440,14 @@ static float parse_delta(const char *arg)
     if (strcmp(arg, "--") == 0)               return -1.0f;
     return (float)atof(arg);   /* handles "+1", "-2.5", "0" … */
 }
+
+/* "=<n>": an absolute value instead of a delta */
+static bool parse_set(const char *arg, uint16_t *v)
+{
+    if (*arg != '=') return false;
+    *v = (uint16_t)strtoul(arg + 1, NULL, 10);
+    return true;
+}
 /* ────────────────────────────────────────────────────────────────────────  */
 
 /* # TEMP # TEMP # TEMP # TEMP # TEMP # TEMP # TEMP # TEMP # TEMP # TEMP # TEMP   */
@@ -188,54 +456,216 @@ static float parse_delta(const char *arg)
 #include "geo_debug.h"
 
 void printPolys(void) {
-    Polyhedron *poly = poly_alloc();
-    if (!poly) {
+    const size_t bytes = poly_conway_bytes("kdaD");  /* fits the largest below */
+    PolyArena  arena;
+    Polyhedron p;
+    poly_arena_init(&arena, malloc(bytes), bytes);
+    if (!arena.mem) {
         USBD_UsrLog("Error: out of heap\n");
         return;
     }
 
-    //poly_init_icosahedron(poly);
-    //geo_dump_wireframe(poly, "icosa");
+    //if (poly_init_icosahedron(&p, &arena)) geo_dump_wireframe(&p, "icosa");
 
-    poly_init_dodecahedron(poly);
-    geo_dump_wireframe(poly, "dodeca");
+    if (poly_init_dodecahedron(&p, &arena)) geo_dump_wireframe(&p, "dodeca");
 
-    //poly_init_cube(poly);
-    //geo_dump_wireframe(poly, "cube");
+    //arena.used = 0;
+    //if (poly_init_cube(&p, &arena)) geo_dump_wireframe(&p, "cube");
 
-    //poly_init_octahedron(poly);
-    //geo_dump_wireframe(poly, "octa");
+    //arena.used = 0;
+    //if (poly_init_octahedron(&p, &arena)) geo_dump_wireframe(&p, "octa");
 
-    //poly_init_icosidodecahedron(poly);
-    //geo_dump_wireframe(poly, "icosidodecahedron");
+    //arena.used = 0;
+    //if (poly_init_icosidodecahedron(&p, &arena)) geo_dump_wireframe(&p, "icosidodecahedron");
 
-    //poly_init_rhombitruncated_icosidodecahedron(poly);
-    //geo_dump_wireframe(poly, "rhombitruncated_icosidodecahedron");
+    //arena.used = 0;
+    //if (poly_init_rhombitruncated_icosidodecahedron(&p, &arena))
+    //    geo_dump_wireframe(&p, "rhombitruncated_icosidodecahedron");
 
-    poly_free(poly);
-}
+    //arena.used = 0;
+    //if (poly_init_conway(&p, &arena, "tI")) geo_dump_wireframe(&p, "truncated_icosahedron");
 
+    free(arena.mem);
+}
 
-static uint8_t mode = 0;
 
 /* # END TEMP # END TEMP # END TEMP # END TEMP # END TEMP # END TEMP # END TEMP   */
 extern Polyhedron poly;
 #define GEO_DUMP_CMD   "#dumpgeo#"
-/* ────────────────────────────────────────────────────────────────────────  */
-static bool usb_greeted = false; // only say hewooo once
-void usb_comms_process(void)
+#define GEO_BIN_CMD    "#dumpgeob#"
+#define GEO_HASH_CMD   "#geohash#"
+#define GYRO_CMD       "#gyro "
+#define PALETTE_BLEND_MS 800
+
+/* "#dumpgeo#": the scene's model a line per step, behind the frames */
+static bool geo_dump_step(uint32_t step)
 {
-    if (!usb_greeted &&
-        hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED) {
-        usb_greeted = true;
-        USBD_UsrLog("Debug interface ready. Type \"help\" for commands.\n");
-    }
+    return geo_dump_model_step(&poly, "poly", step);
+}
 
-    if (!rx_ready) return;
-    rx_ready = false;
+/* "#geohash# 1a2b3c4d V=20 E=30 F=12#": what the app keys its geometry
+ * cache by (geo_hash()), said when the host opens the port and on request */
+static void announce_geometry(void)
+{
+    USBD_UsrLog("#geohash# %08lx V=%u E=%u F=%u#", (unsigned long)geo_hash(&poly),
+                (unsigned)poly.V, (unsigned)poly.E, (unsigned)poly.F);
+}
 
-    /* 1. Trim whitespace + CR/LF --------------------------------------- */
-    char *msg = rx_buffer;
+/* "#dumpgeob#": the same as PKT_GEOMETRY packets, a packet per step */
+static bool geo_bin_step(uint32_t step)
+{
+    return geo_dump_packet_step(&poly, step);
+}
+
+/* "#gyro x=+0.120,y=-0.031,z=+1.571#" (app_window._send_gyro) → view rotation,
+ * a missing component counts as 0 */
+static void handle_gyro(const char *arg)
+{
+    float xyz[3] = { 0.f, 0.f, 0.f };
+    static const char keys[3][3] = { "x=", "y=", "z=" };
+    for (uint8_t i = 0; i < 3; ++i) {
+        const char *k = strstr(arg, keys[i]);
+        if (k) xyz[i] = (float)atof(k + 2);
+    }
+    view_set_euler(xyz[2], xyz[1], xyz[0]);   /* yaw = z, pitch = y, roll = x */
+}
+/* "layer 1 stars add 200", "layer 1 off": overlay on top of the current mode */
+static void handle_layer(const char *arg)
+{
+    char       name[16] = "", blend[8] = "add";
+    unsigned   layer = 0, alpha = 255;
+    int        got   = sscanf(arg, "%u %15s %7s %u", &layer, name, blend, &alpha);
+    if (got >= 2 && strcmp(name, "off") == 0) {
+        layers_clear((uint8_t)layer);
+        return;
+    }
+    int anim = anim_find(name);
+    int mode = layers_blend_find(blend);
+    if (got < 2 || anim < 0 || mode < 0 || alpha > 255 ||
+        !layers_set((uint8_t)layer, (uint8_t)anim, (LayerBlend)mode, (uint8_t)alpha)) {
+        USBD_UsrLog("layer: <1..%u> <anim>|off [add|max|alpha|mul] [0..255]\n", LAYER_OVERLAYS);
+    }
+}
+/* "param" lists them all, "param plasma.k1 3.5" sets one */
+static void handle_param(const char *arg)
+{
+    char  name[24];
+    float v;
+    if (sscanf(arg, "%23s %f", name, &v) == 2) {
+        const ParamDef *p = param_find(name);
+        if (!p) {
+            USBD_UsrLog("param: no %s\n", name);
+        } else if (!param_set(p, v)) {
+            USBD_UsrLog("param: %s in %g..%g\n", name, p->min, p->max);
+        } else {
+            USBD_UsrLog("%s = %g\n", name, param_get(p));
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < anim_param_count(); ++i) {
+        const ParamDef *p = anim_param_get(i);
+        USBD_UsrLog("%3u %-16s %g  [%g..%g]\n", p->id, p->name, param_get(p), p->min, p->max);
+    }
+}
+/* "preset save 1", "preset load 1" */
+static void handle_preset(const char *arg)
+{
+    char     op[8] = "";
+    unsigned slot  = PARAM_PRESETS;
+    sscanf(arg, "%7s %u", op, &slot);
+    bool save = strcmp(op, "save") == 0;
+    if ((!save && strcmp(op, "load") != 0) || slot >= PARAM_PRESETS) {
+        USBD_UsrLog("preset: save|load <0..%u>\n", PARAM_PRESETS - 1);
+        return;
+    }
+    bool ok = save ? param_preset_save((uint8_t)slot) : param_preset_load((uint8_t)slot);
+    USBD_UsrLog("preset %s %u: %s\n", op, slot, ok ? "ok" : "failed");
+}
+/* "script" shows the running one, "script save" / "script load" */
+static void handle_script(const char *arg)
+{
+    bool ok = true;
+    if      (strcmp(arg, " save") == 0) ok = vm_save();
+    else if (strcmp(arg, " load") == 0) ok = vm_restore();
+    else if (*arg) {
+        USBD_UsrLog("script: [save|load]\n");
+        return;
+    }
+    USBD_UsrLog("script: %u instructions%s\n", vm_length(), ok ? "" : ", flash failed");
+}
+/* "stream" hands the LEDs to the host (led_stream.h), the text that ends
+ * it lands here again and shows what came through */
+static void handle_stream(const char *arg)
+{
+    const StreamStats *s = stream_stats();
+    if (*arg) {
+        USBD_UsrLog("stream: %lu frames, %lu keys, %lu torn, %lu stalled, %lu without base\n",
+                    (unsigned long)s->frames, (unsigned long)s->keys, (unsigned long)s->torn,
+                    (unsigned long)s->stalled, (unsigned long)s->no_base);
+        return;
+    }
+    if (!stream_start()) {
+        USBD_UsrLog("stream: renderer not ready\n");
+        return;
+    }
+    USBD_UsrLog("stream: on, %u LEDs, frames [S] [K] F|D|P ... E\n", mapping_get_total_pixels());
+}
+/* "tx" shows what the TX ring dropped, "tx <text|packet> <block|drop|priority>"
+ * changes a channel's policy */
+static void handle_tx(const char *arg)
+{
+    static const char *const ch_name[TX_CH_COUNT] = { "text", "packet" };
+    static const char *const pol_name[]           = { "priority", "drop", "block" };
+    char ch[8], pol[10];
+    if (sscanf(arg, " %7s %9s", ch, pol) == 2) {
+        int c = -1, p = -1;
+        for (int i = 0; i < TX_CH_COUNT; ++i) if (strcmp(ch, ch_name[i]) == 0) c = i;
+        for (int i = 0; i < 3; ++i)           if (strcmp(pol, pol_name[i]) == 0) p = i;
+        if (c < 0 || p < 0) {
+            USBD_UsrLog("tx: [text|packet block|drop|priority]\n");
+            return;
+        }
+        usb_tx_set_policy((TxChannel)c, (TxPolicy)p);
+    }
+    USBD_UsrLog("tx: text %lu dropped (%s), packet %lu dropped (%s), %lu from interrupts, "
+                "%lu free, packets via %s\n",
+                (unsigned long)usb_tx_dropped(TX_CH_TEXT),   pol_name[usb_tx_policy(TX_CH_TEXT)],
+                (unsigned long)usb_tx_dropped(TX_CH_PACKET), pol_name[usb_tx_policy(TX_CH_PACKET)],
+                (unsigned long)log_ring_dropped(), (unsigned long)usb_tx_room(),
+#ifdef USB_BULK
+                usb_bulk_open() ? "bulk" : "cdc");
+#else
+                "cdc");
+#endif
+}
+#ifdef LED_STRIP_CAL
+/* "cal" lists the strip calibration, "cal 1 b 0.9 1.1" sets strip 1's blue
+ * gain and gamma */
+static void handle_cal(const char *arg)
+{
+    static const char ch_name[] = "rgbw";
+    unsigned s;
+    char     c;
+    float    gain, gamma;
+    if (sscanf(arg, "%u %c %f %f", &s, &c, &gain, &gamma) == 4) {
+        const char *ch = strchr(ch_name, c);
+        if (!c || !ch || !render_strip_cal((uint8_t)s, (uint8_t)(ch - ch_name), gain, gamma)) {
+            USBD_UsrLog("cal: <0..%u> <r|g|b|w> <gain 0..2> <gamma 0..4>\n", LED_STRIP_CAL_MAX - 1);
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < LED_STRIP_CAL_MAX; ++i) {
+        const StripCal *k = render_strip_cal_get(i);
+        USBD_UsrLog("cal %u: gain %g %g %g %g, gamma %g %g %g %g (0 = 1)\n", i,
+                    k->gain[0], k->gain[1], k->gain[2], k->gain[3],
+                    k->gamma[0], k->gamma[1], k->gamma[2], k->gamma[3]);
+    }
+}
+#endif
+/* ────────────────────────────────────────────────────────────────────────  */
+static void handle_line(char *msg)
+{
+    /* 1. Trim whitespace ----------------------------------------------- */
     while (isspace((unsigned char)*msg)) ++msg;
     size_t len = strlen(msg);
     while (len && isspace((unsigned char)msg[len-1])) msg[--len] = '\0';
@@ -246,48 +676,399 @@ void usb_comms_process(void)
         debug_save_and_dump();
         return;
     }
+    if (strcmp(msg, "forget") == 0) {
+        debug_forget_saved();
+        return;
+    }
     if (strcmp(msg, "help") == 0) {
         send_help();
         return;
     }
+    if (strncmp(msg, "scene ", 6) == 0) {
+        PolyBuilder build = scene_builder(msg + 6);
+        if (!build) {
+            USBD_UsrLog("scene: tetra cube octa icosa dodeca icosidodeca\n");
+            return;
+        }
+        scene_reload(build);
+        return;
+    }
+    if (strncmp(msg, "palette", 7) == 0) {
+        int pal = palette_find(msg[7] == ' ' ? msg + 8 : NULL);
+        if (pal < 0) {
+            char   names[128];
+            size_t pos = 0;
+            for (uint8_t i = 0; i < palette_count() && pos < sizeof names; ++i)
+                pos += snprintf(names + pos, sizeof names - pos, " %s", palette_get(i)->name);
+            USBD_UsrLog("palette:%s\n", names);
+            return;
+        }
+        palette_select((uint8_t)pal, PALETTE_BLEND_MS);
+        return;
+    }
+    if (strncmp(msg, "layer ", 6) == 0) {
+        handle_layer(msg + 6);
+        return;
+    }
+    if (strncmp(msg, "highlight", 9) == 0) {
+        debug_highlight_vertex = (msg[9] == ' ') ? (poly_idx_t)atoi(msg + 10) : POLY_IDX_NONE;
+        return;
+    }
+    if (strncmp(msg, "seed", 4) == 0) {
+        if (msg[4] == ' ') {
+            rng_seed((uint32_t)strtoul(msg + 5, NULL, 0));
+            anim_release();            /* restarted on the next tick, streams from the new seed */
+        }
+        USBD_UsrLog("seed: %lu\n", (unsigned long)rng_seed_get());
+        return;
+    }
+    if (strncmp(msg, "quality", 7) == 0) {
+        if (msg[7] == ' ') {
+            gov_force(isdigit((unsigned char)msg[8]) ? (int8_t)atoi(msg + 8) : -1);   /* "auto" */
+        }
+        USBD_UsrLog("quality: %u%s\n", gov_level(), gov_forced() ? "" : " (auto)");
+        return;
+    }
+    if (strcmp(msg, "clock") == 0 || strncmp(msg, "clock ", 6) == 0) {
+#ifdef LED_CLOCK_SCALE
+        if (msg[5] == ' ') {
+            clk_scale_force(isdigit((unsigned char)msg[6]) ? (int8_t)atoi(msg + 6) : -1);   /* "auto" */
+        }
+        clk_scale_report();
+#else
+        USBD_UsrLog("clock: built without LED_CLOCK_SCALE\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "hud") == 0 || strncmp(msg, "hud ", 4) == 0) {
+        bool on = (msg[3] == ' ') ? strcmp(msg + 4, "off") != 0 : !hud_shown();   /* bare: toggle */
+        if (!hud_show(on)) {
+            USBD_UsrLog("hud: no \"hud\" animation, or it runs on another layer\n");
+        }
+        USBD_UsrLog("hud: %s\n", hud_shown() ? "on" : "off");
+        return;
+    }
+    if (strcmp(msg, "supply") == 0) {
+#ifdef LED_SUPPLY_MON
+        supply_report();
+#else
+        USBD_UsrLog("supply: built without LED_SUPPLY_MON\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "param") == 0 || strncmp(msg, "param ", 6) == 0) {
+        handle_param(msg + 5);
+        return;
+    }
+    if (strncmp(msg, "preset ", 7) == 0) {
+        handle_preset(msg + 7);
+        return;
+    }
+    if (strcmp(msg, "script") == 0 || strncmp(msg, "script ", 7) == 0) {
+        handle_script(msg + 6);
+        return;
+    }
+    if (strcmp(msg, "stream") == 0 || strncmp(msg, "stream ", 7) == 0) {
+        handle_stream(msg + 6);
+        return;
+    }
+    if (strcmp(msg, "tx") == 0 || strncmp(msg, "tx ", 3) == 0) {
+        handle_tx(msg + 2);
+        return;
+    }
+    if (strcmp(msg, "telem") == 0 || strncmp(msg, "telem ", 6) == 0) {
+        if (msg[5] == ' ') telemetry_set_interval((uint16_t)strtoul(msg + 6, NULL, 10));
+        USBD_UsrLog("telem: %u ms%s\n", telemetry_interval(), telemetry_interval() ? "" : " (off)");
+        return;
+    }
+    if (strcmp(msg, "mirror") == 0 || strncmp(msg, "mirror ", 7) == 0) {
+        if (msg[6] == ' ') {
+            unsigned long f = strtoul(msg + 7, NULL, 10);
+            mirror_set_fps((uint8_t)(f > 255 ? 255 : f));
+        }
+        const MirrorStats *m = mirror_stats();
+        USBD_UsrLog("mirror: %u fps%s, %lu frames, %lu skipped\n", mirror_fps(),
+                    mirror_fps() ? "" : " (off)", (unsigned long)m->sent, (unsigned long)m->skipped);
+        return;
+    }
+    if (strcmp(msg, "sync") == 0) {
+        const FrameSyncStats *f = frame_sync_stats();
+        USBD_UsrLog("sync: %s, frame %lu, %lu samples, offset %ld us, error %ld us\n",
+                    f->locked ? "locked" : "free", (unsigned long)f->frame,
+                    (unsigned long)f->samples, (long)f->offset_us, (long)f->error_us);
+#ifdef FRAME_SOF_LOCK
+        const SofLockStats *l = sof_lock_stats();
+        USBD_UsrLog("sof: %s, %ld ppm (last %ld), %lu windows, %lu rejected\n",
+                    l->locked ? "trimmed" : "measuring", (long)l->ppm, (long)l->last_ppm,
+                    (unsigned long)l->windows, (unsigned long)l->rejected);
+#endif
+        return;
+    }
+    if (strcmp(msg, "link") == 0) {
+#if defined(LED_LINK_MASTER) || defined(LED_LINK_SLAVE)
+        const LinkStats *l = link_stats();
+        USBD_UsrLog("link: %lu frames, %lu bytes, %lu dropped, %lu torn, %lu no base, %lu errors\n",
+                    (unsigned long)l->frames, (unsigned long)l->bytes, (unsigned long)l->dropped,
+                    (unsigned long)l->torn, (unsigned long)l->no_base, (unsigned long)l->errors);
+#else
+        USBD_UsrLog("link: built without LED_LINK_MASTER / LED_LINK_SLAVE\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "boot") == 0) {
+        boot_report();
+        return;
+    }
+    if (strcmp(msg, "mem") == 0) {
+        scene_mem_report();
+        return;
+    }
+    if (strcmp(msg, "stack") == 0) {
+        stack_report();
+        return;
+    }
+    if (strcmp(msg, "sched") == 0) {
+        sched_report();
+        return;
+    }
+    if (strncmp(msg, "bench encode", 12) == 0) {
+        if (!render_bench_encode((uint16_t)strtoul(msg + 12, NULL, 0))) {
+            USBD_UsrLog("bench encode: out of heap\n");
+        }
+        return;
+    }
+    if (strncmp(msg, "bench wire", 10) == 0) {
+        render_bench_wire((uint16_t)strtoul(msg + 10, NULL, 0));
+        return;
+    }
+    if (strcmp(msg, "bench") == 0 || strncmp(msg, "bench ", 6) == 0) {
+#ifdef LED_PROFILE
+        unsigned long n = msg[5] ? strtoul(msg + 6, NULL, 0) : 0;
+        if (strcmp(msg + 5, " stop") == 0) {
+            bench_stop();
+            USBD_UsrLog("bench: stopped\n");
+        } else if (bench_start((uint16_t)(n > BENCH_FRAMES_MAX ? BENCH_FRAMES_MAX : n))) {
+            USBD_UsrLog("bench: %u animations\n", anim_count());
+        } else {
+            USBD_UsrLog("bench: %s\n", bench_running() ? "already running" : "out of heap");
+        }
+#else
+        USBD_UsrLog("bench: built without LED_PROFILE\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "pcs") == 0 || strncmp(msg, "pcs ", 4) == 0) {
+#ifdef LED_PC_SAMPLE
+        if (msg[3] == ' ') pcs_set_hz((uint16_t)strtoul(msg + 4, NULL, 10));
+        const PcsStats *p = pcs_stats();
+        USBD_UsrLog("pcs: %u Hz%s, %lu samples, %lu sent, %lu dropped\n", pcs_hz(),
+                    pcs_hz() ? "" : " (off)", (unsigned long)p->samples,
+                    (unsigned long)p->sent, (unsigned long)p->dropped);
+#else
+        USBD_UsrLog("pcs: built without LED_PC_SAMPLE\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "irq") == 0 || strncmp(msg, "irq ", 4) == 0) {
+#ifdef LED_IRQ_STATS
+        if (strcmp(msg + 3, " on") == 0)  irq_set_stream(true);
+        if (strcmp(msg + 3, " off") == 0) irq_set_stream(false);
+        irq_report();
+#else
+        USBD_UsrLog("irq: built without LED_IRQ_STATS\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "bb") == 0 || strncmp(msg, "bb ", 3) == 0) {
+#ifdef LED_BLACKBOX
+        const char *arg = msg + 2;
+        while (*arg == ' ') ++arg;
+        if (strcmp(arg, "dump") == 0) {
+            bb_dump_start();        /* streamed out by bb_tick() */
+            return;
+        }
+        if (strcmp(arg, "arm") == 0)           bb_arm();
+        else if (*arg >= '0' && *arg <= '9')   bb_set_spike_us(strtoul(arg, NULL, 10));
+        bb_report();
+#else
+        USBD_UsrLog("bb: built without LED_BLACKBOX\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "rec") == 0 || strncmp(msg, "rec ", 4) == 0) {
+#ifdef LED_REPLAY
+        const char *arg = msg + 3;
+        while (*arg == ' ') ++arg;
+        if (strcmp(arg, "dump") == 0) {
+            replay_dump_start();    /* streamed out by replay_tick() */
+            return;
+        }
+        bool ok = true;
+        if      (strcmp(arg, "start") == 0) ok = replay_record();
+        else if (strcmp(arg, "stop") == 0)  replay_stop();
+        else if (strcmp(arg, "play") == 0)  ok = replay_play();
+        if (!ok) {
+            USBD_UsrLog("rec: busy, or nothing to play\n");
+        }
+        replay_report();
+#else
+        USBD_UsrLog("rec: built without LED_REPLAY\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "cal") == 0 || strncmp(msg, "cal ", 4) == 0) {
+#ifdef LED_STRIP_CAL
+        handle_cal(msg + 3);
+#else
+        USBD_UsrLog("cal: built without LED_STRIP_CAL\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "calib") == 0 || strncmp(msg, "calib ", 6) == 0) {
+#ifdef LED_CALIB
+        const char *arg = msg + 5;
+        while (*arg == ' ') ++arg;
+        if (strncmp(arg, "set ", 4) == 0) {
+            char *end;
+            unsigned long e    = strtoul(arg + 4, &end, 10);
+            unsigned long phys = strtoul(end, &end, 10);
+            unsigned long flip = strtoul(end, NULL, 10);
+            if (!calib_set((poly_idx_t)e, (poly_idx_t)phys, flip != 0)) {
+                USBD_UsrLog("calib: set %lu %lu out of range\n", e, phys);
+            }
+        } else if (strcmp(arg, "apply") == 0) {
+            if (!calib_apply()) {
+                USBD_UsrLog("calib: map incomplete or not a permutation, nothing applied\n");
+            }
+        } else if (strcmp(arg, "stop") == 0) {
+            calib_stop();
+        } else {
+            calib_start((uint16_t)strtoul(arg, NULL, 10));
+        }
+#else
+        USBD_UsrLog("calib: built without LED_CALIB\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "audio") == 0) {
+#ifdef AUDIO_FRAMES
+        const AudioStats *a = audio_stats();
+        const AudioFrame *f = audio_frame();
+        USBD_UsrLog("audio: %lu blocks, %lu lost, %lu deferred, max %lu us, %lu host packets, "
+                    "%lu onsets, %.1f bpm\n",
+                    (unsigned long)a->blocks, (unsigned long)a->lost, (unsigned long)a->deferred,
+                    (unsigned long)a->max_us, (unsigned long)a->host, (unsigned long)f->onsets,
+                    (double)f->bpm);
+        char line[8 * AUDIO_BANDS + 16];
+        int  n = 0;
+        for (uint8_t b = 0; b < AUDIO_BANDS; ++b) {
+            n += snprintf(line + n, sizeof line - n, " %.2f", (double)f->band[b]);
+        }
+        USBD_UsrLog("audio: bands%s, flux %.1f dB\n", line, (double)f->flux);
+#else
+        USBD_UsrLog("audio: built without LED_AUDIO / LED_AUDIO_HOST\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "clip") == 0 || strncmp(msg, "clip ", 5) == 0) {
+#ifdef LED_CLIP
+        const char *arg = msg + 4;
+        while (*arg == ' ') ++arg;
+        uint16_t leds;
+        float    fps;
+        uint32_t frames, bytes;
+        if (strcmp(arg, "stop") == 0) {
+            clip_stop();
+        } else if (strcmp(arg, "play") == 0 || strcmp(arg, "loop") == 0) {
+            if (!clip_play(arg[0] == 'l')) {
+                USBD_UsrLog("clip: none stored, torn, or not for %u LEDs\n",
+                            (unsigned)mapping_get_total_pixels());
+            }
+        } else if (!clip_info(&leds, &fps, &frames, &bytes)) {
+            USBD_UsrLog("clip: none stored (%lu bytes of room)\n", (unsigned long)CLIP_SIZE);
+        } else {
+            const ClipStats *c = clip_stats();
+            USBD_UsrLog("clip: %lu frames, %u LEDs, %.1f fps, %lu bytes; %s, %lu decoded, "
+                        "%lu shown, %lu loops, %lu bad, max %lu us\n",
+                        (unsigned long)frames, (unsigned)leds, (double)fps, (unsigned long)bytes,
+                        clip_playing() ? "playing" : "stopped", (unsigned long)c->frames,
+                        (unsigned long)c->shown, (unsigned long)c->loops, (unsigned long)c->bad,
+                        (unsigned long)c->max_us);
+        }
+#else
+        USBD_UsrLog("clip: built without LED_CLIP\n");
+#endif
+        return;
+    }
+    if (strcmp(msg, "trace") == 0) {
+#ifdef LED_TRACE
+        trace_dump_start();        /* streamed out by trace_tick() */
+#else
+        USBD_UsrLog("trace: built without LED_TRACE\n");
+#endif
+        return;
+    }
+    if (strncmp(msg, GYRO_CMD, sizeof GYRO_CMD - 1) == 0) {
+        handle_gyro(msg + sizeof GYRO_CMD - 1);
+        return;
+    }
     if (strcmp(msg, GEO_DUMP_CMD) == 0) {
-           geo_dump_model(&poly, "poly");
+           if (!sched_job("dumpgeo", geo_dump_step)) geo_dump_model(&poly, "poly");
            return;
        }
+    if (strcmp(msg, GEO_HASH_CMD) == 0) {
+        announce_geometry();
+        return;
+    }
+    if (strcmp(msg, GEO_BIN_CMD) == 0) {
+        if (!sched_job("dumpgeob", geo_bin_step)) {
+            USBD_UsrLog("dumpgeob: jobs full\n");
+        }
+        return;
+    }
 
     /* 3. Single-letter commands ---------------------------------------- */
     char cmd = msg[0];
     const char *arg = msg + 1;
     while (isspace((unsigned char)*arg)) ++arg;   /* tolerate spaces */
 
+    uint16_t set;
+    bool     absolute = parse_set(arg, &set);
+
     switch (cmd) {
     case 'f':  /* face */
-        debug_change_face(parse_delta(arg));
+        if (absolute) debug_set_face(set);
+        else          debug_change_face(parse_delta(arg));
         break;
 
     case 'b':  /* bar / physical bar index */
-        debug_change_bar(parse_delta(arg));
+        if (absolute) debug_set_bar(set);
+        else          debug_change_bar(parse_delta(arg));
         break;
 
     case 'e':  /* edge slot in current face */
-        debug_change_slot(parse_delta(arg));
+        if (absolute) debug_set_slot((uint8_t)set);
+        else          debug_change_slot(parse_delta(arg));
         break;
 
     case 'm': {
-        int delta = (int)parse_delta(arg);
-        mode = (mode + delta) % 7;  // wrap around if needed
+        int mode = absolute ? set : debug_mode() + (int)parse_delta(arg);
+        mode = (mode % DEBUG_MODE_COUNT + DEBUG_MODE_COUNT) % DEBUG_MODE_COUNT;  // wrap around if needed
         debug_change_mode((uint8_t)mode);
-        USBD_UsrLog("Mode: %d", mode);
+        const Animation *anim = (mode < ANIM_6) ? anim_get((uint8_t)mode) : NULL;
+        USBD_UsrLog("Mode: %d %s", mode, anim ? anim->name : "edges");
         break;
     }
 
     case 'h':
-    	debug_change_hue(parse_delta(arg));
+        if (absolute) debug_set_hue((uint8_t)set);
+        else          debug_change_hue(parse_delta(arg));
     	break;
 
     case 'r':  /* reverse / flip */
-        if (*arg != '\0') { send_help(); return; }
-        debug_toggle_flip();
+        if (absolute)           debug_set_flip(set != 0);
+        else if (*arg != '\0') { send_help(); return; }
+        else                    debug_toggle_flip();
         break;
 
     case 'g':  /* geo → dump vertices & edges */
@@ -299,6 +1080,67 @@ void usb_comms_process(void)
         send_help();
         return;
     }
+    /* drawn by the next frame tick, input renders nothing itself */
+}
+
+bool usb_comms_run_line(const char *line)
+{
+    char buf[sizeof rx_line];
+    strncpy(buf, line, sizeof buf - 1);
+    buf[sizeof buf - 1] = '\0';
+    handle_line(buf);               /* trims in place */
+    return true;
+}
+
+bool usb_comms_rx_pending(void)
+{
+    return spsc_used(&rx_ring) != 0 || usb_packet_rx_pending();
+}
+
+/* ────────────────────────────────────────────────────────────────────────  */
+static bool usb_greeted = false; // only say hewooo once
+static bool geo_announced = false; // once per host open
+void usb_comms_process(void)
+{
+    if (!usb_greeted &&
+        hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED) {
+        usb_greeted = true;
+        USBD_UsrLog("Debug interface ready. Type \"help\" for commands.\n");
+    }
+    if (!host_open) {
+        geo_announced = false;
+    } else if (!geo_announced && cdc_ready()) {
+        geo_announced = true;
+        announce_geometry();
+    }
+
+    usb_packet_poll();
 
-    debug_ui_tick();
+    /* every complete line queued since the last poll, in order */
+    uint8_t  chunk[64];
+    uint16_t n;
+    while ((n = spsc_pop(&rx_ring, chunk, sizeof chunk)) != 0) {
+        for (uint16_t i = 0; i < n; ++i) {
+            char c = (char)chunk[i];
+            if (c == '\n' || c == '\r') {
+                rx_line[rx_line_len] = '\0';
+                if (rx_line_drop) {         /* USBD_UsrLog is two statements */
+                    USBD_UsrLog("rx: line over %u bytes dropped\n", (unsigned)sizeof rx_line - 1);
+                } else if (rx_line_len &&
+                           replay_note(REPLAY_LINE, (const uint8_t *)rx_line, (uint8_t)rx_line_len)) {
+                    handle_line(rx_line);
+                }
+                rx_line_len  = 0;
+                rx_line_drop = false;
+            } else if (rx_line_len < sizeof rx_line - 1) {
+                rx_line[rx_line_len++] = c;
+            } else {
+                rx_line_drop = true;
+            }
+        }
+    }
+    if (rx_overrun) {
+        USBD_UsrLog("rx: %lu bytes lost, ring full\n", (unsigned long)rx_overrun);
+        rx_overrun = 0;
+    }
 }
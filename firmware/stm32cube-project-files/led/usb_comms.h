@@ -18,13 +18,65 @@ extern "C" {
 #else
 #define TX_BUF_SIZE DEBUG_TX_BUF_SIZE
 #endif
+#if TX_BUF_SIZE & (TX_BUF_SIZE - 1)
+#error "TX_BUF_SIZE must be a power of two"
+#endif
 
 #ifndef DEBUG_TX_DROP_CHUNK
 #define TX_DROP_CHUNK 256     /* drop oldest bytes on overflow */
 #else
-#define TX_BUF_SIZE DEBUG_TX_DROP_CHUNK
+#define TX_DROP_CHUNK DEBUG_TX_DROP_CHUNK
+#endif
+
+/* the bulk pipe's ring (USB_BULK, usb_bulk.h), power of two too; it goes
+ * out in transfers as long as its contiguous part, not in console chunks */
+#ifndef TX_BULK_SIZE
+#define TX_BULK_SIZE  4096
+#endif
+
+/* longest a TX_BLOCK write waits for the host before it is dropped */
+#ifndef TX_BLOCK_MS
+#define TX_BLOCK_MS   20
 #endif
 
+/* --------------------------------------------------------------------------
+ * TX CHANNELS
+ *
+ * Everything goes out of one ring; each writer names its channel and the
+ * channel's policy says what happens when the ring is full:
+ *
+ *   TX_PRIORITY  the oldest unsent bytes make room (TX_DROP_CHUNK at a
+ *                time), the newest output always gets in
+ *   TX_DROP      the write is dropped whole
+ *   TX_BLOCK     the main loop waits up to TX_BLOCK_MS for the host to
+ *                take some, then drops; from an ISR or with no host it drops
+ *
+ * Text (printf) defaults to TX_PRIORITY, as the log always was; packets to
+ * TX_BLOCK, a torn packet is lost anyway and the deferred log dumps should
+ * not be. Dropped bytes are counted per channel ("tx" on the console).
+ *
+ * A pipe is an IN endpoint with its own ring: the CDC console, and with
+ * USB_BULK the vendor bulk pipe, which packets take while the host
+ * listens there (usb_bulk.h). Text always goes to the console.
+ * -------------------------------------------------------------------------- */
+typedef enum {
+    TX_CH_TEXT,             /* printf / USBD_UsrLog */
+    TX_CH_PACKET,           /* usb_packet_send: replies, PKT_LOG */
+    TX_CH_COUNT
+} TxChannel;
+
+typedef enum {
+    TX_PIPE_CDC,
+    TX_PIPE_BULK,           /* USB_BULK only */
+    TX_PIPE_COUNT
+} TxPipe;
+
+typedef enum {
+    TX_PRIORITY,
+    TX_DROP,
+    TX_BLOCK,
+} TxPolicy;
+
 /* --------------------------------------------------------------------------
  * USB CDC COMMAND INTERFACE
  * -------------------------------------------------------------------------- */
@@ -49,6 +101,12 @@ void usb_set_host_open(bool open);
  */
 void usb_tx_complete_isr(void);
 
+/**
+ * @brief  A pipe's transfer completed, or was cut off by a (re)configuration:
+ *         its ring memory is free again, the next chunk goes (USB ISR).
+ */
+void usb_tx_pipe_done(TxPipe pipe);
+
 /**
  * @brief  Poll-based handler to process any received commands.
  *         Should be called regularly in main loop.
@@ -56,6 +114,18 @@ void usb_tx_complete_isr(void);
  */
 void usb_comms_process(void);
 
+/**
+ * @brief  Run one console line as if it had come in (a replay, replay.h).
+ * @return false: there is no console to run it (host build)
+ */
+bool usb_comms_run_line(const char *line);
+
+/**
+ * @brief  Console or packet bytes from the host are waiting for
+ *         usb_comms_process().
+ */
+bool usb_comms_rx_pending(void);
+
 /**
  * @brief  Retargeted printf write handler to buffer USB logs.
  *         Called by newlib (e.g. printf).
@@ -71,6 +141,34 @@ int _write(int file, char *ptr, int len);
  */
 void flush_usb_buffer(void);
 
+/**
+ * @brief  Free bytes in the TX ring, for bulk dumps that must not overrun it.
+ */
+uint32_t usb_tx_room(void);
+
+/**
+ * @brief  Free bytes in the ring a channel writes to now (packets may take
+ *         the bulk pipe).
+ */
+uint32_t usb_tx_channel_room(TxChannel ch);
+
+/**
+ * @brief  Queue bytes on a channel, from anywhere: the main loop and the
+ *         USB ISR write the ring, other interrupts queue through the log
+ *         ring (log_ring.h), up to LOG_RING_SIZE / 2 at a time. TX_BLOCK
+ *         only waits in the main loop.
+ * @return Bytes queued, len unless some were dropped.
+ */
+uint32_t usb_tx_write(TxChannel ch, const void *buf, uint32_t len);
+
+void     usb_tx_set_policy(TxChannel ch, TxPolicy p);
+TxPolicy usb_tx_policy(TxChannel ch);
+
+/**
+ * @brief  Bytes dropped on a channel since boot.
+ */
+uint32_t usb_tx_dropped(TxChannel ch);
+
 #ifdef __cplusplus
 }
 #endif
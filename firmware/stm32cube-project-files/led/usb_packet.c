@@ -0,0 +1,334 @@
+/* --------------------------------------------------------------------------
+ * usb_packet.c – COBS framing, CRC check and the packet type table
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "usb_packet.h"
+#include "usb_comms.h"       /* usb_tx_write */
+#include "spsc_ring.h"
+#include "crc.h"             /* hcrc (MX_CRC_Init) */
+#include "led_params.h"      /* param_frame */
+#include "led_vm.h"          /* vm_frame_handle */
+#include "led_view.h"        /* view_set_euler, view_orient_sample */
+#include "led_debug.h"       /* debug_control */
+#include "frame_sync.h"      /* frame_sync_sample */
+#include "latency.h"         /* latency_probe */
+#include "replay.h"          /* replay_note: recorded, or ignored while a replay plays */
+#include "audio.h"           /* audio_host_feat */
+#include "clip.h"            /* clip_packet */
+
+#define HDR_LEN         2u                                  /* type, len */
+#define CRC_LEN         4u
+#define RAW_MAX         (HDR_LEN + PKT_PAYLOAD_MAX + CRC_LEN)
+#define ENC_MAX         (RAW_MAX + RAW_MAX / 254 + 1)       /* COBS worst case */
+
+_Static_assert(PKT_OVERHEAD == ENC_MAX + 2u - PKT_PAYLOAD_MAX, "PKT_OVERHEAD: the framing below");
+#define REPLY_MAX       64u
+
+/* RX: the USB ISR pushes, usb_packet_poll() pops */
+SPSC_RING(rx_ring, PKT_RX_RING);
+
+/* the packet being collected, still COBS encoded */
+static uint8_t  enc[ENC_MAX];
+static uint16_t enc_n    = 0;
+static bool     enc_drop = false;       /* too long / overrun: wait for the next 0x00 */
+
+/* arrival times: a chunk that ends on a delimiter leaves its end position
+ * (bytes pushed since boot) and DWT->CYCCNT here, the packet that delimiter
+ * closes looks itself up by position when it is dispatched */
+#define STAMPS          8u
+static volatile uint32_t stamp_at[STAMPS];
+static volatile uint32_t stamp_cyc[STAMPS];
+static uint32_t          stamp_w;       /* ISR */
+static uint32_t          rx_in;         /* ISR: bytes pushed */
+static uint32_t          rx_out;        /* main loop: bytes popped */
+static bool              rx_timed;      /* the packet being dispatched has one */
+static uint32_t          rx_cyc;
+
+/* decoded packet, word aligned for the CRC unit */
+static uint32_t raw_w[(RAW_MAX + 3) / 4];
+
+static PktStats stats;
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * Handlers: payload in, reply payload into out, its length (-1 = no reply)
+ */
+typedef int16_t (*PktHandler)(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap);
+
+static int16_t pkt_ping(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    if (n > cap) n = (uint8_t)cap;
+    memcpy(out, p, n);
+    return n;
+}
+
+static int16_t pkt_param(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    return (int16_t)param_frame(p, n, out, cap);
+}
+
+static int16_t pkt_script(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    return (int16_t)vm_frame_handle(p, n, out, cap);
+}
+
+static int16_t pkt_gyro(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)n; (void)out; (void)cap;
+    ProtoGyro g;
+    proto_gyro_decode(p, &g);
+    view_set_euler(g.xyz[2], g.xyz[1], g.xyz[0]);   /* yaw = z, pitch = y, roll = x */
+    return -1;
+}
+
+static int16_t pkt_orient(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)n; (void)out; (void)cap;
+    ProtoOrient o;
+    proto_orient_decode(p, &o);
+    view_orient_sample(o.host_us, o.q);
+    return -1;
+}
+
+static int16_t pkt_sync(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)n; (void)out; (void)cap;
+    ProtoSync s;
+    proto_sync_decode(p, &s);
+    uint32_t cyc = DWT->CYCCNT;             /* late by the main loop: the filter drops it */
+    usb_packet_rx_time(&cyc);
+    frame_sync_sample(s.host_us, s.frame, s.phase_us, s.period_us, cyc);
+    return -1;
+}
+
+static int16_t pkt_probe(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)n; (void)out; (void)cap;
+    ProtoProbe pr;
+    proto_probe_decode(p, &pr);
+    uint32_t cyc = DWT->CYCCNT;
+    usb_packet_rx_time(&cyc);
+    latency_probe(pr.id, pr.host_us, cyc);
+    return -1;                              /* answered once the frame is out */
+}
+
+#ifdef LED_AUDIO_HOST
+static int16_t pkt_audio(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)n; (void)out; (void)cap;
+    ProtoAudioFeat a;
+    proto_audio_feat_decode(p, &a);
+    audio_host_feat(&a);
+    return -1;
+}
+#endif
+
+static int16_t pkt_control(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)cap;
+    int16_t bad = debug_control(p, n);
+    if (bad < 0) return -1;
+    out[0] = (uint8_t)bad;
+    return 1;
+}
+
+static const struct {
+    uint8_t    type;
+    uint8_t    min_len;     /* shortest payload */
+    PktHandler fn;
+} handlers[] = {
+    { PKT_PING,   0,  pkt_ping   },
+    { PKT_PARAM,  2,  pkt_param  },
+    { PKT_SCRIPT, 2,  pkt_script },
+    { PKT_GYRO,    PROTO_GYRO_SIZE,       pkt_gyro    },
+    { PKT_CONTROL, PROTO_CONTROL_OP_SIZE, pkt_control },
+    { PKT_ORIENT,  PROTO_ORIENT_SIZE,     pkt_orient  },
+    { PKT_SYNC,    PROTO_SYNC_SIZE,       pkt_sync    },
+    { PKT_PROBE,   PROTO_PROBE_SIZE,      pkt_probe   },
+#ifdef LED_AUDIO_HOST
+    { PKT_AUDIO,   PROTO_AUDIO_FEAT_SIZE, pkt_audio   },
+#endif
+#ifdef LED_CLIP
+    { PKT_CLIP,    1,                     clip_packet },
+#endif
+};
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * COBS: every run of non-zero bytes is prefixed with its length + 1, a
+ * full run of 254 has no zero after it
+ */
+static uint16_t cobs_decode(const uint8_t *in, uint16_t n, uint8_t *out, uint16_t cap)
+{
+    uint16_t o = 0;
+    for (uint16_t i = 0; i < n; ) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > n || o + code - 1 > cap) return 0;
+        for (uint8_t k = 1; k < code; ++k) out[o++] = in[i++];
+        if (code != 0xFF && i < n) {
+            if (o >= cap) return 0;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+static uint16_t cobs_encode(const uint8_t *in, uint16_t n, uint8_t *out)
+{
+    uint16_t code_at = 0, o = 1;
+    uint8_t  code    = 1;
+    for (uint16_t i = 0; i < n; ++i) {
+        if (in[i]) {
+            out[o++] = in[i];
+            ++code;
+        }
+        if (!in[i] || code == 0xFF) {
+            out[code_at] = code;
+            code_at = o++;
+            code    = 1;
+        }
+    }
+    out[code_at] = code;
+    return o;
+}
+
+/* over the n bytes at w, zero padded to whole words */
+static uint32_t packet_crc(uint32_t *w, uint16_t n)
+{
+    memset((uint8_t *)w + n, 0, (4u - (n & 3u)) & 3u);
+    return HAL_CRC_Calculate(&hcrc, w, (n + 3u) / 4u);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * TX
+ */
+void usb_packet_send(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+    static uint8_t  out[2 + HDR_LEN + PKT_PAYLOAD_MAX + CRC_LEN + (RAW_MAX / 254 + 1)];
+    static uint32_t tx_w[(RAW_MAX + 3) / 4];   /* own buffer: handlers may log */
+    uint8_t *raw = (uint8_t *)tx_w;
+    raw[0] = type;
+    raw[1] = len;
+    if (len) memcpy(&raw[HDR_LEN], payload, len);
+    uint32_t crc = packet_crc(tx_w, (uint16_t)(HDR_LEN + len));
+    memcpy(&raw[HDR_LEN + len], &crc, CRC_LEN);
+
+    out[0] = 0;
+    uint16_t n = cobs_encode(raw, (uint16_t)(HDR_LEN + len + CRC_LEN), &out[1]);
+    out[1 + n] = 0;
+    usb_tx_write(TX_CH_PACKET, out, n + 2u);
+}
+
+static void send_error(uint8_t type, PktStatus st)
+{
+    const uint8_t e[2] = { type, (uint8_t)st };
+    usb_packet_send(PKT_ERROR, e, sizeof e);
+}
+
+/* ─────────────────────────────────────────────────────────────────────────
+ * RX
+ */
+void usb_packet_rx(const uint8_t *buf, uint32_t len)
+{
+    if (len > PKT_RX_RING) len = PKT_RX_RING;
+    uint16_t n = spsc_push(&rx_ring, buf, (uint16_t)len);
+    if (n < len) ++stats.overrun;                   /* fails its check */
+    rx_in += n;
+    if (n && buf[n - 1] == 0) {
+        uint32_t k = stamp_w++ % STAMPS;
+        stamp_at[k]  = 0;                           /* torn while written: no match */
+        stamp_cyc[k] = DWT->CYCCNT;
+        stamp_at[k]  = rx_in;
+    }
+}
+
+/* the stamp left for the delimiter at byte position pos, if still there */
+static bool stamp_find(uint32_t pos, uint32_t *cyc)
+{
+    for (uint32_t k = 0; k < STAMPS; ++k) {
+        if (stamp_at[k] != pos) continue;
+        uint32_t c = stamp_cyc[k];
+        if (stamp_at[k] != pos) return false;       /* overwritten meanwhile */
+        *cyc = c;
+        return true;
+    }
+    return false;
+}
+
+static void dispatch(uint16_t enc_len)
+{
+    uint8_t *raw = (uint8_t *)raw_w;
+    uint16_t n   = cobs_decode(enc, enc_len, raw, RAW_MAX);
+    if (n < HDR_LEN + CRC_LEN || n != HDR_LEN + raw[1] + CRC_LEN) {
+        ++stats.bad;
+        send_error(n ? raw[0] : 0, PKT_ERR_LEN);
+        return;
+    }
+    uint8_t  type = raw[0], len = raw[1];
+    uint32_t crc;
+    memcpy(&crc, &raw[HDR_LEN + len], CRC_LEN);
+    if (packet_crc(raw_w, (uint16_t)(HDR_LEN + len)) != crc) {
+        ++stats.crc;
+        send_error(type, PKT_ERR_CRC);
+        return;
+    }
+
+    if (replay_note(type, &raw[HDR_LEN], len)) usb_packet_run(type, &raw[HDR_LEN], len);
+}
+
+void usb_packet_run(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+    for (uint8_t i = 0; i < sizeof handlers / sizeof *handlers; ++i) {
+        if (handlers[i].type != type) continue;
+        if (len < handlers[i].min_len) {
+            ++stats.bad;
+            send_error(type, PKT_ERR_LEN);
+            return;
+        }
+        uint8_t reply[REPLY_MAX];
+        int16_t r = handlers[i].fn(payload, len, reply, sizeof reply);
+        ++stats.ok;
+        if (r >= 0) usb_packet_send((uint8_t)(type | PKT_REPLY), reply, (uint8_t)r);
+        return;
+    }
+    ++stats.bad;
+    send_error(type, PKT_ERR_TYPE);
+}
+
+void usb_packet_poll(void)
+{
+    uint8_t  chunk[64];
+    uint16_t n;
+    while ((n = spsc_pop(&rx_ring, chunk, sizeof chunk)) != 0) {
+        for (uint16_t i = 0; i < n; ++i) {
+            uint8_t b = chunk[i];
+            if (b == 0) {                   /* delimiter: a packet ends (or none started) */
+                if (enc_n && !enc_drop) {
+                    rx_timed = stamp_find(rx_out + i + 1u, &rx_cyc);
+                    dispatch(enc_n);
+                    rx_timed = false;           /* a replayed packet has no time */
+                } else if (enc_drop) {
+                    ++stats.bad;
+                }
+                enc_n    = 0;
+                enc_drop = false;
+            } else if (enc_n < sizeof enc) {
+                enc[enc_n++] = b;
+            } else {
+                enc_drop = true;
+            }
+        }
+        rx_out += n;
+    }
+}
+
+bool usb_packet_rx_pending(void)
+{
+    return spsc_used(&rx_ring) != 0;
+}
+
+bool usb_packet_rx_time(uint32_t *cyc)
+{
+    if (rx_timed) *cyc = rx_cyc;
+    return rx_timed;
+}
+
+const PktStats *usb_packet_stats(void) { return &stats; }
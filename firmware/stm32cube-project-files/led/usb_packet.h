@@ -0,0 +1,95 @@
+/*
+ * usb_packet.h – binary packets next to the text console
+ *
+ * For tools, not people: no trimming, no strcmp, no atof. A packet is COBS
+ * framed (a 0x00 before and after it, none inside), so the stream resyncs
+ * at the next 0x00 after a lost or torn one. Decoded it is
+ *
+ *   type u8 | len u8 | payload[len] | crc u32 (little endian)
+ *
+ * crc is the CRC unit's (CRC-32/MPEG-2: poly 0x04C11DB7, init ~0, no
+ * reflection, no final xor) over type, len and payload, zero padded to
+ * whole words, each word read little endian. Packets go through a type
+ * table; an answer has the request's type | PKT_REPLY, a packet that is
+ * refused gets PKT_ERROR (type, PktStatus). Replies are framed the same way
+ * and share the USB stream with the text log.
+ *
+ * USB chunks that start with 0x00 (or continue an unfinished packet) are
+ * packets, anything else goes to the text console as before.
+ */
+
+#ifndef _USB_PACKET_H_
+#define _USB_PACKET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "proto.h"           /* PktType, payload layouts (tools/protocol.def) */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PKT_PAYLOAD_MAX         255
+/* bytes one packet takes in the TX ring on top of its payload: header, crc,
+ * COBS, delimiters (usb_tx_channel_room() checks before a send) */
+#define PKT_OVERHEAD            (2u + 4u + 2u + 2u)
+/* bytes the ISR can queue before usb_packet_poll() drains them (power of two) */
+#ifndef PKT_RX_RING
+  #define PKT_RX_RING           512
+#endif
+
+typedef enum {
+    PKT_OK,
+    PKT_ERR_TYPE,           /* nothing handles this type */
+    PKT_ERR_LEN,            /* payload too short / len does not match */
+    PKT_ERR_CRC,
+} PktStatus;
+
+typedef struct {
+    uint32_t ok;            /* dispatched */
+    uint32_t crc;           /* refused: CRC mismatch */
+    uint32_t bad;           /* refused: framing, length, type */
+    uint32_t overrun;       /* RX ring full, bytes lost */
+} PktStats;
+
+/**
+ * Queue received bytes (USB ISR)
+ */
+void usb_packet_rx(const uint8_t *buf, uint32_t len);
+
+/**
+ * Decode and dispatch whatever is queued (main loop)
+ */
+void usb_packet_poll(void);
+
+/**
+ * Hand a decoded packet's payload to its handler, reply and all (the
+ * packets of a replay, replay.h)
+ */
+void usb_packet_run(uint8_t type, const uint8_t *payload, uint8_t len);
+
+/**
+ * Bytes queued that usb_packet_poll() has not seen yet
+ */
+bool usb_packet_rx_pending(void);
+
+/**
+ * When the packet being handled came in (handlers only): DWT->CYCCNT in the
+ * USB ISR, for a packet that ended its USB transfer (sent on its own)
+ * @return false: not known, it shared a transfer with what came after it
+ */
+bool usb_packet_rx_time(uint32_t *cyc);
+
+/**
+ * Encode and send one packet (PKT_PAYLOAD_MAX at most)
+ */
+void usb_packet_send(uint8_t type, const uint8_t *payload, uint8_t len);
+
+const PktStats *usb_packet_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _USB_PACKET_H_ */
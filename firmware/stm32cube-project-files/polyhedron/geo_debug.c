@@ -1,14 +1,17 @@
 /* --------------------------------------------------------------------------
  * geo_debug.c – Geometry wireframe dumper implementation
  * -------------------------------------------------------------------------- */
-#include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include "geo_debug.h"
-#include "usb_comms.h"   /* USBD_UsrLog */
+#include "dlog.h"        /* DLOG */
+#include "usb_comms.h"   /* usb_tx_channel_room */
+#include "usb_packet.h"  /* usb_packet_send, PKT_OVERHEAD */
 #include "led_anim.h"      // for vertex_hue_from_xyz()
 #include "led_debug.h" // debug_hue
+#include "led_mapping.h"    // mapping_get_edge_info()
 
-static float edge_len(const Polyhedron *p, uint8_t e)
+static float edge_len(const Polyhedron *p, poly_idx_t e)
 {
     Edge ed = p->e[e];
     const float *A = p->v[ed.a];
@@ -22,28 +25,28 @@ static float edge_len(const Polyhedron *p, uint8_t e)
 void geo_dump_wireframe(const Polyhedron *p, const char *name)
 {
     /* Start dump with tag and metadata */
-    USBD_UsrLog("#geo# %s V=%u E=%u", name, p->V, p->E);
+    DLOG("#geo# %s V=%u E=%u", name, p->V, p->E);
 
     /* Emit each vertex */
-    for (uint8_t v = 0; v < p->V; ++v) {
-        USBD_UsrLog("v %u %.6f %.6f %.6f",
-                    v,
-                    (double)p->v[v][0],
-                    (double)p->v[v][1],
-                    (double)p->v[v][2]);
+    for (poly_idx_t v = 0; v < p->V; ++v) {
+        DLOG("v %u %.6f %.6f %.6f",
+             v,
+             (double)p->v[v][0],
+             (double)p->v[v][1],
+             (double)p->v[v][2]);
     }
 
     /* Emit each edge with length */
-    for (uint8_t e = 0; e < p->E; ++e) {
+    for (poly_idx_t e = 0; e < p->E; ++e) {
         Edge ed = p->e[e];
-        USBD_UsrLog("e %u %u %u %.6f",
-                    e,
-                    ed.a, ed.b,
-                    (double)edge_len(p, e));
+        DLOG("e %u %u %u %.6f",
+             e,
+             ed.a, ed.b,
+             (double)edge_len(p, e));
     }
 
     /* End dump marker */
-    USBD_UsrLog("#endgeo#");
+    DLOG("#endgeo#");
 }
 
 
@@ -52,70 +55,256 @@ void geo_dump_wireframe(const Polyhedron *p, const char *name)
 #define VERTS_PER_LINE  4
 #define EDGES_PER_LINE 10
 
-void geo_dump_model(const Polyhedron *p, const char *tag)
+/* lines per section of the model dump, for geo_dump_model_step() */
+static uint32_t lines(uint32_t n, uint32_t per) { return (n + per - 1) / per; }
+
+bool geo_dump_model_step(const Polyhedron *p, const char *tag, uint32_t step)
 {
+    const EdgeLedInfo *li = mapping_get_edge_info();
+    bool with_leds = li && mapping_get_edge_count() == p->E;
+    uint32_t n_v = lines(p->V, VERTS_PER_LINE);
+    uint32_t n_e = lines(p->E, EDGES_PER_LINE);
+    uint32_t n_l = with_leds ? n_e : 0;
+
     // header: still include V, E, F counts
-    USBD_UsrLog("#geo# %s V=%u E=%u F=%u",
-                tag, p->V, p->E, p->F);
-
-    // --- chunked vertex lines ---
-    {
-        char buf[256];
-        int pos;
-        for (uint8_t start = 0; start < p->V; start += VERTS_PER_LINE) {
-            pos = snprintf(buf, sizeof(buf), "V:");
-            for (uint8_t v = start;
-                 v < p->V && v < start + VERTS_PER_LINE;
-                 ++v)
-            {
-                uint8_t h;
-                vertex_hue_from_xyz(p->v[v], &h, debug_hue);
-                pos += snprintf(buf + pos, sizeof(buf) - pos,
-                    "%u,(%.3f,%.3f,%.3f,%u); ",
-                    v,
-                    p->v[v][0], p->v[v][1], p->v[v][2],
-                    h
-                );
-            }
-            USBD_UsrLog("%s", buf);
+    if (step == 0) {
+        DLOG("#geo# %s V=%u E=%u F=%u",
+             tag, p->V, p->E, p->F);
+        return true;
+    }
+    step -= 1;
+
+    // --- chunked vertex lines, sent in pieces ---
+    if (step < n_v) {
+        poly_idx_t start = (poly_idx_t)(step * VERTS_PER_LINE);
+        DLOG_RAW("V:");
+        for (poly_idx_t v = start;
+             v < p->V && v < start + VERTS_PER_LINE;
+             ++v)
+        {
+            uint8_t h;
+            vertex_hue_from_xyz(p->v[v], &h, debug_hue);
+            DLOG_RAW("%u,(%.6f,%.6f,%.6f,%u); ",
+                     v,
+                     p->v[v][0], p->v[v][1], p->v[v][2],
+                     h);
         }
+        DLOG_RAW("\n");
+        return true;
     }
+    step -= n_v;
 
     // --- chunked edge lines ---
-    {
-        char buf[256];
-        int pos;
-        for (uint8_t start = 0; start < p->E; start += EDGES_PER_LINE) {
-            pos = snprintf(buf, sizeof(buf), "E:");
-            for (uint8_t e = start;
-                 e < p->E && e < start + EDGES_PER_LINE;
-                 ++e)
-            {
-                const Edge *ed = &p->e[e];
-                pos += snprintf(buf + pos, sizeof(buf) - pos,
-                    "(%u-%u), ",
-                    ed->a, ed->b
-                );
-            }
-            USBD_UsrLog("%s", buf);
+    if (step < n_e) {
+        poly_idx_t start = (poly_idx_t)(step * EDGES_PER_LINE);
+        DLOG_RAW("E:");
+        for (poly_idx_t e = start;
+             e < p->E && e < start + EDGES_PER_LINE;
+             ++e)
+        {
+            const Edge *ed = &p->e[e];
+            DLOG_RAW("(%u-%u), ", ed->a, ed->b);
+        }
+        DLOG_RAW("\n");
+        return true;
+    }
+    step -= n_e;
+
+    // --- chunked LED lines: framebuffer index of each edge's LED at A,
+    //     count, step towards B (what a host needs to address an edge) ---
+    if (step < n_l) {
+        poly_idx_t start = (poly_idx_t)(step * EDGES_PER_LINE);
+        DLOG_RAW("L:");
+        for (poly_idx_t e = start;
+             e < p->E && e < start + EDGES_PER_LINE;
+             ++e)
+        {
+            DLOG_RAW("%u,(%u,%u,%d); ", e, li[e].start, li[e].count, li[e].step);
         }
+        DLOG_RAW("\n");
+        return true;
     }
+    step -= n_l;
 
     // --- one line per face ---
-    {
-        char buf[128];
-        int pos;
-        for (uint8_t f = 0; f < p->F; ++f) {
-            pos = snprintf(buf, sizeof(buf), "f%u:", f);
-            for (uint8_t i = 0; i < p->fv[f]; ++i) {
-                pos += snprintf(buf + pos, sizeof(buf) - pos,
-                    "%u,", p->f[f][i]
-                );
-            }
-            USBD_UsrLog("%s", buf);
+    if (step < p->F) {
+        poly_idx_t f = (poly_idx_t)step;
+        DLOG_RAW("f%u:", f);
+        for (uint8_t i = 0; i < p->fv[f]; ++i) {
+            DLOG_RAW("%u,", p->f[f][i]);
         }
+        DLOG_RAW("\n");
+        return true;
     }
 
     // footer
-    USBD_UsrLog("#endgeo#");
+    DLOG("#endgeo#");
+    return false;
+}
+
+void geo_dump_model(const Polyhedron *p, const char *tag)
+{
+    for (uint32_t step = 0; geo_dump_model_step(p, tag, step); ++step) { }
+}
+
+
+/* --------------------------------------------------------------------------
+ * Binary dump (PKT_GEOMETRY), layout in geo_debug.h
+ * -------------------------------------------------------------------------- */
+
+/* payload kept under SCHED_BULK_ROOM with its framing, one packet a step */
+#define GEO_PKT_MAX     240
+#define GEO_PKT_HEAD    PROTO_GEO_PKT_SIZE      /* section, dump id, first u16 */
+
+#define VERT_BYTES      PROTO_GEO_VERT_SIZE     /* x y z float32, hue u8 */
+#define EDGE_BYTES      PROTO_GEO_EDGE_SIZE     /* a b u16 */
+#define LED_BYTES       PROTO_GEO_LED_SIZE      /* start count u16, step i8 */
+
+/* where the records stand: section, first record of the next packet */
+typedef struct {
+    uint8_t  section;
+    uint16_t next;
+} Cursor;
+
+static struct {
+    Cursor   at;
+    uint8_t  id;
+    uint32_t crc;
+    uint32_t bytes;
+} bin;
+
+/* CRC-32/MPEG-2 a byte at a time (the CRC unit belongs to usb_packet.c) */
+static uint32_t crc_bytes(uint32_t crc, const uint8_t *b, uint32_t n)
+{
+    while (n--) {
+        crc ^= (uint32_t)*b++ << 24;
+        for (uint8_t k = 0; k < 8; ++k)
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+    }
+    return crc;
+}
+
+static uint8_t *put16(uint8_t *d, uint16_t v) { memcpy(d, &v, 2); return d + 2; }
+
+static const EdgeLedInfo *edge_leds(const Polyhedron *p)
+{
+    const EdgeLedInfo *li = mapping_get_edge_info();
+    return li && mapping_get_edge_count() == p->E ? li : NULL;
+}
+
+static uint16_t section_len(const Polyhedron *p, const EdgeLedInfo *li, uint8_t section)
+{
+    switch (section) {
+    case GEO_SEC_VERTS: return p->V;
+    case GEO_SEC_EDGES: return p->E;
+    case GEO_SEC_LEDS:  return li ? p->E : 0;
+    case GEO_SEC_FACES: return p->F;
+    default:            return 0;
+    }
+}
+
+/* past the sections that are done (or empty) */
+static void skip_done(const Polyhedron *p, const EdgeLedInfo *li, Cursor *c)
+{
+    while (c->section < GEO_SEC_END && c->next >= section_len(p, li, c->section)) {
+        c->section++;
+        c->next = 0;
+    }
+}
+
+/* records of the cursor's section, as many as fit */
+static uint8_t *fill(const Polyhedron *p, const EdgeLedInfo *li, Cursor *c,
+                     uint8_t *d, uint8_t *end)
+{
+    switch (c->section) {
+    case GEO_SEC_VERTS:
+        for (; c->next < p->V && d + VERT_BYTES <= end; ++c->next) {
+            memcpy(d, p->v[c->next], 12);
+            vertex_hue_from_xyz(p->v[c->next], &d[12], debug_hue);
+            d += VERT_BYTES;
+        }
+        break;
+    case GEO_SEC_EDGES:
+        for (; c->next < p->E && d + EDGE_BYTES <= end; ++c->next) {
+            d = put16(d, p->e[c->next].a);
+            d = put16(d, p->e[c->next].b);
+        }
+        break;
+    case GEO_SEC_LEDS:
+        for (; c->next < p->E && d + LED_BYTES <= end; ++c->next) {
+            d = put16(d, li[c->next].start);
+            d = put16(d, li[c->next].count);
+            *d++ = (uint8_t)li[c->next].step;
+        }
+        break;
+    case GEO_SEC_FACES:
+        for (; c->next < p->F && d + 1 + 2u * p->fv[c->next] <= end; ++c->next) {
+            *d++ = p->fv[c->next];
+            for (uint8_t i = 0; i < p->fv[c->next]; ++i) d = put16(d, p->f[c->next][i]);
+        }
+        break;
+    }
+    return d;
+}
+
+bool geo_dump_packet_step(const Polyhedron *p, uint32_t step)
+{
+    const EdgeLedInfo *li = edge_leds(p);
+    uint8_t b[GEO_PKT_MAX];
+
+    if (step == 0) {
+        bin.at    = (Cursor){ GEO_SEC_HEAD, 0 };
+        bin.id++;
+        bin.crc   = 0xFFFFFFFFu;
+        bin.bytes = 0;
+    }
+    /* no room: nothing sent, the next step sends this packet */
+    if (usb_tx_channel_room(TX_CH_PACKET) < GEO_PKT_MAX + PKT_OVERHEAD + 2u)
+        return true;
+
+    b[1] = bin.id;
+    if (bin.at.section == GEO_SEC_HEAD) {
+        b[0] = GEO_SEC_HEAD;
+        uint8_t *d = put16(&b[2], 0);
+        d = put16(d, p->V);
+        d = put16(d, p->E);
+        d = put16(d, p->F);
+        d = put16(d, li ? p->E : 0);
+        usb_packet_send(PKT_GEOMETRY, b, (uint8_t)(d - b));
+        bin.at = (Cursor){ GEO_SEC_VERTS, 0 };
+        return true;
+    }
+
+    skip_done(p, li, &bin.at);
+    b[0] = bin.at.section;
+
+    if (bin.at.section == GEO_SEC_END) {
+        memset(&b[2], 0, 2);
+        memcpy(&b[4], &bin.crc, 4);
+        memcpy(&b[8], &bin.bytes, 4);
+        usb_packet_send(PKT_GEOMETRY, b, 12);
+        return false;
+    }
+
+    put16(&b[2], bin.at.next);
+    uint8_t *d = fill(p, li, &bin.at, &b[GEO_PKT_HEAD], &b[GEO_PKT_MAX]);
+    uint32_t n = (uint32_t)(d - &b[GEO_PKT_HEAD]);
+    bin.crc    = crc_bytes(bin.crc, &b[GEO_PKT_HEAD], n);
+    bin.bytes += n;
+    usb_packet_send(PKT_GEOMETRY, b, (uint8_t)(d - b));
+    return true;
+}
+
+uint32_t geo_hash(const Polyhedron *p)
+{
+    const EdgeLedInfo *li = edge_leds(p);
+    Cursor   c   = { GEO_SEC_VERTS, 0 };
+    uint32_t crc = 0xFFFFFFFFu;
+    uint8_t  b[GEO_PKT_MAX - GEO_PKT_HEAD];
+
+    for (skip_done(p, li, &c); c.section < GEO_SEC_END; skip_done(p, li, &c)) {
+        uint8_t *d = fill(p, li, &c, b, &b[sizeof b]);
+        crc = crc_bytes(crc, b, (uint32_t)(d - b));
+    }
+    return crc;
 }
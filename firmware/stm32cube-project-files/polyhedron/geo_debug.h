@@ -4,6 +4,8 @@
 #ifndef GEO_DEBUG_H
 #define GEO_DEBUG_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "polyhedron.h"
 
 #ifdef __cplusplus
@@ -17,8 +19,60 @@ extern "C" {
  */
 void geo_dump_wireframe(const Polyhedron *p, const char *name);
 
+/**
+ * Dump the model (vertices with hues, edges, edge LEDs, faces) over USB,
+ * for the app's viewer. All of it at once.
+ */
 void geo_dump_model(const Polyhedron *p, const char *tag);
 
+/**
+ * The same dump one line per step (0, 1, 2, ...), for a background job
+ * (sched_job()).
+ * @return true while there are more lines
+ */
+bool geo_dump_model_step(const Polyhedron *p, const char *tag, uint32_t step);
+
+/* --------------------------------------------------------------------------
+ * Binary dump: PKT_GEOMETRY packets (usb_packet.h), for the app instead of
+ * the text above. Every packet is
+ *
+ *   section u8 | dump id u8 | first u16 | records
+ *
+ * dump id counts dumps, so packets of two never mix; first is the index of
+ * the first record. Little endian, in this order:
+ *
+ *   GEO_SEC_HEAD   V u16, E u16, F u16, mapped edges u16 (E, or 0 without
+ *                  the LED mapping)
+ *   GEO_SEC_VERTS  x y z float32, hue u8 (vertex_hue_from_xyz, debug_hue)
+ *   GEO_SEC_EDGES  a u16, b u16
+ *   GEO_SEC_LEDS   start u16, count u16, step i8 (mapping_get_edge_info)
+ *   GEO_SEC_FACES  n u8, n vertex indices u16 (whole faces only)
+ *   GEO_SEC_END    crc u32, bytes u32: CRC-32/MPEG-2 (as the packet CRC,
+ *                  but byte by byte) over the records of all packets before
+ * -------------------------------------------------------------------------- */
+enum {
+    GEO_SEC_HEAD,
+    GEO_SEC_VERTS,
+    GEO_SEC_EDGES,
+    GEO_SEC_LEDS,
+    GEO_SEC_FACES,
+    GEO_SEC_END,
+};
+
+/**
+ * The binary dump one packet per step (0, 1, 2, ...), for sched_job(). A
+ * step without room in the TX ring sends nothing and leaves it to the next.
+ * @return true while there are more packets
+ */
+bool geo_dump_packet_step(const Polyhedron *p, uint32_t step);
+
+/**
+ * What GEO_SEC_END of a binary dump would carry, without sending it: the
+ * model and its LED mapping in one number, for the app's cache. Walks
+ * every record (hues included), not for every frame.
+ */
+uint32_t geo_hash(const Polyhedron *p);
+
 #ifdef __cplusplus
 }
 #endif
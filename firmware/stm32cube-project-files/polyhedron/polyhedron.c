@@ -33,6 +33,67 @@ static inline void v_lerp(const float a[3], const float b[3], float t, float d[3
         d[i] = a[i] + t * (b[i] - a[i]);
 }
 
+/* ────────────────────────────────────────────────────────────────────────── */
+/* ARENA                                                                      */
+/* ────────────────────────────────────────────────────────────────────────── */
+
+#define ALIGN4(n)   POLY_ARENA_ALIGN(n)
+
+void *poly_arena_alloc(PolyArena *a, size_t bytes)
+{
+    if (!a->mem) return NULL;
+    size_t at = ALIGN4((uintptr_t)(a->mem + a->used)) - (uintptr_t)a->mem;
+    if (at > a->size || bytes > a->size - at) return NULL;
+    a->used = at + bytes;
+    return a->mem + at;
+}
+
+static size_t bytes_for(uint16_t V, uint16_t F, uint16_t S)
+{
+    const uint16_t E = S / 2;
+    return ALIGN4(V * sizeof(float[3])) + ALIGN4(F) + ALIGN4(F * sizeof(poly_idx_t *)) + ALIGN4(S * sizeof(poly_idx_t))
+         + ALIGN4(E * sizeof(Edge))    + ALIGN4(E * 2u * sizeof(poly_idx_t))
+         + ALIGN4((V + 1u) * sizeof(uint16_t)) + ALIGN4(S * sizeof(poly_idx_t))
+         + POLY_ALIGN - 1;                      /* unaligned arena start */
+}
+
+size_t poly_bytes(poly_idx_t V, poly_idx_t F, uint16_t S) { return bytes_for(V, F, S); }
+
+/* Carve p's arrays for V vertices and F faces of fv[f] vertices each.
+ * Counts are checked here, before anything is written. */
+static bool poly_reserve(Polyhedron *p, PolyArena *a, uint16_t V, uint16_t F, const uint8_t *fv)
+{
+    if (V > POLY_MAX_V || F > POLY_MAX_F) return false;
+    uint16_t S = 0;
+    for (uint16_t f = 0; f < F; ++f) {
+        if (fv[f] > POLY_MAX_FV) return false;
+        S += fv[f];
+    }
+    if (S / 2 > POLY_MAX_E) return false;
+
+    p->V = (poly_idx_t)V;
+    p->F = (poly_idx_t)F;
+    p->S = S;
+    p->E = 0;
+    p->v       = poly_arena_alloc(a, V * sizeof *p->v);
+    p->fv      = poly_arena_alloc(a, F);
+    p->f       = poly_arena_alloc(a, F * sizeof *p->f);
+    poly_idx_t *fi = poly_arena_alloc(a, S * sizeof *fi);
+    p->e       = poly_arena_alloc(a, (S / 2) * sizeof *p->e);
+    p->e2f     = poly_arena_alloc(a, (S / 2) * sizeof *p->e2f);
+    p->v2e_off = poly_arena_alloc(a, (V + 1u) * sizeof *p->v2e_off);
+    p->v2e     = poly_arena_alloc(a, S * sizeof *p->v2e);
+    if (!p->v || !p->fv || !p->f || !fi || !p->e || !p->e2f || !p->v2e_off || !p->v2e)
+        return false;
+
+    for (uint16_t f = 0; f < F; ++f) {
+        p->fv[f] = fv[f];
+        p->f[f]  = fi;
+        fi      += fv[f];
+    }
+    return true;
+}
+
 /* ────────────────────────────────────────────────────────────────────────── */
 /* CORE FUNCTIONS                                                             */
 /* ────────────────────────────────────────────────────────────────────────── */
@@ -105,8 +166,8 @@ static void sort_incident_edges(const Polyhedron *in,
 //   order – output permutation of [0..n-1] giving CCW walk around vi.
 // ----------------------------------------------------------------------------
 static void sort_incident_faces(const Polyhedron *in,
-                                uint8_t           vi,
-                                const uint8_t    *inc,
+                                poly_idx_t        vi,
+                                const poly_idx_t *inc,
                                 uint8_t           n,
                                 uint8_t          *order)
 {
@@ -115,11 +176,11 @@ static void sort_incident_faces(const Polyhedron *in,
     used[0]  = true;
 
     for (uint8_t k = 1; k < n; ++k) {
-        uint8_t prev_face = inc[ order[k - 1] ];
+        poly_idx_t prev_face = inc[ order[k - 1] ];
         // find the next face sharing an edge with prev_face at vi
         for (uint8_t j = 0; j < n; ++j) {
             if (used[j]) continue;
-            uint8_t next_face = inc[j];
+            poly_idx_t next_face = inc[j];
 
             // count common vertices between prev_face and next_face
             uint8_t common = 0;
@@ -147,12 +208,16 @@ static void sort_incident_faces(const Polyhedron *in,
  *
  *
  */
-static void poly_dual(const Polyhedron *in, Polyhedron *out)
+static bool poly_dual(const Polyhedron *in, Polyhedron *out, PolyArena *a)
 {
-    if (in->F > POLY_MAX_V || in->V > POLY_MAX_F) return;
+    // 0) sizes: one face per vertex, as many corners as faces meet there
+    uint8_t deg[POLY_MAX_V] = { 0 };
+    for (uint16_t f = 0; f < in->F; ++f)
+        for (uint8_t j = 0; j < in->fv[f]; ++j)
+            deg[in->f[f][j]]++;
+    if (!poly_reserve(out, a, in->F, in->V, deg)) return false;
 
     // 1) face centroids → new vertices
-    out->V = in->F;
     for (uint16_t f = 0; f < in->F; ++f) {
         poly_face_centroid(in, f, out->v[f]);
         float r = v_len(out->v[f]);
@@ -160,9 +225,9 @@ static void poly_dual(const Polyhedron *in, Polyhedron *out)
     }
 
     // 2) vertex stars → new faces
-    out->F = in->V;
     for (uint16_t vi = 0; vi < in->V; ++vi) {
-        uint8_t inc[POLY_MAX_FV], cnt = 0;
+        poly_idx_t inc[POLY_MAX_FV];
+        uint8_t    cnt = 0;
         for (uint16_t f = 0; f < in->F; ++f) {
             for (uint8_t j = 0; j < in->fv[f]; ++j) {
                 if (in->f[f][j] == vi) {
@@ -182,96 +247,184 @@ static void poly_dual(const Polyhedron *in, Polyhedron *out)
             for (uint8_t k = 0; k < cnt; ++k)
                 out->f[vi][k] = inc[k];
         }
-
-        out->fv[vi] = cnt;
     }
 
     // 3) finalize
     poly_radial_normalize(out);
     poly_prepare(out);
+    return true;
+}
+
+// ──────────────────────────────────────────────────────────────────────────
+// Helpers for the edge-based operators below (in prepared + closed).
+// ──────────────────────────────────────────────────────────────────────────
+
+/* Edges around vertex vi into ring[deg], each one shares a face with the next.
+ * Returns the vertex degree, 0 if the star does not close. */
+static uint8_t vertex_ring(const Polyhedron *in, poly_idx_t vi, poly_idx_t *ring)
+{
+    uint8_t deg;
+    const poly_idx_t *inc = poly_vertex_edges(in, vi, &deg);
+    if (deg == 0 || deg > POLY_MAX_FV) return 0;
+
+    poly_idx_t e = inc[0], f = in->e2f[e][0];
+    for (uint8_t k = 0; k < deg; ++k) {
+        ring[k] = e;
+        if (f == POLY_IDX_NONE) return 0;
+        // f has vi between prev and next, e is one side, step to the other
+        uint8_t n = in->fv[f], j = 0;
+        while (j < n && in->f[f][j] != vi) ++j;
+        if (j == n) return 0;
+        poly_idx_t prev = in->f[f][(j + n - 1) % n], next = in->f[f][(j + 1) % n];
+        e = poly_find_edge(in, vi, poly_edge_other(in, e, vi) == next ? prev : next);
+        if (e >= in->E) return 0;
+        f = (in->e2f[e][0] == f) ? in->e2f[e][1] : in->e2f[e][0];
+    }
+    return (e == ring[0]) ? deg : 0;
+}
+
+/* Flip face f if its winding points inwards (vertex rings come out either way) */
+static void face_outward(Polyhedron *p, poly_idx_t f)
+{
+    float n[3], c[3];
+    poly_face_normal(p, f, n);
+    poly_face_centroid(p, f, c);
+    if (n[0]*c[0] + n[1]*c[1] + n[2]*c[2] >= 0.0f) return;
+    for (uint8_t i = 0, j = p->fv[f] - 1; i < j; ++i, --j) {
+        poly_idx_t t = p->f[f][i]; p->f[f][i] = p->f[f][j]; p->f[f][j] = t;
+    }
 }
 
 // ──────────────────────────────────────────────────────────────────────────
 // Truncate every vertex of `in` by cutting off a fraction `t` of each edge.
 // ──────────────────────────────────────────────────────────────────────────
-/*   - in  : original polyhedron (must have p->E built via poly_prepare)
- *   - out : resulting truncated polyhedron
- *   - t   : cut-fraction along each edge (0 < t < 0.5; 0.5 = midpoint)
+/*   - in  : original polyhedron (prepared, closed surface)
+ *   - out : resulting truncated polyhedron, carved from a
+ *   - t   : cut-fraction along each edge (0 < t < 0.5)
  *
  * Algorithm (edge-centric):
- *  1. Call poly_prepare(in) to ensure E, e[] and e2f[][] are valid.
- *  2. For each edge e=(a,b):
- *       - create one new vertex at  LERP(v[a],v[b], t)
- *       - create one new vertex at  LERP(v[b],v[a], t)
- *     (so out->V = 2*in->E)
- *  3. Build the **truncated faces**:
- *     • For each original face f with verts v0,v1,…,v{n-1},
- *       make a new n-gon whose vertices are the “A-cut” points
- *       on edges (v0→v1),(v1→v2)…
- *     • For each original vertex vi, collect all the “B-cut” points
- *       on the edges incident on vi (in cyclic order) → that gives another face.
- *  4. Normalize & rebuild topology with your usual
- *       poly_radial_normalize(out);
- *       poly_prepare(out);
- *
- * You’ll get exactly the **Archimedean** truncation with parameter t.
+ *  1. For each edge e=(a,b) two new vertices, LERP(v[a],v[b], t) (“A-cut”)
+ *     and LERP(v[b],v[a], t) (“B-cut”)  →  out->V = 2*in->E
+ *  2. Every original n-gon becomes a 2n-gon: per edge (vi→vj) the cut
+ *     next to vi, then the one next to vj.
+ *  3. Every original vertex vi becomes a face: the cuts next to vi on its
+ *     edges, in ring order.
+ *  4. Normalize & rebuild topology.
  */
-void poly_truncate(const Polyhedron *in, Polyhedron *out, float t)
+static bool poly_truncate(const Polyhedron *in, Polyhedron *out, PolyArena *a, float t)
 {
-    /* 1) Allocate a temp on the pool instead of the stack */
-    Polyhedron *tmp = poly_alloc();
-    if (!tmp) return;                // pool exhausted, just abort
-    *tmp = *in;                      // struct‐copy the input
-    poly_prepare(tmp);
-
-    /* 2) Create 2 new verts per edge */
-    uint8_t cutA[POLY_MAX_E], cutB[POLY_MAX_E];
-    out->V = 0;
-    for (uint16_t e = 0; e < tmp->E; ++e) {
-        uint8_t a = tmp->e[e].a, b = tmp->e[e].b;
-        v_lerp(tmp->v[a], tmp->v[b], t, out->v[out->V]);
-        cutA[e] = out->V++;
-        v_lerp(tmp->v[b], tmp->v[a], t, out->v[out->V]);
-        cutB[e] = out->V++;
+    /* 0) Sizes: the original faces doubled, then one face per vertex */
+    uint8_t fvn[POLY_MAX_F + POLY_MAX_V];
+    if (2u * in->E != in->S) return false;              /* not closed */
+    for (poly_idx_t f = 0; f < in->F; ++f)
+        fvn[f] = (uint8_t)(2u * in->fv[f]);
+    for (poly_idx_t vi = 0; vi < in->V; ++vi)
+        fvn[in->F + vi] = (uint8_t)(in->v2e_off[vi + 1] - in->v2e_off[vi]);
+    if (!poly_reserve(out, a, 2u * in->E, (uint16_t)in->F + in->V, fvn)) return false;
+
+    /* 1) Two new verts per edge, cut[2e] next to e.a, cut[2e+1] next to e.b */
+    for (poly_idx_t e = 0; e < in->E; ++e) {
+        poly_idx_t va = in->e[e].a, vb = in->e[e].b;
+        v_lerp(in->v[va], in->v[vb], t, out->v[2 * e]);
+        v_lerp(in->v[vb], in->v[va], t, out->v[2 * e + 1]);
     }
+#define CUT(ei, vv)  ((poly_idx_t)(2 * (ei) + ((vv) == in->e[ei].a ? 0 : 1)))
 
-    /* 3a) Truncate each original face */
-    out->F = 0;
-    for (uint16_t f = 0; f < tmp->F; ++f) {
-        uint8_t n = tmp->fv[f];
-        out->fv[out->F] = n;
+    /* 2) Truncate each original face */
+    for (poly_idx_t f = 0; f < in->F; ++f) {
+        uint8_t n = in->fv[f];
         for (uint8_t i = 0; i < n; ++i) {
-            uint8_t vi = tmp->f[f][i], vj = tmp->f[f][(i+1)%n];
-            uint8_t aa = vi < vj ? vi : vj, bb = vi < vj ? vj : vi;
-            uint16_t eidx = poly_find_edge(tmp, aa, bb);
-            out->f[out->F][i] = (vi == tmp->e[eidx].a ? cutA[eidx] : cutB[eidx]);
+            poly_idx_t vi = in->f[f][i], vj = in->f[f][(i + 1) % n];
+            poly_idx_t e  = poly_find_edge(in, vi, vj);
+            if (e >= in->E) return false;
+            out->f[f][2 * i]     = CUT(e, vi);
+            out->f[f][2 * i + 1] = CUT(e, vj);
         }
-        out->F++;
     }
 
-    /* 3b) One new face per original vertex */
-    for (uint8_t vi = 0; vi < tmp->V; ++vi) {
-        uint8_t inc[POLY_MAX_FV], cnt = 0;
-        for (uint16_t e = 0; e < tmp->E; ++e) {
-            if (tmp->e[e].a == vi || tmp->e[e].b == vi)
-                inc[cnt++] = e;
-        }
+    /* 3) One new face per original vertex */
+    for (poly_idx_t vi = 0; vi < in->V; ++vi) {
+        poly_idx_t ring[POLY_MAX_FV];
+        uint8_t cnt = vertex_ring(in, vi, ring);
+        poly_idx_t nf = (poly_idx_t)(in->F + vi);
+        if (cnt != out->fv[nf]) return false;
+        for (uint8_t k = 0; k < cnt; ++k)
+            out->f[nf][k] = CUT(ring[k], vi);
+        face_outward(out, nf);
+    }
+#undef CUT
 
-        /* no need to sort for correctness—just emit in found order */
-        out->fv[out->F] = cnt;
-        for (uint8_t k = 0; k < cnt; ++k) {
-            uint8_t eidx = inc[k];
-            out->f[out->F][k] = (vi == tmp->e[eidx].a ? cutA[eidx] : cutB[eidx]);
+    /* 4) Normalize & build topology */
+    poly_radial_normalize(out);
+    poly_prepare(out);
+    return true;
+}
+
+// ──────────────────────────────────────────────────────────────────────────
+// Ambo (rectify): one vertex per edge midpoint, faces shrink to the
+// midpoints of their edges, every vertex becomes a face.
+// ──────────────────────────────────────────────────────────────────────────
+static bool poly_ambo(const Polyhedron *in, Polyhedron *out, PolyArena *a)
+{
+    uint8_t fvn[POLY_MAX_F + POLY_MAX_V];
+    if (2u * in->E != in->S) return false;              /* not closed */
+    memcpy(fvn, in->fv, in->F);
+    for (poly_idx_t vi = 0; vi < in->V; ++vi)
+        fvn[in->F + vi] = (uint8_t)(in->v2e_off[vi + 1] - in->v2e_off[vi]);
+    if (!poly_reserve(out, a, in->E, (uint16_t)in->F + in->V, fvn)) return false;
+
+    // new vertex e = midpoint of edge e
+    for (poly_idx_t e = 0; e < in->E; ++e)
+        v_lerp(in->v[in->e[e].a], in->v[in->e[e].b], 0.5f, out->v[e]);
+
+    // face f → its edges in winding order
+    for (poly_idx_t f = 0; f < in->F; ++f) {
+        uint8_t n = in->fv[f];
+        for (uint8_t i = 0; i < n; ++i) {
+            poly_idx_t e = poly_find_edge(in, in->f[f][i], in->f[f][(i + 1) % n]);
+            if (e >= in->E) return false;
+            out->f[f][i] = e;
         }
-        out->F++;
     }
 
-    /* 4) Normalize & build topology */
+    // vertex vi → ring of its edges
+    for (poly_idx_t vi = 0; vi < in->V; ++vi) {
+        poly_idx_t nf = (poly_idx_t)(in->F + vi);
+        if (vertex_ring(in, vi, out->f[nf]) != out->fv[nf]) return false;
+        face_outward(out, nf);
+    }
+
     poly_radial_normalize(out);
     poly_prepare(out);
+    return true;
+}
+
+// ──────────────────────────────────────────────────────────────────────────
+// Kis: raise a vertex over every face centre, the n-gon becomes n triangles.
+// ──────────────────────────────────────────────────────────────────────────
+static bool poly_kis(const Polyhedron *in, Polyhedron *out, PolyArena *a)
+{
+    uint8_t fvn[POLY_MAX_F];
+    if (in->S > POLY_MAX_F) return false;
+    memset(fvn, 3, in->S);
+    if (!poly_reserve(out, a, (uint16_t)in->V + in->F, in->S, fvn)) return false;
+
+    memcpy(out->v, in->v, in->V * sizeof *out->v);
+    poly_idx_t nf = 0;
+    for (poly_idx_t f = 0; f < in->F; ++f) {
+        poly_idx_t c = (poly_idx_t)(in->V + f);
+        uint8_t    n = in->fv[f];
+        poly_face_centroid(in, f, out->v[c]);
+        for (uint8_t i = 0; i < n; ++i, ++nf) {     /* keeps the face's winding */
+            out->f[nf][0] = c;
+            out->f[nf][1] = in->f[f][i];
+            out->f[nf][2] = in->f[f][(i + 1) % n];
+        }
+    }
 
-    /* 5) Return tmp to the pool */
-    poly_free(tmp);
+    poly_radial_normalize(out);
+    poly_prepare(out);
+    return true;
 }
 
 /* ──────────────────────────────────────────────────────────────────────────────────────────────────────────────────────────────────── */
@@ -341,36 +494,66 @@ uint16_t poly_edges(const Polyhedron *p, Edge *buf, uint16_t buf_sz) {
 
 /* ------------------------------------------------------------------
  * _build_edges() – Topology-driven: scan faces, collect unique edges
+ * (numbered in discovery order). Known edges are found through a chain
+ * per lower vertex, head[a] → next[e] → …, so each slot only looks at the
+ * edges of one vertex. next[] borrows v2e, rebuilt right after.
  * ------------------------------------------------------------------ */
 static void _build_edges(Polyhedron *p)
 {
+    poly_idx_t  head[POLY_MAX_V];
+    poly_idx_t *next = p->v2e;                 /* [S] >= [S/2] edges          */
+    memset(head, 0xFF, p->V * sizeof *head);
     p->E = 0;
-    memset(p->e2f, 0xFF, sizeof p->e2f);
+    memset(p->e2f, 0xFF, (p->S / 2) * sizeof *p->e2f);
 
-    for (uint8_t f = 0; f < p->F; ++f) {
+    for (poly_idx_t f = 0; f < p->F; ++f) {
         uint8_t n = p->fv[f];
         for (uint8_t i = 0; i < n; ++i) {
-            uint8_t a = p->f[f][i];
-            uint8_t b = p->f[f][(i + 1) % n];
-            if (a > b) { uint8_t t = a; a = b; b = t; }
+            poly_idx_t a = p->f[f][i];
+            poly_idx_t b = p->f[f][(i + 1) % n];
+            if (a > b) { poly_idx_t t = a; a = b; b = t; }
 
             /* Already known? */
-            uint8_t e;
-            for (e = 0; e < p->E; ++e)
-                if (p->e[e].a == a && p->e[e].b == b) break;
+            poly_idx_t e;
+            for (e = head[a]; e != POLY_IDX_NONE; e = next[e])
+                if (p->e[e].b == b) break;
 
-            if (e == p->E) {                   /* new edge                        */
-                if (p->E >= POLY_MAX_E) break; /* safety                          */
+            if (e == POLY_IDX_NONE) {          /* new edge                        */
+                if (p->E >= p->S / 2) break;   /* safety, not a closed surface    */
+                e = p->E++;
                 p->e[e].a = a; p->e[e].b = b;
-                ++p->E;
+                next[e] = head[a];
+                head[a] = e;
             }
             /* Face adjacency */
-            if (p->e2f[e][0] == 0xFF) p->e2f[e][0] = f;
+            if (p->e2f[e][0] == POLY_IDX_NONE) p->e2f[e][0] = f;
             else                      p->e2f[e][1] = f;
         }
     }
 }
 
+/* ------------------------------------------------------------------
+ * _build_vertex_edges() – CSR vertex → incident edges: count degrees,
+ * prefix sum, scatter (edges come out ascending per vertex)
+ * ------------------------------------------------------------------ */
+static void _build_vertex_edges(Polyhedron *p)
+{
+    memset(p->v2e_off, 0, (p->V + 1u) * sizeof *p->v2e_off);
+    for (poly_idx_t e = 0; e < p->E; ++e) {
+        p->v2e_off[p->e[e].a + 1]++;
+        p->v2e_off[p->e[e].b + 1]++;
+    }
+    for (poly_idx_t v = 0; v < p->V; ++v)
+        p->v2e_off[v + 1] += p->v2e_off[v];
+
+    uint16_t fill[POLY_MAX_V];
+    memcpy(fill, p->v2e_off, p->V * sizeof *fill);
+    for (poly_idx_t e = 0; e < p->E; ++e) {
+        p->v2e[fill[p->e[e].a]++] = e;
+        p->v2e[fill[p->e[e].b]++] = e;
+    }
+}
+
 /**
  * poly_prepare – normalize geometry and build edge table + e2f map
  */
@@ -378,31 +561,52 @@ void poly_prepare(Polyhedron *p) {
     // 1) normalize all points (to unit box or sphere, depending on poly_normalize)
     poly_normalize(p);
 
-    // 2) clear any previous edge→face links
-    memset(p->e2f, 0xFF, sizeof p->e2f);
-
-    // 3) scan faces and collect unique edges, filling both p->e[] and p->e2f[][]
+    // 2) one pass over the face slots: unique edges (bucketed by lower vertex)
+    //    and the edge→face links, both p->e[] and p->e2f[][] (cleared there)
     _build_edges(p);
+
+    // 3) vertex → edge adjacency, linear (count, prefix sum, scatter)
+    _build_vertex_edges(p);
+
+    // 4) derived caches are stale now
+    poly_touch(p);
+}
+
+void poly_touch(Polyhedron *p)
+{
+    static uint32_t gen_counter = 0;       /* shared: unique across solids */
+    p->gen = ++gen_counter;
 }
 
 /* ────────────────────────────────────────────────────────────────────────── */
 /* EDGE + FACE ACCESSORS                                                     */
 /* ────────────────────────────────────────────────────────────────────────── */
 
-uint8_t  poly_edge_count(const Polyhedron *p)                  				{ return p->E; }
-Edge     poly_get_edge(const Polyhedron *p, uint8_t idx)       				{ return p->e[idx]; }
-uint8_t  poly_find_edge(const Polyhedron *p, uint8_t v0, uint8_t v1) 		{if (v0 > v1) { uint8_t t=v0; v0=v1; v1=t; } for (uint8_t e=0; e<p->E; ++e) if (p->e[e].a==v0 && p->e[e].b==v1) return e; return 0xFF;}
-void     poly_edge_faces(const Polyhedron *p, uint8_t eidx, uint8_t out[2]) { out[0]=p->e2f[eidx][0]; out[1]=p->e2f[eidx][1]; }
-uint8_t  poly_face_vertex_count(const Polyhedron *p, uint8_t fidx) 			{ return p->fv[fidx]; }
-const uint8_t* poly_face_vertices(const Polyhedron *p, uint8_t fidx) 		{ return p->f[fidx]; }
-bool poly_face_edge_is_ccw(const Polyhedron *p, uint8_t fidx, uint8_t eidx) {
+poly_idx_t poly_edge_count(const Polyhedron *p)                  			{ return p->E; }
+Edge     poly_get_edge(const Polyhedron *p, poly_idx_t idx)       			{ return p->e[idx]; }
+/* walks the shorter vertex star (v2e), not the edge list */
+poly_idx_t poly_find_edge(const Polyhedron *p, poly_idx_t v0, poly_idx_t v1)
+{
+    if (v0 >= p->V || v1 >= p->V) return POLY_IDX_NONE;
+    if (p->v2e_off[v1 + 1] - p->v2e_off[v1] < p->v2e_off[v0 + 1] - p->v2e_off[v0]) {
+        poly_idx_t t = v0; v0 = v1; v1 = t;
+    }
+    for (uint16_t k = p->v2e_off[v0]; k < p->v2e_off[v0 + 1]; ++k)
+        if (poly_edge_other(p, p->v2e[k], v0) == v1) return p->v2e[k];
+    return POLY_IDX_NONE;
+}
+void     poly_edge_faces(const Polyhedron *p, poly_idx_t eidx, poly_idx_t out[2]) { out[0]=p->e2f[eidx][0]; out[1]=p->e2f[eidx][1]; }
+const poly_idx_t* poly_vertex_edges(const Polyhedron *p, poly_idx_t vidx, uint8_t *n) { *n = (uint8_t)(p->v2e_off[vidx + 1] - p->v2e_off[vidx]); return &p->v2e[p->v2e_off[vidx]]; }
+uint8_t  poly_face_vertex_count(const Polyhedron *p, poly_idx_t fidx) 			{ return p->fv[fidx]; }
+const poly_idx_t* poly_face_vertices(const Polyhedron *p, poly_idx_t fidx) 		{ return p->f[fidx]; }
+bool poly_face_edge_is_ccw(const Polyhedron *p, poly_idx_t fidx, poly_idx_t eidx) {
     Edge e = poly_get_edge(p, eidx);
-    uint8_t a = e.a, b = e.b;
+    poly_idx_t a = e.a, b = e.b;
     uint8_t  n   = poly_face_vertex_count(p, fidx);
-    const uint8_t *vs = poly_face_vertices(p, fidx);
+    const poly_idx_t *vs = poly_face_vertices(p, fidx);
     for (uint8_t i = 0; i < n; ++i) {
-        uint8_t v0 = vs[i];
-        uint8_t v1 = vs[(i + 1) % n];
+        poly_idx_t v0 = vs[i];
+        poly_idx_t v1 = vs[(i + 1) % n];
         if (v0 == a && v1 == b) {
             return true;
         }
@@ -419,18 +623,22 @@ static void rotate_xyz(float v[3], float R[3][3])
     v[2] = R[2][0]*x + R[2][1]*y + R[2][2]*z;
 }
 
-void poly_rotate(Polyhedron *p, float yaw, float pitch, float roll)
+void poly_rotation_matrix(float yaw, float pitch, float roll, float R[3][3])
 {
     /* Z-yaw → Y-pitch → X-roll (Tait-Bryan) */
     float cy = cosf(yaw),  sy = sinf(yaw);
     float cp = cosf(pitch),sp = sinf(pitch);
     float cr = cosf(roll), sr = sinf(roll);
 
-    float R[3][3] = {
-        { cy*cp, cy*sp*sr - sy*cr, cy*sp*cr + sy*sr },
-        { sy*cp, sy*sp*sr + cy*cr, sy*sp*cr - cy*sr },
-        {  -sp ,      cp*sr      ,      cp*cr       }
-    };
+    R[0][0] = cy*cp; R[0][1] = cy*sp*sr - sy*cr; R[0][2] = cy*sp*cr + sy*sr;
+    R[1][0] = sy*cp; R[1][1] = sy*sp*sr + cy*cr; R[1][2] = sy*sp*cr - cy*sr;
+    R[2][0] =  -sp ; R[2][1] =      cp*sr      ; R[2][2] =      cp*cr      ;
+}
+
+void poly_rotate(Polyhedron *p, float yaw, float pitch, float roll)
+{
+    float R[3][3];
+    poly_rotation_matrix(yaw, pitch, roll, R);
 
     for (uint16_t i = 0; i < p->V; ++i)
         rotate_xyz(p->v[i], R);
@@ -439,7 +647,7 @@ void poly_rotate(Polyhedron *p, float yaw, float pitch, float roll)
     poly_prepare(p);
 }
 
-void poly_orient_to_vertex(Polyhedron *p, uint8_t vidx) {
+void poly_orient_to_vertex(Polyhedron *p, poly_idx_t vidx) {
     float vx = p->v[vidx][0];
     float vy = p->v[vidx][1];
     float vz = p->v[vidx][2];
@@ -456,13 +664,13 @@ void poly_orient_to_vertex(Polyhedron *p, uint8_t vidx) {
     poly_prepare(p);
 }
 
-void poly_orient_to_edge(Polyhedron *p, uint8_t v0, uint8_t v1) {
+void poly_orient_to_edge(Polyhedron *p, poly_idx_t v0, poly_idx_t v1) {
     // Kantenindex ermitteln
-    uint8_t eidx = poly_find_edge(p, v0, v1);
-    if (eidx == 0xFF) return;
+    poly_idx_t eidx = poly_find_edge(p, v0, v1);
+    if (eidx == POLY_IDX_NONE) return;
 
     // Angrenzende Flächen holen
-    uint8_t faces[2];
+    poly_idx_t faces[2];
     poly_edge_faces(p, eidx, faces);
 
     // Normale der beiden Flächen
@@ -485,7 +693,7 @@ void poly_orient_to_edge(Polyhedron *p, uint8_t v0, uint8_t v1) {
     poly_prepare(p);
 }
 
-void poly_orient_to_face(Polyhedron *p, uint8_t fidx) {
+void poly_orient_to_face(Polyhedron *p, poly_idx_t fidx) {
     // Flächennormale holen
     float n[3];
     poly_face_normal(p, fidx, n);
@@ -505,27 +713,28 @@ void poly_orient_to_face(Polyhedron *p, uint8_t fidx) {
  * After these, you can call the init and the Polyhedron is ready for dumping or rendering.
  *------------------------------------------------------------------*/
 
-static void _seed_tri(Polyhedron *p, const float (*V)[3], uint16_t vcnt, const uint8_t (*F)[3], uint16_t fcnt) {
-    p->V = vcnt;
+static bool _seed_tri(Polyhedron *p, PolyArena *a, const float (*V)[3], uint16_t vcnt, const uint8_t (*F)[3], uint16_t fcnt) {
+    uint8_t fv[POLY_MAX_F];
+    memset(fv, 3, fcnt);
+    if (!poly_reserve(p, a, vcnt, fcnt, fv)) return false;
     memcpy(p->v, V, sizeof(float)*3*vcnt);
-    p->F = fcnt;
-    for (uint16_t i = 0; i < fcnt; ++i) {
-        p->fv[i] = 3;
-        memcpy(p->f[i], F[i], 3);
-    }
+    for (uint16_t i = 0; i < fcnt; ++i)
+        for (uint8_t j = 0; j < 3; ++j) p->f[i][j] = F[i][j];
+    return true;
 }
 
 // 1) Tetrahedron (seed with 4 triangles)
-void poly_init_tetrahedron(Polyhedron *p) {
+bool poly_init_tetrahedron(Polyhedron *p, PolyArena *a) {
     static const float V[4][3] = { { 1,  1,  1}, { 1, -1, -1}, {-1,  1, -1}, {-1, -1,  1} };
     static const uint8_t F[4][3] = { {0,1,2},{0,3,1},{0,2,3},{1,3,2} };
-    _seed_tri(p, V, 4, F, 4);
+    if (!_seed_tri(p, a, V, 4, F, 4)) return false;
     poly_radial_normalize(p);
     poly_prepare(p);
+    return true;
 }
 
 // 2) Cube (seed with 12 triangles)
-void poly_init_cube(Polyhedron *p) {
+bool poly_init_cube(Polyhedron *p, PolyArena *a) {
     static const float V[8][3] = {
         { 1, 1, 1},{ 1, 1,-1},{ 1,-1, 1},{ 1,-1,-1},
         {-1, 1, 1},{-1, 1,-1},{-1,-1, 1},{-1,-1,-1}
@@ -535,12 +744,13 @@ void poly_init_cube(Polyhedron *p) {
         {0,1,5},{0,5,4}, {2,6,7},{2,7,3},
         {0,4,6},{0,6,2}, {1,3,7},{1,7,5}
     };
-    _seed_tri(p, V, 8, F, 12);
+    if (!_seed_tri(p, a, V, 8, F, 12)) return false;
     poly_radial_normalize(p);
     poly_prepare(p);
+    return true;
 }
 
-void poly_init_cube4(Polyhedron *p)        /* 6 quads */
+bool poly_init_cube4(Polyhedron *p, PolyArena *a)        /* 6 quads */
 {
     static const float V[8][3] = {
         { 1, 1, 1},{ 1, 1,-1},{ 1,-1, 1},{ 1,-1,-1},
@@ -551,16 +761,18 @@ void poly_init_cube4(Polyhedron *p)        /* 6 quads */
         {0,1,5,4},{2,6,7,3},
         {0,4,6,2},{1,3,7,5}
     };
-    p->V = 8;  memcpy(p->v, V, sizeof V);
-    p->F = 6;
-    for (uint8_t i=0;i<6;++i){ p->fv[i]=4; memcpy(p->f[i],F[i],4); }
+    static const uint8_t FV[6] = { 4, 4, 4, 4, 4, 4 };
+    if (!poly_reserve(p, a, 8, 6, FV)) return false;
+    memcpy(p->v, V, sizeof V);
+    for (uint8_t i=0;i<6;++i){ for (uint8_t j=0;j<4;++j) p->f[i][j]=F[i][j]; }
     poly_radial_normalize(p);
     poly_prepare(p);
+    return true;
 }
 
 
 // 3) Icosahedron (seed with 20 triangles)
-void poly_init_icosahedron(Polyhedron *p) {
+bool poly_init_icosahedron(Polyhedron *p, PolyArena *a) {
     static const float V[12][3] = {
         {0,  1,  PHI},{0, -1,  PHI},{0,  1, -PHI},{0, -1, -PHI},
         {1,  PHI, 0 },{-1, PHI, 0 },{1, -PHI, 0 },{-1,-PHI, 0 },
@@ -573,86 +785,150 @@ void poly_init_icosahedron(Polyhedron *p) {
         {3,9,6},{3,6,7},{3,7,11},
         {4,8,9},{5,11,10},{6,8,9},{7,10,11}
     };
-    _seed_tri(p, V, 12, F, 20);
+    if (!_seed_tri(p, a, V, 12, F, 20)) return false;
     poly_radial_normalize(p);
     poly_prepare(p);
+    return true;
 }
 
 
 
 
-void poly_init_octahedron(Polyhedron *p)
-{
-    Polyhedron *tmp = poly_alloc();
-    if (!tmp) return;
-    poly_init_cube4(tmp);
-    poly_dual(tmp, p);
-    poly_free(tmp);
-}
+/* ────────────────────────────────────────────────────────────────────────── */
+/* CONWAY OPERATORS                                                           */
+/* ────────────────────────────────────────────────────────────────────────── */
 
+typedef struct { uint32_t V, F, S; } PolySize;
 
-// 5) Dodecahedron (dual of Icosahedron)
-void poly_init_dodecahedron(Polyhedron *p) {
-    Polyhedron *tmp = poly_alloc();
-    if (!tmp) return;
-    poly_init_icosahedron(tmp);
-    poly_dual(tmp, p);
-    poly_free(tmp);
+static bool seed_size(char c, PolySize *s)
+{
+    switch (c) {
+    case 'T': *s = (PolySize){  4,  4, 12 }; return true;
+    case 'C': *s = (PolySize){  8,  6, 24 }; return true;
+    case 'I': *s = (PolySize){ 12, 20, 60 }; return true;
+    default:  return false;
+    }
 }
 
-void poly_init_icosidodecahedron(Polyhedron *p)
+/* size after op, false if it would overflow the index limits */
+static bool op_size(char op, PolySize *s)
 {
-    Polyhedron *dode  = poly_alloc();
-    Polyhedron *trunc = poly_alloc();
-    if (!dode || !trunc) {
-        if (dode)  poly_free(dode);
-        if (trunc) poly_free(trunc);
-        return;
+    switch (op) {
+    case 'd': { uint32_t t = s->V; s->V = s->F; s->F = t; break; }
+    case 'a': s->F += s->V; s->V = s->S / 2; s->S *= 2; break;
+    case 't': s->F += s->V; s->V = s->S;     s->S *= 3; break;
+    case 'k': s->V += s->F; s->F = s->S;     s->S *= 3; break;
+    default:  return false;
     }
-    // 1) seed dodecahedron
-    poly_init_dodecahedron(dode);
-    // 2) half-truncate → triangles + pentagons
-    poly_truncate(dode, trunc, 0.5f);
-    // 3) copy result into caller‐supplied buffer
-    *p = *trunc;    //<— this must actually write back into *p
-
-    // cleanup
-    poly_free(dode);
-    poly_free(trunc);
+    return s->V <= POLY_MAX_V && s->F <= POLY_MAX_F && s->S / 2 <= POLY_MAX_E;
 }
 
-void poly_init_rhombitruncated_icosidodecahedron(Polyhedron *p)
+static bool seed_init(char c, Polyhedron *p, PolyArena *a)
 {
-    // scratch on heap, not stack
-    Polyhedron *seed  = poly_alloc();
-    Polyhedron *tmp   = poly_alloc();
-    if (!seed || !tmp) {
-        if (seed) poly_free(seed);
-        if (tmp)  poly_free(tmp);
-        return;
+    switch (c) {
+    case 'T': return poly_init_tetrahedron(p, a);
+    case 'C': return poly_init_cube4(p, a);
+    default:  return poly_init_icosahedron(p, a);
     }
+}
 
-    // 1) build Archimedean icosidodecahedron
-    poly_init_icosidodecahedron(seed);
-    // ensure its topology is up-to-date
-    poly_radial_normalize(seed);
-    poly_prepare(seed);
+static bool op_apply(char op, const Polyhedron *in, Polyhedron *out, PolyArena *a)
+{
+    switch (op) {
+    case 'd': return poly_dual(in, out, a);
+    case 'a': return poly_ambo(in, out, a);
+    case 't': return poly_truncate(in, out, a, POLY_TRUNCATE_T);
+    default:  return poly_kis(in, out, a);
+    }
+}
 
-    // 2) truncate at t=0.5 → Archimedean truncated icosidodecahedron
-    poly_truncate(seed, tmp, 0.5f);
+/* ops → seed letter + operators in the order they are applied (O = dC, D = dI) */
+static uint8_t conway_parse(const char *ops, char *seed, char seq[POLY_CONWAY_MAX_OPS])
+{
+    size_t len = strlen(ops);
+    if (len == 0) return 0;
+    uint8_t n = 0;
+    *seed = ops[len - 1];
+    if      (*seed == 'O') { *seed = 'C'; seq[n++] = 'd'; }
+    else if (*seed == 'D') { *seed = 'I'; seq[n++] = 'd'; }
+    while (--len) {
+        if (n == POLY_CONWAY_MAX_OPS) return 0;
+        seq[n++] = ops[len - 1];
+    }
+    return n;
+}
 
-    // 3) dualize → rhombic solid
-    poly_dual(tmp, p);
+/* arena bytes of the final solid (out) and the largest intermediate one (scr) */
+static bool conway_sizes(char seed, const char *seq, uint8_t n, size_t *out, size_t *scr)
+{
+    PolySize s;
+    if (!seed_size(seed, &s)) return false;
+    *scr = 0;
+    for (uint8_t i = 0; i < n; ++i) {
+        size_t b = bytes_for((uint16_t)s.V, (uint16_t)s.F, (uint16_t)s.S);
+        if (b > *scr) *scr = b;
+        if (!op_size(seq[i], &s)) return false;
+    }
+    *out = bytes_for((uint16_t)s.V, (uint16_t)s.F, (uint16_t)s.S);
+    return true;
+}
 
-    // 4) final normalize + prepare
-    poly_radial_normalize(p);
-    poly_prepare(p);
+size_t poly_conway_bytes(const char *ops)
+{
+    char seed, seq[POLY_CONWAY_MAX_OPS];
+    size_t out, scr;
+    uint8_t n = conway_parse(ops, &seed, seq);
+    if (!n && strlen(ops) != 1) return 0;
+    return conway_sizes(seed, seq, n, &out, &scr) ? out : 0;
+}
 
-    // cleanup
-    poly_free(seed);
-    poly_free(tmp);
+/*
+ * Stages ping-pong between the two halves of one heap scratch (each sized for
+ * the largest intermediate), the stage before the last one is overwritten
+ * as soon as it has been read. Only the last stage lands in the caller's
+ * arena, so `a` holds exactly the requested solid.
+ */
+bool poly_init_conway(Polyhedron *p, PolyArena *a, const char *ops)
+{
+    char seed, seq[POLY_CONWAY_MAX_OPS];
+    size_t out_b, scr_b;
+    uint8_t n = conway_parse(ops, &seed, seq);
+    if (!n && strlen(ops) != 1) return false;
+    if (!conway_sizes(seed, seq, n, &out_b, &scr_b)) return false;
+    if (n == 0) return seed_init(seed, p, a);
+
+    uint8_t *mem = malloc(2 * scr_b);
+    if (!mem) return false;
+    PolyArena  scr[2];
+    Polyhedron stage[2];
+    poly_arena_init(&scr[0], mem, scr_b);
+    poly_arena_init(&scr[1], mem + scr_b, scr_b);
+
+    bool ok = seed_init(seed, &stage[0], &scr[0]);
+    for (uint8_t i = 0; ok && i < n; ++i) {
+        const Polyhedron *in = &stage[i & 1];
+        if (i + 1 == n) {
+            ok = op_apply(seq[i], in, p, a);
+        } else {
+            scr[(i + 1) & 1].used = 0;
+            ok = op_apply(seq[i], in, &stage[(i + 1) & 1], &scr[(i + 1) & 1]);
+        }
+    }
+    free(mem);
+    return ok;
 }
 
+bool poly_init_octahedron(Polyhedron *p, PolyArena *a)      { return poly_init_conway(p, a, "O"); }
 
+// 5) Dodecahedron (dual of Icosahedron)
+bool poly_init_dodecahedron(Polyhedron *p, PolyArena *a)    { return poly_init_conway(p, a, "D"); }
 
+// Rectified dodecahedron: 30 vertices, 20 triangles + 12 pentagons
+bool poly_init_icosidodecahedron(Polyhedron *p, PolyArena *a) { return poly_init_conway(p, a, "aD"); }
 
+// Dual of the truncated icosidodecahedron (dtaD), built as kis of the rhombic
+// triacontahedron (kdaD, same topology) to keep the intermediates small
+bool poly_init_rhombitruncated_icosidodecahedron(Polyhedron *p, PolyArena *a)
+{
+    return poly_init_conway(p, a, "kdaD");
+}
@@ -6,26 +6,50 @@
 #include <stdbool.h>
 #include <string.h>
 #include <math.h>   // For sqrtf()
+#include "config.h" // POLY_INDEX_16
 
 /* ────────────────────────────────────────────────────────────────────────── */
-/* CONFIGURATION: Polyhedron memory limits                                    */
+/* CONFIGURATION: Polyhedron limits                                           */
 /* ────────────────────────────────────────────────────────────────────────── */
 
-
-//You’re overflowing the Cortex-M stack when you build polyhedra inside the initializer.
-//With POLY_MAX_V = 200 each Polyhedron is ≈ 10 kB
-//The default bare metal stack on CubeIDE projects is often 4 kB or 8 kB
-
-// do not increase any of those over 255
-#define POLY_MAX_V   200     // Maximum number of vertices
-#define POLY_MAX_E   300     // Maximum number of unique edges
-#define POLY_MAX_F   120     // Maximum number of faces
+// The arrays are carved from a PolyArena, sized to the real V / E / F, so these
+// are index limits only (counts and indices are poly_idx_t). POLY_MAX_V / _F
+// and POLY_MAX_FV size some stack scratch while building (vertex stars, face
+// walks, per-vertex chains), keep them near the largest solid actually built.
+//
+// poly_idx_t is 8 bit unless config.h sets POLY_INDEX_16: every index table
+// (faces, e2f, v2e, the mapping's edge maps, ...) doubles then, but solids
+// with more than 254 vertices / edges / faces become possible.
+#ifdef POLY_INDEX_16
+typedef uint16_t poly_idx_t;
+#define POLY_IDX_NONE  0xFFFFu   // "no vertex / edge / face" (e2f of an open edge, ...)
+#ifndef POLY_MAX_V
+#define POLY_MAX_V   512     // Maximum number of vertices
+#endif
+#ifndef POLY_MAX_E
+#define POLY_MAX_E   1024    // Maximum number of unique edges
+#endif
+#ifndef POLY_MAX_F
+#define POLY_MAX_F   512     // Maximum number of faces
+#endif
+#else
+typedef uint8_t  poly_idx_t;
+#define POLY_IDX_NONE  0xFFu
+#define POLY_MAX_V   255     // Maximum number of vertices
+#define POLY_MAX_E   255     // Maximum number of unique edges
+#define POLY_MAX_F   255     // Maximum number of faces
+#endif
 #define POLY_MAX_FV  10      // Maximum vertices per face (ie 8 = octagon, 10 dodecagon etc..)
 
-// note that these values lead top ~8kbytes. building larger ones leads to stack overflow. (not functional rn)
+#if POLY_MAX_V > POLY_IDX_NONE || POLY_MAX_E > POLY_IDX_NONE || POLY_MAX_F > POLY_IDX_NONE
+#error "POLY_MAX_V / _E / _F must fit poly_idx_t (indices stay below POLY_IDX_NONE)"
+#endif
 
 #define PHI  ((1.0f + sqrtf(5.0f)) * 0.5f)  // Golden ratio
 
+#define POLY_CONWAY_MAX_OPS  8              // operators per poly_init_conway() string
+#define POLY_TRUNCATE_T      (1.0f / 3.0f)  // edge fraction cut off by 't' (exact for triangles)
+
 
 
 
@@ -37,19 +61,34 @@ typedef struct {
     uint16_t a, b;    // Vertex indices, sorted: a < b
 } Edge;
 
+/* Bump allocator the Polyhedron arrays are carved from (caller-supplied
+ * memory, nothing is freed on its own: reset `used` or drop the arena) */
+typedef struct {
+    uint8_t *mem;
+    size_t   size;
+    size_t   used;
+} PolyArena;
+
+/* Header only, the arrays live in a PolyArena and are sized by the poly_init_*
+ * that filled it. Closed surfaces: every edge borders two faces, E = S / 2. */
 typedef struct {
     /* ── Base geometry ─────────────────────────────── */
-    uint8_t  V;                            // Number of vertices
-    float    v[POLY_MAX_V][3];             // Vertex positions (XYZ)
+    poly_idx_t  V;                         // Number of vertices
+    float     (*v)[3];                     // [V] Vertex positions (XYZ)
 
-    uint8_t  F;                            // Number of faces
-    uint8_t  fv[POLY_MAX_F];              // Vertices per face
-    uint8_t  f[POLY_MAX_F][POLY_MAX_FV];  // Vertex indices per face
+    poly_idx_t  F;                         // Number of faces
+    uint16_t    S;                         // Face slots (sum of fv)
+    uint8_t    *fv;                        // [F] Vertices per face
+    poly_idx_t **f;                        // [F] Vertex indices per face, f[i][0 .. fv[i])
 
     /* ── Derived topology ──────────────────────────── */
-    uint8_t  E;                            // Number of unique edges
-    Edge     e[POLY_MAX_E];               // Edge list (a < b)
-    uint8_t  e2f[POLY_MAX_E][2];          // Edge → Face adjacency (2 faces per edge)
+    poly_idx_t  E;                         // Number of unique edges
+    Edge       *e;                         // [S/2] Edge list (a < b)
+    poly_idx_t (*e2f)[2];                  // [S/2] Edge → Face adjacency (2 faces per edge)
+    uint16_t   *v2e_off;                   // [V+1] Vertex → Edge CSR: edges of v are
+    poly_idx_t *v2e;                       // [S]     v2e[v2e_off[v] .. v2e_off[v+1])
+
+    uint32_t gen;                          // new value whenever v / topology changed (poly_touch)
 } Polyhedron;
 
 
@@ -70,12 +109,18 @@ uint16_t poly_edges(const Polyhedron *p, Edge *buf, uint16_t buf_sz);
 /* ────────────────────────────────────────────────────────────────────────── */
 void poly_rotate(Polyhedron *p, float yaw, float pitch, float roll);
 
+/**
+ * Rotationsmatrix, die poly_rotate() anwendet (Z-yaw → Y-pitch → X-roll),
+ * v' = R · v. Für Rotationen, die die Vertices nicht anfassen (led_view).
+ */
+void poly_rotation_matrix(float yaw, float pitch, float roll, float R[3][3]);
+
 /**
  * Orientiert das Polyeder so, dass der angegebene Vertex unten steht (Z-Achse durch den Vertex).
  * @param p     Pointer auf das Polyhedron-Objekt
  * @param vidx  Index des Vertex
  */
-void poly_orient_to_vertex(Polyhedron *p, uint8_t vidx);
+void poly_orient_to_vertex(Polyhedron *p, poly_idx_t vidx);
 
 /**
  * Orientiert das Polyeder so, dass die angegebene Kante unten steht.
@@ -84,55 +129,82 @@ void poly_orient_to_vertex(Polyhedron *p, uint8_t vidx);
  * @param v0    Erster Vertex-Index der Kante
  * @param v1    Zweiter Vertex-Index der Kante
  */
-void poly_orient_to_edge(Polyhedron *p, uint8_t v0, uint8_t v1);
+void poly_orient_to_edge(Polyhedron *p, poly_idx_t v0, poly_idx_t v1);
 
 /**
  * Orientiert das Polyeder so, dass die angegebene Fläche unten steht.
  * @param p     Pointer auf das Polyhedron-Objekt
  * @param fidx  Index der Face
  */
-void poly_orient_to_face(Polyhedron *p, uint8_t fidx);
+void poly_orient_to_face(Polyhedron *p, poly_idx_t fidx);
+
+/* All carve p's arrays from a (intermediate solids go to a heap scratch that
+ * is freed again), false if a or the heap is too small. */
+bool poly_init_tetrahedron 							(Polyhedron *p, PolyArena *a);
+bool poly_init_cube        							(Polyhedron *p, PolyArena *a);
+bool poly_init_octahedron  							(Polyhedron *p, PolyArena *a);
+bool poly_init_icosahedron 							(Polyhedron *p, PolyArena *a);
+bool poly_init_dodecahedron							(Polyhedron *p, PolyArena *a); // Dual of icosahedron
+bool poly_init_rhombitruncated_icosidodecahedron	(Polyhedron *p, PolyArena *a); // V 62, F 120
+bool poly_init_icosidodecahedron					(Polyhedron *p, PolyArena *a); // V 30, F 32
 
-void poly_init_tetrahedron 							(Polyhedron *p);
-void poly_init_cube        							(Polyhedron *p);
-void poly_init_octahedron  							(Polyhedron *p);
-void poly_init_icosahedron 							(Polyhedron *p);
-void poly_init_dodecahedron							(Polyhedron *p); // Dual of icosahedron
-void poly_init_rhombitruncated_icosidodecahedron	(Polyhedron *p); //broke rn (definete stack overflow)
-void poly_init_icosidodecahedron					(Polyhedron *p); //can get to work maybe (tune down max FV etc..)
+/**
+ * Build a solid from Conway notation, operators apply right to left:
+ * seeds T C O I D, operators d (dual), a (ambo), t (truncate), k (kis),
+ * e.g. "aD" = icosidodecahedron, "tI" = truncated icosahedron.
+ * Intermediate stages share one heap scratch, only the result goes to a.
+ * @return false on an unknown letter, too many operators, a result beyond the
+ *         index limits, or if a / the heap is too small
+ */
+bool   poly_init_conway (Polyhedron *p, PolyArena *a, const char *ops);
+/* arena bytes poly_init_conway(ops) needs in a, 0 if ops is invalid */
+size_t poly_conway_bytes(const char *ops);
 
 /* ────────────────────────────────────────────────────────────────────────── */
 /* TOPOLOGY HELPERS                                                           */
 /* ────────────────────────────────────────────────────────────────────────── */
 
-void     poly_prepare(Polyhedron *p);  // Builds edges + e2f
+void     poly_prepare(Polyhedron *p);  // Builds edges + e2f + v2e, then poly_touch()
+/* p->gen = a value no polyhedron had before: caches derived from p (LED
+ * positions, distances, ...) compare it to know they are stale. Call it after
+ * writing p->v directly, poly_prepare() and everything built on it already do. */
+void     poly_touch(Polyhedron *p);
 
 /* ── Edge Access ────────────────────────────────────────────────────────── */
-uint8_t  poly_edge_count(const Polyhedron *p);
-Edge     poly_get_edge(const Polyhedron *p, uint8_t idx);
-uint8_t  poly_find_edge(const Polyhedron *p, uint8_t v0, uint8_t v1);
-void     poly_edge_faces(const Polyhedron *p, uint8_t edgeIdx, uint8_t out[2]);
+poly_idx_t poly_edge_count(const Polyhedron *p);
+Edge       poly_get_edge(const Polyhedron *p, poly_idx_t idx);
+poly_idx_t poly_find_edge(const Polyhedron *p, poly_idx_t v0, poly_idx_t v1);   // POLY_IDX_NONE if none, O(vertex degree)
+void       poly_edge_faces(const Polyhedron *p, poly_idx_t edgeIdx, poly_idx_t out[2]);
+
+/* ── Vertex Access ──────────────────────────────────────────────────────── */
+/* incident edges of a vertex (ascending edge index), *n = vertex degree */
+const poly_idx_t* poly_vertex_edges(const Polyhedron *p, poly_idx_t vIdx, uint8_t *n);
+/* the other end of edge e seen from vertex v */
+static inline poly_idx_t poly_edge_other(const Polyhedron *p, poly_idx_t e, poly_idx_t v) {
+    return (poly_idx_t)(p->e[e].a == v ? p->e[e].b : p->e[e].a);
+}
 
 /* ── Face Access ────────────────────────────────────────────────────────── */
-uint8_t        	poly_face_vertex_count(const Polyhedron *p, uint8_t faceIdx);
-const uint8_t* 	poly_face_vertices(const Polyhedron *p, uint8_t faceIdx);
-bool 			poly_face_edge_is_ccw(const Polyhedron *p, uint8_t faceIdx, uint8_t edgeIdx);
-
-/*────────────────────  SMALL POOL ALLOCATOR  ────────────────────*/
-/**
- * Allocate one zero-initialized Polyhedron on the heap.
- * Returns NULL if out of memory.
- */
-static inline Polyhedron *poly_alloc(void) {
-    Polyhedron *p = malloc(sizeof *p);
-    if (p) memset(p, 0, sizeof *p);
-    return p;
+uint8_t           poly_face_vertex_count(const Polyhedron *p, poly_idx_t faceIdx);
+const poly_idx_t* poly_face_vertices(const Polyhedron *p, poly_idx_t faceIdx);
+bool              poly_face_edge_is_ccw(const Polyhedron *p, poly_idx_t faceIdx, poly_idx_t edgeIdx);
+
+/*────────────────────  ARENA  ────────────────────*/
+static inline void poly_arena_init(PolyArena *a, void *mem, size_t size) {
+    a->mem  = (uint8_t *)mem;
+    a->size = size;
+    a->used = 0;
 }
 
-/**
- * Free a Polyhedron previously returned by poly_alloc().
- */
-static inline void poly_free(Polyhedron *p) {
-    free(p);
-}
+/* what every arena block is aligned to: 4 on the MCU, pointer size on a
+ * 64 bit host (tools/host); size scratch sums with POLY_ARENA_ALIGN */
+#define POLY_ALIGN            (sizeof(void *) > 4 ? sizeof(void *) : 4u)
+#define POLY_ARENA_ALIGN(n)   (((n) + POLY_ALIGN - 1) & ~(size_t)(POLY_ALIGN - 1))
+
+/* POLY_ALIGN aligned, NULL if the arena is full */
+void  *poly_arena_alloc(PolyArena *a, size_t bytes);
+
+/* arena bytes a polyhedron with V vertices, F faces and S face slots takes */
+size_t poly_bytes(poly_idx_t V, poly_idx_t F, uint16_t S);
+
 #endif  // POLYHEDRON_H
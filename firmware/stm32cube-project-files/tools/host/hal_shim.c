@@ -0,0 +1,227 @@
+/* --------------------------------------------------------------------------
+ * hal_shim.c – the HAL calls led/ makes, on the host (shim/stm32f4xx_hal.h)
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include <time.h>
+#include "hal_shim.h"
+
+uint32_t SystemCoreClock = 84000000u;
+
+CoreDebug_Type     hal_shim_coredebug;
+SCB_Type           hal_shim_scb;
+TIM_TypeDef        hal_shim_tim[14];
+DMA_TypeDef        hal_shim_dma[2];
+DMA_Stream_TypeDef hal_shim_dma_stream[2][8];
+USART_TypeDef      hal_shim_usart[6];
+EXTI_TypeDef       hal_shim_exti;
+RCC_TypeDef        hal_shim_rcc;
+SPI_TypeDef        hal_shim_spi[5];
+GPIO_TypeDef       hal_shim_gpio[8];
+CRC_TypeDef        hal_shim_crc;
+
+CRC_HandleTypeDef  hcrc = { .Instance = &hal_shim_crc };
+
+/* linker symbols the heap / RAM reports read: a run reports nonsense there */
+char     _sramfunc = 0, _estack = 0;
+extern char _eramfunc __attribute__((alias("_sramfunc")));     /* no .RamFunc here */
+uint32_t _Min_Stack_Size;
+void *_sbrk(ptrdiff_t incr) { (void)incr; return &_estack; }
+
+/* ── time ──────────────────────────────────────────────────────────────── */
+static DWT_Type dwt;
+static bool     realtime;
+static uint64_t virtual_us;
+static uint64_t t0_ns;
+
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    if (!t0_ns) t0_ns = ns - 1;
+    return ns - t0_ns;
+}
+
+DWT_Type *hal_shim_dwt(void)
+{
+    dwt.CYCCNT = (uint32_t)(host_ns() * (SystemCoreClock / 1000000u) / 1000u);
+    return &dwt;
+}
+
+void hal_shim_set_realtime(bool on)
+{
+    realtime = on;
+}
+
+bool hal_shim_realtime(void)
+{
+    return realtime;
+}
+
+void hal_shim_set_time_us(uint64_t us)
+{
+    virtual_us = us;
+}
+
+uint64_t hal_shim_now_us(void)
+{
+    return realtime ? host_ns() / 1000u : virtual_us;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(hal_shim_now_us() / 1000u);
+}
+
+void HAL_Delay(uint32_t ms)
+{
+    if (!realtime) { virtual_us += (uint64_t)ms * 1000u; return; }
+    struct timespec ts = { ms / 1000u, (long)(ms % 1000u) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) { return SystemCoreClock / 2u; }
+uint32_t HAL_RCC_GetPCLK2Freq(void) { return SystemCoreClock; }
+
+/* ── GPIO, DMA handles: nothing to drive ───────────────────────────────── */
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init) { (void)port; (void)init; }
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if (state) port->ODR |= pin;
+    else       port->ODR &= ~(uint32_t)pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin)
+{
+    port->ODR ^= pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) { (void)hdma; return HAL_OK; }
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+
+/* ── SPI and TIM5: queued, hal_shim_isr_run() plays the interrupts ────── */
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    const uint8_t     *data;
+    uint16_t           size;
+} Transfer;
+
+static Transfer      queue[HAL_SHIM_SPI_MAX];
+static uint8_t       queued;
+static HalShimSpiFn  on_spi;
+
+void hal_shim_on_spi(HalShimSpiFn fn)
+{
+    on_spi = fn;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t size)
+{
+    if (queued == HAL_SHIM_SPI_MAX) return HAL_BUSY;
+    for (uint8_t i = 0; i < queued; ++i) {
+        if (queue[i].hspi == hspi) return HAL_BUSY;     /* still sending */
+    }
+    queue[queued++] = (Transfer){ hspi, data, size };
+    return HAL_OK;
+}
+
+/* the bytes in wire order: a 16 bit frame's high byte first */
+static const uint8_t *wire_bytes(const Transfer *t, uint16_t *bytes)
+{
+    static uint8_t swapped[UINT16_MAX + 1u];
+    if (t->hspi->Init.DataSize != SPI_DATASIZE_16BIT) {
+        *bytes = t->size;
+        return t->data;
+    }
+    uint32_t n = (uint32_t)t->size * 2u;
+    if (n > UINT16_MAX) n = UINT16_MAX & ~1u;     /* the capture's size field */
+    for (uint32_t i = 0; i < n; i += 2) {
+        swapped[i]     = t->data[i + 1];
+        swapped[i + 1] = t->data[i];
+    }
+    *bytes = (uint16_t)n;
+    return swapped;
+}
+
+HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef *hspi)
+{
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < queued; ++i) {
+        if (queue[i].hspi != hspi) queue[k++] = queue[i];
+    }
+    queued = k;
+    return HAL_OK;
+}
+
+/* a one-pulse timer with its update interrupt on: it has run out */
+static bool timer_due(TIM_TypeDef *t)
+{
+    if (!(t->CR1 & TIM_CR1_CEN) || !(t->DIER & TIM_DIER_UIE)) return false;
+    if (t->CR1 & TIM_CR1_OPM) t->CR1 &= ~TIM_CR1_CEN;
+    t->SR |= TIM_SR_UIF;
+    return true;
+}
+
+uint32_t hal_shim_isr_run(void)
+{
+    uint32_t done = 0;
+    for (;;) {                          /* a completion may start the next frame */
+        if (queued) {
+            Transfer t = queue[0];
+            memmove(&queue[0], &queue[1], sizeof queue[0] * --queued);
+            if (on_spi) {
+                uint16_t bytes;
+                const uint8_t *data = wire_bytes(&t, &bytes);
+                on_spi(t.hspi, data, bytes);
+            }
+            HAL_SPI_TxCpltCallback(t.hspi);
+        } else if (timer_due(TIM5)) {
+            TIM5_IRQHandler();          /* led_render.c's latch timer */
+        } else {
+            return done;
+        }
+        ++done;
+    }
+}
+
+__weak void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)     { (void)hspi; }
+__weak void HAL_SPI_TxHalfCpltCallback(SPI_HandleTypeDef *hspi) { (void)hspi; }
+__weak void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)      { (void)hspi; }
+__weak void TIM5_IRQHandler(void)                               { TIM5->CR1 = 0; }
+
+/* ── CRC unit: CRC-32/MPEG-2 over whole words, MSB first, by table ───── */
+static uint32_t crc_tbl[256];
+
+static uint32_t crc_word(uint32_t crc, uint32_t w)
+{
+    if (!crc_tbl[1]) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i << 24;
+            for (int k = 0; k < 8; ++k) c = (c & 0x80000000u) ? (c << 1) ^ 0x04C11DB7u : c << 1;
+            crc_tbl[i] = c;
+        }
+    }
+    crc ^= w;
+    for (int i = 0; i < 4; ++i) crc = (crc << 8) ^ crc_tbl[crc >> 24];
+    return crc;
+}
+
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *h, uint32_t *buf, uint32_t words)
+{
+    uint32_t crc = h->Instance->DR;
+    for (uint32_t i = 0; i < words; ++i) crc = crc_word(crc, buf[i]);
+    h->Instance->DR = crc;
+    return crc;
+}
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *h, uint32_t *buf, uint32_t words)
+{
+    h->Instance->DR = 0xFFFFFFFFu;
+    return HAL_CRC_Accumulate(h, buf, words);
+}
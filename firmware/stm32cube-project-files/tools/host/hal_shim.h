@@ -0,0 +1,46 @@
+/*
+ * hal_shim.h – what the host runner (led_host.c) steers the HAL shim with
+ *
+ * Time: by default the run has a virtual clock, HAL_GetTick() and the frame
+ * number (frame_sync, see host_modules.c) are set by the runner frame by
+ * frame, so the same command draws the same frames on every machine and
+ * every run. With realtime they follow the host's clock instead, the way
+ * a free running board would. DWT->CYCCNT is always the host's clock:
+ * what the profiler zones measure is real work.
+ */
+
+#ifndef _HAL_SHIM_H_
+#define _HAL_SHIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx_hal.h"
+
+/* transfers that can be in flight at once (one per strip) */
+#define HAL_SHIM_SPI_MAX        8
+
+/* a strip's bytes, as the SPI would have clocked them out */
+typedef void (*HalShimSpiFn)(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t size);
+
+void     hal_shim_set_realtime(bool on);
+bool     hal_shim_realtime(void);
+void     hal_shim_set_time_us(uint64_t us);
+uint64_t hal_shim_now_us(void);
+
+/* frame number and period the firmware's frame_sync / frame_clock report */
+void     host_set_frame(uint32_t frame, uint32_t period_us);
+
+void     hal_shim_on_spi(HalShimSpiFn fn);
+
+/**
+ * Plays the interrupts the frame's output raises, as soon as nothing else
+ * runs: every queued SPI transfer goes to the capture hook and completes
+ * (HAL_SPI_TxCpltCallback), a running TIM5 one-pulse (led_render.c's latch
+ * timer) fires, until the transfers these start are done as well
+ * @return interrupts played
+ */
+uint32_t hal_shim_isr_run(void);
+
+void TIM5_IRQHandler(void);
+
+#endif /* _HAL_SHIM_H_ */
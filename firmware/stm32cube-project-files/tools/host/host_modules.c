@@ -0,0 +1,252 @@
+/* --------------------------------------------------------------------------
+ * host_modules.c – host versions of the led/ modules that are hardware
+ *
+ * Left out of the host build and replaced here, API for API:
+ *   frame_clock.c   TIM2 slots         → the runner's frame period
+ *   frame_sync.c    host frame lock    → locked to the runner's frame number
+ *                                        (anim_clock's deterministic path)
+ *   dma_mem.c       DMA2 mem-to-mem    → memcpy / fill, done on return
+ *   flash_store.c   sector 5 records   → RAM, empty at start (a fresh board)
+ *   usb_comms.c     CDC console + ring → text to stdout, packets counted,
+ *                                        console lines of a replay not run
+ *   audio_in.c      ADC1 / TIM3 / DMA  → a synthetic 120 BPM kick over noise,
+ *                                        blocks due on the run's clock
+ *   clip.c          flash partition    → no clip stored, uploads unanswered
+ *   clock_scale.c   AHB prescaler      → HCLK stays where it is, level 0
+ *   supply.c        ADC1 / DMA2        → nothing measured, the limiter
+ *                                        runs on its model alone
+ *   pc_sample.c     TIM4 interrupt     → never started, nothing sampled
+ *   itm.c           SWO / TPIU         → no debugger attached, ports off
+ * -------------------------------------------------------------------------- */
+#include <string.h>
+#include "hal_shim.h"
+#include "frame_clock.h"
+#include "frame_sync.h"
+#include "dma_mem.h"
+#include "flash_store.h"
+#include "usb_comms.h"
+#include "audio_in.h"
+#include "clip.h"
+#include "clock_scale.h"
+#include "supply.h"
+#include "pc_sample.h"
+#include "itm.h"
+
+/* ── frame_clock / frame_sync ──────────────────────────────────────────── */
+static FrameClockStats clock_stats = { .period_us = 1000000UL / FRAME_CLOCK_FPS };
+static FrameSyncStats  sync_stats;
+
+void host_set_frame(uint32_t frame, uint32_t period_us)
+{
+    clock_stats.period_us = period_us;
+    clock_stats.frames    = frame + 1;
+    sync_stats.frame      = frame;
+    sync_stats.locked     = !hal_shim_realtime();
+}
+
+bool frame_clock_init(uint16_t fps)       { clock_stats.period_us = 1000000UL / fps; return true; }
+bool frame_clock_begin(void)              { return true; }
+void frame_clock_end(void)                { }
+bool frame_clock_pending(void)            { return false; }
+uint32_t frame_clock_slack_us(void)       { return clock_stats.period_us; }
+void frame_clock_set_period(uint32_t us)  { clock_stats.period_us = us; }
+void frame_clock_adjust(int32_t us)       { (void)us; }
+uint32_t frame_clock_tick_cyc(void)       { return DWT->CYCCNT; }
+const FrameClockStats *frame_clock_stats(void) { return &clock_stats; }
+
+void frame_sync_sample(uint32_t host_us, uint32_t frame, uint32_t phase_us,
+                       uint32_t period_us, uint32_t rx_cyc)
+{
+    (void)host_us; (void)frame; (void)phase_us; (void)period_us; (void)rx_cyc;
+}
+void     frame_sync_tick(void)            { }
+uint32_t frame_sync_frame(void)           { return sync_stats.frame; }
+bool     frame_sync_locked(void)          { return sync_stats.locked; }
+bool     frame_sync_due(uint32_t frame)   { return (int32_t)(sync_stats.frame - frame) >= 0; }
+const FrameSyncStats *frame_sync_stats(void) { return &sync_stats; }
+
+/* ── dma_mem ───────────────────────────────────────────────────────────── */
+void dma_mem_init(void) { }
+bool dma_mem_busy(void) { return false; }
+void dma_mem_wait(void) { }
+
+bool dma_mem_copy(void *dst, const void *src, size_t bytes)
+{
+    memcpy(dst, src, bytes);
+    return true;
+}
+
+bool dma_mem_fill(void *dst, uint32_t word, size_t bytes)
+{
+    uint8_t *d = dst;
+    for (size_t i = 0; i < bytes; ++i) d[i] = (uint8_t)(word >> (8 * (i & 3)));
+    return true;
+}
+
+/* ── flash_store ───────────────────────────────────────────────────────── */
+static struct {
+    uint16_t key, len;
+    uint8_t  data[FLASH_STORE_MAX_LEN];
+} store[FLASH_STORE_KEYS];
+
+bool flash_store_get(uint16_t key, void *buf, uint16_t len)
+{
+    for (uint8_t i = 0; i < FLASH_STORE_KEYS; ++i) {
+        if (store[i].len && store[i].key == key && store[i].len == len) {
+            memcpy(buf, store[i].data, len);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool flash_store_put(uint16_t key, const void *buf, uint16_t len)
+{
+    if (!len || len > FLASH_STORE_MAX_LEN) return false;
+    for (uint8_t i = 0; i < FLASH_STORE_KEYS; ++i) {
+        if (!store[i].len || store[i].key == key) {
+            store[i].key = key;
+            store[i].len = len;
+            memcpy(store[i].data, buf, len);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool flash_store_erase(void)
+{
+    memset(store, 0, sizeof store);
+    return true;
+}
+
+bool flash_store_erase_keep(void)
+{
+    return true;                    /* the records are all there is */
+}
+
+/* ── usb_comms ─────────────────────────────────────────────────────────── */
+volatile bool host_open = false;
+USBD_HandleTypeDef hUsbDeviceFS;
+
+static TxPolicy policy[TX_CH_COUNT];
+static uint32_t packet_bytes;
+
+uint32_t usb_tx_write(TxChannel ch, const void *buf, uint32_t len)
+{
+    if (ch == TX_CH_TEXT) return (uint32_t)fwrite(buf, 1, len, stdout);
+    packet_bytes += len;                /* nobody listening */
+    return len;
+}
+
+uint32_t usb_tx_room(void)                      { return TX_BUF_SIZE; }
+uint32_t usb_tx_channel_room(TxChannel ch)      { (void)ch; return TX_BUF_SIZE; }
+void     usb_tx_set_policy(TxChannel ch, TxPolicy p) { policy[ch] = p; }
+TxPolicy usb_tx_policy(TxChannel ch)            { return policy[ch]; }
+uint32_t usb_tx_dropped(TxChannel ch)           { return ch == TX_CH_PACKET ? packet_bytes : 0; }
+uint8_t  usb_comms_receive(uint8_t *buf, uint32_t len) { (void)buf; (void)len; return USBD_OK; }
+void     usb_set_host_open(bool open)           { host_open = open; }
+void     usb_tx_complete_isr(void)              { }
+void     usb_tx_pipe_done(TxPipe pipe)          { (void)pipe; }
+void     usb_comms_process(void)                { }
+bool     usb_comms_rx_pending(void)             { return false; }
+bool     usb_comms_run_line(const char *line)   { (void)line; return false; }
+void     flush_usb_buffer(void)                 { fflush(stdout); }
+uint8_t  CDC_Transmit_FS(uint8_t *buf, uint16_t len) { (void)buf; (void)len; return USBD_OK; }
+
+/* ── audio_in ──────────────────────────────────────────────────────────── */
+#ifdef LED_AUDIO
+#include <math.h>
+
+#define HOP_US  (1000000ull * AUDIO_HOP / AUDIO_FS_HZ)
+
+static uint16_t block[AUDIO_HOP];
+static uint64_t audio_t0;
+static uint64_t audio_taken;        /* blocks handed out, or skipped over */
+static uint32_t audio_seed = 1;
+
+static uint64_t audio_filled(void) { return (hal_shim_now_us() - audio_t0) / HOP_US; }
+
+void audio_in_start(void) { audio_t0 = hal_shim_now_us(); audio_taken = 0; }
+void audio_in_stop(void)  { }
+bool audio_in_ready(void) { return audio_filled() > audio_taken; }
+
+/* block n: a 60 Hz kick decaying from every half second, low noise, mid supply */
+const uint16_t *audio_in_take(uint32_t *lost)
+{
+    uint64_t f = audio_filled();
+    if (f <= audio_taken) return NULL;
+    if (lost) *lost = (uint32_t)(f - audio_taken - 1);
+    audio_taken = f;
+    uint64_t s0 = (f - 1) * AUDIO_HOP;
+    for (uint16_t i = 0; i < AUDIO_HOP; ++i) {
+        double t    = (double)(s0 + i) / AUDIO_FS_HZ;
+        double beat = fmod(t, 0.5);
+        double kick = 1500.0 * exp(-beat * 12.0) * sin(2.0 * M_PI * 60.0 * beat);
+        audio_seed  = audio_seed * 1664525u + 1013904223u;
+        double hiss = ((double)(audio_seed >> 16) / 65536.0 - 0.5) * 40.0;
+        block[i]    = (uint16_t)(2048.0 + kick + hiss);
+    }
+    return block;
+}
+#endif
+
+/* ── clip ──────────────────────────────────────────────────────────────── */
+#ifdef LED_CLIP
+static ClipStats clip_none;
+
+bool clip_play(bool loop)     { (void)loop; return false; }
+void clip_stop(void)          { }
+bool clip_playing(void)       { return false; }
+bool clip_tick(void)          { return false; }
+const ClipStats *clip_stats(void) { return &clip_none; }
+
+bool clip_info(uint16_t *leds, float *fps, uint32_t *frames, uint32_t *bytes)
+{
+    (void)leds; (void)fps; (void)frames; (void)bytes;
+    return false;
+}
+
+int16_t clip_packet(const uint8_t *p, uint8_t n, uint8_t *out, uint16_t cap)
+{
+    (void)p; (void)n; (void)out; (void)cap;
+    return -1;
+}
+#endif
+
+/* ── clock_scale ───────────────────────────────────────────────────────── */
+#ifdef LED_CLOCK_SCALE
+void    clk_scale_tick(void)              { }
+uint8_t clk_scale_level(void)             { return 0; }
+void    clk_scale_force(int8_t level)     { (void)level; }
+void    clk_scale_report(void)            { USBD_UsrLog("clock: level 0, host\n"); }
+#endif
+
+/* ── supply ────────────────────────────────────────────────────────────── */
+#ifdef LED_SUPPLY_MON
+static const SupplyStats supply_none = { .gain_q8 = 256, .budget_ma = LED_POWER_LIMIT_MA,
+                                          .min_mv = UINT16_MAX };
+
+void supply_init(void)                    { }
+void supply_tick(void)                    { }
+const SupplyStats *supply_stats(void)     { return &supply_none; }
+void supply_report(void)                  { USBD_UsrLog("supply: not measured (host)\n"); }
+#endif
+
+/* ── pc_sample ─────────────────────────────────────────────────────────── */
+#ifdef LED_PC_SAMPLE
+static PcsStats pcs_none;
+
+void     pcs_set_hz(uint16_t hz)          { (void)hz; }
+uint16_t pcs_hz(void)                     { return 0; }
+void     pcs_tick(void)                   { }
+const PcsStats *pcs_stats(void)           { return &pcs_none; }
+#endif
+
+/* ── itm ───────────────────────────────────────────────────────────────── */
+#ifdef LED_ITM
+void itm_init(void)                       { }
+bool itm_port_on(uint8_t port)            { (void)port; return false; }
+void itm_put32(uint8_t port, uint32_t v)  { (void)port; (void)v; }
+void itm_write(uint8_t port, const void *buf, uint32_t len) { (void)port; (void)buf; (void)len; }
+#endif
@@ -0,0 +1,511 @@
+/*
+ * led_host.c – host tool: the LED engine headless on the desktop
+ *
+ * led/ and polyhedron/ built natively against a HAL shim (shim/, hal_shim.c,
+ * host_modules.c): boots the scene as main.c does (dodecahedron, three SPI
+ * strips), runs one animation for a number of frames and reports what each
+ * stage cost. Not part of the CubeIDE build. From tools/host:
+ *
+ *   make
+ *   ./led_host -l                                   list the animations
+ *   ./led_host -n 600 -o frames.rgb -w spi.bin plasma
+ *
+ *   -n frames     frames to run (600)
+ *   -r fps        frame rate the animation is stepped at (FRAME_CLOCK_FPS)
+ *   -b level      g_global_brightness (255)
+ *   -o file       framebuffers: 3 bytes per LED in framebuffer order, one
+ *                 block per frame (what PKT_PIXELS mirrors, led_mirror.h)
+ *   -w file       SPI bytes: frame u32 | strip u8 | length u16 | bytes, per
+ *                 transfer, little endian (encoded, gamma and brightness in)
+ *   -t            real time: frames paced by the host clock, the animation
+ *                 clock free running from DWT, as on a board without a host
+ *   -p file       play a recording of the board's input (replay.h, "rec
+ *                 dump", saved by the app as logs/rec_<time>.bin): its
+ *                 animation, seed, quality level and frame count, the
+ *                 packets handed over at the frames they came before
+ *                 (console lines are counted, not run). Needs a build
+ *                 with CFLAGS_EXTRA=-DLED_REPLAY.
+ *
+ * Without -t time is virtual: frame n is drawn at n × period, the animation
+ * clock locked to the frame number (frame_sync), so two runs of the same
+ * command write the same files. The stage times are measured either way
+ * (DWT->CYCCNT is the host's clock): the profiler zones (profiler.h) plus
+ * the whole anim_tick() and the interrupts that complete the frame, per
+ * frame.
+ *
+ * Golden frames, for changes that must not change the picture (or only by
+ * so much): record every animation (or the ones named) on the tree as it
+ * is, make the change, check against the recording:
+ *
+ *   ./led_host -g golden [-n frames] [animation ...]      (make golden)
+ *   ./led_host -c golden [-e tolerance] [animation ...]   (make check)
+ *
+ *   -g dir        one dir/<name>.golden per animation: the -o frames behind
+ *                 a header with the LED count, frame count, period and the
+ *                 average anim_tick() time of the recording
+ *   -c dir        draws each animation as recorded (frames, period) and
+ *                 compares frame by frame: worst channel error, mean error,
+ *                 PSNR, frames off by more than -e (0, exact), next to the
+ *                 recorded and the current anim_tick() time. Exit status 1
+ *                 if a frame is off or a recording is missing.
+ *
+ * Every animation starts the same way in both: from RNG_SEED, quality
+ * level 0, a dark framebuffer, virtual time from 0.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "hal_shim.h"
+#include "scene.h"
+#include "scene_mem.h"
+#include "led_anim.h"
+#include "led_render.h"
+#include "led_mapping.h"
+#include "led_rng.h"
+#include "led_governor.h"
+#include "profiler.h"
+#include "replay.h"
+#include "audio.h"
+
+#define GOLDEN_MAGIC    "IPGF"
+#define GOLDEN_VERSION  1
+
+/* dir/<name>.golden: this, then frames × leds × 3 bytes (-o's layout) */
+typedef struct {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  pad;
+    uint16_t leds;
+    uint32_t frames;
+    uint32_t period_us;
+    uint64_t tick_ns;           /* average anim_tick() of the recording */
+} GoldenHead;
+
+/* what a golden check found for one animation */
+typedef struct {
+    const uint8_t *ref;         /* the recorded frames */
+    uint8_t        tol;
+    uint32_t       bad;         /* frames with a channel off by more than tol */
+    int64_t        first_bad;
+    uint8_t        worst;
+    uint64_t       abs_sum;
+    uint64_t       sq_sum;
+} Diff;
+
+typedef void (*FrameFn)(void *ctx, uint32_t frame, const uint8_t *rgb, uint16_t leds);
+
+static DMA_HandleTypeDef hdma_tx[3];     /* LED_SPI_16BIT sets them up */
+static SPI_HandleTypeDef hspi1 = { .Instance = SPI1, .Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_32,
+                                   .hdmatx = &hdma_tx[0] };
+static SPI_HandleTypeDef hspi2 = { .Instance = SPI2, .Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16,
+                                   .hdmatx = &hdma_tx[1] };
+static SPI_HandleTypeDef hspi3 = { .Instance = SPI3, .Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16,
+                                   .hdmatx = &hdma_tx[2] };
+static SPI_HandleTypeDef *const led_spis[] = { &hspi1, &hspi2, &hspi3 };   /* as main.c */
+
+static FILE     *spi_out;
+static uint32_t  frame;
+static uint64_t  spi_bytes;
+static uint32_t  spi_transfers;
+
+typedef struct {
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t min_ns;
+} Stage;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void stage_add(Stage *s, uint64_t ns)
+{
+    s->sum_ns += ns;
+    if (ns > s->max_ns) s->max_ns = ns;
+    if (!s->min_ns || ns < s->min_ns) s->min_ns = ns;
+}
+
+static void stage_print(const char *name, const Stage *s, uint32_t n)
+{
+    printf("  %-10s %7u %9.1f %9.1f %9.1f\n", name, (unsigned)n,
+           s->min_ns / 1e3, n ? s->sum_ns / 1e3 / n : 0.0, s->max_ns / 1e3);
+}
+
+static void capture_spi(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t size)
+{
+    ++spi_transfers;
+    spi_bytes += size;
+    if (!spi_out) return;
+    uint8_t strip = 0;
+    while (strip < sizeof led_spis / sizeof led_spis[0] && led_spis[strip] != hspi) ++strip;
+    uint8_t head[7] = {
+        (uint8_t)frame, (uint8_t)(frame >> 8), (uint8_t)(frame >> 16), (uint8_t)(frame >> 24),
+        strip, (uint8_t)size, (uint8_t)(size >> 8)
+    };
+    fwrite(head, 1, sizeof head, spi_out);
+    fwrite(data, 1, size, spi_out);
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: led_host [-l] [-n frames] [-r fps] [-b level] [-o frames.rgb] "
+                    "[-w spi.bin] [-t] animation\n"
+                    "       led_host -p recording [-o frames.rgb] [-w spi.bin]\n"
+                    "       led_host -g dir [-n frames] [-r fps] [animation ...]\n"
+                    "       led_host -c dir [-e tolerance] [animation ...]\n");
+    return 2;
+}
+
+/* the same start for every run: seed, quality, a dark framebuffer */
+static void anim_begin(uint8_t anim, uint8_t level)
+{
+    rng_seed(RNG_SEED);
+    anim_release();
+    gov_force(0);
+    set_all_pixels_color(0, 0, 0);
+    anim_select(anim);
+    g_global_brightness = level;
+}
+
+/* the drawn frame as 3 bytes per LED, whatever the pixel format */
+static const uint8_t *frame_rgb(uint16_t leds)
+{
+    const rgb_8b *fb = render_acquire_back();
+    if (!fb || sizeof *fb == 3) return (const uint8_t *)fb;
+    static uint8_t *packed;
+    static uint16_t packed_leds;
+    if (packed_leds != leds) {
+        free(packed);
+        packed      = malloc(3u * leds);
+        packed_leds = packed ? leds : 0;
+    }
+    if (!packed) return NULL;
+    for (uint16_t i = 0; i < leds; ++i) memcpy(&packed[3u * i], &fb[i], 3);
+    return packed;
+}
+
+/* frames of the selected animation, each handed to fn */
+static void run(uint32_t frames, uint32_t period_us, Stage *tick, Stage *isr, FrameFn fn, void *ctx)
+{
+    const uint16_t leds  = mapping_get_total_pixels();
+    const uint64_t start = now_ns();
+    for (frame = 0; frame < frames; ++frame) {
+        if (hal_shim_realtime()) {
+            uint64_t due = start + (uint64_t)frame * period_us * 1000u;
+            for (uint64_t t; (t = now_ns()) < due; ) {
+                struct timespec ts = { 0, (long)(due - t) };
+                nanosleep(&ts, NULL);
+            }
+        } else {
+            hal_shim_set_time_us((uint64_t)frame * period_us);
+        }
+        host_set_frame(frame, period_us);
+        replay_frame();
+        audio_tick();
+        audio_latch();
+
+        uint64_t t0 = now_ns();
+        anim_tick();
+        uint64_t t1 = now_ns();
+        hal_shim_isr_run();
+        uint64_t t2 = now_ns();
+        stage_add(tick, t1 - t0);
+        stage_add(isr, t2 - t1);
+
+        if (fn) fn(ctx, frame, frame_rgb(leds), leds);
+    }
+}
+
+#ifdef LED_REPLAY
+/* a recording: head and entries handed to replay_load(), its animation */
+static int replay_open(const char *path, uint32_t *frames, uint32_t *period_us)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return -1; }
+    ReplayHead h;
+    static uint8_t entries[REPLAY_BYTES];
+    bool ok = fread(&h, sizeof h, 1, f) == 1 && h.bytes <= REPLAY_BYTES &&
+              fread(entries, 1, h.bytes, f) == h.bytes && h.period_us && h.frames;
+    fclose(f);
+    h.anim[sizeof h.anim - 1] = '\0';
+    int anim = ok ? anim_find(h.anim) : -1;
+    if (!ok || anim < 0 || !replay_load(&h, entries)) {
+        fprintf(stderr, "%s: not a recording, or of an animation this build has not\n", path);
+        return -1;
+    }
+    *frames    = h.frames;
+    *period_us = h.period_us;
+    printf("%s: %s, %u frames, seed 0x%08x, quality %u, %u bytes of input\n", path, h.anim,
+           (unsigned)h.frames, (unsigned)h.seed, (unsigned)h.gov_level, (unsigned)h.bytes);
+    return anim;
+}
+#endif
+
+static void write_frame(void *ctx, uint32_t n, const uint8_t *rgb, uint16_t leds)
+{
+    (void)n;
+    fwrite(rgb, 3, leds, (FILE *)ctx);
+}
+
+static void diff_frame(void *ctx, uint32_t n, const uint8_t *rgb, uint16_t leds)
+{
+    Diff          *d   = ctx;
+    const uint8_t *ref = d->ref + (size_t)n * 3u * leds;
+    uint8_t        off = 0;
+    for (uint32_t i = 0; i < 3u * leds; ++i) {
+        uint8_t e = (uint8_t)abs((int)rgb[i] - (int)ref[i]);
+        d->abs_sum += e;
+        d->sq_sum  += (uint32_t)e * e;
+        if (e > off) off = e;
+    }
+    if (off > d->worst) d->worst = off;
+    if (off > d->tol) {
+        if (!d->bad) d->first_bad = n;
+        ++d->bad;
+    }
+}
+
+static void golden_path(char *buf, size_t len, const char *dir, const char *name)
+{
+    snprintf(buf, len, "%s/%s.golden", dir, name);
+}
+
+static bool golden_record(const char *dir, uint8_t anim, uint32_t frames, uint32_t period_us)
+{
+    char path[512];
+    golden_path(path, sizeof path, dir, anim_get(anim)->name);
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror(path); return false; }
+
+    GoldenHead h = { .magic = GOLDEN_MAGIC, .version = GOLDEN_VERSION,
+                     .leds = mapping_get_total_pixels(), .frames = frames, .period_us = period_us };
+    Stage tick = { 0 }, isr = { 0 };
+    fwrite(&h, sizeof h, 1, f);
+    anim_begin(anim, 255);
+    run(frames, period_us, &tick, &isr, write_frame, f);
+    h.tick_ns = tick.sum_ns / frames;
+    fseek(f, 0, SEEK_SET);
+    fwrite(&h, sizeof h, 1, f);                 /* now with the time */
+    bool ok = !ferror(f);
+    if (fclose(f) || !ok) { perror(path); return false; }
+
+    printf("  %-10s %6u frames, %7.1f us a tick -> %s\n", anim_get(anim)->name,
+           (unsigned)frames, tick.sum_ns / 1e3 / frames, path);
+    return true;
+}
+
+/* false if a frame is off by more than tol or there is nothing to compare */
+static bool golden_check(const char *dir, uint8_t anim, uint8_t tol)
+{
+    const char *name = anim_get(anim)->name;
+    char path[512];
+    golden_path(path, sizeof path, dir, name);
+    FILE *f = fopen(path, "rb");
+    if (!f) { printf("  %-10s no recording (%s)\n", name, path); return false; }
+
+    GoldenHead h;
+    const uint16_t leds = mapping_get_total_pixels();
+    if (fread(&h, sizeof h, 1, f) != 1 || memcmp(h.magic, GOLDEN_MAGIC, 4) ||
+        h.version != GOLDEN_VERSION || !h.frames || !h.period_us) {
+        printf("  %-10s not a golden file\n", name);
+        fclose(f);
+        return false;
+    }
+    if (h.leds != leds) {
+        printf("  %-10s recorded with %u LEDs, %u now\n", name, (unsigned)h.leds, (unsigned)leds);
+        fclose(f);
+        return false;
+    }
+    size_t   bytes = (size_t)h.frames * 3u * leds;
+    uint8_t *ref   = malloc(bytes);
+    if (!ref || fread(ref, 1, bytes, f) != bytes) {
+        printf("  %-10s short recording\n", name);
+        free(ref);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    Diff  d = { .ref = ref, .tol = tol, .first_bad = -1 };
+    Stage tick = { 0 }, isr = { 0 };
+    anim_begin(anim, 255);
+    run(h.frames, h.period_us, &tick, &isr, diff_frame, &d);
+    free(ref);
+
+    double n    = (double)bytes;
+    double mse  = d.sq_sum / n;
+    double now  = tick.sum_ns / 1e3 / h.frames;
+    double was  = h.tick_ns / 1e3;
+    char   psnr[16], first[16];
+    if (mse > 0) snprintf(psnr, sizeof psnr, "%.1f", 10.0 * log10(255.0 * 255.0 / mse));
+    else         snprintf(psnr, sizeof psnr, "exact");
+    if (d.bad)   snprintf(first, sizeof first, "%lld", (long long)d.first_bad);
+    else         snprintf(first, sizeof first, "-");
+    printf("  %-10s %6u %6u %6s %4u %8.4f %7s %9.1f %9.1f %7.2fx  %s\n", name,
+           (unsigned)h.frames, (unsigned)d.bad, first, (unsigned)d.worst, d.abs_sum / n, psnr,
+           was, now, now > 0 ? was / now : 0.0, d.bad ? "FAIL" : "ok");
+    return !d.bad;
+}
+
+/* the named animations (or all) through record / check: failures */
+static int golden(const char *dir, bool record, char **names, int count,
+                  uint32_t frames, uint32_t period_us, uint8_t tol)
+{
+    uint8_t list[256], n = 0;
+    if (!count) {
+        for (uint8_t i = 0; i < anim_count(); ++i) list[n++] = i;
+    }
+    for (int k = 0; k < count; ++k) {
+        int a = anim_find(names[k]);
+        if (a < 0) {
+            fprintf(stderr, "no animation \"%s\" (-l lists them)\n", names[k]);
+            return -1;
+        }
+        list[n++] = (uint8_t)a;
+    }
+    if (!record) {
+        printf("  %-10s %6s %6s %6s %4s %8s %7s %9s %9s %8s\n", "animation", "frames", "off",
+               "first", "max", "mean", "psnr", "was us", "now us", "speedup");
+    }
+    if (record) mkdir(dir, 0777);               /* may be there already */
+    int failed = 0;
+    for (uint8_t i = 0; i < n; ++i) {
+        bool ok = record ? golden_record(dir, list[i], frames, period_us)
+                         : golden_check(dir, list[i], tol);
+        if (!ok) ++failed;
+    }
+    if (!record) printf("%u of %u animations as recorded (tolerance %u)\n",
+                        (unsigned)(n - failed), (unsigned)n, (unsigned)tol);
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t    frames = 600, fps = FRAME_CLOCK_FPS;
+    unsigned    level  = 255, tol = 0;
+    const char *rgb_path = NULL, *spi_path = NULL, *golden_dir = NULL, *play_path = NULL;
+    bool        list = false, record = false;
+
+    for (int c; (c = getopt(argc, argv, "ln:r:b:o:w:tg:c:e:p:")) != -1; ) {
+        switch (c) {
+        case 'l': list     = true;                                  break;
+        case 'n': frames   = (uint32_t)strtoul(optarg, NULL, 0);    break;
+        case 'r': fps      = (uint32_t)strtoul(optarg, NULL, 0);    break;
+        case 'b': level    = (unsigned)strtoul(optarg, NULL, 0);    break;
+        case 'o': rgb_path = optarg;                                break;
+        case 'w': spi_path = optarg;                                break;
+        case 't': hal_shim_set_realtime(true);                      break;
+        case 'g': golden_dir = optarg; record = true;               break;
+        case 'c': golden_dir = optarg; record = false;              break;
+        case 'e': tol      = (unsigned)strtoul(optarg, NULL, 0);    break;
+        case 'p': play_path = optarg;                               break;
+        default:  return usage();
+        }
+    }
+    if (list) {
+        for (uint8_t i = 0; i < anim_count(); ++i) printf("%s\n", anim_get(i)->name);
+        return 0;
+    }
+    if (!fps || !frames || level > 255 || tol > 255) return usage();
+    if (golden_dir ? hal_shim_realtime() || play_path
+                   : optind != argc - (play_path ? 0 : 1)) return usage();
+#ifndef LED_REPLAY
+    if (play_path) {
+        fprintf(stderr, "-p: built without LED_REPLAY (make CFLAGS_EXTRA=-DLED_REPLAY)\n");
+        return 1;
+    }
+#endif
+
+    int anim = golden_dir || play_path ? 0 : anim_find(argv[optind]);
+    if (anim < 0) {
+        fprintf(stderr, "no animation \"%s\" (-l lists them)\n", argv[optind]);
+        return 1;
+    }
+
+    FILE *rgb_out = NULL;
+    if (rgb_path && !(rgb_out = fopen(rgb_path, "wb"))) { perror(rgb_path); return 1; }
+    if (spi_path && !(spi_out = fopen(spi_path, "wb"))) { perror(spi_path); return 1; }
+
+    hal_shim_on_spi(capture_spi);
+    if (!scene_init(NULL, sizeof led_spis / sizeof led_spis[0], led_spis)) {
+        fprintf(stderr, "scene_init failed\n");
+        scene_mem_report();
+        return 1;
+    }
+    hal_shim_isr_run();                 /* whatever init sent (the first, dark frame) */
+    audio_init();                       /* LED_AUDIO: the synthetic input from here */
+
+    uint32_t period_us = 1000000u / fps;
+    if (golden_dir) {
+        int failed = golden(golden_dir, record, argv + optind, argc - optind,
+                            frames, period_us, (uint8_t)tol);
+        if (spi_out) fclose(spi_out);
+        if (rgb_out) fclose(rgb_out);
+        return failed ? 1 : 0;
+    }
+
+    const uint16_t leds = mapping_get_total_pixels();
+    uint32_t       seq0 = render_frame_seq();
+    Stage          tick = { 0 }, isr = { 0 };
+
+    anim_begin((uint8_t)anim, (uint8_t)level);
+#ifdef LED_REPLAY
+    if (play_path) {
+        if ((anim = replay_open(play_path, &frames, &period_us)) < 0) return 1;
+        fps = 1000000u / period_us;
+    }
+#endif
+    uint64_t start = now_ns();
+    run(frames, period_us, &tick, &isr, rgb_out ? write_frame : NULL, rgb_out);
+    double wall = (now_ns() - start) / 1e9;
+
+    if (rgb_out) fclose(rgb_out);
+    if (spi_out) fclose(spi_out);
+
+    uint32_t drawn = render_frame_seq() - seq0;
+    printf("%s: %u frames at %u fps, %u LEDs on %u strips, %u encoded "
+           "(%u SPI transfers, %.1f kB), %.3f s wall\n",
+           anim_get((uint8_t)anim)->name, (unsigned)frames, (unsigned)fps, (unsigned)leds,
+           (unsigned)render_strip_count(), (unsigned)drawn, (unsigned)spi_transfers,
+           spi_bytes / 1024.0, wall);
+    for (uint8_t s = 0; s < render_strip_count(); ++s) {
+        const StripInfo *si = render_strip_info(s);
+        printf("  strip %u: %u LEDs, %lu Hz, %lu us on the wire\n", (unsigned)s,
+               (unsigned)si->count, (unsigned long)si->bitrate, (unsigned long)si->wire_us);
+    }
+    printf("\n  stage        calls    min us    avg us    max us\n");
+    stage_print("anim_tick", &tick, frames);
+    stage_print("isr", &isr, frames);
+#ifdef LED_REPLAY
+    if (play_path) {
+        const ReplayStats *r = replay_stats();
+        printf("  replay: %u packets handed over, %u console lines not run\n",
+               (unsigned)r->packets, (unsigned)r->skipped);
+    }
+#endif
+#ifdef LED_PROFILE
+    static const char *const zone_names[] = {
+#define PROF_NAME(name, budget) #name,
+        PROF_ZONES(PROF_NAME)
+#undef PROF_NAME
+    };
+    for (int z = 0; z < PROF_ZONE_COUNT; ++z) {
+        const ProfStats *p = prof_stats((ProfZone)z);
+        if (!p->calls) continue;
+        const double cyc_us = SystemCoreClock / 1e6;
+        printf("  %-10s %7u %9.1f %9.1f %9.1f   p99 %u us, %u over budget\n",
+               zone_names[z], (unsigned)p->calls, p->min_cyc / cyc_us,
+               p->sum_cyc / cyc_us / p->calls, p->max_cyc / cyc_us,
+               (unsigned)prof_p99_us((ProfZone)z), (unsigned)p->overruns);
+    }
+#endif
+    return 0;
+}
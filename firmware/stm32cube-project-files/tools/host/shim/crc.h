@@ -0,0 +1,12 @@
+/*
+ * crc.h – host stand-in for the CubeMX CRC module (Core/Inc/crc.h)
+ */
+
+#ifndef _HOST_CRC_H_
+#define _HOST_CRC_H_
+
+#include "stm32f4xx_hal.h"
+
+extern CRC_HandleTypeDef hcrc;
+
+#endif /* _HOST_CRC_H_ */
@@ -0,0 +1,38 @@
+/*
+ * stm32f4xx.h – host stand-in for the CMSIS device header: the HAL shim
+ * plus the unaligned access helpers led_vm.c and pixel_simd.c use. No
+ * __ARM_FEATURE_DSP here, so the portable paths are the ones compiled.
+ */
+
+#ifndef _HOST_STM32F4XX_H_
+#define _HOST_STM32F4XX_H_
+
+#include <string.h>
+#include "stm32f4xx_hal.h"
+
+static inline uint32_t host_unaligned_read32(const void *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline void host_unaligned_write32(void *p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+}
+
+#define __UNALIGNED_UINT32_READ(p)      host_unaligned_read32(p)
+#define __UNALIGNED_UINT32_WRITE(p, v)  host_unaligned_write32((p), (v))
+#define __UNALIGNED_UINT16_READ(p)      (*(const uint16_t *)(p))
+#define __CLZ(x)                        ((uint8_t)((x) ? __builtin_clz(x) : 32))
+#define __RBIT(x)                       host_rbit(x)
+
+static inline uint32_t host_rbit(uint32_t v)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < 32; ++i, v >>= 1) r = (r << 1) | (v & 1u);
+    return r;
+}
+
+#endif /* _HOST_STM32F4XX_H_ */
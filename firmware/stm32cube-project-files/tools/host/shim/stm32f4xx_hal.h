@@ -0,0 +1,300 @@
+/*
+ * stm32f4xx_hal.h – host stand-in for the HAL, as much of it as led/ uses
+ *
+ * First on the include path of the host build (tools/host/Makefile), so
+ * every #include "stm32f4xx_hal.h" in led/ and polyhedron/ lands here.
+ * Peripherals are plain structs in RAM: code that sets up TIM5, reads
+ * RCC->CFGR or clears DMA flags compiles and runs, nothing happens. The
+ * parts that matter are in hal_shim.c:
+ *
+ *   DWT->CYCCNT           host time at SystemCoreClock (84 MHz), so cycle
+ *                         counts and the profiler read like on the MCU
+ *   HAL_GetTick()         ms of the run's time base (hal_shim_now_us)
+ *   HAL_SPI_Transmit_DMA  queues the transfer; hal_shim_isr_run() hands the
+ *                         bytes to the capture and completes it, the way
+ *                         the DMA ISR would (and fires the TIM5 latch timer).
+ *                         16 bit frames are counted and sent MSB first
+ *   HAL_CRC_*             the CRC unit in software (CRC-32/MPEG-2, by word)
+ */
+
+#ifndef _HOST_STM32F4XX_HAL_H_
+#define _HOST_STM32F4XX_HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __IO                    volatile
+#define __ALIGN_BEGIN
+#define __ALIGN_END             __attribute__((aligned(4)))
+#define __weak                  __attribute__((weak))
+#define UNUSED(x)               ((void)(x))
+
+/* no interrupts on the host, everything runs on the caller's thread */
+#define __DMB()                 __sync_synchronize()
+#define __DSB()                 __sync_synchronize()
+#define __ISB()                 ((void)0)
+#define __NOP()                 ((void)0)
+#define __WFI()                 ((void)0)
+#define __disable_irq()         ((void)0)
+#define __enable_irq()          ((void)0)
+#define __get_PRIMASK()         0u
+#define __set_PRIMASK(x)        ((void)(x))
+/* one stack: the split in stack_mon.c does nothing */
+#define __get_MSP()             0u
+#define __set_MSP(x)            ((void)(x))
+#define __set_PSP(x)            ((void)(x))
+#define __get_CONTROL()         0u
+#define __set_CONTROL(x)        ((void)(x))
+#define CONTROL_SPSEL_Msk       (1UL << 1)
+
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+
+typedef enum {
+    OTG_FS_IRQn         = 67,
+    TIM2_IRQn           = 28,
+    TIM5_IRQn           = 50,
+    DMA2_Stream0_IRQn   = 56,
+    USART1_IRQn         = 37,
+    EXTI15_10_IRQn      = 40,
+} IRQn_Type;
+
+/* ── registers ─────────────────────────────────────────────────────────── */
+typedef struct { __IO uint32_t CTRL, CYCCNT, LAR; } DWT_Type;
+typedef struct { __IO uint32_t DEMCR; } CoreDebug_Type;
+typedef struct { __IO uint32_t ICSR, AIRCR, SHCSR; } SCB_Type;
+
+typedef struct {
+    __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR,
+                  RCR, CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct { __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR; } DMA_Stream_TypeDef;
+typedef struct { __IO uint32_t LISR, HISR, LIFCR, HIFCR; } DMA_TypeDef;
+typedef struct { __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR; } USART_TypeDef;
+typedef struct { __IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR; } EXTI_TypeDef;
+typedef struct { __IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1ENR, APB1ENR, APB2ENR; } RCC_TypeDef;
+typedef struct { __IO uint32_t CR1, CR2, SR, DR, CRCPR, RXCRCR, TXCRCR, I2SCFGR, I2SPR; } SPI_TypeDef;
+typedef struct { __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2]; } GPIO_TypeDef;
+typedef struct { __IO uint32_t DR, IDR, CR; } CRC_TypeDef;
+
+/* DWT: CYCCNT is brought up to date on every access */
+DWT_Type *hal_shim_dwt(void);
+#define DWT                     (hal_shim_dwt())
+
+extern CoreDebug_Type           hal_shim_coredebug;
+extern SCB_Type                 hal_shim_scb;
+extern TIM_TypeDef              hal_shim_tim[14];
+extern DMA_TypeDef              hal_shim_dma[2];
+extern DMA_Stream_TypeDef       hal_shim_dma_stream[2][8];
+extern USART_TypeDef            hal_shim_usart[6];
+extern EXTI_TypeDef             hal_shim_exti;
+extern RCC_TypeDef              hal_shim_rcc;
+extern SPI_TypeDef              hal_shim_spi[5];
+extern GPIO_TypeDef             hal_shim_gpio[8];
+extern CRC_TypeDef              hal_shim_crc;
+
+#define CoreDebug               (&hal_shim_coredebug)
+#define SCB                     (&hal_shim_scb)
+#define TIM1                    (&hal_shim_tim[1])
+#define TIM2                    (&hal_shim_tim[2])
+#define TIM3                    (&hal_shim_tim[3])
+#define TIM4                    (&hal_shim_tim[4])
+#define TIM5                    (&hal_shim_tim[5])
+#define DMA1                    (&hal_shim_dma[0])
+#define DMA2                    (&hal_shim_dma[1])
+#define DMA2_Stream0            (&hal_shim_dma_stream[1][0])
+#define DMA2_Stream1            (&hal_shim_dma_stream[1][1])
+#define DMA2_Stream2            (&hal_shim_dma_stream[1][2])
+#define DMA2_Stream3            (&hal_shim_dma_stream[1][3])
+#define DMA2_Stream4            (&hal_shim_dma_stream[1][4])
+#define DMA2_Stream5            (&hal_shim_dma_stream[1][5])
+#define DMA2_Stream6            (&hal_shim_dma_stream[1][6])
+#define DMA2_Stream7            (&hal_shim_dma_stream[1][7])
+#define USART1                  (&hal_shim_usart[1])
+#define EXTI                    (&hal_shim_exti)
+#define RCC                     (&hal_shim_rcc)
+#define SPI1                    (&hal_shim_spi[1])
+#define SPI2                    (&hal_shim_spi[2])
+#define SPI3                    (&hal_shim_spi[3])
+#define SPI4                    (&hal_shim_spi[4])
+#define GPIOA                   (&hal_shim_gpio[0])
+#define GPIOB                   (&hal_shim_gpio[1])
+#define GPIOC                   (&hal_shim_gpio[2])
+#define CRC                     (&hal_shim_crc)
+
+/* ── bits (values as in stm32f401xc.h) ─────────────────────────────────── */
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#define SCB_ICSR_VECTACTIVE_Msk     (0x1FFUL)
+
+#define TIM_CR1_CEN                 (1UL << 0)
+#define TIM_CR1_OPM                 (1UL << 3)
+#define TIM_CR1_ARPE                (1UL << 7)
+#define TIM_DIER_UIE                (1UL << 0)
+#define TIM_DIER_CC1DE              (1UL << 9)
+#define TIM_DIER_CC2DE              (1UL << 10)
+#define TIM_DIER_CC3DE              (1UL << 11)
+#define TIM_SR_UIF                  (1UL << 0)
+#define TIM_EGR_UG                  (1UL << 0)
+
+#define DMA_SxCR_EN                 (1UL << 0)
+#define DMA_SxCR_TEIE               (1UL << 2)
+#define DMA_SxCR_TCIE               (1UL << 4)
+#define DMA_SxCR_DIR_0              (1UL << 6)
+#define DMA_SxCR_DIR_1              (1UL << 7)
+#define DMA_SxCR_CIRC               (1UL << 8)
+#define DMA_SxCR_PINC               (1UL << 9)
+#define DMA_SxCR_MINC               (1UL << 10)
+#define DMA_SxCR_PSIZE_0            (1UL << 11)
+#define DMA_SxCR_PSIZE_1            (1UL << 12)
+#define DMA_SxCR_MSIZE_0            (1UL << 13)
+#define DMA_SxCR_MSIZE_1            (1UL << 14)
+#define DMA_SxCR_PL_0               (1UL << 16)
+#define DMA_SxCR_PL_1               (1UL << 17)
+#define DMA_SxCR_PBURST_0           (1UL << 21)
+#define DMA_SxCR_MBURST_0           (1UL << 23)
+#define DMA_SxCR_CHSEL_Pos          25U
+#define DMA_SxFCR_FTH               (3UL << 0)
+#define DMA_SxFCR_DMDIS             (1UL << 2)
+#define DMA_HISR_TEIF6              (1UL << 19)
+#define DMA_HISR_DMEIF6             (1UL << 18)
+#define DMA_HISR_TCIF6              (1UL << 21)
+#define DMA_HISR_TEIF7              (1UL << 25)
+#define DMA_HISR_DMEIF7             (1UL << 24)
+#define DMA_HISR_TCIF7              (1UL << 27)
+
+#define USART_SR_FE                 (1UL << 1)
+#define USART_SR_NE                 (1UL << 2)
+#define USART_SR_ORE                (1UL << 3)
+#define USART_CR1_RE                (1UL << 2)
+#define USART_CR1_TE                (1UL << 3)
+#define USART_CR1_UE                (1UL << 13)
+#define USART_CR3_DMAR              (1UL << 6)
+#define USART_CR3_DMAT              (1UL << 7)
+
+#define RCC_CFGR_PPRE1              (7UL << 10)
+#define RCC_CFGR_PPRE2              (7UL << 13)
+#define SPI_CR1_BR_Pos              3U
+#define SPI_BAUDRATEPRESCALER_2     0x00000000U
+#define SPI_BAUDRATEPRESCALER_4     0x00000008U
+#define SPI_BAUDRATEPRESCALER_8     0x00000010U
+#define SPI_BAUDRATEPRESCALER_16    0x00000018U
+#define SPI_BAUDRATEPRESCALER_32    0x00000020U
+
+#define GPIO_PIN_0                  ((uint16_t)0x0001)
+#define GPIO_PIN_9                  ((uint16_t)0x0200)
+#define GPIO_PIN_10                 ((uint16_t)0x0400)
+#define GPIO_PIN_12                 ((uint16_t)0x1000)
+#define GPIO_MODE_OUTPUT_PP         0x00000001U
+#define GPIO_MODE_AF_PP             0x00000002U
+#define GPIO_MODE_IT_RISING_FALLING 0x10310000U
+#define GPIO_NOPULL                 0x00000000U
+#define GPIO_PULLUP                 0x00000001U
+#define GPIO_PULLDOWN               0x00000002U
+#define GPIO_SPEED_FREQ_HIGH        0x00000002U
+#define GPIO_SPEED_FREQ_VERY_HIGH   0x00000003U
+#define GPIO_AF7_USART1             ((uint8_t)0x07)
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin, Mode, Pull, Speed, Alternate;
+} GPIO_InitTypeDef;
+
+/* ── handles ───────────────────────────────────────────────────────────── */
+#define DMA_NORMAL                  0x00000000U
+#define DMA_CIRCULAR                DMA_SxCR_CIRC
+#define DMA_PDATAALIGN_HALFWORD     DMA_SxCR_PSIZE_0
+#define DMA_MDATAALIGN_HALFWORD     DMA_SxCR_MSIZE_0
+#define DMA_FIFOMODE_ENABLE         DMA_SxFCR_DMDIS
+#define DMA_FIFO_THRESHOLD_HALFFULL 0x00000001U
+#define DMA_MBURST_INC4             DMA_SxCR_MBURST_0
+#define DMA_PBURST_SINGLE           0x00000000U
+#define SPI_DATASIZE_8BIT           0x00000000U
+#define SPI_DATASIZE_16BIT          0x00000800U     /* SPI_CR1_DFF */
+
+typedef struct {
+    uint32_t Channel, Direction, PeriphInc, MemInc, PeriphDataAlignment,
+             MemDataAlignment, Mode, Priority, FIFOMode, FIFOThreshold,
+             MemBurst, PeriphBurst;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+    DMA_Stream_TypeDef *Instance;
+    DMA_InitTypeDef     Init;
+    void               *Parent;
+} DMA_HandleTypeDef;
+
+typedef struct {
+    uint32_t Mode, Direction, DataSize, CLKPolarity, CLKPhase, NSS,
+             BaudRatePrescaler, FirstBit;
+} SPI_InitTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+    SPI_TypeDef       *Instance;
+    SPI_InitTypeDef    Init;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+} SPI_HandleTypeDef;
+
+typedef struct {
+    CRC_TypeDef *Instance;
+} CRC_HandleTypeDef;
+
+/* ── functions ─────────────────────────────────────────────────────────── */
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+void     HAL_Delay(uint32_t ms);
+
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+#define __HAL_RCC_DMA2_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_TIM1_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_TIM2_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_TIM5_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_USART1_CLK_ENABLE()   ((void)0)
+
+#define HAL_NVIC_SetPriority(irq, pre, sub)  ((void)(irq), (void)(pre), (void)(sub))
+#define HAL_NVIC_EnableIRQ(irq)              ((void)(irq))
+#define HAL_NVIC_DisableIRQ(irq)             ((void)(irq))
+#define NVIC_EnableIRQ(irq)                  ((void)(irq))
+#define NVIC_DisableIRQ(irq)                 ((void)(irq))
+
+void          HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void          HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+void          HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef *hspi);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_TxHalfCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi);
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t *buf, uint32_t words);
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *hcrc, uint32_t *buf, uint32_t words);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HOST_STM32F4XX_HAL_H_ */
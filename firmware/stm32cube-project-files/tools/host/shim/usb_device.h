@@ -0,0 +1,12 @@
+/*
+ * usb_device.h – host stand-in: the device handle
+ */
+
+#ifndef _HOST_USB_DEVICE_H_
+#define _HOST_USB_DEVICE_H_
+
+#include "usbd_def.h"
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+#endif /* _HOST_USB_DEVICE_H_ */
@@ -0,0 +1,14 @@
+/*
+ * usbd_cdc.h – host stand-in for the CDC class header (packet sizes)
+ */
+
+#ifndef _HOST_USBD_CDC_H_
+#define _HOST_USBD_CDC_H_
+
+#include "usbd_def.h"
+
+#define CDC_DATA_FS_MAX_PACKET_SIZE     64U
+#define CDC_DATA_FS_OUT_PACKET_SIZE     CDC_DATA_FS_MAX_PACKET_SIZE
+#define CDC_DATA_FS_IN_PACKET_SIZE      CDC_DATA_FS_MAX_PACKET_SIZE
+
+#endif /* _HOST_USBD_CDC_H_ */
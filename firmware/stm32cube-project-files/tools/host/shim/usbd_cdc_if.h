@@ -0,0 +1,12 @@
+/*
+ * usbd_cdc_if.h – host stand-in for the CDC interface (USB_DEVICE/App)
+ */
+
+#ifndef _HOST_USBD_CDC_IF_H_
+#define _HOST_USBD_CDC_IF_H_
+
+#include "usbd_cdc.h"
+
+uint8_t CDC_Transmit_FS(uint8_t *buf, uint16_t len);
+
+#endif /* _HOST_USBD_CDC_IF_H_ */
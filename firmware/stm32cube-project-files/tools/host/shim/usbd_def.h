@@ -0,0 +1,26 @@
+/*
+ * usbd_def.h – host stand-in: the USB device handle and the log macros
+ */
+
+#ifndef _HOST_USBD_DEF_H_
+#define _HOST_USBD_DEF_H_
+
+#include "stm32f4xx_hal.h"
+
+/* as usbd_conf.h (which usbd_def.h pulls in): printf + newline */
+#define USBD_UsrLog(...)        do { printf(__VA_ARGS__); printf("\n"); } while (0)
+#define USBD_ErrLog(...)        USBD_UsrLog(__VA_ARGS__)
+#define USBD_DbgLog(...)        ((void)0)
+
+#define USBD_OK                 0U
+#define USBD_BUSY               1U
+#define USBD_FAIL               3U
+
+#define USBD_STATE_CONFIGURED   0x03U   /* never reached on the host */
+
+typedef struct _USBD_HandleTypeDef {
+    volatile uint8_t dev_state;
+    void            *pClassData;
+} USBD_HandleTypeDef;
+
+#endif /* _HOST_USBD_DEF_H_ */
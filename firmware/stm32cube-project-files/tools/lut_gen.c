@@ -0,0 +1,71 @@
+/*
+ * lut_gen.c – host tool: constant lookup tables for led/lut.c
+ *
+ * Prints led/lut_tables.inc (gamma curves, WS2812 bit patterns, quarter sine,
+ * rainbow). Not part of the CubeIDE build (tools/ is no source folder).
+ * From firmware/stm32cube-project-files:
+ *
+ *   gcc -O2 -I led tools/lut_gen.c -lm -o lut_gen
+ *   ./lut_gen > led/lut_tables.inc
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "lut.h"
+
+static void row(unsigned i, unsigned per_line)
+{
+    printf("%s", (i % per_line) ? " " : "\n    ");
+}
+
+int main(void)
+{
+    static const float gammas[] = LUT_GAMMA_LIST;
+    const unsigned     n_gamma  = sizeof gammas / sizeof gammas[0];
+
+    printf("/* generated by tools/lut_gen.c – do not edit, rerun it instead */\n\n");
+
+    /* gamma, same rounding the firmware's fallback uses */
+    printf("#define LUT_GAMMA_CNT  %u\n\n", n_gamma);
+    printf("static const float lut_gamma_exp[LUT_GAMMA_CNT] = LUT_GAMMA_LIST;\n\n");
+    printf("static const uint8_t lut_gamma8[LUT_GAMMA_CNT][256] = {\n");
+    for (unsigned k = 0; k < n_gamma; ++k) {
+        printf("  { /* %.1f */", gammas[k]);
+        for (unsigned i = 0; i < 256; ++i) {
+            row(i, 16);
+            printf("%3u,", (unsigned)(uint8_t)(powf(i / 255.0f, gammas[k]) * 255.0f + 0.5f));
+        }
+        printf("\n  },\n");
+    }
+    printf("};\n\n");
+
+    printf("const uint32_t lut_ws_bits[256] = {");
+    for (unsigned v = 0; v < 256; ++v) {
+        uint32_t out = 0;
+        for (int b = 7; b >= 0; --b) {
+            out <<= 3;
+            out |= ((v >> b) & 1) ? 0x6u : 0x4u;
+        }
+        row(v, 8);
+        printf("0x%06lXu,", (unsigned long)out);
+    }
+    printf("\n};\n\n");
+
+    /* in double, rounded: the table is exact to 1 LSB of Q15 */
+    printf("const int16_t lut_sin_q15[LUT_SIN_QUARTER + 1] = {");
+    for (unsigned i = 0; i <= LUT_SIN_QUARTER; ++i) {
+        row(i, 12);
+        printf("%5ld,", lround(sin(i * (M_PI / 2) / LUT_SIN_QUARTER) * 32767.0));
+    }
+    printf("\n};\n\n");
+
+    printf("const uint8_t lut_rainbow[256][3] = {");
+    for (unsigned h = 0; h < 256; ++h) {
+        uint8_t r, g, b;
+        lut_rainbow_raw((uint8_t)h, &r, &g, &b);
+        row(h, 6);
+        printf("{ %3u, %3u, %3u },", r, g, b);
+    }
+    printf("\n};\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * poly_gen.c – host tool: geometry tables for LED_ROM_TABLES (led/rom_tables.h)
+ *
+ * Runs the firmware's own builders (polyhedron.c) on the PC and prints them
+ * as const C tables, the firmware then links them into flash instead of
+ * building at boot. Not part of the CubeIDE build (tools/ is no source
+ * folder). From firmware/stm32cube-project-files:
+ *
+ *   gcc -O2 -I polyhedron -I led tools/poly_gen.c polyhedron/polyhedron.c -lm -o poly_gen
+ *   ./poly_gen > led/rom_tables.inc
+ *
+ * Rerun after changing the solid or its orientation (below, keep in step
+ * with main.c). The gamma / sine / rainbow LUTs are tools/lut_gen.c.
+ */
+
+#include <stdio.h>
+#include "polyhedron.h"
+
+/* same as main.c */
+#define GEN_ARENA_BYTES  1024
+#define GEN_ORIENT_VERT  0
+
+static void dump_u8(const char *name, const uint8_t *d, unsigned n)
+{
+    printf("static const uint8_t %s[%u] = {", name, n);
+    for (unsigned i = 0; i < n; ++i)
+        printf("%s%3u,", (i % 16) ? " " : "\n    ", d[i]);
+    printf("\n};\n\n");
+}
+
+/* index tables are printed as poly_idx_t, so the file fits either width */
+static void dump_idx(const char *name, const poly_idx_t *d, unsigned n)
+{
+    printf("static const poly_idx_t %s[%u] = {", name, n);
+    for (unsigned i = 0; i < n; ++i)
+        printf("%s%3u,", (i % 16) ? " " : "\n    ", d[i]);
+    printf("\n};\n\n");
+}
+
+int main(void)
+{
+    static uint32_t mem[GEN_ARENA_BYTES / 4];
+    PolyArena  a;
+    Polyhedron p;
+    poly_arena_init(&a, mem, sizeof mem);
+    if (!poly_init_dodecahedron(&p, &a)) {
+        fprintf(stderr, "poly_gen: poly_init_dodecahedron failed\n");
+        return 1;
+    }
+    poly_orient_to_vertex(&p, GEN_ORIENT_VERT);
+
+    printf("/* generated by tools/poly_gen.c – do not edit, rerun it instead */\n\n");
+    printf("#define ROM_V  %u\n#define ROM_F  %u\n#define ROM_S  %u\n#define ROM_E  %u\n\n",
+           p.V, p.F, p.S, p.E);
+
+    /* geometry, %#.9g round-trips a float (and always has a decimal point) */
+    printf("static const float rom_v[ROM_V][3] = {\n");
+    for (unsigned i = 0; i < p.V; ++i)
+        printf("    { %#.9gf, %#.9gf, %#.9gf },\n", p.v[i][0], p.v[i][1], p.v[i][2]);
+    printf("};\n\n");
+
+    dump_u8("rom_fv", p.fv, p.F);
+    printf("static const poly_idx_t rom_fi[ROM_S] = {\n");
+    for (unsigned f = 0; f < p.F; ++f) {
+        printf("    ");
+        for (unsigned i = 0; i < p.fv[f]; ++i) printf("%3u,", p.f[f][i]);
+        printf("\n");
+    }
+    printf("};\n\n");
+    printf("static const poly_idx_t *const rom_f[ROM_F] = {");
+    for (unsigned f = 0, at = 0; f < p.F; at += p.fv[f++])
+        printf("%s rom_fi + %u,", (f % 6) ? "" : "\n   ", at);
+    printf("\n};\n\n");
+
+    /* topology, as poly_prepare() left it */
+    printf("static const Edge rom_e[ROM_E] = {");
+    for (unsigned e = 0; e < p.E; ++e)
+        printf("%s { %2u, %2u },", (e % 6) ? "" : "\n   ", p.e[e].a, p.e[e].b);
+    printf("\n};\n\n");
+    printf("static const poly_idx_t rom_e2f[ROM_E][2] = {");
+    for (unsigned e = 0; e < p.E; ++e)
+        printf("%s { %2u, %2u },", (e % 6) ? "" : "\n   ", p.e2f[e][0], p.e2f[e][1]);
+    printf("\n};\n\n");
+    printf("static const uint16_t rom_v2e_off[ROM_V + 1] = {");
+    for (unsigned v = 0; v <= p.V; ++v)
+        printf("%s%3u,", (v % 16) ? " " : "\n    ", p.v2e_off[v]);
+    printf("\n};\n\n");
+    dump_idx("rom_v2e", p.v2e, p.v2e_off[p.V]);
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+proto_gen.py – host tool: tools/protocol.def → led/proto.h and app/proto.py
+
+The packet types, the fixed payload layouts and the console's command list
+are written down once, in protocol.def; this turns them into the firmware's
+header (an enum, a struct with memcpy encode / decode per layout, the help
+text) and the app's module (constants, a struct.Struct and a NamedTuple per
+layout, a NumPy dtype for arrays of them). Not part of the CubeIDE build.
+From firmware/stm32cube-project-files:
+
+    python3 tools/proto_gen.py
+
+Rerun after editing protocol.def, commit the three files together.
+"""
+import re, sys
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+DEF  = HERE / "protocol.def"
+OUT_C  = HERE.parent / "led" / "proto.h"
+OUT_PY = HERE.parents[2] / "app" / "proto.py"
+
+# type → C type, struct code, NumPy code, bytes
+TYPES = {
+    "u8":  ("uint8_t",  "B", "u1", 1), "i8":  ("int8_t",  "b", "i1", 1),
+    "u16": ("uint16_t", "H", "<u2", 2), "i16": ("int16_t", "h", "<i2", 2),
+    "u32": ("uint32_t", "I", "<u4", 4), "i32": ("int32_t", "i", "<i4", 4),
+    "f32": ("float",    "f", "<f4", 4), "c8":  ("char",    "s", "S",  1),
+}
+FIELD = re.compile(r"(\w+)\s+(u8|i8|u16|i16|u32|i32|f32|c8)(?:\[(\d+)\])?\s*(?:#\s*(.*))?$")
+
+
+def snake(name):
+    return re.sub(r"(?<!^)(?=[A-Z])", "_", name).lower()
+
+
+def parse(text):
+    packets, records, commands, rec = [], [], [], None
+    for n, line in enumerate(text.splitlines(), 1):
+        if not line.strip() or line.lstrip().startswith("#"):
+            continue
+        if line[0].isspace():
+            m = FIELD.match(line.strip())
+            if rec is None or not m:
+                sys.exit(f"{DEF.name}:{n}: not a field: {line.strip()}")
+            name, typ, cnt, note = m.groups()
+            if typ == "c8" and not cnt:
+                sys.exit(f"{DEF.name}:{n}: c8 needs a length")
+            rec["fields"].append((name, typ, int(cnt) if cnt else None, note or ""))
+            continue
+        kind, _, rest = line.partition(" ")
+        rest = rest.strip()
+        if kind == "packet":
+            name, pid, what = rest.split(None, 2)
+            packets.append((name, int(pid, 0), what))
+            rec = None
+        elif kind == "record":
+            name, _, what = rest.partition(" ")
+            rec = {"name": name, "what": what.strip(), "fields": []}
+            records.append(rec)
+        elif kind == "command":
+            commands.append(rest)
+            rec = None
+        else:
+            sys.exit(f"{DEF.name}:{n}: unknown line: {line}")
+    for r in records:
+        r["size"] = sum(TYPES[t][3] * (c or 1) for _n, t, c, _w in r["fields"])
+    return packets, records, commands
+
+
+def c_header(packets, records, commands):
+    o = ["/*",
+         " * proto.h – generated by tools/proto_gen.py from tools/protocol.def, do not",
+         " * edit: change protocol.def and rerun it (app/proto.py comes out with it)",
+         " *",
+         " * Packet types, the fixed payload layouts (PROTO_<NAME>_SIZE bytes on the",
+         " * wire, unaligned; a struct in memory, proto_<name>_decode / _encode in",
+         " * between) and the console's help text. Little endian, the wire's order.",
+         " */", "", "#ifndef _PROTO_H_", "#define _PROTO_H_", "",
+         "#include <stdint.h>", "#include <string.h>", "",
+         "#ifdef __cplusplus", 'extern "C" {', "#endif", "", "typedef enum {"]
+    w = max(len(n) for n, _i, _t in packets) + 4
+    for name, pid, what in packets:
+        o.append(f"    {'PKT_' + name:<{w}} = 0x{pid:02X},   /* {what} */")
+    o += ["} PktType;", ""]
+    for r in records:
+        up, lo = snake(r["name"]).upper(), snake(r["name"])
+        o += [f"/* {r['what']} */", f"#define PROTO_{up}_SIZE  {r['size']}u", "", "typedef struct {"]
+        for name, typ, cnt, note in r["fields"]:
+            decl = f"{name}[{cnt}]" if cnt else name
+            line = f"    {TYPES[typ][0]:<9}{decl};"
+            o.append(f"{line:<28}/* {note} */" if note else line)
+        o += [f"}} Proto{r['name']};", ""]
+        dec = [f"static inline void proto_{lo}_decode(const uint8_t *p, Proto{r['name']} *r)", "{"]
+        enc = [f"static inline uint8_t *proto_{lo}_encode(uint8_t *p, const Proto{r['name']} *r)", "{"]
+        off = 0
+        for name, typ, cnt, _note in r["fields"]:
+            n = TYPES[typ][3] * (cnt or 1)
+            ref = f"r->{name}" if cnt else f"&r->{name}"
+            dec.append(f"    memcpy({ref}, p + {off}, {n});")
+            enc.append(f"    memcpy(p + {off}, {ref}, {n});")
+            off += n
+        dec += ["}", ""]
+        enc += [f"    return p + PROTO_{up}_SIZE;", "}", ""]
+        o += dec + enc
+    o.append('#define PROTO_HELP  "Valid cmds:\\n" \\')
+    for i, c in enumerate(commands):
+        o.append(f'    " {c}\\n"' + (" \\" if i + 1 < len(commands) else ""))
+    o += ["", "#ifdef __cplusplus", "}", "#endif", "", "#endif /* _PROTO_H_ */", ""]
+    return "\n".join(o)
+
+
+def py_module(packets, records, commands):
+    o = ['"""proto.py - generated by tools/proto_gen.py from tools/protocol.def',
+         "-------------------------------------------------------------------------------",
+         "Do not edit: change firmware/stm32cube-project-files/tools/protocol.def and",
+         "rerun the generator, led/proto.h comes out with it.",
+         "",
+         "Packet types, a NamedTuple per fixed payload layout (X.S its struct.Struct,",
+         "X.decode(buf, off) / x.encode(), X.DTYPE for NumPy arrays of them) and the",
+         "console's command list.",
+         '"""',
+         "import struct",
+         "from typing import NamedTuple",
+         "", "try:", "    import numpy as np", "except ImportError:                             # optional",
+         "    np = None", ""]
+    w = max(len(n) for n, _i, _t in packets)
+    for name, pid, what in packets:
+        o.append(f"{name:<{w}} = 0x{pid:02X}   # {what}")
+    for r in records:
+        fmt = "<" + "".join((str(c) if c else "") + TYPES[t][1] for _n, t, c, _w in r["fields"])
+        o += ["", "", f"class {r['name']}(NamedTuple):", f'    """{r["what"]}"""']
+        for name, typ, cnt, note in r["fields"]:
+            pyt = "bytes" if typ == "c8" else "tuple" if cnt else "float" if typ == "f32" else "int"
+            o.append(f"    {name}: {pyt}" + (f"{'':<{max(1, 20 - len(name) - len(pyt))}}# {note}" if note else ""))
+        o += [f'    S = struct.Struct("{fmt}")', "",
+              "    def encode(self) -> bytes:"]
+        args = []
+        for name, typ, cnt, _note in r["fields"]:
+            args.append(f"*self.{name}" if cnt and typ != "c8" else f"self.{name}")
+        o += [f"        return self.S.pack({', '.join(args)})", "",
+              "    @classmethod", "    def decode(cls, buf, off=0):",
+              "        v = cls.S.unpack_from(buf, off)"]
+        parts, k = [], 0
+        for name, typ, cnt, _note in r["fields"]:
+            if cnt and typ != "c8":
+                parts.append(f"v[{k}:{k + cnt}]")
+                k += cnt
+            else:
+                parts.append(f"v[{k}]")
+                k += 1
+        o.append(f"        return cls({', '.join(parts)})")
+    o += ["", ""]
+    o.append("# NumPy record dtypes, for np.frombuffer over a run of records")
+    o.append("if np is not None:")
+    for r in records:
+        fs = []
+        for name, typ, cnt, _note in r["fields"]:
+            code = TYPES[typ][2]
+            if typ == "c8":
+                fs.append(f'("{name}", "S{cnt}")')
+            elif cnt:
+                fs.append(f'("{name}", "{code}", ({cnt},))')
+            else:
+                fs.append(f'("{name}", "{code}")')
+        o.append(f"    {r['name']}.DTYPE = np.dtype([{', '.join(fs)}])")
+    o += ["", "HELP = ["] + [f'    "{c}",' for c in commands] + ["]", ""]
+    return "\n".join(o)
+
+
+def main():
+    packets, records, commands = parse(DEF.read_text(encoding="utf-8"))
+    OUT_C.write_text(c_header(packets, records, commands), encoding="utf-8")
+    OUT_PY.write_text(py_module(packets, records, commands), encoding="utf-8")
+    print(f"{OUT_C.name}, {OUT_PY.name}: {len(packets)} packets, {len(records)} layouts, "
+          f"{len(commands)} commands")
+
+
+if __name__ == "__main__":
+    main()